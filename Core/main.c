@@ -9,18 +9,48 @@
 #include "netif/ethernet.h"
 
 #include "lwip/tcpip.h"
+#include "lwip/apps/httpd.h"
 #include "lwip/apps/lwiperf.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/dhcp.h"
 #include "lwip/etharp.h"
 #include "lwip/netif.h"
+#include "lwip/sys.h"
 #include "lwip/timeouts.h"
 #include "lwip/init.h"
 
 #include "udpecho_raw.h"
+#include "bench.h"
+#include "flash_dev.h"
+#include "flash_fs.h"
+#include "flash_lease.h"
+#include "flash_upload.h"
 
 volatile bool recv_flag = false;
 struct netif gnetif;
+/* Frames wait in the Rx ring, the Rx interrupt is masked until taken */
+static volatile bool rx_pending = false;
+
+/* Files of httpd, an image of mkflashfs, before the ones of fsdata.c */
+#define WWW_ADDR 0x180000
+
+/* POST /upload/<name> writes the region, FLASH_LEASE_ADDR follows config */
+static const struct flash_upload_region upload_regions[] = {
+    {"/upload/fw", 0, 1024 * 1024},
+    {"/upload/config", 1024 * 1024, 64 * 1024},
+    {"/upload/www", WWW_ADDR, 512 * 1024},
+};
+
+static const tDyn http_dyns[] = {
+    {FLASH_UPLOAD_RESULT_URI, "application/json", flash_upload_json},
+};
 
 void lwip_layer_init(void);
+static void www_poll(void);
+
+#if BENCH_RUN
+static struct bench_cfg bench_cfg;
+#endif
 
 void printIPaddr(void)
 {
@@ -53,45 +83,92 @@ int main(void)
     printf("[test]: TCP/IP Ping Test over lwIP Stack\n\n");
     lwip_layer_init();
 
-    bool link_up = false;
-    ethernet_phy_get_link_status(&link_up);
-    /* Print IP address info */
-    if (link_up && gnetif.ip_addr.addr) {
-        printf("Hello Connection!\n");
-        printIPaddr();
-    }
+    bool bound = false;
 
     NVIC_EnableIRQ(EMAC_TX_IRQn);
     NVIC_EnableIRQ(EMAC_RX_IRQn);
     EMAC_ENABLE_TX();  // TODO: Enable opportunity?
     EMAC_ENABLE_RX();  // TODO: Enable opportunity?
 
+    /* The address comes from DHCP, a stored lease is requested again at
+       once */
+    if (netif_is_up(&gnetif) && dhcp_start(&gnetif) != ERR_OK)
+        printf("[ERROR]: dhcp_start\n");
+
     udpecho_raw_init();
 
+    httpd_init();
+    http_set_dyn_handlers(http_dyns, LWIP_ARRAYSIZE(http_dyns));
+    /* put upload/<name> writes the same regions as POST /upload/<name> */
+    tftp_init(&flash_upload_tftp);
+
+#if BENCH_RUN
+    BENCH_PEER(&bench_cfg.peer);
+    bench_cfg.iperf_port = LWIPERF_TCP_PORT_DEFAULT;
+    bench_cfg.echo_port = 7;
+    bench_cfg.http_port = 80;
+    bench_cfg.cases = bench_default_cases;
+    bench_cfg.num_cases = bench_num_default_cases;
+    bench_start(&gnetif, &bench_cfg);
+#endif
+
     while (1) {
         /* LWIP timers - ARP, DHCP, TCP, etc. */
         sys_check_timeouts();
+        /* Tx time stamps latched by the Tx interrupt */
+        ethernetif_poll(&gnetif);
+        /* httpd and TFTP feed the uploads, which the polls below drain */
+        if (rx_pending) {
+            rx_pending = false;
+            ethernetif_input(&gnetif);
+            NVIC_EnableIRQ(EMAC_RX_IRQn);
+        }
+        /* External flash, one erase or program at a time */
+        flash_upload_poll();
+        flash_lease_poll();
+        www_poll();
+        /* Flash reads of httpd files, started by PDMA */
+        flash_fs_poll();
+        /* Print IP address info once DHCP is bound */
+        if (!bound && dhcp_supplied_address(&gnetif)) {
+            bound = true;
+            printf("Hello Connection! %lu ms\n", (unsigned long) sys_now());
+            printIPaddr();
+        }
+#if BENCH_RUN
+        bench_poll();
+#else
         if (recv_flag) {
             recv_flag = false;
             printf(":)\n");
         }
+#endif
     }
 }
 
 void lwip_layer_init(void)
 {
-    ip_addr_t ipaddr, netmask, gw;
-
-    IP4_ADDR(&gw, 192, 168, 0, 1);
-    IP4_ADDR(&ipaddr, 192, 168, 0, 23);
-    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    /* The last DHCP lease, requested again at once by dhcp_start(), and
+       the httpd uploads */
+    if (flash_w25q_init() != 0 ||
+        flash_lease_init(&flash_w25q, FLASH_LEASE_ADDR) != 0 ||
+        flash_upload_init(&flash_w25q, upload_regions,
+                          LWIP_ARRAYSIZE(upload_regions)) != 0)
+        printf("[ERROR]: no external flash, DHCP starts from DISCOVER\n");
+    else if (flash_fs_mount(&flash_w25q, WWW_ADDR) != 0)
+        printf("[INFO]: no flash fs at 0x%06lx, httpd serves fsdata.c\n",
+               (unsigned long) WWW_ADDR);
+
+    /* LWIP_RAND(), DNS transaction ids and the DHCP xid */
+    sys_rand_init();
 
     /* Initilialize the LwIP stack without RTOS */
     lwip_init();
 
-    /* add the network interface (IPv4/IPv6) without RTOS */
-    netif_add(&gnetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
-              &netif_input);
+    /* add the network interface (IPv4/IPv6) without RTOS, the address comes
+       from DHCP */
+    netif_add(&gnetif, IP4_ADDR_ANY4, IP4_ADDR_ANY4, IP4_ADDR_ANY4, NULL,
+              &ethernetif_init, &netif_input);
 
     /* Registers the default network interface */
     netif_set_default(&gnetif);
@@ -111,12 +188,30 @@ void EMAC_RX_IRQHandler(void)
 {
     PH5 ^= 1;
     recv_flag = true;
-    ethernetif_input(&gnetif);
+    // lwIP runs in the main loop only, hand the frames over to it.
+    NVIC_DisableIRQ(EMAC_RX_IRQn);
+    rx_pending = true;
 }
 
 void EMAC_TX_IRQHandler(void)
 {
     PH4 ^= 1;
     // Clean up Tx resource occupied by previous sent.
-    EMAC_SendPktDone();
+    ethernetif_tx_done(&gnetif);
+}
+
+/* An upload may be rewriting the image, httpd serves fsdata.c until it is
+   over and the image is mounted again */
+static void www_poll(void)
+{
+    static enum flash_upload_result last = FLASH_UPLOAD_NONE;
+    enum flash_upload_result result = flash_upload_get_stats()->result;
+
+    if (result == last)
+        return;
+    last = result;
+    if (result == FLASH_UPLOAD_RUNNING)
+        flash_fs_unmount();
+    else
+        flash_fs_mount(&flash_w25q, WWW_ADDR);
 }
@@ -41,6 +41,12 @@ static void system_clock_init(void)
     CLK_EnableModuleClock(EMAC_MODULE);
     /* Enable TMR0 clock */
     CLK_EnableModuleClock(TMR0_MODULE);
+    /* Enable SPI2 clock */
+    CLK_EnableModuleClock(SPI2_MODULE);
+    /* Enable PDMA clock, reads of the external flash */
+    CLK_EnableModuleClock(PDMA_MODULE);
+    /* Enable TRNG clock, seeds LWIP_RAND() */
+    CLK_EnableModuleClock(TRNG_MODULE);
 
     /* Select UART clock source from HXT and UART module clock divider as 1 */
     CLK_SetModuleClock(UART0_MODULE, CLK_CLKSEL1_UART0SEL_HXT,
@@ -49,6 +55,9 @@ static void system_clock_init(void)
     /* Select TMR0 clock source from HXT */
     CLK_SetModuleClock(TMR0_MODULE, CLK_CLKSEL1_TMR0SEL_HXT, 0);
 
+    /* Select SPI2 clock source from PCLK1 (96 MHz) */
+    CLK_SetModuleClock(SPI2_MODULE, CLK_CLKSEL2_SPI2SEL_PCLK1, 0);
+
     // Configure MDC clock rate to HCLK / (127 + 1) = 1.5 MHz if system is
     // running at 192 MHz
     CLK_SetModuleClock(EMAC_MODULE, 0, CLK_CLKDIV3_EMAC(127));
@@ -126,12 +135,29 @@ static void system_uart0_deinit(void)
  */
 static void system_spi_init(void)
 {
-    // TODO:
+    /* Set GPA/GPG multi-function pins for SPI2, SS driven as GPIO by SPI */
+    SYS->GPA_MFPH &= ~(SYS_GPA_MFPH_PA8MFP_Msk | SYS_GPA_MFPH_PA10MFP_Msk |
+                       SYS_GPA_MFPH_PA11MFP_Msk);
+    SYS->GPA_MFPH |= (SYS_GPA_MFPH_PA8MFP_SPI2_MOSI |
+                      SYS_GPA_MFPH_PA10MFP_SPI2_CLK |
+                      SYS_GPA_MFPH_PA11MFP_SPI2_SS);
+    SYS->GPG_MFPL &= ~SYS_GPG_MFPL_PG4MFP_Msk;
+    SYS->GPG_MFPL |= SYS_GPG_MFPL_PG4MFP_SPI2_MISO;
+
+    /* Enable high slew rate on the clock and data output pins */
+    PA->SLEWCTL |= (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN8_Pos) |
+                   (GPIO_SLEWCTL_HIGH << GPIO_SLEWCTL_HSREN10_Pos);
+
+    /* Mode 0, 8 bit, 48 MHz. The chip select is held low by software across
+     * the command, address and data of one transfer (flash_w25q.c). */
+    SPI_Open(SPI2, SPI_MASTER, SPI_MODE_0, 8, 48000000);
+    SPI_DisableAutoSS(SPI2);
+    SPI_SET_SS_HIGH(SPI2);
 }
 
 static void system_spi_deinit(void)
 {
-    // TODO:
+    SPI_Close(SPI2);
 }
 
 /**
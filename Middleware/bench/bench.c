@@ -0,0 +1,366 @@
+/**
+ * @file bench.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Throughput benchmark of the stack against a peer, CSV on stdout.
+ *
+ * The bytes are counted by wrapping the input and linkoutput functions of
+ * the netif, so every case is measured the same way, headers included. The
+ * watermarks are the max of MEM_STATS and MEMP_STATS, reset at each case.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "bench.h"
+#include "lwip/apps/http_client.h"
+#include "lwip/apps/lwiperf.h"
+#include "lwip/memp.h"
+#include "lwip/pbuf.h"
+#include "lwip/stats.h"
+#include "lwip/sys.h"
+#include "lwip/udp.h"
+
+#if !MEM_STATS || !MEMP_STATS
+#error "bench.c needs MEM_STATS and MEMP_STATS (lwipopts.h)"
+#endif
+
+#define BENCH_SECOND 1000
+
+const struct bench_case bench_default_cases[] = {
+    {"iperf_server", BENCH_IPERF_SERVER, 12, 0},
+    {"iperf_client", BENCH_IPERF_CLIENT, 11, 0},
+    {"udp_echo_64", BENCH_UDP_ECHO, 5, 64},
+    {"udp_echo_1472", BENCH_UDP_ECHO, 5, 1472},
+    {"http_get_16k", BENCH_HTTP_GET, 5, 16384},
+};
+
+const uint32_t bench_num_default_cases = LWIP_ARRAYSIZE(bench_default_cases);
+
+static const char *const pool_names[] = {
+#define LWIP_MEMPOOL(name, num, size, desc) #name,
+#include "lwip/priv/memp_std.h"
+};
+
+static struct {
+    struct netif *netif;
+    const struct bench_cfg *cfg;
+    netif_input_fn input;
+    netif_linkoutput_fn linkoutput;
+    uint8_t running;
+    uint8_t calibrating;
+    uint32_t index;        /* of the case */
+    uint32_t second;       /* of the case, from 1 */
+    uint32_t second_start; /* sys_now() */
+    uint32_t loops;        /* bench_poll() calls of the second */
+    uint32_t idle_loops;   /* those of the calibration second */
+    uint32_t idle_sum;
+    uint32_t ops;
+    /* counted in the EMAC interrupts on the M487 */
+    volatile uint32_t rx;
+    volatile uint32_t tx;
+    void *iperf_server;
+    struct udp_pcb *udp;
+    uint32_t udp_sent;     /* sys_now() */
+    uint8_t http_busy;
+} b;
+
+static struct bench_result results[BENCH_MAX_CASES];
+static httpc_connection_t http_settings;
+static char http_uri[16];
+
+static err_t bench_input(struct pbuf *p, struct netif *netif)
+{
+    b.rx += p->tot_len;
+    return b.input(p, netif);
+}
+
+static err_t bench_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    b.tx += p->tot_len;
+    return b.linkoutput(netif, p);
+}
+
+static int bench_is(enum bench_kind kind)
+{
+    const struct bench_case *c = bench_current();
+
+    return c != NULL && c->kind == kind;
+}
+
+static void bench_reset_watermarks(void)
+{
+    uint32_t i;
+
+    lwip_stats.mem.max = lwip_stats.mem.used;
+    for (i = 0; i < MEMP_MAX; i++)
+        lwip_stats.memp[i]->max = lwip_stats.memp[i]->used;
+}
+
+/*******************************************************************************
+ * Traffic of the cases
+ ******************************************************************************/
+static void bench_iperf_report(void *arg, enum lwiperf_report_type type,
+                               const ip_addr_t *local_addr, u16_t local_port,
+                               const ip_addr_t *remote_addr, u16_t remote_port,
+                               u32_t bytes, u32_t ms, u32_t kbps)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_addr);
+    LWIP_UNUSED_ARG(remote_port);
+    LWIP_UNUSED_ARG(bytes);
+    LWIP_UNUSED_ARG(ms);
+    LWIP_UNUSED_ARG(kbps);
+
+    if ((type == LWIPERF_TCP_DONE_SERVER && bench_is(BENCH_IPERF_SERVER)) ||
+        (type == LWIPERF_TCP_DONE_CLIENT && bench_is(BENCH_IPERF_CLIENT)))
+        b.ops++;
+}
+
+static void bench_udp_send(void)
+{
+    uint16_t len = bench_current()->payload;
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+
+    b.udp_sent = sys_now();
+    if (p == NULL)
+        return;
+    memset(p->payload, 0x55, len);
+    udp_sendto(b.udp, p, &b.cfg->peer, b.cfg->echo_port);
+    pbuf_free(p);
+}
+
+static void bench_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                           const ip_addr_t *addr, u16_t port)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    if (bench_is(BENCH_UDP_ECHO) && p->tot_len == bench_current()->payload) {
+        b.ops++;
+        bench_udp_send();
+    }
+    pbuf_free(p);
+}
+
+static err_t bench_http_recv(void *arg, struct altcp_pcb *pcb,
+                             struct pbuf *p, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p != NULL) {
+        altcp_recved(pcb, p->tot_len);
+        pbuf_free(p);
+    }
+    return ERR_OK;
+}
+
+static void bench_http_result(void *arg, httpc_result_t result,
+                              u32_t rx_content_len, u32_t srv_res, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(rx_content_len);
+    LWIP_UNUSED_ARG(err);
+
+    /* the next request from bench_poll(), not from within http_client.c */
+    b.http_busy = 0;
+    if (bench_is(BENCH_HTTP_GET) && result == HTTPC_RESULT_OK &&
+        srv_res == 200)
+        b.ops++;
+}
+
+static void bench_http_get(void)
+{
+    httpc_state_t *conn;
+
+    if (httpc_get_file(&b.cfg->peer, b.cfg->http_port, http_uri,
+                       &http_settings, bench_http_recv, NULL,
+                       &conn) == ERR_OK)
+        b.http_busy = 1;
+}
+
+/*******************************************************************************
+ * Cases
+ ******************************************************************************/
+static void bench_row(const char *second, uint32_t ms, uint64_t rx,
+                      uint64_t tx, uint32_t ops, uint32_t idle)
+{
+    struct stats_mem *pool = lwip_stats.memp[MEMP_PBUF_POOL];
+
+    if (ms == 0)
+        ms = 1;
+    printf("bench,%s,%s,%lu,%lu,%lu,%lu,%lu,%lu,%lu,%lu\n",
+           bench_current()->name, second,
+           (unsigned long) (rx * 8 / ms), (unsigned long) (tx * 8 / ms),
+           (unsigned long) ops, (unsigned long) idle,
+           (unsigned long) lwip_stats.mem.used,
+           (unsigned long) lwip_stats.mem.max, (unsigned long) pool->used,
+           (unsigned long) pool->max);
+}
+
+static void bench_case_start(void)
+{
+    const struct bench_case *c = bench_current();
+
+    memset(&results[b.index], 0, sizeof(results[b.index]));
+    b.second = 1;
+    b.idle_sum = 0;
+    b.ops = 0;
+    b.rx = 0;
+    b.tx = 0;
+    bench_reset_watermarks();
+
+    switch (c->kind) {
+    case BENCH_IPERF_SERVER:
+        /* left listening, lwiperf_abort() would not close the pcbs */
+        if (b.iperf_server == NULL)
+            b.iperf_server = lwiperf_start_tcp_server(
+                IP_ADDR_ANY, b.cfg->iperf_port, bench_iperf_report, NULL);
+        break;
+    case BENCH_IPERF_CLIENT:
+        lwiperf_start_tcp_client(&b.cfg->peer, b.cfg->iperf_port,
+                                 LWIPERF_CLIENT, bench_iperf_report, NULL);
+        break;
+    case BENCH_UDP_ECHO:
+        b.udp = udp_new();
+        if (b.udp == NULL)
+            break;
+        udp_recv(b.udp, bench_udp_recv, NULL);
+        bench_udp_send();
+        break;
+    case BENCH_HTTP_GET:
+        snprintf(http_uri, sizeof(http_uri), "/%u", c->payload);
+        memset(&http_settings, 0, sizeof(http_settings));
+        http_settings.result_fn = bench_http_result;
+        if (!b.http_busy)
+            bench_http_get();
+        break;
+    }
+}
+
+static void bench_finish(void)
+{
+    uint32_t i;
+
+    b.running = 0;
+    b.netif->input = b.input;
+    b.netif->linkoutput = b.linkoutput;
+    printf("memp,pool,used,max,avail,err\n");
+    for (i = 0; i < MEMP_MAX; i++)
+        printf("memp,%s,%lu,%lu,%lu,%lu\n", pool_names[i],
+               (unsigned long) lwip_stats.memp[i]->used,
+               (unsigned long) lwip_stats.memp[i]->max,
+               (unsigned long) lwip_stats.memp[i]->avail,
+               (unsigned long) lwip_stats.memp[i]->err);
+}
+
+static void bench_case_stop(void)
+{
+    struct bench_result *r = &results[b.index];
+
+    if (bench_current()->kind == BENCH_UDP_ECHO && b.udp != NULL) {
+        udp_remove(b.udp);
+        b.udp = NULL;
+    }
+    r->idle = (uint8_t) (r->seconds ? b.idle_sum / r->seconds : 0);
+    bench_row("all", r->seconds * BENCH_SECOND, r->rx_bytes, r->tx_bytes,
+              r->ops, r->idle);
+
+    if (++b.index < b.cfg->num_cases)
+        bench_case_start();
+    else
+        bench_finish();
+}
+
+/* The row of a second, the next case after the last one */
+static void bench_second(void)
+{
+    struct bench_result *r = &results[b.index];
+    uint32_t rx = b.rx, tx = b.tx, idle = 100;
+    char second[12];
+
+    b.rx -= rx;
+    b.tx -= tx;
+    if (b.idle_loops > 0)
+        idle = LWIP_MIN(100, (uint64_t) b.loops * 100 / b.idle_loops);
+    r->rx_bytes += rx;
+    r->tx_bytes += tx;
+    r->ops += b.ops;
+    r->seconds++;
+    b.idle_sum += idle;
+    snprintf(second, sizeof(second), "%lu", (unsigned long) b.second);
+    bench_row(second, BENCH_SECOND, rx, tx, b.ops, idle);
+    b.ops = 0;
+
+    if (b.second++ == bench_current()->duration)
+        bench_case_stop();
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int bench_start(struct netif *netif, const struct bench_cfg *cfg)
+{
+    if (b.running || cfg->num_cases == 0 || cfg->num_cases > BENCH_MAX_CASES)
+        return -1;
+
+    b.netif = netif;
+    b.cfg = cfg;
+    b.input = netif->input;
+    b.linkoutput = netif->linkoutput;
+    netif->input = bench_input;
+    netif->linkoutput = bench_linkoutput;
+    b.index = 0;
+    b.calibrating = 1;
+    b.loops = 0;
+    b.second_start = sys_now();
+    b.running = 1;
+    printf("bench,case,second,rx_kbps,tx_kbps,ops,idle_pct,mem_used,mem_max,"
+           "pbuf_pool_used,pbuf_pool_max\n");
+    return 0;
+}
+
+void bench_poll(void)
+{
+    if (!b.running)
+        return;
+    b.loops++;
+    if (bench_is(BENCH_UDP_ECHO) && b.udp != NULL &&
+        sys_now() - b.udp_sent >= BENCH_UDP_TIMEOUT)
+        bench_udp_send();
+    if (bench_is(BENCH_HTTP_GET) && !b.http_busy)
+        bench_http_get();
+    if (sys_now() - b.second_start < BENCH_SECOND)
+        return;
+
+    b.second_start += BENCH_SECOND;
+    if (b.calibrating) {
+        b.idle_loops = b.loops;
+        b.calibrating = 0;
+        bench_case_start();
+    } else {
+        bench_second();
+    }
+    b.loops = 0;
+}
+
+int bench_done(void)
+{
+    return b.cfg != NULL && !b.running;
+}
+
+const struct bench_case *bench_current(void)
+{
+    if (!b.running || b.calibrating)
+        return NULL;
+    return &b.cfg->cases[b.index];
+}
+
+const struct bench_result *bench_get_result(uint32_t i)
+{
+    return i < b.index ? &results[i] : NULL;
+}
@@ -0,0 +1,131 @@
+/**
+ * @file bench.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Throughput benchmark of the stack against a peer, CSV on stdout.
+ *
+ * Runs a list of cases one after the other, each for a fixed time:
+ *  - BENCH_IPERF_SERVER : lwiperf server here, the peer runs an iperf client
+ *  - BENCH_IPERF_CLIENT : lwiperf client to the iperf server of the peer,
+ *                         lwiperf sends for 10 s whatever the duration
+ *  - BENCH_UDP_ECHO     : datagrams of payload bytes to the UDP echo server
+ *                         of the peer, one in flight
+ *  - BENCH_HTTP_GET     : GET /<payload> from the HTTP server of the peer,
+ *                         one request after the other
+ *
+ * Every second a row "bench,<case>,<second>,..." gives the bytes the netif
+ * received and sent as kbit/s, the operations completed (iperf sessions,
+ * echoes, responses), the idle time and the heap and PBUF_POOL use with
+ * their watermark of the case. A row with second "all" closes each case,
+ * rows "memp,<pool>,..." the run. printf() goes to UART0 on the M487.
+ *
+ * Idle is the count of bench_poll() calls of the second against those of
+ * the calibration second before the first case, so bench_poll() is called
+ * once per main loop and the loop does not wait. On the host, where the
+ * loop runs once per event, it is only indicative.
+ *
+ * The same code runs on the M487 (BENCH_RUN in Core/main.c) and in the
+ * simulation of the unix port (UnitTest/host/sim/netsim.c, scenario bench).
+ */
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdint.h>
+#include "lwip/ip_addr.h"
+#include "lwip/netif.h"
+
+/*******************************************************************************
+ * Options
+ ******************************************************************************/
+/** Run the default cases against BENCH_PEER after start up (Core/main.c) */
+#ifndef BENCH_RUN
+#define BENCH_RUN 0
+#endif
+
+/** The PC running iperf -s, iperf -c, a UDP echo server and a HTTP server */
+#ifndef BENCH_PEER
+#define BENCH_PEER(addr) IP_ADDR4(addr, 192, 168, 0, 220)
+#endif
+
+/** A datagram not echoed within this time is sent again (ms) */
+#ifndef BENCH_UDP_TIMEOUT
+#define BENCH_UDP_TIMEOUT 100
+#endif
+
+/** Cases of a run, for their results */
+#ifndef BENCH_MAX_CASES
+#define BENCH_MAX_CASES 16
+#endif
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+enum bench_kind {
+    BENCH_IPERF_SERVER,
+    BENCH_IPERF_CLIENT,
+    BENCH_UDP_ECHO,
+    BENCH_HTTP_GET,
+};
+
+struct bench_case {
+    const char *name;
+    enum bench_kind kind;
+    uint32_t duration;   /* s */
+    uint16_t payload;    /* bytes of a datagram or a response body */
+};
+
+struct bench_cfg {
+    ip_addr_t peer;
+    uint16_t iperf_port; /* of the server here and of the one of the peer */
+    uint16_t echo_port;
+    uint16_t http_port;
+    const struct bench_case *cases;
+    uint32_t num_cases;
+};
+
+/** Totals of a case */
+struct bench_result {
+    uint64_t rx_bytes;
+    uint64_t tx_bytes;
+    uint32_t ops;
+    uint32_t seconds;
+    uint8_t idle;        /* % */
+};
+
+/** Cases of BENCH_RUN */
+extern const struct bench_case bench_default_cases[];
+extern const uint32_t bench_num_default_cases;
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Count the traffic of netif and start with the calibration second.
+ *        cfg and its cases must stay valid until bench_done().
+ * @return 0, -1 if a run is going on or there are no cases
+ */
+int bench_start(struct netif *netif, const struct bench_cfg *cfg);
+
+/**
+ * @brief Advance the run, once per main loop.
+ */
+void bench_poll(void);
+
+/**
+ * @brief Whether the last case has finished, the netif is left as it was.
+ */
+int bench_done(void);
+
+/**
+ * @brief The case running, NULL during the calibration and when done.
+ */
+const struct bench_case *bench_current(void);
+
+/**
+ * @brief Totals of the i-th case, once it has finished.
+ */
+const struct bench_result *bench_get_result(uint32_t i);
+
+#endif /* BENCH_H */
@@ -0,0 +1,52 @@
+/**
+ * @file flash_dev.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief NOR flash interface of the upload pipeline.
+ *
+ *  - flash_w25q : onboard w25q128jv on SPI2 (flash_w25q.c)
+ *  - a file-backed stand-in for host tests (UnitTest/host/flash_file.c)
+ *
+ * Erase and program only start the operation, busy() tells when the flash
+ * is done, so the caller keeps receiving while a page is programmed. So
+ * does read_start(), where the data is moved by DMA (flash_fs.c).
+ */
+
+#ifndef FLASH_DEV_H
+#define FLASH_DEV_H
+
+#include <stdint.h>
+
+struct flash_dev {
+    uint32_t size;        /* bytes */
+    uint32_t page_size;   /* largest program, page aligned */
+    uint32_t sector_size; /* smallest erase */
+    uint32_t block_size;  /* faster erase of many sectors, 0 if none */
+    /** Start erasing len (sector_size or block_size) bytes at addr, aligned */
+    int (*erase)(const struct flash_dev *dev, uint32_t addr, uint32_t len);
+    /** Start programming len bytes at addr, within one page */
+    int (*program)(const struct flash_dev *dev, uint32_t addr,
+                   const uint8_t *data, uint32_t len);
+    /** Whether an erase, program or started read is still running */
+    int (*busy)(const struct flash_dev *dev);
+    /** Read len bytes at addr, waits for a running erase or program */
+    int (*read)(const struct flash_dev *dev, uint32_t addr, uint8_t *buf,
+                uint32_t len);
+    /** Start reading len bytes at addr to buf, done when busy() is 0. NULL
+        if reads only block. */
+    int (*read_start)(const struct flash_dev *dev, uint32_t addr,
+                      uint8_t *buf, uint32_t len);
+};
+
+/*******************************************************************************
+ * w25q128jv
+ ******************************************************************************/
+extern const struct flash_dev flash_w25q;
+
+/**
+ * @brief Check the JEDEC ID of the flash on SPI2 (system_spi_init()).
+ * @return 0 if a w25q128jv answers
+ */
+int flash_w25q_init(void);
+
+#endif /* FLASH_DEV_H */
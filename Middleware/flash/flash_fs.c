@@ -0,0 +1,637 @@
+/**
+ * @file flash_fs.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Read-only file system image on the external flash.
+ *
+ * A name is found by a binary search of the index on its hash, the entries
+ * and names are read through the cache, so a lookup of a file that was
+ * served recently does not touch the flash. The cache evicts the block used
+ * least recently. The image structs are read as they are stored, the M487
+ * and the hosts building the image are little-endian.
+ *
+ * flash_fs_read_async() has one background read at a time, of a cache block
+ * or of the stream buffer. It is started right away if the flash is idle,
+ * otherwise by flash_fs_poll(), and the block is left out of the LRU until
+ * it is in. Readers that find the flash taken wait for that read too, then
+ * try again. The one that started it is called back first. A part is
+ * returned once it is complete, not a few bytes up to the first miss, so
+ * it is sent in full segments. Its blocks are not evicted for its own
+ * reads, a small file spans half of the cache at most.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "flash_fs.h"
+#include "lwip/apps/fs.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/def.h"
+
+#if FLASH_FS_BLOCK_SIZE & (FLASH_FS_BLOCK_SIZE - 1)
+#error "FLASH_FS_BLOCK_SIZE must be a power of two"
+#endif
+#if FLASH_FS_CACHE_BLOCKS < 4
+#error "FLASH_FS_CACHE_BLOCKS must be 4 or more"
+#endif
+
+#define FLASH_FS_NO_BLOCK 0xFFFFFFFFUL
+
+/* Files read past the cache */
+#define FLASH_FS_LARGE_FILE (FLASH_FS_CACHE_BLOCKS * FLASH_FS_BLOCK_SIZE / 2)
+
+static struct {
+    const struct flash_dev *dev;
+    uint32_t addr;       /* of the image */
+    uint32_t size;
+    uint16_t num_files;
+    uint8_t mounted;
+} fs;
+
+static struct {
+    uint32_t addr;       /* flash address of data, FLASH_FS_NO_BLOCK if empty */
+    uint32_t used;       /* tick of the last use */
+    uint8_t filling;     /* by the background read */
+    uint8_t data[FLASH_FS_BLOCK_SIZE];
+} cache[FLASH_FS_CACHE_BLOCKS];
+
+/* The last background read of a large file */
+static struct {
+    uint32_t addr;       /* flash address of data, FLASH_FS_NO_BLOCK if empty */
+    uint32_t len;
+    uint8_t data[FLASH_FS_STREAM_SIZE];
+} stream;
+
+static struct {
+    const struct flash_dev *dev;
+    uint8_t *buf;
+    uint32_t addr;
+    uint32_t len;
+    int8_t block;        /* cache block filled, -1 for the stream buffer */
+    uint8_t active;
+    uint8_t started;     /* read_start() called */
+    uint8_t discard;     /* unmounted meanwhile */
+    struct flash_fs_file *owner;
+} job;
+
+static struct flash_fs_file *waiters[FLASH_FS_MAX_OPEN];
+
+static uint32_t tick;
+static struct flash_fs_stats stats;
+
+static void flash_fs_cache_clear(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < FLASH_FS_CACHE_BLOCKS; i++) {
+        cache[i].addr = FLASH_FS_NO_BLOCK;
+        cache[i].used = 0;
+    }
+    stream.addr = FLASH_FS_NO_BLOCK;
+}
+
+/**
+ * @brief The index of the cached block at addr (block aligned), -1 if not
+ *        cached.
+ */
+static int flash_fs_cache_find(uint32_t addr)
+{
+    int i;
+
+    for (i = 0; i < FLASH_FS_CACHE_BLOCKS; i++) {
+        if (cache[i].addr == addr) {
+            cache[i].used = ++tick;
+            stats.hits++;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/**
+ * @brief The least recently used block, emptied. Not the one being filled,
+ *        nor one of the flash addresses lo .. hi - 1 a read is waiting for.
+ */
+static int flash_fs_cache_victim(uint32_t lo, uint32_t hi)
+{
+    int i, victim = -1;
+
+    for (i = 0; i < FLASH_FS_CACHE_BLOCKS; i++) {
+        if (cache[i].filling || (cache[i].addr < hi &&
+                                 cache[i].addr + FLASH_FS_BLOCK_SIZE > lo))
+            continue;
+        if (victim < 0 || cache[i].used < cache[victim].used)
+            victim = i;
+    }
+    stats.misses++;
+    cache[victim].addr = FLASH_FS_NO_BLOCK;
+    return victim;
+}
+
+/**
+ * @brief The cached block at addr (block aligned), read from the flash in
+ *        place of the least recently used one if not cached.
+ * @return NULL on a flash error
+ */
+static const uint8_t *flash_fs_cache_block(uint32_t addr)
+{
+    int victim = flash_fs_cache_find(addr);
+
+    if (victim >= 0)
+        return cache[victim].data;
+
+    victim = flash_fs_cache_victim(0, 0);
+    if (fs.dev->read(fs.dev, addr, cache[victim].data,
+                     LWIP_MIN(FLASH_FS_BLOCK_SIZE, fs.dev->size - addr)))
+        return NULL;
+    cache[victim].addr = addr;
+    cache[victim].used = ++tick;
+    return cache[victim].data;
+}
+
+/**
+ * @brief Read len bytes at offset of the image through the cache.
+ */
+static int flash_fs_cache_read(uint32_t offset, void *buf, uint32_t len)
+{
+    uint32_t addr = fs.addr + offset, off, n;
+    const uint8_t *block;
+    uint8_t *dst = buf;
+
+    while (len > 0) {
+        off = addr & (FLASH_FS_BLOCK_SIZE - 1);
+        n = LWIP_MIN(len, FLASH_FS_BLOCK_SIZE - off);
+        block = flash_fs_cache_block(addr - off);
+        if (block == NULL)
+            return -1;
+        memcpy(dst, &block[off], n);
+        addr += n;
+        dst += n;
+        len -= n;
+    }
+    return 0;
+}
+
+static int flash_fs_entry(uint32_t i, struct flash_fs_entry *e)
+{
+    return flash_fs_cache_read(sizeof(struct flash_fs_header) + i * sizeof(*e),
+                               e, sizeof(*e));
+}
+
+/**
+ * @brief Whether the entry is within the image, checked once at mount.
+ */
+static int flash_fs_entry_valid(const struct flash_fs_entry *e)
+{
+    uint32_t end = fs.size - sizeof(uint32_t);
+
+    return e->name < end && e->offset <= end && e->len <= end - e->offset &&
+           e->hdr_len <= e->len;
+}
+
+static int flash_fs_name_equal(const struct flash_fs_entry *e,
+                               const char *name)
+{
+    char buf[FLASH_FS_NAME_MAX];
+    uint32_t n = LWIP_MIN(sizeof(buf), fs.size - e->name);
+
+    if (flash_fs_cache_read(e->name, buf, n))
+        return 0;
+    return strncmp(buf, name, n) == 0 && memchr(buf, '\0', n) != NULL;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int flash_fs_mount(const struct flash_dev *dev, uint32_t addr)
+{
+    struct flash_fs_header hdr;
+    struct flash_fs_entry e;
+    uint32_t magic, i;
+
+    flash_fs_unmount();
+    if (addr >= dev->size || dev->size - addr < sizeof(hdr) ||
+        dev->read(dev, addr, (uint8_t *) &hdr, sizeof(hdr)))
+        return -1;
+    if (hdr.magic != FLASH_FS_MAGIC || hdr.size > dev->size - addr ||
+        hdr.names > hdr.size ||
+        hdr.names < sizeof(hdr) + (uint32_t) hdr.num_files * sizeof(e) ||
+        dev->read(dev, addr + hdr.size - sizeof(magic), (uint8_t *) &magic,
+                  sizeof(magic)) ||
+        magic != FLASH_FS_MAGIC)
+        return -1;
+
+    fs.dev = dev;
+    fs.addr = addr;
+    fs.size = hdr.size;
+    fs.num_files = hdr.num_files;
+    for (i = 0; i < fs.num_files; i++) {
+        if (flash_fs_entry(i, &e) || !flash_fs_entry_valid(&e))
+            return -1;
+    }
+    fs.mounted = 1;
+    printf("[INFO]: flash fs at 0x%06lx, %u files, %lu bytes\n",
+           (unsigned long) addr, fs.num_files, (unsigned long) fs.size);
+    return 0;
+}
+
+void flash_fs_unmount(void)
+{
+    fs.mounted = 0;
+    /* a block being filled stays out of the LRU until the read is in */
+    job.discard = 1;
+    flash_fs_cache_clear();
+}
+
+int flash_fs_open(const char *name, struct flash_fs_file *file)
+{
+    struct flash_fs_entry e;
+    uint32_t h = FLASH_FS_HASH_INIT;
+    uint32_t lo = 0, hi, mid;
+    const char *c;
+
+    if (!fs.mounted)
+        return -1;
+    for (c = name; *c; c++)
+        h = FLASH_FS_HASH_STEP(h, *c);
+
+    /* first entry with a hash >= h */
+    hi = fs.num_files;
+    while (lo < hi) {
+        mid = lo + (hi - lo) / 2;
+        if (flash_fs_entry(mid, &e))
+            return -1;
+        if (e.hash < h)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    for (; lo < fs.num_files; lo++) {
+        if (flash_fs_entry(lo, &e) || e.hash != h)
+            return -1;
+        if (flash_fs_name_equal(&e, name)) {
+            file->addr = fs.addr + e.offset;
+            file->len = e.len;
+            file->hdr_len = e.hdr_len;
+            file->flags = e.flags;
+            file->waiting = 0;
+            file->cb = NULL;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int flash_fs_read(const struct flash_fs_file *file, uint32_t offset,
+                  uint8_t *buf, uint32_t len)
+{
+    if (!fs.mounted)
+        return -1;
+    if (offset >= file->len)
+        return 0;
+    len = LWIP_MIN(len, file->len - offset);
+
+    if (file->len > FLASH_FS_LARGE_FILE) {
+        stats.bypassed++;
+        if (fs.dev->read(fs.dev, file->addr + offset, buf, len))
+            return -1;
+    } else if (flash_fs_cache_read(file->addr - fs.addr + offset, buf, len)) {
+        return -1;
+    }
+    return (int) len;
+}
+
+/**
+ * @brief Start the background read if the flash is idle, reading it the
+ *        blocking way if it cannot be started.
+ */
+static void flash_fs_job_try(void)
+{
+    if (job.dev->busy(job.dev))
+        return;
+    job.started = 1;
+    if (job.dev->read_start(job.dev, job.addr, job.buf, job.len) &&
+        job.dev->read(job.dev, job.addr, job.buf, job.len))
+        job.discard = 1;
+}
+
+static void flash_fs_job_start(struct flash_fs_file *owner, int block,
+                               uint8_t *buf, uint32_t addr, uint32_t len)
+{
+    job.dev = fs.dev;
+    job.buf = buf;
+    job.addr = addr;
+    job.len = len;
+    job.block = (int8_t) block;
+    job.active = 1;
+    job.started = 0;
+    job.discard = 0;
+    job.owner = owner;
+    if (block >= 0)
+        cache[block].filling = 1;
+    flash_fs_job_try();
+}
+
+static void flash_fs_wake(struct flash_fs_file *file)
+{
+    if (!file->waiting)
+        return;
+    file->waiting = 0;
+    if (file->cb != NULL)
+        file->cb(file->arg);
+}
+
+static void flash_fs_job_done(void)
+{
+    struct flash_fs_file *woken[FLASH_FS_MAX_OPEN];
+    struct flash_fs_file *owner = job.owner;
+    uint32_t i;
+
+    if (job.block >= 0) {
+        cache[job.block].filling = 0;
+        if (!job.discard) {
+            cache[job.block].addr = job.addr;
+            cache[job.block].used = ++tick;
+        }
+    } else if (!job.discard) {
+        stream.addr = job.addr;
+        stream.len = job.len;
+    }
+    job.active = 0;
+
+    /* the callbacks may wait again, for the next read */
+    memcpy(woken, waiters, sizeof(woken));
+    memset(waiters, 0, sizeof(waiters));
+    if (owner != NULL)
+        flash_fs_wake(owner);
+    for (i = 0; i < FLASH_FS_MAX_OPEN; i++) {
+        if (woken[i] != NULL && woken[i] != owner)
+            flash_fs_wake(woken[i]);
+    }
+}
+
+/**
+ * @brief Wait for the background read.
+ * @return 0, -1 if FLASH_FS_MAX_OPEN files wait already
+ */
+static int flash_fs_wait(struct flash_fs_file *file, void (*cb)(void *arg),
+                         void *arg)
+{
+    uint32_t i, slot = FLASH_FS_MAX_OPEN;
+
+    for (i = 0; i < FLASH_FS_MAX_OPEN; i++) {
+        if (waiters[i] == file)
+            break;
+        if (waiters[i] == NULL && slot == FLASH_FS_MAX_OPEN)
+            slot = i;
+    }
+    if (i == FLASH_FS_MAX_OPEN) {
+        if (slot == FLASH_FS_MAX_OPEN)
+            return -1;
+        waiters[slot] = file;
+    }
+    file->cb = cb;
+    file->arg = arg;
+    file->waiting = 1;
+    stats.delayed++;
+    return 0;
+}
+
+int flash_fs_read_async(struct flash_fs_file *file, uint32_t offset,
+                        uint8_t *buf, uint32_t len, void (*cb)(void *arg),
+                        void *arg)
+{
+    uint32_t addr = file->addr + offset, base, off, n = 0, chunk;
+    int i;
+
+    if (!fs.mounted)
+        return -1;
+    if (fs.dev->read_start == NULL)
+        return flash_fs_read(file, offset, buf, len);
+    if (offset >= file->len)
+        return 0;
+    len = LWIP_MIN(len, file->len - offset);
+
+    if (file->len > FLASH_FS_LARGE_FILE) {
+        if (addr >= stream.addr && addr - stream.addr < stream.len) {
+            n = LWIP_MIN(len, stream.len - (addr - stream.addr));
+            memcpy(buf, &stream.data[addr - stream.addr], n);
+            stats.bypassed++;
+            if (n == len || n >= FLASH_FS_STREAM_SIZE / 2)
+                return (int) n;
+            /* read again from addr, not a few bytes now and the rest later */
+        }
+    } else {
+        while (n < len) {
+            off = (addr + n) & (FLASH_FS_BLOCK_SIZE - 1);
+            i = flash_fs_cache_find(addr + n - off);
+            if (i < 0)
+                break;
+            chunk = LWIP_MIN(len - n, FLASH_FS_BLOCK_SIZE - off);
+            memcpy(&buf[n], &cache[i].data[off], chunk);
+            n += chunk;
+        }
+        if (n == len)
+            return (int) n;
+    }
+
+    if (flash_fs_wait(file, cb, arg))
+        return flash_fs_read(file, offset, buf, len);
+    if (job.active)
+        return FLASH_FS_DELAYED;
+    if (file->len > FLASH_FS_LARGE_FILE) {
+        stream.addr = FLASH_FS_NO_BLOCK;
+        flash_fs_job_start(file, -1, stream.data, addr,
+                           LWIP_MIN(FLASH_FS_STREAM_SIZE, file->len - offset));
+    } else {
+        base = (addr + n) & ~(FLASH_FS_BLOCK_SIZE - 1UL);
+        i = flash_fs_cache_victim(addr, addr + len);
+        flash_fs_job_start(file, i, cache[i].data, base,
+                           LWIP_MIN(FLASH_FS_BLOCK_SIZE, fs.dev->size - base));
+    }
+    return FLASH_FS_DELAYED;
+}
+
+void flash_fs_close(struct flash_fs_file *file)
+{
+    uint32_t i;
+
+    file->waiting = 0;
+    for (i = 0; i < FLASH_FS_MAX_OPEN; i++) {
+        if (waiters[i] == file)
+            waiters[i] = NULL;
+    }
+    if (job.owner == file)
+        job.owner = NULL;
+}
+
+void flash_fs_poll(void)
+{
+    if (!job.active)
+        return;
+    if (!job.started)
+        flash_fs_job_try();
+    else if (!job.dev->busy(job.dev))
+        flash_fs_job_done();
+}
+
+const struct flash_fs_stats *flash_fs_get_stats(void)
+{
+    return &stats;
+}
+
+/*******************************************************************************
+ * httpd custom files
+ ******************************************************************************/
+#if LWIP_HTTPD_CUSTOM_FILES
+#if !LWIP_HTTPD_DYNAMIC_FILE_READ
+#error "flash_fs.c needs LWIP_HTTPD_DYNAMIC_FILE_READ"
+#endif
+
+/* The handles of pextension */
+static struct flash_fs_file httpd_files[FLASH_FS_MAX_OPEN];
+static uint8_t httpd_open[FLASH_FS_MAX_OPEN];
+
+int fs_open_custom(struct fs_file *file, const char *name)
+{
+    uint32_t i;
+
+    for (i = 0; i < FLASH_FS_MAX_OPEN; i++) {
+        if (!httpd_open[i])
+            break;
+    }
+    /* none free, fsdata.c may still have the file */
+    if (i == FLASH_FS_MAX_OPEN || flash_fs_open(name, &httpd_files[i]))
+        return 0;
+    httpd_open[i] = 1;
+    file->data = NULL;
+    file->len = (int) httpd_files[i].len;
+    file->index = 0;
+    file->pextension = &httpd_files[i];
+    file->flags = httpd_files[i].flags;
+#if HTTPD_PRECALCULATED_CHECKSUM
+    file->chksum = NULL;
+    file->chksum_count = 0;
+#endif
+    return 1;
+}
+
+void fs_close_custom(struct fs_file *file)
+{
+    struct flash_fs_file *f = file->pextension;
+
+    flash_fs_close(f);
+    httpd_open[f - httpd_files] = 0;
+}
+
+#if LWIP_HTTPD_FS_ASYNC_READ
+u8_t fs_canread_custom(struct fs_file *file)
+{
+    struct flash_fs_file *f = file->pextension;
+
+    /* asked of the files of fsdata.c too */
+    return !file->is_custom_file || !f->waiting;
+}
+
+u8_t fs_wait_read_custom(struct fs_file *file, fs_wait_cb callback_fn,
+                         void *callback_arg)
+{
+    struct flash_fs_file *f = file->pextension;
+
+    if (!file->is_custom_file || !f->waiting)
+        return 0;
+    f->cb = callback_fn;
+    f->arg = callback_arg;
+    return 1;
+}
+
+int fs_read_async_custom(struct fs_file *file, char *buffer, int count,
+                         fs_wait_cb callback_fn, void *callback_arg)
+{
+    int n;
+
+    n = flash_fs_read_async(file->pextension, (uint32_t) file->index,
+                            (uint8_t *) buffer, (uint32_t) count,
+                            callback_fn, callback_arg);
+    if (n == FLASH_FS_DELAYED)
+        return FS_READ_DELAYED;
+    if (n <= 0)
+        return FS_READ_EOF;
+    file->index += n;
+    return n;
+}
+#else
+int fs_read_custom(struct fs_file *file, char *buffer, int count)
+{
+    int n;
+
+    n = flash_fs_read(file->pextension, (uint32_t) file->index,
+                      (uint8_t *) buffer, (uint32_t) count);
+    if (n <= 0)
+        return FS_READ_EOF;
+    file->index += n;
+    return n;
+}
+#endif /* LWIP_HTTPD_FS_ASYNC_READ */
+#endif /* LWIP_HTTPD_CUSTOM_FILES */
+
+/*******************************************************************************
+ * tftp_server.c
+ ******************************************************************************/
+static struct {
+    struct flash_fs_file file;
+    uint32_t offset;
+    uint8_t open;
+} tftp;
+
+static void *flash_fs_tftp_open(const char *fname, const char *mode,
+                                u8_t write)
+{
+    char name[FLASH_FS_NAME_MAX];
+
+    /* netascii files are sent as they are stored */
+    LWIP_UNUSED_ARG(mode);
+    if (write || tftp.open)
+        return NULL;
+    /* TFTP names come without the leading '/' of the URIs */
+    if (fname[0] != '/') {
+        snprintf(name, sizeof(name), "/%s", fname);
+        fname = name;
+    }
+    if (flash_fs_open(fname, &tftp.file))
+        return NULL;
+    /* the file without the HTTP header */
+    tftp.offset = tftp.file.hdr_len;
+    tftp.open = 1;
+    return &tftp;
+}
+
+static void flash_fs_tftp_close(void *handle)
+{
+    LWIP_UNUSED_ARG(handle);
+    tftp.open = 0;
+}
+
+static int flash_fs_tftp_read(void *handle, void *buf, int bytes)
+{
+    int n;
+
+    LWIP_UNUSED_ARG(handle);
+    n = flash_fs_read(&tftp.file, tftp.offset, buf, (uint32_t) bytes);
+    if (n > 0)
+        tftp.offset += (uint32_t) n;
+    return n;
+}
+
+static int flash_fs_tftp_write(void *handle, struct pbuf *p)
+{
+    LWIP_UNUSED_ARG(handle);
+    LWIP_UNUSED_ARG(p);
+    return -1;
+}
+
+const struct tftp_context flash_fs_tftp = {
+    flash_fs_tftp_open,
+    flash_fs_tftp_close,
+    flash_fs_tftp_read,
+    flash_fs_tftp_write,
+};
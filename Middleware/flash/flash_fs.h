@@ -0,0 +1,162 @@
+/**
+ * @file flash_fs.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Read-only file system image on the external flash.
+ *
+ * The image is built on the host (mkflashfs/) and written anywhere on the
+ * flash, e.g. by a POST to flash_upload.c:
+ *
+ *  - header     : struct flash_fs_header
+ *  - index      : struct flash_fs_entry[num_files], sorted by name hash
+ *  - names      : null-terminated, referenced by the entries
+ *  - blobs      : one per file at FLASH_FS_ALIGN, the HTTP header that
+ *                 mkflashfs generated followed by the file
+ *  - trailer    : FLASH_FS_MAGIC in the last four bytes, so an image whose
+ *                 upload did not complete is not mounted
+ *
+ * Numbers are little-endian. Flash reads go through an LRU cache of
+ * FLASH_FS_CACHE_BLOCKS blocks in RAM, which keeps the index and the small
+ * files that are served again and again. Files larger than half of the cache
+ * are read past it, so streaming one does not evict them.
+ *
+ * flash_fs_read_async() does not wait for the flash: a block that is not
+ * cached is read by read_start() of the flash_dev (PDMA on the M487) while
+ * the main loop goes on, flash_fs_poll() calls back the readers once it is
+ * in. Large files are streamed through a buffer of FLASH_FS_STREAM_SIZE.
+ *
+ * httpd opens the files with fs_open_custom() (LWIP_HTTPD_CUSTOM_FILES)
+ * before the ones of fsdata.c, and reads them with fs_read_async_custom()
+ * if LWIP_HTTPD_FS_ASYNC_READ. tftp_server.c reads with flash_fs_tftp.
+ */
+
+#ifndef FLASH_FS_H
+#define FLASH_FS_H
+
+#include <stdint.h>
+#include "flash_dev.h"
+
+#define FLASH_FS_MAGIC   0x31534646UL /* "FFS1" */
+#define FLASH_FS_ALIGN   256          /* of the blobs, a flash page */
+
+/** Blocks of the RAM cache */
+#ifndef FLASH_FS_CACHE_BLOCKS
+#define FLASH_FS_CACHE_BLOCKS 8
+#endif
+
+/** Bytes per cache block, a power of two */
+#ifndef FLASH_FS_BLOCK_SIZE
+#define FLASH_FS_BLOCK_SIZE 512
+#endif
+
+/** Bytes of a background read of a large file */
+#ifndef FLASH_FS_STREAM_SIZE
+#define FLASH_FS_STREAM_SIZE 2048
+#endif
+
+/** Files open in httpd, and files waiting for flash_fs_read_async() */
+#ifndef FLASH_FS_MAX_OPEN
+#define FLASH_FS_MAX_OPEN 8
+#endif
+
+/** Longest file name, null included */
+#define FLASH_FS_NAME_MAX 64
+
+/** Hash of the file names, 32 bit FNV-1a as the one of fsdata.c */
+#define FLASH_FS_HASH_INIT       2166136261UL
+#define FLASH_FS_HASH_STEP(h, c) ((uint32_t) (((h) ^ (uint8_t) (c)) * 16777619UL))
+
+struct flash_fs_header {
+    uint32_t magic;
+    uint32_t size;       /* of the image, trailer included */
+    uint16_t num_files;
+    uint16_t reserved;
+    uint32_t names;      /* offset of the names */
+};
+
+struct flash_fs_entry {
+    uint32_t hash;       /* of the name */
+    uint32_t name;       /* offset of the name */
+    uint32_t offset;     /* of the blob */
+    uint32_t len;        /* of the blob, header included */
+    uint16_t hdr_len;    /* HTTP header before the file */
+    uint8_t flags;       /* FS_FILE_FLAGS_* of httpd */
+    uint8_t reserved;
+};
+
+/** flash_fs_read_async() started a read, the callback tells when done */
+#define FLASH_FS_DELAYED (-2)
+
+/** An open file, the blob at addr */
+struct flash_fs_file {
+    uint32_t addr;
+    uint32_t len;
+    uint16_t hdr_len;
+    uint8_t flags;
+    uint8_t waiting;     /* for a background read, callback not called yet */
+    void (*cb)(void *arg);
+    void *arg;
+};
+
+struct flash_fs_stats {
+    uint32_t hits;       /* cache blocks found */
+    uint32_t misses;     /* cache blocks read from the flash */
+    uint32_t bypassed;   /* reads of large files past the cache */
+    uint32_t delayed;    /* FLASH_FS_DELAYED returned */
+};
+
+/**
+ * @brief Mount the image at addr, empties the cache. Mount again after the
+ *        image has been rewritten.
+ * @return 0, -1 if there is no complete image at addr
+ */
+int flash_fs_mount(const struct flash_dev *dev, uint32_t addr);
+
+void flash_fs_unmount(void);
+
+/**
+ * @brief Find a file, name as in the URI ("/index.html").
+ * @return 0, -1 if not found or nothing mounted
+ */
+int flash_fs_open(const char *name, struct flash_fs_file *file);
+
+/**
+ * @brief Read up to len bytes at offset of the blob.
+ * @return bytes read, 0 at the end, -1 on a flash error
+ */
+int flash_fs_read(const struct flash_fs_file *file, uint32_t offset,
+                  uint8_t *buf, uint32_t len);
+
+/**
+ * @brief Read up to len bytes at offset of the blob if they are in RAM,
+ *        otherwise start reading them from the flash and call cb(arg) from
+ *        flash_fs_poll() when they are, to be read again. Blocks as
+ *        flash_fs_read() if the flash_dev has no read_start().
+ * @return bytes read, 0 at the end, -1 on a flash error, FLASH_FS_DELAYED
+ */
+int flash_fs_read_async(struct flash_fs_file *file, uint32_t offset,
+                        uint8_t *buf, uint32_t len, void (*cb)(void *arg),
+                        void *arg);
+
+/**
+ * @brief Done with the file, its callback is not called any more.
+ */
+void flash_fs_close(struct flash_fs_file *file);
+
+/**
+ * @brief Start the next background read, or call back the readers of the
+ *        one that is done. Called from the main loop.
+ */
+void flash_fs_poll(void);
+
+const struct flash_fs_stats *flash_fs_get_stats(void);
+
+/*******************************************************************************
+ * tftp_server.c
+ ******************************************************************************/
+struct tftp_context;
+
+/** Read-only context for tftp_init(), one transfer at a time */
+extern const struct tftp_context flash_fs_tftp;
+
+#endif /* FLASH_FS_H */
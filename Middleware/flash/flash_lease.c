@@ -0,0 +1,189 @@
+/**
+ * @file flash_lease.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief DHCP lease kept on the external flash across restarts.
+ *
+ * rec is the lease as dhcp.c last stored it, out the record being
+ * programmed: the flash may still read from it after program() returned.
+ * [0, next) of the sector is used, a record is free when all of its bytes
+ * read erased.
+ *
+ * dhcp_lease_store() may run in the EMAC Rx interrupt (ethernetif_input()),
+ * it only writes rec and sets pending. flash_lease_poll() in the main loop
+ * copies rec again if a store came in meanwhile.
+ */
+
+#include <string.h>
+#include "flash_lease.h"
+#include "lwip/dhcp.h"
+
+#if !LWIP_DHCP_LEASE_STORE
+#error "flash_lease.c needs LWIP_DHCP_LEASE_STORE"
+#endif
+
+#define FLASH_LEASE_REC_SIZE sizeof(struct flash_lease_record)
+
+static struct {
+    const struct flash_dev *dev; /* NULL until flash_lease_init() */
+    uint32_t addr;               /* of the sector */
+    uint32_t next;               /* offset of the first free record */
+    uint32_t seq;                /* of the last record */
+    volatile uint8_t pending;    /* rec not written yet */
+    uint8_t erasing;
+    struct flash_lease_record rec;
+    struct flash_lease_record out;
+} fl;
+
+static struct flash_lease_stats stats;
+
+/**
+ * @brief ~ sum of the words before check.
+ */
+static uint32_t flash_lease_check(const struct flash_lease_record *r)
+{
+    const uint32_t *w = &r->magic;
+    uint32_t sum = 0;
+
+    while (w < &r->check)
+        sum += *w++;
+    return ~sum;
+}
+
+static int flash_lease_valid(const struct flash_lease_record *r)
+{
+    return r->magic == FLASH_LEASE_MAGIC && r->check == flash_lease_check(r);
+}
+
+static int flash_lease_erased(const struct flash_lease_record *r)
+{
+    const uint8_t *b = (const uint8_t *) r;
+    uint32_t i;
+
+    for (i = 0; i < FLASH_LEASE_REC_SIZE; i++) {
+        if (b[i] != 0xff)
+            return 0;
+    }
+    return 1;
+}
+
+/**
+ * @brief Whether the lease of a record is the same as rec's.
+ */
+static int flash_lease_same(const struct flash_lease_record *r)
+{
+    return r->addr == fl.rec.addr && r->netmask == fl.rec.netmask &&
+           r->gw == fl.rec.gw && r->server == fl.rec.server &&
+           r->lease_time == fl.rec.lease_time;
+}
+
+/*******************************************************************************
+ * dhcp.c
+ ******************************************************************************/
+u8_t dhcp_lease_load(struct netif *netif, struct dhcp_lease *lease)
+{
+    LWIP_UNUSED_ARG(netif);
+
+    if (fl.rec.addr == 0)
+        return 0;
+    ip4_addr_set_u32(&lease->addr, fl.rec.addr);
+    ip4_addr_set_u32(&lease->netmask, fl.rec.netmask);
+    ip4_addr_set_u32(&lease->gw, fl.rec.gw);
+    ip4_addr_set_u32(&lease->server, fl.rec.server);
+    lease->lease_time = fl.rec.lease_time;
+    return 1;
+}
+
+void dhcp_lease_store(struct netif *netif, const struct dhcp_lease *lease)
+{
+    struct flash_lease_record r;
+
+    LWIP_UNUSED_ARG(netif);
+
+    memset(&r, 0, sizeof(r));
+    if (lease != NULL) {
+        r.addr = ip4_addr_get_u32(&lease->addr);
+        r.netmask = ip4_addr_get_u32(&lease->netmask);
+        r.gw = ip4_addr_get_u32(&lease->gw);
+        r.server = ip4_addr_get_u32(&lease->server);
+        r.lease_time = lease->lease_time;
+    }
+    if (flash_lease_same(&r)) {
+        stats.skipped++;
+        return;
+    }
+    fl.rec = r;
+    fl.pending = 1;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int flash_lease_init(const struct flash_dev *dev, uint32_t addr)
+{
+    struct flash_lease_record r;
+    uint32_t off;
+
+    if (addr & (dev->sector_size - 1) || addr + dev->sector_size > dev->size)
+        return -1;
+
+    memset(&fl, 0, sizeof(fl));
+    for (off = 0; off + FLASH_LEASE_REC_SIZE <= dev->sector_size;
+         off += FLASH_LEASE_REC_SIZE) {
+        if (dev->read(dev, addr + off, (uint8_t *) &r, sizeof(r)) != 0 ||
+            flash_lease_erased(&r))
+            break;
+        if (flash_lease_valid(&r)) {
+            fl.rec = r;
+            fl.seq = r.seq;
+        }
+    }
+    fl.dev = dev;
+    fl.addr = addr;
+    fl.next = off;
+    return 0;
+}
+
+void flash_lease_poll(void)
+{
+    const struct flash_dev *dev = fl.dev;
+
+    if (dev == NULL || !fl.pending || dev->busy(dev))
+        return;
+
+    if (fl.erasing) {
+        fl.erasing = 0;
+        fl.next = 0;
+    }
+    if (fl.next + FLASH_LEASE_REC_SIZE > dev->sector_size) {
+        /* the lease is only in RAM until the record is programmed */
+        if (dev->erase(dev, fl.addr, dev->sector_size) != 0) {
+            fl.pending = 0;
+            stats.errors++;
+            return;
+        }
+        fl.erasing = 1;
+        stats.erases++;
+        return;
+    }
+
+    do {
+        fl.pending = 0;
+        fl.out = fl.rec;
+    } while (fl.pending);
+    fl.out.magic = FLASH_LEASE_MAGIC;
+    fl.out.seq = ++fl.seq;
+    fl.out.check = flash_lease_check(&fl.out);
+    if (dev->program(dev, fl.addr + fl.next, (const uint8_t *) &fl.out,
+                     sizeof(fl.out)) != 0) {
+        stats.errors++;
+        return;
+    }
+    fl.next += FLASH_LEASE_REC_SIZE;
+    stats.writes++;
+}
+
+const struct flash_lease_stats *flash_lease_get_stats(void)
+{
+    return &stats;
+}
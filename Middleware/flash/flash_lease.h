@@ -0,0 +1,73 @@
+/**
+ * @file flash_lease.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief DHCP lease kept on the external flash across restarts.
+ *
+ * Implements dhcp_lease_load() and dhcp_lease_store() of dhcp.c
+ * (LWIP_DHCP_LEASE_STORE), so dhcp_start() requests the last lease again
+ * (INIT-REBOOT) instead of discovering a server.
+ *
+ * One sector holds a log of struct flash_lease_record, appended to when the
+ * lease changes and erased only once it is full. The last valid record is
+ * the lease, one with addr 0 means there is none. A record whose program
+ * was cut short fails its check and is skipped. Lease renewals that change
+ * nothing are not written.
+ *
+ * The lease is known from flash_lease_init() on, a new one is kept in RAM
+ * and written by flash_lease_poll() when the flash is not busy, so it
+ * shares the flash with flash_upload.c and flash_fs.c. dhcp_lease_store()
+ * never touches the flash, dhcp.c may call it from the EMAC Rx interrupt.
+ * There is no clock across restarts, the server decides whether the lease
+ * still holds.
+ */
+
+#ifndef FLASH_LEASE_H
+#define FLASH_LEASE_H
+
+#include <stdint.h>
+#include "flash_dev.h"
+
+#define FLASH_LEASE_MAGIC 0x3153454cUL /* "LES1" */
+
+/** Sector of the log, behind the upload regions /upload/fw (1 MiB at 0)
+ *  and /upload/config (64 KiB at 1 MiB) */
+#ifndef FLASH_LEASE_ADDR
+#define FLASH_LEASE_ADDR 0x110000
+#endif
+
+/** One entry of the log, 32 bytes so that a page holds a whole number of
+ *  them. Addresses in network order as in ip4_addr_t. */
+struct flash_lease_record {
+    uint32_t magic;      /* FLASH_LEASE_MAGIC */
+    uint32_t seq;        /* counts up with each write */
+    uint32_t addr;       /* 0 if the lease was dropped */
+    uint32_t netmask;
+    uint32_t gw;
+    uint32_t server;
+    uint32_t lease_time; /* seconds */
+    uint32_t check;      /* ~ sum of the words above */
+};
+
+struct flash_lease_stats {
+    uint32_t writes;  /* records programmed */
+    uint32_t erases;  /* of the full sector */
+    uint32_t skipped; /* stores of the lease already kept */
+    uint32_t errors;  /* erase or program refused */
+};
+
+/**
+ * @brief Read the lease from the log in the sector at addr.
+ * @return 0, -1 if addr is not a sector of the flash
+ */
+int flash_lease_init(const struct flash_dev *dev, uint32_t addr);
+
+/**
+ * @brief Write a changed lease when the flash is ready, call from the main
+ *        loop.
+ */
+void flash_lease_poll(void);
+
+const struct flash_lease_stats *flash_lease_get_stats(void);
+
+#endif /* FLASH_LEASE_H */
@@ -0,0 +1,445 @@
+/**
+ * @file flash_upload.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief httpd POST bodies streamed to the external flash.
+ *
+ * Offsets are relative to the start of the region: received bytes are in the
+ * ring at offset % FLASH_UPLOAD_BUF_SIZE, [programmed, received) is waiting
+ * for the flash and [programmed, erased) is already erased. The window has
+ * been opened for [0, credited), credited <= programmed. A page starts on a
+ * page boundary of the ring, so it is programmed straight from the ring.
+ *
+ * A TFTP write has no length up front, it is taken as the size of the region
+ * until the last block. The ACK of a window is held back while the ring
+ * cannot take another full window.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "flash_upload.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "lwip/sys.h"
+
+#if !LWIP_HTTPD_SUPPORT_POST || !LWIP_HTTPD_POST_MANUAL_WND
+#error "flash_upload.c needs LWIP_HTTPD_SUPPORT_POST and LWIP_HTTPD_POST_MANUAL_WND"
+#endif
+
+/* The peer sends at most TCP_WND beyond what has been credited, credited
+ * bytes are programmed or within the room of the ring beyond that */
+#if FLASH_UPLOAD_BUF_SIZE < 2 * TCP_WND
+#error "FLASH_UPLOAD_BUF_SIZE must hold two TCP windows"
+#endif
+
+/* Most a TFTP client sends per ACK */
+#define FLASH_UPLOAD_TFTP_WINDOW (TFTP_MAX_WINDOWSIZE * TFTP_MAX_BLKSIZE)
+
+#if FLASH_UPLOAD_BUF_SIZE < FLASH_UPLOAD_TFTP_WINDOW
+#error "FLASH_UPLOAD_BUF_SIZE must hold a TFTP window"
+#endif
+
+static struct {
+    const struct flash_dev *dev;
+    const struct flash_upload_region *regions;
+    uint8_t num_regions;
+    uint8_t active;
+    uint8_t tftp;        /* else httpd POST */
+    uint8_t held;        /* TFTP ACK held back, tftp_write_resume() pending */
+    void *conn;          /* NULL once the connection is gone */
+    uint32_t addr;       /* flash address of offset 0 */
+    uint32_t len;        /* Content-Length, size of the TFTP file */
+    uint32_t size;       /* of the region */
+    uint32_t received;
+    uint32_t programmed;
+    uint32_t erased;
+    uint32_t credited;
+    uint32_t prog_len;   /* page being programmed */
+    uint32_t t0;
+} up;
+
+static uint8_t ring[FLASH_UPLOAD_BUF_SIZE];
+static struct flash_upload_stats stats;
+
+/**
+ * @brief Open the window of the connection by len bytes.
+ */
+static void flash_upload_credit(void *conn, uint32_t len)
+{
+    u16_t n;
+
+    up.credited += len;
+    while (len > 0) {
+        n = (u16_t) LWIP_MIN(len, 0xffff);
+        httpd_post_data_recved(conn, n);
+        len -= n;
+    }
+}
+
+/**
+ * @brief Open the window for what the ring can take beyond a full window.
+ *        The last byte waits for the last page, httpd finishes the POST
+ *        once all of it is credited.
+ */
+static void flash_upload_credit_ring(void)
+{
+    uint32_t n = up.programmed + FLASH_UPLOAD_BUF_SIZE - TCP_WND;
+
+    n = LWIP_MIN(n, LWIP_MIN(up.received, up.len - 1));
+    if (n > up.credited)
+        flash_upload_credit(up.conn, n - up.credited);
+}
+
+/**
+ * @brief Stop the upload. The connection only gets the window of what has
+ *        not been credited yet, httpd then finishes the POST. A held TFTP
+ *        ACK is sent, or an error instead.
+ */
+static void flash_upload_end(enum flash_upload_result result)
+{
+    void *conn = up.conn;
+    uint8_t held = up.held;
+
+    up.active = 0;
+    up.held = 0;
+    up.conn = NULL;
+    stats.bytes = up.programmed;
+    stats.ms = sys_now() - up.t0;
+    stats.result = result;
+    if (result == FLASH_UPLOAD_OK) {
+        printf("[INFO]: flash upload %lu bytes in %lu ms, %lu KiB/s\n",
+               (unsigned long) stats.bytes, (unsigned long) stats.ms,
+               (unsigned long) ((uint64_t) stats.bytes * 1000 / 1024 /
+                                (stats.ms ? stats.ms : 1)));
+    } else if (result == FLASH_UPLOAD_ABORTED) {
+        printf("[INFO]: flash upload aborted at %lu bytes\n",
+               (unsigned long) stats.bytes);
+    } else {
+        printf("[ERROR]: flash upload failed at %lu bytes\n",
+               (unsigned long) stats.bytes);
+    }
+    if (conn != NULL)
+        flash_upload_credit(conn, up.received - up.credited);
+    if (held)
+        tftp_write_resume(result == FLASH_UPLOAD_OK ? 0 : -1);
+}
+
+/**
+ * @brief Send the held TFTP ACK once the ring can take another window. The
+ *        last one waits for the last page.
+ */
+static void flash_upload_tftp_resume(void)
+{
+    if (up.held && up.received < up.len &&
+        FLASH_UPLOAD_BUF_SIZE - (up.received - up.programmed) >=
+            FLASH_UPLOAD_TFTP_WINDOW) {
+        up.held = 0;
+        tftp_write_resume(0);
+    }
+}
+
+static const struct flash_upload_region *flash_upload_find(const char *uri)
+{
+    uint8_t i;
+
+    for (i = 0; i < up.num_regions; i++) {
+        if (strcmp(uri, up.regions[i].uri) == 0)
+            return &up.regions[i];
+    }
+    return NULL;
+}
+
+static void flash_upload_start(const struct flash_upload_region *r,
+                               uint32_t len)
+{
+    up.active = 1;
+    up.tftp = 0;
+    up.held = 0;
+    up.conn = NULL;
+    up.addr = r->addr;
+    up.len = len;
+    up.size = r->size;
+    up.received = 0;
+    up.programmed = 0;
+    up.erased = 0;
+    up.credited = 0;
+    up.prog_len = 0;
+    up.t0 = sys_now();
+    stats.bytes = 0;
+    stats.ms = 0;
+    stats.result = FLASH_UPLOAD_RUNNING;
+}
+
+/**
+ * @brief Copy len bytes of p into the ring, at most two pieces around its
+ *        end.
+ */
+static void flash_upload_take(struct pbuf *p, uint32_t len)
+{
+    uint32_t off, n;
+    uint32_t done = 0;
+
+    while (done < len) {
+        off = up.received % FLASH_UPLOAD_BUF_SIZE;
+        n = LWIP_MIN(len - done, FLASH_UPLOAD_BUF_SIZE - off);
+        pbuf_copy_partial(p, &ring[off], (u16_t) n, (u16_t) done);
+        up.received += n;
+        done += n;
+    }
+}
+
+/**
+ * @brief Erase at up.erased, a block if the region has one there and the
+ *        rest of the body covers more than a quarter of it: a block erase
+ *        takes about as long as four sector erases.
+ */
+static int flash_upload_erase(void)
+{
+    const struct flash_dev *dev = up.dev;
+    uint32_t addr = up.addr + up.erased;
+    uint32_t len = dev->sector_size;
+
+    if (dev->block_size && (addr & (dev->block_size - 1)) == 0 &&
+        up.erased + dev->block_size <= up.size &&
+        up.len - up.erased > dev->block_size / 4)
+        len = dev->block_size;
+    if (dev->erase(dev, addr, len))
+        return -1;
+    up.erased += len;
+    return 0;
+}
+
+/*******************************************************************************
+ * httpd POST callbacks
+ ******************************************************************************/
+err_t httpd_post_begin(void *connection, const char *uri,
+                       const char *http_request, u16_t http_request_len,
+                       int content_len, char *response_uri,
+                       u16_t response_uri_len, u8_t *post_auto_wnd)
+{
+    const struct flash_upload_region *r = flash_upload_find(uri);
+
+    LWIP_UNUSED_ARG(http_request);
+    LWIP_UNUSED_ARG(http_request_len);
+    LWIP_UNUSED_ARG(response_uri);
+    LWIP_UNUSED_ARG(response_uri_len);
+
+    /* one upload at a time */
+    if (r == NULL || up.active || (uint32_t) content_len > r->size)
+        return ERR_VAL;
+
+    flash_upload_start(r, (uint32_t) content_len);
+    up.conn = connection;
+    *post_auto_wnd = 0;
+    return ERR_OK;
+}
+
+err_t httpd_post_receive_data(void *connection, struct pbuf *p)
+{
+    uint32_t len;
+
+    if (!up.active || connection != up.conn ||
+        up.received + p->tot_len - up.programmed > FLASH_UPLOAD_BUF_SIZE) {
+        if (up.active && connection == up.conn)
+            flash_upload_end(FLASH_UPLOAD_ABORTED);
+        httpd_post_data_recved(connection, p->tot_len);
+        pbuf_free(p);
+        return ERR_VAL;
+    }
+
+    /* a request pipelined behind the body is dropped, it only gets the
+       window back */
+    len = LWIP_MIN(p->tot_len, up.len - up.received);
+    flash_upload_take(p, len);
+    if (p->tot_len > len)
+        httpd_post_data_recved(connection, (u16_t) (p->tot_len - len));
+    pbuf_free(p);
+    flash_upload_poll();
+    if (up.active)
+        flash_upload_credit_ring();
+    return ERR_OK;
+}
+
+void httpd_post_finished(void *connection, char *response_uri,
+                         u16_t response_uri_len)
+{
+    if (up.active && connection == up.conn) {
+        /* before the last page was programmed: connection closed, or
+           nothing to program */
+        up.conn = NULL;
+        flash_upload_end(up.programmed == up.len ? FLASH_UPLOAD_OK
+                                                 : FLASH_UPLOAD_ABORTED);
+    }
+    snprintf(response_uri, response_uri_len, "%s", FLASH_UPLOAD_RESULT_URI);
+}
+
+/*******************************************************************************
+ * tftp_server.c
+ ******************************************************************************/
+static void *flash_upload_tftp_open(const char *fname, const char *mode,
+                                    u8_t write)
+{
+    char uri[TFTP_MAX_FILENAME_LEN + 2];
+    const struct flash_upload_region *r;
+
+    LWIP_UNUSED_ARG(mode);
+
+    /* TFTP names come without the leading '/' of the URIs */
+    if (fname[0] != '/') {
+        snprintf(uri, sizeof(uri), "/%s", fname);
+        fname = uri;
+    }
+    r = flash_upload_find(fname);
+    if (!write || r == NULL || up.active)
+        return NULL;
+
+    flash_upload_start(r, r->size);
+    up.tftp = 1;
+    return &up;
+}
+
+static void flash_upload_tftp_close(void *handle)
+{
+    LWIP_UNUSED_ARG(handle);
+
+    /* before the last page was programmed: timeout or error */
+    if (up.active && up.tftp) {
+        up.held = 0;
+        flash_upload_end(FLASH_UPLOAD_ABORTED);
+    }
+}
+
+static int flash_upload_tftp_read(void *handle, void *buf, int bytes)
+{
+    LWIP_UNUSED_ARG(handle);
+    LWIP_UNUSED_ARG(buf);
+    LWIP_UNUSED_ARG(bytes);
+    return -1;
+}
+
+static int flash_upload_tftp_write(void *handle, struct pbuf *p)
+{
+    LWIP_UNUSED_ARG(handle);
+
+    /* the server goes by what this write returns */
+    up.held = 0;
+    /* the region is full, or the flash failed */
+    if (!up.active || !up.tftp)
+        return p == NULL && stats.result == FLASH_UPLOAD_OK ? 0 : -1;
+
+    if (p == NULL) {
+        /* the last ACK waits for the last page */
+        up.len = up.received;
+        if (up.programmed == up.len && up.prog_len == 0)
+            flash_upload_end(FLASH_UPLOAD_OK);
+        else
+            flash_upload_poll();
+    } else if (up.received + p->tot_len > up.len ||
+               up.received + p->tot_len - up.programmed >
+                   FLASH_UPLOAD_BUF_SIZE) {
+        flash_upload_end(FLASH_UPLOAD_ABORTED);
+        return -1;
+    } else {
+        flash_upload_take(p, p->tot_len);
+        flash_upload_poll();
+    }
+    if (!up.active)
+        return stats.result == FLASH_UPLOAD_OK ? 0 : -1;
+
+    if (p == NULL || FLASH_UPLOAD_BUF_SIZE - (up.received - up.programmed) <
+                         FLASH_UPLOAD_TFTP_WINDOW) {
+        up.held = 1;
+        return TFTP_WRITE_WAIT;
+    }
+    return 0;
+}
+
+const struct tftp_context flash_upload_tftp = {
+    flash_upload_tftp_open,
+    flash_upload_tftp_close,
+    flash_upload_tftp_read,
+    flash_upload_tftp_write,
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int flash_upload_init(const struct flash_dev *dev,
+                      const struct flash_upload_region *regions,
+                      uint8_t num_regions)
+{
+    uint8_t i;
+
+    if (FLASH_UPLOAD_BUF_SIZE % dev->page_size)
+        return -1;
+    for (i = 0; i < num_regions; i++) {
+        if ((regions[i].addr | regions[i].size) & (dev->sector_size - 1) ||
+            regions[i].addr + regions[i].size > dev->size)
+            return -1;
+    }
+    up.dev = dev;
+    up.regions = regions;
+    up.num_regions = num_regions;
+    return 0;
+}
+
+void flash_upload_poll(void)
+{
+    const struct flash_dev *dev = up.dev;
+    uint32_t page;
+
+    if (!up.active || dev->busy(dev))
+        return;
+
+    if (up.prog_len) {
+        up.programmed += up.prog_len;
+        if (up.programmed == up.len) {
+            /* the last credit lets httpd finish the POST */
+            flash_upload_end(FLASH_UPLOAD_OK);
+            return;
+        }
+        up.prog_len = 0;
+        if (up.tftp)
+            flash_upload_tftp_resume();
+        else
+            flash_upload_credit_ring();
+    }
+
+    page = LWIP_MIN(dev->page_size, up.len - up.programmed);
+    if (page == 0)
+        return;
+    if (up.programmed + page > up.erased) {
+        if (flash_upload_erase())
+            flash_upload_end(FLASH_UPLOAD_EFLASH);
+    } else if (up.received - up.programmed >= page) {
+        if (dev->program(dev, up.addr + up.programmed,
+                         &ring[up.programmed % FLASH_UPLOAD_BUF_SIZE], page))
+            flash_upload_end(FLASH_UPLOAD_EFLASH);
+        else
+            up.prog_len = page;
+    } else if (up.received == up.programmed && up.erased < up.len) {
+        /* waiting for data, erase ahead */
+        if (flash_upload_erase())
+            flash_upload_end(FLASH_UPLOAD_EFLASH);
+    }
+}
+
+const struct flash_upload_stats *flash_upload_get_stats(void)
+{
+    return &stats;
+}
+
+err_t flash_upload_json(int index, char *buf, u16_t *len, u32_t *state)
+{
+    static const char *const result[] = {"none", "running", "ok", "aborted",
+                                         "flash error"};
+
+    LWIP_UNUSED_ARG(index);
+    LWIP_UNUSED_ARG(state);
+    *len = (u16_t) snprintf(buf, *len,
+                            "{\"result\":\"%s\",\"bytes\":%lu,\"ms\":%lu}",
+                            result[stats.result], (unsigned long) stats.bytes,
+                            (unsigned long) stats.ms);
+    return ERR_OK;
+}
@@ -0,0 +1,97 @@
+/**
+ * @file flash_upload.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief httpd POST bodies streamed to the external flash.
+ *
+ * Implements the httpd_post_*() callbacks (LWIP_HTTPD_SUPPORT_POST). The
+ * body is gathered into a ring of flash pages, each page is programmed as
+ * soon as it is complete while the next ones are received. The TCP window
+ * is only opened as far as programming frees the ring
+ * (LWIP_HTTPD_POST_MANUAL_WND), so the ring never overflows and a client
+ * cannot send faster than the flash writes. Sectors are erased ahead while
+ * waiting for data.
+ *
+ *  POST /upload/fw HTTP/1.1
+ *  Content-Length: 262144
+ *
+ * answers with FLASH_UPLOAD_RESULT_URI, which the application registers
+ * as a dynamic handler (flash_upload_json()).
+ *
+ * tftp_server.c writes the same regions with flash_upload_tftp, the file
+ * name is the URI without the leading '/':
+ *
+ *  tftp -m binary 192.168.0.23 -c put fw.bin upload/fw
+ *
+ * The ACK of a TFTP window is held back until the ring can take the next
+ * one, the last one until the last page is programmed.
+ */
+
+#ifndef FLASH_UPLOAD_H
+#define FLASH_UPLOAD_H
+
+#include <stdint.h>
+#include "flash_dev.h"
+#include "lwip/apps/httpd.h"
+
+/** Bytes received but not programmed yet, a multiple of the page size and
+ *  at least two TCP windows */
+#ifndef FLASH_UPLOAD_BUF_SIZE
+#define FLASH_UPLOAD_BUF_SIZE 8192
+#endif
+
+/** Response of every upload, the result of the last one */
+#define FLASH_UPLOAD_RESULT_URI "/upload.json"
+
+enum flash_upload_result {
+    FLASH_UPLOAD_NONE,    /* nothing uploaded since boot */
+    FLASH_UPLOAD_RUNNING,
+    FLASH_UPLOAD_OK,
+    FLASH_UPLOAD_ABORTED, /* connection closed before the end of the body */
+    FLASH_UPLOAD_EFLASH   /* erase or program refused */
+};
+
+/** Where the body of a POST to uri goes, addr and size sector aligned */
+struct flash_upload_region {
+    const char *uri;
+    uint32_t addr;
+    uint32_t size;
+};
+
+struct flash_upload_stats {
+    uint32_t bytes; /* programmed */
+    uint32_t ms;    /* from httpd_post_begin() to the last page programmed */
+    enum flash_upload_result result;
+};
+
+/**
+ * @brief Accept uploads to the regions of a flash device.
+ * @return 0, -1 if a region is not sector aligned or outside of the flash
+ */
+int flash_upload_init(const struct flash_dev *dev,
+                      const struct flash_upload_region *regions,
+                      uint8_t num_regions);
+
+/**
+ * @brief Start the next erase or program when the flash is ready, call from
+ *        the main loop.
+ */
+void flash_upload_poll(void);
+
+const struct flash_upload_stats *flash_upload_get_stats(void);
+
+/**
+ * @brief tDynHandler writing the stats of the last upload as JSON, to be
+ *        registered for FLASH_UPLOAD_RESULT_URI.
+ */
+err_t flash_upload_json(int index, char *buf, u16_t *len, u32_t *state);
+
+/*******************************************************************************
+ * tftp_server.c
+ ******************************************************************************/
+struct tftp_context;
+
+/** Write-only context for tftp_init(), shares the one upload at a time */
+extern const struct tftp_context flash_upload_tftp;
+
+#endif /* FLASH_UPLOAD_H */
@@ -0,0 +1,241 @@
+/**
+ * @file flash_w25q.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief w25q128jv 16 MiB NOR flash on SPI2, SS driven by software.
+ *
+ * Page program 0.4 ms, 4 KiB sector erase 45 ms, 64 KiB block erase 150 ms
+ * (typical, datasheet). Nothing here waits for those, the caller polls
+ * busy() and keeps the network running meanwhile.
+ *
+ * read_start() clocks the data phase of a fast read by PDMA, channel
+ * W25Q_PDMA_TX feeding dummy bytes to SPI2 and W25Q_PDMA_RX moving what
+ * comes back to the buffer. busy() ends the transfer once both are done.
+ */
+
+#include "flash_dev.h"
+#include "NuMicro.h"
+
+#define W25Q_WRITE_ENABLE   0x06
+#define W25Q_READ_STATUS1   0x05
+#define W25Q_PAGE_PROGRAM   0x02
+#define W25Q_SECTOR_ERASE   0x20
+#define W25Q_BLOCK_ERASE    0xD8
+#define W25Q_FAST_READ      0x0B
+#define W25Q_JEDEC_ID       0x9F
+
+#define W25Q_STATUS_BUSY    0x01
+
+/** Manufacturer Winbond, memory type SPI, capacity 128 Mbit */
+#define W25Q128JV_ID        0xEF4018UL
+
+/** Bytes in flight, half of the 16 byte FIFOs of SPI2 at 8 bit */
+#define W25Q_FIFO_DEPTH     8
+
+/** PDMA channels of read_start(), and the most bytes of one transfer */
+#define W25Q_PDMA_RX        0
+#define W25Q_PDMA_TX        1
+#define W25Q_PDMA_MASK      ((1UL << W25Q_PDMA_RX) | (1UL << W25Q_PDMA_TX))
+#define W25Q_PDMA_MAX       65536UL
+
+/* The source of the TX channel, in SRAM */
+static uint8_t w25q_dummy = 0xFF;
+static volatile uint8_t w25q_dma;
+
+/**
+ * @brief Clock out tx (0xFF if NULL) and keep the bytes clocked in to rx
+ *        (dropped if NULL), SS already low.
+ */
+static void w25q_xfer(const uint8_t *tx, uint8_t *rx, uint32_t len)
+{
+    uint32_t sent = 0, recv = 0;
+    uint8_t b;
+
+    while (recv < len) {
+        if (sent < len && sent - recv < W25Q_FIFO_DEPTH) {
+            SPI_WRITE_TX(SPI2, tx ? tx[sent] : 0xFF);
+            sent++;
+        }
+        if (!SPI_GET_RX_FIFO_EMPTY_FLAG(SPI2)) {
+            b = (uint8_t) SPI_READ_RX(SPI2);
+            if (rx)
+                rx[recv] = b;
+            recv++;
+        }
+    }
+    while (SPI_IS_BUSY(SPI2))
+        ;
+}
+
+/**
+ * @brief Command with a 24 bit address, SS left low for the data phase.
+ */
+static void w25q_cmd_addr(uint8_t cmd, uint32_t addr)
+{
+    uint8_t hdr[4];
+
+    hdr[0] = cmd;
+    hdr[1] = (uint8_t)(addr >> 16);
+    hdr[2] = (uint8_t)(addr >> 8);
+    hdr[3] = (uint8_t) addr;
+    SPI_SET_SS_LOW(SPI2);
+    w25q_xfer(hdr, NULL, sizeof(hdr));
+}
+
+static void w25q_write_enable(void)
+{
+    uint8_t cmd = W25Q_WRITE_ENABLE;
+
+    SPI_SET_SS_LOW(SPI2);
+    w25q_xfer(&cmd, NULL, 1);
+    SPI_SET_SS_HIGH(SPI2);
+}
+
+static uint8_t w25q_status(void)
+{
+    uint8_t buf[2] = {W25Q_READ_STATUS1, 0xFF};
+
+    SPI_SET_SS_LOW(SPI2);
+    w25q_xfer(buf, buf, sizeof(buf));
+    SPI_SET_SS_HIGH(SPI2);
+    return buf[1];
+}
+
+/**
+ * @brief Whether the read of read_start() is still running, SS raised and
+ *        SPI2 back to the CPU once it is done.
+ */
+static int w25q_dma_busy(void)
+{
+    if (!w25q_dma)
+        return 0;
+    if ((PDMA_GET_TD_STS(PDMA) & W25Q_PDMA_MASK) != W25Q_PDMA_MASK)
+        return 1;
+    PDMA_CLR_TD_FLAG(PDMA, W25Q_PDMA_MASK);
+    while (SPI_IS_BUSY(SPI2))
+        ;
+    SPI_DISABLE_TX_RX_PDMA(SPI2);
+    SPI_SET_SS_HIGH(SPI2);
+    w25q_dma = 0;
+    return 0;
+}
+
+/*******************************************************************************
+ * flash_dev operations
+ ******************************************************************************/
+static int w25q_busy(const struct flash_dev *dev)
+{
+    (void) dev;
+    if (w25q_dma_busy())
+        return 1;
+    return (w25q_status() & W25Q_STATUS_BUSY) != 0;
+}
+
+static int w25q_erase(const struct flash_dev *dev, uint32_t addr,
+                      uint32_t len)
+{
+    uint8_t cmd;
+
+    if (len == dev->sector_size)
+        cmd = W25Q_SECTOR_ERASE;
+    else if (len == dev->block_size)
+        cmd = W25Q_BLOCK_ERASE;
+    else
+        return -1;
+    if ((addr & (len - 1)) || addr + len > dev->size || w25q_busy(dev))
+        return -1;
+
+    w25q_write_enable();
+    w25q_cmd_addr(cmd, addr);
+    SPI_SET_SS_HIGH(SPI2);
+    return 0;
+}
+
+static int w25q_program(const struct flash_dev *dev, uint32_t addr,
+                        const uint8_t *data, uint32_t len)
+{
+    uint32_t offset = addr & (dev->page_size - 1);
+
+    if (len == 0 || offset + len > dev->page_size ||
+        addr + len > dev->size || w25q_busy(dev))
+        return -1;
+
+    w25q_write_enable();
+    w25q_cmd_addr(W25Q_PAGE_PROGRAM, addr);
+    w25q_xfer(data, NULL, len);
+    SPI_SET_SS_HIGH(SPI2);
+    return 0;
+}
+
+static int w25q_read(const struct flash_dev *dev, uint32_t addr,
+                     uint8_t *buf, uint32_t len)
+{
+    uint8_t dummy = 0xFF;
+
+    if (addr + len > dev->size)
+        return -1;
+    while (w25q_busy(dev))
+        ;
+
+    w25q_cmd_addr(W25Q_FAST_READ, addr);
+    w25q_xfer(&dummy, NULL, 1);
+    w25q_xfer(NULL, buf, len);
+    SPI_SET_SS_HIGH(SPI2);
+    return 0;
+}
+
+static int w25q_read_start(const struct flash_dev *dev, uint32_t addr,
+                           uint8_t *buf, uint32_t len)
+{
+    if (len == 0 || len > W25Q_PDMA_MAX || addr + len > dev->size ||
+        w25q_busy(dev))
+        return -1;
+
+    w25q_cmd_addr(W25Q_FAST_READ, addr);
+    w25q_xfer(&w25q_dummy, NULL, 1);
+
+    PDMA_CLR_TD_FLAG(PDMA, W25Q_PDMA_MASK);
+    PDMA_SetTransferCnt(PDMA, W25Q_PDMA_RX, PDMA_WIDTH_8, len);
+    PDMA_SetTransferAddr(PDMA, W25Q_PDMA_RX, (uint32_t) &SPI2->RX,
+                         PDMA_SAR_FIX, (uint32_t) buf, PDMA_DAR_INC);
+    PDMA_SetTransferMode(PDMA, W25Q_PDMA_RX, PDMA_SPI2_RX, FALSE, 0);
+    PDMA_SetBurstType(PDMA, W25Q_PDMA_RX, PDMA_REQ_SINGLE, 0);
+    PDMA_SetTransferCnt(PDMA, W25Q_PDMA_TX, PDMA_WIDTH_8, len);
+    PDMA_SetTransferAddr(PDMA, W25Q_PDMA_TX, (uint32_t) &w25q_dummy,
+                         PDMA_SAR_FIX, (uint32_t) &SPI2->TX, PDMA_DAR_FIX);
+    PDMA_SetTransferMode(PDMA, W25Q_PDMA_TX, PDMA_SPI2_TX, FALSE, 0);
+    PDMA_SetBurstType(PDMA, W25Q_PDMA_TX, PDMA_REQ_SINGLE, 0);
+
+    w25q_dma = 1;
+    SPI_TRIGGER_TX_RX_PDMA(SPI2);
+    return 0;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+const struct flash_dev flash_w25q = {
+    .size        = 16UL * 1024 * 1024,
+    .page_size   = 256,
+    .sector_size = 4096,
+    .block_size  = 65536,
+    .erase       = w25q_erase,
+    .program     = w25q_program,
+    .busy        = w25q_busy,
+    .read        = w25q_read,
+    .read_start  = w25q_read_start,
+};
+
+int flash_w25q_init(void)
+{
+    uint8_t buf[4] = {W25Q_JEDEC_ID, 0xFF, 0xFF, 0xFF};
+    uint32_t id;
+
+    PDMA_Open(PDMA, W25Q_PDMA_MASK);
+    SPI_SET_SS_LOW(SPI2);
+    w25q_xfer(buf, buf, sizeof(buf));
+    SPI_SET_SS_HIGH(SPI2);
+
+    id = ((uint32_t) buf[1] << 16) | ((uint32_t) buf[2] << 8) | buf[3];
+    return id == W25Q128JV_ID ? 0 : -1;
+}
@@ -0,0 +1,306 @@
+/**
+ * @file mkflashfs.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host tool - build a flash_fs image of a directory.
+ *
+ *   mkflashfs [-gz] <dir> <image>
+ *
+ * Every file gets the HTTP/1.1 header makefsdata -11 would generate, 404*,
+ * 400* and 501* files their status. With -gz a gzip variant "<name>.gz" is
+ * added next to each file it makes smaller, as makefsdata -gz does, except
+ * for images that are compressed already. Built with the firmware
+ * lwipopts.h for HTTPD_SERVER_AGENT, linked with zlib.
+ */
+
+#include <dirent.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#include "flash_fs.h"
+
+/* the header strings of httpd */
+#define LWIP_HTTPD_DYNAMIC_HEADERS 1
+#include "lwip/def.h"
+#include "lwip/init.h"
+#include "httpd_structs.h"
+#include "lwip/apps/fs.h"
+
+#define MAX_FILES 1024
+
+struct file {
+    char name[FLASH_FS_NAME_MAX];
+    uint8_t *data;
+    uint32_t len;
+    uint8_t flags;
+    int gzip;               /* the variant, data is gzip */
+    uint32_t hash;
+    char hdr[512];
+    uint32_t hdr_len;
+};
+
+static struct file files[MAX_FILES];
+static uint32_t num_files;
+static int gzip_variants;
+
+static const char *const precompressed[] = {"gif", "png", "jpg", "ico", "gz"};
+
+static void die(const char *msg, const char *arg)
+{
+    fprintf(stderr, "mkflashfs: %s %s\n", msg, arg);
+    exit(1);
+}
+
+static const char *extension(const char *name)
+{
+    const char *dot = strrchr(name, '.');
+
+    return dot != NULL && strchr(dot, '/') == NULL ? dot + 1 : "";
+}
+
+static uint8_t *read_file(const char *path, uint32_t *len)
+{
+    FILE *f = fopen(path, "rb");
+    uint8_t *buf;
+    long n;
+
+    if (f == NULL || fseek(f, 0, SEEK_END) || (n = ftell(f)) < 0 ||
+        fseek(f, 0, SEEK_SET))
+        die("cannot read", path);
+    buf = malloc(n ? n : 1);
+    if (buf == NULL || fread(buf, 1, n, f) != (size_t) n)
+        die("cannot read", path);
+    fclose(f);
+    *len = (uint32_t) n;
+    return buf;
+}
+
+/* gzip with mtime 0 so that images are reproducible, NULL if not smaller */
+static uint8_t *gzip(const uint8_t *data, uint32_t len, uint32_t *gz_len)
+{
+    z_stream strm;
+    uint8_t *buf;
+
+    memset(&strm, 0, sizeof(strm));
+    if (deflateInit2(&strm, 9, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY))
+        die("deflateInit2", "failed");
+    buf = malloc(deflateBound(&strm, len));
+    if (buf == NULL)
+        die("out of memory", "");
+    strm.next_in = (Bytef *) data;
+    strm.avail_in = len;
+    strm.next_out = buf;
+    strm.avail_out = deflateBound(&strm, len);
+    if (deflate(&strm, Z_FINISH) != Z_STREAM_END)
+        die("deflate", "failed");
+    *gz_len = (uint32_t) strm.total_out;
+    deflateEnd(&strm);
+    if (*gz_len >= len) {
+        free(buf);
+        return NULL;
+    }
+    return buf;
+}
+
+static struct file *add(const char *name, uint8_t *data, uint32_t len)
+{
+    struct file *f;
+
+    if (num_files == MAX_FILES)
+        die("more than 1024 files in", name);
+    if (strlen(name) >= FLASH_FS_NAME_MAX)
+        die("name too long:", name);
+    f = &files[num_files++];
+    snprintf(f->name, sizeof(f->name), "%s", name);
+    f->data = data;
+    f->len = len;
+    f->flags = FS_FILE_FLAGS_HEADER_INCLUDED |
+               FS_FILE_FLAGS_HEADER_PERSISTENT |
+               FS_FILE_FLAGS_HEADER_HTTPVER_1_1;
+    return f;
+}
+
+static void add_file(const char *path, const char *name)
+{
+    char gz_name[FLASH_FS_NAME_MAX + 3];
+    const char *ext = extension(name);
+    uint32_t len, gz_len, i;
+    uint8_t *data = read_file(path, &len), *gz = NULL;
+    struct file *f;
+
+    if (gzip_variants) {
+        for (i = 0; i < sizeof(precompressed) / sizeof(precompressed[0]); i++)
+            if (strcmp(ext, precompressed[i]) == 0)
+                break;
+        if (i == sizeof(precompressed) / sizeof(precompressed[0]))
+            gz = gzip(data, len, &gz_len);
+    }
+    f = add(name, data, len);
+    if (gz != NULL) {
+        f->flags |= FS_FILE_FLAGS_HAS_GZIP;
+        if (snprintf(gz_name, sizeof(gz_name), "%s.gz", name) >=
+            (int) sizeof(gz_name))
+            die("name too long:", name);
+        add(gz_name, gz, gz_len)->gzip = 1;
+    }
+}
+
+static void add_dir(const char *path, const char *name)
+{
+    char sub_path[4096], sub_name[FLASH_FS_NAME_MAX * 2];
+    struct dirent *d;
+    struct stat s;
+    DIR *dir = opendir(path);
+
+    if (dir == NULL)
+        die("cannot open", path);
+    while ((d = readdir(dir)) != NULL) {
+        if (d->d_name[0] == '.')
+            continue;
+        if (snprintf(sub_path, sizeof(sub_path), "%s/%s", path,
+                     d->d_name) >= (int) sizeof(sub_path) ||
+            snprintf(sub_name, sizeof(sub_name), "%s/%s", name,
+                     d->d_name) >= (int) sizeof(sub_name))
+            die("name too long:", d->d_name);
+        if (stat(sub_path, &s))
+            die("cannot stat", sub_path);
+        if (S_ISDIR(s.st_mode))
+            add_dir(sub_path, sub_name);
+        else if (S_ISREG(s.st_mode))
+            add_file(sub_path, sub_name);
+    }
+    closedir(dir);
+}
+
+/* The header of makefsdata -11, the gzip variant with the content type of
+   the original */
+static void http_header(struct file *f)
+{
+    const char *base = strrchr(f->name, '/') + 1;
+    const char *type = HTTP_HDR_DEFAULT_TYPE, *ext;
+    char name[FLASH_FS_NAME_MAX];
+    int status = HTTP_HDR_OK_11, n;
+    size_t i;
+
+    memcpy(name, f->name, sizeof(name));
+    if (f->gzip)
+        name[strlen(name) - 3] = '\0';
+    ext = extension(name);
+    if (strncmp(base, "404", 3) == 0)
+        status = HTTP_HDR_NOT_FOUND_11;
+    else if (strncmp(base, "400", 3) == 0)
+        status = HTTP_HDR_BAD_REQUEST_11;
+    else if (strncmp(base, "501", 3) == 0)
+        status = HTTP_HDR_NOT_IMPL_11;
+    for (i = 0; i < NUM_HTTP_HEADERS; i++) {
+        if (strcmp(ext, g_psHTTPHeaders[i].extension) == 0) {
+            type = g_psHTTPHeaders[i].content_type;
+            break;
+        }
+    }
+
+    n = snprintf(f->hdr, sizeof(f->hdr), "%s%s%s%lu\r\n%s%s%s%s",
+                 g_psHTTPHeaderStrings[status],
+                 g_psHTTPHeaderStrings[HTTP_HDR_SERVER],
+                 g_psHTTPHeaderStrings[HTTP_HDR_CONTENT_LENGTH],
+                 (unsigned long) f->len,
+                 g_psHTTPHeaderStrings[HTTP_HDR_CONN_KEEPALIVE],
+                 f->gzip ? "Content-Encoding: gzip\r\n" : "",
+                 f->gzip || (f->flags & FS_FILE_FLAGS_HAS_GZIP)
+                     ? "Vary: Accept-Encoding\r\n"
+                     : "",
+                 type);
+    if (n < 0 || (size_t) n >= sizeof(f->hdr))
+        die("header too long for", f->name);
+    f->hdr_len = (uint32_t) n;
+}
+
+static int by_hash(const void *a, const void *b)
+{
+    const struct file *fa = a, *fb = b;
+
+    if (fa->hash != fb->hash)
+        return fa->hash < fb->hash ? -1 : 1;
+    return strcmp(fa->name, fb->name);
+}
+
+static uint32_t align(uint32_t n, uint32_t to)
+{
+    return (n + to - 1) / to * to;
+}
+
+int main(int argc, char *argv[])
+{
+    struct flash_fs_header hdr;
+    struct flash_fs_entry e;
+    uint32_t i, names, blobs, off, size, magic = FLASH_FS_MAGIC;
+    uint8_t *img;
+    const char *c;
+    FILE *out;
+
+    if (argc == 4 && strcmp(argv[1], "-gz") == 0) {
+        gzip_variants = 1;
+        argv++;
+        argc--;
+    }
+    if (argc != 3) {
+        fprintf(stderr, "usage: mkflashfs [-gz] <dir> <image>\n");
+        return 1;
+    }
+    add_dir(argv[1], "");
+    if (num_files == 0)
+        die("no files in", argv[1]);
+
+    for (i = 0; i < num_files; i++) {
+        files[i].hash = FLASH_FS_HASH_INIT;
+        for (c = files[i].name; *c; c++)
+            files[i].hash = FLASH_FS_HASH_STEP(files[i].hash, *c);
+        http_header(&files[i]);
+    }
+    qsort(files, num_files, sizeof(files[0]), by_hash);
+
+    /* header, index, names, then the blobs aligned */
+    names = sizeof(hdr) + num_files * sizeof(e);
+    blobs = names;
+    for (i = 0; i < num_files; i++)
+        blobs += strlen(files[i].name) + 1;
+    size = blobs = align(blobs, FLASH_FS_ALIGN);
+    for (i = 0; i < num_files; i++)
+        size = align(size + files[i].hdr_len + files[i].len, FLASH_FS_ALIGN);
+    size += sizeof(magic);
+
+    img = calloc(1, size);
+    if (img == NULL)
+        die("out of memory", "");
+    hdr.magic = FLASH_FS_MAGIC;
+    hdr.size = size;
+    hdr.num_files = (uint16_t) num_files;
+    hdr.reserved = 0;
+    hdr.names = names;
+    memcpy(img, &hdr, sizeof(hdr));
+    for (i = 0, off = blobs; i < num_files; i++) {
+        memset(&e, 0, sizeof(e));
+        e.hash = files[i].hash;
+        e.name = names;
+        e.offset = off;
+        e.len = files[i].hdr_len + files[i].len;
+        e.hdr_len = (uint16_t) files[i].hdr_len;
+        e.flags = files[i].flags;
+        memcpy(&img[sizeof(hdr) + i * sizeof(e)], &e, sizeof(e));
+        memcpy(&img[names], files[i].name, strlen(files[i].name) + 1);
+        names += strlen(files[i].name) + 1;
+        memcpy(&img[off], files[i].hdr, files[i].hdr_len);
+        memcpy(&img[off + files[i].hdr_len], files[i].data, files[i].len);
+        off = align(off + e.len, FLASH_FS_ALIGN);
+    }
+    memcpy(&img[size - sizeof(magic)], &magic, sizeof(magic));
+
+    out = fopen(argv[2], "wb");
+    if (out == NULL || fwrite(img, 1, size, out) != size || fclose(out))
+        die("cannot write", argv[2]);
+    printf("%s: %u files, %u bytes\n", argv[2], num_files, size);
+    return 0;
+}
@@ -33,6 +33,7 @@
 LWIPARCH?=$(CONTRIBDIR)/ports/unix/port
 SYSARCH?=$(LWIPARCH)/sys_arch.c
 ARCHFILES=$(LWIPARCH)/perf.c \
+  $(CONTRIBDIR)/../perf/perf_stats.c \
   $(SYSARCH) \
 	$(LWIPARCH)/netif/tapif.c \
 	$(LWIPARCH)/netif/list.c \
@@ -43,6 +44,7 @@ UNIX_COMMON_MK_DIR := $(dir $(abspath $(lastword $(MAKEFILE_LIST))))
 include $(UNIX_COMMON_MK_DIR)../Common.allports.mk
 
 LDFLAGS+=-lutil
+CFLAGS+=-I$(CONTRIBDIR)/../perf
 
 UNAME_S:= $(shell uname -s)
 ifneq ($(UNAME_S),Darwin)
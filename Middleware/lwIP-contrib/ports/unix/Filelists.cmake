@@ -11,6 +11,7 @@
 set(lwipcontribportunix_SRCS
     ${LWIP_CONTRIB_DIR}/ports/unix/port/sys_arch.c
     ${LWIP_CONTRIB_DIR}/ports/unix/port/perf.c
+    ${LWIP_CONTRIB_DIR}/../perf/perf_stats.c
 )
 
 set(lwipcontribportunixnetifs_SRCS
@@ -22,6 +23,7 @@ set(lwipcontribportunixnetifs_SRCS
 
 add_library(lwipcontribportunix EXCLUDE_FROM_ALL ${lwipcontribportunix_SRCS} ${lwipcontribportunixnetifs_SRCS})
 target_include_directories(lwipcontribportunix PRIVATE ${LWIP_INCLUDE_DIRS} ${LWIP_MBEDTLS_INCLUDE_DIRS})
+target_include_directories(lwipcontribportunix PUBLIC ${LWIP_CONTRIB_DIR}/../perf)
 target_compile_options(lwipcontribportunix PRIVATE ${LWIP_COMPILER_FLAGS})
 target_compile_definitions(lwipcontribportunix PRIVATE ${LWIP_DEFINITIONS} ${LWIP_MBEDTLS_DEFINITIONS})
 target_link_libraries(lwipcontribportunix PUBLIC ${LWIP_MBEDTLS_LINK_LIBRARIES})
@@ -32,32 +32,46 @@
 #ifndef LWIP_ARCH_PERF_H
 #define LWIP_ARCH_PERF_H
 
-#include <sys/times.h>
+#include <stdio.h>
+#include <stdint.h>
+#include <time.h>
 
-#ifdef PERF
-#define PERF_START  { \
-                         unsigned long __c1l, __c1h, __c2l, __c2h; \
-                         __asm__(".byte 0x0f, 0x31" : "=a" (__c1l), "=d" (__c1h))
-#define PERF_STOP(x)   __asm__(".byte 0x0f, 0x31" : "=a" (__c2l), "=d" (__c2h)); \
-                       perf_print(__c1l, __c1h, __c2l, __c2h, x);}
+#include "perf_stats.h"
 
-/*#define PERF_START do { \
-                     struct tms __perf_start, __perf_end; \
-                     times(&__perf_start)
-#define PERF_STOP(x) times(&__perf_end); \
-                     perf_print_times(&__perf_start, &__perf_end, x);\
-                     } while(0)*/
-#else /* PERF */
+/* Monotonic clock in ns, truncated to 32 bit like a cycle counter. Only the
+   difference of two readings is used. */
+static inline uint32_t
+perf_cycles(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+}
+#define PERF_CYCLES() perf_cycles()
+
+#if LWIP_PERF
+/* ns between PERF_START and PERF_STOP go to perf_stats, the point is looked
+   up once per call site. */
+#define PERF_START  uint32_t perf_start_cycles = PERF_CYCLES()
+#define PERF_STOP(x) do { \
+                       static struct perf_point *perf_pt; \
+                       uint32_t perf_delta = PERF_CYCLES() - perf_start_cycles; \
+                       if (perf_pt == NULL) { \
+                         perf_pt = perf_point_get(x); \
+                       } \
+                       if (perf_pt != NULL) { \
+                         perf_hist_add(&perf_pt->hist, perf_delta); \
+                       } \
+                     } while(0)
+#else /* LWIP_PERF */
 #define PERF_START    /* null definition */
 #define PERF_STOP(x)  /* null definition */
-#endif /* PERF */
-
-void perf_print(unsigned long c1l, unsigned long c1h,
-		unsigned long c2l, unsigned long c2h,
-		char *key);
+#endif /* LWIP_PERF */
 
-void perf_print_times(struct tms *start, struct tms *end, char *key);
+/** Set the file perf_print_stats() writes to, NULL for stdout. */
+void perf_init(const char *fname);
 
-void perf_init(char *fname);
+/** Print all PERF_STOP() points in us and clear them. */
+void perf_print_stats(void);
 
 #endif /* LWIP_ARCH_PERF_H */
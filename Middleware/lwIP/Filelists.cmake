@@ -169,6 +169,8 @@ set(lwiphttp_SRCS
     ${LWIP_DIR}/src/apps/http/fs.c
     ${LWIP_DIR}/src/apps/http/http_client.c
     ${LWIP_DIR}/src/apps/http/httpd.c
+    ${LWIP_DIR}/src/apps/http/httpd_parser.c
+    ${LWIP_DIR}/src/apps/http/httpd_ws.c
 )
 
 # MAKEFSDATA HTTP server host utility
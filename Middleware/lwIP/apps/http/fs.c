@@ -70,22 +70,45 @@ fs_open(struct fs_file *file, const char *name)
   file->is_custom_file = 0;
 #endif /* LWIP_HTTPD_CUSTOM_FILES */
 
+#if HTTPD_PRECALCULATED_CHECKSUM
+  file->chksum_count = 0;
+  file->chksum = NULL;
+#endif /* HTTPD_PRECALCULATED_CHECKSUM */
+
+#ifdef FS_HASH_SIZE
+  {
+    /* fsdata.c has a perfect hash of the file names: one slot to check */
+    u32_t h = FS_HASH_INIT(FS_HASH_SEED);
+    const char *c;
+    for (c = name; *c; c++) {
+      h = FS_HASH_STEP(h, *c);
+    }
+    f = fs_hash_table[h & (FS_HASH_SIZE - 1)];
+    if ((f != NULL) && strcmp(name, (const char *)f->name)) {
+      f = NULL;
+    }
+  }
+#else /* FS_HASH_SIZE */
   for (f = FS_ROOT; f != NULL; f = f->next) {
     if (!strcmp(name, (const char *)f->name)) {
-      file->data = (const char *)f->data;
-      file->len = f->len;
-      file->index = f->len;
-      file->pextension = NULL;
-      file->flags = f->flags;
+      break;
+    }
+  }
+#endif /* FS_HASH_SIZE */
+  if (f != NULL) {
+    file->data = (const char *)f->data;
+    file->len = f->len;
+    file->index = f->len;
+    file->pextension = NULL;
+    file->flags = f->flags;
 #if HTTPD_PRECALCULATED_CHECKSUM
-      file->chksum_count = f->chksum_count;
-      file->chksum = f->chksum;
+    file->chksum_count = f->chksum_count;
+    file->chksum = f->chksum;
 #endif /* HTTPD_PRECALCULATED_CHECKSUM */
 #if LWIP_HTTPD_FILE_STATE
-      file->state = fs_state_init(file, name);
+    file->state = fs_state_init(file, name);
 #endif /* #if LWIP_HTTPD_FILE_STATE */
-      return ERR_OK;
-    }
+    return ERR_OK;
   }
   /* file not found */
   return ERR_VAL;
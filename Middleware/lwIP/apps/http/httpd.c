@@ -94,6 +94,12 @@
 #include "lwip/stats.h"
 #include "lwip/apps/fs.h"
 #include "httpd_structs.h"
+#if LWIP_HTTPD_INCREMENTAL_PARSER
+#include "httpd_parser.h"
+#endif /* LWIP_HTTPD_INCREMENTAL_PARSER */
+#if LWIP_HTTPD_WEBSOCKET
+#include "httpd_ws.h"
+#endif /* LWIP_HTTPD_WEBSOCKET */
 #include "lwip/def.h"
 
 #include "lwip/altcp.h"
@@ -118,10 +124,80 @@
 #define MIN_REQ_LEN   7
 
 #define CRLF "\r\n"
+#define HTTP11_VERSION              "HTTP/1.1"
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
 #define HTTP11_CONNECTIONKEEPALIVE  "Connection: keep-alive"
 #define HTTP11_CONNECTIONKEEPALIVE2 "Connection: Keep-Alive"
+#define HTTP11_CONNECTIONCLOSE      "Connection: close"
 #endif
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+#if !LWIP_HTTPD_SUPPORT_11_KEEPALIVE || !LWIP_HTTPD_SUPPORT_REQUESTLIST
+#error LWIP_HTTPD_SUPPORT_PIPELINING needs LWIP_HTTPD_SUPPORT_11_KEEPALIVE and LWIP_HTTPD_SUPPORT_REQUESTLIST
+#endif
+/** Pipelined requests answered by nested calls from http_eof(), the next
+    one is started from http_sent() */
+#define HTTP_PIPELINE_MAX_NESTING   4
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+#if LWIP_HTTPD_INCREMENTAL_PARSER && !LWIP_HTTPD_SUPPORT_REQUESTLIST
+#error LWIP_HTTPD_INCREMENTAL_PARSER needs LWIP_HTTPD_SUPPORT_REQUESTLIST
+#endif
+#if LWIP_HTTPD_GZIP_VARIANTS
+#define HTTP_HDR_ACCEPT_ENCODING    "Accept-Encoding:"
+/** Longest URI for which the gzip variant "<uri>.gz" is looked up */
+#define HTTP_GZIP_URI_LEN           63
+#endif
+
+#if LWIP_HTTPD_SUPPORT_POST
+#define HTTP_POST_DATA_PENDING(hs) ((hs)->post_content_len_left != 0)
+#else
+#define HTTP_POST_DATA_PENDING(hs) 0
+#endif
+
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+#define HTTP_IS_DYN(hs) ((hs)->dyn != NULL)
+/* hs->dyn_flags */
+#define HTTP_DYN_FLAG_CHUNKED  0x01 /* HTTP/1.1 request, chunked response */
+#define HTTP_DYN_FLAG_HDR      0x02 /* response header not yet sent */
+/* Response header: the content type goes between start and end */
+#define HTTP_DYN_HDR_START(ver) ver " 200 OK\r\nServer: "HTTPD_SERVER_AGENT"\r\nContent-Type: "
+#define HTTP_DYN_HDR_END        "\r\nCache-Control: no-store\r\n"
+#define HTTP_DYN_HDR_CHUNKED    "Transfer-Encoding: chunked\r\n"
+#define HTTP_DYN_HDR_CLOSE      "Connection: close\r\n"
+/** Chunk header "XXXX\r\n" (LWIP_HTTPD_DYN_BUF_SIZE < 64 KiB), chunk trailer
+    "\r\n" and room for the last chunk "0\r\n\r\n" */
+#define HTTP_DYN_CHUNK_HDR_LEN      6
+#define HTTP_DYN_LAST_CHUNK         "0\r\n\r\n"
+#define HTTP_DYN_CHUNK_OVERHEAD     (HTTP_DYN_CHUNK_HDR_LEN + 2 + sizeof(HTTP_DYN_LAST_CHUNK) - 1)
+#if LWIP_HTTPD_DYN_BUF_SIZE > 0xffff
+#error LWIP_HTTPD_DYN_BUF_SIZE must be < 64 KiB
+#endif
+#else /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+#define HTTP_IS_DYN(hs) 0
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+#if !LWIP_HTTPD_INCREMENTAL_PARSER
+#error LWIP_HTTPD_WEBSOCKET needs LWIP_HTTPD_INCREMENTAL_PARSER
+#endif
+#if LWIP_HTTPD_WS_MAX_FRAME + HTTPD_WS_HDR_MAX > TCP_WND
+#error LWIP_HTTPD_WS_MAX_FRAME must fit into TCP_WND
+#endif
+#define HTTP_IS_WS(hs) ((hs)->ws != NULL)
+/* hs->ws_flags */
+#define HTTP_WS_FLAG_CLOSE_SENT  0x01 /* close frame sent, nothing else follows */
+#define HTTP_WS_FLAG_CLOSE_RCVD  0x02 /* close frame received, nothing else read */
+#define HTTP_WS_FLAG_BROKEN      0x04 /* a frame was cut off in the send buffer */
+/* Handshake response: the accept key goes between start and end */
+#define HTTP_WS_RSP_START "HTTP/1.1 101 Switching Protocols\r\nUpgrade: websocket\r\n" \
+                          "Connection: Upgrade\r\nSec-WebSocket-Accept: "
+#define HTTP_WS_RSP_END   "\r\n\r\n"
+#else /* LWIP_HTTPD_WEBSOCKET */
+#define HTTP_IS_WS(hs) 0
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+/** A response is being sent (a file or a dynamic response) or the connection
+    has been upgraded to WebSocket */
+#define HTTP_IS_SENDING(hs) (((hs)->handle != NULL) || HTTP_IS_DYN(hs) || HTTP_IS_WS(hs))
 
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
 #define HTTP_IS_DYNAMIC_FILE(hs) ((hs)->buf != NULL)
@@ -180,6 +256,18 @@ static char httpd_req_buf[LWIP_HTTPD_MAX_REQ_LENGTH + 1];
 static char http_uri_buf[LWIP_HTTPD_URI_BUF_LEN + 1];
 #endif
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+/** Dynamic responses are written here and copied by altcp_write() at once */
+static char http_dyn_buf[LWIP_HTTPD_DYN_BUF_SIZE];
+static const tDyn *httpd_dyns;
+static int httpd_num_dyns;
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+static const tWs *httpd_ws_handlers;
+static int httpd_num_ws;
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #if LWIP_HTTPD_DYNAMIC_HEADERS
 /* The number of individual strings that comprise the headers sent before each
  * requested file.
@@ -250,6 +338,13 @@ struct http_state {
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
   struct pbuf *req;
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  u32_t req_unrecved; /* bytes at the end of req not yet passed to altcp_recved() */
+  u16_t req_len;      /* length of the parsed request at the start of req */
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+#if LWIP_HTTPD_INCREMENTAL_PARSER
+  struct http_req_parser parser; /* position and state of parsing req */
+#endif /* LWIP_HTTPD_INCREMENTAL_PARSER */
 
 #if LWIP_HTTPD_DYNAMIC_FILE_READ
   char *buf;        /* File read buffer. */
@@ -257,9 +352,26 @@ struct http_state {
 #endif /* LWIP_HTTPD_DYNAMIC_FILE_READ */
   u32_t left;       /* Number of unsent bytes in buf. */
   u8_t retries;
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+  u8_t dyn_flags;   /* HTTP_DYN_FLAG_* */
+  const tDyn *dyn;  /* Dynamic response being sent, NULL for a file. */
+  u32_t dyn_state;  /* State of the handler, see tDynHandler. */
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+#if LWIP_HTTPD_WEBSOCKET
+  const tWs *ws;    /* Handlers of an upgraded connection, NULL for HTTP. */
+  struct http_state *ws_next; /* list of the WebSocket connections */
+  struct pbuf *ws_rx;   /* frame(s) received, not yet complete */
+  struct pbuf *ws_txq;  /* frames not yet taken by the send buffer */
+  u32_t ws_txq_len;
+  u8_t ws_flags;    /* HTTP_WS_FLAG_* */
+  u8_t ws_idle;     /* polls without a sign of life from the client */
+#endif /* LWIP_HTTPD_WEBSOCKET */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   u8_t keepalive;
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_GZIP_VARIANTS
+  u8_t accept_gzip;
+#endif /* LWIP_HTTPD_GZIP_VARIANTS */
 #if LWIP_HTTPD_SSI
   struct http_ssi_state *ssi;
 #endif /* LWIP_HTTPD_SSI */
@@ -311,6 +423,9 @@ static err_t http_find_file(struct http_state *hs, const char *uri, int is_09);
 static err_t http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const char *uri, u8_t tag_check, char *params);
 static err_t http_poll(void *arg, struct altcp_pcb *pcb);
 static u8_t http_check_eof(struct altcp_pcb *pcb, struct http_state *hs);
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+static void http_pipeline_next(struct altcp_pcb *pcb, struct http_state *hs);
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
 #if LWIP_HTTPD_FS_ASYNC_READ
 static void http_continue(void *connection);
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
@@ -347,7 +462,8 @@ static char *http_cgi_param_vals[LWIP_HTTPD_MAX_CGI_PARAMETERS]; /* Values for e
 
 #if LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED
 /** global list of active HTTP connections, use to kill the oldest when
-    running out of memory */
+    running out of memory. Persistent connections are moved to the front
+    after every response, so the list is in least recently used order. */
 static struct http_state *http_connections;
 
 static void
@@ -382,6 +498,9 @@ http_kill_oldest_connection(u8_t ssi_required)
 {
   struct http_state *hs = http_connections;
   struct http_state *hs_free_next = NULL;
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  struct http_state *hs_idle_next = NULL;
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   while (hs && hs->next) {
 #if LWIP_HTTPD_SSI
     if (ssi_required) {
@@ -395,9 +514,21 @@ http_kill_oldest_connection(u8_t ssi_required)
     {
       hs_free_next = hs;
     }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+    if (!ssi_required && !HTTP_IS_SENDING(hs->next)) {
+      /* persistent connection waiting for its next request */
+      hs_idle_next = hs;
+    }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
     LWIP_ASSERT("broken list", hs != hs->next);
     hs = hs->next;
   }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  /* rather kill an idle connection than one sending a response */
+  if (hs_idle_next != NULL) {
+    hs_free_next = hs_idle_next;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   if (hs_free_next != NULL) {
     LWIP_ASSERT("hs_free_next->next != NULL", hs_free_next->next != NULL);
     LWIP_ASSERT("hs_free_next->next->pcb != NULL", hs_free_next->next->pcb != NULL);
@@ -412,6 +543,45 @@ http_kill_oldest_connection(u8_t ssi_required)
 
 #endif /* LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED */
 
+#if LWIP_HTTPD_WEBSOCKET
+/** list of the WebSocket connections, for httpd_ws_broadcast() */
+static struct http_state *http_ws_conns;
+
+static void
+http_ws_remove_connection(struct http_state *hs)
+{
+  struct http_state **pp;
+  for (pp = &http_ws_conns; *pp != NULL; pp = &(*pp)->ws_next) {
+    if (*pp == hs) {
+      *pp = hs->ws_next;
+      break;
+    }
+  }
+}
+
+/** The connection is closed: tell the application and drop the frames */
+static void
+http_ws_eof(struct http_state *hs)
+{
+  const tWs *ws = hs->ws;
+
+  http_ws_remove_connection(hs);
+  /* nothing can be sent from the close handler */
+  hs->ws = NULL;
+  if (hs->ws_rx != NULL) {
+    pbuf_free(hs->ws_rx);
+    hs->ws_rx = NULL;
+  }
+  if (hs->ws_txq != NULL) {
+    pbuf_free(hs->ws_txq);
+    hs->ws_txq = NULL;
+  }
+  if (ws->pfnClose != NULL) {
+    ws->pfnClose(hs, (int)(ws - httpd_ws_handlers));
+  }
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #if LWIP_HTTPD_SSI
 /** Allocate as struct http_ssi_state. */
 static struct http_ssi_state *
@@ -451,6 +621,9 @@ http_state_init(struct http_state *hs)
   /* Indicate that the headers are not yet valid */
   hs->hdr_index = NUM_FILE_HDR_STRINGS;
 #endif /* LWIP_HTTPD_DYNAMIC_HEADERS */
+#if LWIP_HTTPD_INCREMENTAL_PARSER
+  http_req_parser_init(&hs->parser);
+#endif /* LWIP_HTTPD_INCREMENTAL_PARSER */
 }
 
 /** Allocate a struct http_state. */
@@ -505,6 +678,11 @@ http_state_eof(struct http_state *hs)
     hs->req = NULL;
   }
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->ws != NULL) {
+    http_ws_eof(hs);
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
 }
 
 /** Free a struct http_state.
@@ -585,6 +763,34 @@ http_write(struct altcp_pcb *pcb, const void *ptr, u16_t *length, u8_t apiflags)
   return err;
 }
 
+#if LWIP_HTTPD_SUPPORT_POST
+/** Make sure the post code knows that the connection is closed while the
+ * body was still being received (or, with LWIP_HTTPD_POST_MANUAL_WND, not
+ * all of it passed to httpd_post_data_recved() yet).
+ *
+ * @param hs connection state, may be NULL
+ */
+static void
+http_post_conn_closed(struct http_state *hs)
+{
+  if (hs != NULL) {
+    if ((hs->post_content_len_left != 0)
+#if LWIP_HTTPD_POST_MANUAL_WND
+        || ((hs->no_auto_wnd != 0) && (hs->unrecved_bytes != 0))
+#endif /* LWIP_HTTPD_POST_MANUAL_WND */
+       ) {
+      hs->post_content_len_left = 0;
+#if LWIP_HTTPD_POST_MANUAL_WND
+      hs->unrecved_bytes = 0;
+      hs->post_finished = 1;
+#endif /* LWIP_HTTPD_POST_MANUAL_WND */
+      http_uri_buf[0] = 0;
+      httpd_post_finished(hs, http_uri_buf, LWIP_HTTPD_URI_BUF_LEN);
+    }
+  }
+}
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+
 /**
  * The connection shall be actively closed (using RST to close from fault states).
  * Reset the sent- and recv-callbacks.
@@ -599,17 +805,7 @@ http_close_or_abort_conn(struct altcp_pcb *pcb, struct http_state *hs, u8_t abor
   LWIP_DEBUGF(HTTPD_DEBUG, ("Closing connection %p\n", (void *)pcb));
 
 #if LWIP_HTTPD_SUPPORT_POST
-  if (hs != NULL) {
-    if ((hs->post_content_len_left != 0)
-#if LWIP_HTTPD_POST_MANUAL_WND
-        || ((hs->no_auto_wnd != 0) && (hs->unrecved_bytes != 0))
-#endif /* LWIP_HTTPD_POST_MANUAL_WND */
-       ) {
-      /* make sure the post code knows that the connection is closed */
-      http_uri_buf[0] = 0;
-      httpd_post_finished(hs, http_uri_buf, LWIP_HTTPD_URI_BUF_LEN);
-    }
-  }
+  http_post_conn_closed(hs);
 #endif /* LWIP_HTTPD_SUPPORT_POST*/
 
 
@@ -657,6 +853,12 @@ http_eof(struct altcp_pcb *pcb, struct http_state *hs)
   /* HTTP/1.1 persistent connection? (Not supported for SSI) */
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
   if (hs->keepalive) {
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+    /* keep the requests pipelined behind this one */
+    struct pbuf *req = hs->req;
+    u32_t req_unrecved = hs->req_unrecved;
+    hs->req = NULL;
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
     http_remove_connection(hs);
 
     http_state_eof(hs);
@@ -667,6 +869,17 @@ http_eof(struct altcp_pcb *pcb, struct http_state *hs)
     http_add_connection(hs);
     /* ensure nagle doesn't interfere with sending all data as fast as possible: */
     altcp_nagle_disable(pcb);
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+    hs->req = req;
+    hs->req_unrecved = req_unrecved;
+    if (req != NULL) {
+      http_pipeline_next(pcb, hs);
+    } else
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+    {
+      /* idle connections are the first to go when tcp_alloc() runs out of PCBs */
+      altcp_setprio(pcb, HTTPD_TCP_PRIO_IDLE);
+    }
   } else
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
   {
@@ -1183,6 +1396,56 @@ http_check_eof(struct altcp_pcb *pcb, struct http_state *hs)
   return 1;
 }
 
+#if HTTPD_PRECALCULATED_CHECKSUM && LWIP_CHECKSUM_ON_COPY && !LWIP_ALTCP
+#define HTTP_PRECALC_MISMATCH 0xff
+
+/** Sub-function of http_send_data_nonssi(): send the file in the chunks
+ * checksummed by makefsdata (-c), each as one PBUF_ROM reference with its
+ * precalculated checksum, so the file data is not read before the netif
+ * sends it. Only whole chunks are sent: a partial one would misalign the
+ * remaining checksums.
+ *
+ * @returns: - 1: data has been written (so call tcp_ouput)
+ *           - 0: no data has been written (no need to call tcp_output)
+ *           - HTTP_PRECALC_MISMATCH: the file position is not on a chunk
+ */
+static u8_t
+http_send_data_precalc(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  const struct fsdata_chksum *chk = hs->handle->chksum;
+  u32_t offset = (u32_t)(hs->file - hs->handle->data);
+  u16_t lo = 0, hi = hs->handle->chksum_count;
+  u8_t data_to_send = 0;
+
+  /* the chunks are sorted by offset */
+  while (lo < hi) {
+    u16_t mid = (u16_t)((lo + hi) / 2);
+    if (chk[mid].offset < offset) {
+      lo = (u16_t)(mid + 1);
+    } else {
+      hi = mid;
+    }
+  }
+  if ((lo == hs->handle->chksum_count) || (chk[lo].offset != offset)) {
+    return HTTP_PRECALC_MISMATCH;
+  }
+
+  for (chk = &chk[lo]; lo < hs->handle->chksum_count; lo++, chk++) {
+    if ((chk->len > hs->left) || (chk->len > altcp_sndbuf(pcb)) ||
+        (altcp_sndqueuelen(pcb) + 2 > TCP_SND_QUEUELEN)) {
+      break;
+    }
+    if (tcp_write_precalc(pcb, hs->file, chk->len, 0, chk->chksum) != ERR_OK) {
+      break;
+    }
+    data_to_send = 1;
+    hs->file += chk->len;
+    hs->left -= chk->len;
+  }
+  return data_to_send;
+}
+#endif /* HTTPD_PRECALCULATED_CHECKSUM && LWIP_CHECKSUM_ON_COPY && !LWIP_ALTCP */
+
 /** Sub-function of http_send(): This is the normal send-routine for non-ssi files
  *
  * @returns: - 1: data has been written (so call tcp_ouput)
@@ -1195,6 +1458,15 @@ http_send_data_nonssi(struct altcp_pcb *pcb, struct http_state *hs)
   u16_t len;
   u8_t data_to_send = 0;
 
+#if HTTPD_PRECALCULATED_CHECKSUM && LWIP_CHECKSUM_ON_COPY && !LWIP_ALTCP
+  if ((hs->handle->chksum != NULL) && !HTTP_IS_DATA_VOLATILE(hs)) {
+    u8_t sent = http_send_data_precalc(pcb, hs);
+    if (sent != HTTP_PRECALC_MISMATCH) {
+      return sent;
+    }
+  }
+#endif /* HTTPD_PRECALCULATED_CHECKSUM && LWIP_CHECKSUM_ON_COPY && !LWIP_ALTCP */
+
   /* We are not processing an SHTML file so no tag checking is necessary.
    * Just send the data as we received it from the file. */
   len = (u16_t)LWIP_MIN(hs->left, 0xffff);
@@ -1565,6 +1837,445 @@ http_send_data_ssi(struct altcp_pcb *pcb, struct http_state *hs)
 }
 #endif /* LWIP_HTTPD_SSI */
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+/** Sub-function of http_send_dyn(): write the response header to buf.
+ *
+ * @returns the length of the header, 0 if it does not fit into len
+ */
+static u16_t
+http_dyn_header(struct http_state *hs, char *buf, u16_t len)
+{
+  const char *hdr[5];
+  u16_t n = 0, off = 0, i;
+
+  if (hs->dyn_flags & HTTP_DYN_FLAG_CHUNKED) {
+    hdr[n++] = HTTP_DYN_HDR_START(HTTP11_VERSION);
+  } else {
+    hdr[n++] = HTTP_DYN_HDR_START("HTTP/1.0");
+  }
+  hdr[n++] = hs->dyn->pcContentType;
+  hdr[n++] = HTTP_DYN_HDR_END;
+  if (hs->dyn_flags & HTTP_DYN_FLAG_CHUNKED) {
+    hdr[n++] = HTTP_DYN_HDR_CHUNKED;
+  }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (!hs->keepalive)
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+  {
+    hdr[n++] = HTTP_DYN_HDR_CLOSE;
+  }
+  for (i = 0; i < n; i++) {
+    size_t hdr_len = strlen(hdr[i]);
+    if (off + hdr_len + 2 > len) {
+      return 0;
+    }
+    MEMCPY(&buf[off], hdr[i], hdr_len);
+    off = (u16_t)(off + hdr_len);
+  }
+  buf[off++] = '\r';
+  buf[off++] = '\n';
+  return off;
+}
+
+/** Sub-function of http_send(): send the next parts of a dynamic response.
+ * Each part is assembled in http_dyn_buf (the response header before the
+ * first one, the chunk header, what the handler wrote, the chunk trailer and
+ * the last chunk after the final one), sized to what the send buffer takes,
+ * and copied by altcp_write() in one call, so the buffer is free again on
+ * return and shared by all connections. The handler state is only advanced
+ * when the part has been enqueued.
+ *
+ * @returns: - 1: data has been written (so call tcp_ouput)
+ *           - 0: no data has been written (no need to call tcp_output)
+ */
+static u8_t
+http_send_dyn(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  u8_t chunked = (hs->dyn_flags & HTTP_DYN_FLAG_CHUNKED) != 0;
+  u8_t data_to_send = 0;
+
+  while (altcp_sndqueuelen(pcb) < TCP_SND_QUEUELEN) {
+    u16_t room = (u16_t)LWIP_MIN(altcp_sndbuf(pcb), sizeof(http_dyn_buf));
+    u16_t off = 0, len, body;
+    u32_t state = hs->dyn_state;
+    err_t done, err;
+#ifdef HTTPD_MAX_WRITE_LEN
+    room = (u16_t)LWIP_MIN(room, HTTPD_MAX_WRITE_LEN(pcb));
+#endif /* HTTPD_MAX_WRITE_LEN */
+
+    if (hs->dyn_flags & HTTP_DYN_FLAG_HDR) {
+      off = http_dyn_header(hs, http_dyn_buf, room);
+      if (off == 0) {
+        break;
+      }
+    }
+    /* what the handler may write */
+    body = (u16_t)(off + (chunked ? HTTP_DYN_CHUNK_HDR_LEN : 0));
+    len = (u16_t)(room - off);
+    if (chunked) {
+      len = (u16_t)((len > HTTP_DYN_CHUNK_OVERHEAD) ? (len - HTTP_DYN_CHUNK_OVERHEAD) : 0);
+    }
+    if ((len == 0) && (off == 0)) {
+      /* wait for room in the send buffer */
+      break;
+    }
+    if (len > 0) {
+      u16_t max_len = len;
+      done = hs->dyn->pfnDynHandler((int)(hs->dyn - httpd_dyns), &http_dyn_buf[body], &len, &state);
+      if ((done != ERR_OK) && (done != ERR_INPROGRESS)) {
+        LWIP_DEBUGF(HTTPD_DEBUG, ("http_send_dyn: handler failed, close\n"));
+        http_close_conn(pcb, hs);
+        return 0;
+      }
+      LWIP_ASSERT("handler wrote too much", len <= max_len);
+    } else {
+      /* only the header fits */
+      done = ERR_INPROGRESS;
+    }
+    if (chunked && (len > 0)) {
+      char *p = &http_dyn_buf[off];
+      p[0] = hex[(len >> 12) & 0xf];
+      p[1] = hex[(len >> 8) & 0xf];
+      p[2] = hex[(len >> 4) & 0xf];
+      p[3] = hex[len & 0xf];
+      p[4] = '\r';
+      p[5] = '\n';
+      off = (u16_t)(body + len);
+      http_dyn_buf[off++] = '\r';
+      http_dyn_buf[off++] = '\n';
+    } else if (len > 0) {
+      off = (u16_t)(body + len);
+    }
+    if (chunked && (done == ERR_OK)) {
+      MEMCPY(&http_dyn_buf[off], HTTP_DYN_LAST_CHUNK, sizeof(HTTP_DYN_LAST_CHUNK) - 1);
+      off = (u16_t)(off + sizeof(HTTP_DYN_LAST_CHUNK) - 1);
+    }
+    if (off > 0) {
+      err = altcp_write(pcb, http_dyn_buf, off,
+                        (u8_t)(TCP_WRITE_FLAG_COPY | ((done == ERR_OK) ? 0 : TCP_WRITE_FLAG_MORE)));
+      if (err != ERR_OK) {
+        /* the handler is asked for this part again */
+        LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_send_dyn: write failed (%d)\n", err));
+        break;
+      }
+      hs->dyn_flags &= (u8_t)~HTTP_DYN_FLAG_HDR;
+      data_to_send = 1;
+    }
+    hs->dyn_state = state;
+    if (done == ERR_OK) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("End of dynamic response.\n"));
+      http_eof(pcb, hs);
+      return 0;
+    }
+    if (len == 0) {
+      /* the handler waits for room or data */
+      break;
+    }
+  }
+  return data_to_send;
+}
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+/** Sub-function of http_ws_write_frame(): write a frame, as much of it as
+ * the send buffer takes now, and queue the rest behind the frames already
+ * queued. Nothing is written if the rest does not fit into the queue.
+ */
+static err_t
+http_ws_output(struct altcp_pcb *pcb, struct http_state *hs, const u8_t *hdr, u16_t hdr_len,
+               const u8_t *data, u16_t len)
+{
+  u16_t n = (u16_t)(hdr_len + len);
+  u16_t direct = 0, done = 0, w;
+  struct pbuf *q;
+  u8_t *dst;
+
+  if (hs->ws_flags & HTTP_WS_FLAG_BROKEN) {
+    return ERR_CONN;
+  }
+  if ((hs->ws_txq == NULL) && (altcp_sndqueuelen(pcb) + 2 <= TCP_SND_QUEUELEN)) {
+    direct = (u16_t)LWIP_MIN(n, altcp_sndbuf(pcb));
+  }
+  if (hs->ws_txq_len + (u32_t)(n - direct) > LWIP_HTTPD_WS_SNDQUEUE_LEN) {
+    return ERR_MEM;
+  }
+  if (direct > 0) {
+    w = LWIP_MIN(direct, hdr_len);
+    if (altcp_write(pcb, hdr, w, (u8_t)(TCP_WRITE_FLAG_COPY | ((w < n) ? TCP_WRITE_FLAG_MORE : 0))) == ERR_OK) {
+      done = w;
+      if (direct > hdr_len) {
+        w = (u16_t)(direct - hdr_len);
+        if (altcp_write(pcb, data, w, (u8_t)(TCP_WRITE_FLAG_COPY |
+                                             ((done + w < n) ? TCP_WRITE_FLAG_MORE : 0))) == ERR_OK) {
+          done = (u16_t)(done + w);
+        }
+      }
+    }
+  }
+  if (done < n) {
+    q = pbuf_alloc(PBUF_RAW, (u16_t)(n - done), PBUF_RAM);
+    if (q == NULL) {
+      if (done > 0) {
+        /* the frame is cut off, the stream cannot be continued */
+        hs->ws_flags |= HTTP_WS_FLAG_BROKEN;
+      }
+      return ERR_MEM;
+    }
+    dst = (u8_t *)q->payload;
+    if (done < hdr_len) {
+      MEMCPY(dst, &hdr[done], hdr_len - done);
+      dst += hdr_len - done;
+      done = hdr_len;
+    }
+    if (n > done) {
+      MEMCPY(dst, &data[done - hdr_len], n - done);
+    }
+    if (hs->ws_txq == NULL) {
+      hs->ws_txq = q;
+    } else {
+      pbuf_cat(hs->ws_txq, q);
+    }
+    hs->ws_txq_len += q->len;
+  }
+  return ERR_OK;
+}
+
+/** Send a frame with the flags (FIN and opcode) and payload given */
+static err_t
+http_ws_write_frame(struct http_state *hs, u8_t flags, const void *data, u16_t len)
+{
+  u8_t hdr[4];
+  u8_t hdr_len;
+
+  if (len > 0xffff - sizeof(hdr)) {
+    return ERR_VAL;
+  }
+  hdr_len = httpd_ws_frame_hdr(hdr, flags, len);
+  return http_ws_output(hs->pcb, hs, hdr, hdr_len, (const u8_t *)data, len);
+}
+
+/** Start the close handshake (or answer the client's close frame) */
+static err_t
+http_ws_send_close(struct http_state *hs, u16_t code)
+{
+  u8_t status[2];
+  err_t err;
+
+  if (hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT) {
+    return ERR_OK;
+  }
+  status[0] = (u8_t)(code >> 8);
+  status[1] = (u8_t)code;
+  err = http_ws_write_frame(hs, HTTPD_WS_FIN | HTTPD_WS_CLOSE, status, (u16_t)(code ? 2 : 0));
+  hs->ws_flags |= HTTP_WS_FLAG_CLOSE_SENT;
+  /* the client has LWIP_HTTPD_WS_PONG_POLLS to answer */
+  hs->ws_idle = LWIP_HTTPD_WS_PING_POLLS;
+  return err;
+}
+
+/** Sub-function of http_ws_input(): move queued frames into the send buffer */
+static u8_t
+http_ws_send_queued(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  u8_t data_to_send = HTTP_NO_DATA_TO_SEND;
+  u16_t len;
+
+  while ((hs->ws_txq != NULL) && (altcp_sndqueuelen(pcb) < TCP_SND_QUEUELEN)) {
+    len = (u16_t)LWIP_MIN(hs->ws_txq->len, altcp_sndbuf(pcb));
+    if ((len == 0) || (altcp_write(pcb, hs->ws_txq->payload, len, TCP_WRITE_FLAG_COPY) != ERR_OK)) {
+      break;
+    }
+    hs->ws_txq_len -= len;
+    hs->ws_txq = pbuf_free_header(hs->ws_txq, len);
+    data_to_send = HTTP_DATA_TO_SEND_CONTINUE;
+  }
+  return data_to_send;
+}
+
+/** Sub-function of http_ws_input(): a frame has been received completely,
+ * its unmasked payload is at the start of hs->ws_rx.
+ */
+static void
+http_ws_frame(struct http_state *hs, const struct httpd_ws_frame *f)
+{
+  u8_t buf[125];
+  u16_t len = (u16_t)f->len;
+  const void *data = NULL;
+  u16_t code = 0;
+
+  switch (f->flags & ~HTTPD_WS_FIN) {
+    case HTTPD_WS_PING:
+      if (!(hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT)) {
+        if (len > 0) {
+          data = pbuf_get_contiguous(hs->ws_rx, buf, sizeof(buf), len, 0);
+        }
+        http_ws_write_frame(hs, HTTPD_WS_FIN | HTTPD_WS_PONG, data, len);
+      }
+      break;
+    case HTTPD_WS_PONG:
+      break;
+    case HTTPD_WS_CLOSE:
+      hs->ws_flags |= HTTP_WS_FLAG_CLOSE_RCVD;
+      if (len >= 2) {
+        /* echo the status code */
+        code = (u16_t)((pbuf_get_at(hs->ws_rx, 0) << 8) | pbuf_get_at(hs->ws_rx, 1));
+      }
+      http_ws_send_close(hs, code);
+      break;
+    default:
+      if (!(hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT) && (hs->ws->pfnRecv != NULL)) {
+        hs->ws->pfnRecv(hs, (int)(hs->ws - httpd_ws_handlers), f->flags, hs->ws_rx, len);
+      }
+      break;
+  }
+}
+
+/**
+ * Data received on a WebSocket connection (or p NULL to continue with what
+ * is queued): pass every complete frame to http_ws_frame(), send queued
+ * frames and close the connection when the close handshake is done.
+ *
+ * A frame stays in hs->ws_rx until it is complete and is only then passed
+ * to altcp_recved(), so the receive window limits what a client can queue.
+ * Its header is read and its payload unmasked in place.
+ *
+ * @return HTTP_DATA_TO_SEND_CONTINUE if data has been written,
+ *         HTTP_DATA_TO_SEND_FREED if the connection has been closed,
+ *         HTTP_NO_DATA_TO_SEND otherwise
+ */
+static u8_t
+http_ws_input(struct altcp_pcb *pcb, struct http_state *hs, struct pbuf *p)
+{
+  struct httpd_ws_frame f;
+  u16_t code = 0;
+  u8_t data_to_send;
+  err_t err;
+
+  if (p != NULL) {
+    if (!(hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT)) {
+      hs->ws_idle = 0;
+    }
+    if (hs->ws_rx == NULL) {
+      hs->ws_rx = p;
+    } else {
+      pbuf_cat(hs->ws_rx, p);
+    }
+  }
+  while ((hs->ws_rx != NULL) && !(hs->ws_flags & HTTP_WS_FLAG_CLOSE_RCVD)) {
+    err = httpd_ws_frame_parse(&f, hs->ws_rx);
+    if (err == ERR_INPROGRESS) {
+      break;
+    }
+    if ((err == ERR_OK) && !f.masked) {
+      /* clients mask every frame */
+      err = ERR_VAL;
+    } else if ((err == ERR_OK) && (f.len > LWIP_HTTPD_WS_MAX_FRAME)) {
+      err = ERR_MEM;
+    }
+    if (err != ERR_OK) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("http_ws_input: bad frame (%d), close\n", err));
+      code = (err == ERR_MEM) ? HTTPD_WS_CLOSE_TOO_BIG : HTTPD_WS_CLOSE_PROTOCOL_ERROR;
+      break;
+    }
+    if (hs->ws_rx->tot_len < f.hdr_len + f.len) {
+      /* wait for the rest of the payload */
+      break;
+    }
+    hs->ws_rx = pbuf_free_header(hs->ws_rx, f.hdr_len);
+    httpd_ws_unmask(hs->ws_rx, f.len, f.mask);
+    http_ws_frame(hs, &f);
+    hs->ws_rx = pbuf_free_header(hs->ws_rx, (u16_t)f.len);
+    altcp_recved(pcb, (u16_t)(f.hdr_len + f.len));
+  }
+  if (code != 0) {
+    http_ws_send_close(hs, code);
+    /* do not wait for the client's close frame */
+    hs->ws_flags |= HTTP_WS_FLAG_CLOSE_RCVD;
+  }
+  if ((hs->ws_flags & HTTP_WS_FLAG_CLOSE_RCVD) && (hs->ws_rx != NULL)) {
+    /* nothing more is read */
+    altcp_recved(pcb, hs->ws_rx->tot_len);
+    pbuf_free(hs->ws_rx);
+    hs->ws_rx = NULL;
+  }
+
+  data_to_send = http_ws_send_queued(pcb, hs);
+  if ((hs->ws_flags & HTTP_WS_FLAG_BROKEN) ||
+      ((hs->ws_flags & HTTP_WS_FLAG_CLOSE_RCVD) && (hs->ws_txq == NULL))) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("http_ws_input: WebSocket closed\n"));
+    http_close_conn(pcb, hs);
+    return HTTP_DATA_TO_SEND_FREED;
+  }
+  return data_to_send;
+}
+
+/** Sub-function of http_poll(): ping a client that has been idle for
+ * LWIP_HTTPD_WS_PING_POLLS, close if it still is LWIP_HTTPD_WS_PONG_POLLS
+ * later.
+ */
+static void
+http_ws_poll(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  hs->ws_idle++;
+  if (hs->ws_idle >= LWIP_HTTPD_WS_PING_POLLS + LWIP_HTTPD_WS_PONG_POLLS) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: WebSocket client not answering, close\n"));
+    http_close_conn(pcb, hs);
+    return;
+  }
+  if ((hs->ws_idle == LWIP_HTTPD_WS_PING_POLLS) && !(hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT)) {
+    if (http_ws_write_frame(hs, HTTPD_WS_FIN | HTTPD_WS_PING, NULL, 0) == ERR_OK) {
+      altcp_output(pcb);
+    }
+  }
+  if (http_ws_input(pcb, hs, NULL) == HTTP_DATA_TO_SEND_CONTINUE) {
+    altcp_output(pcb);
+  }
+}
+
+/** Answer the WebSocket handshake of a GET request for a registered URI
+ * with "101 Switching Protocols". The request header is still in hs->req.
+ *
+ * @return ERR_OK if the connection has been upgraded,
+ *         ERR_ARG if the handshake is invalid (RFC 6455 4.2.1)
+ */
+static err_t
+http_ws_upgrade(struct http_state *hs, struct altcp_pcb *pcb, const tWs *ws)
+{
+  const struct http_req_parser *rp = &hs->parser;
+  char rsp[sizeof(HTTP_WS_RSP_START) - 1 + HTTPD_WS_ACCEPT_LEN + sizeof(HTTP_WS_RSP_END) - 1];
+  char key[HTTPD_WS_KEY_LEN];
+  char *p = rsp;
+
+  if ((rp->version != HTTP_VERSION_11) || !(rp->flags & HTTP_REQ_FLAG_UPGRADE) ||
+      (rp->val_len[HTTP_REQ_HDR_WS_KEY] != HTTPD_WS_KEY_LEN) ||
+      (rp->val_len[HTTP_REQ_HDR_WS_VERSION] != 2) ||
+      (pbuf_memcmp(hs->req, rp->val_off[HTTP_REQ_HDR_WS_VERSION], "13", 2) != 0)) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Invalid WebSocket handshake\n"));
+    return ERR_ARG;
+  }
+  pbuf_copy_partial(hs->req, key, sizeof(key), rp->val_off[HTTP_REQ_HDR_WS_KEY]);
+  MEMCPY(p, HTTP_WS_RSP_START, sizeof(HTTP_WS_RSP_START) - 1);
+  p += sizeof(HTTP_WS_RSP_START) - 1;
+  httpd_ws_accept(key, p);
+  p += HTTPD_WS_ACCEPT_LEN;
+  MEMCPY(p, HTTP_WS_RSP_END, sizeof(HTTP_WS_RSP_END) - 1);
+  if (altcp_write(pcb, rsp, sizeof(rsp), TCP_WRITE_FLAG_COPY) != ERR_OK) {
+    return ERR_ARG;
+  }
+  LWIP_DEBUGF(HTTPD_DEBUG, ("WebSocket connection for %s\n", ws->pcURI));
+  hs->ws = ws;
+  hs->ws_next = http_ws_conns;
+  http_ws_conns = hs;
+  /* frames are small and pushed out one by one */
+  altcp_nagle_disable(pcb);
+  if (ws->pfnOpen != NULL) {
+    ws->pfnOpen(hs, (int)(ws - httpd_ws_handlers));
+  }
+  return ERR_OK;
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 /**
  * Try to send more data on this pcb.
  *
@@ -1590,6 +2301,18 @@ http_send(struct altcp_pcb *pcb, struct http_state *hs)
     return 0;
   }
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+  if (hs->dyn != NULL) {
+    return http_send_dyn(pcb, hs);
+  }
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->ws != NULL) {
+    /* frames received right behind the handshake, queued frames */
+    return (u8_t)(http_ws_input(pcb, hs, NULL) == HTTP_DATA_TO_SEND_CONTINUE);
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #if LWIP_HTTPD_FS_ASYNC_READ
   /* Check if we are allowed to read from this file.
      (e.g. SSI might want to delay sending until data is available) */
@@ -1783,6 +2506,71 @@ http_post_rxpbuf(struct http_state *hs, struct pbuf *p)
   return ERR_OK;
 }
 
+/** Pass a POST request with a valid Content-Length to the application and
+ * the part of the body received with the header.
+ *
+ * @param inp The input pbuf(s) (containing the POST header and body).
+ * @param hs The http connection state.
+ * @param uri The HTTP URI parsed from input pbuf(s).
+ * @param hdr The HTTP header following the URI.
+ * @param hdr_data_len Size of 'hdr'.
+ * @param hdr_len Size of the whole request header, the body starts here.
+ * @param content_len Value of the Content-Length header.
+ * @return ERR_OK: POST accepted by the application.
+ *         another err_t: POST denied by the application
+ */
+static err_t
+http_post_start(struct pbuf *inp, struct http_state *hs, char *uri,
+                const char *hdr, u16_t hdr_data_len, u16_t hdr_len, int content_len)
+{
+  err_t err;
+  u8_t post_auto_wnd = 1;
+  http_uri_buf[0] = 0;
+  err = httpd_post_begin(hs, uri, hdr, hdr_data_len, content_len,
+                         http_uri_buf, LWIP_HTTPD_URI_BUF_LEN, &post_auto_wnd);
+  if (err == ERR_OK) {
+    /* try to pass in data of the first pbuf(s) */
+    struct pbuf *q = inp;
+    u16_t start_offset = hdr_len;
+#if LWIP_HTTPD_POST_MANUAL_WND
+    hs->no_auto_wnd = !post_auto_wnd;
+#endif /* LWIP_HTTPD_POST_MANUAL_WND */
+    /* set the Content-Length to be received for this POST */
+    hs->post_content_len_left = (u32_t)content_len;
+
+    /* get to the pbuf where the body starts */
+    while ((q != NULL) && (q->len <= start_offset)) {
+      start_offset -= q->len;
+      q = q->next;
+    }
+    if (q != NULL) {
+      /* hide the remaining HTTP header */
+      pbuf_remove_header(q, start_offset);
+#if LWIP_HTTPD_POST_MANUAL_WND
+      if (!post_auto_wnd) {
+        /* already tcp_recved() this data... */
+        hs->unrecved_bytes = q->tot_len;
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+        /* ...not yet with pipelining: leave the body to the application */
+        hs->req_unrecved -= q->tot_len;
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+      }
+#endif /* LWIP_HTTPD_POST_MANUAL_WND */
+      pbuf_ref(q);
+      return http_post_rxpbuf(hs, q);
+    } else if (hs->post_content_len_left == 0) {
+      q = pbuf_alloc(PBUF_RAW, 0, PBUF_REF);
+      return http_post_rxpbuf(hs, q);
+    } else {
+      return ERR_OK;
+    }
+  } else {
+    /* return file passed from application */
+    return http_find_file(hs, http_uri_buf, 0);
+  }
+}
+
+#if !LWIP_HTTPD_INCREMENTAL_PARSER
 /** Handle a post request. Called from http_parse_request when method 'POST'
  * is found.
  *
@@ -1801,7 +2589,6 @@ static err_t
 http_post_request(struct pbuf *inp, struct http_state *hs,
                   char *data, u16_t data_len, char *uri, char *uri_end)
 {
-  err_t err;
   /* search for end-of-header (first double-CRLF) */
   char *crlfcrlf = lwip_strnstr(uri_end + 1, CRLF CRLF, data_len - (uri_end + 1 - data));
 
@@ -1828,48 +2615,10 @@ http_post_request(struct pbuf *inp, struct http_state *hs,
           const char *hdr_start_after_uri = uri_end + 1;
           u16_t hdr_len = (u16_t)LWIP_MIN(data_len, crlfcrlf + 4 - data);
           u16_t hdr_data_len = (u16_t)LWIP_MIN(data_len, crlfcrlf + 4 - hdr_start_after_uri);
-          u8_t post_auto_wnd = 1;
-          http_uri_buf[0] = 0;
           /* trim http header */
           *crlfcrlf = 0;
-          err = httpd_post_begin(hs, uri, hdr_start_after_uri, hdr_data_len, content_len,
-                                 http_uri_buf, LWIP_HTTPD_URI_BUF_LEN, &post_auto_wnd);
-          if (err == ERR_OK) {
-            /* try to pass in data of the first pbuf(s) */
-            struct pbuf *q = inp;
-            u16_t start_offset = hdr_len;
-#if LWIP_HTTPD_POST_MANUAL_WND
-            hs->no_auto_wnd = !post_auto_wnd;
-#endif /* LWIP_HTTPD_POST_MANUAL_WND */
-            /* set the Content-Length to be received for this POST */
-            hs->post_content_len_left = (u32_t)content_len;
-
-            /* get to the pbuf where the body starts */
-            while ((q != NULL) && (q->len <= start_offset)) {
-              start_offset -= q->len;
-              q = q->next;
-            }
-            if (q != NULL) {
-              /* hide the remaining HTTP header */
-              pbuf_remove_header(q, start_offset);
-#if LWIP_HTTPD_POST_MANUAL_WND
-              if (!post_auto_wnd) {
-                /* already tcp_recved() this data... */
-                hs->unrecved_bytes = q->tot_len;
-              }
-#endif /* LWIP_HTTPD_POST_MANUAL_WND */
-              pbuf_ref(q);
-              return http_post_rxpbuf(hs, q);
-            } else if (hs->post_content_len_left == 0) {
-              q = pbuf_alloc(PBUF_RAW, 0, PBUF_REF);
-              return http_post_rxpbuf(hs, q);
-            } else {
-              return ERR_OK;
-            }
-          } else {
-            /* return file passed from application */
-            return http_find_file(hs, http_uri_buf, 0);
-          }
+          return http_post_start(inp, hs, uri, hdr_start_after_uri, hdr_data_len,
+                                 hdr_len, content_len);
         } else {
           LWIP_DEBUGF(HTTPD_DEBUG, ("POST received invalid Content-Length: %s\n",
                                     content_len_num));
@@ -1890,6 +2639,7 @@ http_post_request(struct pbuf *inp, struct http_state *hs,
   return ERR_ARG;
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 }
+#endif /* !LWIP_HTTPD_INCREMENTAL_PARSER */
 
 #if LWIP_HTTPD_POST_MANUAL_WND
 /**
@@ -1953,6 +2703,245 @@ http_continue(void *connection)
 }
 #endif /* LWIP_HTTPD_FS_ASYNC_READ */
 
+#if LWIP_HTTPD_GZIP_VARIANTS
+#if !LWIP_HTTPD_INCREMENTAL_PARSER
+/** Check whether the request headers accept "Content-Encoding: gzip",
+ * i.e. the Accept-Encoding header lists gzip without "q=0".
+ * Header name and coding are matched case-insensitively (RFC 7230 3.2,
+ * RFC 7231 5.3.4), as by the incremental parser.
+ *
+ * @param data the request headers
+ * @param data_len length of data
+ * @return 1 if a gzip encoded response is accepted, 0 otherwise
+ */
+static u8_t
+http_accepts_gzip(const char *data, u16_t data_len)
+{
+  const size_t name_len = sizeof(HTTP_HDR_ACCEPT_ENCODING) - 1;
+  const char *line, *eol, *end = data + data_len, *tok;
+  /* a header name starts a line, the first line is the request line */
+  line = lwip_strnstr(data, CRLF, data_len);
+  for (; line != NULL; line = eol) {
+    line += 2;
+    eol = lwip_strnstr(line, CRLF, (size_t)(end - line));
+    if (eol == NULL) {
+      return 0;
+    }
+    if (((size_t)(eol - line) >= name_len) &&
+        !lwip_strnicmp(line, HTTP_HDR_ACCEPT_ENCODING, name_len)) {
+      break;
+    }
+  }
+  if (line == NULL) {
+    return 0;
+  }
+  for (line += name_len; line < eol; ) {
+    for (; (line < eol) && ((*line == ' ') || (*line == ',')); line++);
+    tok = line;
+    for (; (line < eol) && (*line != ',') && (*line != ';') && (*line != ' '); line++);
+    if ((line - tok == 4) && !lwip_strnicmp(tok, "gzip", 4)) {
+      /* "gzip;q=0", "gzip;q=0.0" etc. refuse the encoding */
+      for (; (line < eol) && (*line == ' '); line++);
+      if ((line < eol) && (*line == ';')) {
+        for (line++; (line < eol) && (*line == ' '); line++);
+        if ((line + 2 < eol) && ((line[0] == 'q') || (line[0] == 'Q')) &&
+            (line[1] == '=') && (line[2] == '0')) {
+          for (line += 3; (line < eol) && ((*line == '.') || (*line == '0')); line++);
+          if ((line == eol) || (*line == ',') || (*line == ' ')) {
+            return 0;
+          }
+        }
+      }
+      return 1;
+    }
+    /* parameters of another coding */
+    for (; (line < eol) && (*line != ','); line++);
+  }
+  return 0;
+}
+#endif /* !LWIP_HTTPD_INCREMENTAL_PARSER */
+
+/** Replace an opened file by its gzip variant "<uri>.gz".
+ * The original file stays open if there is no such variant.
+ *
+ * @param file the opened file (flagged FS_FILE_FLAGS_HAS_GZIP)
+ * @param uri the name the file was opened with
+ */
+static void
+http_open_gzip_variant(struct fs_file *file, const char *uri)
+{
+  char name[HTTP_GZIP_URI_LEN + 4];
+  struct fs_file gz;
+  size_t uri_len = strlen(uri);
+
+  if (uri_len > HTTP_GZIP_URI_LEN) {
+    return;
+  }
+  MEMCPY(name, uri, uri_len);
+  MEMCPY(&name[uri_len], ".gz", 4);
+  if (fs_open(&gz, name) == ERR_OK) {
+    LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Sending gzip variant %s\n", name));
+    fs_close(file);
+    *file = gz;
+  }
+}
+#endif /* LWIP_HTTPD_GZIP_VARIANTS */
+
+#if LWIP_HTTPD_INCREMENTAL_PARSER
+/**
+ * When data has been received in the correct state, continue parsing the
+ * HTTP request where the previous segment left off (hs->parser). The request
+ * stays in the received pbufs, only a URI spanning pbufs is copied.
+ *
+ * @param inp the received pbuf, NULL to parse the request queued in hs->req
+ * @param hs the connection state
+ * @param pcb the altcp_pcb which received this packet
+ * @return ERR_OK if request was OK and hs has been initialized correctly
+ *         ERR_INPROGRESS if request was OK so far but not fully received
+ *         another err_t otherwise
+ */
+static err_t
+http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pcb)
+{
+  struct http_req_parser *rp = &hs->parser;
+  struct pbuf *p = inp;
+  char *uri;
+  u16_t uri_off, uri_len, hdr_len;
+  int is_09;
+  err_t err;
+
+  LWIP_UNUSED_ARG(pcb); /* only used for post */
+  LWIP_ASSERT("p != NULL", (p != NULL) || (hs->req != NULL));
+  LWIP_ASSERT("hs != NULL", hs != NULL);
+
+  if (HTTP_IS_SENDING(hs) || (hs->file != NULL)) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Received data while sending a file\n"));
+    /* already sending a file */
+    /* @todo: abort? */
+    return ERR_USE;
+  }
+
+  if (p != NULL) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
+    /* enqueue the pbuf, parsing resumes at the end of the previous one */
+    if (hs->req == NULL) {
+      hs->req = p;
+    } else {
+      pbuf_cat(hs->req, p);
+    }
+    /* increase pbuf ref counter as it is freed when we return but we want to
+       keep it on the req list */
+    pbuf_ref(p);
+  }
+
+  err = http_req_parse(rp, hs->req, LWIP_HTTPD_REQ_BUFSIZE);
+  if (err == ERR_INPROGRESS) {
+    if (pbuf_clen(hs->req) <= LWIP_HTTPD_REQ_QUEUELEN) {
+      /* request not fully received */
+      return ERR_INPROGRESS;
+    }
+    err = ERR_MEM;
+  }
+  uri_off = rp->uri_off;
+  uri_len = rp->uri_len;
+  hdr_len = rp->hdr_len;
+  LWIP_UNUSED_ARG(hdr_len); /* only used for pipelining */
+  is_09 = (rp->version == HTTP_VERSION_09);
+  if ((err != ERR_OK) || (uri_len > LWIP_HTTPD_MAX_REQ_LENGTH)) {
+    goto badrequest;
+  }
+  if (rp->method == HTTP_METHOD_UNKNOWN) {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Unsupported request method (not implemented)\n"));
+    http_req_parser_init(rp);
+    return http_find_error_file(hs, 501);
+  }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  /* HTTP/1.0 with "Connection: keep-alive" or HTTP/1.1 without
+     "Connection: close" requests a persistent connection */
+  hs->keepalive = !is_09 && ((rp->flags & HTTP_REQ_FLAG_KEEPALIVE) ||
+                             ((rp->version == HTTP_VERSION_11) &&
+                              !(rp->flags & HTTP_REQ_FLAG_CLOSE)));
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_GZIP_VARIANTS
+  hs->accept_gzip = !is_09 && (rp->flags & HTTP_REQ_FLAG_GZIP);
+#endif /* LWIP_HTTPD_GZIP_VARIANTS */
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+  hs->dyn_flags = (rp->version == HTTP_VERSION_11) ? HTTP_DYN_FLAG_CHUNKED : 0;
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_SUPPORT_POST
+  if (rp->method == HTTP_METHOD_POST) {
+    /* httpd_post_begin() gets the header after the URI as one string */
+    u16_t len = (u16_t)(hdr_len - uri_off);
+    u32_t content_len = rp->content_len;
+    char *hdr;
+    u16_t end;
+    if (is_09 || !(rp->flags & HTTP_REQ_FLAG_CONTENT_LENGTH) ||
+        (content_len > 0x7fffffffUL) || (len > LWIP_HTTPD_MAX_REQ_LENGTH)) {
+      goto badrequest;
+    }
+    uri = (char *)pbuf_get_contiguous(hs->req, httpd_req_buf, sizeof(httpd_req_buf), len, uri_off);
+    if (uri == NULL) {
+      goto badrequest;
+    }
+    uri[uri_len] = 0;
+    hdr = uri + uri_len + 1;
+    /* trim http header */
+    for (end = len; (end > uri_len + 1) && ((uri[end - 1] == '\r') || (uri[end - 1] == '\n')); end--);
+    uri[end] = 0;
+    http_req_parser_init(rp);
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Received POST request for URI: \"%s\"\n", uri));
+    err = http_post_start(hs->req, hs, uri, hdr, (u16_t)(len - uri_len - 1), hdr_len, (int)content_len);
+    if (err == ERR_ARG) {
+      goto badrequest;
+    }
+    return err;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_POST */
+
+  uri = (char *)pbuf_get_contiguous(hs->req, httpd_req_buf, sizeof(httpd_req_buf), (u16_t)(uri_len + 1), uri_off);
+  if (uri == NULL) {
+    goto badrequest;
+  }
+  /* null-terminate the URI (the pbuf is freed or trimmed when returning) */
+  uri[uri_len] = 0;
+#if LWIP_HTTPD_WEBSOCKET
+  if ((rp->method == HTTP_METHOD_GET) && (rp->flags & HTTP_REQ_FLAG_WEBSOCKET)) {
+    int i;
+    for (i = 0; i < httpd_num_ws; i++) {
+      if (!strcmp(uri, httpd_ws_handlers[i].pcURI)) {
+        err = http_ws_upgrade(hs, pcb, &httpd_ws_handlers[i]);
+        if (err != ERR_OK) {
+          goto badrequest;
+        }
+        http_req_parser_init(rp);
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+        /* frames behind the handshake stay queued in hs->req (clients must
+           wait for the 101, RFC 6455 4.1, but may not) */
+        hs->req_len = hdr_len;
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+        return ERR_OK;
+      }
+    }
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+  http_req_parser_init(rp);
+  LWIP_DEBUGF(HTTPD_DEBUG, ("Received GET request for URI: \"%s\"\n", uri));
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  /* requests behind this one stay queued in hs->req */
+  hs->req_len = hdr_len;
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+  return http_find_file(hs, uri, is_09);
+
+badrequest:
+  LWIP_DEBUGF(HTTPD_DEBUG, ("bad request\n"));
+  http_req_parser_init(rp);
+  /* could not parse request */
+  return http_find_error_file(hs, 400);
+}
+
+#else /* LWIP_HTTPD_INCREMENTAL_PARSER */
+
 /**
  * When data has been received in the correct state, try to parse it
  * as a HTTP request.
@@ -1979,10 +2968,15 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
 #endif /* LWIP_HTTPD_SUPPORT_POST */
 
   LWIP_UNUSED_ARG(pcb); /* only used for post */
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  /* p == NULL: parse the next pipelined request queued in hs->req */
+  LWIP_ASSERT("p != NULL", (p != NULL) || (hs->req != NULL));
+#else /* LWIP_HTTPD_SUPPORT_PIPELINING */
   LWIP_ASSERT("p != NULL", p != NULL);
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
   LWIP_ASSERT("hs != NULL", hs != NULL);
 
-  if ((hs->handle != NULL) || (hs->file != NULL)) {
+  if (HTTP_IS_SENDING(hs) || (hs->file != NULL)) {
     LWIP_DEBUGF(HTTPD_DEBUG, ("Received data while sending a file\n"));
     /* already sending a file */
     /* @todo: abort? */
@@ -1991,21 +2985,27 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
 
 #if LWIP_HTTPD_SUPPORT_REQUESTLIST
 
-  LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  if (p != NULL)
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+  {
+    LWIP_DEBUGF(HTTPD_DEBUG, ("Received %"U16_F" bytes\n", p->tot_len));
 
-  /* first check allowed characters in this pbuf? */
+    /* first check allowed characters in this pbuf? */
 
-  /* enqueue the pbuf */
-  if (hs->req == NULL) {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("First pbuf\n"));
-    hs->req = p;
-  } else {
-    LWIP_DEBUGF(HTTPD_DEBUG, ("pbuf enqueued\n"));
-    pbuf_cat(hs->req, p);
+    /* enqueue the pbuf */
+    if (hs->req == NULL) {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("First pbuf\n"));
+      hs->req = p;
+    } else {
+      LWIP_DEBUGF(HTTPD_DEBUG, ("pbuf enqueued\n"));
+      pbuf_cat(hs->req, p);
+    }
+    /* increase pbuf ref counter as it is freed when we return but we want to
+       keep it on the req list */
+    pbuf_ref(p);
   }
-  /* increase pbuf ref counter as it is freed when we return but we want to
-     keep it on the req list */
-  pbuf_ref(p);
+  p = hs->req;
 
   if (hs->req->next != NULL) {
     data_len = LWIP_MIN(hs->req->tot_len, LWIP_HTTPD_MAX_REQ_LENGTH);
@@ -2073,18 +3073,31 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
       uri_len = (u16_t)(sp2 - (sp1 + 1));
       if ((sp2 != 0) && (sp2 > sp1)) {
         /* wait for CRLFCRLF (indicating end of HTTP headers) before parsing anything */
-        if (lwip_strnstr(data, CRLF CRLF, data_len) != NULL) {
+        char *crlfcrlf = lwip_strnstr(data, CRLF CRLF, data_len);
+        if (crlfcrlf != NULL) {
           char *uri = sp1 + 1;
+          /* only search the headers of this request, not the ones pipelined behind it */
+          u16_t hdr_len = (u16_t)(crlfcrlf + 4 - data);
 #if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
-          /* This is HTTP/1.0 compatible: for strict 1.1, a connection
-             would always be persistent unless "close" was specified. */
-          if (!is_09 && (lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE, data_len) ||
-                         lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE2, data_len))) {
+          /* HTTP/1.0 with "Connection: keep-alive" or HTTP/1.1 without
+             "Connection: close" requests a persistent connection */
+          if (!is_09 && (lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE, hdr_len) ||
+                         lwip_strnstr(data, HTTP11_CONNECTIONKEEPALIVE2, hdr_len) ||
+                         (!strncmp(sp2 + 1, HTTP11_VERSION, sizeof(HTTP11_VERSION) - 1) &&
+                          !lwip_strnstr(data, HTTP11_CONNECTIONCLOSE, hdr_len)))) {
             hs->keepalive = 1;
           } else {
             hs->keepalive = 0;
           }
 #endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_GZIP_VARIANTS
+          hs->accept_gzip = !is_09 && http_accepts_gzip(data, hdr_len);
+#endif /* LWIP_HTTPD_GZIP_VARIANTS */
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+          hs->dyn_flags = (!is_09 && !strncmp(sp2 + 1, HTTP11_VERSION, sizeof(HTTP11_VERSION) - 1)) ?
+                          HTTP_DYN_FLAG_CHUNKED : 0;
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+          LWIP_UNUSED_ARG(hdr_len);
           /* null-terminate the METHOD (pbuf is freed anyway wen returning) */
           *sp1 = 0;
           uri[uri_len] = 0;
@@ -2111,6 +3124,10 @@ http_parse_request(struct pbuf *inp, struct http_state *hs, struct altcp_pcb *pc
           } else
 #endif /* LWIP_HTTPD_SUPPORT_POST */
           {
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+            /* requests behind this one stay queued in hs->req */
+            hs->req_len = hdr_len;
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
             return http_find_file(hs, uri, is_09);
           }
         }
@@ -2138,6 +3155,8 @@ badrequest:
   }
 }
 
+#endif /* LWIP_HTTPD_INCREMENTAL_PARSER */
+
 #if LWIP_HTTPD_SSI && (LWIP_HTTPD_SSI_BY_FILE_EXTENSION == 1)
 /* Check if SSI should be parsed for this file/URL
  * (With LWIP_HTTPD_SSI_BY_FILE_EXTENSION == 2, this function can be
@@ -2179,6 +3198,39 @@ http_uri_is_ssi(struct fs_file *file, const char *uri)
 }
 #endif /* LWIP_HTTPD_SSI */
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+/** Initialize a http connection with a dynamic response.
+ *
+ * @param hs http connection state
+ * @param dyn the handler registered for the URI
+ * @param is_09 1 if the request is HTTP/0.9 (no HTTP headers in response)
+ * @return ERR_OK
+ */
+static err_t
+http_init_dyn(struct http_state *hs, const tDyn *dyn, int is_09)
+{
+  LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("Dynamic response for %s\n", dyn->pcURI));
+  hs->dyn = dyn;
+  hs->dyn_state = 0;
+  if (is_09) {
+    hs->dyn_flags = 0;
+  } else {
+    hs->dyn_flags |= HTTP_DYN_FLAG_HDR;
+  }
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  if (!(hs->dyn_flags & HTTP_DYN_FLAG_CHUNKED)) {
+    /* the end of the body is the end of the connection */
+    hs->keepalive = 0;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+  hs->retries = 0;
+#if LWIP_HTTPD_TIMING
+  hs->time_started = sys_now();
+#endif /* LWIP_HTTPD_TIMING */
+  return ERR_OK;
+}
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
 /** Try to find the file specified by uri and, if found, initialize hs
  * accordingly.
  *
@@ -2195,9 +3247,9 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
   struct fs_file *file = NULL;
   char *params = NULL;
   err_t err;
-#if LWIP_HTTPD_CGI
+#if LWIP_HTTPD_CGI || LWIP_HTTPD_DYNAMIC_HANDLERS
   int i;
-#endif /* LWIP_HTTPD_CGI */
+#endif /* LWIP_HTTPD_CGI || LWIP_HTTPD_DYNAMIC_HANDLERS */
 #if !LWIP_HTTPD_SSI
   const
 #endif /* !LWIP_HTTPD_SSI */
@@ -2259,6 +3311,14 @@ http_find_file(struct http_state *hs, const char *uri, int is_09)
       params++;
     }
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+    for (i = 0; i < httpd_num_dyns; i++) {
+      if (strcmp(uri, httpd_dyns[i].pcURI) == 0) {
+        return http_init_dyn(hs, &httpd_dyns[i], is_09);
+      }
+    }
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
 #if LWIP_HTTPD_CGI
     http_cgi_paramcount = -1;
     /* Does the base URI we have isolated correspond to a CGI handler? */
@@ -2331,6 +3391,12 @@ http_init_file(struct http_state *hs, struct fs_file *file, int is_09, const cha
     LWIP_ASSERT("file->data != NULL", file->data != NULL);
 #endif
 
+#if LWIP_HTTPD_GZIP_VARIANTS
+    if (hs->accept_gzip && !tag_check && (file->flags & FS_FILE_FLAGS_HAS_GZIP)) {
+      http_open_gzip_variant(file, uri);
+    }
+#endif /* LWIP_HTTPD_GZIP_VARIANTS */
+
 #if LWIP_HTTPD_SSI
     if (tag_check) {
       struct http_ssi_state *ssi = http_ssi_state_alloc();
@@ -2445,6 +3511,10 @@ http_err(void *arg, err_t err)
   LWIP_DEBUGF(HTTPD_DEBUG, ("http_err: %s", lwip_strerr(err)));
 
   if (hs != NULL) {
+#if LWIP_HTTPD_SUPPORT_POST
+    /* the post code must not use the connection after it is freed here */
+    http_post_conn_closed(hs);
+#endif /* LWIP_HTTPD_SUPPORT_POST */
     http_state_free(hs);
   }
 }
@@ -2467,6 +3537,12 @@ http_sent(void *arg, struct altcp_pcb *pcb, u16_t len)
   }
 
   hs->retries = 0;
+#if LWIP_HTTPD_WEBSOCKET
+  if ((hs->ws != NULL) && !(hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT)) {
+    /* acknowledged data shows the client is alive */
+    hs->ws_idle = 0;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
 
   http_send(pcb, hs);
 
@@ -2501,6 +3577,12 @@ http_poll(void *arg, struct altcp_pcb *pcb)
 #endif /* LWIP_HTTPD_ABORT_ON_CLOSE_MEM_ERROR */
     return ERR_OK;
   } else {
+#if LWIP_HTTPD_WEBSOCKET
+    if (hs->ws != NULL) {
+      http_ws_poll(pcb, hs);
+      return ERR_OK;
+    }
+#endif /* LWIP_HTTPD_WEBSOCKET */
     hs->retries++;
     if (hs->retries == HTTPD_MAX_RETRIES) {
       LWIP_DEBUGF(HTTPD_DEBUG, ("http_poll: too many retries, close\n"));
@@ -2511,7 +3593,7 @@ http_poll(void *arg, struct altcp_pcb *pcb)
     /* If this connection has a file open, try to send some more data. If
      * it has not yet received a GET request, don't do this since it will
      * cause the connection to close immediately. */
-    if (hs->handle) {
+    if (HTTP_IS_SENDING(hs)) {
       LWIP_DEBUGF(HTTPD_DEBUG | LWIP_DBG_TRACE, ("http_poll: try to send more data\n"));
       if (http_send(pcb, hs)) {
         /* If we wrote anything to be sent, go ahead and send it now. */
@@ -2524,6 +3606,79 @@ http_poll(void *arg, struct altcp_pcb *pcb)
   return ERR_OK;
 }
 
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+/** Drop the request just parsed from hs->req but keep the requests pipelined
+ * behind it. Request data is passed to altcp_recved() only here, so the
+ * receive window limits how much a client can queue.
+ *
+ * @param pcb the altcp_pcb of the connection
+ * @param hs connection state
+ * @param parsed return value of http_parse_request()
+ */
+static void
+http_req_consumed(struct altcp_pcb *pcb, struct http_state *hs, err_t parsed)
+{
+  u32_t left;
+  if (hs->req != NULL) {
+    if ((parsed == ERR_OK) && (hs->req_len > 0) && (hs->req_len < hs->req->tot_len)) {
+      hs->req = pbuf_free_header(hs->req, hs->req_len);
+    } else {
+      pbuf_free(hs->req);
+      hs->req = NULL;
+    }
+  }
+  hs->req_len = 0;
+  left = (hs->req != NULL) ? hs->req->tot_len : 0;
+  if (hs->req_unrecved > left) {
+    altcp_recved(pcb, (u16_t)(hs->req_unrecved - left));
+    hs->req_unrecved = left;
+  }
+#if LWIP_HTTPD_WEBSOCKET
+  if ((hs->ws != NULL) && (hs->req != NULL)) {
+    /* frames sent right behind the handshake, passed to altcp_recved() by
+       http_ws_input() */
+    hs->ws_rx = hs->req;
+    hs->req = NULL;
+    hs->req_unrecved = 0;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+}
+
+/** A response has been enqueued completely (http_eof()): start the response
+ * to the next request queued in hs->req. Responses to pipelined requests are
+ * so written back to back into the send buffer, in request order.
+ *
+ * @param pcb the altcp_pcb of the connection
+ * @param hs connection state
+ */
+static void
+http_pipeline_next(struct altcp_pcb *pcb, struct http_state *hs)
+{
+  static u8_t nesting;
+  err_t parsed;
+
+  if (nesting >= HTTP_PIPELINE_MAX_NESTING) {
+    /* http_sent() gets here again when the enqueued data is acknowledged */
+    return;
+  }
+  parsed = http_parse_request(NULL, hs, pcb);
+  if (parsed == ERR_INPROGRESS) {
+    /* wait for the rest of the request */
+    return;
+  }
+  http_req_consumed(pcb, hs, parsed);
+  if (parsed == ERR_OK) {
+    if (!HTTP_POST_DATA_PENDING(hs)) {
+      nesting++;
+      http_send(pcb, hs);
+      nesting--;
+    }
+  } else if (parsed == ERR_ARG) {
+    http_close_conn(pcb, hs);
+  }
+}
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+
 /**
  * Data has been received on this pcb.
  * For HTTP 1.0, this should normally only happen once (if the request fits in one packet).
@@ -2550,11 +3705,36 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
     return ERR_OK;
   }
 
+#if LWIP_HTTPD_WEBSOCKET
+  if (hs->ws != NULL) {
+    http_ws_input(pcb, hs, p);
+    return ERR_OK;
+  }
+#endif /* LWIP_HTTPD_WEBSOCKET */
+#if LWIP_HTTPD_SUPPORT_11_KEEPALIVE
+  /* back from HTTPD_TCP_PRIO_IDLE */
+  altcp_setprio(pcb, HTTPD_TCP_PRIO);
+#endif /* LWIP_HTTPD_SUPPORT_11_KEEPALIVE */
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  if (HTTP_IS_SENDING(hs) && !HTTP_POST_DATA_PENDING(hs) && (hs->req != NULL) &&
+      (pbuf_clen(hs->req) + pbuf_clen(p) > LWIP_HTTPD_REQ_QUEUELEN)) {
+    /* too many pipelined requests queued: refuse the data, TCP passes it
+       in again later (tcp_fasttmr) */
+    return ERR_MEM;
+  }
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
+
 #if LWIP_HTTPD_SUPPORT_POST && LWIP_HTTPD_POST_MANUAL_WND
   if (hs->no_auto_wnd) {
     hs->unrecved_bytes += p->tot_len;
   } else
 #endif /* LWIP_HTTPD_SUPPORT_POST && LWIP_HTTPD_POST_MANUAL_WND */
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+  if (!HTTP_POST_DATA_PENDING(hs)) {
+    /* request data, see http_req_consumed() */
+    hs->req_unrecved += p->tot_len;
+  } else
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
   {
     /* Inform TCP that we have taken the data. */
     altcp_recved(pcb, p->tot_len);
@@ -2575,11 +3755,16 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
   } else
 #endif /* LWIP_HTTPD_SUPPORT_POST */
   {
-    if (hs->handle == NULL) {
+    if (!HTTP_IS_SENDING(hs)) {
       err_t parsed = http_parse_request(p, hs, pcb);
       LWIP_ASSERT("http_parse_request: unexpected return value", parsed == ERR_OK
                   || parsed == ERR_INPROGRESS || parsed == ERR_ARG || parsed == ERR_USE);
-#if LWIP_HTTPD_SUPPORT_REQUESTLIST
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+      if (parsed != ERR_INPROGRESS) {
+        /* request fully parsed or error */
+        http_req_consumed(pcb, hs, parsed);
+      }
+#elif LWIP_HTTPD_SUPPORT_REQUESTLIST
       if (parsed != ERR_INPROGRESS) {
         /* request fully parsed or error */
         if (hs->req != NULL) {
@@ -2602,9 +3787,20 @@ http_recv(void *arg, struct altcp_pcb *pcb, struct pbuf *p, err_t err)
         http_close_conn(pcb, hs);
       }
     } else {
+#if LWIP_HTTPD_SUPPORT_PIPELINING
+      /* request(s) pipelined behind the one being answered, parsed by
+         http_pipeline_next() */
+      LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: request queued\n"));
+      if (hs->req == NULL) {
+        hs->req = p;
+      } else {
+        pbuf_cat(hs->req, p);
+      }
+#else /* LWIP_HTTPD_SUPPORT_PIPELINING */
       LWIP_DEBUGF(HTTPD_DEBUG, ("http_recv: already sending data\n"));
       /* already sending but still receiving data, we might want to RST here? */
       pbuf_free(p);
+#endif /* LWIP_HTTPD_SUPPORT_PIPELINING */
     }
   }
   return ERR_OK;
@@ -2759,4 +3955,119 @@ http_set_cgi_handlers(const tCGI *cgis, int num_handlers)
 }
 #endif /* LWIP_HTTPD_CGI */
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+/**
+ * @ingroup httpd
+ * Set an array of URLs answered by dynamic response handlers
+ *
+ * @param dyns an array of URLs, content types and handler functions
+ * @param num_handlers number of elements in the 'dyns' array
+ */
+void
+http_set_dyn_handlers(const tDyn *dyns, int num_handlers)
+{
+  LWIP_ASSERT("no dyns given", dyns != NULL);
+  LWIP_ASSERT("invalid number of handlers", num_handlers > 0);
+
+  httpd_dyns = dyns;
+  httpd_num_dyns = num_handlers;
+}
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+/**
+ * @ingroup httpd
+ * Set an array of URLs accepting WebSocket connections
+ *
+ * @param ws an array of URLs and handler functions
+ * @param num_handlers number of elements in the 'ws' array
+ */
+void
+http_set_ws_handlers(const tWs *ws, int num_handlers)
+{
+  LWIP_ASSERT("no ws given", ws != NULL);
+  LWIP_ASSERT("invalid number of handlers", num_handlers > 0);
+
+  httpd_ws_handlers = ws;
+  httpd_num_ws = num_handlers;
+}
+
+/**
+ * @ingroup httpd
+ * Send a WebSocket message in one frame. What the TCP send buffer does not
+ * take now is queued (LWIP_HTTPD_WS_SNDQUEUE_LEN) and sent as it is
+ * acknowledged, in order.
+ *
+ * @param connection as passed to the open handler
+ * @param opcode HTTPD_WS_TEXT or HTTPD_WS_BINARY
+ * @param data the payload
+ * @param len length of the payload
+ * @return ERR_OK if the frame has been sent or queued,
+ *         ERR_MEM if it does not fit into the queue now (the frame is
+ *         dropped, try again from the sent/poll side or coalesce),
+ *         ERR_CONN if the connection is closing
+ */
+err_t
+httpd_ws_send(void *connection, u8_t opcode, const void *data, u16_t len)
+{
+  struct http_state *hs = (struct http_state *)connection;
+  err_t err;
+
+  LWIP_ASSERT("connection != NULL", hs != NULL);
+  if ((hs->ws == NULL) || (hs->ws_flags & HTTP_WS_FLAG_CLOSE_SENT)) {
+    return ERR_CONN;
+  }
+  err = http_ws_write_frame(hs, (u8_t)(HTTPD_WS_FIN | opcode), data, len);
+  if (err == ERR_OK) {
+    altcp_output(hs->pcb);
+  }
+  return err;
+}
+
+/**
+ * @ingroup httpd
+ * Send a WebSocket message to every connection of a URL, see httpd_ws_send().
+ *
+ * @param iIndex index of the URL in the array of http_set_ws_handlers()
+ * @return the number of connections the message has been sent or queued to
+ */
+int
+httpd_ws_broadcast(int iIndex, u8_t opcode, const void *data, u16_t len)
+{
+  struct http_state *hs;
+  int n = 0;
+
+  for (hs = http_ws_conns; hs != NULL; hs = hs->ws_next) {
+    if ((hs->ws == &httpd_ws_handlers[iIndex]) &&
+        (httpd_ws_send(hs, opcode, data, len) == ERR_OK)) {
+      n++;
+    }
+  }
+  return n;
+}
+
+/**
+ * @ingroup httpd
+ * Start the close handshake of a WebSocket connection. The close handler is
+ * called when the client has answered or after LWIP_HTTPD_WS_PONG_POLLS.
+ *
+ * @param connection as passed to the open handler
+ * @param code status code, e.g. HTTPD_WS_CLOSE_NORMAL, 0 for none
+ */
+err_t
+httpd_ws_close(void *connection, u16_t code)
+{
+  struct http_state *hs = (struct http_state *)connection;
+  err_t err;
+
+  LWIP_ASSERT("connection != NULL", hs != NULL);
+  if (hs->ws == NULL) {
+    return ERR_CONN;
+  }
+  err = http_ws_send_close(hs, code);
+  altcp_output(hs->pcb);
+  return err;
+}
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #endif /* LWIP_TCP && LWIP_CALLBACK_API */
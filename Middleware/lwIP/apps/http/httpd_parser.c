@@ -0,0 +1,468 @@
+/**
+ * @file httpd_parser.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Incremental HTTP request header parser for httpd.
+ *
+ * A state machine over the bytes of the request, resumed at http_req_parser
+ * .pos on every call. Header names and the tokens of the Connection,
+ * Accept-Encoding and Upgrade lists are matched against small tables as they
+ * stream by, Content-Length is converted on the fly. The values of the other
+ * known headers are only located. Lines may end in CRLF or LF.
+ */
+
+#include "httpd_parser.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+#if LWIP_HTTPD_INCREMENTAL_PARSER
+
+/* Parser states */
+#define PS_METHOD      0
+#define PS_URI_START   1
+#define PS_URI         2
+#define PS_VERSION     3
+#define PS_LINE_END    4 /* rest of the request line, up to LF */
+#define PS_LINE_START  5
+#define PS_NAME        6
+#define PS_VALUE_START 7
+#define PS_VALUE       8
+#define PS_DONE        9
+#define PS_ERROR       10
+
+/* States inside the value of a token list header */
+#define VS_TOKEN       0 /* name of the list element */
+#define VS_SKIP        1 /* rest of the element, up to ',' or ';' */
+#define VS_PARAM       2 /* parameter name after ';' */
+#define VS_Q           3 /* "q" read, expect '=' */
+#define VS_QVAL        4 /* value of the "q" parameter */
+
+/* Token matched by the element had a "q=0" parameter */
+#define TOK_QZERO      0x80
+
+#define HTTP_LOWER(c)  ((((c) >= 'A') && ((c) <= 'Z')) ? (char)((c) + ('a' - 'A')) : (c))
+#define HTTP_BLANK(c)  (((c) == ' ') || ((c) == '\t') || ((c) == '\r'))
+#define HTTP_ALL(n)    ((u8_t)((1 << (n)) - 1))
+
+static const char *const http_methods[] = { "GET", "POST" };
+static const char *const http_versions[] = { "HTTP/1.0", "HTTP/1.1" };
+/* indexed by HTTP_REQ_HDR_*, lower case */
+static const char *const http_hdr_names[HTTP_REQ_HDR_COUNT] = {
+  "connection", "content-length", "accept-encoding", "upgrade",
+  "sec-websocket-key", "sec-websocket-version"
+};
+static const char *const http_conn_tokens[] = { "keep-alive", "close", "upgrade" };
+static const u8_t http_conn_flags[] = {
+  HTTP_REQ_FLAG_KEEPALIVE, HTTP_REQ_FLAG_CLOSE, HTTP_REQ_FLAG_UPGRADE
+};
+static const char *const http_enc_tokens[] = { "gzip" };
+static const u8_t http_enc_flags[] = { HTTP_REQ_FLAG_GZIP };
+static const char *const http_upgrade_tokens[] = { "websocket" };
+static const u8_t http_upgrade_flags[] = { HTTP_REQ_FLAG_WEBSOCKET };
+
+/** Tokens of a list header and the flags they set */
+struct http_req_list {
+  const char *const *tokens;
+  const u8_t *flags;
+  u8_t count;
+};
+
+#define HTTP_REQ_LIST(t, f)  { t, f, (u8_t)LWIP_ARRAYSIZE(t) }
+
+/* indexed by HTTP_REQ_HDR_*, count 0 for headers that are no token list */
+static const struct http_req_list http_req_lists[HTTP_REQ_HDR_COUNT] = {
+  HTTP_REQ_LIST(http_conn_tokens, http_conn_flags),
+  { NULL, NULL, 0 },
+  HTTP_REQ_LIST(http_enc_tokens, http_enc_flags),
+  HTTP_REQ_LIST(http_upgrade_tokens, http_upgrade_flags),
+  { NULL, NULL, 0 },
+  { NULL, NULL, 0 }
+};
+
+#define NUM_METHODS      LWIP_ARRAYSIZE(http_methods)
+#define NUM_VERSIONS     LWIP_ARRAYSIZE(http_versions)
+
+/** Match the next character against the candidates left in rp->mask */
+static void
+http_req_match(struct http_req_parser *rp, const char *const *names, u8_t count, char c)
+{
+  u8_t i;
+
+  if (rp->mask == 0) {
+    return;
+  }
+  for (i = 0; i < count; i++) {
+    if ((rp->mask & (1 << i)) && ((names[i][rp->match] != c) || (c == 0))) {
+      rp->mask &= (u8_t)~(1 << i);
+    }
+  }
+  rp->match++;
+}
+
+/** @return index + 1 of the candidate matched completely, 0 if none */
+static u8_t
+http_req_matched(const struct http_req_parser *rp, const char *const *names, u8_t count)
+{
+  u8_t i;
+
+  for (i = 0; i < count; i++) {
+    if ((rp->mask & (1 << i)) && (names[i][rp->match] == 0)) {
+      return (u8_t)(i + 1);
+    }
+  }
+  return 0;
+}
+
+static void
+http_req_token_start(struct http_req_parser *rp, u8_t count)
+{
+  rp->sub = VS_TOKEN;
+  rp->tok = 0;
+  rp->mask = HTTP_ALL(count);
+  rp->match = 0;
+}
+
+/** End of an element of a token list */
+static void
+http_req_element_end(struct http_req_parser *rp)
+{
+  const struct http_req_list *list = &http_req_lists[rp->hdr];
+  u8_t tok;
+
+  tok = (rp->sub == VS_TOKEN) ? http_req_matched(rp, list->tokens, list->count) : rp->tok;
+  if ((tok != 0) && !(tok & TOK_QZERO)) {
+    /* "gzip;q=0" refuses the encoding */
+    rp->flags |= list->flags[tok - 1];
+  }
+  http_req_token_start(rp, list->count);
+}
+
+/** Character of the value of a known header */
+static err_t
+http_req_value_char(struct http_req_parser *rp, char c)
+{
+  const struct http_req_list *list = &http_req_lists[rp->hdr];
+
+  if (rp->hdr == HTTP_REQ_HDR_CONTENT_LENGTH) {
+    if ((c >= '0') && (c <= '9')) {
+      if ((rp->sub == VS_SKIP) || (rp->content_len > (0xffffffffUL - 9) / 10)) {
+        return ERR_ARG;
+      }
+      rp->content_len = rp->content_len * 10 + (u32_t)(c - '0');
+      rp->tok = 1;
+    } else if (HTTP_BLANK(c)) {
+      if (rp->tok) {
+        /* only blanks may follow the number */
+        rp->sub = VS_SKIP;
+      }
+    } else {
+      return ERR_ARG;
+    }
+    return ERR_INPROGRESS;
+  }
+
+  if (list->count == 0) {
+    /* value only located */
+    return ERR_INPROGRESS;
+  }
+
+  /* list of tokens with parameters */
+  if (c == ',') {
+    http_req_element_end(rp);
+    return ERR_INPROGRESS;
+  }
+  switch (rp->sub) {
+    case VS_TOKEN:
+      if ((c == ';') || HTTP_BLANK(c)) {
+        if ((c == ';') || (rp->match > 0)) {
+          rp->tok = http_req_matched(rp, list->tokens, list->count);
+          rp->sub = (c == ';') ? VS_PARAM : VS_SKIP;
+        }
+      } else {
+        http_req_match(rp, list->tokens, list->count, HTTP_LOWER(c));
+      }
+      break;
+    case VS_SKIP:
+      if (c == ';') {
+        rp->sub = VS_PARAM;
+      }
+      break;
+    case VS_PARAM:
+      if ((c == 'q') || (c == 'Q')) {
+        rp->sub = VS_Q;
+      } else if (!HTTP_BLANK(c)) {
+        rp->sub = VS_SKIP;
+      }
+      break;
+    case VS_Q:
+      if (c == '=') {
+        rp->tok |= TOK_QZERO;
+        rp->sub = VS_QVAL;
+      } else if (!HTTP_BLANK(c)) {
+        rp->sub = (c == ';') ? VS_PARAM : VS_SKIP;
+      }
+      break;
+    case VS_QVAL:
+      if ((c >= '1') && (c <= '9')) {
+        rp->tok &= (u8_t)~TOK_QZERO;
+      } else if (c == ';') {
+        rp->sub = VS_PARAM;
+      }
+      break;
+    default:
+      break;
+  }
+  return ERR_INPROGRESS;
+}
+
+/** LF at the end of a header line */
+static err_t
+http_req_value_end(struct http_req_parser *rp)
+{
+  rp->state = PS_LINE_START;
+  if (rp->hdr == HTTP_REQ_HDR_NONE) {
+    return ERR_INPROGRESS;
+  }
+  rp->val_len[rp->hdr] = (u16_t)(rp->val_end - rp->val_off[rp->hdr]);
+  if (rp->hdr == HTTP_REQ_HDR_CONTENT_LENGTH) {
+    if (!rp->tok) {
+      return ERR_ARG;
+    }
+    rp->flags |= HTTP_REQ_FLAG_CONTENT_LENGTH;
+  } else if (http_req_lists[rp->hdr].count != 0) {
+    http_req_element_end(rp);
+  }
+  return ERR_INPROGRESS;
+}
+
+static err_t
+http_req_done(struct http_req_parser *rp)
+{
+  rp->hdr_len = rp->pos;
+  rp->state = PS_DONE;
+  return ERR_OK;
+}
+
+/** Consume one character of the request */
+static err_t
+http_req_parse_char(struct http_req_parser *rp, char c)
+{
+  u16_t pos = rp->pos++;
+  u8_t i;
+
+  switch (rp->state) {
+    case PS_METHOD:
+      if (c == ' ') {
+        rp->method = http_req_matched(rp, http_methods, NUM_METHODS);
+        rp->state = PS_URI_START;
+      } else if ((c == '\r') || (c == '\n')) {
+        return ERR_ARG;
+      } else {
+        http_req_match(rp, http_methods, NUM_METHODS, c);
+      }
+      break;
+    case PS_URI_START:
+      if ((c == '\r') || (c == '\n')) {
+        return ERR_ARG;
+      } else if (c != ' ') {
+        rp->uri_off = pos;
+        rp->state = PS_URI;
+      }
+      break;
+    case PS_URI:
+      if ((c == ' ') || (c == '\r') || (c == '\n')) {
+        rp->uri_len = (u16_t)(pos - rp->uri_off);
+        rp->mask = HTTP_ALL(NUM_VERSIONS);
+        rp->match = 0;
+        if (c == ' ') {
+          rp->state = PS_VERSION;
+        } else {
+          /* HTTP/0.9: the request line is the whole request */
+          rp->version = HTTP_VERSION_09;
+          if (c == '\n') {
+            return http_req_done(rp);
+          }
+          rp->state = PS_LINE_END;
+        }
+      }
+      break;
+    case PS_VERSION:
+      if ((c == '\r') || (c == '\n')) {
+        rp->version = (http_req_matched(rp, http_versions, NUM_VERSIONS) == 2) ?
+                      HTTP_VERSION_11 : HTTP_VERSION_10;
+        rp->state = (c == '\n') ? PS_LINE_START : PS_LINE_END;
+      } else if (c != ' ') {
+        http_req_match(rp, http_versions, NUM_VERSIONS, c);
+      }
+      break;
+    case PS_LINE_END:
+      if (c == '\n') {
+        if (rp->version == HTTP_VERSION_09) {
+          return http_req_done(rp);
+        }
+        rp->state = PS_LINE_START;
+      }
+      break;
+    case PS_LINE_START:
+      if (c == '\n') {
+        /* empty line: end of the header */
+        return http_req_done(rp);
+      } else if (c != '\r') {
+        rp->mask = HTTP_ALL(HTTP_REQ_HDR_COUNT);
+        rp->match = 0;
+        http_req_match(rp, http_hdr_names, HTTP_REQ_HDR_COUNT, HTTP_LOWER(c));
+        rp->state = PS_NAME;
+      }
+      break;
+    case PS_NAME:
+      if (c == ':') {
+        i = http_req_matched(rp, http_hdr_names, HTTP_REQ_HDR_COUNT);
+        rp->hdr = i ? (u8_t)(i - 1) : HTTP_REQ_HDR_NONE;
+        if (rp->hdr == HTTP_REQ_HDR_CONTENT_LENGTH) {
+          if (rp->flags & HTTP_REQ_FLAG_CONTENT_LENGTH) {
+            /* the length of the body must be unambiguous */
+            return ERR_ARG;
+          }
+          rp->content_len = 0;
+        }
+        http_req_token_start(rp, (rp->hdr != HTTP_REQ_HDR_NONE) ?
+                             http_req_lists[rp->hdr].count : 0);
+        rp->state = PS_VALUE_START;
+      } else if (c == '\n') {
+        return ERR_ARG;
+      } else if (c != '\r') {
+        http_req_match(rp, http_hdr_names, HTTP_REQ_HDR_COUNT, HTTP_LOWER(c));
+      }
+      break;
+    case PS_VALUE_START:
+      if ((c == ' ') || (c == '\t') || (c == '\r')) {
+        break;
+      }
+      if (rp->hdr != HTTP_REQ_HDR_NONE) {
+        rp->val_off[rp->hdr] = pos;
+      }
+      rp->val_end = pos;
+      rp->state = PS_VALUE;
+      /* FALLTHROUGH */
+    case PS_VALUE:
+      if (c == '\n') {
+        return http_req_value_end(rp);
+      }
+      if (rp->hdr != HTTP_REQ_HDR_NONE) {
+        if (!HTTP_BLANK(c)) {
+          rp->val_end = (u16_t)(pos + 1);
+        }
+        return http_req_value_char(rp, c);
+      }
+      break;
+    case PS_DONE:
+      return ERR_OK;
+    default:
+      return ERR_ARG;
+  }
+  return ERR_INPROGRESS;
+}
+
+/** Skip the characters that do not change the state: the URI, names of
+ * other headers and their values, the rest of the request line.
+ *
+ * @return offset of the next character to parse, len if none
+ */
+static u16_t
+http_req_skip(const struct http_req_parser *rp, const char *data, u16_t off, u16_t len)
+{
+  const char *lf;
+  char c;
+
+  switch (rp->state) {
+    case PS_VALUE:
+      if (rp->hdr != HTTP_REQ_HDR_NONE) {
+        break;
+      }
+      /* FALLTHROUGH */
+    case PS_LINE_END:
+      lf = (const char *)memchr(data + off, '\n', (size_t)(len - off));
+      return (lf != NULL) ? (u16_t)(lf - data) : len;
+    case PS_URI:
+      for (; off < len; off++) {
+        c = data[off];
+        if ((c == ' ') || (c == '\r') || (c == '\n')) {
+          break;
+        }
+      }
+      break;
+    case PS_NAME:
+      if (rp->mask == 0) {
+        for (; off < len; off++) {
+          c = data[off];
+          if ((c == ':') || (c == '\n')) {
+            break;
+          }
+        }
+      }
+      break;
+    default:
+      break;
+  }
+  return off;
+}
+
+/** Prepare the parser for the next request */
+void
+http_req_parser_init(struct http_req_parser *rp)
+{
+  memset(rp, 0, sizeof(*rp));
+  rp->mask = HTTP_ALL(NUM_METHODS);
+  rp->hdr = HTTP_REQ_HDR_NONE;
+}
+
+/**
+ * Parse the request header received so far.
+ *
+ * @param rp parser state, http_req_parser_init() before the first call
+ * @param p pbuf chain starting with the request, grown between calls
+ * @param max_len longest request header accepted
+ * @return ERR_OK when the header is complete (rp->hdr_len),
+ *         ERR_INPROGRESS if more data is needed,
+ *         ERR_MEM if the header is longer than max_len,
+ *         ERR_ARG if the request is malformed
+ */
+err_t
+http_req_parse(struct http_req_parser *rp, struct pbuf *p, u16_t max_len)
+{
+  struct pbuf *q;
+  const char *data;
+  u16_t off, end;
+  err_t err;
+
+  if (rp->state == PS_DONE) {
+    return ERR_OK;
+  } else if (rp->state == PS_ERROR) {
+    return ERR_ARG;
+  }
+  for (q = pbuf_skip(p, rp->pos, &off); q != NULL; q = q->next, off = 0) {
+    data = (const char *)q->payload;
+    while (off < q->len) {
+      end = http_req_skip(rp, data, off, q->len);
+      if ((u32_t)rp->pos + (u32_t)(end - off) >= max_len) {
+        return ERR_MEM;
+      }
+      rp->pos = (u16_t)(rp->pos + (end - off));
+      off = end;
+      if (off == q->len) {
+        break;
+      }
+      err = http_req_parse_char(rp, data[off++]);
+      if (err != ERR_INPROGRESS) {
+        if (err != ERR_OK) {
+          rp->state = PS_ERROR;
+        }
+        return err;
+      }
+    }
+  }
+  return ERR_INPROGRESS;
+}
+
+#endif /* LWIP_HTTPD_INCREMENTAL_PARSER */
@@ -0,0 +1,82 @@
+/**
+ * @file httpd_parser.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Incremental HTTP request header parser for httpd.
+ *
+ * The parser is fed the pbuf chain a request is received in. It keeps its
+ * position and state between calls, so every byte is looked at once however
+ * many segments the header arrives in, and nothing is copied: the URI and
+ * the values of the known headers are returned as offsets into the chain.
+ */
+
+#ifndef LWIP_HTTPD_PARSER_H
+#define LWIP_HTTPD_PARSER_H
+
+#include "lwip/apps/httpd_opts.h"
+#include "lwip/err.h"
+#include "lwip/pbuf.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Request methods, HTTP_METHOD_UNKNOWN for all others */
+#define HTTP_METHOD_UNKNOWN  0
+#define HTTP_METHOD_GET      1
+#define HTTP_METHOD_POST     2
+
+/** Request versions, HTTP/0.9 is a request line without version */
+#define HTTP_VERSION_09      9
+#define HTTP_VERSION_10      10
+#define HTTP_VERSION_11      11
+
+/** Headers whose value is located (http_req_parser.val_off/val_len) */
+#define HTTP_REQ_HDR_CONNECTION       0
+#define HTTP_REQ_HDR_CONTENT_LENGTH   1
+#define HTTP_REQ_HDR_ACCEPT_ENCODING  2
+#define HTTP_REQ_HDR_UPGRADE          3
+#define HTTP_REQ_HDR_WS_KEY           4 /* Sec-WebSocket-Key */
+#define HTTP_REQ_HDR_WS_VERSION       5 /* Sec-WebSocket-Version */
+#define HTTP_REQ_HDR_COUNT            6
+#define HTTP_REQ_HDR_NONE             0xff
+
+/** Tokens found in the header values (http_req_parser.flags) */
+#define HTTP_REQ_FLAG_KEEPALIVE       0x01 /* Connection: keep-alive */
+#define HTTP_REQ_FLAG_CLOSE           0x02 /* Connection: close */
+#define HTTP_REQ_FLAG_GZIP            0x04 /* Accept-Encoding: gzip, not q=0 */
+#define HTTP_REQ_FLAG_CONTENT_LENGTH  0x08 /* content_len is valid */
+#define HTTP_REQ_FLAG_UPGRADE         0x10 /* Connection: upgrade */
+#define HTTP_REQ_FLAG_WEBSOCKET       0x20 /* Upgrade: websocket */
+
+/** State of the parser and the parsed request. All offsets are relative to
+ * the start of the request in the pbuf chain passed to http_req_parse(). */
+struct http_req_parser {
+  u16_t pos;          /* bytes consumed */
+  u8_t state;
+  u8_t sub;           /* state inside a header value */
+  u8_t hdr;           /* header being parsed, HTTP_REQ_HDR_* */
+  u8_t mask;          /* candidates of the name/token being matched */
+  u8_t match;         /* characters of the name/token matched */
+  u8_t tok;           /* token matched in the current list element */
+
+  u8_t method;        /* HTTP_METHOD_* */
+  u8_t version;       /* HTTP_VERSION_* */
+  u8_t flags;         /* HTTP_REQ_FLAG_* */
+  u16_t uri_off;
+  u16_t uri_len;
+  u16_t val_off[HTTP_REQ_HDR_COUNT]; /* values without surrounding blanks, */
+  u16_t val_len[HTTP_REQ_HDR_COUNT]; /* val_len 0 if the header is missing */
+  u16_t val_end;      /* end of the current value without trailing blanks */
+  u32_t content_len;
+  u16_t hdr_len;      /* length of the request header, incl. the empty line */
+};
+
+void http_req_parser_init(struct http_req_parser *rp);
+err_t http_req_parse(struct http_req_parser *rp, struct pbuf *p, u16_t max_len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HTTPD_PARSER_H */
@@ -0,0 +1,265 @@
+/**
+ * @file httpd_ws.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief WebSocket (RFC 6455) handshake key and frame codec for httpd.
+ *
+ * The accept key needs SHA-1 and base64, both kept minimal here: one digest
+ * of 60 bytes per handshake does not justify a crypto library. Unmasking
+ * XORs whole aligned words, the mask rotated to the alignment of each pbuf.
+ */
+
+#include "httpd_ws.h"
+#include "lwip/def.h"
+
+#include <string.h>
+
+#if LWIP_HTTPD_WEBSOCKET
+
+#define WS_GUID      "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"
+#define WS_GUID_LEN  (sizeof(WS_GUID) - 1)
+
+/* First header byte */
+#define WS_RSV       0x70
+#define WS_OPCODE    0x0f
+/* Second header byte */
+#define WS_MASKED    0x80
+#define WS_LEN       0x7f
+#define WS_LEN_16    126
+#define WS_LEN_64    127
+/** Longest payload of a control frame */
+#define WS_CTRL_MAX  125
+
+#define ROL32(x, n)  (((x) << (n)) | ((x) >> (32 - (n))))
+
+static void
+httpd_ws_sha1_block(u32_t *h, const u8_t *blk)
+{
+  u32_t w[16], a, b, c, d, e, f, k, t;
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    w[i] = ((u32_t)blk[4 * i] << 24) | ((u32_t)blk[4 * i + 1] << 16) |
+           ((u32_t)blk[4 * i + 2] << 8) | blk[4 * i + 3];
+  }
+  a = h[0];
+  b = h[1];
+  c = h[2];
+  d = h[3];
+  e = h[4];
+  for (i = 0; i < 80; i++) {
+    if (i >= 16) {
+      t = w[(i + 13) & 15] ^ w[(i + 8) & 15] ^ w[(i + 2) & 15] ^ w[i & 15];
+      w[i & 15] = ROL32(t, 1);
+    }
+    if (i < 20) {
+      f = (b & c) | (~b & d);
+      k = 0x5a827999UL;
+    } else if (i < 40) {
+      f = b ^ c ^ d;
+      k = 0x6ed9eba1UL;
+    } else if (i < 60) {
+      f = (b & c) | (b & d) | (c & d);
+      k = 0x8f1bbcdcUL;
+    } else {
+      f = b ^ c ^ d;
+      k = 0xca62c1d6UL;
+    }
+    t = ROL32(a, 5) + f + e + k + w[i & 15];
+    e = d;
+    d = c;
+    c = ROL32(b, 30);
+    b = a;
+    a = t;
+  }
+  h[0] += a;
+  h[1] += b;
+  h[2] += c;
+  h[3] += d;
+  h[4] += e;
+}
+
+/** SHA-1 of a message shorter than 56 + 64 bytes (two blocks) */
+static void
+httpd_ws_sha1(const u8_t *msg, u8_t len, u8_t *digest)
+{
+  u32_t h[5] = { 0x67452301UL, 0xefcdab89UL, 0x98badcfeUL, 0x10325476UL, 0xc3d2e1f0UL };
+  u8_t blk[128];
+  u8_t n = (len < 56) ? 64 : 128;
+  u32_t bits = (u32_t)len * 8;
+  int i;
+
+  memset(blk, 0, sizeof(blk));
+  MEMCPY(blk, msg, len);
+  blk[len] = 0x80;
+  blk[n - 4] = (u8_t)(bits >> 24);
+  blk[n - 3] = (u8_t)(bits >> 16);
+  blk[n - 2] = (u8_t)(bits >> 8);
+  blk[n - 1] = (u8_t)bits;
+  httpd_ws_sha1_block(h, blk);
+  if (n == 128) {
+    httpd_ws_sha1_block(h, blk + 64);
+  }
+  for (i = 0; i < 20; i++) {
+    digest[i] = (u8_t)(h[i >> 2] >> (24 - 8 * (i & 3)));
+  }
+}
+
+/**
+ * Sec-WebSocket-Accept for a Sec-WebSocket-Key: base64 of the SHA-1 of the
+ * key and the RFC 6455 GUID.
+ *
+ * @param key HTTPD_WS_KEY_LEN characters, as received
+ * @param accept HTTPD_WS_ACCEPT_LEN characters written, not terminated
+ */
+void
+httpd_ws_accept(const char *key, char *accept)
+{
+  static const char b64[] = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+  u8_t msg[HTTPD_WS_KEY_LEN + WS_GUID_LEN];
+  u8_t d[20];
+  u32_t v;
+  int i;
+
+  MEMCPY(msg, key, HTTPD_WS_KEY_LEN);
+  MEMCPY(&msg[HTTPD_WS_KEY_LEN], WS_GUID, WS_GUID_LEN);
+  httpd_ws_sha1(msg, sizeof(msg), d);
+  /* 20 bytes: six groups of three and two bytes padded with '=' */
+  for (i = 0; i < 7; i++) {
+    v = ((u32_t)d[3 * i] << 16) | ((u32_t)d[3 * i + 1] << 8) | ((i < 6) ? d[3 * i + 2] : 0);
+    accept[4 * i] = b64[(v >> 18) & 0x3f];
+    accept[4 * i + 1] = b64[(v >> 12) & 0x3f];
+    accept[4 * i + 2] = b64[(v >> 6) & 0x3f];
+    accept[4 * i + 3] = b64[v & 0x3f];
+  }
+  accept[HTTPD_WS_ACCEPT_LEN - 1] = '=';
+}
+
+/**
+ * Parse the header of the frame at the start of a pbuf chain. The payload
+ * may not have been received yet.
+ *
+ * @param f the header, valid on ERR_OK
+ * @param p pbuf chain starting with the frame
+ * @return ERR_OK if the header is complete,
+ *         ERR_INPROGRESS if more data is needed,
+ *         ERR_MEM if the payload length does not fit 32 bit,
+ *         ERR_VAL if the frame is malformed (status 1002)
+ */
+err_t
+httpd_ws_frame_parse(struct httpd_ws_frame *f, const struct pbuf *p)
+{
+  u8_t h[HTTPD_WS_HDR_MAX];
+  u8_t have, need = 2, opcode, i;
+  u32_t len;
+
+  have = (u8_t)pbuf_copy_partial(p, h, (u16_t)LWIP_MIN(p->tot_len, sizeof(h)), 0);
+  if (have < need) {
+    return ERR_INPROGRESS;
+  }
+  opcode = h[0] & WS_OPCODE;
+  len = h[1] & WS_LEN;
+  if (h[0] & WS_RSV) {
+    /* no extension negotiated */
+    return ERR_VAL;
+  }
+  if (opcode >= HTTPD_WS_CLOSE) {
+    /* control frames are short and not fragmented */
+    if ((opcode > HTTPD_WS_PONG) || !(h[0] & HTTPD_WS_FIN) || (len > WS_CTRL_MAX)) {
+      return ERR_VAL;
+    }
+  } else if (opcode > HTTPD_WS_BINARY) {
+    return ERR_VAL;
+  }
+  if (len == WS_LEN_16) {
+    need += 2;
+  } else if (len == WS_LEN_64) {
+    need += 8;
+  }
+  if (h[1] & WS_MASKED) {
+    need += 4;
+  }
+  if (have < need) {
+    return ERR_INPROGRESS;
+  }
+  if (len == WS_LEN_16) {
+    len = ((u32_t)h[2] << 8) | h[3];
+  } else if (len == WS_LEN_64) {
+    if (h[2] | h[3] | h[4] | h[5]) {
+      return ERR_MEM;
+    }
+    len = ((u32_t)h[6] << 24) | ((u32_t)h[7] << 16) | ((u32_t)h[8] << 8) | h[9];
+  }
+  f->flags = h[0] & (HTTPD_WS_FIN | WS_OPCODE);
+  f->masked = (h[1] & WS_MASKED) != 0;
+  f->hdr_len = need;
+  f->len = len;
+  for (i = 0; i < 4; i++) {
+    f->mask[i] = f->masked ? h[need - 4 + i] : 0;
+  }
+  return ERR_OK;
+}
+
+/**
+ * Unmask the payload at the start of a pbuf chain in place.
+ *
+ * @param p pbuf chain starting with the payload
+ * @param len payload length, at most p->tot_len
+ * @param mask the masking key of the frame
+ */
+void
+httpd_ws_unmask(struct pbuf *p, u32_t len, const u8_t *mask)
+{
+  u8_t k = 0, r[4], j;
+  u16_t i, n;
+  u32_t m;
+  u8_t *d;
+
+  for (; (p != NULL) && (len > 0); p = p->next) {
+    d = (u8_t *)p->payload;
+    n = (u16_t)LWIP_MIN(p->len, len);
+    len -= n;
+    /* up to the first aligned word */
+    for (i = 0; (i < n) && (((mem_ptr_t)&d[i] & 3) != 0); i++) {
+      d[i] ^= mask[k];
+      k = (k + 1) & 3;
+    }
+    if (n - i >= 4) {
+      for (j = 0; j < 4; j++) {
+        r[j] = mask[(k + j) & 3];
+      }
+      MEMCPY(&m, r, sizeof(m));
+      for (; i + 4 <= n; i += 4) {
+        *(u32_t *)(void *)&d[i] ^= m;
+      }
+    }
+    for (; i < n; i++) {
+      d[i] ^= mask[k];
+      k = (k + 1) & 3;
+    }
+  }
+}
+
+/**
+ * Write the header of an unmasked (server) frame.
+ *
+ * @param hdr at least 4 bytes
+ * @param flags opcode and HTTPD_WS_FIN
+ * @param len payload length
+ * @return the header length
+ */
+u8_t
+httpd_ws_frame_hdr(u8_t *hdr, u8_t flags, u16_t len)
+{
+  hdr[0] = flags;
+  if (len < WS_LEN_16) {
+    hdr[1] = (u8_t)len;
+    return 2;
+  }
+  hdr[1] = WS_LEN_16;
+  hdr[2] = (u8_t)(len >> 8);
+  hdr[3] = (u8_t)len;
+  return 4;
+}
+
+#endif /* LWIP_HTTPD_WEBSOCKET */
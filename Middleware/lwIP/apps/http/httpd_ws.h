@@ -0,0 +1,50 @@
+/**
+ * @file httpd_ws.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief WebSocket (RFC 6455) handshake key and frame codec for httpd.
+ *
+ * Frames are parsed where they were received: the header is read from the
+ * start of the pbuf chain and the payload unmasked in place, so a frame is
+ * never copied to be decoded. The connection handling is in httpd.c.
+ */
+
+#ifndef LWIP_HTTPD_WS_H
+#define LWIP_HTTPD_WS_H
+
+#include "lwip/apps/httpd.h"
+
+#if LWIP_HTTPD_WEBSOCKET
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Sec-WebSocket-Key: base64 of 16 random bytes */
+#define HTTPD_WS_KEY_LEN     24
+/** Sec-WebSocket-Accept: base64 of a SHA-1 digest */
+#define HTTPD_WS_ACCEPT_LEN  28
+/** Longest frame header: 64 bit length and masking key */
+#define HTTPD_WS_HDR_MAX     14
+
+/** Header of a received frame */
+struct httpd_ws_frame {
+  u8_t flags;     /* opcode and HTTPD_WS_FIN */
+  u8_t masked;
+  u8_t hdr_len;   /* bytes of the header in front of the payload */
+  u8_t mask[4];
+  u32_t len;      /* payload length */
+};
+
+void httpd_ws_accept(const char *key, char *accept);
+err_t httpd_ws_frame_parse(struct httpd_ws_frame *f, const struct pbuf *p);
+void httpd_ws_unmask(struct pbuf *p, u32_t len, const u8_t *mask);
+u8_t httpd_ws_frame_hdr(u8_t *hdr, u8_t flags, u16_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
+#endif /* LWIP_HTTPD_WS_H */
@@ -27,8 +27,26 @@
 #define MAKEFS_SUPPORT_DEFLATE 0
 #endif
 
+/** Makefsdata can generate a gzip-compressed variant "<name>.gz" next to every
+ * compressible file (where file size shrinks). httpd serves it instead of the
+ * original to clients sending "Accept-Encoding: gzip" (LWIP_HTTPD_GZIP_VARIANTS).
+ * Compression uses the host's zlib (link with -lz).
+ */
+#ifndef MAKEFS_SUPPORT_GZIP
+#define MAKEFS_SUPPORT_GZIP 0
+#endif
+
 #define COPY_BUFSIZE (1024*1024) /* 1 MByte */
 
+#if MAKEFS_SUPPORT_GZIP
+#include <zlib.h>
+
+int gzip_level = 9; /* default compression level, can be changed via command line */
+#define USAGE_ARG_GZIP " [-gz<:compr_level>]"
+#else /* MAKEFS_SUPPORT_GZIP */
+#define USAGE_ARG_GZIP ""
+#endif /* MAKEFS_SUPPORT_GZIP */
+
 #if MAKEFS_SUPPORT_DEFLATE
 #include "../miniz.c"
 
@@ -107,19 +125,31 @@ static int payload_alingment_dummy_counter = 0;
 
 #define MAX_PATH_LEN 256
 
+/* Content encoding of a file, passed to file_write_http_header() */
+#define FILE_ENC_NONE      0
+#define FILE_ENC_DEFLATE   1
+#define FILE_ENC_GZIP      2
+#define FILE_ENC_MASK      0x0f
+/* or'ed to FILE_ENC_NONE: a gzip variant exists, responses depend on Accept-Encoding */
+#define FILE_ENC_VARY      0x10
+
 struct file_entry {
   struct file_entry *next;
   const char *filename_c;
+  const char *name;
 };
 
 int process_sub(FILE *data_file, FILE *struct_file);
 int process_file(FILE *data_file, FILE *struct_file, const char *filename);
+static int write_file(FILE *data_file, FILE *struct_file, const char *filename, const char *qualifiedName,
+                      const u8_t *file_data, int file_size, u8_t flags, int encoding);
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed);
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, int encoding);
 int file_put_ascii(FILE *file, const char *ascii_string, int len, int *i);
 int s_put_ascii(char *buf, const char *ascii_string, int len, int *i);
 void concat_files(const char *file1, const char *file2, const char *targetfile);
 int check_path(char *path, size_t size);
+static void write_hash_table(FILE *struct_file, int num_files);
 static int checkSsiByFilelist(const char* filename_listfile);
 static int ext_in_list(const char* filename, const char *ext_list);
 static int file_to_exclude(const char* filename);
@@ -143,6 +173,11 @@ unsigned char deflateNonSsiFiles = 0;
 size_t deflatedBytesReduced = 0;
 size_t overallDataBytes = 0;
 #endif
+#if MAKEFS_SUPPORT_GZIP
+unsigned char gzipVariants = 0;
+size_t gzipBytesOriginal = 0;
+size_t gzipBytesVariant = 0;
+#endif
 const char *exclude_list = NULL;
 const char *ncompress_list = NULL;
 
@@ -155,7 +190,7 @@ static size_t ssi_file_num_lines;
 
 static void print_usage(void)
 {
-  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c] [-f:<filename>] [-m] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>" USAGE_ARG_DEFLATE NEWLINE NEWLINE);
+  printf(" Usage: htmlgen [targetdir] [-s] [-e] [-11] [-nossi] [-ssi:<filename>] [-c] [-f:<filename>] [-m] [-svr:<name>] [-x:<ext_list>] [-xc:<ext_list>" USAGE_ARG_DEFLATE USAGE_ARG_GZIP NEWLINE NEWLINE);
   printf("   targetdir: relative or absolute path to files to convert" NEWLINE);
   printf("   switch -s: toggle processing of subdirectories (default is on)" NEWLINE);
   printf("   switch -e: exclude HTTP header from file (header is created at runtime, default is off)" NEWLINE);
@@ -171,6 +206,10 @@ static void print_usage(void)
 #if MAKEFS_SUPPORT_DEFLATE
   printf("   switch -defl: deflate-compress all non-SSI files (with opt. compr.-level, default=10)" NEWLINE);
   printf("                 ATTENTION: browser has to support \"Content-Encoding: deflate\"!" NEWLINE);
+#endif
+#if MAKEFS_SUPPORT_GZIP
+  printf("   switch -gz: add a gzip-compressed variant \"<name>.gz\" of all non-SSI files (with opt. compr.-level, default=9)" NEWLINE);
+  printf("               served for \"Accept-Encoding: gzip\" if httpd has LWIP_HTTPD_GZIP_VARIANTS enabled" NEWLINE);
 #endif
   printf("   if targetdir not specified, htmlgen will attempt to" NEWLINE);
   printf("   process files in subdirectory 'fs'" NEWLINE);
@@ -247,6 +286,25 @@ int main(int argc, char *argv[])
         printf("Deflating all non-SSI files with level %d (but only if size is reduced)" NEWLINE, deflate_level);
 #else
         printf("WARNING: Deflate support is disabled\n");
+#endif
+      } else if (strstr(argv[i], "-gz") == argv[i]) {
+#if MAKEFS_SUPPORT_GZIP
+        char *colon = strstr(argv[i], ":");
+        if (colon) {
+          if (colon[1] != 0) {
+            int gz_level = atoi(&colon[1]);
+            if ((gz_level >= 1) && (gz_level <= 9)) {
+              gzip_level = gz_level;
+            } else {
+              printf("ERROR: gzip level must be [1..9]" NEWLINE);
+              exit(0);
+            }
+          }
+        }
+        gzipVariants = 1;
+        printf("Adding gzip variants of all non-SSI files with level %d (but only if size is reduced)" NEWLINE, gzip_level);
+#else
+        printf("WARNING: gzip support is disabled\n");
 #endif
       } else if (strstr(argv[i], "-x:") == argv[i]) {
         exclude_list = &argv[i][3];
@@ -336,6 +394,7 @@ int main(int argc, char *argv[])
   fprintf(data_file, NEWLINE NEWLINE);
   fprintf(struct_file, "#define FS_ROOT file_%s" NEWLINE, lastFileVar);
   fprintf(struct_file, "#define FS_NUMFILES %d" NEWLINE NEWLINE, filesProcessed);
+  write_hash_table(struct_file, filesProcessed);
 
   fclose(data_file);
   fclose(struct_file);
@@ -359,12 +418,20 @@ int main(int argc, char *argv[])
     printf("(Deflated total byte reduction: %d bytes -> %d bytes (%.02f%%)" NEWLINE,
            (int)overallDataBytes, (int)deflatedBytesReduced, (float)((deflatedBytesReduced * 100.0) / overallDataBytes));
   }
+#endif
+#if MAKEFS_SUPPORT_GZIP
+  if (gzipVariants && gzipBytesOriginal) {
+    printf("(gzip variants: %d bytes -> %d bytes (%.02f%%)" NEWLINE,
+           (int)gzipBytesOriginal, (int)gzipBytesVariant, (float)((gzipBytesVariant * 100.0) / gzipBytesOriginal));
+  }
 #endif
   printf(NEWLINE);
 
   while (first_file != NULL) {
     struct file_entry *fe = first_file;
     first_file = fe->next;
+    free((void *)fe->filename_c);
+    free((void *)fe->name);
     free(fe);
   }
 
@@ -515,11 +582,12 @@ int process_sub(FILE *data_file, FILE *struct_file)
 
             printf("processing %s/%s..." NEWLINE, curSubdir, curName);
 
-            if (process_file(data_file, struct_file, curName) < 0) {
+            ret = process_file(data_file, struct_file, curName);
+            if (ret < 0) {
               printf(NEWLINE "Error... aborting" NEWLINE);
               return -1;
             }
-            filesProcessed++;
+            filesProcessed += ret;
           }
         }
       }
@@ -627,7 +695,64 @@ static u8_t *get_file_data(const char *filename, int *file_size, int can_be_comp
   return buf;
 }
 
-static void process_file_data(FILE *data_file, u8_t *file_data, size_t file_size)
+#if MAKEFS_SUPPORT_GZIP
+/** gzip-compress file data, returns NULL if that does not reduce the size */
+static u8_t *get_gzip_data(const u8_t *file_data, int file_size, int *gz_size)
+{
+  z_stream strm;
+  uLong bound;
+  u8_t *buf;
+  u8_t *check;
+  int ret;
+
+  memset(&strm, 0, sizeof(strm));
+  /* windowBits 15 + 16: gzip wrapper, mtime 0 so that the output is reproducible */
+  ret = deflateInit2(&strm, gzip_level, Z_DEFLATED, 15 + 16, 9, Z_DEFAULT_STRATEGY);
+  LWIP_ASSERT("deflateInit2 failed", ret == Z_OK);
+  bound = deflateBound(&strm, (uLong)file_size);
+  buf = (u8_t *)malloc(bound);
+  LWIP_ASSERT("buf != NULL", buf != NULL);
+  strm.next_in = (Bytef *)file_data;
+  strm.avail_in = (uInt)file_size;
+  strm.next_out = buf;
+  strm.avail_out = (uInt)bound;
+  ret = deflate(&strm, Z_FINISH);
+  LWIP_ASSERT("deflate failed", ret == Z_STREAM_END);
+  *gz_size = (int)strm.total_out;
+  deflateEnd(&strm);
+
+  if (*gz_size >= file_size) {
+    printf(" - no gzip variant: (would be %d bytes larger)" NEWLINE, *gz_size - file_size);
+    free(buf);
+    return NULL;
+  }
+
+  /* sanity-check compression by inflating and comparing to the original */
+  check = (u8_t *)malloc((size_t)file_size + 1);
+  LWIP_ASSERT("check != NULL", check != NULL);
+  memset(&strm, 0, sizeof(strm));
+  ret = inflateInit2(&strm, 15 + 16);
+  LWIP_ASSERT("inflateInit2 failed", ret == Z_OK);
+  strm.next_in = buf;
+  strm.avail_in = (uInt)*gz_size;
+  strm.next_out = check;
+  strm.avail_out = (uInt)file_size + 1;
+  ret = inflate(&strm, Z_FINISH);
+  LWIP_ASSERT("inflate failed", ret == Z_STREAM_END);
+  LWIP_ASSERT("inflate size mismatch", strm.total_out == (uLong)file_size);
+  LWIP_ASSERT("inflated memcmp failed", !memcmp(check, file_data, (size_t)file_size));
+  inflateEnd(&strm);
+  free(check);
+
+  printf(" - gzip variant: %d bytes -> %d bytes (%.02f%%)" NEWLINE, file_size, *gz_size,
+         (float)((*gz_size * 100.0) / file_size));
+  gzipBytesOriginal += (size_t)file_size;
+  gzipBytesVariant += (size_t)*gz_size;
+  return buf;
+}
+#endif /* MAKEFS_SUPPORT_GZIP */
+
+static void process_file_data(FILE *data_file, const u8_t *file_data, size_t file_size)
 {
   size_t written, i, src_off = 0;
   size_t off = 0;
@@ -655,40 +780,87 @@ static int write_checksums(FILE *struct_file, const char *varname,
                            u16_t hdr_len, u16_t hdr_chksum, const u8_t *file_data, size_t file_size)
 {
   int chunk_size = TCP_MSS;
-  int offset, src_offset;
-  size_t len;
+  size_t offset, len, total = hdr_len + file_size;
+  u8_t *buf;
   int i = 0;
+  LWIP_UNUSED_ARG(hdr_chksum);
 #if LWIP_TCP_TIMESTAMPS
   /* when timestamps are used, usable space is 12 bytes less per segment */
   chunk_size -= 12;
 #endif
 
+  /* The header is stored right in front of the data: checksum both as one
+     stream cut into full segments, so that httpd can send every segment
+     as a single PBUF_ROM reference */
+  buf = (u8_t *)malloc(total + 1);
+  LWIP_ASSERT("buf != NULL", buf != NULL);
+  memcpy(buf, hdr_buf, hdr_len);
+  memcpy(&buf[hdr_len], file_data, file_size);
+
   fprintf(struct_file, "#if HTTPD_PRECALCULATED_CHECKSUM" NEWLINE);
   fprintf(struct_file, "const struct fsdata_chksum chksums_%s[] = {" NEWLINE, varname);
 
-  if (hdr_len > 0) {
-    /* add checksum for HTTP header */
-    fprintf(struct_file, "{%d, 0x%04x, %d}," NEWLINE, 0, hdr_chksum, hdr_len);
-    i++;
-  }
-  src_offset = 0;
-  for (offset = hdr_len; ; offset += len) {
+  for (offset = 0; offset < total; offset += len) {
     unsigned short chksum;
-    const void *data = (const void *)&file_data[src_offset];
-    len = LWIP_MIN(chunk_size, (int)file_size - src_offset);
-    if (len == 0) {
-      break;
-    }
-    chksum = ~inet_chksum(data, (u16_t)len);
-    /* add checksum for data */
-    fprintf(struct_file, "{%d, 0x%04x, %"SZT_F"}," NEWLINE, offset, chksum, len);
+    len = LWIP_MIN((size_t)chunk_size, total - offset);
+    chksum = ~inet_chksum(&buf[offset], (u16_t)len);
+    fprintf(struct_file, "{%"SZT_F", 0x%04x, %"SZT_F"}," NEWLINE, offset, chksum, len);
     i++;
   }
   fprintf(struct_file, "};" NEWLINE);
   fprintf(struct_file, "#endif /* HTTPD_PRECALCULATED_CHECKSUM */" NEWLINE);
+  free(buf);
   return i;
 }
 
+/** Seed a hash of the file names so that every name gets its own slot:
+ * fs_open() then needs one hash and one strcmp() per request instead of a
+ * strcmp() walk over the file list. The hash is FS_HASH_STEP() of fs.h. */
+static void write_hash_table(FILE *struct_file, int num_files)
+{
+  struct file_entry *f;
+  const struct file_entry **slots;
+  u32_t size, seed, h;
+  const char *c;
+  int collision = 1;
+
+  for (size = 1; size < (u32_t)num_files * 2; size <<= 1);
+  for (;;) {
+    slots = (const struct file_entry **)calloc(size, sizeof(*slots));
+    LWIP_ASSERT("slots != NULL", slots != NULL);
+    for (seed = 0; (seed < 0x10000) && collision; seed++) {
+      memset((void *)slots, 0, size * sizeof(*slots));
+      collision = 0;
+      for (f = first_file; (f != NULL) && !collision; f = f->next) {
+        h = FS_HASH_INIT(seed);
+        for (c = f->name; *c; c++) {
+          h = FS_HASH_STEP(h, *c);
+        }
+        h &= size - 1;
+        if (slots[h] != NULL) {
+          collision = 1;
+        } else {
+          slots[h] = f;
+        }
+      }
+    }
+    if (!collision) {
+      break;
+    }
+    free((void *)slots);
+    size <<= 1;
+  }
+
+  fprintf(struct_file, "#define FS_HASH_SEED 0x%04x" NEWLINE, seed - 1);
+  fprintf(struct_file, "#define FS_HASH_SIZE %u" NEWLINE NEWLINE, size);
+  fprintf(struct_file, "static const struct fsdata_file *const fs_hash_table[FS_HASH_SIZE] = {" NEWLINE);
+  for (h = 0; h < size; h++) {
+    fprintf(struct_file, "file_%s," NEWLINE, slots[h] ? slots[h]->filename_c : "NULL");
+  }
+  fprintf(struct_file, "};" NEWLINE);
+  free((void *)slots);
+}
+
 static int is_valid_char_for_c_var(char x)
 {
   if (((x >= 'A') && (x <= 'Z')) ||
@@ -738,10 +910,11 @@ static void fix_filename_for_c(char *qualifiedName, size_t max_len)
   free(new_name);
 }
 
-static void register_filename(const char *qualifiedName)
+static void register_filename(const char *qualifiedName, const char *name)
 {
   struct file_entry *fe = (struct file_entry *)malloc(sizeof(struct file_entry));
   fe->filename_c = strdup(qualifiedName);
+  fe->name = strdup(name);
   fe->next = NULL;
   if (first_file == NULL) {
     first_file = last_file = fe;
@@ -904,28 +1077,79 @@ static int file_can_be_compressed(const char *filename)
 
 int process_file(FILE *data_file, FILE *struct_file, const char *filename)
 {
-  char varname[MAX_PATH_LEN];
-  int i = 0;
   char qualifiedName[MAX_PATH_LEN];
   int file_size;
-  u16_t http_hdr_chksum = 0;
-  u16_t http_hdr_len = 0;
-  int chksum_count = 0;
   u8_t flags = 0;
-  u8_t has_content_len;
   u8_t *file_data;
   int is_ssi;
   int can_be_compressed;
   int is_compressed = 0;
-  int flags_printed;
+  int encoding;
+  int files = 1;
+#if MAKEFS_SUPPORT_GZIP
+  u8_t *gz_data = NULL;
+  int gz_size = 0;
+#endif
 
   /* create qualified name (@todo: prepend slash or not?) */
   sprintf(qualifiedName, "%s/%s", curSubdir, filename);
+
+  is_ssi = is_ssi_file(filename);
+  if (is_ssi) {
+    flags |= FS_FILE_FLAGS_SSI;
+  }
+  can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
+  file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+  encoding = is_compressed ? FILE_ENC_DEFLATE : FILE_ENC_NONE;
+#if MAKEFS_SUPPORT_GZIP
+  if (gzipVariants && can_be_compressed && !is_compressed) {
+    gz_data = get_gzip_data(file_data, file_size, &gz_size);
+    if (gz_data != NULL) {
+      if (strlen(qualifiedName) + 3 >= MAX_PATH_LEN) {
+        printf("File name too long for gzip variant: \"%s\"\n", qualifiedName);
+        exit(-1);
+      }
+      flags |= FS_FILE_FLAGS_HAS_GZIP;
+      encoding |= FILE_ENC_VARY;
+    }
+  }
+#endif
+
+  write_file(data_file, struct_file, filename, qualifiedName, file_data, file_size, flags, encoding);
+  free(file_data);
+
+#if MAKEFS_SUPPORT_GZIP
+  if (gz_data != NULL) {
+    /* the variant is found by the original name + ".gz" and is sent
+       with the content type of the original */
+    strcat(qualifiedName, ".gz");
+    write_file(data_file, struct_file, filename, qualifiedName, gz_data, gz_size,
+               (u8_t)(flags & ~FS_FILE_FLAGS_HAS_GZIP), FILE_ENC_GZIP);
+    free(gz_data);
+    files++;
+  }
+#endif
+  return files;
+}
+
+/** Write one fsdata_file: the data array (name, HTTP header, file data) and its
+ * struct (plus checksums), linked to the previously written file */
+static int write_file(FILE *data_file, FILE *struct_file, const char *filename, const char *qualifiedName,
+                      const u8_t *file_data, int file_size, u8_t flags, int encoding)
+{
+  char varname[MAX_PATH_LEN];
+  int i = 0;
+  u16_t http_hdr_chksum = 0;
+  u16_t http_hdr_len = 0;
+  int chksum_count = 0;
+  u8_t has_content_len;
+  int flags_printed;
+
   /* create C variable name */
   strcpy(varname, qualifiedName);
   /* convert slashes & dots to underscores */
   fix_filename_for_c(varname, MAX_PATH_LEN);
-  register_filename(varname);
+  register_filename(varname, qualifiedName);
 #if ALIGN_PAYLOAD
   /* to force even alignment of array, type 1 */
   fprintf(data_file, "#if FSDATA_FILE_ALIGNMENT==1" NEWLINE);
@@ -945,15 +1169,9 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
 #endif /* ALIGN_PAYLOAD */
   fprintf(data_file, NEWLINE);
 
-  is_ssi = is_ssi_file(filename);
-  if (is_ssi) {
-    flags |= FS_FILE_FLAGS_SSI;
-  }
-  has_content_len = !is_ssi;
-  can_be_compressed = includeHttpHeader && !is_ssi && file_can_be_compressed(filename);
-  file_data = get_file_data(filename, &file_size, can_be_compressed, &is_compressed);
+  has_content_len = !(flags & FS_FILE_FLAGS_SSI);
   if (includeHttpHeader) {
-    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len, is_compressed);
+    file_write_http_header(data_file, filename, file_size, &http_hdr_len, &http_hdr_chksum, has_content_len, encoding);
     flags |= FS_FILE_FLAGS_HEADER_INCLUDED;
     if (has_content_len) {
       flags |= FS_FILE_FLAGS_HEADER_PERSISTENT;
@@ -999,6 +1217,13 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
     fputs("FS_FILE_FLAGS_SSI", struct_file);
     flags_printed = 1;
   }
+  if (flags & FS_FILE_FLAGS_HAS_GZIP) {
+    if (flags_printed) {
+      fputs(" | ", struct_file);
+    }
+    fputs("FS_FILE_FLAGS_HAS_GZIP", struct_file);
+    flags_printed = 1;
+  }
   if (!flags_printed) {
     fputs("0", struct_file);
   }
@@ -1016,12 +1241,11 @@ int process_file(FILE *data_file, FILE *struct_file, const char *filename)
   fprintf(data_file, NEWLINE "/* raw file data (%d bytes) */" NEWLINE, file_size);
   process_file_data(data_file, file_data, file_size);
   fprintf(data_file, "};" NEWLINE NEWLINE);
-  free(file_data);
   return 0;
 }
 
 int file_write_http_header(FILE *data_file, const char *filename, int file_size, u16_t *http_hdr_len,
-                           u16_t *http_hdr_chksum, u8_t provide_content_len, int is_compressed)
+                           u16_t *http_hdr_chksum, u8_t provide_content_len, int encoding)
 {
   int i = 0;
   int response_type = HTTP_HDR_OK;
@@ -1184,19 +1408,34 @@ int file_write_http_header(FILE *data_file, const char *filename, int file_size,
     }
   }
 
-#if MAKEFS_SUPPORT_DEFLATE
-  if (is_compressed) {
-    /* tell the client about the deflate encoding */
-    LWIP_ASSERT("error", deflateNonSsiFiles);
-    cur_string = "Content-Encoding: deflate\r\n";
+  if ((encoding & FILE_ENC_MASK) != FILE_ENC_NONE) {
+    /* tell the client about the deflate/gzip encoding */
+    if ((encoding & FILE_ENC_MASK) == FILE_ENC_DEFLATE) {
+      cur_string = "Content-Encoding: deflate\r\n";
+    } else {
+      cur_string = "Content-Encoding: gzip\r\n";
+    }
     cur_len = strlen(cur_string);
-    fprintf(data_file, NEWLINE "/* \"%s\" (%d bytes) */" NEWLINE, cur_string, cur_len);
+    fprintf(data_file, NEWLINE "/* \"%s\" (%"SZT_F" bytes) */" NEWLINE, cur_string, cur_len);
     written += file_put_ascii(data_file, cur_string, cur_len, &i);
     i = 0;
+    if (precalcChksum) {
+      memcpy(&hdr_buf[hdr_len], cur_string, cur_len);
+      hdr_len += cur_len;
+    }
+  }
+  if ((encoding & FILE_ENC_VARY) || ((encoding & FILE_ENC_MASK) == FILE_ENC_GZIP)) {
+    /* original and gzip variant share the URL: tell caches to key on Accept-Encoding */
+    cur_string = "Vary: Accept-Encoding\r\n";
+    cur_len = strlen(cur_string);
+    fprintf(data_file, NEWLINE "/* \"%s\" (%"SZT_F" bytes) */" NEWLINE, cur_string, cur_len);
+    written += file_put_ascii(data_file, cur_string, cur_len, &i);
+    i = 0;
+    if (precalcChksum) {
+      memcpy(&hdr_buf[hdr_len], cur_string, cur_len);
+      hdr_len += cur_len;
+    }
   }
-#else
-  LWIP_UNUSED_ARG(is_compressed);
-#endif
 
   /* write content-type, ATTENTION: this includes the double-CRLF! */
   cur_string = file_type;
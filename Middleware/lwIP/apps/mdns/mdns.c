@@ -16,9 +16,7 @@
  * - Tiebreaking for simultaneous probing
  * - Sending goodbye messages (zero ttl) - shutdown, DHCP lease about to expire, DHCP turned off...
  * - Checking that source address of unicast requests are on the same network
- * - Limiting multicast responses to 1 per second per resource record
  * - Fragmenting replies if required
- * - Handling multi-packet known answers
  * - Individual known answer detection for all local IPv6 addresses
  * - Dynamic size of outgoing packet
  */
@@ -64,6 +62,7 @@
 #include "lwip/prot/dns.h"
 #include "lwip/prot/iana.h"
 #include "lwip/timeouts.h"
+#include "lwip/sys.h"
 
 #include <string.h>
 
@@ -152,6 +151,16 @@ static mdns_name_result_cb_t mdns_name_result_cb;
 #define MDNS_PROBING_ONGOING      1
 #define MDNS_PROBING_COMPLETE     2
 
+/* A record is multicast at most once per second (RFC 6762 section 6) */
+#define MDNS_MULTICAST_INTERVAL_MS  1000
+/* Wait for the rest of a truncated known answer list (RFC 6762 section 7.2) */
+#define MDNS_KNOWN_ANSWER_DELAY_MS  400
+#ifdef LWIP_RAND
+#define MDNS_KNOWN_ANSWER_JITTER_MS (LWIP_RAND() % 100)
+#else
+#define MDNS_KNOWN_ANSWER_JITTER_MS 50
+#endif
+
 static const char *dnssd_protos[] = {
   "_udp", /* DNSSD_PROTO_UDP */
   "_tcp", /* DNSSD_PROTO_TCP */
@@ -175,8 +184,37 @@ struct mdns_service {
   u16_t proto;
   /** Port of the service */
   u16_t port;
+  /** sys_now() when the records of the REPLY_SERVICE_* bits were last
+   *  multicast, valid if the bit is set in mcast_valid */
+  u32_t mcast_time[4];
+  u8_t mcast_valid;
+};
+
+#if MDNS_REPLY_CACHE_SIZE
+/** What a reply was built from, the same key gives the same reply */
+struct mdns_reply_key {
+#if LWIP_IPV4
+  ip4_addr_t addr;
+#endif
+  u8_t host_replies;
+  u8_t host_reverse_v6_replies;
+  u8_t host_known;
+  u8_t cache_flush;
+  u8_t serv_replies[MDNS_MAX_SERVICES];
+  u8_t serv_known[MDNS_MAX_SERVICES];
 };
 
+/** A reply kept encoded, header included */
+struct mdns_cached_reply {
+  struct mdns_reply_key key;
+  /** DNS message, NULL if the slot is free */
+  u8_t *data;
+  u16_t len;
+  /** mdns_host.reply_clock when last sent */
+  u32_t used;
+};
+#endif /* MDNS_REPLY_CACHE_SIZE */
+
 /** Description of a host/netif */
 struct mdns_host {
   /** Hostname */
@@ -189,6 +227,16 @@ struct mdns_host {
   u8_t probes_sent;
   /** State in probing sequence */
   u8_t probing_state;
+  /** sys_now() when the records of the REPLY_HOST_* bits were last
+   *  multicast, valid if the bit is set in mcast_valid */
+  u32_t mcast_time[4];
+  u8_t mcast_valid;
+  /** Reply to a truncated query, waiting for the rest of its known answers */
+  struct mdns_outpacket *delayed;
+#if MDNS_REPLY_CACHE_SIZE
+  struct mdns_cached_reply replies[MDNS_REPLY_CACHE_SIZE];
+  u32_t reply_clock;
+#endif
 };
 
 /** Information about received packet */
@@ -217,6 +265,10 @@ struct mdns_packet {
   u16_t answers;
   /** Number of unparsed answers */
   u16_t answers_left;
+  /** TC set, more known answers follow in the next packets */
+  u8_t truncated;
+  /** Authority section present, a probe from another host */
+  u8_t probe_query;
 };
 
 /** Information about outgoing packet */
@@ -256,6 +308,10 @@ struct mdns_outpacket {
   u8_t host_reverse_v6_replies;
   /* Reply bitmask per service */
   u8_t serv_replies[MDNS_MAX_SERVICES];
+  /* Bitmask for host records the querier knows, not sent as additional */
+  u8_t host_known;
+  /* Bitmask per service of records the querier knows */
+  u8_t serv_known[MDNS_MAX_SERVICES];
 };
 
 /** Domain, type and class.
@@ -286,6 +342,7 @@ struct mdns_answer {
 
 static err_t mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags);
 static void mdns_probe(void* arg);
+static void mdns_delayed_reply(void *arg);
 
 static err_t
 mdns_domain_add_label_base(struct mdns_domain *domain, u8_t len)
@@ -1298,6 +1355,225 @@ mdns_init_outpacket(struct mdns_outpacket *out, struct mdns_packet *in)
   }
 }
 
+/**
+ * Drop the records multicast less than MDNS_MULTICAST_INTERVAL_MS ago
+ * @param bits Reply bitmask, the 4 records from bit shift on
+ * @param shift 0 for REPLY_HOST_*, 4 for REPLY_SERVICE_*
+ * @param mcast_time When each of the 4 records was multicast
+ * @param mcast_valid Which of mcast_time are set
+ * @param now sys_now()
+ * @return The bits of the records to send
+ */
+static u8_t
+mdns_mcast_limit(u8_t bits, u8_t shift, const u32_t *mcast_time, u8_t mcast_valid, u32_t now)
+{
+  u8_t i;
+  for (i = 0; i < 4; i++) {
+    u8_t bit = (u8_t)(1 << (i + shift));
+    if ((bits & bit) && (mcast_valid & (1 << i)) &&
+        (u32_t)(now - mcast_time[i]) < MDNS_MULTICAST_INTERVAL_MS) {
+      bits = (u8_t)(bits & ~bit);
+    }
+  }
+  return bits;
+}
+
+/**
+ * Note the time the records of bits were multicast
+ * @see mdns_mcast_limit
+ */
+static void
+mdns_mcast_mark(u8_t bits, u8_t shift, u32_t *mcast_time, u8_t *mcast_valid, u32_t now)
+{
+  u8_t i;
+  for (i = 0; i < 4; i++) {
+    if (bits & (1 << (i + shift))) {
+      mcast_time[i] = now;
+      *mcast_valid |= (u8_t)(1 << i);
+    }
+  }
+}
+
+/**
+ * Remove the answers multicast within the last MDNS_MULTICAST_INTERVAL_MS
+ * from a reply that will be multicast
+ */
+static void
+mdns_limit_outpacket(struct mdns_outpacket *outpkt)
+{
+  struct mdns_host *mdns = NETIF_TO_HOST(outpkt->netif);
+  u32_t now = sys_now();
+  int i;
+
+  outpkt->host_replies = mdns_mcast_limit(outpkt->host_replies, 0, mdns->mcast_time, mdns->mcast_valid, now);
+  for (i = 0; i < MDNS_MAX_SERVICES; i++) {
+    struct mdns_service *service = mdns->services[i];
+    if (service) {
+      outpkt->serv_replies[i] = mdns_mcast_limit(outpkt->serv_replies[i], 4, service->mcast_time, service->mcast_valid, now);
+    }
+  }
+}
+
+/**
+ * Check if a reply has any answer selected
+ */
+static int
+mdns_outpacket_has_replies(struct mdns_outpacket *outpkt)
+{
+  int i;
+
+  if (outpkt->host_replies) {
+    return 1;
+  }
+  for (i = 0; i < MDNS_MAX_SERVICES; i++) {
+    if (outpkt->serv_replies[i]) {
+      return 1;
+    }
+  }
+  return 0;
+}
+
+/**
+ * Send a packet unicast or to the multicast group, the answers of a multicast
+ * response count for the rate limit.
+ */
+static err_t
+mdns_sendto(struct mdns_outpacket *outpkt, struct pbuf *p, u8_t flags)
+{
+  const ip_addr_t *mcast_destaddr;
+  struct mdns_host *mdns;
+  u32_t now;
+  err_t res;
+  int i;
+
+  LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Sending packet, len=%d, unicast=%d\n", p->tot_len, outpkt->unicast_reply));
+  if (outpkt->unicast_reply) {
+    return udp_sendto_if(mdns_pcb, p, &outpkt->dest_addr, outpkt->dest_port, outpkt->netif);
+  }
+
+  if (IP_IS_V6_VAL(outpkt->dest_addr)) {
+#if LWIP_IPV6
+    mcast_destaddr = &v6group;
+#endif
+  } else {
+#if LWIP_IPV4
+    mcast_destaddr = &v4group;
+#endif
+  }
+  res = udp_sendto_if(mdns_pcb, p, mcast_destaddr, LWIP_IANA_PORT_MDNS, outpkt->netif);
+  if (res != ERR_OK || !(flags & DNS_FLAG1_RESPONSE)) {
+    return res;
+  }
+
+  mdns = NETIF_TO_HOST(outpkt->netif);
+  now = sys_now();
+  mdns_mcast_mark(outpkt->host_replies, 0, mdns->mcast_time, &mdns->mcast_valid, now);
+  for (i = 0; i < MDNS_MAX_SERVICES; i++) {
+    struct mdns_service *service = mdns->services[i];
+    if (service) {
+      mdns_mcast_mark(outpkt->serv_replies[i], 4, service->mcast_time, &service->mcast_valid, now);
+    }
+  }
+  return ERR_OK;
+}
+
+#if MDNS_REPLY_CACHE_SIZE
+/**
+ * Look up the reply built for the records selected in outpkt
+ * @return The reply, or the slot to keep it in once built (data NULL)
+ */
+static struct mdns_cached_reply *
+mdns_reply_cache_get(struct mdns_host *mdns, struct mdns_outpacket *outpkt, struct mdns_reply_key *key)
+{
+  struct mdns_cached_reply *oldest = NULL;
+  int i;
+
+  memset(key, 0, sizeof(*key));
+#if LWIP_IPV4
+  ip4_addr_copy(key->addr, *netif_ip4_addr(outpkt->netif));
+#endif
+  key->host_replies = outpkt->host_replies;
+  key->host_reverse_v6_replies = outpkt->host_reverse_v6_replies;
+  key->host_known = outpkt->host_known;
+  key->cache_flush = outpkt->cache_flush;
+  MEMCPY(key->serv_replies, outpkt->serv_replies, sizeof(key->serv_replies));
+  MEMCPY(key->serv_known, outpkt->serv_known, sizeof(key->serv_known));
+
+  mdns->reply_clock++;
+  for (i = 0; i < MDNS_REPLY_CACHE_SIZE; i++) {
+    struct mdns_cached_reply *cached = &mdns->replies[i];
+    if (cached->data != NULL && memcmp(&cached->key, key, sizeof(*key)) == 0) {
+      cached->used = mdns->reply_clock;
+      return cached;
+    }
+    if (oldest == NULL || cached->data == NULL ||
+        (oldest->data != NULL && (u32_t)(mdns->reply_clock - cached->used) > (u32_t)(mdns->reply_clock - oldest->used))) {
+      oldest = cached;
+    }
+  }
+
+  if (oldest->data != NULL) {
+    mem_free(oldest->data);
+    oldest->data = NULL;
+  }
+  return oldest;
+}
+
+/**
+ * Keep a copy of a reply just built
+ */
+static void
+mdns_reply_cache_put(struct mdns_host *mdns, struct mdns_cached_reply *cached,
+                     const struct mdns_reply_key *key, struct pbuf *p)
+{
+  cached->data = (u8_t *)mem_malloc(p->tot_len);
+  if (cached->data == NULL) {
+    return;
+  }
+  pbuf_copy_partial(p, cached->data, p->tot_len, 0);
+  cached->len = p->tot_len;
+  cached->key = *key;
+  cached->used = mdns->reply_clock;
+}
+
+/**
+ * Send a kept reply, referenced by the pbuf instead of copied
+ */
+static err_t
+mdns_reply_cache_send(struct mdns_outpacket *outpkt, struct mdns_cached_reply *cached, u8_t flags)
+{
+  struct pbuf *p;
+  err_t res;
+
+  p = pbuf_alloc_reference(cached->data, cached->len, PBUF_REF);
+  if (p == NULL) {
+    return ERR_MEM;
+  }
+  LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Sending kept reply\n"));
+  res = mdns_sendto(outpkt, p, flags);
+  pbuf_free(p);
+  return res;
+}
+
+/**
+ * Drop the kept replies, called when a record changes
+ */
+static void
+mdns_reply_cache_clear(struct mdns_host *mdns)
+{
+  int i;
+
+  for (i = 0; i < MDNS_REPLY_CACHE_SIZE; i++) {
+    if (mdns->replies[i].data != NULL) {
+      mem_free(mdns->replies[i].data);
+      mdns->replies[i].data = NULL;
+    }
+  }
+}
+#else /* MDNS_REPLY_CACHE_SIZE */
+#define mdns_reply_cache_clear(mdns)
+#endif /* MDNS_REPLY_CACHE_SIZE */
+
 /**
  * Send chosen answers as a reply
  *
@@ -1313,6 +1589,20 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
   int i;
   struct mdns_host *mdns = NETIF_TO_HOST(outpkt->netif);
   u16_t answers = 0;
+#if MDNS_REPLY_CACHE_SIZE
+  struct mdns_cached_reply *cached = NULL;
+  struct mdns_reply_key key;
+
+  /* Replies without a question or transaction id depend on the records only */
+  if (outpkt->pbuf == NULL && !outpkt->legacy_query && outpkt->tx_id == 0 &&
+      flags == (DNS_FLAG1_RESPONSE | DNS_FLAG1_AUTHORATIVE) &&
+      mdns_outpacket_has_replies(outpkt)) {
+    cached = mdns_reply_cache_get(mdns, outpkt, &key);
+    if (cached->data != NULL) {
+      return mdns_reply_cache_send(outpkt, cached, flags);
+    }
+  }
+#endif
 
   /* Write answers to host questions */
 #if LWIP_IPV4
@@ -1418,7 +1708,7 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
     if (outpkt->serv_replies[i] & REPLY_SERVICE_NAME_PTR) {
       /* Our service instance requested, include SRV & TXT
        * if they are already not requested. */
-      if (!(outpkt->serv_replies[i] & REPLY_SERVICE_SRV)) {
+      if (!((outpkt->serv_replies[i] | outpkt->serv_known[i]) & REPLY_SERVICE_SRV)) {
         res = mdns_add_srv_answer(outpkt, outpkt->cache_flush, mdns, service);
         if (res != ERR_OK) {
           goto cleanup;
@@ -1426,7 +1716,7 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
         outpkt->additional++;
       }
 
-      if (!(outpkt->serv_replies[i] & REPLY_SERVICE_TXT)) {
+      if (!((outpkt->serv_replies[i] | outpkt->serv_known[i]) & REPLY_SERVICE_TXT)) {
         res = mdns_add_txt_answer(outpkt, outpkt->cache_flush, service);
         if (res != ERR_OK) {
           goto cleanup;
@@ -1441,7 +1731,7 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
     if ((outpkt->serv_replies[i] & (REPLY_SERVICE_NAME_PTR | REPLY_SERVICE_SRV)) ||
         (outpkt->host_replies & (REPLY_HOST_A | REPLY_HOST_AAAA))) {
 #if LWIP_IPV6
-      if (!(outpkt->host_replies & REPLY_HOST_AAAA)) {
+      if (!((outpkt->host_replies | outpkt->host_known) & REPLY_HOST_AAAA)) {
         int addrindex;
         for (addrindex = 0; addrindex < LWIP_IPV6_NUM_ADDRESSES; addrindex++) {
           if (ip6_addr_isvalid(netif_ip6_addr_state(outpkt->netif, addrindex))) {
@@ -1455,7 +1745,7 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
       }
 #endif
 #if LWIP_IPV4
-      if (!(outpkt->host_replies & REPLY_HOST_A) &&
+      if (!((outpkt->host_replies | outpkt->host_known) & REPLY_HOST_A) &&
           !ip4_addr_isany_val(*netif_ip4_addr(outpkt->netif))) {
         res = mdns_add_a_answer(outpkt, outpkt->cache_flush, outpkt->netif);
         if (res != ERR_OK) {
@@ -1468,7 +1758,6 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
   }
 
   if (outpkt->pbuf) {
-    const ip_addr_t *mcast_destaddr;
     struct dns_hdr hdr;
 
     /* Write header */
@@ -1484,22 +1773,14 @@ mdns_send_outpacket(struct mdns_outpacket *outpkt, u8_t flags)
     /* Shrink packet */
     pbuf_realloc(outpkt->pbuf, outpkt->write_offset);
 
-    if (IP_IS_V6_VAL(outpkt->dest_addr)) {
-#if LWIP_IPV6
-      mcast_destaddr = &v6group;
-#endif
-    } else {
-#if LWIP_IPV4
-      mcast_destaddr = &v4group;
-#endif
+#if MDNS_REPLY_CACHE_SIZE
+    if (cached != NULL) {
+      mdns_reply_cache_put(mdns, cached, &key, outpkt->pbuf);
     }
+#endif
+
     /* Send created packet */
-    LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Sending packet, len=%d, unicast=%d\n", outpkt->write_offset, outpkt->unicast_reply));
-    if (outpkt->unicast_reply) {
-      res = udp_sendto_if(mdns_pcb, outpkt->pbuf, &outpkt->dest_addr, outpkt->dest_port, outpkt->netif);
-    } else {
-      res = udp_sendto_if(mdns_pcb, outpkt->pbuf, mcast_destaddr, LWIP_IANA_PORT_MDNS, outpkt->netif);
-    }
+    res = mdns_sendto(outpkt, outpkt->pbuf, flags);
   }
 
 cleanup:
@@ -1553,70 +1834,21 @@ mdns_announce(struct netif *netif, const ip_addr_t *destination)
 }
 
 /**
- * Handle question MDNS packet
- * 1. Parse all questions and set bits what answers to send
- * 2. Clear pending answers if known answers are supplied
- * 3. Put chosen answers in new packet and send as reply
+ * Clear pending answers the querier already has, and note the records
+ * it knows so they are not sent as additional records either
+ * (RFC 6762 section 7.1)
+ * @param pkt The query, parsed up to the answers
+ * @param reply The reply to the query
+ * @return ERR_OK if all known answers were read, an err_t otherwise
  */
-static void
-mdns_handle_question(struct mdns_packet *pkt)
+static err_t
+mdns_handle_known_answers(struct mdns_packet *pkt, struct mdns_outpacket *reply)
 {
   struct mdns_service *service;
-  struct mdns_outpacket reply;
-  int replies = 0;
   int i;
   err_t res;
   struct mdns_host *mdns = NETIF_TO_HOST(pkt->netif);
 
-  if (mdns->probing_state != MDNS_PROBING_COMPLETE) {
-    /* Don't answer questions until we've verified our domains via probing */
-    /* @todo we should check incoming questions during probing for tiebreaking */
-    return;
-  }
-
-  mdns_init_outpacket(&reply, pkt);
-
-  while (pkt->questions_left) {
-    struct mdns_question q;
-
-    res = mdns_read_question(pkt, &q);
-    if (res != ERR_OK) {
-      LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Failed to parse question, skipping query packet\n"));
-      return;
-    }
-
-    LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Query for domain "));
-    mdns_domain_debug_print(&q.info.domain);
-    LWIP_DEBUGF(MDNS_DEBUG, (" type %d class %d\n", q.info.type, q.info.klass));
-
-    if (q.unicast) {
-      /* Reply unicast if any question is unicast */
-      reply.unicast_reply = 1;
-    }
-
-    reply.host_replies |= check_host(pkt->netif, &q.info, &reply.host_reverse_v6_replies);
-    replies |= reply.host_replies;
-
-    for (i = 0; i < MDNS_MAX_SERVICES; i++) {
-      service = mdns->services[i];
-      if (!service) {
-        continue;
-      }
-      reply.serv_replies[i] |= check_service(service, &q.info);
-      replies |= reply.serv_replies[i];
-    }
-
-    if (replies && reply.legacy_query) {
-      /* Add question to reply packet (legacy packet only has 1 question) */
-      res = mdns_add_question(&reply, &q.info.domain, q.info.type, q.info.klass, 0);
-      reply.questions = 1;
-      if (res != ERR_OK) {
-        goto cleanup;
-      }
-    }
-  }
-
-  /* Handle known answers */
   while (pkt->answers_left) {
     struct mdns_answer ans;
     u8_t rev_v6;
@@ -1625,7 +1857,7 @@ mdns_handle_question(struct mdns_packet *pkt)
     res = mdns_read_answer(pkt, &ans);
     if (res != ERR_OK) {
       LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Failed to parse answer, skipping query packet\n"));
-      goto cleanup;
+      return res;
     }
 
     LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Known answer for domain "));
@@ -1639,11 +1871,12 @@ mdns_handle_question(struct mdns_packet *pkt)
     }
 
     rev_v6 = 0;
-    match = reply.host_replies & check_host(pkt->netif, &ans.info, &rev_v6);
+    match = check_host(pkt->netif, &ans.info, &rev_v6);
     if (match && (ans.ttl > (mdns->dns_ttl / 2))) {
-      /* The RR in the known answer matches an RR we are planning to send,
+      /* The RR in the known answer matches one of our RRs,
        * and the TTL is less than half gone.
-       * If the payload matches we should not send that answer.
+       * If the payload matches we should not send that answer,
+       * neither as an additional record.
        */
       if (ans.info.type == DNS_RRTYPE_PTR) {
         /* Read domain and compare */
@@ -1655,15 +1888,15 @@ mdns_handle_question(struct mdns_packet *pkt)
 #if LWIP_IPV4
           if (match & REPLY_HOST_PTR_V4) {
             LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: v4 PTR\n"));
-            reply.host_replies &= ~REPLY_HOST_PTR_V4;
+            reply->host_replies &= ~REPLY_HOST_PTR_V4;
           }
 #endif
 #if LWIP_IPV6
           if (match & REPLY_HOST_PTR_V6) {
             LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: v6 PTR\n"));
-            reply.host_reverse_v6_replies &= ~rev_v6;
-            if (reply.host_reverse_v6_replies == 0) {
-              reply.host_replies &= ~REPLY_HOST_PTR_V6;
+            reply->host_reverse_v6_replies &= ~rev_v6;
+            if (reply->host_reverse_v6_replies == 0) {
+              reply->host_replies &= ~REPLY_HOST_PTR_V6;
             }
           }
 #endif
@@ -1673,7 +1906,8 @@ mdns_handle_question(struct mdns_packet *pkt)
         if (ans.rd_length == sizeof(ip4_addr_t) &&
             pbuf_memcmp(pkt->pbuf, ans.rd_offset, netif_ip4_addr(pkt->netif), ans.rd_length) == 0) {
           LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: A\n"));
-          reply.host_replies &= ~REPLY_HOST_A;
+          reply->host_replies &= ~REPLY_HOST_A;
+          reply->host_known |= REPLY_HOST_A;
         }
 #endif
       } else if (match & REPLY_HOST_AAAA) {
@@ -1682,7 +1916,8 @@ mdns_handle_question(struct mdns_packet *pkt)
             /* TODO this clears all AAAA responses if first addr is set as known */
             pbuf_memcmp(pkt->pbuf, ans.rd_offset, netif_ip6_addr(pkt->netif, 0), ans.rd_length) == 0) {
           LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: AAAA\n"));
-          reply.host_replies &= ~REPLY_HOST_AAAA;
+          reply->host_replies &= ~REPLY_HOST_AAAA;
+          reply->host_known |= REPLY_HOST_AAAA;
         }
 #endif
       }
@@ -1693,11 +1928,12 @@ mdns_handle_question(struct mdns_packet *pkt)
       if (!service) {
         continue;
       }
-      match = reply.serv_replies[i] & check_service(service, &ans.info);
+      match = check_service(service, &ans.info);
       if (match && (ans.ttl > (service->dns_ttl / 2))) {
-        /* The RR in the known answer matches an RR we are planning to send,
+        /* The RR in the known answer matches one of our RRs,
          * and the TTL is less than half gone.
-         * If the payload matches we should not send that answer.
+         * If the payload matches we should not send that answer,
+         * neither as an additional record.
          */
         if (ans.info.type == DNS_RRTYPE_PTR) {
           /* Read domain and compare */
@@ -1709,14 +1945,14 @@ mdns_handle_question(struct mdns_packet *pkt)
               res = mdns_build_service_domain(&my_ans, service, 0);
               if (res == ERR_OK && mdns_domain_eq(&known_ans, &my_ans)) {
                 LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: service type PTR\n"));
-                reply.serv_replies[i] &= ~REPLY_SERVICE_TYPE_PTR;
+                reply->serv_replies[i] &= ~REPLY_SERVICE_TYPE_PTR;
               }
             }
             if (match & REPLY_SERVICE_NAME_PTR) {
               res = mdns_build_service_domain(&my_ans, service, 1);
               if (res == ERR_OK && mdns_domain_eq(&known_ans, &my_ans)) {
                 LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: service name PTR\n"));
-                reply.serv_replies[i] &= ~REPLY_SERVICE_NAME_PTR;
+                reply->serv_replies[i] &= ~REPLY_SERVICE_NAME_PTR;
               }
             }
           }
@@ -1751,21 +1987,163 @@ mdns_handle_question(struct mdns_packet *pkt)
               break;
             }
             LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: SRV\n"));
-            reply.serv_replies[i] &= ~REPLY_SERVICE_SRV;
+            reply->serv_replies[i] &= ~REPLY_SERVICE_SRV;
+            reply->serv_known[i] |= REPLY_SERVICE_SRV;
           } while (0);
         } else if (match & REPLY_SERVICE_TXT) {
           mdns_prepare_txtdata(service);
           if (service->txtdata.length == ans.rd_length &&
               pbuf_memcmp(pkt->pbuf, ans.rd_offset, service->txtdata.name, ans.rd_length) == 0) {
             LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Skipping known answer: TXT\n"));
-            reply.serv_replies[i] &= ~REPLY_SERVICE_TXT;
+            reply->serv_replies[i] &= ~REPLY_SERVICE_TXT;
+            reply->serv_known[i] |= REPLY_SERVICE_TXT;
           }
         }
       }
     }
   }
 
-  mdns_send_outpacket(&reply, DNS_FLAG1_RESPONSE | DNS_FLAG1_AUTHORATIVE);
+  return ERR_OK;
+}
+
+/**
+ * Send a reply to questions. A multicast reply leaves out the answers
+ * multicast within the last second, unless it answers a probe
+ * (RFC 6762 section 6).
+ */
+static void
+mdns_send_reply(struct mdns_outpacket *reply, u8_t probe_query)
+{
+  if (!reply->unicast_reply && !probe_query) {
+    mdns_limit_outpacket(reply);
+  }
+  mdns_send_outpacket(reply, DNS_FLAG1_RESPONSE | DNS_FLAG1_AUTHORATIVE);
+}
+
+/**
+ * Timer callback sending the reply to a truncated query
+ */
+static void
+mdns_delayed_reply(void *arg)
+{
+  struct netif *netif = (struct netif *)arg;
+  struct mdns_host *mdns = NETIF_TO_HOST(netif);
+  struct mdns_outpacket *reply = mdns->delayed;
+
+  mdns->delayed = NULL;
+  mdns_send_reply(reply, 0);
+  mem_free(reply);
+}
+
+/**
+ * Drop the reply waiting for more known answers
+ */
+static void
+mdns_drop_delayed_reply(struct netif *netif)
+{
+  struct mdns_host *mdns = NETIF_TO_HOST(netif);
+
+  if (mdns->delayed != NULL) {
+    sys_untimeout(mdns_delayed_reply, netif);
+    mem_free(mdns->delayed);
+    mdns->delayed = NULL;
+  }
+}
+
+/**
+ * Handle question MDNS packet
+ * 1. Parse all questions and set bits what answers to send
+ * 2. Clear pending answers if known answers are supplied
+ * 3. Put chosen answers in new packet and send as reply, or wait for the
+ *    rest of the known answers if the query is truncated
+ */
+static void
+mdns_handle_question(struct mdns_packet *pkt)
+{
+  struct mdns_service *service;
+  struct mdns_outpacket reply;
+  int replies = 0;
+  int i;
+  err_t res;
+  struct mdns_host *mdns = NETIF_TO_HOST(pkt->netif);
+
+  if (mdns->probing_state != MDNS_PROBING_COMPLETE) {
+    /* Don't answer questions until we've verified our domains via probing */
+    /* @todo we should check incoming questions during probing for tiebreaking */
+    return;
+  }
+
+  if (mdns->delayed != NULL && pkt->questions == 0 &&
+      pkt->source_port == mdns->delayed->dest_port &&
+      ip_addr_cmp(&pkt->source_addr, &mdns->delayed->dest_addr)) {
+    /* Known answers continuing a truncated query (RFC 6762 section 7.2) */
+    mdns_handle_known_answers(pkt, mdns->delayed);
+    if (pkt->truncated) {
+      sys_untimeout(mdns_delayed_reply, pkt->netif);
+      sys_timeout(MDNS_KNOWN_ANSWER_DELAY_MS + MDNS_KNOWN_ANSWER_JITTER_MS, mdns_delayed_reply, pkt->netif);
+    }
+    return;
+  }
+
+  mdns_init_outpacket(&reply, pkt);
+
+  while (pkt->questions_left) {
+    struct mdns_question q;
+
+    res = mdns_read_question(pkt, &q);
+    if (res != ERR_OK) {
+      LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Failed to parse question, skipping query packet\n"));
+      return;
+    }
+
+    LWIP_DEBUGF(MDNS_DEBUG, ("MDNS: Query for domain "));
+    mdns_domain_debug_print(&q.info.domain);
+    LWIP_DEBUGF(MDNS_DEBUG, (" type %d class %d\n", q.info.type, q.info.klass));
+
+    if (q.unicast) {
+      /* Reply unicast if any question is unicast */
+      reply.unicast_reply = 1;
+    }
+
+    reply.host_replies |= check_host(pkt->netif, &q.info, &reply.host_reverse_v6_replies);
+    replies |= reply.host_replies;
+
+    for (i = 0; i < MDNS_MAX_SERVICES; i++) {
+      service = mdns->services[i];
+      if (!service) {
+        continue;
+      }
+      reply.serv_replies[i] |= check_service(service, &q.info);
+      replies |= reply.serv_replies[i];
+    }
+
+    if (replies && reply.legacy_query) {
+      /* Add question to reply packet (legacy packet only has 1 question) */
+      res = mdns_add_question(&reply, &q.info.domain, q.info.type, q.info.klass, 0);
+      reply.questions = 1;
+      if (res != ERR_OK) {
+        goto cleanup;
+      }
+    }
+  }
+
+  res = mdns_handle_known_answers(pkt, &reply);
+  if (res != ERR_OK) {
+    goto cleanup;
+  }
+
+  if (pkt->truncated && !reply.legacy_query && !pkt->probe_query &&
+      mdns->delayed == NULL && mdns_outpacket_has_replies(&reply)) {
+    /* Wait for the known answers in the next packets */
+    mdns->delayed = (struct mdns_outpacket *)mem_malloc(sizeof(struct mdns_outpacket));
+    if (mdns->delayed != NULL) {
+      SMEMCPY(mdns->delayed, &reply, sizeof(reply));
+      sys_timeout(MDNS_KNOWN_ANSWER_DELAY_MS + MDNS_KNOWN_ANSWER_JITTER_MS, mdns_delayed_reply, pkt->netif);
+      return;
+    }
+  }
+
+  mdns_send_reply(&reply, pkt->probe_query);
 
 cleanup:
   if (reply.pbuf) {
@@ -1887,6 +2265,8 @@ mdns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
   packet.tx_id = lwip_ntohs(hdr.id);
   packet.questions = packet.questions_left = lwip_ntohs(hdr.numquestions);
   packet.answers = packet.answers_left = lwip_ntohs(hdr.numanswers) + lwip_ntohs(hdr.numauthrr) + lwip_ntohs(hdr.numextrarr);
+  packet.truncated = (hdr.flags1 & DNS_FLAG1_TRUNC) ? 1 : 0;
+  packet.probe_query = hdr.numauthrr ? 1 : 0;
 
 #if LWIP_IPV6
   if (IP_IS_V6(ip_current_dest_addr())) {
@@ -2122,6 +2502,8 @@ mdns_resp_remove_netif(struct netif *netif)
   if (mdns->probing_state == MDNS_PROBING_ONGOING) {
     sys_untimeout(mdns_probe, netif);
   }
+  mdns_drop_delayed_reply(netif);
+  mdns_reply_cache_clear(mdns);
 
   for (i = 0; i < MDNS_MAX_SERVICES; i++) {
     struct mdns_service *service = mdns->services[i];
@@ -2184,7 +2566,8 @@ mdns_resp_rename_netif(struct netif *netif, const char *hostname)
  * @param port The port the service listens to
  * @param dns_ttl Validity time in seconds to send out for service data in DNS replies
  * @param txt_fn Callback to get TXT data. Will be called each time a TXT reply is created to
- *               allow dynamic replies.
+ *               allow dynamic replies. Replies are kept (MDNS_REPLY_CACHE_SIZE), call
+ *               mdns_resp_announce() when the TXT data changes.
  * @param txt_data Userdata pointer for txt_fn
  * @return service_id if the service was added to the netif, an err_t otherwise
  */
@@ -2252,6 +2635,8 @@ mdns_resp_del_service(struct netif *netif, s8_t slot)
   srv = mdns->services[slot];
   mdns->services[slot] = NULL;
   mem_free(srv);
+  mdns_drop_delayed_reply(netif);
+  mdns_reply_cache_clear(mdns);
   return ERR_OK;
 }
 
@@ -2310,7 +2695,8 @@ mdns_resp_add_service_txtitem(struct mdns_service *service, const char *txt, u8_
 
 /**
  * @ingroup mdns
- * Send unsolicited answer containing all our known data
+ * Send unsolicited answer containing all our known data. The replies kept
+ * for queries are built again afterwards.
  * @param netif The network interface to send on
  */
 void
@@ -2325,6 +2711,9 @@ mdns_resp_announce(struct netif *netif)
     return;
   }
 
+  /* Records may have changed, e.g. the TXT data */
+  mdns_reply_cache_clear(mdns);
+
   if (mdns->probing_state == MDNS_PROBING_COMPLETE) {
     /* Announce on IPv6 and IPv4 */
 #if LWIP_IPV6
@@ -2367,6 +2756,8 @@ mdns_resp_restart(struct netif *netif)
   if (mdns->probing_state == MDNS_PROBING_ONGOING) {
     sys_untimeout(mdns_probe, netif);
   }
+  mdns_drop_delayed_reply(netif);
+  mdns_reply_cache_clear(mdns);
   /* @todo if we've failed 15 times within a 10 second period we MUST wait 5 seconds (or wait 5 seconds every time except first)*/
   mdns->probes_sent = 0;
   mdns->probing_state = MDNS_PROBING_ONGOING;
@@ -39,7 +39,6 @@
  *
  *
  * @todo:
- * - Handle large outgoing payloads for PUBLISH messages
  * - Fix restriction of a single topic in each (UN)SUBSCRIBE message (protocol has support for multiple topics)
  * - Add support for legacy MQTT protocol version
  *
@@ -225,50 +224,155 @@ mqtt_ringbuf_len(struct mqtt_ringbuf_t *rb)
 /** Return number of bytes possible to read without wrapping around */
 #define mqtt_ringbuf_linear_read_length(rb) LWIP_MIN(mqtt_ringbuf_len(rb), (MQTT_OUTPUT_RINGBUF_SIZE - (rb)->get))
 
+/** Return number of bytes in ring buffer before the mark of a queued payload */
+#define mqtt_ringbuf_len_to(rb, mark) ((u16_t)(((mark) + MQTT_OUTPUT_RINGBUF_SIZE - (rb)->get) % MQTT_OUTPUT_RINGBUF_SIZE))
+
+/** Return the i-th payload queued by reference, from the oldest */
+static struct mqtt_out_ref *
+mqtt_ref_at(mqtt_client_t *client, u8_t i)
+{
+  return &client->refs[(client->ref_head + i) % MQTT_OUTPUT_REF_MAX];
+}
+
 /**
- * Try send as many bytes as possible from output ring buffer
- * @param rb Output ring buffer
- * @param tpcb TCP connection handle
+ * Release the payloads queued by reference that TCP has acknowledged
+ * @param client MQTT client
+ * @param all Release all of them, TCP does not reference them anymore
  */
 static void
-mqtt_output_send(struct mqtt_ringbuf_t *rb, struct altcp_pcb *tpcb)
+mqtt_ref_release(mqtt_client_t *client, u8_t all)
 {
-  err_t err;
-  u8_t wrap = 0;
-  u16_t ringbuf_lin_len = mqtt_ringbuf_linear_read_length(rb);
-  u16_t send_len = altcp_sndbuf(tpcb);
-  LWIP_ASSERT("mqtt_output_send: tpcb != NULL", tpcb != NULL);
+  struct mqtt_out_ref *ref;
 
-  if (send_len == 0 || ringbuf_lin_len == 0) {
-    return;
+  while (client->ref_num > 0) {
+    ref = mqtt_ref_at(client, 0);
+    if (!all && (client->ref_written == 0 || (s32_t)(client->out_acked - ref->end) < 0)) {
+      break;
+    }
+    pbuf_free(ref->p);
+    ref->p = NULL;
+    client->ref_head = (client->ref_head + 1) % MQTT_OUTPUT_REF_MAX;
+    client->ref_num--;
+    if (client->ref_written > 0) {
+      client->ref_written--;
+    }
   }
+}
 
-  LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_output_send: tcp_sndbuf: %d bytes, ringbuf_linear_available: %d, get %d, put %d\n",
-                                 send_len, ringbuf_lin_len, rb->get, rb->put));
-
-  if (send_len > ringbuf_lin_len) {
-    /* Space in TCP output buffer is larger than available in ring buffer linear portion */
-    send_len = ringbuf_lin_len;
-    /* Wrap around if more data in ring buffer after linear portion */
-    wrap = (mqtt_ringbuf_len(rb) > ringbuf_lin_len);
+/**
+ * Write as many bytes as possible from output ring buffer and of the
+ * payloads queued by reference to TCP, in the order they were queued. The
+ * payloads are written without copy, TCP references them until acknowledged.
+ * @param client MQTT client
+ * @return 1 if bytes were written, 0 if not
+ */
+static u8_t
+mqtt_output_write(mqtt_client_t *client)
+{
+  struct mqtt_ringbuf_t *rb = &client->output;
+  struct altcp_pcb *tpcb = client->conn;
+  struct mqtt_out_ref *ref;
+  struct pbuf *q;
+  u16_t send_len, ring_len, q_off;
+  u8_t sent = 0;
+  err_t err = ERR_OK;
+  LWIP_ASSERT("mqtt_output_write: tpcb != NULL", tpcb != NULL);
+
+  while (err == ERR_OK && altcp_sndbuf(tpcb) > 0) {
+    ref = client->ref_written < client->ref_num ? mqtt_ref_at(client, client->ref_written) : NULL;
+    ring_len = ref != NULL ? mqtt_ringbuf_len_to(rb, ref->mark) : mqtt_ringbuf_len(rb);
+
+    if (ring_len > 0) {
+      /* Use the lesser one of ring buffer linear length and TCP send buffer size */
+      send_len = LWIP_MIN(LWIP_MIN(ring_len, mqtt_ringbuf_linear_read_length(rb)), altcp_sndbuf(tpcb));
+      LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_output_write: tcp_sndbuf: %d bytes, ringbuf: %d, get %d, put %d\n",
+                                     altcp_sndbuf(tpcb), ring_len, rb->get, rb->put));
+      err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len,
+                        TCP_WRITE_FLAG_COPY | ((send_len < ring_len || ref != NULL) ? TCP_WRITE_FLAG_MORE : 0));
+      if (err == ERR_OK) {
+        mqtt_ringbuf_advance_get_idx(rb, send_len);
+      }
+    } else if (ref != NULL) {
+      q = pbuf_skip(ref->p, ref->off, &q_off);
+      send_len = LWIP_MIN((u16_t)(q->len - q_off), altcp_sndbuf(tpcb));
+      LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_output_write: tcp_sndbuf: %d bytes, payload: %d of %d\n",
+                                     altcp_sndbuf(tpcb), ref->off, ref->p->tot_len));
+      err = altcp_write(tpcb, (const u8_t *)q->payload + q_off, send_len,
+                        (ref->off + send_len < ref->p->tot_len) ? TCP_WRITE_FLAG_MORE : 0);
+      if (err == ERR_OK) {
+        ref->off += send_len;
+        if (ref->off == ref->p->tot_len) {
+          ref->end = client->out_written + send_len;
+          client->ref_written++;
+        }
+      }
+    } else {
+      break;
+    }
+    if (err == ERR_OK) {
+      client->out_written += send_len;
+      sent = 1;
+    }
   }
-  err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY | (wrap ? TCP_WRITE_FLAG_MORE : 0));
-  if ((err == ERR_OK) && wrap) {
-    mqtt_ringbuf_advance_get_idx(rb, send_len);
-    /* Use the lesser one of ring buffer linear length and TCP send buffer size */
-    send_len = LWIP_MIN(altcp_sndbuf(tpcb), mqtt_ringbuf_linear_read_length(rb));
-    err = altcp_write(tpcb, mqtt_ringbuf_get_ptr(rb), send_len, TCP_WRITE_FLAG_COPY);
+
+  if (err != ERR_OK) {
+    LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_output_write: Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
   }
+  return sent;
+}
 
-  if (err == ERR_OK) {
-    mqtt_ringbuf_advance_get_idx(rb, send_len);
+/**
+ * Try send as many bytes as possible from output ring buffer and of the
+ * payloads queued by reference
+ * @param client MQTT client
+ */
+static void
+mqtt_output_send(mqtt_client_t *client)
+{
+  if (mqtt_output_write(client)) {
     /* Flush */
-    altcp_output(tpcb);
-  } else {
-    LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_output_send: Send failed with err %d (\"%s\")\n", err, lwip_strerr(err)));
+    altcp_output(client->conn);
   }
 }
 
+#if MQTT_OUTPUT_COALESCE
+/**
+ * Send what requests of the last main loop pass have written to TCP
+ * @param arg MQTT client
+ */
+static void
+mqtt_output_flush(void *arg)
+{
+  mqtt_client_t *client = (mqtt_client_t *)arg;
+
+  client->output_flush = 0;
+  if (client->conn != NULL) {
+    mqtt_output_write(client);
+    altcp_output(client->conn);
+  }
+}
+#endif /* MQTT_OUTPUT_COALESCE */
+
+/**
+ * Write a request queued in output ring buffer to TCP. With
+ * MQTT_OUTPUT_COALESCE it is sent with the others of the main loop pass, by
+ * mqtt_output_flush() or by TCP if called from one of its callbacks.
+ * @param client MQTT client
+ */
+static void
+mqtt_output_queue(mqtt_client_t *client)
+{
+#if MQTT_OUTPUT_COALESCE
+  mqtt_output_write(client);
+  if (!client->output_flush) {
+    client->output_flush = 1;
+    sys_timeout(0, mqtt_output_flush, client);
+  }
+#else
+  mqtt_output_send(client);
+#endif
+}
+
 
 
 /*--------------------------------------------------------------------------------------------------------------------- */
@@ -386,11 +490,15 @@ mqtt_take_request(struct mqtt_request_t **tail, u16_t pkt_id)
  * Handle requests timeout
  * @param tail Pointer to request queue tail pointer
  * @param t Time since last call in seconds
+ * @param acks Number of requests waiting for a server response, decremented
+ *        for those timed out
+ * @return Number of requests waiting for a server response that timed out
  */
-static void
-mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t)
+static u8_t
+mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t, u8_t *acks)
 {
   struct mqtt_request_t *r;
+  u8_t n = 0;
   LWIP_ASSERT("mqtt_request_time_elapsed: tail != NULL", tail != NULL);
   r = *tail;
   while (t > 0 && r != NULL) {
@@ -398,6 +506,10 @@ mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t)
       t -= (u8_t)r->timeout_diff;
       /* Unchain */
       *tail = r->next;
+      if (r->pkt_id != 0) {
+        (*acks)--;
+        n++;
+      }
       /* Notify upper layer about timeout */
       if (r->cb != NULL) {
         r->cb(r->arg, ERR_TIMEOUT);
@@ -410,6 +522,7 @@ mqtt_request_time_elapsed(struct mqtt_request_t **tail, u8_t t)
       t = 0;
     }
   }
+  return n;
 }
 
 /**
@@ -508,13 +621,14 @@ mqtt_output_append_fixed_header(struct mqtt_ringbuf_t *rb, u8_t msg_type, u8_t f
  * Check output buffer space
  * @param rb Output ring buffer
  * @param r_length Remaining length after fixed header
+ * @param ref_length Bytes of it sent by reference, not through the ring buffer
  * @return 1 if message will fit, 0 if not enough buffer space
  */
 static u8_t
-mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length)
+mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length, u16_t ref_length)
 {
   /* Start with length of type byte + remaining length */
-  u16_t total_len = 1 + r_length;
+  u16_t total_len = 1 + r_length - ref_length;
 
   LWIP_ASSERT("mqtt_output_check_space: rb != NULL", rb != NULL);
 
@@ -524,7 +638,8 @@ mqtt_output_check_space(struct mqtt_ringbuf_t *rb, u16_t r_length)
     r_length >>= 7;
   } while (r_length > 0);
 
-  return (total_len <= mqtt_ringbuf_free(rb));
+  /* A full ring buffer would read as empty */
+  return (total_len < mqtt_ringbuf_free(rb));
 }
 
 
@@ -540,11 +655,14 @@ mqtt_close(mqtt_client_t *client, mqtt_connection_status_t reason)
 
   /* Bring down TCP connection if not already done */
   if (client->conn != NULL) {
-    err_t res;
+    err_t res = ERR_CLSD;
     altcp_recv(client->conn, NULL);
     altcp_err(client->conn,  NULL);
     altcp_sent(client->conn, NULL);
-    res = altcp_close(client->conn);
+    /* Unacknowledged payloads by reference would stay queued after a close */
+    if (client->ref_written == 0) {
+      res = altcp_close(client->conn);
+    }
     if (res != ERR_OK) {
       altcp_abort(client->conn);
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_close: Close err=%s\n", lwip_strerr(res)));
@@ -554,6 +672,12 @@ mqtt_close(mqtt_client_t *client, mqtt_connection_status_t reason)
 
   /* Remove all pending requests */
   mqtt_clear_requests(&client->pend_req_queue);
+  client->req_acks = 0;
+  mqtt_ref_release(client, 1);
+#if MQTT_OUTPUT_COALESCE
+  sys_untimeout(mqtt_output_flush, client);
+  client->output_flush = 0;
+#endif
   /* Stop cyclic timer */
   sys_untimeout(mqtt_cyclic_timer, client);
 
@@ -588,8 +712,11 @@ mqtt_cyclic_timer(void *arg)
       restart_timer = 0;
     }
   } else if (client->conn_state == MQTT_CONNECTED) {
-    /* Handle timeout for pending requests */
-    mqtt_request_time_elapsed(&client->pend_req_queue, MQTT_CYCLIC_TIMER_INTERVAL);
+    /* Handle timeout for pending requests, the server is not keeping up with the window */
+    if (mqtt_request_time_elapsed(&client->pend_req_queue, MQTT_CYCLIC_TIMER_INTERVAL, &client->req_acks) > 0) {
+      client->req_window = LWIP_MAX(client->req_window / 2, 1);
+      LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_cyclic_timer: Requests timed out, window %d\n", client->req_window));
+    }
 
     /* keep_alive > 0 means keep alive functionality shall be used */
     if (client->keep_alive > 0) {
@@ -605,7 +732,7 @@ mqtt_cyclic_timer(void *arg)
       /* If time for a keep alive message to be sent, transmission has been idle for keep_alive time */
       if ((client->cyclic_tick * MQTT_CYCLIC_TIMER_INTERVAL) >= client->keep_alive) {
         LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_cyclic_timer: Sending keep-alive message to server\n"));
-        if (mqtt_output_check_space(&client->output, 0) != 0) {
+        if (mqtt_output_check_space(&client->output, 0, 0) != 0) {
           mqtt_output_append_fixed_header(&client->output, MQTT_MSG_TYPE_PINGREQ, 0, 0, 0, 0);
           client->cyclic_tick = 0;
         }
@@ -635,10 +762,10 @@ static err_t
 pub_ack_rec_rel_response(mqtt_client_t *client, u8_t msg, u16_t pkt_id, u8_t qos)
 {
   err_t err = ERR_OK;
-  if (mqtt_output_check_space(&client->output, 2)) {
+  if (mqtt_output_check_space(&client->output, 2, 0)) {
     mqtt_output_append_fixed_header(&client->output, msg, 0, qos, 0, 2);
     mqtt_output_append_u16(&client->output, pkt_id);
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_queue(client);
   } else {
     LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("pub_ack_rec_rel_response: OOM creating response: %s with pkt_id: %d\n",
                                    mqtt_msg_type_to_str(msg), pkt_id));
@@ -661,6 +788,44 @@ mqtt_incomming_suback(struct mqtt_request_t *r, u8_t result)
 }
 
 
+/**
+ * Send PUBACK for QoS 1 or PUBREC for QoS 2 once an incoming publish is complete
+ * @param client MQTT client
+ */
+static void
+mqtt_incoming_publish_ack(mqtt_client_t *client)
+{
+  u8_t qos = MQTT_CTL_PACKET_QOS(client->rx_buffer[0]);
+
+  if (qos > 0) {
+    u8_t resp_msg = (qos == 1) ? MQTT_MSG_TYPE_PUBACK : MQTT_MSG_TYPE_PUBREC;
+    LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_incomming_publish: Sending publish response: %s with pkt_id: %d\n",
+                                   mqtt_msg_type_to_str(resp_msg), client->inpub_pkt_id));
+    pub_ack_rec_rel_response(client, resp_msg, client->inpub_pkt_id, 0);
+  }
+}
+
+/**
+ * Length of the variable header of an incoming message being received, the
+ * topic and packet identifier of a PUBLISH
+ * @param client MQTT client
+ * @param fixed_hdr_len length of fixed header
+ * @return 0 if not a PUBLISH, 2 until the topic length has been received
+ */
+static u32_t
+mqtt_incoming_publish_hdr_len(mqtt_client_t *client, u8_t fixed_hdr_len)
+{
+  const u8_t *var_hdr = client->rx_buffer + fixed_hdr_len;
+
+  if (MQTT_CTL_PACKET_TYPE(client->rx_buffer[0]) != MQTT_MSG_TYPE_PUBLISH) {
+    return 0;
+  }
+  if (client->msg_idx < fixed_hdr_len + 2U) {
+    return 2;
+  }
+  return 2U + (((u32_t)var_hdr[0] << 8) | var_hdr[1]) + (MQTT_CTL_PACKET_QOS(client->rx_buffer[0]) ? 2U : 0U);
+}
+
 /**
  * Complete MQTT message received or buffer full
  * @param client MQTT client
@@ -776,12 +941,8 @@ mqtt_message_received(mqtt_client_t *client, u8_t fixed_hdr_len, u16_t length, u
         client->data_cb(client->inpub_arg, var_hdr_payload + payload_offset, payload_length, remaining_length == 0 ? MQTT_DATA_FLAG_LAST : 0);
       }
       /* Reply if QoS > 0 */
-      if (remaining_length == 0 && qos > 0) {
-        /* Send PUBACK for QoS 1 or PUBREC for QoS 2 */
-        u8_t resp_msg = (qos == 1) ? MQTT_MSG_TYPE_PUBACK : MQTT_MSG_TYPE_PUBREC;
-        LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_incomming_publish: Sending publish response: %s with pkt_id: %d\n",
-                                       mqtt_msg_type_to_str(resp_msg), client->inpub_pkt_id));
-        pub_ack_rec_rel_response(client, resp_msg, client->inpub_pkt_id, 0);
+      if (remaining_length == 0) {
+        mqtt_incoming_publish_ack(client);
       }
     }
   } else {
@@ -805,6 +966,11 @@ mqtt_message_received(mqtt_client_t *client, u8_t fixed_hdr_len, u16_t length, u
       struct mqtt_request_t *r = mqtt_take_request(&client->pend_req_queue, pkt_id);
       if (r != NULL) {
         LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_message_received: %s response with id %d\n", mqtt_msg_type_to_str(pkt_type), pkt_id));
+        /* Open the window before the callback, which may make the next request */
+        client->req_acks--;
+        if (client->req_window < MQTT_REQ_MAX_IN_FLIGHT) {
+          client->req_window++;
+        }
         if (pkt_type == MQTT_MSG_TYPE_SUBACK) {
           if (length < 3) {
             LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_message_received: To small SUBACK packet\n"));
@@ -884,16 +1050,43 @@ mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
     } else {
       /* Fixed header has been parsed, parse variable header */
       u16_t cpy_len, buffer_space;
+      u32_t hdr_len = mqtt_incoming_publish_hdr_len(client, fixed_hdr_len);
+
+      if (hdr_len != 0 && client->msg_idx - fixed_hdr_len >= hdr_len) {
+        /* Publish payload, passed to the data callback segment by segment without copy */
+        u16_t q_off;
+        struct pbuf *q = pbuf_skip(p, in_offset, &q_off);
+
+        cpy_len = (u16_t)LWIP_MIN((u32_t)(q->len - q_off), msg_rem_len);
+        client->msg_idx += cpy_len;
+        in_offset += cpy_len;
+        msg_rem_len -= cpy_len;
+        if (client->data_cb != NULL) {
+          client->data_cb(client->inpub_arg, (const u8_t *)q->payload + q_off, cpy_len,
+                          msg_rem_len == 0 ? MQTT_DATA_FLAG_LAST : 0);
+        }
+        if (msg_rem_len == 0) {
+          mqtt_incoming_publish_ack(client);
+          /* Reset parser state */
+          client->msg_idx = 0;
+          fixed_hdr_len = 0;
+        }
+        continue;
+      }
 
       /* Allow to copy the lesser one of available length in input data or bytes remaining in message */
       cpy_len = (u16_t)LWIP_MIN((u16_t)(p->tot_len - in_offset), msg_rem_len);
 
-      /* Limit to available space in buffer */
-      buffer_space = MQTT_VAR_HEADER_BUFFER_LEN - fixed_hdr_len;
+      /* Limit to available space in buffer, and to the variable header of a publish */
+      buffer_space = (u16_t)(MQTT_VAR_HEADER_BUFFER_LEN - client->msg_idx);
       if (cpy_len > buffer_space) {
         cpy_len = buffer_space;
       }
-      pbuf_copy_partial(p, client->rx_buffer + fixed_hdr_len, cpy_len, in_offset);
+      if (hdr_len != 0 && cpy_len > hdr_len - (client->msg_idx - fixed_hdr_len)) {
+        cpy_len = (u16_t)(hdr_len - (client->msg_idx - fixed_hdr_len));
+      }
+      /* Append, the variable header may come in several segments */
+      pbuf_copy_partial(p, client->rx_buffer + client->msg_idx, cpy_len, in_offset);
 
       /* Advance get and put indexes  */
       client->msg_idx += cpy_len;
@@ -901,9 +1094,12 @@ mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
       msg_rem_len -= cpy_len;
 
       LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_parse_incoming: msg_idx: %"U32_F", cpy_len: %"U16_F", remaining %"U32_F"\n", client->msg_idx, cpy_len, msg_rem_len));
-      if ((msg_rem_len == 0) || (cpy_len == buffer_space)) {
-        /* Whole message received or buffer is full */
-        mqtt_connection_status_t res = mqtt_message_received(client, fixed_hdr_len, cpy_len, msg_rem_len);
+      hdr_len = mqtt_incoming_publish_hdr_len(client, fixed_hdr_len);
+      if ((msg_rem_len == 0) || (client->msg_idx == MQTT_VAR_HEADER_BUFFER_LEN) ||
+          (hdr_len != 0 && client->msg_idx - fixed_hdr_len == hdr_len)) {
+        /* Whole message or publish header received, or buffer is full */
+        mqtt_connection_status_t res = mqtt_message_received(client, fixed_hdr_len,
+                                       (u16_t)(client->msg_idx - fixed_hdr_len), msg_rem_len);
         if (res != MQTT_CONNECT_ACCEPTED) {
           return res;
         }
@@ -912,6 +1108,9 @@ mqtt_parse_incoming(mqtt_client_t *client, struct pbuf *p)
           client->msg_idx = 0;
           /* msg_tot_len = 0; */
           fixed_hdr_len = 0;
+        } else if (hdr_len == 0 || client->msg_idx - fixed_hdr_len != hdr_len) {
+          LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_parse_incoming: Message does not fit the receive buffer\n"));
+          return MQTT_CONNECT_DISCONNECTED;
         }
       }
     }
@@ -977,7 +1176,9 @@ mqtt_tcp_sent_cb(void *arg, struct altcp_pcb *tpcb, u16_t len)
   mqtt_client_t *client = (mqtt_client_t *)arg;
 
   LWIP_UNUSED_ARG(tpcb);
-  LWIP_UNUSED_ARG(len);
+
+  client->out_acked += len;
+  mqtt_ref_release(client, 0);
 
   if (client->conn_state == MQTT_CONNECTED) {
     struct mqtt_request_t *r;
@@ -994,7 +1195,7 @@ mqtt_tcp_sent_cb(void *arg, struct altcp_pcb *tpcb, u16_t len)
       mqtt_delete_request(r);
     }
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, client->conn);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1028,7 +1229,7 @@ mqtt_tcp_poll_cb(void *arg, struct altcp_pcb *tpcb)
   mqtt_client_t *client = (mqtt_client_t *)arg;
   if (client->conn_state == MQTT_CONNECTED) {
     /* Try send any remaining buffers from output queue */
-    mqtt_output_send(&client->output, tpcb);
+    mqtt_output_send(client);
   }
   return ERR_OK;
 }
@@ -1056,6 +1257,11 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
   altcp_recv(tpcb, mqtt_tcp_recv_cb);
   altcp_sent(tpcb, mqtt_tcp_sent_cb);
   altcp_poll(tpcb, mqtt_tcp_poll_cb, 2);
+#if MQTT_OUTPUT_COALESCE
+  /* Messages are coalesced per main loop pass, Nagle would hold all but the
+     first full segment for a round trip and bound the in-flight window */
+  altcp_nagle_disable(tpcb);
+#endif
 
   LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_tcp_connect_cb: TCP connection established to server\n"));
   /* Enter MQTT connect state */
@@ -1066,7 +1272,7 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
   client->cyclic_tick = 0;
 
   /* Start transmission from output queue, connect message is the first one out*/
-  mqtt_output_send(&client->output, client->conn);
+  mqtt_output_send(client);
 
   return ERR_OK;
 }
@@ -1078,23 +1284,22 @@ mqtt_tcp_connect_cb(void *arg, struct altcp_pcb *tpcb, err_t err)
 
 
 /**
- * @ingroup mqtt
- * MQTT publish function.
+ * Queue a PUBLISH message, the payload either copied into the output ring
+ * buffer or sent by reference
  * @param client MQTT client
  * @param topic Publish topic string
- * @param payload Data to publish (NULL is allowed)
- * @param payload_length Length of payload (0 is allowed)
+ * @param payload Data to copy, NULL if ref is given
+ * @param ref Data to send by reference, NULL if payload is given
+ * @param payload_length Length of payload or ref
  * @param qos Quality of service, 0 1 or 2
  * @param retain MQTT retain flag
  * @param cb Callback to call when publish is complete or has timed out
  * @param arg User supplied argument to publish callback
- * @return ERR_OK if successful
- *         ERR_CONN if client is disconnected
- *         ERR_MEM if short on memory
+ * @return ERR_OK if successful, ERR_CONN, ERR_ARG or ERR_MEM
  */
-err_t
-mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
-             mqtt_request_cb_t cb, void *arg)
+static err_t
+mqtt_publish_msg(mqtt_client_t *client, const char *topic, const void *payload, struct pbuf *ref, u16_t payload_length,
+                 u8_t qos, u8_t retain, mqtt_request_cb_t cb, void *arg)
 {
   struct mqtt_request_t *r;
   u16_t pkt_id;
@@ -1115,26 +1320,28 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
 
   if (qos > 0) {
     total_len += 2;
-    /* Generate pkt_id id for QoS1 and 2 */
-    pkt_id = msg_generate_packet_id(client);
-  } else {
-    /* Use reserved value pkt_id 0 for QoS 0 in request handle */
-    pkt_id = 0;
   }
   LWIP_ERROR("mqtt_publish: total length overflow", (total_len <= 0xFFFF), return ERR_ARG);
   remaining_length = (u16_t)total_len;
 
   LWIP_DEBUGF(MQTT_DEBUG_TRACE, ("mqtt_publish: Publish with payload length %d to topic \"%s\"\n", payload_length, topic));
 
+  if (qos > 0 && client->req_acks >= client->req_window) {
+    return ERR_MEM;
+  }
+  if (ref != NULL && client->ref_num == MQTT_OUTPUT_REF_MAX) {
+    return ERR_MEM;
+  }
+  if (mqtt_output_check_space(&client->output, remaining_length, ref != NULL ? payload_length : 0) == 0) {
+    return ERR_MEM;
+  }
+  /* Generate pkt_id id for QoS1 and 2, use reserved value pkt_id 0 for QoS 0 in request handle */
+  pkt_id = qos > 0 ? msg_generate_packet_id(client) : 0;
   r = mqtt_create_request(client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id, cb, arg);
   if (r == NULL) {
     return ERR_MEM;
   }
 
-  if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
-    mqtt_delete_request(r);
-    return ERR_MEM;
-  }
   /* Append fixed header */
   mqtt_output_append_fixed_header(&client->output, MQTT_MSG_TYPE_PUBLISH, 0, qos, retain, remaining_length);
 
@@ -1146,16 +1353,82 @@ mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_
     mqtt_output_append_u16(&client->output, pkt_id);
   }
 
-  /* Append optional publish payload */
-  if ((payload != NULL) && (payload_length > 0)) {
+  /* Append optional publish payload, or queue it after what is in the ring buffer */
+  if (ref != NULL) {
+    struct mqtt_out_ref *out = mqtt_ref_at(client, client->ref_num++);
+    pbuf_ref(ref);
+    out->p = ref;
+    out->mark = client->output.put;
+    out->off = 0;
+  } else if ((payload != NULL) && (payload_length > 0)) {
     mqtt_output_append_buf(&client->output, payload, payload_length);
   }
 
   mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  if (qos > 0) {
+    client->req_acks++;
+  }
+  mqtt_output_queue(client);
   return ERR_OK;
 }
 
+/**
+ * @ingroup mqtt
+ * MQTT publish function.
+ * With MQTT_OUTPUT_COALESCE the message is sent with the others queued in the
+ * same main loop pass. QoS 1 and 2 messages are bounded by the in-flight
+ * window, see MQTT_REQ_WINDOW_INIT, ERR_MEM tells to retry after a callback.
+ * @param client MQTT client
+ * @param topic Publish topic string
+ * @param payload Data to publish (NULL is allowed)
+ * @param payload_length Length of payload (0 is allowed)
+ * @param qos Quality of service, 0 1 or 2
+ * @param retain MQTT retain flag
+ * @param cb Callback to call when publish is complete or has timed out
+ * @param arg User supplied argument to publish callback
+ * @return ERR_OK if successful
+ *         ERR_CONN if client is disconnected
+ *         ERR_MEM if short on memory or the in-flight window is full
+ */
+err_t
+mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
+             mqtt_request_cb_t cb, void *arg)
+{
+  return mqtt_publish_msg(client, topic, payload, NULL, payload_length, qos, retain, cb, arg);
+}
+
+/**
+ * @ingroup mqtt
+ * MQTT publish function, the payload is not copied but sent by reference.
+ * Only the fixed header, topic and packet identifier go through the output
+ * ring-buffer, so the payload may be larger than MQTT_OUTPUT_RINGBUF_SIZE.
+ *
+ * A reference to the pbuf is held until TCP has acknowledged the payload or
+ * the connection is closed, its data must not change until then. Caller-owned
+ * memory can be passed as a PBUF_REF or PBUF_ROM pbuf, or as a custom pbuf
+ * (pbuf_alloced_custom()) whose free function tells when it is released.
+ * @param client MQTT client
+ * @param topic Publish topic string
+ * @param payload Data to publish, any pbuf chain (NULL is allowed)
+ * @param qos Quality of service, 0 1 or 2
+ * @param retain MQTT retain flag
+ * @param cb Callback to call when publish is complete or has timed out
+ * @param arg User supplied argument to publish callback
+ * @return ERR_OK if successful
+ *         ERR_CONN if client is disconnected
+ *         ERR_MEM if short on memory, MQTT_OUTPUT_REF_MAX payloads are queued or
+ *                 the in-flight window is full
+ */
+err_t
+mqtt_publish_pbuf(mqtt_client_t *client, const char *topic, struct pbuf *payload, u8_t qos, u8_t retain,
+                  mqtt_request_cb_t cb, void *arg)
+{
+  if (payload != NULL && payload->tot_len == 0) {
+    payload = NULL;
+  }
+  return mqtt_publish_msg(client, topic, NULL, payload, payload != NULL ? payload->tot_len : 0, qos, retain, cb, arg);
+}
+
 
 /**
  * @ingroup mqtt
@@ -1195,6 +1468,9 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
     LWIP_DEBUGF(MQTT_DEBUG_WARN, ("mqtt_sub_unsub: Can not (un)subscribe in disconnected state\n"));
     return ERR_CONN;
   }
+  if (client->req_acks >= client->req_window) {
+    return ERR_MEM;
+  }
 
   pkt_id = msg_generate_packet_id(client);
   r = mqtt_create_request(client->req_list, LWIP_ARRAYSIZE(client->req_list), pkt_id, cb, arg);
@@ -1202,7 +1478,7 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
     return ERR_MEM;
   }
 
-  if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
+  if (mqtt_output_check_space(&client->output, remaining_length, 0) == 0) {
     mqtt_delete_request(r);
     return ERR_MEM;
   }
@@ -1220,7 +1496,8 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
   }
 
   mqtt_append_request(&client->pend_req_queue, r);
-  mqtt_output_send(&client->output, client->conn);
+  client->req_acks++;
+  mqtt_output_queue(client);
   return ERR_OK;
 }
 
@@ -1230,7 +1507,8 @@ mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_request_
  * Set callback to handle incoming publish requests from server
  * @param client MQTT client
  * @param pub_cb Callback invoked when publish starts, contain topic and total length of payload
- * @param data_cb Callback for each fragment of payload that arrives
+ * @param data_cb Callback for each fragment of payload that arrives, a segment of
+ *        the received pbufs passed without copy
  * @param arg User supplied argument to both callbacks
  */
 void
@@ -1307,6 +1585,7 @@ mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip_addr, u16_t port,
   client->connect_cb = cb;
   client->keep_alive = client_info->keep_alive;
   mqtt_init_requests(client->req_list, LWIP_ARRAYSIZE(client->req_list));
+  client->req_window = LWIP_MIN(MQTT_REQ_WINDOW_INIT, MQTT_REQ_MAX_IN_FLIGHT);
 
   /* Build connect message */
   if (client_info->will_topic != NULL && client_info->will_msg != NULL) {
@@ -1357,7 +1636,7 @@ mqtt_client_connect(mqtt_client_t *client, const ip_addr_t *ip_addr, u16_t port,
   LWIP_ERROR("mqtt_client_connect: remaining_length overflow", len <= 0xFFFF, return ERR_VAL);
   remaining_length = (u16_t)len;
 
-  if (mqtt_output_check_space(&client->output, remaining_length) == 0) {
+  if (mqtt_output_check_space(&client->output, remaining_length, 0) == 0) {
     return ERR_MEM;
   }
 
@@ -0,0 +1,390 @@
+/**
+ * @file mqtt_dispatch.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief MQTT subscription registry, incoming PUBLISH messages dispatched to
+ *        the handlers of the topic filters they match.
+ *
+ * A topic is split into levels once. Each level is looked up in the hash
+ * table from every node reached so far, which are more than one only when
+ * filters have '+' on the way. The label hash of a level is computed once
+ * and combined with the hash of each parent, so a lookup compares labels
+ * only on a hash hit.
+ */
+
+#include "lwip/apps/mqtt_dispatch.h"
+#include "lwip/mem.h"
+
+#include <string.h>
+
+#if LWIP_TCP && LWIP_CALLBACK_API
+
+/** MQTT_DISPATCH_DEBUG: Default is off */
+#ifndef MQTT_DISPATCH_DEBUG
+#define MQTT_DISPATCH_DEBUG LWIP_DBG_OFF
+#endif
+
+#define MQTT_DISPATCH_FNV_INIT   0x811c9dc5UL
+#define MQTT_DISPATCH_FNV_PRIME  0x01000193UL
+
+#define MQTT_DISPATCH_BUCKET(hash) ((hash) & (MQTT_DISPATCH_HASH_SIZE - 1))
+
+#if (MQTT_DISPATCH_HASH_SIZE & (MQTT_DISPATCH_HASH_SIZE - 1)) != 0
+#error "MQTT_DISPATCH_HASH_SIZE must be a power of 2"
+#endif
+
+/** Hash of a level label */
+static u32_t
+mqtt_dispatch_label_hash(const char *label, u16_t len)
+{
+  u32_t h = MQTT_DISPATCH_FNV_INIT;
+  u16_t i;
+
+  for (i = 0; i < len; i++) {
+    h = (h ^ (u8_t)label[i]) * MQTT_DISPATCH_FNV_PRIME;
+  }
+  return h;
+}
+
+/** Hash of a child, its label hash mixed with the hash of the parent */
+static u32_t
+mqtt_dispatch_child_hash(const struct mqtt_dispatch_node *parent, u32_t label_hash)
+{
+  u32_t h = label_hash ^ (parent->hash * 0x9e3779b1UL);
+
+  return h ^ (h >> 16);
+}
+
+/** Hashed child of parent with a label, NULL if none */
+static struct mqtt_dispatch_node *
+mqtt_dispatch_child(struct mqtt_dispatch *reg, const struct mqtt_dispatch_node *parent,
+                    const char *label, u16_t len, u32_t hash)
+{
+  struct mqtt_dispatch_node *n;
+
+  for (n = reg->buckets[MQTT_DISPATCH_BUCKET(hash)]; n != NULL; n = n->next) {
+    if (n->hash == hash && n->parent == parent && n->len == len &&
+        memcmp(n->label, label, len) == 0) {
+      return n;
+    }
+  }
+  return NULL;
+}
+
+/** New child of parent, hashed unless it is the '+' one */
+static struct mqtt_dispatch_node *
+mqtt_dispatch_node_new(struct mqtt_dispatch *reg, struct mqtt_dispatch_node *parent,
+                       const char *label, u16_t len, u32_t hash, u8_t plus)
+{
+  struct mqtt_dispatch_node *n;
+
+  n = (struct mqtt_dispatch_node *)mem_malloc((mem_size_t)(sizeof(*n) + len));
+  if (n == NULL) {
+    return NULL;
+  }
+  memset(n, 0, sizeof(*n));
+  n->parent = parent;
+  n->hash = hash;
+  n->len = len;
+  MEMCPY(n->label, label, len);
+  if (plus) {
+    parent->plus = n;
+  } else {
+    n->next = reg->buckets[MQTT_DISPATCH_BUCKET(hash)];
+    reg->buckets[MQTT_DISPATCH_BUCKET(hash)] = n;
+  }
+  parent->children++;
+  reg->nodes++;
+  return n;
+}
+
+/** Free the nodes without filters and children, from n up */
+static void
+mqtt_dispatch_prune(struct mqtt_dispatch *reg, struct mqtt_dispatch_node *n)
+{
+  struct mqtt_dispatch_node *parent, **pn;
+
+  while (n != &reg->root && n->children == 0 && n->subs == NULL && n->multi == NULL) {
+    parent = n->parent;
+    if (parent->plus == n) {
+      parent->plus = NULL;
+    } else {
+      for (pn = &reg->buckets[MQTT_DISPATCH_BUCKET(n->hash)]; *pn != n; pn = &(*pn)->next);
+      *pn = n->next;
+    }
+    parent->children--;
+    reg->nodes--;
+    mem_free(n);
+    n = parent;
+  }
+}
+
+/**
+ * @ingroup mqtt
+ * Initialize an empty subscription registry.
+ * @param reg Registry
+ */
+void
+mqtt_dispatch_init(struct mqtt_dispatch *reg)
+{
+  LWIP_ASSERT("mqtt_dispatch_init: reg != NULL", reg != NULL);
+
+  memset(reg, 0, sizeof(*reg));
+  reg->root.hash = MQTT_DISPATCH_FNV_INIT;
+}
+
+/**
+ * @ingroup mqtt
+ * Add a handler for the messages whose topic matches a filter. Handlers of
+ * the same filter are called in the order added, those of overlapping
+ * filters all once.
+ * @param reg Registry
+ * @param filter Topic filter, '+' for one level and '#' for the rest
+ * @param pub_cb Called when a matching publish starts, may be NULL
+ * @param data_cb Called for each fragment of its payload, may be NULL
+ * @param arg Argument of the callbacks
+ * @param sub Where to store the handle for mqtt_dispatch_remove(), may be NULL
+ * @return ERR_OK, ERR_ARG if the filter is malformed, ERR_MEM
+ */
+err_t
+mqtt_dispatch_add(struct mqtt_dispatch *reg, const char *filter,
+                  mqtt_incoming_publish_cb_t pub_cb, mqtt_incoming_data_cb_t data_cb,
+                  void *arg, struct mqtt_dispatch_sub **sub)
+{
+  struct mqtt_dispatch_node *n = &reg->root, *child;
+  struct mqtt_dispatch_sub *s, **ps;
+  const char *level = filter, *end;
+  u8_t multi = 0;
+  u16_t len;
+  u32_t hash;
+
+  LWIP_ASSERT("mqtt_dispatch_add: reg != NULL", reg != NULL);
+  LWIP_ASSERT("mqtt_dispatch_add: filter != NULL", filter != NULL);
+  LWIP_ERROR("mqtt_dispatch_add: empty filter", filter[0] != '\0', return ERR_ARG);
+
+  s = (struct mqtt_dispatch_sub *)mem_malloc(sizeof(*s));
+  if (s == NULL) {
+    return ERR_MEM;
+  }
+  for (;;) {
+    end = strchr(level, '/');
+    if (end == NULL) {
+      end = level + strlen(level);
+    }
+    LWIP_ERROR("mqtt_dispatch_add: level too long", end - level <= 0xffff, goto err_arg);
+    len = (u16_t)(end - level);
+    if (len == 1 && level[0] == '#') {
+      LWIP_ERROR("mqtt_dispatch_add: '#' not last", *end == '\0', goto err_arg);
+      multi = 1;
+      break;
+    }
+    LWIP_ERROR("mqtt_dispatch_add: wildcard within a level",
+               (memchr(level, '+', len) == NULL && memchr(level, '#', len) == NULL) ||
+               (len == 1 && level[0] == '+'), goto err_arg);
+    if (len == 1 && level[0] == '+') {
+      child = n->plus;
+      hash = mqtt_dispatch_child_hash(n, mqtt_dispatch_label_hash(level, len));
+      if (child == NULL) {
+        child = mqtt_dispatch_node_new(reg, n, level, len, hash, 1);
+      }
+    } else {
+      hash = mqtt_dispatch_child_hash(n, mqtt_dispatch_label_hash(level, len));
+      child = mqtt_dispatch_child(reg, n, level, len, hash);
+      if (child == NULL) {
+        child = mqtt_dispatch_node_new(reg, n, level, len, hash, 0);
+      }
+    }
+    if (child == NULL) {
+      mqtt_dispatch_prune(reg, n);
+      mem_free(s);
+      return ERR_MEM;
+    }
+    n = child;
+    if (*end == '\0') {
+      break;
+    }
+    level = end + 1;
+  }
+
+  s->next = NULL;
+  s->node = n;
+  s->pub_cb = pub_cb;
+  s->data_cb = data_cb;
+  s->arg = arg;
+  s->multi = multi;
+  for (ps = multi ? &n->multi : &n->subs; *ps != NULL; ps = &(*ps)->next);
+  *ps = s;
+  if (sub != NULL) {
+    *sub = s;
+  }
+  LWIP_DEBUGF(MQTT_DISPATCH_DEBUG, ("mqtt_dispatch_add: \"%s\", %"U16_F" nodes\n", filter, reg->nodes));
+  return ERR_OK;
+
+err_arg:
+  mqtt_dispatch_prune(reg, n);
+  mem_free(s);
+  return ERR_ARG;
+}
+
+/**
+ * @ingroup mqtt
+ * Remove a handler, not from within a callback of the registry.
+ * @param reg Registry
+ * @param sub Handle from mqtt_dispatch_add()
+ */
+void
+mqtt_dispatch_remove(struct mqtt_dispatch *reg, struct mqtt_dispatch_sub *sub)
+{
+  struct mqtt_dispatch_sub **ps;
+
+  LWIP_ASSERT("mqtt_dispatch_remove: reg != NULL", reg != NULL);
+  LWIP_ASSERT("mqtt_dispatch_remove: sub != NULL", sub != NULL);
+  LWIP_ASSERT("mqtt_dispatch_remove: not while dispatching", !reg->dispatching);
+
+  for (ps = sub->multi ? &sub->node->multi : &sub->node->subs; *ps != sub; ps = &(*ps)->next) {
+    LWIP_ASSERT("mqtt_dispatch_remove: sub registered", *ps != NULL);
+  }
+  *ps = sub->next;
+  mqtt_dispatch_prune(reg, sub->node);
+  mem_free(sub);
+  /* A message being received is not dispatched anymore */
+  reg->match_num = 0;
+}
+
+/** Keep a matched handler list for the message */
+static void
+mqtt_dispatch_match_list(struct mqtt_dispatch *reg, struct mqtt_dispatch_sub *list)
+{
+  if (list == NULL) {
+    return;
+  }
+  if (reg->match_num == MQTT_DISPATCH_MATCH_MAX) {
+    LWIP_DEBUGF(MQTT_DISPATCH_DEBUG | LWIP_DBG_LEVEL_WARNING, ("mqtt_dispatch_match: MQTT_DISPATCH_MATCH_MAX exceeded\n"));
+    return;
+  }
+  reg->match[reg->match_num++] = list;
+}
+
+/**
+ * @ingroup mqtt
+ * Match a topic against the filters, the matched handlers are those
+ * mqtt_dispatch_incoming_data() calls next.
+ * @param reg Registry
+ * @param topic Zero terminated topic of an incoming publish
+ * @return Number of matched handler lists, 0 if no filter matches
+ */
+u8_t
+mqtt_dispatch_match(struct mqtt_dispatch *reg, const char *topic)
+{
+  struct mqtt_dispatch_node *nodes[2][MQTT_DISPATCH_MATCH_MAX], *child;
+  struct mqtt_dispatch_node **cur = nodes[0], **next = nodes[1], **tmp;
+  u8_t cur_num = 1, next_num, i;
+  /* Wildcards at the first level do not match topics starting with '$' */
+  u8_t sys = topic[0] == '$';
+  const char *level = topic;
+  u32_t label_hash;
+  u16_t len;
+
+  reg->match_num = 0;
+  cur[0] = &reg->root;
+  for (;;) {
+    /* '#' matches the parent level and any below */
+    for (i = 0; i < cur_num; i++) {
+      if (!sys || cur[i] != &reg->root) {
+        mqtt_dispatch_match_list(reg, cur[i]->multi);
+      }
+    }
+    if (level == NULL) {
+      break;
+    }
+
+    for (len = 0; level[len] != '\0' && level[len] != '/'; len++);
+    label_hash = mqtt_dispatch_label_hash(level, len);
+    next_num = 0;
+    for (i = 0; i < cur_num; i++) {
+      child = mqtt_dispatch_child(reg, cur[i], level, len, mqtt_dispatch_child_hash(cur[i], label_hash));
+      if (child != NULL && next_num < MQTT_DISPATCH_MATCH_MAX) {
+        next[next_num++] = child;
+      }
+      child = cur[i]->plus;
+      if (child != NULL && (!sys || cur[i] != &reg->root) && next_num < MQTT_DISPATCH_MATCH_MAX) {
+        next[next_num++] = child;
+      }
+    }
+    tmp = cur;
+    cur = next;
+    next = tmp;
+    cur_num = next_num;
+    if (cur_num == 0) {
+      return reg->match_num;
+    }
+    level = level[len] == '/' ? level + len + 1 : NULL;
+  }
+
+  for (i = 0; i < cur_num; i++) {
+    mqtt_dispatch_match_list(reg, cur[i]->subs);
+  }
+  return reg->match_num;
+}
+
+/**
+ * @ingroup mqtt
+ * Incoming publish callback of the client (mqtt_set_inpub_callback()), calls
+ * the publish callbacks of the matching handlers.
+ * @param arg Registry
+ * @param topic Zero terminated topic
+ * @param tot_len Total length of the payload
+ */
+void
+mqtt_dispatch_incoming_publish(void *arg, const char *topic, u32_t tot_len)
+{
+  struct mqtt_dispatch *reg = (struct mqtt_dispatch *)arg;
+  struct mqtt_dispatch_sub *s;
+  u8_t i;
+
+  if (mqtt_dispatch_match(reg, topic) == 0) {
+    LWIP_DEBUGF(MQTT_DISPATCH_DEBUG, ("mqtt_dispatch_incoming_publish: no handler for \"%s\"\n", topic));
+    return;
+  }
+  reg->dispatching = 1;
+  for (i = 0; i < reg->match_num; i++) {
+    for (s = reg->match[i]; s != NULL; s = s->next) {
+      if (s->pub_cb != NULL) {
+        s->pub_cb(s->arg, topic, tot_len);
+      }
+    }
+  }
+  reg->dispatching = 0;
+}
+
+/**
+ * @ingroup mqtt
+ * Incoming data callback of the client (mqtt_set_inpub_callback()), calls
+ * the data callbacks of the handlers matched by the publish.
+ * @param arg Registry
+ * @param data Fragment of the payload
+ * @param len Length of the fragment
+ * @param flags MQTT_DATA_FLAG_LAST with the last fragment
+ */
+void
+mqtt_dispatch_incoming_data(void *arg, const u8_t *data, u16_t len, u8_t flags)
+{
+  struct mqtt_dispatch *reg = (struct mqtt_dispatch *)arg;
+  struct mqtt_dispatch_sub *s;
+  u8_t i;
+
+  reg->dispatching = 1;
+  for (i = 0; i < reg->match_num; i++) {
+    for (s = reg->match[i]; s != NULL; s = s->next) {
+      if (s->data_cb != NULL) {
+        s->data_cb(s->arg, data, len, flags);
+      }
+    }
+  }
+  reg->dispatching = 0;
+  if (flags & MQTT_DATA_FLAG_LAST) {
+    reg->match_num = 0;
+  }
+}
+
+#endif /* LWIP_TCP && LWIP_CALLBACK_API */
@@ -56,7 +56,9 @@
 err_t
 snmp_ans1_enc_tlv(struct snmp_pbuf_stream *pbuf_stream, struct snmp_asn1_tlv *tlv)
 {
-  u8_t data;
+  /* type and up to 1 + 3 length bytes, written at once */
+  u8_t buf[5];
+  u8_t pos = 0;
   u8_t length_bytes_required;
 
   /* write type */
@@ -69,8 +71,7 @@ snmp_ans1_enc_tlv(struct snmp_pbuf_stream *pbuf_stream, struct snmp_asn1_tlv *tl
     return ERR_ARG;
   }
 
-  PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, tlv->type));
-  tlv->type_len = 1;
+  buf[pos++] = tlv->type;
 
   /* write length */
   if (tlv->value_len <= 127) {
@@ -83,7 +84,7 @@ snmp_ans1_enc_tlv(struct snmp_pbuf_stream *pbuf_stream, struct snmp_asn1_tlv *tl
 
   /* check for forced min length */
   if (tlv->length_len > 0) {
-    if (tlv->length_len < length_bytes_required) {
+    if ((tlv->length_len < length_bytes_required) || (tlv->length_len > sizeof(buf) - 1)) {
       /* unable to code requested length in requested number of bytes */
       return ERR_ARG;
     }
@@ -96,27 +97,24 @@ snmp_ans1_enc_tlv(struct snmp_pbuf_stream *pbuf_stream, struct snmp_asn1_tlv *tl
   if (length_bytes_required > 1) {
     /* multi byte representation required */
     length_bytes_required--;
-    data = 0x80 | length_bytes_required; /* extended length definition, 1 length byte follows */
-
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, data));
+    buf[pos++] = 0x80 | length_bytes_required; /* extended length definition, 1 length byte follows */
 
     while (length_bytes_required > 1) {
       if (length_bytes_required == 2) {
         /* append high byte */
-        data = (u8_t)(tlv->value_len >> 8);
+        buf[pos++] = (u8_t)(tlv->value_len >> 8);
       } else {
         /* append leading 0x00 */
-        data = 0x00;
+        buf[pos++] = 0x00;
       }
-
-      PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, data));
       length_bytes_required--;
     }
   }
 
   /* append low byte */
-  data = (u8_t)(tlv->value_len & 0xFF);
-  PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, data));
+  buf[pos++] = (u8_t)(tlv->value_len & 0xFF);
+  PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
+  tlv->type_len = 1;
 
   return ERR_OK;
 }
@@ -150,22 +148,26 @@ snmp_asn1_enc_raw(struct snmp_pbuf_stream *pbuf_stream, const u8_t *raw, u16_t r
 err_t
 snmp_asn1_enc_u32t(struct snmp_pbuf_stream *pbuf_stream, u16_t octets_needed, u32_t value)
 {
+  u8_t buf[5];
+  u8_t pos = 0;
+
   if (octets_needed > 5) {
     return ERR_ARG;
   }
   if (octets_needed == 5) {
     /* not enough bits in 'value' add leading 0x00 */
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, 0x00));
+    buf[pos++] = 0x00;
     octets_needed--;
   }
 
   while (octets_needed > 1) {
     octets_needed--;
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)(value >> (octets_needed << 3))));
+    buf[pos++] = (u8_t)(value >> (octets_needed << 3));
   }
 
   /* (only) one least significant octet */
-  PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)value));
+  buf[pos++] = (u8_t)value;
+  PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
 
   return ERR_OK;
 }
@@ -182,14 +184,21 @@ snmp_asn1_enc_u32t(struct snmp_pbuf_stream *pbuf_stream, u16_t octets_needed, u3
 err_t
 snmp_asn1_enc_s32t(struct snmp_pbuf_stream *pbuf_stream, u16_t octets_needed, s32_t value)
 {
+  u8_t buf[4];
+  u8_t pos = 0;
+
+  if (octets_needed > 4) {
+    return ERR_ARG;
+  }
+
   while (octets_needed > 1) {
     octets_needed--;
-
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)(value >> (octets_needed << 3))));
+    buf[pos++] = (u8_t)(value >> (octets_needed << 3));
   }
 
   /* (only) one least significant octet */
-  PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)value));
+  buf[pos++] = (u8_t)value;
+  PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
 
   return ERR_OK;
 }
@@ -205,10 +214,14 @@ snmp_asn1_enc_s32t(struct snmp_pbuf_stream *pbuf_stream, u16_t octets_needed, s3
 err_t
 snmp_asn1_enc_oid(struct snmp_pbuf_stream *pbuf_stream, const u32_t *oid, u16_t oid_len)
 {
+  /* sub-identifiers are collected and written in chunks, one sub-id takes up to 5 octets */
+  u8_t buf[32];
+  u8_t pos = 0;
+
   if (oid_len > 1) {
     /* write compressed first two sub id's */
     u32_t compressed_byte = ((oid[0] * 40) + oid[1]);
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)compressed_byte));
+    buf[pos++] = (u8_t)compressed_byte;
     oid_len -= 2;
     oid += 2;
   } else {
@@ -221,6 +234,11 @@ snmp_asn1_enc_oid(struct snmp_pbuf_stream *pbuf_stream, const u32_t *oid, u16_t
     u32_t sub_id;
     u8_t shift, tail;
 
+    if (pos > sizeof(buf) - 5) {
+      PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
+      pos = 0;
+    }
+
     oid_len--;
     sub_id = *oid;
     tail = 0;
@@ -231,15 +249,17 @@ snmp_asn1_enc_oid(struct snmp_pbuf_stream *pbuf_stream, const u32_t *oid, u16_t
       code = (u8_t)(sub_id >> shift);
       if ((code != 0) || (tail != 0)) {
         tail = 1;
-        PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, code | 0x80));
+        buf[pos++] = code | 0x80;
       }
       shift -= 7;
     }
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)sub_id & 0x7F));
+    buf[pos++] = (u8_t)sub_id & 0x7F;
 
     /* proceed to next sub-identifier */
     oid++;
   }
+  PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
+
   return ERR_OK;
 }
 
@@ -680,22 +700,26 @@ snmp_asn1_dec_u64t(struct snmp_pbuf_stream *pbuf_stream, u16_t len, u64_t *value
 err_t
 snmp_asn1_enc_u64t(struct snmp_pbuf_stream *pbuf_stream, u16_t octets_needed, u64_t value)
 {
+  u8_t buf[9];
+  u8_t pos = 0;
+
   if (octets_needed > 9) {
     return ERR_ARG;
   }
   if (octets_needed == 9) {
     /* not enough bits in 'value' add leading 0x00 */
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, 0x00));
+    buf[pos++] = 0x00;
     octets_needed--;
   }
 
   while (octets_needed > 1) {
     octets_needed--;
-    PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)(value >> (octets_needed << 3))));
+    buf[pos++] = (u8_t)(value >> (octets_needed << 3));
   }
 
   /* always write at least one octet (also in case of value == 0) */
-  PBUF_OP_EXEC(snmp_pbuf_stream_write(pbuf_stream, (u8_t)(value)));
+  buf[pos++] = (u8_t)(value);
+  PBUF_OP_EXEC(snmp_pbuf_stream_writebuf(pbuf_stream, buf, pos));
 
   return ERR_OK;
 }
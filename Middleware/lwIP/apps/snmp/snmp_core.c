@@ -1171,6 +1171,145 @@ snmp_next_oid_check(struct snmp_next_oid_state *state, const u32_t *oid, u8_t oi
   return 0;
 }
 
+#if SNMP_ROW_INDEX
+/** incremented around each request, an index built under another value is stale */
+static u16_t snmp_row_index_epoch = 1;
+
+/** makes all row indexes stale; called before and after each request because
+the objects referenced by the rows (e.g. tcp_pcbs) may change in between */
+void
+snmp_row_index_expire(void)
+{
+  snmp_row_index_epoch++;
+  if (snmp_row_index_epoch == 0) {
+    /* 0 marks an index never built */
+    snmp_row_index_epoch = 1;
+  }
+}
+
+/** returns !=0 if the index was built during the current request */
+u8_t
+snmp_row_index_current(const struct snmp_row_index *index)
+{
+  return (index->epoch == snmp_row_index_epoch) ? 1 : 0;
+}
+
+/** starts collecting the rows of a table with snmp_row_index_add() */
+void
+snmp_row_index_begin(struct snmp_row_index *index)
+{
+  index->count    = 0;
+  index->overflow = 0;
+  index->changed  = 0;
+  index->epoch    = snmp_row_index_epoch;
+}
+
+/** adds a row in any order; if it does not fit the index is marked as overflowed.
+The rows of a table are mostly the same from one request to the next: a row equal
+to the one added at the same position last time keeps the previous order. */
+void
+snmp_row_index_add(struct snmp_row_index *index, const u32_t *oid, u8_t oid_len, void *reference)
+{
+  struct snmp_row_index_entry *row;
+
+  if (index->overflow) {
+    return;
+  }
+  if ((index->count >= index->size) || (oid_len > SNMP_ROW_INDEX_OID_LEN)) {
+    index->overflow     = 1;
+    index->sorted_count = 0;
+    return;
+  }
+
+  row = &index->rows[index->count];
+  if (index->changed || (index->count >= index->sorted_count) || (row->reference != reference) ||
+      (row->oid_len != oid_len) || (memcmp(row->oid, oid, oid_len * sizeof(u32_t)) != 0)) {
+    MEMCPY(row->oid, oid, oid_len * sizeof(u32_t));
+    row->oid_len   = oid_len;
+    row->reference = reference;
+    index->changed = 1;
+  }
+  index->count++;
+}
+
+static s8_t
+snmp_row_index_compare(const struct snmp_row_index_entry *rows, u16_t a, u16_t b)
+{
+  return snmp_oid_compare(rows[a].oid, rows[a].oid_len, rows[b].oid, rows[b].oid_len);
+}
+
+static void
+snmp_row_index_sift(struct snmp_row_index_entry *rows, u16_t root, u16_t count)
+{
+  while ((u32_t)root * 2 + 1 < count) {
+    u16_t child = (u16_t)(root * 2 + 1);
+    u16_t tmp;
+
+    if ((child + 1 < count) && (snmp_row_index_compare(rows, rows[child].order, rows[child + 1].order) < 0)) {
+      child++;
+    }
+    if (snmp_row_index_compare(rows, rows[root].order, rows[child].order) >= 0) {
+      return;
+    }
+
+    tmp               = rows[root].order;
+    rows[root].order  = rows[child].order;
+    rows[child].order = tmp;
+    root = child;
+  }
+}
+
+/** sorts the order of the collected rows if they changed (heapsort, no recursion and no extra memory) */
+void
+snmp_row_index_end(struct snmp_row_index *index)
+{
+  struct snmp_row_index_entry *rows = index->rows;
+  u16_t i, tmp;
+
+  if (index->overflow || (!index->changed && (index->count == index->sorted_count))) {
+    return;
+  }
+
+  for (i = 0; i < index->count; i++) {
+    rows[i].order = i;
+  }
+  for (i = (u16_t)(index->count / 2); i > 0; i--) {
+    snmp_row_index_sift(rows, (u16_t)(i - 1), index->count);
+  }
+  for (i = (u16_t)(index->count - 1); (i > 0) && (i < index->count); i--) {
+    tmp           = rows[0].order;
+    rows[0].order = rows[i].order;
+    rows[i].order = tmp;
+    snmp_row_index_sift(rows, 0, i);
+  }
+  index->sorted_count = index->count;
+}
+
+/** returns the first row located behind the passed OID or NULL */
+const struct snmp_row_index_entry *
+snmp_row_index_next(const struct snmp_row_index *index, const u32_t *oid, u8_t oid_len)
+{
+  const struct snmp_row_index_entry *rows = index->rows;
+  u16_t lo = 0;
+  u16_t hi = index->count;
+
+  LWIP_ASSERT("index overflowed, scan the table instead", !index->overflow);
+
+  while (lo < hi) {
+    u16_t mid = (u16_t)((lo + hi) / 2);
+    const struct snmp_row_index_entry *row = &rows[rows[mid].order];
+
+    if (snmp_oid_compare(row->oid, row->oid_len, oid, oid_len) > 0) {
+      hi = mid;
+    } else {
+      lo = (u16_t)(mid + 1);
+    }
+  }
+
+  return (lo < index->count) ? &rows[rows[lo].order] : NULL;
+}
+#endif /* SNMP_ROW_INDEX */
+
 u8_t
 snmp_oid_in_range(const u32_t *oid_in, u8_t oid_len, const struct snmp_oid_range *oid_ranges, u8_t oid_ranges_len)
 {
@@ -120,6 +120,11 @@ interfaces_Table_get_cell_instance(const u32_t *column, const u32_t *row_oid, u8
   return SNMP_ERR_NOSUCHINSTANCE;
 }
 
+#if SNMP_ROW_INDEX
+static struct snmp_row_index_entry interfaces_Table_rows[SNMP_ROW_INDEX_ROWS];
+static struct snmp_row_index interfaces_Table_index = SNMP_ROW_INDEX_CREATE(interfaces_Table_rows);
+#endif
+
 static snmp_err_t
 interfaces_Table_get_next_cell_instance(const u32_t *column, struct snmp_obj_id *row_oid, struct snmp_node_instance *cell_instance)
 {
@@ -129,6 +134,29 @@ interfaces_Table_get_next_cell_instance(const u32_t *column, struct snmp_obj_id
 
   LWIP_UNUSED_ARG(column);
 
+#if SNMP_ROW_INDEX
+  if (!snmp_row_index_current(&interfaces_Table_index)) {
+    snmp_row_index_begin(&interfaces_Table_index);
+    NETIF_FOREACH(netif) {
+      u32_t test_oid[LWIP_ARRAYSIZE(interfaces_Table_oid_ranges)];
+      test_oid[0] = netif_to_num(netif);
+      snmp_row_index_add(&interfaces_Table_index, test_oid, LWIP_ARRAYSIZE(interfaces_Table_oid_ranges), netif);
+    }
+    snmp_row_index_end(&interfaces_Table_index);
+  }
+
+  if (!interfaces_Table_index.overflow) {
+    const struct snmp_row_index_entry *row = snmp_row_index_next(&interfaces_Table_index, row_oid->id, row_oid->len);
+    if (row == NULL) {
+      return SNMP_ERR_NOSUCHINSTANCE;
+    }
+    snmp_oid_assign(row_oid, row->oid, row->oid_len);
+    /* store netif pointer for subsequent operations (get/test/set) */
+    cell_instance->reference.ptr = row->reference;
+    return SNMP_ERR_NOERROR;
+  }
+#endif
+
   /* init struct to search next oid */
   snmp_next_oid_init(&state, row_oid->id, row_oid->len, result_temp, LWIP_ARRAYSIZE(interfaces_Table_oid_ranges));
 
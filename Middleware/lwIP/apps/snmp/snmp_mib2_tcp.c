@@ -252,6 +252,37 @@ tcp_ConnTable_get_cell_value(const u32_t *column, const u32_t *row_oid, u8_t row
   return SNMP_ERR_NOSUCHINSTANCE;
 }
 
+/* builds the row OID of a pcb, returns 0 if the pcb is no row of tcpConnTable */
+static u8_t
+tcp_ConnTable_row_oid(const struct tcp_pcb *pcb, u32_t *oid)
+{
+  if (!IP_IS_V4_VAL(pcb->local_ip)) {
+    return 0;
+  }
+
+  snmp_ip4_to_oid(ip_2_ip4(&pcb->local_ip), &oid[0]);
+  oid[4] = pcb->local_port;
+
+  /* PCBs in state LISTEN are not connected and have no remote_ip or remote_port */
+  if (pcb->state == LISTEN) {
+    snmp_ip4_to_oid(IP4_ADDR_ANY4, &oid[5]);
+    oid[9] = 0;
+  } else {
+    if (IP_IS_V6_VAL(pcb->remote_ip)) { /* should never happen */
+      return 0;
+    }
+    snmp_ip4_to_oid(ip_2_ip4(&pcb->remote_ip), &oid[5]);
+    oid[9] = pcb->remote_port;
+  }
+
+  return 1;
+}
+
+#if SNMP_ROW_INDEX
+static struct snmp_row_index_entry tcp_ConnTable_rows[SNMP_ROW_INDEX_ROWS];
+static struct snmp_row_index tcp_ConnTable_index = SNMP_ROW_INDEX_CREATE(tcp_ConnTable_rows);
+#endif
+
 static snmp_err_t
 tcp_ConnTable_get_next_cell_instance_and_value(const u32_t *column, struct snmp_obj_id *row_oid, union snmp_variant_value *value, u32_t *value_len)
 {
@@ -259,37 +290,42 @@ tcp_ConnTable_get_next_cell_instance_and_value(const u32_t *column, struct snmp_
   struct tcp_pcb *pcb;
   struct snmp_next_oid_state state;
   u32_t result_temp[LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges)];
+  u32_t test_oid[LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges)];
+
+#if SNMP_ROW_INDEX
+  if (!snmp_row_index_current(&tcp_ConnTable_index)) {
+    snmp_row_index_begin(&tcp_ConnTable_index);
+    for (i = 0; i < LWIP_ARRAYSIZE(tcp_pcb_lists); i++) {
+      for (pcb = *tcp_pcb_lists[i]; pcb != NULL; pcb = pcb->next) {
+        if (tcp_ConnTable_row_oid(pcb, test_oid)) {
+          snmp_row_index_add(&tcp_ConnTable_index, test_oid, LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges), pcb);
+        }
+      }
+    }
+    snmp_row_index_end(&tcp_ConnTable_index);
+  }
+
+  if (!tcp_ConnTable_index.overflow) {
+    const struct snmp_row_index_entry *row = snmp_row_index_next(&tcp_ConnTable_index, row_oid->id, row_oid->len);
+    if (row == NULL) {
+      return SNMP_ERR_NOSUCHINSTANCE;
+    }
+    snmp_oid_assign(row_oid, row->oid, row->oid_len);
+    /* fill in object properties */
+    return tcp_ConnTable_get_cell_value_core((struct tcp_pcb *)row->reference, column, value, value_len);
+  }
+#endif
 
   /* init struct to search next oid */
   snmp_next_oid_init(&state, row_oid->id, row_oid->len, result_temp, LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges));
 
   /* iterate over all possible OIDs to find the next one */
   for (i = 0; i < LWIP_ARRAYSIZE(tcp_pcb_lists); i++) {
-    pcb = *tcp_pcb_lists[i];
-    while (pcb != NULL) {
-      u32_t test_oid[LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges)];
-
-      if (IP_IS_V4_VAL(pcb->local_ip)) {
-        snmp_ip4_to_oid(ip_2_ip4(&pcb->local_ip), &test_oid[0]);
-        test_oid[4] = pcb->local_port;
-
-        /* PCBs in state LISTEN are not connected and have no remote_ip or remote_port */
-        if (pcb->state == LISTEN) {
-          snmp_ip4_to_oid(IP4_ADDR_ANY4, &test_oid[5]);
-          test_oid[9] = 0;
-        } else {
-          if (IP_IS_V6_VAL(pcb->remote_ip)) { /* should never happen */
-            continue;
-          }
-          snmp_ip4_to_oid(ip_2_ip4(&pcb->remote_ip), &test_oid[5]);
-          test_oid[9] = pcb->remote_port;
-        }
-
-        /* check generated OID: is it a candidate for the next one? */
+    for (pcb = *tcp_pcb_lists[i]; pcb != NULL; pcb = pcb->next) {
+      /* check generated OID: is it a candidate for the next one? */
+      if (tcp_ConnTable_row_oid(pcb, test_oid)) {
         snmp_next_oid_check(&state, test_oid, LWIP_ARRAYSIZE(tcp_ConnTable_oid_ranges), pcb);
       }
-
-      pcb = pcb->next;
     }
   }
 
@@ -370,6 +406,11 @@ tcp_ConnectionTable_get_cell_value(const u32_t *column, const u32_t *row_oid, u8
   return SNMP_ERR_NOSUCHINSTANCE;
 }
 
+#if SNMP_ROW_INDEX
+static struct snmp_row_index_entry tcp_ConnectionTable_rows[SNMP_ROW_INDEX_ROWS];
+static struct snmp_row_index tcp_ConnectionTable_index = SNMP_ROW_INDEX_CREATE(tcp_ConnectionTable_rows);
+#endif
+
 static snmp_err_t
 tcp_ConnectionTable_get_next_cell_instance_and_value(const u32_t *column, struct snmp_obj_id *row_oid, union snmp_variant_value *value, u32_t *value_len)
 {
@@ -383,6 +424,33 @@ tcp_ConnectionTable_get_next_cell_instance_and_value(const u32_t *column, struct
 
   LWIP_UNUSED_ARG(value_len);
 
+#if SNMP_ROW_INDEX
+  if (!snmp_row_index_current(&tcp_ConnectionTable_index)) {
+    snmp_row_index_begin(&tcp_ConnectionTable_index);
+    for (i = 0; i < LWIP_ARRAYSIZE(tcp_pcb_nonlisten_lists); i++) {
+      for (pcb = *tcp_pcb_nonlisten_lists[i]; pcb != NULL; pcb = pcb->next) {
+        u8_t idx = 0;
+        u32_t test_oid[LWIP_ARRAYSIZE(result_temp)];
+
+        idx += snmp_ip_port_to_oid(&pcb->local_ip, pcb->local_port, &test_oid[idx]);
+        idx += snmp_ip_port_to_oid(&pcb->remote_ip, pcb->remote_port, &test_oid[idx]);
+        snmp_row_index_add(&tcp_ConnectionTable_index, test_oid, idx, pcb);
+      }
+    }
+    snmp_row_index_end(&tcp_ConnectionTable_index);
+  }
+
+  if (!tcp_ConnectionTable_index.overflow) {
+    const struct snmp_row_index_entry *row = snmp_row_index_next(&tcp_ConnectionTable_index, row_oid->id, row_oid->len);
+    if (row == NULL) {
+      return SNMP_ERR_NOSUCHINSTANCE;
+    }
+    snmp_oid_assign(row_oid, row->oid, row->oid_len);
+    /* fill in object properties */
+    return tcp_ConnectionTable_get_cell_value_core(column, (struct tcp_pcb *)row->reference, value);
+  }
+#endif
+
   /* init struct to search next oid */
   snmp_next_oid_init(&state, row_oid->id, row_oid->len, result_temp, LWIP_ARRAYSIZE(result_temp));
 
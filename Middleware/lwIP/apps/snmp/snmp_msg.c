@@ -281,6 +281,10 @@ snmp_receive(void *handle, struct pbuf *p, const ip_addr_t *source_ip, u16_t por
   request.inbound_pbuf = p;
 
   snmp_stats.inpkts++;
+#if SNMP_ROW_INDEX
+  /* table indexes are built anew for this request */
+  snmp_row_index_expire();
+#endif
 
   err = snmp_parse_inbound_frame(&request);
   if (err == ERR_OK) {
@@ -380,6 +384,11 @@ snmp_receive(void *handle, struct pbuf *p, const ip_addr_t *source_ip, u16_t por
       pbuf_free(request.outbound_pbuf);
     }
   }
+
+#if SNMP_ROW_INDEX
+  /* the rows may reference objects that do not outlive the request */
+  snmp_row_index_expire();
+#endif
 }
 
 static u8_t
@@ -60,7 +60,10 @@ snmp_pbuf_stream_read(struct snmp_pbuf_stream *pbuf_stream, u8_t *data)
     return ERR_BUF;
   }
 
-  if (pbuf_copy_partial(pbuf_stream->pbuf, data, 1, pbuf_stream->offset) == 0) {
+  if (pbuf_stream->offset < pbuf_stream->pbuf->len) {
+    /* byte in the first pbuf, read the payload directly */
+    *data = ((const u8_t *)pbuf_stream->pbuf->payload)[pbuf_stream->offset];
+  } else if (pbuf_copy_partial(pbuf_stream->pbuf, data, 1, pbuf_stream->offset) == 0) {
     return ERR_BUF;
   }
 
@@ -73,6 +76,13 @@ snmp_pbuf_stream_read(struct snmp_pbuf_stream *pbuf_stream, u8_t *data)
 err_t
 snmp_pbuf_stream_write(struct snmp_pbuf_stream *pbuf_stream, u8_t data)
 {
+  if ((pbuf_stream->length > 0) && (pbuf_stream->offset < pbuf_stream->pbuf->len)) {
+    ((u8_t *)pbuf_stream->pbuf->payload)[pbuf_stream->offset] = data;
+    pbuf_stream->offset++;
+    pbuf_stream->length--;
+    return ERR_OK;
+  }
+
   return snmp_pbuf_stream_writebuf(pbuf_stream, &data, 1);
 }
 
@@ -83,7 +93,11 @@ snmp_pbuf_stream_writebuf(struct snmp_pbuf_stream *pbuf_stream, const void *buf,
     return ERR_BUF;
   }
 
-  if (pbuf_take_at(pbuf_stream->pbuf, buf, buf_len, pbuf_stream->offset) != ERR_OK) {
+  if ((u32_t)pbuf_stream->offset + buf_len <= pbuf_stream->pbuf->len) {
+    /* the outbound frame is one PBUF_RAM: copy straight into its payload
+       instead of walking the chain in pbuf_take_at() */
+    MEMCPY(&((u8_t *)pbuf_stream->pbuf->payload)[pbuf_stream->offset], buf, buf_len);
+  } else if (pbuf_take_at(pbuf_stream->pbuf, buf, buf_len, pbuf_stream->offset) != ERR_OK) {
     return ERR_BUF;
   }
 
@@ -45,6 +45,10 @@
  * For a list of some public NTP servers, see this link:
  * http://support.ntp.org/bin/view/Servers/NTPPoolServers
  *
+ * With SNTP_HIGH_PRECISION, all servers are polled and their offsets
+ * filtered and combined as in RFC 5905 to slew a nanosecond clock through
+ * SNTP_UPDATE_CLOCK() instead of setting the time.
+ *
  * @todo:
  * - complete SNTP_CHECK_RESPONSE checks 3 and 4
  */
@@ -62,6 +66,10 @@
 #include <string.h>
 #include <time.h>
 
+#ifdef LWIP_HOOK_FILENAME
+#include LWIP_HOOK_FILENAME
+#endif
+
 #if LWIP_UDP
 
 /* Handle support for more than one server via SNTP_MAX_SERVERS */
@@ -75,6 +83,13 @@
 #if SNTP_UPDATE_DELAY < 15000
 #error "SNTPv4 RFC 4330 enforces a minimum update time of 15 seconds (define SNTP_SUPPRESS_DELAY_CHECK to disable this error)!"
 #endif
+#if SNTP_HIGH_PRECISION && SNTP_POLL_INTERVAL < 15000
+#error "SNTPv4 RFC 4330 enforces a minimum update time of 15 seconds (define SNTP_SUPPRESS_DELAY_CHECK to disable this error)!"
+#endif
+#endif
+
+#if SNTP_HIGH_PRECISION && !LWIP_HAVE_INT64
+#error "SNTP high precision mode requires 64-bit arithmetic"
 #endif
 
 /* the various debug levels for this file */
@@ -114,6 +129,17 @@
 /* Number of seconds between 1970 and Feb 7, 2036 06:28:16 UTC (epoch 1) */
 #define DIFF_SEC_1970_2036          ((u32_t)2085978496L)
 
+#if SNTP_HIGH_PRECISION
+#define SNTP_NS_PER_SEC             1000000000LL
+/* Dispersion growth of a sample with its age, RFC 5905 7.2 (15 ppm) */
+#define SNTP_PHI_PPM                15
+/* Time stamps read from the clock if not from the hardware */
+#ifndef SNTP_GET_TIME_NS
+# define SNTP_GET_TIME_NS()         sntp_get_system_time_ns()
+# define SNTP_GET_SYSTEM_TIME_NS    1
+#endif
+#endif /* SNTP_HIGH_PRECISION */
+
 /** Convert NTP timestamp fraction to microseconds.
  */
 #ifndef SNTP_FRAC_TO_US
@@ -217,6 +243,18 @@ PACK_STRUCT_END
 #  include "arch/epstruct.h"
 #endif
 
+#if SNTP_HIGH_PRECISION
+/**
+ * One offset measurement of a server, nanoseconds.
+ */
+struct sntp_sample {
+  s64_t offset; /* clock minus server */
+  s64_t delay;  /* round trip, without the time the server held the request */
+  s64_t local;  /* clock when the response was received */
+  s64_t root;   /* root delay / 2 + root dispersion the server reported */
+};
+#endif /* SNTP_HIGH_PRECISION */
+
 /* function prototypes */
 static void sntp_request(void *arg);
 
@@ -235,18 +273,41 @@ struct sntp_server {
   /** Reachability shift register as described in RFC 5905 */
   u8_t reachability;
 #endif /* SNTP_MONITOR_SERVER_REACHABILITY */
+#if SNTP_HIGH_PRECISION
+  /** Request waiting for its response, holds the transmit time stamp */
+  struct pbuf *req;
+  /** Transmit timestamp sent, network byte order, the response echoes it */
+  struct sntp_time req_xmt;
+  /** Clock when the request was sent, if the hardware has no time stamp */
+  s64_t req_t1;
+  /** Clock filter, the last SNTP_FILTER_SIZE samples */
+  struct sntp_sample filter[SNTP_FILTER_SIZE];
+  u8_t filter_count;
+  u8_t filter_next;
+  /** Polls in a row without response */
+  u8_t missed;
+  /** Agreed with the majority in the last selection */
+  u8_t selected;
+#endif /* SNTP_HIGH_PRECISION */
 };
 static struct sntp_server sntp_servers[SNTP_MAX_SERVERS];
 
 #if SNTP_GET_SERVERS_FROM_DHCP || SNTP_GET_SERVERS_FROM_DHCPV6
 static u8_t sntp_set_servers_from_dhcp;
 #endif /* SNTP_GET_SERVERS_FROM_DHCP || SNTP_GET_SERVERS_FROM_DHCPV6 */
-#if SNTP_SUPPORT_MULTIPLE_SERVERS
+#if SNTP_SUPPORT_MULTIPLE_SERVERS && !SNTP_HIGH_PRECISION
 /** The currently used server (initialized to 0) */
 static u8_t sntp_current_server;
-#else /* SNTP_SUPPORT_MULTIPLE_SERVERS */
+#else /* SNTP_SUPPORT_MULTIPLE_SERVERS && !SNTP_HIGH_PRECISION */
 #define sntp_current_server 0
-#endif /* SNTP_SUPPORT_MULTIPLE_SERVERS */
+#endif /* SNTP_SUPPORT_MULTIPLE_SERVERS && !SNTP_HIGH_PRECISION */
+
+#if SNTP_HIGH_PRECISION
+/** The server the last update was based on (SNTP_MAX_SERVERS if none) */
+static u8_t sntp_sys_peer = SNTP_MAX_SERVERS;
+/** Clock when the last sample passed to SNTP_UPDATE_CLOCK was received */
+static s64_t sntp_last_update;
+#endif /* SNTP_HIGH_PRECISION */
 
 #if SNTP_RETRY_TIMEOUT_EXP
 #define SNTP_RESET_RETRY_TIMEOUT() sntp_retry_timeout = SNTP_RETRY_TIMEOUT
@@ -257,16 +318,16 @@ static u32_t sntp_retry_timeout;
 #define sntp_retry_timeout SNTP_RETRY_TIMEOUT
 #endif /* SNTP_RETRY_TIMEOUT_EXP */
 
-#if SNTP_CHECK_RESPONSE >= 1
+#if SNTP_CHECK_RESPONSE >= 1 && !SNTP_HIGH_PRECISION
 /** Saves the last server address to compare with response */
 static ip_addr_t sntp_last_server_address;
-#endif /* SNTP_CHECK_RESPONSE >= 1 */
+#endif /* SNTP_CHECK_RESPONSE >= 1 && !SNTP_HIGH_PRECISION */
 
-#if SNTP_CHECK_RESPONSE >= 2
+#if SNTP_CHECK_RESPONSE >= 2 && !SNTP_HIGH_PRECISION
 /** Saves the last timestamp sent (which is sent back by the server)
  * to compare against in response. Stored in network byte order. */
 static struct sntp_time sntp_last_timestamp_sent;
-#endif /* SNTP_CHECK_RESPONSE >= 2 */
+#endif /* SNTP_CHECK_RESPONSE >= 2 && !SNTP_HIGH_PRECISION */
 
 #if defined(LWIP_DEBUG) && !defined(sntp_format_time)
 /* Debug print helper. */
@@ -279,6 +340,417 @@ sntp_format_time(s32_t sec)
 }
 #endif /* LWIP_DEBUG && !sntp_format_time */
 
+#if SNTP_HIGH_PRECISION
+
+#ifdef SNTP_GET_SYSTEM_TIME_NS
+/**
+ * SNTP_GET_SYSTEM_TIME in nanoseconds since 1970
+ */
+static s64_t
+sntp_get_system_time_ns(void)
+{
+  u32_t sec, us;
+
+  SNTP_GET_SYSTEM_TIME(sec, us);
+  return (s64_t)sec * SNTP_NS_PER_SEC + (s64_t)us * 1000;
+}
+#endif /* SNTP_GET_SYSTEM_TIME_NS */
+
+/**
+ * NTP timestamp (network byte order) to nanoseconds since 1970
+ */
+static s64_t
+sntp_time_to_ns(u32_t sec, u32_t frac)
+{
+  u32_t unix_sec = (u32_t)((s32_t)lwip_ntohl(sec) + DIFF_SEC_1970_2036);
+
+  return (s64_t)unix_sec * SNTP_NS_PER_SEC +
+         (s64_t)(((u64_t)lwip_ntohl(frac) * SNTP_NS_PER_SEC) >> 32);
+}
+
+/**
+ * Nanoseconds since 1970 to an NTP timestamp (network byte order)
+ */
+static void
+sntp_ns_to_time(s64_t ns, struct sntp_time *t)
+{
+  u32_t sec = (u32_t)(ns / SNTP_NS_PER_SEC) - DIFF_SEC_1970_2036;
+  u32_t frac = (u32_t)((((u64_t)(ns % SNTP_NS_PER_SEC)) << 32) / SNTP_NS_PER_SEC);
+
+  t->sec = lwip_htonl(sec);
+  t->frac = lwip_htonl(frac);
+}
+
+/**
+ * NTP short format (16.16 seconds, network byte order) to nanoseconds
+ */
+static s64_t
+sntp_short_to_ns(u32_t v)
+{
+  return (s64_t)(((u64_t)lwip_ntohl(v) * SNTP_NS_PER_SEC) >> 16);
+}
+
+/**
+ * Forget the request in flight, a late response is ignored.
+ */
+static void
+sntp_drop_request(struct sntp_server *server)
+{
+  if (server->req != NULL) {
+    pbuf_free(server->req);
+    server->req = NULL;
+  }
+  server->req_xmt.sec = 0;
+  server->req_xmt.frac = 0;
+}
+
+/**
+ * Drop the request and the samples of a server, e.g. after the clock was
+ * stepped or the server changed.
+ */
+static void
+sntp_reset_server(struct sntp_server *server)
+{
+  sntp_drop_request(server);
+  server->filter_count = 0;
+  server->filter_next = 0;
+  server->missed = 0;
+  server->selected = 0;
+}
+
+/**
+ * Clock filter: the sample of least delay is the most accurate one, the
+ * offsets of the others from it are the jitter of the server.
+ *
+ * @return the sample of least delay, NULL if there are none
+ */
+static const struct sntp_sample *
+sntp_filter(const struct sntp_server *server, s64_t *jitter)
+{
+  const struct sntp_sample *best = NULL;
+  s64_t sum = 0;
+  u8_t i;
+
+  for (i = 0; i < server->filter_count; i++) {
+    if (best == NULL || server->filter[i].delay < best->delay) {
+      best = &server->filter[i];
+    }
+  }
+  if (best == NULL) {
+    return NULL;
+  }
+  for (i = 0; i < server->filter_count; i++) {
+    s64_t d = server->filter[i].offset - best->offset;
+    sum += (d < 0) ? -d : d;
+  }
+  *jitter = (server->filter_count > 1) ? sum / (server->filter_count - 1) : 0;
+  return best;
+}
+
+/**
+ * Root distance of a server: the most its offset can be wrong by, growing
+ * with the age of the sample.
+ */
+static s64_t
+sntp_distance(const struct sntp_sample *best, s64_t jitter, s64_t now)
+{
+  s64_t age = now - best->local;
+
+  if (age < 0) {
+    age = 0;
+  }
+  return best->delay / 2 + best->root + jitter + age / 1000000 * SNTP_PHI_PPM + 1;
+}
+
+/**
+ * Select the servers whose offsets agree (the largest set of intervals
+ * offset +- distance with a common point, which must be a majority),
+ * combine their offsets weighted by distance and pass the result on if the
+ * best of them has a sample not used yet.
+ */
+static void
+sntp_update(s64_t now)
+{
+  const struct sntp_sample *best[SNTP_MAX_SERVERS];
+  s64_t dist[SNTP_MAX_SERVERS];
+  s64_t jitter, offset, sum, wsum;
+  u8_t i, j, n = 0, count, max_count = 0, sys = SNTP_MAX_SERVERS;
+  s64_t point = 0;
+
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    best[i] = sntp_filter(&sntp_servers[i], &jitter);
+    sntp_servers[i].selected = 0;
+    if (best[i] != NULL) {
+      dist[i] = sntp_distance(best[i], jitter, now);
+      n++;
+    }
+  }
+
+  /* the intersection is largest at the lower end of one of the intervals */
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    if (best[i] == NULL) {
+      continue;
+    }
+    count = 0;
+    for (j = 0; j < SNTP_MAX_SERVERS; j++) {
+      if (best[j] != NULL &&
+          best[j]->offset - dist[j] <= best[i]->offset - dist[i] &&
+          best[i]->offset - dist[i] <= best[j]->offset + dist[j]) {
+        count++;
+      }
+    }
+    if (count > max_count) {
+      max_count = count;
+      point = best[i]->offset - dist[i];
+    }
+  }
+  if (max_count == 0 || 2 * max_count <= n) {
+    LWIP_DEBUGF(SNTP_DEBUG_WARN, ("sntp_update: no majority of %"U16_F" servers agrees\n", (u16_t)n));
+    return;
+  }
+
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    if (best[i] != NULL && best[i]->offset - dist[i] <= point &&
+        point <= best[i]->offset + dist[i]) {
+      sntp_servers[i].selected = 1;
+      if (sys == SNTP_MAX_SERVERS || dist[i] < dist[sys]) {
+        sys = i;
+      }
+    }
+  }
+
+  /* relative to the system peer, the offsets before the first step are
+   * decades */
+  sum = 0;
+  wsum = 0;
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    if (sntp_servers[i].selected) {
+      s64_t w = (1LL << 30) / (dist[i] / 1000 + 1);
+      sum += w * (best[i]->offset - best[sys]->offset);
+      wsum += w;
+    }
+  }
+  offset = best[sys]->offset + sum / wsum;
+  sntp_sys_peer = sys;
+
+  if (best[sys]->local <= sntp_last_update ||
+      sntp_servers[sys].filter_count < (SNTP_FILTER_SIZE + 1) / 2) {
+    /* nothing new, or too few samples to trust the least delay one */
+    return;
+  }
+  sntp_last_update = best[sys]->local;
+
+  LWIP_DEBUGF(SNTP_DEBUG_TRACE, ("sntp_update: %s, offset %"S32_F" us from %"U16_F" servers\n",
+                                 sntp_format_time((s32_t)((u32_t)(now / SNTP_NS_PER_SEC) - DIFF_SEC_1970_2036)),
+                                 (s32_t)(offset / 1000), (u16_t)max_count));
+  if (SNTP_UPDATE_CLOCK(offset, best[sys]->delay, best[sys]->local)) {
+    /* the samples are relative to the clock before the step */
+    LWIP_DEBUGF(SNTP_DEBUG_STATE, ("sntp_update: clock stepped\n"));
+    for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+      sntp_reset_server(&sntp_servers[i]);
+    }
+    sntp_last_update = 0;
+    sntp_sys_peer = SNTP_MAX_SERVERS;
+  }
+}
+
+/** UDP recv callback for the sntp pcb, high precision mode */
+static void
+sntp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port)
+{
+  struct sntp_server *server = NULL;
+  struct sntp_sample *sample;
+  struct sntp_msg msg;
+  s64_t t1, t2, t3, t4;
+  u8_t i;
+
+  LWIP_UNUSED_ARG(arg);
+  LWIP_UNUSED_ARG(pcb);
+
+  /* destination time stamp, before anything else */
+  if (!SNTP_PBUF_TIME_NS(p, t4)) {
+    t4 = SNTP_GET_TIME_NS();
+  }
+
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    if (sntp_servers[i].req_xmt.sec != 0 && ip_addr_cmp(addr, &sntp_servers[i].addr)) {
+      server = &sntp_servers[i];
+      break;
+    }
+  }
+  if (server == NULL || port != SNTP_PORT || p->tot_len != SNTP_MSG_LEN) {
+    LWIP_DEBUGF(SNTP_DEBUG_WARN, ("sntp_recv: Unexpected packet\n"));
+    pbuf_free(p);
+    return;
+  }
+  pbuf_copy_partial(p, &msg, SNTP_MSG_LEN, 0);
+  pbuf_free(p);
+
+  if ((msg.li_vn_mode & SNTP_MODE_MASK) != SNTP_MODE_SERVER ||
+      msg.originate_timestamp[0] != server->req_xmt.sec ||
+      msg.originate_timestamp[1] != server->req_xmt.frac) {
+    /* wait for the response to the request in flight */
+    LWIP_DEBUGF(SNTP_DEBUG_WARN, ("sntp_recv: Invalid mode or originate timestamp in response\n"));
+    return;
+  }
+
+  /* transmit time stamp of the request, after the MAC sent it */
+  if (!SNTP_PBUF_TIME_NS(server->req, t1)) {
+    t1 = server->req_t1;
+  }
+  sntp_drop_request(server);
+  server->missed = 0;
+
+  if (msg.stratum == SNTP_STRATUM_KOD || msg.stratum >= 16 ||
+      (msg.li_vn_mode & SNTP_LI_MASK) == SNTP_LI_ALARM_CONDITION) {
+    /* Kiss-of-Death or not synchronized itself, its samples are stale */
+    LWIP_DEBUGF(SNTP_DEBUG_STATE, ("sntp_recv: Server not synchronized or Kiss-of-Death\n"));
+    server->filter_count = 0;
+    server->filter_next = 0;
+    return;
+  }
+
+#if SNTP_MONITOR_SERVER_REACHABILITY
+  server->reachability |= 1;
+#endif /* SNTP_MONITOR_SERVER_REACHABILITY */
+
+  t2 = sntp_time_to_ns(msg.receive_timestamp[0], msg.receive_timestamp[1]);
+  t3 = sntp_time_to_ns(msg.transmit_timestamp[0], msg.transmit_timestamp[1]);
+
+  sample = &server->filter[server->filter_next];
+  server->filter_next = (u8_t)((server->filter_next + 1) % SNTP_FILTER_SIZE);
+  if (server->filter_count < SNTP_FILTER_SIZE) {
+    server->filter_count++;
+  }
+  /* Clock offset and round-trip delay according to RFC 5905 8 */
+  sample->offset = ((t1 - t2) + (t4 - t3)) / 2;
+  sample->delay = (t4 - t1) - (t3 - t2);
+  if (sample->delay < 0) {
+    sample->delay = 0;
+  }
+  sample->local = t4;
+  sample->root = sntp_short_to_ns(msg.root_delay) / 2 + sntp_short_to_ns(msg.root_dispersion);
+}
+
+/** Send a request to a server, high precision mode */
+static void
+sntp_send_request(struct sntp_server *server)
+{
+  struct pbuf *p;
+  struct sntp_msg *msg;
+
+  p = pbuf_alloc(PBUF_TRANSPORT, SNTP_MSG_LEN, PBUF_RAM);
+  if (p == NULL) {
+    LWIP_DEBUGF(SNTP_DEBUG_SERIOUS, ("sntp_send_request: Out of memory\n"));
+    return;
+  }
+  msg = (struct sntp_msg *)p->payload;
+  memset(msg, 0, SNTP_MSG_LEN);
+  msg->li_vn_mode = SNTP_LI_NO_WARNING | SNTP_VERSION | SNTP_MODE_CLIENT;
+
+  /* the software transmit time stamp, replaced by the hardware one if the
+   * MAC takes it */
+  server->req_t1 = SNTP_GET_TIME_NS();
+  sntp_ns_to_time(server->req_t1, &server->req_xmt);
+  if (server->req_xmt.sec == 0) {
+    server->req_xmt.sec = PP_HTONL(1);
+  }
+  msg->transmit_timestamp[0] = server->req_xmt.sec;
+  msg->transmit_timestamp[1] = server->req_xmt.frac;
+
+  SNTP_TX_TIMESTAMP_REQ(p);
+  if (udp_sendto(sntp_pcb, p, &server->addr, SNTP_PORT) == ERR_OK) {
+    /* keep our reference for the hardware transmit time stamp (IP output
+     * wants p->ref == 1, so it is not taken before sending). The driver
+     * holds its own until it stores the stamp from the main loop, a
+     * response taken before that falls back to req_t1. */
+    server->req = p;
+  } else {
+    pbuf_free(p);
+    sntp_drop_request(server);
+  }
+#if SNTP_MONITOR_SERVER_REACHABILITY
+  server->reachability <<= 1;
+#endif /* SNTP_MONITOR_SERVER_REACHABILITY */
+}
+
+#if SNTP_SERVER_DNS
+/**
+ * DNS found callback when using DNS names as server address.
+ */
+static void
+sntp_dns_found(const char *hostname, const ip_addr_t *ipaddr, void *arg)
+{
+  struct sntp_server *server = (struct sntp_server *)arg;
+
+  LWIP_UNUSED_ARG(hostname);
+
+  if (ipaddr != NULL && server->name != NULL) {
+    if (!ip_addr_cmp(ipaddr, &server->addr)) {
+      sntp_reset_server(server);
+    }
+    server->addr = *ipaddr;
+    sntp_send_request(server);
+  } else {
+    LWIP_DEBUGF(SNTP_DEBUG_WARN_STATE, ("sntp_dns_found: Failed to resolve server address\n"));
+  }
+}
+#endif /* SNTP_SERVER_DNS */
+
+/**
+ * Poll all servers, high precision mode.
+ *
+ * @param arg is unused (only necessary to conform to sys_timeout)
+ */
+static void
+sntp_request(void *arg)
+{
+  u8_t i;
+
+  LWIP_UNUSED_ARG(arg);
+
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    struct sntp_server *server = &sntp_servers[i];
+
+    if (server->req_xmt.sec != 0) {
+      /* no response to the last poll, the samples age out */
+      sntp_drop_request(server);
+      if (++server->missed >= SNTP_FILTER_SIZE) {
+        sntp_reset_server(server);
+      }
+    }
+  }
+
+  /* the responses to the last poll are in, a falseticker answering first
+   * is outvoted by the others */
+  sntp_update(SNTP_GET_TIME_NS());
+
+  for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+    struct sntp_server *server = &sntp_servers[i];
+
+#if SNTP_SERVER_DNS
+    if (server->name != NULL) {
+      ip_addr_t addr;
+      err_t err = dns_gethostbyname(server->name, &addr, sntp_dns_found, server);
+      if (err == ERR_OK) {
+        sntp_dns_found(server->name, &addr, server);
+      }
+      continue;
+    }
+#endif /* SNTP_SERVER_DNS */
+    if (!ip_addr_isany(&server->addr)) {
+      sntp_send_request(server);
+    }
+  }
+
+  sys_timeout((u32_t)SNTP_POLL_INTERVAL, sntp_request, NULL);
+}
+
+/* There is no current server to move on from */
+#define sntp_try_next_server    sntp_request
+
+#else /* SNTP_HIGH_PRECISION */
+
 /**
  * SNTP processing of received timestamp
  */
@@ -645,6 +1117,8 @@ sntp_request(void *arg)
   }
 }
 
+#endif /* SNTP_HIGH_PRECISION */
+
 /**
  * @ingroup sntp
  * Initialize this module.
@@ -694,14 +1168,23 @@ sntp_stop(void)
 {
   LWIP_ASSERT_CORE_LOCKED();
   if (sntp_pcb != NULL) {
-#if SNTP_MONITOR_SERVER_REACHABILITY
+#if SNTP_MONITOR_SERVER_REACHABILITY || SNTP_HIGH_PRECISION
     u8_t i;
+#endif /* SNTP_MONITOR_SERVER_REACHABILITY || SNTP_HIGH_PRECISION */
+#if SNTP_MONITOR_SERVER_REACHABILITY
     for (i = 0; i < SNTP_MAX_SERVERS; i++) {
       sntp_servers[i].reachability = 0;
     }
 #endif /* SNTP_MONITOR_SERVER_REACHABILITY */
     sys_untimeout(sntp_request, NULL);
     sys_untimeout(sntp_try_next_server, NULL);
+#if SNTP_HIGH_PRECISION
+    for (i = 0; i < SNTP_MAX_SERVERS; i++) {
+      sntp_reset_server(&sntp_servers[i]);
+    }
+    sntp_last_update = 0;
+    sntp_sys_peer = SNTP_MAX_SERVERS;
+#endif /* SNTP_HIGH_PRECISION */
     udp_remove(sntp_pcb);
     sntp_pcb = NULL;
   }
@@ -727,6 +1210,7 @@ sntp_setoperatingmode(u8_t operating_mode)
   LWIP_ASSERT_CORE_LOCKED();
   LWIP_ASSERT("Invalid operating mode", operating_mode <= SNTP_OPMODE_LISTENONLY);
   LWIP_ASSERT("Operating mode must not be set while SNTP client is running", sntp_pcb == NULL);
+  LWIP_ASSERT("High precision mode only polls", !SNTP_HIGH_PRECISION || operating_mode == SNTP_OPMODE_POLL);
   sntp_opmode = operating_mode;
 }
 
@@ -757,6 +1241,39 @@ sntp_getreachability(u8_t idx)
 }
 #endif /* SNTP_MONITOR_SERVER_REACHABILITY */
 
+#if SNTP_HIGH_PRECISION
+/**
+ * @ingroup sntp
+ * Get the clock filter output of one of the NTP servers, high precision mode.
+ *
+ * @param idx the index of the NTP server
+ * @param stats filled in
+ * @return 1 if the server has samples, 0 if not
+ */
+u8_t
+sntp_getpeerstats(u8_t idx, struct sntp_peer_stats *stats)
+{
+  const struct sntp_sample *best;
+  s64_t jitter = 0;
+
+  memset(stats, 0, sizeof(*stats));
+  if (idx >= SNTP_MAX_SERVERS) {
+    return 0;
+  }
+  best = sntp_filter(&sntp_servers[idx], &jitter);
+  if (best == NULL) {
+    return 0;
+  }
+  stats->offset = best->offset;
+  stats->delay = best->delay;
+  stats->jitter = jitter;
+  stats->samples = sntp_servers[idx].filter_count;
+  stats->selected = sntp_servers[idx].selected;
+  stats->sys_peer = (idx == sntp_sys_peer);
+  return 1;
+}
+#endif /* SNTP_HIGH_PRECISION */
+
 #if SNTP_GET_SERVERS_FROM_DHCP || SNTP_GET_SERVERS_FROM_DHCPV6
 /**
  * Config SNTP server handling by IP address, name, or DHCP; clear table
@@ -785,6 +1302,9 @@ sntp_setserver(u8_t idx, const ip_addr_t *server)
 {
   LWIP_ASSERT_CORE_LOCKED();
   if (idx < SNTP_MAX_SERVERS) {
+#if SNTP_HIGH_PRECISION
+    sntp_reset_server(&sntp_servers[idx]);
+#endif /* SNTP_HIGH_PRECISION */
     if (server != NULL) {
       sntp_servers[idx].addr = (*server);
     } else {
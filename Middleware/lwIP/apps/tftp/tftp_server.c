@@ -5,7 +5,8 @@
  * @author   Logan Gunthorpe <logang@deltatee.com>
  *           Dirk Ziegelmeier <dziegel@gmx.de>
  *
- * @brief    Trivial File Transfer Protocol (RFC 1350)
+ * @brief    Trivial File Transfer Protocol (RFC 1350) with the blksize
+ *           (RFC 2348) and windowsize (RFC 7440) options
  *
  * Copyright (c) Deltatee Enterprises Ltd. 2013
  * All rights reserved.
@@ -45,6 +46,14 @@
  * @ingroup apps
  *
  * This is simple TFTP server for the lwIP raw API.
+ *
+ * A client may ask for larger blocks (blksize, up to TFTP_MAX_BLKSIZE) and
+ * for several blocks per ACK (windowsize, up to TFTP_MAX_WINDOWSIZE); the
+ * granted values are sent back in an OACK. A read keeps the blocks of the
+ * window until they are acknowledged and sends them again from the first
+ * one not acknowledged, on timeout or when the client acknowledges only
+ * part of the window. A write is acknowledged once per window, and on a
+ * missing block with the last one received in order.
  */
 
 #include "lwip/apps/tftp_server.h"
@@ -55,7 +64,8 @@
 #include "lwip/timeouts.h"
 #include "lwip/debug.h"
 
-#define TFTP_MAX_PAYLOAD_SIZE 512
+#define TFTP_DEFAULT_BLKSIZE  512
+#define TFTP_MIN_BLKSIZE      8
 #define TFTP_HEADER_LENGTH    4
 
 #define TFTP_RRQ   1
@@ -63,6 +73,21 @@
 #define TFTP_DATA  3
 #define TFTP_ACK   4
 #define TFTP_ERROR 5
+#define TFTP_OACK  6
+
+/* Options granted in the OACK */
+#define TFTP_OPT_BLKSIZE    0x01
+#define TFTP_OPT_WINDOWSIZE 0x02
+
+/* Longest option name or value taken, "windowsize" */
+#define TFTP_MAX_OPTION_LEN 10
+
+#if (TFTP_MAX_BLKSIZE < TFTP_DEFAULT_BLKSIZE) || (TFTP_MAX_BLKSIZE > 65464)
+#error "TFTP_MAX_BLKSIZE must be within 512..65464"
+#endif
+#if (TFTP_MAX_WINDOWSIZE < 1) || (TFTP_MAX_WINDOWSIZE > 255)
+#error "TFTP_MAX_WINDOWSIZE must be within 1..255"
+#endif
 
 enum tftp_error {
   TFTP_ERROR_FILE_NOT_FOUND    = 1,
@@ -79,31 +104,74 @@ enum tftp_error {
 struct tftp_state {
   const struct tftp_context *ctx;
   void *handle;
-  struct pbuf *last_data;
+  /* read: blocks blknum.. sent but not acknowledged */
+  struct pbuf *window[TFTP_MAX_WINDOWSIZE];
   struct udp_pcb *upcb;
   ip_addr_t addr;
   u16_t port;
   int timer;
   int last_pkt;
+  /* read: first block not acknowledged, write: next block expected */
   u16_t blknum;
+  u16_t blksize;
+  /* write: last block received out of order */
+  u16_t ooo_blknum;
+  u8_t windowsize;
+  /* read: blocks in window[] */
+  u8_t queued;
+  /* write: blocks received in order since the last ACK */
+  u8_t received;
   u8_t retries;
   u8_t mode_write;
+  u8_t options;
+  /* OACK sent, waiting for ACK 0 (read) or block 1 (write) */
+  u8_t oack;
+  /* read: the last block is in window[], write: the last block is written */
+  u8_t eof;
+  /* write: the blocks since ooo_blknum are out of order */
+  u8_t ooo;
+  /* write: the last write() returned TFTP_WRITE_WAIT, no ACK until tftp_write_resume() */
+  u8_t ack_held;
+  /* write: the ACK of a window waits for tftp_write_resume() */
+  u8_t ack_due;
 };
 
 static struct tftp_state tftp_state;
 
 static void tftp_tmr(void *arg);
 
+/* Drop the first n blocks of the window, acknowledged by the client */
+static void
+free_window(u8_t n)
+{
+  u8_t i;
+
+  for (i = 0; i < n; i++) {
+    pbuf_free(tftp_state.window[i]);
+  }
+  for (i = n; i < tftp_state.queued; i++) {
+    tftp_state.window[i - n] = tftp_state.window[i];
+  }
+  for (i = (u8_t)(tftp_state.queued - n); i < tftp_state.queued; i++) {
+    tftp_state.window[i] = NULL;
+  }
+  tftp_state.queued = (u8_t)(tftp_state.queued - n);
+  tftp_state.blknum = (u16_t)(tftp_state.blknum + n);
+}
+
 static void
 close_handle(void)
 {
   tftp_state.port = 0;
   ip_addr_set_any(0, &tftp_state.addr);
 
-  if (tftp_state.last_data != NULL) {
-    pbuf_free(tftp_state.last_data);
-    tftp_state.last_data = NULL;
-  }
+  free_window(tftp_state.queued);
+  tftp_state.oack     = 0;
+  tftp_state.eof      = 0;
+  tftp_state.received = 0;
+  tftp_state.ooo      = 0;
+  tftp_state.ack_held = 0;
+  tftp_state.ack_due  = 0;
 
   sys_untimeout(tftp_tmr, NULL);
 
@@ -153,15 +221,53 @@ send_ack(u16_t blknum)
   pbuf_free(p);
 }
 
+/* Append "name\0value\0" to buf, returns its length */
+static u16_t
+put_option(char *buf, const char *name, u16_t value)
+{
+  u16_t len = (u16_t)(strlen(name) + 1);
+
+  MEMCPY(buf, name, len);
+  lwip_itoa(&buf[len], 6, value);
+  return (u16_t)(len + strlen(&buf[len]) + 1);
+}
+
+static void
+send_oack(void)
+{
+  char opts[sizeof("blksize") + 6 + sizeof("windowsize") + 6];
+  u16_t len = 0;
+  struct pbuf *p;
+  u16_t *payload;
+
+  if (tftp_state.options & TFTP_OPT_BLKSIZE) {
+    len = (u16_t)(len + put_option(&opts[len], "blksize", tftp_state.blksize));
+  }
+  if (tftp_state.options & TFTP_OPT_WINDOWSIZE) {
+    len = (u16_t)(len + put_option(&opts[len], "windowsize", tftp_state.windowsize));
+  }
+
+  p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)(2 + len), PBUF_RAM);
+  if (p == NULL) {
+    return;
+  }
+  payload = (u16_t *) p->payload;
+
+  payload[0] = PP_HTONS(TFTP_OACK);
+  MEMCPY(&payload[1], opts, len);
+  udp_sendto(tftp_state.upcb, p, &tftp_state.addr, tftp_state.port);
+  pbuf_free(p);
+}
+
 static void
-resend_data(void)
+resend_data(struct pbuf *data)
 {
-  struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, tftp_state.last_data->len, PBUF_RAM);
+  struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, data->len, PBUF_RAM);
   if (p == NULL) {
     return;
   }
 
-  if (pbuf_copy(p, tftp_state.last_data) != ERR_OK) {
+  if (pbuf_copy(p, data) != ERR_OK) {
     pbuf_free(p);
     return;
   }
@@ -170,34 +276,117 @@ resend_data(void)
   pbuf_free(p);
 }
 
+/* Read and send blocks until the window is full or the file is read */
 static void
-send_data(void)
+send_window(void)
 {
+  struct pbuf *p;
   u16_t *payload;
   int ret;
 
-  if (tftp_state.last_data != NULL) {
-    pbuf_free(tftp_state.last_data);
+  while ((tftp_state.queued < tftp_state.windowsize) && !tftp_state.eof) {
+    p = pbuf_alloc(PBUF_TRANSPORT, (u16_t)(TFTP_HEADER_LENGTH + tftp_state.blksize), PBUF_RAM);
+    if (p == NULL) {
+      /* tftp_tmr() tries again */
+      return;
+    }
+
+    payload = (u16_t *) p->payload;
+    payload[0] = PP_HTONS(TFTP_DATA);
+    payload[1] = lwip_htons((u16_t)(tftp_state.blknum + tftp_state.queued));
+
+    ret = tftp_state.ctx->read(tftp_state.handle, &payload[2], tftp_state.blksize);
+    if (ret < 0) {
+      pbuf_free(p);
+      send_error(&tftp_state.addr, tftp_state.port, TFTP_ERROR_ACCESS_VIOLATION, "Error occured while reading the file.");
+      close_handle();
+      return;
+    }
+
+    if (ret < tftp_state.blksize) {
+      tftp_state.eof = 1;
+    }
+    pbuf_realloc(p, (u16_t)(TFTP_HEADER_LENGTH + ret));
+    tftp_state.window[tftp_state.queued++] = p;
+    resend_data(p);
   }
+}
 
-  tftp_state.last_data = pbuf_alloc(PBUF_TRANSPORT, TFTP_HEADER_LENGTH + TFTP_MAX_PAYLOAD_SIZE, PBUF_RAM);
-  if (tftp_state.last_data == NULL) {
+/* Acknowledge the blocks received so far, unless write() asked to wait */
+static void
+ack_window(void)
+{
+  tftp_state.received = 0;
+
+  if (tftp_state.ack_held) {
+    tftp_state.ack_due = 1;
     return;
   }
 
-  payload = (u16_t *) tftp_state.last_data->payload;
-  payload[0] = PP_HTONS(TFTP_DATA);
-  payload[1] = lwip_htons(tftp_state.blknum);
-
-  ret = tftp_state.ctx->read(tftp_state.handle, &payload[2], TFTP_MAX_PAYLOAD_SIZE);
-  if (ret < 0) {
-    send_error(&tftp_state.addr, tftp_state.port, TFTP_ERROR_ACCESS_VIOLATION, "Error occured while reading the file.");
+  send_ack((u16_t)(tftp_state.blknum - 1));
+  if (tftp_state.eof) {
     close_handle();
-    return;
   }
+}
+
+static u32_t
+parse_number(const char *str)
+{
+  u32_t n = 0;
 
-  pbuf_realloc(tftp_state.last_data, (u16_t)(TFTP_HEADER_LENGTH + ret));
-  resend_data();
+  do {
+    if ((*str < '0') || (*str > '9') || (n > 0xFFFFFF)) {
+      return 0;
+    }
+    n = n * 10 + (u32_t)(*str - '0');
+  } while (*++str != 0);
+
+  return n;
+}
+
+/* Take the options following the mode string of a request, pairs of
+   null-terminated name and value. Unknown options are not acknowledged. */
+static void
+parse_options(struct pbuf *p, u16_t offset)
+{
+  const char tftp_null = 0;
+  char name[TFTP_MAX_OPTION_LEN + 1];
+  char value[TFTP_MAX_OPTION_LEN + 1];
+  u16_t name_end_offset;
+  u16_t value_end_offset;
+  u32_t n;
+
+  tftp_state.blksize    = TFTP_DEFAULT_BLKSIZE;
+  tftp_state.windowsize = 1;
+  tftp_state.options    = 0;
+
+  while (offset < p->tot_len) {
+    name_end_offset = pbuf_memfind(p, &tftp_null, sizeof(tftp_null), offset);
+    if (name_end_offset == 0xFFFF) {
+      return;
+    }
+    value_end_offset = pbuf_memfind(p, &tftp_null, sizeof(tftp_null), name_end_offset + 1);
+    if (value_end_offset == 0xFFFF) {
+      return;
+    }
+
+    if (((u16_t)(name_end_offset - offset) <= TFTP_MAX_OPTION_LEN) &&
+        ((u16_t)(value_end_offset - name_end_offset - 1) <= TFTP_MAX_OPTION_LEN)) {
+      pbuf_copy_partial(p, name, name_end_offset - offset + 1, offset);
+      pbuf_copy_partial(p, value, value_end_offset - name_end_offset, name_end_offset + 1);
+      n = parse_number(value);
+
+      if ((lwip_stricmp(name, "blksize") == 0) && (n >= TFTP_MIN_BLKSIZE)) {
+        tftp_state.blksize = (u16_t)LWIP_MIN(n, TFTP_MAX_BLKSIZE);
+        tftp_state.options |= TFTP_OPT_BLKSIZE;
+      } else if ((lwip_stricmp(name, "windowsize") == 0) && (n >= 1)) {
+        tftp_state.windowsize = (u8_t)LWIP_MIN(n, TFTP_MAX_WINDOWSIZE);
+        tftp_state.options |= TFTP_OPT_WINDOWSIZE;
+      }
+    }
+
+    offset = (u16_t)(value_end_offset + 1);
+  }
 }
 
 static void
@@ -231,7 +420,8 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
       u16_t mode_end_offset;
 
       if (tftp_state.handle != NULL) {
-        send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "Only one connection at a time is supported");
+        /* the request again from the same client, which missed the
+           answer: tftp_tmr() sends it again */
         break;
       }
 
@@ -253,6 +443,9 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
       }
       pbuf_copy_partial(p, mode, mode_end_offset - filename_end_offset, filename_end_offset + 1);
 
+      /* options -> blksize, windowsize */
+      parse_options(p, (u16_t)(mode_end_offset + 1));
+
       tftp_state.handle = tftp_state.ctx->open(filename, mode, opcode == PP_HTONS(TFTP_WRQ));
       tftp_state.blknum = 1;
 
@@ -263,17 +456,27 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
 
       LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: %s request from ", (opcode == PP_HTONS(TFTP_WRQ)) ? "write" : "read"));
       ip_addr_debug_print(TFTP_DEBUG | LWIP_DBG_STATE, addr);
-      LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, (" for '%s' mode '%s'\n", filename, mode));
+      LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, (" for '%s' mode '%s' blksize %"U16_F" windowsize %"U16_F"\n",
+                                                filename, mode, tftp_state.blksize, (u16_t)tftp_state.windowsize));
 
       ip_addr_copy(tftp_state.addr, *addr);
       tftp_state.port = port;
+      tftp_state.oack = (tftp_state.options != 0);
 
       if (opcode == PP_HTONS(TFTP_WRQ)) {
         tftp_state.mode_write = 1;
-        send_ack(0);
+        if (tftp_state.oack) {
+          send_oack();
+        } else {
+          send_ack(0);
+        }
       } else {
         tftp_state.mode_write = 0;
-        send_data();
+        if (tftp_state.oack) {
+          send_oack();
+        } else {
+          send_window();
+        }
       }
 
       break;
@@ -296,32 +499,49 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
       blknum = lwip_ntohs(sbuf[1]);
       if (blknum == tftp_state.blknum) {
         pbuf_remove_header(p, TFTP_HEADER_LENGTH);
+        tftp_state.oack = 0;
+        tftp_state.ooo = 0;
 
         ret = tftp_state.ctx->write(tftp_state.handle, p);
+        if ((ret >= 0) && (p->tot_len < tftp_state.blksize)) {
+          /* the last block, the file is complete */
+          tftp_state.eof = 1;
+          ret = tftp_state.ctx->write(tftp_state.handle, NULL);
+        }
         if (ret < 0) {
           send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "error writing file");
           close_handle();
-        } else {
-          send_ack(blknum);
+          break;
         }
+        /* the last write() tells whether the client may send more */
+        tftp_state.ack_held = (ret == TFTP_WRITE_WAIT);
 
-        if (p->tot_len < TFTP_MAX_PAYLOAD_SIZE) {
-          close_handle();
-        } else {
-          tftp_state.blknum++;
+        tftp_state.blknum++;
+        tftp_state.received++;
+        if (tftp_state.eof || (tftp_state.received >= tftp_state.windowsize)) {
+          ack_window();
         }
-      } else if ((u16_t)(blknum + 1) == tftp_state.blknum) {
-        /* retransmit of previous block, ack again (casting to u16_t to care for overflow) */
-        send_ack(blknum);
       } else {
-        send_error(addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Wrong block number");
+        /* a block of the window is missing, or the client sends the window
+           again after the ACK got lost: acknowledge the last block received
+           in order, once for every run of blocks sent by the client
+           (casting to u16_t to care for overflow) */
+        if (!tftp_state.ooo || ((u16_t)(tftp_state.ooo_blknum - blknum) < 0x8000)) {
+          tftp_state.received = 0;
+          if (!tftp_state.ack_held) {
+            send_ack((u16_t)(tftp_state.blknum - 1));
+          }
+        }
+        tftp_state.ooo = 1;
+        tftp_state.ooo_blknum = blknum;
       }
       break;
     }
 
     case PP_HTONS(TFTP_ACK): {
       u16_t blknum;
-      int lastpkt;
+      u16_t acked;
+      u8_t i;
 
       if (tftp_state.handle == NULL) {
         send_error(addr, port, TFTP_ERROR_ACCESS_VIOLATION, "No connection");
@@ -334,27 +554,48 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
       }
 
       blknum = lwip_ntohs(sbuf[1]);
-      if (blknum != tftp_state.blknum) {
-        send_error(addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Wrong block number");
+      if (tftp_state.oack) {
+        /* ACK 0 accepts the options */
+        if (blknum != 0) {
+          send_error(addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Wrong block number");
+          break;
+        }
+        tftp_state.oack = 0;
+        send_window();
         break;
       }
 
-      lastpkt = 0;
-
-      if (tftp_state.last_data != NULL) {
-        lastpkt = tftp_state.last_data->tot_len != (TFTP_MAX_PAYLOAD_SIZE + TFTP_HEADER_LENGTH);
+      acked = (u16_t)(blknum + 1 - tftp_state.blknum);
+      if ((acked == 0) || (acked > tftp_state.queued)) {
+        /* an ACK before the window is a duplicate, ignored so that
+           blocks are not sent twice for ever (Sorcerer's Apprentice) */
+        if ((u16_t)(tftp_state.blknum - 1 - blknum) >= 0x8000) {
+          send_error(addr, port, TFTP_ERROR_UNKNOWN_TRFR_ID, "Wrong block number");
+        }
+        break;
       }
 
-      if (!lastpkt) {
-        tftp_state.blknum++;
-        send_data();
-      } else {
+      free_window((u8_t)acked);
+      if (tftp_state.eof && (tftp_state.queued == 0)) {
         close_handle();
+        break;
+      }
+
+      /* the client missed the block after the one acknowledged */
+      for (i = 0; i < tftp_state.queued; i++) {
+        resend_data(tftp_state.window[i]);
       }
+      send_window();
 
       break;
     }
 
+    case PP_HTONS(TFTP_ERROR):
+      /* the client gave up, e.g. refusing the options; not answered */
+      LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: error from client\n"));
+      close_handle();
+      break;
+
     default:
       send_error(addr, port, TFTP_ERROR_ILLEGAL_OPERATION, "Unknown operation");
       break;
@@ -366,6 +607,8 @@ recv(void *arg, struct udp_pcb *upcb, struct pbuf *p, const ip_addr_t *addr, u16
 static void
 tftp_tmr(void *arg)
 {
+  u8_t i;
+
   LWIP_UNUSED_ARG(arg);
 
   tftp_state.timer++;
@@ -376,10 +619,24 @@ tftp_tmr(void *arg)
 
   sys_timeout(TFTP_TIMER_MSECS, tftp_tmr, NULL);
 
+  if (tftp_state.ack_held) {
+    /* the client waits for tftp_write_resume() */
+    return;
+  }
+
   if ((tftp_state.timer - tftp_state.last_pkt) > (TFTP_TIMEOUT_MSECS / TFTP_TIMER_MSECS)) {
-    if ((tftp_state.last_data != NULL) && (tftp_state.retries < TFTP_MAX_RETRIES)) {
+    if (tftp_state.retries < TFTP_MAX_RETRIES) {
       LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout, retrying\n"));
-      resend_data();
+      if (tftp_state.oack) {
+        send_oack();
+      } else if (tftp_state.mode_write) {
+        send_ack((u16_t)(tftp_state.blknum - 1));
+      } else {
+        for (i = 0; i < tftp_state.queued; i++) {
+          resend_data(tftp_state.window[i]);
+        }
+        send_window();
+      }
       tftp_state.retries++;
     } else {
       LWIP_DEBUGF(TFTP_DEBUG | LWIP_DBG_STATE, ("tftp: timeout\n"));
@@ -413,7 +670,7 @@ tftp_init(const struct tftp_context *ctx)
   tftp_state.port      = 0;
   tftp_state.ctx       = ctx;
   tftp_state.timer     = 0;
-  tftp_state.last_data = NULL;
+  tftp_state.queued    = 0;
   tftp_state.upcb      = pcb;
 
   udp_recv(pcb, recv, NULL);
@@ -432,4 +689,29 @@ void tftp_cleanup(void)
   memset(&tftp_state, 0, sizeof(tftp_state));
 }
 
+/** @ingroup tftp
+ * Send the ACK held back since write() returned TFTP_WRITE_WAIT.
+ * @param result &gt;= 0: the data is written, the client may send more;
+ *               &lt; 0: Error, the transfer is aborted
+ */
+void
+tftp_write_resume(int result)
+{
+  if ((tftp_state.handle == NULL) || !tftp_state.ack_held) {
+    return;
+  }
+
+  tftp_state.ack_held = 0;
+  if (result < 0) {
+    send_error(&tftp_state.addr, tftp_state.port, TFTP_ERROR_ACCESS_VIOLATION, "error writing file");
+    close_handle();
+    return;
+  }
+
+  if (tftp_state.ack_due) {
+    tftp_state.ack_due = 0;
+    ack_window();
+  }
+}
+
 #endif /* LWIP_UDP */
@@ -89,6 +89,7 @@
 #if LWIP_DNS /* don't build if not configured for use in lwipopts.h */
 
 #include "lwip/def.h"
+#include "lwip/sys.h"
 #include "lwip/udp.h"
 #include "lwip/mem.h"
 #include "lwip/memp.h"
@@ -125,6 +126,14 @@ static u16_t dns_txid;
 #if DNS_MAX_SERVERS > 255
 #error DNS_MAX_SERVERS must fit into an u8_t
 #endif
+#if (DNS_TABLE_HASH_SIZE & (DNS_TABLE_HASH_SIZE - 1)) != 0
+#error DNS_TABLE_HASH_SIZE must be a power of 2
+#endif
+
+#if DNS_SERVER_RTT
+/** Smoothed response time (ms * 8) of a server that did not answer */
+#define DNS_SERVER_SRTT_LOST      ((u32_t)DNS_MAX_RETRIES * DNS_TMR_INTERVAL * 8)
+#endif
 
 /* The number of parallel requests (i.e. calls to dns_gethostbyname
  * that cannot be answered from the DNS table.
@@ -213,19 +222,40 @@ typedef enum {
   DNS_STATE_UNUSED           = 0,
   DNS_STATE_NEW              = 1,
   DNS_STATE_ASKING           = 2,
-  DNS_STATE_DONE             = 3
+  DNS_STATE_DONE             = 3,
+  /* resolved, being queried again before the TTL expires */
+  DNS_STATE_REFRESH          = 4,
+  /* reported not to exist, until the negative TTL expires */
+  DNS_STATE_NEGATIVE         = 5
 } dns_state_enum_t;
 
+/** An entry waiting for the answer of a server */
+#define DNS_STATE_IS_ASKING(state) (((state) == DNS_STATE_ASKING) || ((state) == DNS_STATE_REFRESH))
+
 /** DNS table entry */
 struct dns_table_entry {
   u32_t ttl;
+#if DNS_PREFETCH_PERCENT
+  /* ttl left when the entry is queried again, 0 if not */
+  u32_t prefetch;
+#endif
+#if DNS_SERVER_RTT
+  /* sys_now() of the first query to server_idx */
+  u32_t sent;
+#endif
   ip_addr_t ipaddr;
   u16_t txid;
   u8_t  state;
   u8_t  server_idx;
+  /* server the query was sent to first */
+  u8_t  server_first;
   u8_t  tmr;
   u8_t  retries;
   u8_t  seqno;
+  /* next entry + 1 of the same hash bucket, 0 at the end */
+  u8_t  hash_next;
+  /* looked up since it was resolved */
+  u8_t  used;
 #if ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) != 0)
   u8_t pcb_idx;
 #endif
@@ -285,6 +315,7 @@ static err_t dns_lookup_local(const char *hostname, ip_addr_t *addr LWIP_DNS_ADD
 static void dns_recv(void *s, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr, u16_t port);
 static void dns_check_entries(void);
 static void dns_call_found(u8_t idx, ip_addr_t *addr);
+static void dns_entry_failed(u8_t idx);
 
 /*-----------------------------------------------------------------------------
  * Globals
@@ -299,6 +330,12 @@ static u8_t                   dns_seqno;
 static struct dns_table_entry dns_table[DNS_TABLE_SIZE];
 static struct dns_req_entry   dns_requests[DNS_MAX_REQUESTS];
 static ip_addr_t              dns_servers[DNS_MAX_SERVERS];
+/* entry + 1 heading each bucket of the names of dns_table, 0 if empty */
+static u8_t                   dns_hash_heads[DNS_TABLE_HASH_SIZE];
+#if DNS_SERVER_RTT
+/* smoothed response time of the servers (ms * 8), 0 if not measured yet */
+static u32_t                  dns_server_srtt[DNS_MAX_SERVERS];
+#endif
 
 #if LWIP_IPV4
 const ip_addr_t dns_mquery_v4group = DNS_MQUERY_IPV4_GROUP_INIT;
@@ -361,6 +398,11 @@ void
 dns_setserver(u8_t numdns, const ip_addr_t *dnsserver)
 {
   if (numdns < DNS_MAX_SERVERS) {
+#if DNS_SERVER_RTT
+    if ((dnsserver == NULL) || !ip_addr_cmp(&dns_servers[numdns], dnsserver)) {
+      dns_server_srtt[numdns] = 0;
+    }
+#endif /* DNS_SERVER_RTT */
     if (dnsserver != NULL) {
       dns_servers[numdns] = (*dnsserver);
     } else {
@@ -583,6 +625,50 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
 #endif /* DNS_LOCAL_HOSTLIST_IS_DYNAMIC*/
 #endif /* DNS_LOCAL_HOSTLIST */
 
+/**
+ * Hash bucket of a name in dns_hash_heads, case-insensitive (FNV-1a).
+ */
+static u16_t
+dns_hash_bucket(const char *name)
+{
+  u32_t hash = 2166136261UL;
+
+  while (*name != 0) {
+    hash = (hash ^ (u8_t)lwip_tolower(*name)) * 16777619UL;
+    ++name;
+  }
+  return (u16_t)(hash & (DNS_TABLE_HASH_SIZE - 1));
+}
+
+/**
+ * Add an entry to the bucket of its name, once the name is set.
+ */
+static void
+dns_hash_link(u8_t idx)
+{
+  u16_t bucket = dns_hash_bucket(dns_table[idx].name);
+
+  dns_table[idx].hash_next = dns_hash_heads[bucket];
+  dns_hash_heads[bucket] = (u8_t)(idx + 1);
+}
+
+/**
+ * Remove an entry from the bucket of its name, before the name changes.
+ */
+static void
+dns_hash_unlink(u8_t idx)
+{
+  u8_t *link = &dns_hash_heads[dns_hash_bucket(dns_table[idx].name)];
+
+  while (*link != 0) {
+    if (*link == idx + 1) {
+      *link = dns_table[idx].hash_next;
+      return;
+    }
+    link = &dns_table[*link - 1].hash_next;
+  }
+}
+
 /**
  * @ingroup dns
  * Look up a hostname in the array of known hostnames.
@@ -596,12 +682,13 @@ dns_local_addhost(const char *hostname, const ip_addr_t *addr)
  * @param addr the hostname's IP address, as u32_t (instead of ip_addr_t to
  *         better check for failure: != IPADDR_NONE) or IPADDR_NONE if the hostname
  *         was not found in the cached dns_table.
- * @return ERR_OK if found, ERR_ARG if not found
+ * @return ERR_OK if found, ERR_VAL if known not to exist, ERR_ARG if not found
  */
 static err_t
 dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addrtype))
 {
   u8_t i;
+  struct dns_table_entry *entry;
 #if DNS_LOCAL_HOSTLIST
   if (dns_lookup_local(name, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_OK) {
     return ERR_OK;
@@ -613,16 +700,23 @@ dns_lookup(const char *name, ip_addr_t *addr LWIP_DNS_ADDRTYPE_ARG(u8_t dns_addr
   }
 #endif /* DNS_LOOKUP_LOCAL_EXTERN */
 
-  /* Walk through name list, return entry if found. If not, return NULL. */
-  for (i = 0; i < DNS_TABLE_SIZE; ++i) {
-    if ((dns_table[i].state == DNS_STATE_DONE) &&
-        (lwip_strnicmp(name, dns_table[i].name, sizeof(dns_table[i].name)) == 0) &&
-        LWIP_DNS_ADDRTYPE_MATCH_IP(dns_addrtype, dns_table[i].ipaddr)) {
+  /* Walk through the entries of the bucket of the name, return the address if found. */
+  for (i = dns_hash_heads[dns_hash_bucket(name)]; i != 0; i = entry->hash_next) {
+    entry = &dns_table[i - 1];
+    if (((entry->state == DNS_STATE_DONE) || (entry->state == DNS_STATE_REFRESH) ||
+         (entry->state == DNS_STATE_NEGATIVE)) &&
+        (lwip_strnicmp(name, entry->name, sizeof(entry->name)) == 0) &&
+        LWIP_DNS_ADDRTYPE_MATCH_IP(dns_addrtype, entry->ipaddr)) {
+      if (entry->state == DNS_STATE_NEGATIVE) {
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": does not exist\n", name));
+        return ERR_VAL;
+      }
       LWIP_DEBUGF(DNS_DEBUG, ("dns_lookup: \"%s\": found = ", name));
-      ip_addr_debug_print_val(DNS_DEBUG, dns_table[i].ipaddr);
+      ip_addr_debug_print_val(DNS_DEBUG, entry->ipaddr);
       LWIP_DEBUGF(DNS_DEBUG, ("\n"));
+      entry->used = 1;
       if (addr) {
-        ip_addr_copy(*addr, dns_table[i].ipaddr);
+        ip_addr_copy(*addr, entry->ipaddr);
       }
       return ERR_OK;
     }
@@ -766,10 +860,7 @@ dns_send(u8_t idx)
 #endif
      ) {
     /* DNS server not valid anymore, e.g. PPP netif has been shut down */
-    /* call specified callback function if provided */
-    dns_call_found(idx, NULL);
-    /* flush this entry */
-    entry->state = DNS_STATE_UNUSED;
+    dns_entry_failed(idx);
     return ERR_OK;
   }
 
@@ -847,6 +938,11 @@ dns_send(u8_t idx)
       dst_port = DNS_SERVER_PORT;
       dst = &dns_servers[entry->server_idx];
     }
+#if DNS_SERVER_RTT
+    if (entry->retries == 0) {
+      entry->sent = sys_now();
+    }
+#endif /* DNS_SERVER_RTT */
     err = udp_sendto(dns_pcbs[pcb_idx], p, dst, dst_port);
 
     /* free pbuf */
@@ -978,7 +1074,7 @@ dns_call_found(u8_t idx, ip_addr_t *addr)
     if (i == idx) {
       continue; /* only check other requests */
     }
-    if (dns_table[i].state == DNS_STATE_ASKING) {
+    if (DNS_STATE_IS_ASKING(dns_table[i].state)) {
       if (dns_table[i].pcb_idx == dns_table[idx].pcb_idx) {
         /* another request is still using the same pcb */
         dns_table[idx].pcb_idx = DNS_MAX_SOURCE_PORTS;
@@ -1007,7 +1103,7 @@ again:
 
   /* check whether the ID is unique */
   for (i = 0; i < DNS_TABLE_SIZE; i++) {
-    if ((dns_table[i].state == DNS_STATE_ASKING) &&
+    if (DNS_STATE_IS_ASKING(dns_table[i].state) &&
         (dns_table[i].txid == txid)) {
       /* ID already used by another pending query */
       goto again;
@@ -1017,6 +1113,80 @@ again:
   return txid;
 }
 
+/**
+ * Server to send a new query to: the one with the lowest smoothed response
+ * time, one not measured yet first so that each gets measured.
+ */
+static u8_t
+dns_first_server(void)
+{
+#if DNS_SERVER_RTT
+  u8_t i, best = 0;
+
+  for (i = 1; i < DNS_MAX_SERVERS; i++) {
+    if (!ip_addr_isany_val(dns_servers[i]) &&
+        (ip_addr_isany_val(dns_servers[best]) || (dns_server_srtt[i] < dns_server_srtt[best]))) {
+      best = i;
+    }
+  }
+  return best;
+#else /* DNS_SERVER_RTT */
+  return 0;
+#endif /* DNS_SERVER_RTT */
+}
+
+#if DNS_SERVER_RTT
+/**
+ * Account the response time of the server of an entry, unless the query was
+ * sent to it again (the answer may be to either). Smoothed by 1/8 as in TCP,
+ * the first answer after a timeout is taken as it is.
+ */
+static void
+dns_server_answered(struct dns_table_entry *entry)
+{
+  u32_t rtt;
+  u32_t *srtt = &dns_server_srtt[entry->server_idx];
+
+  if ((entry->retries != 0)
+#if LWIP_DNS_SUPPORT_MDNS_QUERIES
+      || entry->is_mdns
+#endif /* LWIP_DNS_SUPPORT_MDNS_QUERIES */
+     ) {
+    return;
+  }
+  rtt = LWIP_MIN(LWIP_MAX(sys_now() - entry->sent, 1), DNS_SERVER_SRTT_LOST >> 3);
+  if ((*srtt == 0) || (*srtt >= DNS_SERVER_SRTT_LOST)) {
+    *srtt = rtt << 3;
+  } else {
+    *srtt = *srtt - (*srtt >> 3) + rtt;
+  }
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_server_answered: dns_servers[%"U16_F"]: %"U32_F" ms, smoothed %"U32_F" ms\n",
+                          (u16_t)entry->server_idx, rtt, *srtt >> 3));
+}
+#endif /* DNS_SERVER_RTT */
+
+/**
+ * Next configured server to try for an entry, in turn after server_idx up to
+ * the one the query was sent to first.
+ *
+ * @return its index, DNS_MAX_SERVERS if all have been tried
+ */
+static u8_t
+dns_next_server(struct dns_table_entry *pentry)
+{
+  u8_t idx = pentry->server_idx;
+
+  for (;;) {
+    idx = (u8_t)((idx + 1) % DNS_MAX_SERVERS);
+    if (idx == pentry->server_first) {
+      return DNS_MAX_SERVERS;
+    }
+    if (!ip_addr_isany_val(dns_servers[idx])) {
+      return idx;
+    }
+  }
+}
+
 /**
  * Check whether there are other backup DNS servers available to try
  */
@@ -1026,7 +1196,7 @@ dns_backupserver_available(struct dns_table_entry *pentry)
   u8_t ret = 0;
 
   if (pentry) {
-    if ((pentry->server_idx + 1 < DNS_MAX_SERVERS) && !ip_addr_isany_val(dns_servers[pentry->server_idx + 1])) {
+    if (dns_next_server(pentry) < DNS_MAX_SERVERS) {
       ret = 1;
     }
   }
@@ -1034,6 +1204,74 @@ dns_backupserver_available(struct dns_table_entry *pentry)
   return ret;
 }
 
+/**
+ * The query of an entry failed or timed out: call the callbacks. An entry
+ * being refreshed keeps its address until its TTL expires.
+ */
+static void
+dns_entry_failed(u8_t idx)
+{
+  /* call specified callback function if provided */
+  dns_call_found(idx, NULL);
+  /* flush this entry */
+  if (dns_table[idx].state == DNS_STATE_REFRESH) {
+    dns_table[idx].state = DNS_STATE_DONE;
+  } else {
+    dns_table[idx].state = DNS_STATE_UNUSED;
+  }
+}
+
+/**
+ * Send the first query of an entry, to the fastest server.
+ *
+ * @param i index of the dns_table entry
+ * @param state DNS_STATE_ASKING, or DNS_STATE_REFRESH for an entry resolved
+ *        before
+ */
+static void
+dns_start_query(u8_t i, u8_t state)
+{
+  err_t err;
+  struct dns_table_entry *entry = &dns_table[i];
+
+  entry->txid = dns_create_txid();
+  entry->state = state;
+  entry->server_idx = dns_first_server();
+  entry->server_first = entry->server_idx;
+  entry->tmr = 1;
+  entry->retries = 0;
+
+  /* send DNS packet for this entry */
+  err = dns_send(i);
+  if (err != ERR_OK) {
+    LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
+                ("dns_send returned error: %s\n", lwip_strerr(err)));
+  }
+}
+
+#if DNS_PREFETCH_PERCENT
+/**
+ * Query a resolved entry again before its TTL expires, lookups are still
+ * answered with its address meanwhile.
+ */
+static void
+dns_prefetch(u8_t i)
+{
+  struct dns_table_entry *entry = &dns_table[i];
+
+  entry->prefetch = 0;
+#if ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) != 0)
+  entry->pcb_idx = dns_alloc_pcb();
+  if (entry->pcb_idx >= DNS_MAX_SOURCE_PORTS) {
+    LWIP_DEBUGF(DNS_DEBUG, ("dns_prefetch: \"%s\": failed to allocate a pcb\n", entry->name));
+    return;
+  }
+#endif
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_prefetch: \"%s\": %"U32_F" s left\n", entry->name, entry->ttl));
+  dns_start_query(i, DNS_STATE_REFRESH);
+}
+#endif /* DNS_PREFETCH_PERCENT */
+
 /**
  * dns_check_entry() - see if entry has not yet been queried and, if so, sends out a query.
  * Check an entry in the dns_table:
@@ -1053,38 +1291,36 @@ dns_check_entry(u8_t i)
 
   switch (entry->state) {
     case DNS_STATE_NEW:
-      /* initialize new entry */
-      entry->txid = dns_create_txid();
-      entry->state = DNS_STATE_ASKING;
-      entry->server_idx = 0;
-      entry->tmr = 1;
-      entry->retries = 0;
-
-      /* send DNS packet for this entry */
-      err = dns_send(i);
-      if (err != ERR_OK) {
-        LWIP_DEBUGF(DNS_DEBUG | LWIP_DBG_LEVEL_WARNING,
-                    ("dns_send returned error: %s\n", lwip_strerr(err)));
-      }
+      /* initialize new entry and send DNS packet for it */
+      dns_start_query(i, DNS_STATE_ASKING);
       break;
+    case DNS_STATE_REFRESH:
+      /* the address is not used past its TTL, answered or not */
+      if (--entry->ttl == 0) {
+        LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": flush\n", entry->name));
+        dns_call_found(i, NULL);
+        entry->state = DNS_STATE_UNUSED;
+        break;
+      }
+      /* fall through */
     case DNS_STATE_ASKING:
       if (--entry->tmr == 0) {
         if (++entry->retries == DNS_MAX_RETRIES) {
+#if DNS_SERVER_RTT
+          dns_server_srtt[entry->server_idx] = DNS_SERVER_SRTT_LOST;
+#endif /* DNS_SERVER_RTT */
           if (dns_backupserver_available(entry)
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
               && !entry->is_mdns
 #endif /* LWIP_DNS_SUPPORT_MDNS_QUERIES */
              ) {
             /* change of server */
-            entry->server_idx++;
+            entry->server_idx = dns_next_server(entry);
             entry->tmr = 1;
             entry->retries = 0;
           } else {
             LWIP_DEBUGF(DNS_DEBUG, ("dns_check_entry: \"%s\": timeout\n", entry->name));
-            /* call specified callback function if provided */
-            dns_call_found(i, NULL);
-            /* flush this entry */
-            entry->state = DNS_STATE_UNUSED;
+            dns_entry_failed(i);
             break;
           }
         } else {
@@ -1100,6 +1336,7 @@ dns_check_entry(u8_t i)
         }
       }
       break;
+    case DNS_STATE_NEGATIVE:
     case DNS_STATE_DONE:
       /* if the time to live is nul */
       if ((entry->ttl == 0) || (--entry->ttl == 0)) {
@@ -1107,6 +1344,11 @@ dns_check_entry(u8_t i)
         /* flush this entry, there cannot be any related pending entries in this state */
         entry->state = DNS_STATE_UNUSED;
       }
+#if DNS_PREFETCH_PERCENT
+      else if (entry->used && (entry->ttl <= entry->prefetch)) {
+        dns_prefetch(i);
+      }
+#endif /* DNS_PREFETCH_PERCENT */
       break;
     case DNS_STATE_UNUSED:
       /* nothing to do */
@@ -1149,6 +1391,12 @@ dns_correct_response(u8_t idx, u32_t ttl)
   if (entry->ttl > DNS_MAX_TTL) {
     entry->ttl = DNS_MAX_TTL;
   }
+#if DNS_PREFETCH_PERCENT
+  /* 0 (never) for a TTL too short */
+  entry->prefetch = entry->ttl - (entry->ttl / 100) * DNS_PREFETCH_PERCENT -
+                    ((entry->ttl % 100) * DNS_PREFETCH_PERCENT) / 100;
+#endif /* DNS_PREFETCH_PERCENT */
+  entry->used = 0;
   dns_call_found(idx, &entry->ipaddr);
 
   if (entry->ttl == 0) {
@@ -1163,6 +1411,79 @@ dns_correct_response(u8_t idx, u32_t ttl)
   }
 }
 
+#if DNS_MAX_NEG_TTL
+/**
+ * TTL of a negative response (RFC 2308 section 5): the lower of the TTL and
+ * of the MINIMUM field of the SOA record in the authority section.
+ *
+ * @param p pbuf containing the response
+ * @param res_idx offset of the next record
+ * @param nrecords records left, answers and authority
+ * @return the TTL, 0 (not to be cached) if there is no SOA record
+ */
+static u32_t
+dns_negative_ttl(struct pbuf *p, u16_t res_idx, u32_t nrecords)
+{
+  struct dns_answer ans;
+  u32_t minimum;
+  u16_t len;
+
+  while ((nrecords > 0) && (res_idx < p->tot_len)) {
+    res_idx = dns_skip_name(p, res_idx);
+    if (res_idx == 0xFFFF) {
+      return 0;
+    }
+    if (pbuf_copy_partial(p, &ans, SIZEOF_DNS_ANSWER, res_idx) != SIZEOF_DNS_ANSWER) {
+      return 0;
+    }
+    len = lwip_htons(ans.len);
+    if (res_idx + SIZEOF_DNS_ANSWER + len > 0xFFFF) {
+      return 0;
+    }
+    res_idx = (u16_t)(res_idx + SIZEOF_DNS_ANSWER);
+    /* MNAME and RNAME, then SERIAL, REFRESH, RETRY, EXPIRE and MINIMUM */
+    if ((ans.type == PP_HTONS(DNS_RRTYPE_SOA)) && (ans.cls == PP_HTONS(DNS_RRCLASS_IN)) &&
+        (len >= 2 + 5 * sizeof(u32_t))) {
+      if (pbuf_copy_partial(p, &minimum, sizeof(minimum), (u16_t)(res_idx + len - sizeof(minimum))) != sizeof(minimum)) {
+        return 0;
+      }
+      return LWIP_MIN(lwip_ntohl(ans.ttl), lwip_ntohl(minimum));
+    }
+    res_idx = (u16_t)(res_idx + len);
+    --nrecords;
+  }
+  return 0;
+}
+
+/**
+ * The name does not exist or has no address of the type asked: call the
+ * callbacks and keep the entry for the negative TTL, lookups of the name fail
+ * without a query meanwhile.
+ */
+static void
+dns_negative_response(u8_t idx, u32_t ttl)
+{
+  struct dns_table_entry *entry = &dns_table[idx];
+
+  dns_call_found(idx, NULL);
+  if (ttl > DNS_MAX_NEG_TTL) {
+    ttl = DNS_MAX_NEG_TTL;
+  }
+  if (ttl == 0) {
+    entry->state = DNS_STATE_UNUSED;
+    return;
+  }
+  LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": does not exist, for %"U32_F" s\n", entry->name, ttl));
+  entry->state = DNS_STATE_NEGATIVE;
+  entry->ttl = ttl;
+  entry->used = 0;
+#if DNS_PREFETCH_PERCENT
+  entry->prefetch = 0;
+#endif /* DNS_PREFETCH_PERCENT */
+  ip_addr_set_any(LWIP_DNS_ADDRTYPE_IS_IPV6(entry->reqaddrtype), &entry->ipaddr);
+}
+#endif /* DNS_MAX_NEG_TTL */
+
 /**
  * Receive input function for DNS response packets arriving for the dns UDP pcb.
  */
@@ -1176,6 +1497,9 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
   struct dns_answer ans;
   struct dns_query qry;
   u16_t nquestions, nanswers;
+#if DNS_MAX_NEG_TTL
+  u32_t ttl;
+#endif /* DNS_MAX_NEG_TTL */
 
   LWIP_UNUSED_ARG(arg);
   LWIP_UNUSED_ARG(pcb);
@@ -1194,7 +1518,7 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
     txid = lwip_htons(hdr.id);
     for (i = 0; i < DNS_TABLE_SIZE; i++) {
       struct dns_table_entry *entry = &dns_table[i];
-      if ((entry->state == DNS_STATE_ASKING) &&
+      if (DNS_STATE_IS_ASKING(entry->state) &&
           (entry->txid == txid)) {
 
         /* We only care about the question(s) and the answers. The authrr
@@ -1246,10 +1570,22 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
           goto ignore_packet;
         }
         res_idx = (u16_t)(res_idx + SIZEOF_DNS_QUERY);
+#if DNS_SERVER_RTT
+        dns_server_answered(entry);
+#endif /* DNS_SERVER_RTT */
 
         /* Check for error. If so, call callback to inform. */
         if (hdr.flags2 & DNS_FLAG2_ERR_MASK) {
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": error in flags\n", entry->name));
+#if DNS_MAX_NEG_TTL
+          if ((hdr.flags2 & DNS_FLAG2_ERR_MASK) == DNS_FLAG2_ERR_NAME) {
+            /* the name does not exist, the other servers would tell the same */
+            ttl = dns_negative_ttl(p, res_idx, (u32_t)nanswers + lwip_htons(hdr.numauthrr));
+            pbuf_free(p);
+            dns_negative_response(i, ttl);
+            return;
+          }
+#endif /* DNS_MAX_NEG_TTL */
 
           /* if there is another backup DNS server to try
            * then don't stop the DNS request
@@ -1346,11 +1682,17 @@ dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p, const ip_addr_t *addr,
           }
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
           LWIP_DEBUGF(DNS_DEBUG, ("dns_recv: \"%s\": error in response\n", entry->name));
+#if DNS_MAX_NEG_TTL
+          /* no address of the type asked (NODATA) */
+          ttl = dns_negative_ttl(p, res_idx, (u32_t)nanswers + lwip_htons(hdr.numauthrr));
+          pbuf_free(p);
+          dns_negative_response(i, ttl);
+          return;
+#endif /* DNS_MAX_NEG_TTL */
         }
         /* call callback to indicate error, clean up memory and return */
         pbuf_free(p);
-        dns_call_found(i, NULL);
-        dns_table[i].state = DNS_STATE_UNUSED;
+        dns_entry_failed(i);
         return;
       }
     }
@@ -1421,7 +1763,7 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
       break;
     }
     /* check if this is the oldest completed entry */
-    if (entry->state == DNS_STATE_DONE) {
+    if ((entry->state == DNS_STATE_DONE) || (entry->state == DNS_STATE_NEGATIVE)) {
       u8_t age = (u8_t)(dns_seqno - entry->seqno);
       if (age > lseq) {
         lseq = age;
@@ -1432,7 +1774,7 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
 
   /* if we don't have found an unused entry, use the oldest completed one */
   if (i == DNS_TABLE_SIZE) {
-    if ((lseqi >= DNS_TABLE_SIZE) || (dns_table[lseqi].state != DNS_STATE_DONE)) {
+    if (lseqi >= DNS_TABLE_SIZE) {
       /* no entry can be used now, table is full */
       LWIP_DEBUGF(DNS_DEBUG, ("dns_enqueue: \"%s\": DNS entries table is full\n", name));
       return ERR_MEM;
@@ -1473,9 +1815,13 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
   LWIP_DNS_SET_ADDRTYPE(req->reqaddrtype, dns_addrtype);
   req->found = found;
   req->arg   = callback_arg;
+  if (entry->name[0] != 0) {
+    dns_hash_unlink(i);
+  }
   namelen = LWIP_MIN(hostnamelen, DNS_MAX_NAME_LENGTH - 1);
   MEMCPY(entry->name, name, namelen);
   entry->name[namelen] = 0;
+  dns_hash_link(i);
 
 #if ((LWIP_DNS_SECURE & LWIP_DNS_SECURE_RAND_SRC_PORT) != 0)
   entry->pcb_idx = dns_alloc_pcb();
@@ -1513,6 +1859,8 @@ dns_enqueue(const char *name, size_t hostnamelen, dns_found_callback found,
  * - ERR_INPROGRESS enqueue a request to be sent to the DNS server
  *   for resolution if no errors are present.
  * - ERR_ARG: dns client not initialized or invalid hostname
+ * - ERR_VAL: no DNS server configured, or the hostname was reported not to
+ *   exist less than its negative TTL ago (DNS_MAX_NEG_TTL)
  *
  * @param hostname the hostname that is to be queried
  * @param addr pointer to a ip_addr_t where to store the address if it is already
@@ -1548,6 +1896,7 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
                            void *callback_arg, u8_t dns_addrtype)
 {
   size_t hostnamelen;
+  err_t err;
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
   u8_t is_mdns;
 #endif
@@ -1587,7 +1936,8 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
     }
   }
   /* already have this address cached? */
-  if (dns_lookup(hostname, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype)) == ERR_OK) {
+  err = dns_lookup(hostname, addr LWIP_DNS_ADDRTYPE_ARG(dns_addrtype));
+  if (err == ERR_OK) {
     return ERR_OK;
   }
 #if LWIP_IPV4 && LWIP_IPV6
@@ -1606,6 +1956,10 @@ dns_gethostbyname_addrtype(const char *hostname, ip_addr_t *addr, dns_found_call
 #else /* LWIP_IPV4 && LWIP_IPV6 */
   LWIP_UNUSED_ARG(dns_addrtype);
 #endif /* LWIP_IPV4 && LWIP_IPV6 */
+  if (err == ERR_VAL) {
+    /* known not to exist until its negative TTL expires */
+    return ERR_VAL;
+  }
 
 #if LWIP_DNS_SUPPORT_MDNS_QUERIES
   if (strstr(hostname, ".local") == &hostname[hostnamelen] - 6) {
@@ -201,6 +201,12 @@ static err_t dhcp_decline(struct netif *netif);
 #endif /* DHCP_DOES_ARP_CHECK */
 static err_t dhcp_rebind(struct netif *netif);
 static err_t dhcp_reboot(struct netif *netif);
+#if LWIP_DHCP_LEASE_STORE
+static u8_t dhcp_reboot_stored(struct netif *netif);
+#if DHCP_DOES_ARP_CHECK
+static void dhcp_probe(struct netif *netif);
+#endif /* DHCP_DOES_ARP_CHECK */
+#endif /* LWIP_DHCP_LEASE_STORE */
 static void dhcp_set_state(struct dhcp *dhcp, u8_t new_state);
 
 /* receive, unfold, parse and free incoming messages */
@@ -290,6 +296,10 @@ dhcp_handle_nak(struct netif *netif)
   dhcp_set_state(dhcp, DHCP_STATE_BACKING_OFF);
   /* remove IP address from interface (must no longer be used, as per RFC2131) */
   netif_set_addr(netif, IP4_ADDR_ANY4, IP4_ADDR_ANY4, IP4_ADDR_ANY4);
+#if LWIP_DHCP_LEASE_STORE
+  /* nor after a restart */
+  dhcp_lease_store(netif, NULL);
+#endif /* LWIP_DHCP_LEASE_STORE */
   /* We can immediately restart discovery */
   dhcp_discover(netif);
 }
@@ -488,6 +498,12 @@ dhcp_fine_tmr(void)
         /* this client's request timeout triggered */
         dhcp_timeout(netif);
       }
+#if LWIP_DHCP_LEASE_STORE && DHCP_DOES_ARP_CHECK
+      /* probe the stored address again, unless the last period is over */
+      if ((dhcp->probe_timeout > 0) && (--dhcp->probe_timeout > 0)) {
+        dhcp_probe(netif);
+      }
+#endif /* LWIP_DHCP_LEASE_STORE && DHCP_DOES_ARP_CHECK */
     }
   }
 }
@@ -645,6 +661,13 @@ dhcp_handle_ack(struct netif *netif, struct dhcp_msg *msg_in)
   /* (y)our internet address */
   ip4_addr_copy(dhcp->offered_ip_addr, msg_in->yiaddr);
 
+#if LWIP_DHCP_LEASE_STORE
+  /* the server of a stored lease may have changed since */
+  if ((dhcp->state == DHCP_STATE_REBOOTING) && dhcp_option_given(dhcp, DHCP_OPTION_IDX_SERVER_ID)) {
+    ip_addr_set_ip4_u32(&dhcp->server_ip_addr, lwip_htonl(dhcp_get_option_value(dhcp, DHCP_OPTION_IDX_SERVER_ID)));
+  }
+#endif /* LWIP_DHCP_LEASE_STORE */
+
 #if LWIP_DHCP_BOOTP_FILE
   /* copy boot server address,
      boot file name copied in dhcp_parse_reply if not overloaded */
@@ -795,6 +818,13 @@ dhcp_start(struct netif *netif)
     return ERR_OK;
   }
 
+#if LWIP_DHCP_LEASE_STORE
+  /* request the stored lease again, skipping discovery */
+  if (dhcp_reboot_stored(netif)) {
+    return ERR_OK;
+  }
+#endif /* LWIP_DHCP_LEASE_STORE */
+
   /* (re)start the DHCP negotiation */
   result = dhcp_discover(netif);
   if (result != ERR_OK) {
@@ -889,6 +919,12 @@ dhcp_network_changed(struct netif *netif)
         dhcp->autoip_coop_state = DHCP_AUTOIP_COOP_STATE_OFF;
       }
 #endif /* LWIP_DHCP_AUTOIP_COOP */
+#if LWIP_DHCP_LEASE_STORE
+      /* started while the link was down */
+      if ((dhcp->state == DHCP_STATE_INIT) && dhcp_reboot_stored(netif)) {
+        break;
+      }
+#endif /* LWIP_DHCP_LEASE_STORE */
       /* ensure we start with short timeouts, even if already discovering */
       dhcp->tries = 0;
       dhcp_discover(netif);
@@ -925,6 +961,25 @@ dhcp_arp_reply(struct netif *netif, const ip4_addr_t *addr)
       dhcp_decline(netif);
     }
   }
+#if LWIP_DHCP_LEASE_STORE
+  /* did a host respond to the probe of a stored address? */
+  else if ((dhcp != NULL) && (dhcp->probe_timeout > 0) && ip4_addr_cmp(addr, &dhcp->offered_ip_addr)) {
+    LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE | LWIP_DBG_LEVEL_WARNING,
+                ("dhcp_arp_reply(): arp reply matched with stored address, dropping lease\n"));
+    dhcp->probe_timeout = 0;
+    dhcp_lease_store(netif, NULL);
+    if (dhcp->state == DHCP_STATE_REBOOTING) {
+      /* not acknowledged yet, ask for another address */
+      dhcp->tries = 0;
+      dhcp_discover(netif);
+    } else if (dhcp->state == DHCP_STATE_BOUND) {
+      /* already bound, give it back and stop using it */
+      dhcp->t0_timeout = dhcp->t1_renew_time = dhcp->t2_rebind_time = 0;
+      dhcp_decline(netif);
+      netif_set_addr(netif, IP4_ADDR_ANY4, IP4_ADDR_ANY4, IP4_ADDR_ANY4);
+    }
+  }
+#endif /* LWIP_DHCP_LEASE_STORE */
 }
 
 /**
@@ -993,6 +1048,10 @@ dhcp_discover(struct netif *netif)
   u16_t options_out_len;
 
   LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_discover()\n"));
+#if LWIP_DHCP_LEASE_STORE
+  /* the stored address is not asked for any more */
+  dhcp->probe_timeout = 0;
+#endif /* LWIP_DHCP_LEASE_STORE */
 
   ip4_addr_set_any(&dhcp->offered_ip_addr);
   dhcp_set_state(dhcp, DHCP_STATE_SELECTING);
@@ -1136,6 +1195,18 @@ dhcp_bind(struct netif *netif)
 
   netif_set_addr(netif, &dhcp->offered_ip_addr, &sn_mask, &gw_addr);
   /* interface is used by routing now that an address is set */
+
+#if LWIP_DHCP_LEASE_STORE
+  {
+    struct dhcp_lease lease;
+    ip4_addr_copy(lease.addr, dhcp->offered_ip_addr);
+    ip4_addr_copy(lease.netmask, sn_mask);
+    ip4_addr_copy(lease.gw, gw_addr);
+    ip4_addr_copy(lease.server, *ip_2_ip4(&dhcp->server_ip_addr));
+    lease.lease_time = dhcp->offered_t0_lease;
+    dhcp_lease_store(netif, &lease);
+  }
+#endif /* LWIP_DHCP_LEASE_STORE */
 }
 
 /**
@@ -1306,6 +1377,64 @@ dhcp_reboot(struct netif *netif)
   return result;
 }
 
+#if LWIP_DHCP_LEASE_STORE
+#if DHCP_DOES_ARP_CHECK
+/**
+ * Probe the address of a stored lease by ARP, from 0.0.0.0 until it is
+ * bound. A reply is handled by dhcp_arp_reply().
+ *
+ * @param netif the netif under DHCP control
+ */
+static void
+dhcp_probe(struct netif *netif)
+{
+  struct dhcp *dhcp = netif_dhcp_data(netif);
+
+  LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE, ("dhcp_probe(): %"U16_F" periods left\n", (u16_t)dhcp->probe_timeout));
+  if (etharp_query(netif, &dhcp->offered_ip_addr, NULL) != ERR_OK) {
+    LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_LEVEL_WARNING, ("dhcp_probe: could not perform ARP query\n"));
+  }
+}
+#endif /* DHCP_DOES_ARP_CHECK */
+
+/**
+ * Request the lease kept by dhcp_lease_store() again (INIT-REBOOT), while
+ * its address is probed.
+ *
+ * @param netif network interface which must reboot
+ * @return 1 if a lease was stored and is requested, 0 to discover one
+ */
+static u8_t
+dhcp_reboot_stored(struct netif *netif)
+{
+  struct dhcp *dhcp = netif_dhcp_data(netif);
+  struct dhcp_lease lease;
+
+  if (!dhcp_lease_load(netif, &lease) || ip4_addr_isany_val(lease.addr)) {
+    return 0;
+  }
+  LWIP_DEBUGF(DHCP_DEBUG | LWIP_DBG_TRACE | LWIP_DBG_STATE, ("dhcp_reboot_stored(): 0x%08"X32_F"\n", ip4_addr_get_u32(&lease.addr)));
+  ip4_addr_copy(dhcp->offered_ip_addr, lease.addr);
+  ip4_addr_copy(dhcp->offered_sn_mask, lease.netmask);
+  dhcp->subnet_mask_given = 1;
+  ip4_addr_copy(dhcp->offered_gw_addr, lease.gw);
+  ip_addr_copy_from_ip4(dhcp->server_ip_addr, lease.server);
+  dhcp->offered_t0_lease = lease.lease_time;
+
+#if DHCP_DOES_ARP_CHECK
+  /* the first probe goes out before the request, so that a reply can come
+     in before the acknowledgement */
+  if ((netif->flags & NETIF_FLAG_ETHARP) != 0) {
+    dhcp->probe_timeout = DHCP_REBOOT_PROBES;
+    dhcp_probe(netif);
+  }
+#endif /* DHCP_DOES_ARP_CHECK */
+  dhcp->tries = 0;
+  dhcp_reboot(netif);
+  return 1;
+}
+#endif /* LWIP_DHCP_LEASE_STORE */
+
 /**
  * @ingroup dhcp4
  * Release a DHCP lease and stop DHCP statemachine (and AUTOIP if LWIP_DHCP_AUTOIP_COOP).
@@ -1342,8 +1471,16 @@ dhcp_release_and_stop(struct netif *netif)
   dhcp->offered_t0_lease = dhcp->offered_t1_renew = dhcp->offered_t2_rebind = 0;
   dhcp->t1_renew_time = dhcp->t2_rebind_time = dhcp->lease_used = dhcp->t0_timeout = 0;
 
+#if LWIP_DHCP_LEASE_STORE
+  dhcp->probe_timeout = 0;
+#endif /* LWIP_DHCP_LEASE_STORE */
+
   /* send release message when current IP was assigned via DHCP */
   if (dhcp_supplied_address(netif)) {
+#if LWIP_DHCP_LEASE_STORE
+    /* given back, not to be requested again after a restart */
+    dhcp_lease_store(netif, NULL);
+#endif /* LWIP_DHCP_LEASE_STORE */
     /* create and initialize the DHCP message header */
     struct pbuf *p_out;
     u16_t options_out_len;
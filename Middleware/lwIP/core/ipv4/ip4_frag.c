@@ -55,20 +55,20 @@
 /**
  * The IP reassembly code currently has the following limitations:
  * - IP header options are not supported
- * - fragments must not overlap (e.g. due to different routes),
- *   currently, overlapping or duplicate fragments are thrown away
- *   if IP_REASS_CHECK_OVERLAP=1 (the default)!
+ * - overlapping fragments are not merged: a fragment within the data received
+ *   so far is thrown away as a duplicate, one overlapping it only in part
+ *   discards the whole datagram
+ *
+ * Datagrams are found in IP_REASS_HASH_SIZE buckets by source, destination, ID
+ * and protocol. Each keeps its fragments as runs of contiguous data: a fragment
+ * extending a run is chained behind it right away, its IP header hidden, so a
+ * datagram received in order is a single pbuf chain at any time and complete
+ * once that run spans the whole length. The pbufs queued are limited in total
+ * (IP_REASS_MAX_PBUFS) and per source address (IP_REASS_MAX_PBUFS_PER_SRC).
  *
  * @todo: work with IP header options
  */
 
-/** Setting this to 0, you can turn off checking the fragments for overlapping
- * regions. The code gets a little smaller. Only use this if you know that
- * overlapping won't occur on your network! */
-#ifndef IP_REASS_CHECK_OVERLAP
-#define IP_REASS_CHECK_OVERLAP 1
-#endif /* IP_REASS_CHECK_OVERLAP */
-
 /** Set to 0 to prevent freeing the oldest datagram when the reassembly buffer is
  * full (IP_REASS_MAX_PBUFS pbufs are enqueued). The code gets a little smaller.
  * Datagrams will be freed by timeout only. Especially useful when MEMP_NUM_REASSDATA
@@ -77,18 +77,23 @@
 #define IP_REASS_FREE_OLDEST 1
 #endif /* IP_REASS_FREE_OLDEST */
 
+#if (IP_REASS_HASH_SIZE & (IP_REASS_HASH_SIZE - 1)) != 0
+#error "IP_REASS_HASH_SIZE must be a power of 2"
+#endif
+
 #define IP_REASS_FLAG_LASTFRAG 0x01
 
 #define IP_REASS_VALIDATE_TELEGRAM_FINISHED  1
 #define IP_REASS_VALIDATE_PBUF_QUEUED        0
 #define IP_REASS_VALIDATE_PBUF_DROPPED       -1
+#define IP_REASS_VALIDATE_TELEGRAM_DROPPED   -2
 
 /** This is a helper struct which holds the starting
- * offset and the ending offset of this fragment to
- * easily chain the fragments.
+ * offset and the ending offset of a run of contiguous
+ * fragments, its last pbuf and the next run.
  * It has the same packing requirements as the IP header, since it replaces
- * the IP header in memory in incoming fragments (after copying it) to keep
- * track of the various fragments. (-> If the IP header doesn't need packing,
+ * the IP header in memory in the first fragment of each run (after copying it)
+ * to keep track of the runs. (-> If the IP header doesn't need packing,
  * this struct doesn't need packing, too.)
  */
 #ifdef PACK_STRUCT_USE_INCLUDES
@@ -97,6 +102,7 @@
 PACK_STRUCT_BEGIN
 struct ip_reass_helper {
   PACK_STRUCT_FIELD(struct pbuf *next_pbuf);
+  PACK_STRUCT_FIELD(struct pbuf *last_pbuf);
   PACK_STRUCT_FIELD(u16_t start);
   PACK_STRUCT_FIELD(u16_t end);
 } PACK_STRUCT_STRUCT;
@@ -105,18 +111,57 @@ PACK_STRUCT_END
 #  include "arch/epstruct.h"
 #endif
 
+/** Pbufs queued from one source address, while it has datagrams queued */
+struct ip_reass_src {
+  ip4_addr_t addr;
+  u16_t pbufs;
+  u8_t datagrams;
+};
+
 #define IP_ADDRESSES_AND_ID_MATCH(iphdrA, iphdrB)  \
   (ip4_addr_cmp(&(iphdrA)->src, &(iphdrB)->src) && \
    ip4_addr_cmp(&(iphdrA)->dest, &(iphdrB)->dest) && \
-   IPH_ID(iphdrA) == IPH_ID(iphdrB)) ? 1 : 0
+   IPH_ID(iphdrA) == IPH_ID(iphdrB) && \
+   IPH_PROTO(iphdrA) == IPH_PROTO(iphdrB)) ? 1 : 0
 
 /* global variables */
-static struct ip_reassdata *reassdatagrams;
+static struct ip_reassdata *reassdatagrams[IP_REASS_HASH_SIZE];
+static struct ip_reass_src ip_reass_srcs[MEMP_NUM_REASSDATA];
 static u16_t ip_reass_pbufcount;
 
 /* function prototypes */
-static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
-static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev);
+static void ip_reass_dequeue_datagram(struct ip_reassdata *ipr);
+static void ip_reass_free_complete_datagram(struct ip_reassdata *ipr, int timed_out);
+
+/** Hash bucket of the datagram an IP header belongs to */
+static u16_t
+ip_reass_hash(const struct ip_hdr *iphdr)
+{
+  u32_t h;
+
+  h = ip4_addr_get_u32(&iphdr->src) ^ ip4_addr_get_u32(&iphdr->dest);
+  h ^= ((u32_t)IPH_ID(iphdr) << 16) | IPH_PROTO(iphdr);
+  h ^= h >> 16;
+  h *= 0x45d9f3bUL;
+  h ^= h >> 16;
+  return (u16_t)(h & (IP_REASS_HASH_SIZE - 1));
+}
+
+/** Set the tot_len fields of a run, not kept up to date while chaining */
+static void
+ip_reass_seal_run(struct pbuf *p)
+{
+  struct pbuf *q;
+  u32_t tot_len = 0;
+
+  for (q = p; q != NULL; q = q->next) {
+    tot_len += q->len;
+  }
+  for (q = p; q != NULL; q = q->next) {
+    q->tot_len = (u16_t)tot_len;
+    tot_len -= q->len;
+  }
+}
 
 /**
  * Reassembly timer base function
@@ -127,166 +172,129 @@ static int ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_r
 void
 ip_reass_tmr(void)
 {
-  struct ip_reassdata *r, *prev = NULL;
-
-  r = reassdatagrams;
-  while (r != NULL) {
-    /* Decrement the timer. Once it reaches 0,
-     * clean up the incomplete fragment assembly */
-    if (r->timer > 0) {
-      r->timer--;
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer dec %"U16_F"\n", (u16_t)r->timer));
-      prev = r;
-      r = r->next;
-    } else {
-      /* reassembly timed out */
-      struct ip_reassdata *tmp;
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer timed out\n"));
-      tmp = r;
+  struct ip_reassdata *r, *next;
+  u16_t i;
+
+  for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+    for (r = reassdatagrams[i]; r != NULL; r = next) {
       /* get the next pointer before freeing */
-      r = r->next;
-      /* free the helper struct and all enqueued pbufs */
-      ip_reass_free_complete_datagram(tmp, prev);
+      next = r->next;
+      /* Decrement the timer. Once it reaches 0,
+       * clean up the incomplete fragment assembly */
+      if (r->timer > 0) {
+        r->timer--;
+        LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer dec %"U16_F"\n", (u16_t)r->timer));
+      } else {
+        /* reassembly timed out */
+        LWIP_DEBUGF(IP_REASS_DEBUG, ("ip_reass_tmr: timer timed out\n"));
+        /* free the helper struct and all enqueued pbufs */
+        ip_reass_free_complete_datagram(r, 1);
+      }
     }
   }
 }
 
 /**
  * Free a datagram (struct ip_reassdata) and all its pbufs.
- * Updates the total count of enqueued pbufs (ip_reass_pbufcount),
- * SNMP counters and sends an ICMP time exceeded packet.
+ * Updates the count of enqueued pbufs, SNMP counters and, if the datagram
+ * timed out, sends an ICMP time exceeded packet. A datagram discarded to make
+ * room does not, so fragments sent at a full buffer cannot draw ICMP packets.
  *
  * @param ipr datagram to free
- * @param prev the previous datagram in the linked list
- * @return the number of pbufs freed
+ * @param timed_out 1 if the datagram is freed by ip_reass_tmr()
  */
-static int
-ip_reass_free_complete_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
+static void
+ip_reass_free_complete_datagram(struct ip_reassdata *ipr, int timed_out)
 {
-  u16_t pbufs_freed = 0;
-  u16_t clen;
-  struct pbuf *p;
-  struct ip_reass_helper *iprh;
-
-  LWIP_ASSERT("prev != ipr", prev != ipr);
-  if (prev != NULL) {
-    LWIP_ASSERT("prev->next == ipr", prev->next == ipr);
-  }
+  struct pbuf *p, *next;
 
   MIB2_STATS_INC(mib2.ipreasmfails);
+  p = ipr->p;
 #if LWIP_ICMP
-  iprh = (struct ip_reass_helper *)ipr->p->payload;
-  if (iprh->start == 0) {
+  if (timed_out && (p != NULL) && (((struct ip_reass_helper *)p->payload)->start == 0)) {
     /* The first fragment was received, send ICMP time exceeded. */
-    /* First, de-queue the first pbuf from r->p. */
-    p = ipr->p;
-    ipr->p = iprh->next_pbuf;
+    /* First, de-queue the first run from r->p. */
+    ipr->p = ((struct ip_reass_helper *)p->payload)->next_pbuf;
     /* Then, copy the original header into it. */
     SMEMCPY(p->payload, &ipr->iphdr, IP_HLEN);
+    ip_reass_seal_run(p);
     icmp_time_exceeded(p, ICMP_TE_FRAG);
-    clen = pbuf_clen(p);
-    LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
-    pbufs_freed = (u16_t)(pbufs_freed + clen);
     pbuf_free(p);
+    p = ipr->p;
   }
+#else /* LWIP_ICMP */
+  LWIP_UNUSED_ARG(timed_out);
 #endif /* LWIP_ICMP */
 
-  /* First, free all received pbufs.  The individual pbufs need to be released
-     separately as they have not yet been chained */
-  p = ipr->p;
+  /* Then, free all runs. Each one is a pbuf chain, the runs are linked
+     through their helper structs */
   while (p != NULL) {
-    struct pbuf *pcur;
-    iprh = (struct ip_reass_helper *)p->payload;
-    pcur = p;
     /* get the next pointer before freeing */
-    p = iprh->next_pbuf;
-    clen = pbuf_clen(pcur);
-    LWIP_ASSERT("pbufs_freed + clen <= 0xffff", pbufs_freed + clen <= 0xffff);
-    pbufs_freed = (u16_t)(pbufs_freed + clen);
-    pbuf_free(pcur);
+    next = ((struct ip_reass_helper *)p->payload)->next_pbuf;
+    pbuf_free(p);
+    p = next;
   }
   /* Then, unchain the struct ip_reassdata from the list and free it. */
-  ip_reass_dequeue_datagram(ipr, prev);
-  LWIP_ASSERT("ip_reass_pbufcount >= pbufs_freed", ip_reass_pbufcount >= pbufs_freed);
-  ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - pbufs_freed);
-
-  return pbufs_freed;
+  ip_reass_dequeue_datagram(ipr);
 }
 
 #if IP_REASS_FREE_OLDEST
 /**
- * Free the oldest datagram to make room for enqueueing new fragments.
- * The datagram 'fraghdr' belongs to is not freed!
+ * Free a datagram to make room for enqueueing new fragments: the oldest one of
+ * 'src', or if src is NULL, the oldest one of the source holding most pbufs
+ * (most datagrams if 'structs' is set). A flood from one source thus frees its
+ * own datagrams before those of others.
+ * The datagram 'keep' the current fragment belongs to is not freed!
  *
- * @param fraghdr IP header of the current fragment
- * @param pbufs_needed number of pbufs needed to enqueue
- *        (used for freeing other datagrams if not enough space)
- * @return the number of pbufs freed
+ * @param keep datagram of the current fragment, NULL if it has none yet
+ * @param src source to free a datagram of, NULL for any
+ * @param structs 1 if short of struct ip_reassdata rather than pbufs
+ * @return 1 if a datagram was freed, 0 if there was none to free
  */
 static int
-ip_reass_remove_oldest_datagram(struct ip_hdr *fraghdr, int pbufs_needed)
+ip_reass_remove_oldest_datagram(const struct ip_reassdata *keep, const struct ip_reass_src *src, int structs)
 {
-  /* @todo Can't we simply remove the last datagram in the
-   *       linked list behind reassdatagrams?
-   */
-  struct ip_reassdata *r, *oldest, *prev, *oldest_prev;
-  int pbufs_freed = 0, pbufs_freed_current;
-  int other_datagrams;
-
-  /* Free datagrams until being allowed to enqueue 'pbufs_needed' pbufs,
-   * but don't free the datagram that 'fraghdr' belongs to! */
-  do {
-    oldest = NULL;
-    prev = NULL;
-    oldest_prev = NULL;
-    other_datagrams = 0;
-    r = reassdatagrams;
-    while (r != NULL) {
-      if (!IP_ADDRESSES_AND_ID_MATCH(&r->iphdr, fraghdr)) {
-        /* Not the same datagram as fraghdr */
-        other_datagrams++;
-        if (oldest == NULL) {
-          oldest = r;
-          oldest_prev = prev;
-        } else if (r->timer <= oldest->timer) {
-          /* older than the previous oldest */
-          oldest = r;
-          oldest_prev = prev;
-        }
+  struct ip_reassdata *r, *oldest = NULL;
+  u16_t i, held, oldest_held = 0;
+
+  for (i = 0; i < IP_REASS_HASH_SIZE; i++) {
+    for (r = reassdatagrams[i]; r != NULL; r = r->next) {
+      if ((r == keep) || ((src != NULL) && (r->src != src))) {
+        continue;
       }
-      if (r->next != NULL) {
-        prev = r;
+      held = structs ? r->src->datagrams : r->src->pbufs;
+      if ((oldest == NULL) || (held > oldest_held) ||
+          ((held == oldest_held) && (r->timer < oldest->timer))) {
+        oldest = r;
+        oldest_held = held;
       }
-      r = r->next;
     }
-    if (oldest != NULL) {
-      pbufs_freed_current = ip_reass_free_complete_datagram(oldest, oldest_prev);
-      pbufs_freed += pbufs_freed_current;
-    }
-  } while ((pbufs_freed < pbufs_needed) && (other_datagrams > 1));
-  return pbufs_freed;
+  }
+  if (oldest == NULL) {
+    return 0;
+  }
+  ip_reass_free_complete_datagram(oldest, 0);
+  return 1;
 }
 #endif /* IP_REASS_FREE_OLDEST */
 
 /**
- * Enqueues a new fragment into the fragment queue
+ * Enqueues a new datagram into the datagram queue
  * @param fraghdr points to the new fragments IP hdr
- * @param clen number of pbufs needed to enqueue (used for freeing other datagrams if not enough space)
+ * @param src pbufs queued from the fragment's source, NULL if none
  * @return A pointer to the queue location into which the fragment was enqueued
  */
 static struct ip_reassdata *
-ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
+ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, struct ip_reass_src *src)
 {
   struct ip_reassdata *ipr;
-#if ! IP_REASS_FREE_OLDEST
-  LWIP_UNUSED_ARG(clen);
-#endif
+  u16_t i;
 
   /* No matching previous fragment found, allocate a new reassdata struct */
   ipr = (struct ip_reassdata *)memp_malloc(MEMP_REASSDATA);
   if (ipr == NULL) {
 #if IP_REASS_FREE_OLDEST
-    if (ip_reass_remove_oldest_datagram(fraghdr, clen) >= clen) {
+    if (ip_reass_remove_oldest_datagram(NULL, NULL, 1)) {
       ipr = (struct ip_reassdata *)memp_malloc(MEMP_REASSDATA);
     }
     if (ipr == NULL)
@@ -297,15 +305,36 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
       return NULL;
     }
   }
+  if (src == NULL) {
+    /* a source entry is free as long as not more than MEMP_NUM_REASSDATA
+       datagrams are, i.e. unless MEMP_MEM_MALLOC lifts that limit */
+    for (i = 0; i < MEMP_NUM_REASSDATA; i++) {
+      if (ip_reass_srcs[i].datagrams == 0) {
+        src = &ip_reass_srcs[i];
+        ip4_addr_copy(src->addr, fraghdr->src);
+        src->pbufs = 0;
+        break;
+      }
+    }
+    if (src == NULL) {
+      memp_free(MEMP_REASSDATA, ipr);
+      IPFRAG_STATS_INC(ip_frag.memerr);
+      LWIP_DEBUGF(IP_REASS_DEBUG, ("Failed to alloc reassdata source\n"));
+      return NULL;
+    }
+  }
   memset(ipr, 0, sizeof(struct ip_reassdata));
   ipr->timer = IP_REASS_MAXAGE;
+  ipr->src = src;
+  src->datagrams++;
 
-  /* enqueue the new structure to the front of the list */
-  ipr->next = reassdatagrams;
-  reassdatagrams = ipr;
   /* copy the ip header for later tests and input */
   /* @todo: no ip options supported? */
   SMEMCPY(&(ipr->iphdr), fraghdr, IP_HLEN);
+  /* enqueue the new structure to the front of its bucket */
+  i = ip_reass_hash(fraghdr);
+  ipr->next = reassdatagrams[i];
+  reassdatagrams[i] = ipr;
   return ipr;
 }
 
@@ -314,27 +343,33 @@ ip_reass_enqueue_new_datagram(struct ip_hdr *fraghdr, int clen)
  * @param ipr points to the queue entry to dequeue
  */
 static void
-ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
+ip_reass_dequeue_datagram(struct ip_reassdata *ipr)
 {
+  struct ip_reassdata **r;
+
   /* dequeue the reass struct  */
-  if (reassdatagrams == ipr) {
-    /* it was the first in the list */
-    reassdatagrams = ipr->next;
-  } else {
-    /* it wasn't the first, so it must have a valid 'prev' */
-    LWIP_ASSERT("sanity check linked list", prev != NULL);
-    prev->next = ipr->next;
+  for (r = &reassdatagrams[ip_reass_hash(&ipr->iphdr)]; *r != ipr; r = &(*r)->next) {
+    LWIP_ASSERT("sanity check linked list", *r != NULL);
   }
+  *r = ipr->next;
+
+  /* and adjust the number of pbufs currently queued for reassembly. */
+  LWIP_ASSERT("ip_reass_pbufcount >= clen", ip_reass_pbufcount >= ipr->clen);
+  LWIP_ASSERT("src->pbufs >= clen", ipr->src->pbufs >= ipr->clen);
+  ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - ipr->clen);
+  ipr->src->pbufs = (u16_t)(ipr->src->pbufs - ipr->clen);
+  ipr->src->datagrams--;
 
   /* now we can free the ip_reassdata struct */
   memp_free(MEMP_REASSDATA, ipr);
 }
 
 /**
- * Chain a new pbuf into the pbuf list that composes the datagram.  The pbuf list
- * will grow over time as  new pbufs are rx.
- * Also checks that the datagram passes basic continuity checks (if the last
- * fragment was received at least once).
+ * Chain a new pbuf into the runs that compose the datagram: behind the run it
+ * continues, or as a new run, merged with the run it is followed by if they
+ * meet. The runs grow over time as new pbufs are rx.
+ * Also checks that the fragment agrees with the data and the end of the
+ * datagram received so far.
  * @param ipr points to the reassembly state
  * @param new_p points to the pbuf for the current fragment
  * @param is_last is 1 if this pbuf has MF==0 (ipr->flags not updated yet)
@@ -343,151 +378,111 @@ ip_reass_dequeue_datagram(struct ip_reassdata *ipr, struct ip_reassdata *prev)
 static int
 ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct pbuf *new_p, int is_last)
 {
-  struct ip_reass_helper *iprh, *iprh_tmp, *iprh_prev = NULL;
-  struct pbuf *q;
-  u16_t offset, len;
+  struct ip_reass_helper *iprh, *iprh_tmp;
+  struct pbuf *q, *prev = NULL, *before = NULL, *after, *last;
+  u16_t offset, len, end;
   u8_t hlen;
   struct ip_hdr *fraghdr;
-  int valid = 1;
 
   /* Extract length and fragment offset from current fragment */
   fraghdr = (struct ip_hdr *)new_p->payload;
   len = lwip_ntohs(IPH_LEN(fraghdr));
   hlen = IPH_HL_BYTES(fraghdr);
-  if (hlen > len) {
-    /* invalid datagram */
+  if (hlen >= len) {
+    /* invalid datagram or nothing to chain */
     return IP_REASS_VALIDATE_PBUF_DROPPED;
   }
   len = (u16_t)(len - hlen);
   offset = IPH_OFFSET_BYTES(fraghdr);
-
-  /* overwrite the fragment's ip header from the pbuf with our helper struct,
-   * and setup the embedded helper structure. */
-  /* make sure the struct ip_reass_helper fits into the IP header */
-  LWIP_ASSERT("sizeof(struct ip_reass_helper) <= IP_HLEN",
-              sizeof(struct ip_reass_helper) <= IP_HLEN);
-  iprh = (struct ip_reass_helper *)new_p->payload;
-  iprh->next_pbuf = NULL;
-  iprh->start = offset;
-  iprh->end = (u16_t)(offset + len);
-  if (iprh->end < offset) {
+  end = (u16_t)(offset + len);
+  if (end < offset) {
     /* u16_t overflow, cannot handle this */
     return IP_REASS_VALIDATE_PBUF_DROPPED;
   }
+  if (((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0) &&
+      ((end > ipr->datagram_len) || (is_last && (end != ipr->datagram_len)))) {
+    /* the fragment disagrees with the last one on the length */
+    return IP_REASS_VALIDATE_TELEGRAM_DROPPED;
+  }
 
-  /* Iterate through until we either get to the end of the list (append),
-   * or we find one with a larger offset (insert). */
-  for (q = ipr->p; q != NULL;) {
+  /* Find the first run that ends at or after the start of the fragment. */
+  for (q = ipr->p; q != NULL; q = iprh_tmp->next_pbuf) {
     iprh_tmp = (struct ip_reass_helper *)q->payload;
-    if (iprh->start < iprh_tmp->start) {
-      /* the new pbuf should be inserted before this */
-      iprh->next_pbuf = q;
-      if (iprh_prev != NULL) {
-        /* not the fragment with the lowest offset */
-#if IP_REASS_CHECK_OVERLAP
-        if ((iprh->start < iprh_prev->end) || (iprh->end > iprh_tmp->start)) {
-          /* fragment overlaps with previous or following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
-#endif /* IP_REASS_CHECK_OVERLAP */
-        iprh_prev->next_pbuf = new_p;
-        if (iprh_prev->end != iprh->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      } else {
-#if IP_REASS_CHECK_OVERLAP
-        if (iprh->end > iprh_tmp->start) {
-          /* fragment overlaps with following, throw away */
-          return IP_REASS_VALIDATE_PBUF_DROPPED;
-        }
-#endif /* IP_REASS_CHECK_OVERLAP */
-        /* fragment with the lowest offset */
-        ipr->p = new_p;
-      }
+    if (iprh_tmp->end >= offset) {
       break;
-    } else if (iprh->start == iprh_tmp->start) {
-      /* received the same datagram twice: no need to keep the datagram */
-      return IP_REASS_VALIDATE_PBUF_DROPPED;
-#if IP_REASS_CHECK_OVERLAP
-    } else if (iprh->start < iprh_tmp->end) {
-      /* overlap: no need to keep the new datagram */
+    }
+    prev = q;
+  }
+  after = q;
+  if (q != NULL) {
+    iprh_tmp = (struct ip_reass_helper *)q->payload;
+    if ((iprh_tmp->start <= offset) && (iprh_tmp->end >= end)) {
+      /* received the same data twice: no need to keep the fragment */
       return IP_REASS_VALIDATE_PBUF_DROPPED;
-#endif /* IP_REASS_CHECK_OVERLAP */
-    } else {
-      /* Check if the fragments received so far have no holes. */
-      if (iprh_prev != NULL) {
-        if (iprh_prev->end != iprh_tmp->start) {
-          /* There is a fragment missing between the current
-           * and the previous fragment */
-          valid = 0;
-        }
-      }
     }
-    q = iprh_tmp->next_pbuf;
-    iprh_prev = iprh_tmp;
-  }
-
-  /* If q is NULL, then we made it to the end of the list. Determine what to do now */
-  if (q == NULL) {
-    if (iprh_prev != NULL) {
-      /* this is (for now), the fragment with the highest offset:
-       * chain it to the last fragment */
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("check fragments don't overlap", iprh_prev->end <= iprh->start);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      iprh_prev->next_pbuf = new_p;
-      if (iprh_prev->end != iprh->start) {
-        valid = 0;
-      }
+    if (iprh_tmp->end == offset) {
+      /* the fragment continues this run */
+      before = q;
+      after = iprh_tmp->next_pbuf;
+    }
+  }
+  if ((after != NULL) && (((struct ip_reass_helper *)after->payload)->start < end)) {
+    /* overlap with data received before: the datagram cannot be trusted */
+    return IP_REASS_VALIDATE_TELEGRAM_DROPPED;
+  }
+  if (is_last && (after != NULL)) {
+    /* data received before lies beyond the end */
+    return IP_REASS_VALIDATE_TELEGRAM_DROPPED;
+  }
+
+  for (last = new_p; last->next != NULL; last = last->next) {
+    /* find the last pbuf of the fragment */
+  }
+  if (before != NULL) {
+    /* hide the fragment's ip header and chain it behind the run */
+    iprh = (struct ip_reass_helper *)before->payload;
+    pbuf_remove_header(new_p, hlen);
+    iprh->last_pbuf->next = new_p;
+    iprh->last_pbuf = last;
+    iprh->end = end;
+  } else {
+    /* overwrite the fragment's ip header from the pbuf with our helper struct,
+     * and setup the embedded helper structure. */
+    /* make sure the struct ip_reass_helper fits into the IP header */
+    LWIP_ASSERT("sizeof(struct ip_reass_helper) <= IP_HLEN",
+                sizeof(struct ip_reass_helper) <= IP_HLEN);
+    iprh = (struct ip_reass_helper *)new_p->payload;
+    iprh->next_pbuf = after;
+    iprh->last_pbuf = last;
+    iprh->start = offset;
+    iprh->end = end;
+    if (prev != NULL) {
+      ((struct ip_reass_helper *)prev->payload)->next_pbuf = new_p;
     } else {
-#if IP_REASS_CHECK_OVERLAP
-      LWIP_ASSERT("no previous fragment, this must be the first fragment!",
-                  ipr->p == NULL);
-#endif /* IP_REASS_CHECK_OVERLAP */
-      /* this is the first fragment we ever received for this ip datagram */
+      /* the run with the lowest offset */
       ipr->p = new_p;
     }
   }
+  if ((after != NULL) && (((struct ip_reass_helper *)after->payload)->start == end)) {
+    /* the gap to the following run is closed: append that run, too */
+    iprh_tmp = (struct ip_reass_helper *)after->payload;
+    iprh->next_pbuf = iprh_tmp->next_pbuf;
+    iprh->end = iprh_tmp->end;
+    last = iprh_tmp->last_pbuf;
+    pbuf_remove_header(after, IP_HLEN);
+    iprh->last_pbuf->next = after;
+    iprh->last_pbuf = last;
+  }
 
   /* At this point, the validation part begins: */
-  /* If we already received the last fragment */
+  /* If we already received the last fragment, the datagram is complete
+     once its first run spans all of it */
   if (is_last || ((ipr->flags & IP_REASS_FLAG_LASTFRAG) != 0)) {
-    /* and had no holes so far */
-    if (valid) {
-      /* then check if the rest of the fragments is here */
-      /* Check if the queue starts with the first datagram */
-      if ((ipr->p == NULL) || (((struct ip_reass_helper *)ipr->p->payload)->start != 0)) {
-        valid = 0;
-      } else {
-        /* and check that there are no holes after this datagram */
-        iprh_prev = iprh;
-        q = iprh->next_pbuf;
-        while (q != NULL) {
-          iprh = (struct ip_reass_helper *)q->payload;
-          if (iprh_prev->end != iprh->start) {
-            valid = 0;
-            break;
-          }
-          iprh_prev = iprh;
-          q = iprh->next_pbuf;
-        }
-        /* if still valid, all fragments are received
-         * (because to the MF==0 already arrived */
-        if (valid) {
-          LWIP_ASSERT("sanity check", ipr->p != NULL);
-          LWIP_ASSERT("sanity check",
-                      ((struct ip_reass_helper *)ipr->p->payload) != iprh);
-          LWIP_ASSERT("validate_datagram:next_pbuf!=NULL",
-                      iprh->next_pbuf == NULL);
-        }
-      }
+    iprh = (struct ip_reass_helper *)ipr->p->payload;
+    if ((iprh->start == 0) && (iprh->end == (is_last ? end : ipr->datagram_len))) {
+      LWIP_ASSERT("validate_datagram:next_pbuf!=NULL", iprh->next_pbuf == NULL);
+      return IP_REASS_VALIDATE_TELEGRAM_FINISHED;
     }
-    /* If valid is 0 here, there are some fragments missing in the middle
-     * (since MF == 0 has already arrived). Such datagrams simply time out if
-     * no more fragments are received... */
-    return valid ? IP_REASS_VALIDATE_TELEGRAM_FINISHED : IP_REASS_VALIDATE_PBUF_QUEUED;
   }
   /* If we come here, not all fragments were received, yet! */
   return IP_REASS_VALIDATE_PBUF_QUEUED; /* not yet valid! */
@@ -502,14 +497,14 @@ ip_reass_chain_frag_into_datagram_and_validate(struct ip_reassdata *ipr, struct
 struct pbuf *
 ip4_reass(struct pbuf *p)
 {
-  struct pbuf *r;
   struct ip_hdr *fraghdr;
   struct ip_reassdata *ipr;
-  struct ip_reass_helper *iprh;
-  u16_t offset, len, clen;
+  struct ip_reass_src *src;
+  u16_t offset, len, clen, src_pbufs;
   u8_t hlen;
   int valid;
   int is_last;
+  u16_t i;
 
   IPFRAG_STATS_INC(ip_frag.recv);
   MIB2_STATS_INC(mib2.ipreasmreqds);
@@ -531,27 +526,8 @@ ip4_reass(struct pbuf *p)
   }
   len = (u16_t)(len - hlen);
 
-  /* Check if we are allowed to enqueue more datagrams. */
-  clen = pbuf_clen(p);
-  if ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
-#if IP_REASS_FREE_OLDEST
-    if (!ip_reass_remove_oldest_datagram(fraghdr, clen) ||
-        ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS))
-#endif /* IP_REASS_FREE_OLDEST */
-    {
-      /* No datagram could be freed and still too many pbufs enqueued */
-      LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: Overflow condition: pbufct=%d, clen=%d, MAX=%d\n",
-                                   ip_reass_pbufcount, clen, IP_REASS_MAX_PBUFS));
-      IPFRAG_STATS_INC(ip_frag.memerr);
-      /* @todo: send ICMP time exceeded here? */
-      /* drop this pbuf */
-      goto nullreturn;
-    }
-  }
-
-  /* Look for the datagram the fragment belongs to in the current datagram queue,
-   * remembering the previous in the queue for later dequeueing. */
-  for (ipr = reassdatagrams; ipr != NULL; ipr = ipr->next) {
+  /* Look for the datagram the fragment belongs to in its hash bucket. */
+  for (ipr = reassdatagrams[ip_reass_hash(fraghdr)]; ipr != NULL; ipr = ipr->next) {
     /* Check if the incoming fragment matches the one currently present
        in the reassembly buffer. If so, we proceed with copying the
        fragment into the buffer. */
@@ -562,10 +538,55 @@ ip4_reass(struct pbuf *p)
       break;
     }
   }
+  if (ipr != NULL) {
+    src = ipr->src;
+  } else {
+    src = NULL;
+    for (i = 0; i < MEMP_NUM_REASSDATA; i++) {
+      if ((ip_reass_srcs[i].datagrams != 0) && ip4_addr_cmp(&ip_reass_srcs[i].addr, &fraghdr->src)) {
+        src = &ip_reass_srcs[i];
+        break;
+      }
+    }
+  }
+
+  /* Check if we are allowed to enqueue more pbufs, from this source and in total. */
+  clen = pbuf_clen(p);
+  src_pbufs = 0;
+  if (src != NULL) {
+#if IP_REASS_FREE_OLDEST
+    while (((src->pbufs + clen) > IP_REASS_MAX_PBUFS_PER_SRC) &&
+           ip_reass_remove_oldest_datagram(ipr, src, 0)) {
+      /* freed the oldest datagram of the source */
+    }
+#endif /* IP_REASS_FREE_OLDEST */
+    src_pbufs = src->pbufs;
+  }
+  if ((src_pbufs + clen) > IP_REASS_MAX_PBUFS_PER_SRC) {
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: Overflow condition: source pbufct=%d, clen=%d, MAX=%d\n",
+                                 src_pbufs, clen, IP_REASS_MAX_PBUFS_PER_SRC));
+    IPFRAG_STATS_INC(ip_frag.memerr);
+    goto nullreturn;
+  }
+#if IP_REASS_FREE_OLDEST
+  while (((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) &&
+         ip_reass_remove_oldest_datagram(ipr, NULL, 0)) {
+    /* freed the oldest datagram of the source holding most */
+  }
+#endif /* IP_REASS_FREE_OLDEST */
+  if ((ip_reass_pbufcount + clen) > IP_REASS_MAX_PBUFS) {
+    /* No datagram could be freed and still too many pbufs enqueued */
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: Overflow condition: pbufct=%d, clen=%d, MAX=%d\n",
+                                 ip_reass_pbufcount, clen, IP_REASS_MAX_PBUFS));
+    IPFRAG_STATS_INC(ip_frag.memerr);
+    /* @todo: send ICMP time exceeded here? */
+    /* drop this pbuf */
+    goto nullreturn;
+  }
 
   if (ipr == NULL) {
     /* Enqueue a new datagram into the datagram queue */
-    ipr = ip_reass_enqueue_new_datagram(fraghdr, clen);
+    ipr = ip_reass_enqueue_new_datagram(fraghdr, src);
     /* Bail if unable to enqueue */
     if (ipr == NULL) {
       goto nullreturn;
@@ -594,17 +615,24 @@ ip4_reass(struct pbuf *p)
     }
   }
   /* find the right place to insert this pbuf */
-  /* @todo: trim pbufs if fragments are overlapping */
   valid = ip_reass_chain_frag_into_datagram_and_validate(ipr, p, is_last);
   if (valid == IP_REASS_VALIDATE_PBUF_DROPPED) {
     goto nullreturn_ipr;
   }
+  if (valid == IP_REASS_VALIDATE_TELEGRAM_DROPPED) {
+    LWIP_DEBUGF(IP_REASS_DEBUG, ("ip4_reass: inconsistent fragment, datagram discarded\n"));
+    IPFRAG_STATS_INC(ip_frag.err);
+    ip_reass_free_complete_datagram(ipr, 0);
+    goto nullreturn;
+  }
   /* if we come here, the pbuf has been enqueued */
 
   /* Track the current number of pbufs current 'in-flight', in order to limit
      the number of fragments that may be enqueued at any one time
      (overflow checked by testing against IP_REASS_MAX_PBUFS) */
   ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount + clen);
+  ipr->src->pbufs = (u16_t)(ipr->src->pbufs + clen);
+  ipr->clen = (u16_t)(ipr->clen + clen);
   if (is_last) {
     u16_t datagram_len = (u16_t)(offset + len);
     ipr->datagram_len = datagram_len;
@@ -615,16 +643,14 @@ ip4_reass(struct pbuf *p)
   }
 
   if (valid == IP_REASS_VALIDATE_TELEGRAM_FINISHED) {
-    struct ip_reassdata *ipr_prev;
     /* the totally last fragment (flag more fragments = 0) was received at least
-     * once AND all fragments are received */
+     * once AND all fragments are received: they are chained in the first run */
     u16_t datagram_len = (u16_t)(ipr->datagram_len + IP_HLEN);
 
-    /* save the second pbuf before copying the header over the pointer */
-    r = ((struct ip_reass_helper *)ipr->p->payload)->next_pbuf;
+    p = ipr->p;
 
     /* copy the original ip header back to the first pbuf */
-    fraghdr = (struct ip_hdr *)(ipr->p->payload);
+    fraghdr = (struct ip_hdr *)(p->payload);
     SMEMCPY(fraghdr, &ipr->iphdr, IP_HLEN);
     IPH_LEN_SET(fraghdr, lwip_htons(datagram_len));
     IPH_OFFSET_SET(fraghdr, 0);
@@ -636,36 +662,10 @@ ip4_reass(struct pbuf *p)
     }
 #endif /* CHECKSUM_GEN_IP */
 
-    p = ipr->p;
-
-    /* chain together the pbufs contained within the reass_data list. */
-    while (r != NULL) {
-      iprh = (struct ip_reass_helper *)r->payload;
-
-      /* hide the ip header for every succeeding fragment */
-      pbuf_remove_header(r, IP_HLEN);
-      pbuf_cat(p, r);
-      r = iprh->next_pbuf;
-    }
-
-    /* find the previous entry in the linked list */
-    if (ipr == reassdatagrams) {
-      ipr_prev = NULL;
-    } else {
-      for (ipr_prev = reassdatagrams; ipr_prev != NULL; ipr_prev = ipr_prev->next) {
-        if (ipr_prev->next == ipr) {
-          break;
-        }
-      }
-    }
+    ip_reass_seal_run(p);
 
     /* release the sources allocate for the fragment queue entry */
-    ip_reass_dequeue_datagram(ipr, ipr_prev);
-
-    /* and adjust the number of pbufs currently queued for reassembly. */
-    clen = pbuf_clen(p);
-    LWIP_ASSERT("ip_reass_pbufcount >= clen", ip_reass_pbufcount >= clen);
-    ip_reass_pbufcount = (u16_t)(ip_reass_pbufcount - clen);
+    ip_reass_dequeue_datagram(ipr);
 
     MIB2_STATS_INC(mib2.ipreasmoks);
 
@@ -680,8 +680,7 @@ nullreturn_ipr:
   LWIP_ASSERT("ipr != NULL", ipr != NULL);
   if (ipr->p == NULL) {
     /* dropped pbuf after creating a new datagram entry: remove the entry, too */
-    LWIP_ASSERT("not firstalthough just enqueued", ipr == reassdatagrams);
-    ip_reass_dequeue_datagram(ipr, NULL);
+    ip_reass_dequeue_datagram(ipr);
   }
 
 nullreturn:
@@ -132,6 +132,8 @@ tcp_input(struct pbuf *p, struct netif *inp)
 
   PERF_START;
 
+  LWIP_PBUF_TRACE(p, PBUF_TRACE_TRANSPORT);
+
   TCP_STATS_INC(tcp.recv);
   MIB2_STATS_INC(mib2.tcpinsegs);
 
@@ -308,6 +310,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
           tcp_timewait_input(pcb);
         }
         pbuf_free(p);
+        PERF_STOP("tcp_input");
         return;
       }
     }
@@ -380,6 +383,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
         tcp_listen_input(lpcb);
       }
       pbuf_free(p);
+      PERF_STOP("tcp_input");
       return;
     }
   }
@@ -498,6 +502,7 @@ tcp_input(struct pbuf *p, struct netif *inp)
           }
 
           /* Notify application that data has been received. */
+          LWIP_PBUF_TRACE(recv_data, PBUF_TRACE_APP);
           TCP_EVENT_RECV(pcb, recv_data, ERR_OK, err);
           if (err == ERR_ABRT) {
 #if TCP_QUEUE_OOSEQ && LWIP_WND_SCALE
@@ -589,6 +594,7 @@ dropped:
   TCP_STATS_INC(tcp.drop);
   MIB2_STATS_INC(mib2.tcpinerrs);
   pbuf_free(p);
+  PERF_STOP("tcp_input");
 }
 
 /** Called from tcp_input to check for TF_CLOSED flag. This results in closing
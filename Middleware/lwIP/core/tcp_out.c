@@ -125,6 +125,7 @@
 #endif
 
 /* Forward declarations.*/
+static err_t tcp_write_impl(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, const u16_t *precalc);
 static err_t tcp_output_segment(struct tcp_seg *seg, struct tcp_pcb *pcb, struct netif *netif);
 
 /* tcp_route: common code that returns a fixed bound netif or calls ip_route */
@@ -388,6 +389,31 @@ tcp_write_checks(struct tcp_pcb *pcb, u16_t len)
  */
 err_t
 tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
+{
+  return tcp_write_impl(pcb, arg, len, apiflags, NULL);
+}
+
+#if LWIP_CHECKSUM_ON_COPY
+/**
+ * @ingroup tcp_raw
+ * Like tcp_write() for data that is not copied, with its checksum known in
+ * advance (e.g. computed by makefsdata), so the data is never read by the
+ * CPU before the netif sends it.
+ *
+ * The checksum only applies if the data ends up in one segment, i.e. len
+ * fits into the MSS: otherwise it is computed as by tcp_write().
+ *
+ * @param chksum one's complement sum of the data (~inet_chksum())
+ */
+err_t
+tcp_write_precalc(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, u16_t chksum)
+{
+  return tcp_write_impl(pcb, arg, len, apiflags, &chksum);
+}
+#endif /* LWIP_CHECKSUM_ON_COPY */
+
+static err_t
+tcp_write_impl(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags, const u16_t *precalc)
 {
   struct pbuf *concat_p = NULL;
   struct tcp_seg *last_unsent = NULL, *seg = NULL, *prev_seg = NULL, *queue = NULL;
@@ -412,6 +438,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
   u16_t mss_local;
 
   LWIP_ERROR("tcp_write: invalid pcb", pcb != NULL, return ERR_ARG);
+  LWIP_UNUSED_ARG(precalc); /* without TCP_CHECKSUM_ON_COPY */
 
   /* don't allocate segments bigger than half the maximum window we ever received */
   mss_local = LWIP_MIN(pcb->mss, TCPWND_MIN16(pcb->snd_wnd_max / 2));
@@ -485,6 +512,13 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
     unsent_optlen = LWIP_TCP_OPT_LENGTH_SEGMENT(last_unsent->flags, pcb);
     LWIP_ASSERT("mss_local is too small", mss_local >= last_unsent->len + unsent_optlen);
     space = mss_local - (last_unsent->len + unsent_optlen);
+#if TCP_CHECKSUM_ON_COPY
+    if ((precalc != NULL) && ((space < len) || (pcb->unsent_oversize > 0))) {
+      /* Keep precalculated data in one piece so that its checksum applies:
+         don't fill up the last segment, start a new one */
+      space = 0;
+    }
+#endif /* TCP_CHECKSUM_ON_COPY */
 
     /*
      * Phase 1: Copy data directly into an oversized pbuf.
@@ -499,7 +533,7 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
     LWIP_ASSERT("unsent_oversize mismatch (pcb vs. last_unsent)",
                 pcb->unsent_oversize == last_unsent->oversize_left);
 #endif /* TCP_OVERSIZE_DBGCHECK */
-    oversize = pcb->unsent_oversize;
+    oversize = (space > 0) ? pcb->unsent_oversize : 0;
     if (oversize > 0) {
       LWIP_ASSERT("inconsistent oversize vs. space", oversize <= space);
       seg = last_unsent;
@@ -572,7 +606,8 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
         }
 #if TCP_CHECKSUM_ON_COPY
         /* calculate the checksum of nocopy-data */
-        tcp_seg_add_chksum(~inet_chksum((const u8_t *)arg + pos, seglen), seglen,
+        tcp_seg_add_chksum(((precalc != NULL) && (seglen == len)) ? *precalc :
+                           (u16_t)~inet_chksum((const u8_t *)arg + pos, seglen), seglen,
                            &concat_chksum, &concat_chksum_swapped);
         concat_chksummed += seglen;
 #endif /* TCP_CHECKSUM_ON_COPY */
@@ -630,7 +665,11 @@ tcp_write(struct tcp_pcb *pcb, const void *arg, u16_t len, u8_t apiflags)
       }
 #if TCP_CHECKSUM_ON_COPY
       /* calculate the checksum of nocopy-data */
-      chksum = ~inet_chksum((const u8_t *)arg + pos, seglen);
+      if ((precalc != NULL) && (seglen == len)) {
+        chksum = *precalc;
+      } else {
+        chksum = ~inet_chksum((const u8_t *)arg + pos, seglen);
+      }
       if (seglen & 1) {
         chksum_swapped = 1;
         chksum = SWAP_BYTES_IN_WORD(chksum);
@@ -1260,6 +1299,8 @@ tcp_output(struct tcp_pcb *pcb)
     return ERR_OK;
   }
 
+  PERF_START;
+
   wnd = LWIP_MIN(pcb->snd_wnd, pcb->cwnd);
 
   seg = pcb->unsent;
@@ -1275,7 +1316,9 @@ tcp_output(struct tcp_pcb *pcb)
     /* If the TF_ACK_NOW flag is set and the ->unsent queue is empty, construct
      * an empty ACK segment and send it. */
     if (pcb->flags & TF_ACK_NOW) {
-      return tcp_send_empty_ack(pcb);
+      err = tcp_send_empty_ack(pcb);
+      PERF_STOP("tcp_output");
+      return err;
     }
     /* nothing to send: shortcut out of here */
     goto output_done;
@@ -1290,6 +1333,7 @@ tcp_output(struct tcp_pcb *pcb)
 
   netif = tcp_route(pcb, &pcb->local_ip, &pcb->remote_ip);
   if (netif == NULL) {
+    PERF_STOP("tcp_output");
     return ERR_RTE;
   }
 
@@ -1297,6 +1341,7 @@ tcp_output(struct tcp_pcb *pcb)
   if (ip_addr_isany(&pcb->local_ip)) {
     const ip_addr_t *local_ip = ip_netif_get_local_ip(netif, &pcb->remote_ip);
     if (local_ip == NULL) {
+      PERF_STOP("tcp_output");
       return ERR_RTE;
     }
     ip_addr_copy(pcb->local_ip, *local_ip);
@@ -1317,7 +1362,9 @@ tcp_output(struct tcp_pcb *pcb)
     }
     /* We need an ACK, but can't send data now, so send an empty ACK */
     if (pcb->flags & TF_ACK_NOW) {
-      return tcp_send_empty_ack(pcb);
+      err = tcp_send_empty_ack(pcb);
+      PERF_STOP("tcp_output");
+      return err;
     }
     goto output_done;
   }
@@ -1362,6 +1409,7 @@ tcp_output(struct tcp_pcb *pcb)
     if (err != ERR_OK) {
       /* segment could not be sent, for whatever reason */
       tcp_set_flags(pcb, TF_NAGLEMEMERR);
+      PERF_STOP("tcp_output");
       return err;
     }
 #if TCP_OVERSIZE_DBGCHECK
@@ -1417,6 +1465,7 @@ tcp_output(struct tcp_pcb *pcb)
 
 output_done:
   tcp_clear_flags(pcb, TF_NAGLEMEMERR);
+  PERF_STOP("tcp_output");
   return ERR_OK;
 }
 
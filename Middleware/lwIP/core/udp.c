@@ -65,6 +65,10 @@
 
 #include <string.h>
 
+#ifdef LWIP_HOOK_FILENAME
+#include LWIP_HOOK_FILENAME
+#endif
+
 #ifndef UDP_LOCAL_PORT_RANGE_START
 /* From http://www.iana.org/assignments/port-numbers:
    "The Dynamic and/or Private Ports are those from 49152 through 65535" */
@@ -209,6 +213,8 @@ udp_input(struct pbuf *p, struct netif *inp)
 
   PERF_START;
 
+  LWIP_PBUF_TRACE(p, PBUF_TRACE_TRANSPORT);
+
   UDP_STATS_INC(udp.recv);
 
   /* Check minimum length (UDP header) */
@@ -401,6 +407,7 @@ udp_input(struct pbuf *p, struct netif *inp)
       /* callback */
       if (pcb->recv != NULL) {
         /* now the recv function is responsible for freeing p */
+        LWIP_PBUF_TRACE(p, PBUF_TRACE_APP);
         pcb->recv(pcb->recv_arg, pcb, p, ip_current_src_addr(), src);
       } else {
         /* no recv function registered? then we have to free the pbuf! */
@@ -54,6 +54,14 @@ struct fsdata_chksum {
 #define FS_FILE_FLAGS_HEADER_PERSISTENT   0x02
 #define FS_FILE_FLAGS_HEADER_HTTPVER_1_1  0x04
 #define FS_FILE_FLAGS_SSI                 0x08
+/** A gzip-encoded variant of the file exists under its name + ".gz"
+ * (makefsdata -gz) */
+#define FS_FILE_FLAGS_HAS_GZIP            0x10
+
+/** File name hash (32 bit FNV-1a) of the fs_hash_table[] generated by
+ * makefsdata: the seed is chosen so that no two names share a slot */
+#define FS_HASH_INIT(seed)  ((u32_t)(2166136261UL ^ (u32_t)(seed)))
+#define FS_HASH_STEP(h, c)  ((u32_t)(((h) ^ (u8_t)(c)) * 16777619UL))
 
 /** Define FS_FILE_EXTENSION_T_DEFINED if you have typedef'ed to your private
  * pointer type (defaults to 'void' so the default usage is 'void*')
@@ -121,6 +121,103 @@ extern void httpd_cgi_handler(struct fs_file *file, const char* uri, int iNumPar
 
 #endif /* LWIP_HTTPD_CGI || LWIP_HTTPD_CGI_SSI */
 
+#if LWIP_HTTPD_DYNAMIC_HANDLERS
+
+/**
+ * @ingroup httpd
+ * Function pointer for a dynamic response handler.
+ *
+ * Called when the URI registered with http_set_dyn_handlers is requested and
+ * then again whenever the TCP send buffer has room, until the body is
+ * complete. The handler writes the next part of the body to buf, at most
+ * *len bytes, and sets *len to the number of bytes written. *state is 0 on
+ * the first call for a request and is kept between the calls, e.g. the index
+ * of the next record to write.
+ *
+ * A part that does not fit can be left for the next call, return
+ * ERR_INPROGRESS with *len 0 to wait for more room in the send buffer (or
+ * for data to become available: the handler is also called from the poll
+ * timer).
+ *
+ * @return ERR_OK: the body is complete
+ *         ERR_INPROGRESS: call again for the rest of the body
+ *         another err_t: abort the connection
+ */
+typedef err_t (*tDynHandler)(int iIndex, char *buf, u16_t *len, u32_t *state);
+
+/**
+ * @ingroup httpd
+ * Structure defining the URL of a dynamic response, its content type and the
+ * handler writing it.
+ */
+typedef struct
+{
+    const char *pcURI;
+    const char *pcContentType;
+    tDynHandler pfnDynHandler;
+} tDyn;
+
+void http_set_dyn_handlers(const tDyn *pDyns, int iNumHandlers);
+
+#endif /* LWIP_HTTPD_DYNAMIC_HANDLERS */
+
+#if LWIP_HTTPD_WEBSOCKET
+
+/** WebSocket opcodes (RFC 6455) */
+#define HTTPD_WS_CONTINUATION   0x0
+#define HTTPD_WS_TEXT           0x1
+#define HTTPD_WS_BINARY         0x2
+#define HTTPD_WS_CLOSE          0x8
+#define HTTPD_WS_PING           0x9
+#define HTTPD_WS_PONG           0xA
+/** Flag of tWsRecvHandler: last frame of the message */
+#define HTTPD_WS_FIN            0x80
+
+/** WebSocket close status codes */
+#define HTTPD_WS_CLOSE_NORMAL         1000
+#define HTTPD_WS_CLOSE_GOING_AWAY     1001
+#define HTTPD_WS_CLOSE_PROTOCOL_ERROR 1002
+#define HTTPD_WS_CLOSE_TOO_BIG        1009
+
+/**
+ * @ingroup httpd
+ * Function pointer called when a WebSocket connection has been opened or
+ * closed. connection identifies it for httpd_ws_send() until the close
+ * handler has been called.
+ */
+typedef void (*tWsConnHandler)(void *connection, int iIndex);
+
+/**
+ * @ingroup httpd
+ * Function pointer for the WebSocket data frame handler.
+ *
+ * Called for every text, binary or continuation frame received. The first
+ * len bytes of p are the unmasked payload, p may be a chain and is only
+ * valid during the call (copy what is needed, e.g. with pbuf_copy_partial).
+ * flags is the opcode, with HTTPD_WS_FIN for the last frame of a message.
+ */
+typedef void (*tWsRecvHandler)(void *connection, int iIndex, u8_t flags, struct pbuf *p, u16_t len);
+
+/**
+ * @ingroup httpd
+ * Structure defining a WebSocket URI and its handlers, each may be NULL.
+ */
+typedef struct
+{
+    const char *pcURI;
+    tWsConnHandler pfnOpen;
+    tWsRecvHandler pfnRecv;
+    tWsConnHandler pfnClose;
+} tWs;
+
+void http_set_ws_handlers(const tWs *pWs, int iNumHandlers);
+
+err_t httpd_ws_send(void *connection, u8_t opcode, const void *data, u16_t len);
+int httpd_ws_broadcast(int iIndex, u8_t opcode, const void *data, u16_t len);
+err_t httpd_ws_close(void *connection, u16_t code);
+
+#endif /* LWIP_HTTPD_WEBSOCKET */
+
 #if LWIP_HTTPD_SSI
 
 /**
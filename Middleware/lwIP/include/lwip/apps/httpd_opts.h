@@ -80,6 +80,72 @@
 #define LWIP_HTTPD_CGI_SSI        0
 #endif
 
+/** Set this to 1 to support dynamic response handlers.
+ *
+ * URLs registered with @ref http_set_dyn_handlers are answered by a handler
+ * function (@ref tDynHandler) that writes the body part by part, as much as
+ * the TCP send buffer takes each time, and is called again from the sent
+ * callback. HTTP/1.1 responses use chunked transfer encoding, so the length
+ * need not be known in advance and the connection can be kept alive.
+ *
+ * Use this to serve generated content like JSON telemetry without building
+ * it in a buffer first (as SSI does with its tag insert buffer).
+ */
+#if !defined LWIP_HTTPD_DYNAMIC_HANDLERS || defined __DOXYGEN__
+#define LWIP_HTTPD_DYNAMIC_HANDLERS 0
+#endif
+
+/** Size of the static buffer the dynamic handlers write to, shared by all
+ * connections: it holds one TCP write (response header, chunk header, body
+ * part and chunk trailer) and is copied by tcp_write() right away.
+ */
+#if !defined LWIP_HTTPD_DYN_BUF_SIZE || defined __DOXYGEN__
+#define LWIP_HTTPD_DYN_BUF_SIZE   TCP_MSS
+#endif
+
+/** Set this to 1 to support WebSocket connections (RFC 6455).
+ *
+ * A GET with "Upgrade: websocket" for a URI registered with
+ * @ref http_set_ws_handlers is answered with "101 Switching Protocols" and
+ * the connection then carries frames: received ones are unmasked in place in
+ * their pbufs and passed to the handler, @ref httpd_ws_send and
+ * @ref httpd_ws_broadcast push frames from the main loop. The server answers
+ * pings and pings an idle client itself.
+ * Requires LWIP_HTTPD_INCREMENTAL_PARSER.
+ */
+#if !defined LWIP_HTTPD_WEBSOCKET || defined __DOXYGEN__
+#define LWIP_HTTPD_WEBSOCKET      0
+#endif
+
+/** Largest payload of a received WebSocket frame. A frame is only passed to
+ * the handler when it has been received completely and its data is only
+ * acknowledged to TCP (tcp_recved) then, so this must fit into TCP_WND.
+ * Larger frames close the connection with status 1009.
+ */
+#if !defined LWIP_HTTPD_WS_MAX_FRAME || defined __DOXYGEN__
+#define LWIP_HTTPD_WS_MAX_FRAME   1024
+#endif
+
+/** Bytes of WebSocket frames a connection queues when the TCP send buffer
+ * is full, sent from the sent and poll callbacks. httpd_ws_send() returns
+ * ERR_MEM when a frame does not fit.
+ */
+#if !defined LWIP_HTTPD_WS_SNDQUEUE_LEN || defined __DOXYGEN__
+#define LWIP_HTTPD_WS_SNDQUEUE_LEN (2 * TCP_MSS)
+#endif
+
+/** Polls (HTTPD_POLL_INTERVAL) without anything from the client before the
+ * server sends a ping, and more polls without an answer before it closes the
+ * connection. Acknowledged data counts as an answer, so a client receiving a
+ * steady stream of frames is not pinged.
+ */
+#if !defined LWIP_HTTPD_WS_PING_POLLS || defined __DOXYGEN__
+#define LWIP_HTTPD_WS_PING_POLLS  5
+#endif
+#if !defined LWIP_HTTPD_WS_PONG_POLLS || defined __DOXYGEN__
+#define LWIP_HTTPD_WS_PONG_POLLS  3
+#endif
+
 /** Set this to 1 to support SSI (Server-Side-Includes)
  *
  * In contrast to other http servers, this only calls a preregistered callback
@@ -220,6 +286,15 @@
 #define HTTPD_TCP_PRIO                      TCP_PRIO_MIN
 #endif
 
+/** Priority for httpd connections that are kept alive (HTTP/1.1) without a
+ *  request in progress. Set it below HTTPD_TCP_PRIO to let tcp_alloc()
+ *  reclaim the idle connection that has been inactive longest when it runs
+ *  out of pcbs for a new connection (tcp_kill_prio()).
+ */
+#if !defined HTTPD_TCP_PRIO_IDLE || defined __DOXYGEN__
+#define HTTPD_TCP_PRIO_IDLE                 HTTPD_TCP_PRIO
+#endif
+
 /** Set this to 1 to enable timing each file sent */
 #if !defined LWIP_HTTPD_TIMING || defined __DOXYGEN__
 #define LWIP_HTTPD_TIMING                   0
@@ -274,6 +349,25 @@
 #endif
 #endif /* LWIP_HTTPD_SUPPORT_REQUESTLIST */
 
+/** Set this to 1 to answer HTTP/1.1 pipelined requests: requests that arrive
+ * while a response is being sent are queued (up to LWIP_HTTPD_REQ_QUEUELEN
+ * pbufs) and answered in order once the current response is enqueued.
+ * Requires LWIP_HTTPD_SUPPORT_11_KEEPALIVE and LWIP_HTTPD_SUPPORT_REQUESTLIST.
+ */
+#if !defined LWIP_HTTPD_SUPPORT_PIPELINING || defined __DOXYGEN__
+#define LWIP_HTTPD_SUPPORT_PIPELINING       0
+#endif
+
+/** Set this to 1 to parse requests with the incremental parser of
+ * httpd_parser.c: parsing resumes where the previous segment ended and the
+ * request is read in place from the received pbufs, instead of copying a
+ * request spanning pbufs to a buffer and searching it again for every
+ * segment. Requires LWIP_HTTPD_SUPPORT_REQUESTLIST.
+ */
+#if !defined LWIP_HTTPD_INCREMENTAL_PARSER || defined __DOXYGEN__
+#define LWIP_HTTPD_INCREMENTAL_PARSER       0
+#endif
+
 /** This is the size of a static buffer used when URIs end with '/'.
  * In this buffer, the directory requested is concatenated with all the
  * configured default file names.
@@ -283,6 +377,14 @@
 #define LWIP_HTTPD_MAX_REQUEST_URI_LEN      63
 #endif
 
+/** Set this to 1 to send the gzip variant of a file (generated by makefsdata
+ * -gz as "<name>.gz", see FS_FILE_FLAGS_HAS_GZIP) instead of the file itself
+ * to clients that send "Accept-Encoding: gzip".
+ */
+#if !defined LWIP_HTTPD_GZIP_VARIANTS || defined __DOXYGEN__
+#define LWIP_HTTPD_GZIP_VARIANTS            0
+#endif
+
 /** Maximum length of the filename to send as response to a POST request,
  * filled in by the application when a POST is finished.
  */
@@ -367,7 +469,9 @@
 
 /** HTTPD_PRECALCULATED_CHECKSUM==1: include precompiled checksums for
  * predefined (MSS-sized) chunks of the files to prevent having to calculate
- * the checksums at runtime. */
+ * the checksums at runtime. The chunks are sent with tcp_write_precalc(),
+ * which needs LWIP_CHECKSUM_ON_COPY (and LWIP_ALTCP==0), and fsdata.c has to
+ * be generated with makefsdata -c. */
 #if !defined HTTPD_PRECALCULATED_CHECKSUM || defined __DOXYGEN__
 #define HTTPD_PRECALCULATED_CHECKSUM  0
 #endif
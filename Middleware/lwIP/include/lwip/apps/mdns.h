@@ -60,7 +60,8 @@ enum mdns_sd_proto {
 struct mdns_host;
 struct mdns_service;
 
-/** Callback function to add text to a reply, called when generating the reply */
+/** Callback function to add text to a reply, called when generating the reply.
+ * Replies are kept, call mdns_resp_announce() when the text changes. */
 typedef void (*service_get_txt_fn_t)(struct mdns_service *service, void *txt_userdata);
 
 /** Callback function to let application know the result of probing network for name
@@ -59,6 +59,15 @@
 #define MDNS_MAX_SERVICES               1
 #endif
 
+/** The number of replies kept encoded per netif. A query for the same records
+ * is answered with a copy of the reply instead of building it again, the
+ * replies are dropped when the host, its services or its IPv4 address change
+ * and by mdns_resp_announce(). 0 builds every reply.
+ */
+#ifndef MDNS_REPLY_CACHE_SIZE
+#define MDNS_REPLY_CACHE_SIZE           4
+#endif
+
 /** MDNS_RESP_USENETIF_EXTCALLBACK==1: register an ext_callback on the netif
  * to automatically restart probing/announcing on status or address change.
  */
@@ -198,6 +198,10 @@ err_t mqtt_sub_unsub(mqtt_client_t *client, const char *topic, u8_t qos, mqtt_re
 err_t mqtt_publish(mqtt_client_t *client, const char *topic, const void *payload, u16_t payload_length, u8_t qos, u8_t retain,
                                     mqtt_request_cb_t cb, void *arg);
 
+struct pbuf;
+err_t mqtt_publish_pbuf(mqtt_client_t *client, const char *topic, struct pbuf *payload, u8_t qos, u8_t retain,
+                        mqtt_request_cb_t cb, void *arg);
+
 #ifdef __cplusplus
 }
 #endif
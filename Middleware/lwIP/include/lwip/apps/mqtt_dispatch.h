@@ -0,0 +1,91 @@
+/**
+ * @file mqtt_dispatch.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief MQTT subscription registry, incoming PUBLISH messages dispatched to
+ *        the handlers of the topic filters they match.
+ *
+ * The filters are kept in a trie of topic levels. The children of a level
+ * are found by a hash of their label and of their parent, the '+' child and
+ * the '#' handlers of a level are reached directly, so matching a topic
+ * takes one lookup per level and per '+' path, whatever the number of
+ * subscriptions. Nodes and subscriptions are allocated with mem_malloc().
+ *
+ * The registry takes the place of the callbacks of the client:
+ *
+ *   mqtt_dispatch_init(&reg);
+ *   mqtt_dispatch_add(&reg, "dev/+/cmd", cmd_publish, cmd_data, NULL, NULL);
+ *   mqtt_set_inpub_callback(client, mqtt_dispatch_incoming_publish,
+ *                           mqtt_dispatch_incoming_data, &reg);
+ *
+ * Subscribing to the filters at the broker (mqtt_subscribe()) is left to
+ * the application, several handlers may share one broker subscription.
+ */
+
+#ifndef LWIP_HDR_APPS_MQTT_DISPATCH_H
+#define LWIP_HDR_APPS_MQTT_DISPATCH_H
+
+#include "lwip/apps/mqtt.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct mqtt_dispatch_node;
+
+/** Handler of a topic filter */
+struct mqtt_dispatch_sub {
+  struct mqtt_dispatch_sub *next;
+  struct mqtt_dispatch_node *node;
+  mqtt_incoming_publish_cb_t pub_cb;
+  mqtt_incoming_data_cb_t data_cb;
+  void *arg;
+  /** Filter ends with '#' below node */
+  u8_t multi;
+};
+
+/** Topic level of the filters, label bytes follow */
+struct mqtt_dispatch_node {
+  struct mqtt_dispatch_node *parent;
+  /** Next in hash bucket */
+  struct mqtt_dispatch_node *next;
+  /** Child for '+', not hashed */
+  struct mqtt_dispatch_node *plus;
+  /** Filters ending at this level */
+  struct mqtt_dispatch_sub *subs;
+  /** Filters ending with '#' at the next level */
+  struct mqtt_dispatch_sub *multi;
+  /** Hash of the label and of the parent */
+  u32_t hash;
+  /** Children, hashed and '+' */
+  u16_t children;
+  u16_t len;
+  char label[1];
+};
+
+/** Subscription registry */
+struct mqtt_dispatch {
+  struct mqtt_dispatch_node root;
+  struct mqtt_dispatch_node *buckets[MQTT_DISPATCH_HASH_SIZE];
+  /** Handler lists matched by the incoming publish */
+  struct mqtt_dispatch_sub *match[MQTT_DISPATCH_MATCH_MAX];
+  u8_t match_num;
+  u8_t dispatching;
+  /** Nodes allocated, the root not counted */
+  u16_t nodes;
+};
+
+void mqtt_dispatch_init(struct mqtt_dispatch *reg);
+err_t mqtt_dispatch_add(struct mqtt_dispatch *reg, const char *filter,
+                        mqtt_incoming_publish_cb_t pub_cb, mqtt_incoming_data_cb_t data_cb,
+                        void *arg, struct mqtt_dispatch_sub **sub);
+void mqtt_dispatch_remove(struct mqtt_dispatch *reg, struct mqtt_dispatch_sub *sub);
+u8_t mqtt_dispatch_match(struct mqtt_dispatch *reg, const char *topic);
+void mqtt_dispatch_incoming_publish(void *arg, const char *topic, u32_t tot_len);
+void mqtt_dispatch_incoming_data(void *arg, const u8_t *data, u16_t len, u8_t flags);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* LWIP_HDR_APPS_MQTT_DISPATCH_H */
@@ -56,6 +56,14 @@ extern "C" {
 #define MQTT_OUTPUT_RINGBUF_SIZE 256
 #endif
 
+/**
+ * Number of payloads of mqtt_publish_pbuf() queued or not yet acknowledged by
+ * TCP. They are sent by reference, not through the output ring-buffer.
+ */
+#ifndef MQTT_OUTPUT_REF_MAX
+#define MQTT_OUTPUT_REF_MAX 8
+#endif
+
 /**
  * Number of bytes in receive buffer, must be at least the size of the longest incoming topic + 8
  * If one wants to avoid fragmented incoming publish, set length to max incoming topic length + max payload length + 8
@@ -66,11 +74,31 @@ extern "C" {
 
 /**
  * Maximum number of pending subscribe, unsubscribe and publish requests to server .
+ * Those waiting for a response (QoS 1 and 2 publish, subscribe, unsubscribe)
+ * are further bounded by the in-flight window, see MQTT_REQ_WINDOW_INIT.
  */
 #ifndef MQTT_REQ_MAX_IN_FLIGHT
 #define MQTT_REQ_MAX_IN_FLIGHT 4
 #endif
 
+/**
+ * Initial number of requests waiting for a server response. The window grows
+ * by one with each response, up to MQTT_REQ_MAX_IN_FLIGHT, and is halved
+ * when requests time out, so a slow server is not flooded.
+ */
+#ifndef MQTT_REQ_WINDOW_INIT
+#define MQTT_REQ_WINDOW_INIT 4
+#endif
+
+/**
+ * Write requests to TCP when queued but send them at the next
+ * sys_check_timeouts(), so that the small messages queued in one main loop
+ * pass share TCP segments. Output from TCP callbacks is sent by TCP on return.
+ */
+#ifndef MQTT_OUTPUT_COALESCE
+#define MQTT_OUTPUT_COALESCE 1
+#endif
+
 /**
  * Seconds between each cyclic timer call.
  */
@@ -92,6 +120,23 @@ extern "C" {
 #define MQTT_CONNECT_TIMOUT 100
 #endif
 
+/**
+ * Hash buckets of the topic levels of mqtt_dispatch, a power of 2. About the
+ * number of distinct levels over all filters keeps the chains short.
+ */
+#ifndef MQTT_DISPATCH_HASH_SIZE
+#define MQTT_DISPATCH_HASH_SIZE 64
+#endif
+
+/**
+ * Topic levels of the filters matched at once through '+', and handler lists
+ * matched by one topic, in mqtt_dispatch. Matches beyond it are not
+ * dispatched.
+ */
+#ifndef MQTT_DISPATCH_MATCH_MAX
+#define MQTT_DISPATCH_MATCH_MAX 8
+#endif
+
 /**
  * @}
  */
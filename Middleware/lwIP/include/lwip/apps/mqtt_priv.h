@@ -66,6 +66,17 @@ struct mqtt_ringbuf_t {
   u8_t buf[MQTT_OUTPUT_RINGBUF_SIZE];
 };
 
+/** Payload sent by reference, after the ring-buffer bytes before mark */
+struct mqtt_out_ref {
+  struct pbuf *p;
+  /** Ring-buffer put index when queued */
+  u16_t mark;
+  /** Bytes of p written to TCP */
+  u16_t off;
+  /** Output stream position of its end, once written */
+  u32_t end;
+};
+
 /** MQTT client */
 struct mqtt_client_s
 {
@@ -86,6 +97,9 @@ struct mqtt_client_s
   /** Pending requests to server */
   struct mqtt_request_t *pend_req_queue;
   struct mqtt_request_t req_list[MQTT_REQ_MAX_IN_FLIGHT];
+  /** Pending requests waiting for a server response, and their bound */
+  u8_t req_acks;
+  u8_t req_window;
   void *inpub_arg;
   /** Incoming data callback */
   mqtt_incoming_data_cb_t data_cb;
@@ -95,6 +109,17 @@ struct mqtt_client_s
   u8_t rx_buffer[MQTT_VAR_HEADER_BUFFER_LEN];
   /** Output ring-buffer */
   struct mqtt_ringbuf_t output;
+  /** Payloads by reference from ref_head on, the first ref_written of the
+      ref_num are written and wait for their acknowledgement */
+  struct mqtt_out_ref refs[MQTT_OUTPUT_REF_MAX];
+  u8_t ref_head;
+  u8_t ref_num;
+  u8_t ref_written;
+  /** Output written to TCP waits for the flush timeout */
+  u8_t output_flush;
+  /** Output stream bytes written to TCP and acknowledged */
+  u32_t out_written;
+  u32_t out_acked;
 };
 
 #ifdef __cplusplus
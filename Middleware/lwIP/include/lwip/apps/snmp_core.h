@@ -294,6 +294,43 @@ void snmp_next_oid_init(struct snmp_next_oid_state *state,
 u8_t snmp_next_oid_precheck(struct snmp_next_oid_state *state, const u32_t *oid, u8_t oid_len);
 u8_t snmp_next_oid_check(struct snmp_next_oid_state *state, const u32_t *oid, u8_t oid_len, void* reference);
 
+#if SNMP_ROW_INDEX
+/** row of a table index */
+struct snmp_row_index_entry
+{
+  u32_t oid[SNMP_ROW_INDEX_OID_LEN];
+  u8_t oid_len;
+  void* reference;
+  /** rows in OID order: entry i holds the position of the i-th smallest row */
+  u16_t order;
+};
+
+/** rows of a table and their OID order, valid for the request it was built in */
+struct snmp_row_index
+{
+  struct snmp_row_index_entry* rows;
+  u16_t size;
+  u16_t count;
+  /** rows the order was sorted for */
+  u16_t sorted_count;
+  /** request the rows were collected for, 0: never built */
+  u16_t epoch;
+  /** a row did not fit, walk the table by scanning */
+  u8_t overflow;
+  /** a row differs from the previous build, sort again */
+  u8_t changed;
+};
+
+#define SNMP_ROW_INDEX_CREATE(rows) { (rows), (u16_t)LWIP_ARRAYSIZE(rows), 0, 0, 0, 0, 0 }
+
+void snmp_row_index_expire(void);
+u8_t snmp_row_index_current(const struct snmp_row_index *index);
+void snmp_row_index_begin(struct snmp_row_index *index);
+void snmp_row_index_add(struct snmp_row_index *index, const u32_t *oid, u8_t oid_len, void* reference);
+void snmp_row_index_end(struct snmp_row_index *index);
+const struct snmp_row_index_entry* snmp_row_index_next(const struct snmp_row_index *index, const u32_t *oid, u8_t oid_len);
+#endif /* SNMP_ROW_INDEX */
+
 void snmp_oid_assign(struct snmp_obj_id* target, const u32_t *oid, u8_t oid_len);
 void snmp_oid_combine(struct snmp_obj_id* target, const u32_t *oid1, u8_t oid1_len, const u32_t *oid2, u8_t oid2_len);
 void snmp_oid_prefix(struct snmp_obj_id* target, const u32_t *oid, u8_t oid_len);
@@ -142,6 +142,33 @@
 #define SNMP_MAX_VALUE_SIZE             LWIP_MAX(LWIP_MAX((SNMP_MAX_OCTET_STRING_LEN), sizeof(u32_t)*(SNMP_MAX_OBJ_ID_LEN)), SNMP_MIN_VALUE_SIZE)
 #endif
 
+/**
+ * SNMP_ROW_INDEX==1: The tables of the lwIP MIB2 (ifTable, tcpConnTable,
+ * tcpConnectionTable) keep their row OIDs sorted in an index, so that a
+ * get-next is a binary search instead of a scan of all rows. The rows are
+ * collected once per request and sorted again only if they changed.
+ */
+#if !defined SNMP_ROW_INDEX || defined __DOXYGEN__
+#define SNMP_ROW_INDEX                  1
+#endif
+
+/**
+ * SNMP_ROW_INDEX_ROWS: Rows of each table index. A table with more rows is
+ * walked by scanning as without the index.
+ */
+#if !defined SNMP_ROW_INDEX_ROWS || defined __DOXYGEN__
+#define SNMP_ROW_INDEX_ROWS             MEMP_NUM_TCP_PCB
+#endif
+
+/**
+ * SNMP_ROW_INDEX_OID_LEN: Maximum sub-identifiers of a row OID in an index,
+ * 14 for the IPv4 rows of tcpConnectionTable. Rows with a longer OID (IPv6
+ * addresses) make the table walked by scanning.
+ */
+#if !defined SNMP_ROW_INDEX_OID_LEN || defined __DOXYGEN__
+#define SNMP_ROW_INDEX_OID_LEN          14
+#endif
+
 /**
  * The snmp read-access community. Used for write-access and traps, too
  * unless SNMP_COMMUNITY_WRITE or SNMP_COMMUNITY_TRAP are enabled, respectively.
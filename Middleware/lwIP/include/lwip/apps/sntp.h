@@ -62,6 +62,19 @@ const ip_addr_t* sntp_getserver(u8_t idx);
 u8_t sntp_getreachability(u8_t idx);
 #endif /* SNTP_MONITOR_SERVER_REACHABILITY */
 
+#if SNTP_HIGH_PRECISION
+/** Clock filter output of a server, high precision mode, nanoseconds */
+struct sntp_peer_stats {
+  s64_t offset;   /* clock minus server, of the sample of least delay */
+  s64_t delay;    /* round trip of that sample */
+  s64_t jitter;   /* mean offset of the other samples from it */
+  u8_t samples;   /* in the filter */
+  u8_t selected;  /* agreed with the majority, combined into the update */
+  u8_t sys_peer;  /* the best of them, its samples drive the updates */
+};
+u8_t sntp_getpeerstats(u8_t idx, struct sntp_peer_stats *stats);
+#endif /* SNTP_HIGH_PRECISION */
+
 #if SNTP_SERVER_DNS
 void sntp_setservername(u8_t idx, const char *server);
 const char *sntp_getservername(u8_t idx);
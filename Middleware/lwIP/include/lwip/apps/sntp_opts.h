@@ -208,6 +208,60 @@
 #define SNTP_MONITOR_SERVER_REACHABILITY 1
 #endif
 
+/** SNTP_HIGH_PRECISION==1: Discipline a nanosecond clock instead of setting
+ * the time. Every server is polled each SNTP_POLL_INTERVAL, the samples of a
+ * server go through a clock filter (the one of least delay out of the last
+ * SNTP_FILTER_SIZE, RFC 5905 10), the servers whose offsets do not agree
+ * with the majority are dropped (RFC 5905 11.2.1) and the offsets of the
+ * others are combined and passed to SNTP_UPDATE_CLOCK().
+ * Time stamps are taken with SNTP_GET_TIME_NS(), the clock in nanoseconds
+ * since 1970 (SNTP_GET_SYSTEM_TIME converted if not defined), unless
+ * SNTP_PBUF_TIME_NS() finds one taken by the hardware.
+ * Requires 64-bit arithmetic and SNTP_OPMODE_POLL.
+ */
+#if !defined SNTP_HIGH_PRECISION || defined __DOXYGEN__
+#define SNTP_HIGH_PRECISION         0
+#endif
+
+/** Time between two polls of the servers (in milliseconds), high precision
+ * mode. 16 s is the minimum poll interval of NTP (RFC 5905 7.3).
+ */
+#if !defined SNTP_POLL_INTERVAL || defined __DOXYGEN__
+#define SNTP_POLL_INTERVAL          16000
+#endif
+
+/** Number of samples kept per server for the clock filter, high precision
+ * mode.
+ */
+#if !defined SNTP_FILTER_SIZE || defined __DOXYGEN__
+#define SNTP_FILTER_SIZE            8
+#endif
+
+/** SNTP macro to take the time stamp the hardware put on a request after it
+ * was sent or on a response when it was received: sets t (s64_t, ns) and
+ * evaluates to 1 if there is one, 0 to fall back to SNTP_GET_TIME_NS().
+ */
+#if !defined SNTP_PBUF_TIME_NS || defined __DOXYGEN__
+#define SNTP_PBUF_TIME_NS(p, t)     0
+#endif
+
+/** SNTP macro to ask the hardware for the transmit time stamp of a request,
+ * the pbuf is kept until the response is processed.
+ */
+#if !defined SNTP_TX_TIMESTAMP_REQ || defined __DOXYGEN__
+#define SNTP_TX_TIMESTAMP_REQ(p)
+#endif
+
+/** SNTP macro to correct the clock, high precision mode: offset is the
+ * clock minus the servers (ns), delay the round-trip delay the offset was
+ * measured with and local the clock at that time. Evaluates to 1 if the
+ * clock was stepped rather than slewed, the samples taken before are
+ * dropped then.
+ */
+#if !defined SNTP_UPDATE_CLOCK || defined __DOXYGEN__
+#define SNTP_UPDATE_CLOCK(offset, delay, local) 0
+#endif
+
 /**
  * @}
  */
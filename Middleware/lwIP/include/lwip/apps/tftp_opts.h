@@ -99,6 +99,25 @@
 #define TFTP_MAX_MODE_LEN     7
 #endif
 
+/**
+ * Largest block size granted to a client asking for one (RFC 2348), the
+ * data of a block fills a 1500 byte IPv4 MTU. Without the option a client
+ * gets 512 byte blocks.
+ */
+#if !defined TFTP_MAX_BLKSIZE || defined __DOXYGEN__
+#define TFTP_MAX_BLKSIZE      1468
+#endif
+
+/**
+ * Largest number of blocks granted to a client asking to send or receive
+ * several blocks per ACK (RFC 7440). A file read keeps this many blocks of
+ * TFTP_MAX_BLKSIZE in the heap for retransmission. Without the option the
+ * transfer goes block by block.
+ */
+#if !defined TFTP_MAX_WINDOWSIZE || defined __DOXYGEN__
+#define TFTP_MAX_WINDOWSIZE   4
+#endif
+
 /**
  * @}
  */
@@ -80,13 +80,23 @@ struct tftp_context {
    * @param pbuf PBUF adjusted such that payload pointer points
    *             to the beginning of write data. In other words,
    *             TFTP headers are stripped off.
-   * @returns &gt;= 0: Success; &lt; 0: Error
+   *             NULL after the last block: the file is complete.
+   * @returns &gt;= 0: Success; &lt; 0: Error;
+   *          TFTP_WRITE_WAIT: Success, but no ACK is sent until
+   *          tftp_write_resume() or a later write() returning another
+   *          value (e.g. to let the data drain to flash before the
+   *          client sends the next window)
    */
   int (*write)(void* handle, struct pbuf* p);
 };
 
+/** @ingroup tftp
+ * write() has taken the data, the client waits for tftp_write_resume() */
+#define TFTP_WRITE_WAIT 1
+
 err_t tftp_init(const struct tftp_context* ctx);
 void tftp_cleanup(void);
+void tftp_write_resume(int result);
 
 #ifdef __cplusplus
 }
@@ -86,6 +86,9 @@ struct dhcp
   u16_t t2_rebind_time; /* #ticks with period DHCP_COARSE_TIMER_SECS until next rebind try */
   u16_t lease_used; /* #ticks with period DHCP_COARSE_TIMER_SECS since last received DHCP ack */
   u16_t t0_timeout; /* #ticks with period DHCP_COARSE_TIMER_SECS for lease time */
+#if LWIP_DHCP_LEASE_STORE
+  u8_t probe_timeout; /* #ticks with period DHCP_FINE_TIMER_MSECS the stored address is still probed */
+#endif /* LWIP_DHCP_LEASE_STORE */
   ip_addr_t server_ip_addr; /* dhcp server address that offered this lease (ip_addr_t because passed to UDP) */
   ip4_addr_t offered_ip_addr;
   ip4_addr_t offered_sn_mask;
@@ -128,6 +131,26 @@ void dhcp_fine_tmr(void);
 extern void dhcp_set_ntp_servers(u8_t num_ntp_servers, const ip4_addr_t* ntp_server_addrs);
 #endif /* LWIP_DHCP_GET_NTP_SRV */
 
+#if LWIP_DHCP_LEASE_STORE
+/** A lease kept across restarts, see LWIP_DHCP_LEASE_STORE */
+struct dhcp_lease
+{
+  ip4_addr_t addr;
+  ip4_addr_t netmask;
+  ip4_addr_t gw;
+  ip4_addr_t server;
+  u32_t lease_time; /* seconds, as last acknowledged */
+};
+
+/** These functions must exist with LWIP_DHCP_LEASE_STORE.
+ * dhcp_lease_load() returns 1 and fills in lease if one is stored for netif,
+ * dhcp_lease_store() is called with each lease bound, or NULL when it must
+ * not be used any more (NAK, conflict, release). Both are called from the
+ * DHCP timers and input, a store must not wait for the storage. */
+extern u8_t dhcp_lease_load(struct netif *netif, struct dhcp_lease *lease);
+extern void dhcp_lease_store(struct netif *netif, const struct dhcp_lease *lease);
+#endif /* LWIP_DHCP_LEASE_STORE */
+
 #define netif_dhcp_data(netif) ((struct dhcp*)netif_get_client_data(netif, LWIP_NETIF_CLIENT_DATA_INDEX_DHCP))
 
 #ifdef __cplusplus
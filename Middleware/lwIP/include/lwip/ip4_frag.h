@@ -55,14 +55,22 @@ extern "C" {
 /* The IP reassembly timer interval in milliseconds. */
 #define IP_TMR_INTERVAL 1000
 
+struct ip_reass_src;
+
 /** IP reassembly helper struct.
  * This is exported because memp needs to know the size.
  */
 struct ip_reassdata {
+  /** next datagram in the same hash bucket */
   struct ip_reassdata *next;
+  /** runs of contiguous fragments, by offset */
   struct pbuf *p;
+  /** pbufs queued from the source address */
+  struct ip_reass_src *src;
   struct ip_hdr iphdr;
   u16_t datagram_len;
+  /** pbufs queued for this datagram */
+  u16_t clen;
   u8_t flags;
   u8_t timer;
 };
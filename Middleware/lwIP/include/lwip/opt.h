@@ -794,6 +794,25 @@
 #define IP_REASS_MAX_PBUFS              10
 #endif
 
+/**
+ * IP_REASS_MAX_PBUFS_PER_SRC: Maximum amount of pbufs waiting to be reassembled
+ * from one source address. Above it, the oldest datagrams of that source are
+ * discarded first, so a single sender cannot hold all of IP_REASS_MAX_PBUFS with
+ * datagrams it never completes.
+ */
+#if !defined IP_REASS_MAX_PBUFS_PER_SRC || defined __DOXYGEN__
+#define IP_REASS_MAX_PBUFS_PER_SRC      IP_REASS_MAX_PBUFS
+#endif
+
+/**
+ * IP_REASS_HASH_SIZE: Buckets of the index of the datagrams being reassembled,
+ * a power of 2. A fragment is compared with the datagrams of one bucket
+ * instead of all of them.
+ */
+#if !defined IP_REASS_HASH_SIZE || defined __DOXYGEN__
+#define IP_REASS_HASH_SIZE              8
+#endif
+
 /**
  * IP_DEFAULT_TTL: Default value for Time-To-Live used by transport layers.
  */
@@ -961,6 +980,30 @@
 #if !defined LWIP_DHCP_MAX_DNS_SERVERS || defined __DOXYGEN__
 #define LWIP_DHCP_MAX_DNS_SERVERS       DNS_MAX_SERVERS
 #endif
+
+/**
+ * LWIP_DHCP_LEASE_STORE==1: Keep the last lease in non-volatile storage and
+ * request it again at once on dhcp_start() (INIT-REBOOT) instead of
+ * discovering a server. The storage is provided by the port:
+ * u8_t dhcp_lease_load(struct netif *netif, struct dhcp_lease *lease);
+ * void dhcp_lease_store(struct netif *netif, const struct dhcp_lease *lease);
+ * With DHCP_DOES_ARP_CHECK, the stored address is probed by ARP while it is
+ * requested, see DHCP_REBOOT_PROBES.
+ */
+#if !defined LWIP_DHCP_LEASE_STORE || defined __DOXYGEN__
+#define LWIP_DHCP_LEASE_STORE           0
+#endif
+
+/**
+ * DHCP_REBOOT_PROBES: ARP probes of the address of a stored lease, one
+ * sent along with the INIT-REBOOT request and the others every
+ * DHCP_FINE_TIMER_MSECS. The lease is bound as soon as it is acknowledged,
+ * a host answering for the address until one more period has passed still
+ * has it declined.
+ */
+#if !defined DHCP_REBOOT_PROBES || defined __DOXYGEN__
+#define DHCP_REBOOT_PROBES              2
+#endif
 /**
  * @}
  */
@@ -1159,6 +1202,36 @@
 #if !defined LWIP_DNS_SUPPORT_MDNS_QUERIES || defined __DOXYGEN__
 #define LWIP_DNS_SUPPORT_MDNS_QUERIES   0
 #endif
+
+/** DNS_TABLE_HASH_SIZE: Buckets of the index of the names of the DNS table,
+ * a power of 2. A lookup compares the names of one bucket instead of
+ * scanning the whole table. */
+#if !defined DNS_TABLE_HASH_SIZE || defined __DOXYGEN__
+#define DNS_TABLE_HASH_SIZE             8
+#endif
+
+/** DNS_PREFETCH_PERCENT: A name looked up since it was resolved is queried
+ * again from dns_tmr() once this percentage of its TTL has elapsed, and
+ * answered from the table meanwhile, so that callers do not wait for the
+ * server when it expires. 0 disables the prefetch. */
+#if !defined DNS_PREFETCH_PERCENT || defined __DOXYGEN__
+#define DNS_PREFETCH_PERCENT            90
+#endif
+
+/** DNS_MAX_NEG_TTL: Names the server reports as non-existent (NXDOMAIN or no
+ * address) are kept for the TTL of the SOA record of the response (RFC 2308),
+ * at most this many seconds. dns_gethostbyname() returns ERR_VAL for them
+ * meanwhile without a query. 0 disables the negative caching. */
+#if !defined DNS_MAX_NEG_TTL || defined __DOXYGEN__
+#define DNS_MAX_NEG_TTL                 300
+#endif
+
+/** DNS_SERVER_RTT==1: Keep the smoothed response time of each DNS server and
+ * send new queries to the fastest one, the others being tried in turn on
+ * timeout. A server that does not answer is ranked last until it does. */
+#if !defined DNS_SERVER_RTT || defined __DOXYGEN__
+#define DNS_SERVER_RTT                  1
+#endif
 /**
  * @}
  */
@@ -1563,6 +1636,25 @@
 #if !defined LWIP_PBUF_CUSTOM_DATA || defined __DOXYGEN__
 #define LWIP_PBUF_CUSTOM_DATA
 #endif
+
+/**
+ * LWIP_PBUF_CUSTOM_DATA_INIT: Initialize private data on pbufs, called
+ * whenever a pbuf is allocated, e.g.:
+ * #define LWIP_PBUF_CUSTOM_DATA_INIT(p) (p)->tai_timestamp[0] = 0
+ */
+#if !defined LWIP_PBUF_CUSTOM_DATA_INIT || defined __DOXYGEN__
+#define LWIP_PBUF_CUSTOM_DATA_INIT(p)
+#endif
+
+/**
+ * LWIP_PBUF_TRACE: Called with a received pbuf when it enters a stack layer,
+ * stage is one of the PBUF_TRACE_* values from pbuf.h. Used together with
+ * LWIP_PBUF_CUSTOM_DATA to measure per-layer latency, e.g.:
+ * #define LWIP_PBUF_TRACE(p, stage) my_trace(p, stage)
+ */
+#if !defined LWIP_PBUF_TRACE || defined __DOXYGEN__
+#define LWIP_PBUF_TRACE(p, stage)
+#endif
 /**
  * @}
  */
@@ -72,6 +72,12 @@ extern "C" {
 #define PBUF_NEEDS_COPY(p)  ((p)->type_internal & PBUF_TYPE_FLAG_DATA_VOLATILE)
 #endif /* PBUF_NEEDS_COPY */
 
+/** Stages reported through LWIP_PBUF_TRACE() for received packets */
+#define PBUF_TRACE_LINK      1 /* ethernet_input() */
+#define PBUF_TRACE_IP        2 /* ip4_input() */
+#define PBUF_TRACE_TRANSPORT 3 /* udp_input(), tcp_input() */
+#define PBUF_TRACE_APP       4 /* before the application recv callback */
+
 /* @todo: We need a mechanism to prevent wasting memory in every pbuf
    (TCP vs. UDP, IPv4 vs. IPv6: UDP/IPv4 packets may waste up to 28 bytes) */
 
@@ -472,6 +472,10 @@ err_t            tcp_shutdown(struct tcp_pcb *pcb, int shut_rx, int shut_tx);
 
 err_t            tcp_write   (struct tcp_pcb *pcb, const void *dataptr, u16_t len,
                               u8_t apiflags);
+#if LWIP_CHECKSUM_ON_COPY
+err_t            tcp_write_precalc(struct tcp_pcb *pcb, const void *dataptr, u16_t len,
+                                   u8_t apiflags, u16_t chksum);
+#endif /* LWIP_CHECKSUM_ON_COPY */
 
 void             tcp_setprio (struct tcp_pcb *pcb, u8_t prio);
 
@@ -88,6 +88,10 @@ ethernet_input(struct pbuf *p, struct netif *netif)
 
   LWIP_ASSERT_CORE_LOCKED();
 
+  LWIP_PBUF_TRACE(p, PBUF_TRACE_LINK);
+
+  PERF_START;
+
   if (p->len <= SIZEOF_ETH_HDR) {
     /* a packet with only an ethernet header (or less) is not valid for us */
     ETHARP_STATS_INC(etharp.proterr);
@@ -132,6 +136,7 @@ ethernet_input(struct pbuf *p, struct netif *netif)
 #endif
       /* silently ignore this packet: not for our VLAN */
       pbuf_free(p);
+      PERF_STOP("ethernet_input");
       return ERR_OK;
     }
 #endif /* defined(LWIP_HOOK_VLAN_CHECK) || defined(ETHARP_VLAN_CHECK) || defined(ETHARP_VLAN_CHECK_FN) */
@@ -182,8 +187,11 @@ ethernet_input(struct pbuf *p, struct netif *netif)
         LWIP_DEBUGF(ETHARP_DEBUG | LWIP_DBG_TRACE, ("Can't move over header in packet"));
         goto free_and_return;
       } else {
-        /* pass to IP layer */
+        /* pass to IP layer, ip4_input() has too many exits to measure
+           inside */
+        PERF_START;
         ip4_input(p, netif);
+        PERF_STOP("ip4_input");
       }
       break;
 
@@ -245,10 +253,12 @@ ethernet_input(struct pbuf *p, struct netif *netif)
 
   /* This means the pbuf is freed or consumed,
      so the caller doesn't have to free it again */
+  PERF_STOP("ethernet_input");
   return ERR_OK;
 
 free_and_return:
   pbuf_free(p);
+  PERF_STOP("ethernet_input");
   return ERR_OK;
 }
 
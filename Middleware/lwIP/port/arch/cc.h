@@ -36,6 +36,7 @@
 #include "stdio.h"
 
 #define LWIP_NO_STDINT_H 1
+#define LWIP_HAVE_INT64  1
 
 /*-------------data type------------------------------------------------------*/
 
@@ -45,6 +46,8 @@ typedef unsigned short u16_t; /* Unsigned 16 bit quantity        */
 typedef signed short s16_t;   /* Signed   16 bit quantity        */
 typedef unsigned long u32_t;  /* Unsigned 32 bit quantity        */
 typedef signed long s32_t;    /* Signed   32 bit quantity        */
+typedef unsigned long long u64_t; /* Unsigned 64 bit quantity     */
+typedef signed long long s64_t;   /* Signed   64 bit quantity     */
 typedef u32_t mem_ptr_t;      /* Unsigned 32 bit quantity        */
 typedef u32_t sys_prot_t;
 
@@ -108,7 +111,11 @@ typedef u32_t sys_prot_t;
 #endif
 
 
+/* Seeded from the TRNG by sys_rand_init() (sys_arch.c) before lwip_init() */
+void sys_rand_init(void);
+u32_t sys_rand(void);
+#define LWIP_RAND() sys_rand()
+
 #define LWIP_PROVIDE_ERRNO 1
 
-#define TCP_MSS 1000
 #endif /* __CC_H__ */
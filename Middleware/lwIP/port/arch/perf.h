@@ -32,7 +32,43 @@
 #ifndef __PERF_H__
 #define __PERF_H__
 
+#include "NuMicro.h"
+#include "perf_stats.h"
+
+/* Cortex-M4 DWT cycle counter, started by perf_init() */
+#define PERF_CYCLES() (DWT->CYCCNT)
+
+#if LWIP_PERF
+/* Cycles between PERF_START and PERF_STOP go to perf_stats, the point is
+ * looked up once per call site. The points are shared by the Rx interrupt
+ * and the main loop, perf_stop() updates them with interrupts masked. */
+#define PERF_START uint32_t perf_start_cycles = PERF_CYCLES()
+#define PERF_STOP(x)                                                       \
+    do {                                                                   \
+        static struct perf_point *perf_pt;                                 \
+        perf_stop(&perf_pt, x, PERF_CYCLES() - perf_start_cycles);         \
+    } while (0)
+#else
 #define PERF_START   /* null definition */
 #define PERF_STOP(x) /* null definition */
+#endif
+
+/**
+ * @brief Start the DWT cycle counter.
+ */
+void perf_init(void);
+
+/**
+ * @brief PERF_STOP(), add the cycles of a call site to its point.
+ * @param pt     point of the call site, looked up by name when NULL
+ * @param name   point name
+ * @param cycles since PERF_START
+ */
+void perf_stop(struct perf_point **pt, const char *name, uint32_t cycles);
+
+/**
+ * @brief Print all PERF_STOP() points in us and clear them.
+ */
+void perf_print_stats(void);
 
 #endif /* __PERF_H__ */
@@ -46,6 +46,11 @@
 #include "lwip/etharp.h"
 #include "netif/ppp/pppoe.h"
 
+#if PKT_LATENCY
+#include "arch/perf.h"
+#include "pkt_latency.h"
+#endif
+
 /* Define those to better describe your network interface. */
 #define IFNAME0 'e'
 #define IFNAME1 'n'
@@ -59,6 +64,7 @@
 struct ethernetif {
     struct eth_addr *ethaddr;
     /* Add whatever per-interface state that is needed here. */
+    ethernetif_tx_ts_fn tx_ts_fn;
 };
 
 /* EMAC Tx/Rx descriptor's owner bit */
@@ -108,6 +114,84 @@ typedef struct {
 unsigned char mac_addr[6] = {0x66, 0x66, 0x66, 0x88, 0x88, 0x88};
 extern uint32_t u32CurrentTxDesc, u32NextTxDesc, u32CurrentRxDesc;
 
+/* pbufs waiting for their Tx time stamp, indexed by Tx descriptor */
+static struct pbuf *tx_ts_pbuf[EMAC_TX_DESC_SIZE];
+
+/* Tx time stamps latched by ethernetif_tx_done() in the Tx interrupt and
+ * passed on by ethernetif_poll() in the main loop. The interrupt never
+ * touches the pbuf, lwIP is not protected against it (SYS_LIGHTWEIGHT_PROT).
+ * Single producer (Tx interrupt), single consumer (main loop). */
+#define ETHERNETIF_TX_TS_RING (2 * EMAC_TX_DESC_SIZE)
+
+struct tx_ts_entry {
+    struct pbuf *p;
+    u32_t sec;
+    u32_t nsec;
+    u8_t valid; /* sec/nsec hold the Tx time stamp */
+};
+
+static volatile struct tx_ts_entry tx_ts_ring[ETHERNETIF_TX_TS_RING];
+static volatile u32_t tx_ts_head; /* written by the Tx interrupt only */
+static volatile u32_t tx_ts_tail; /* written by ethernetif_poll() only */
+/* pbufs kept in tx_ts_pbuf[] or tx_ts_ring[], at most ETHERNETIF_TX_TS_RING
+ * so the ring never overflows */
+static u32_t tx_ts_held;
+
+#if PKT_LATENCY
+/* Cycle count at entry of the current Rx interrupt */
+static u32_t rx_isr_cycles;
+#endif
+
+/**
+ * Convert the EMAC time stamp sub-second field to nano seconds.
+ * 2^31 sub-second == 10^9 ns, same as EMAC_Subsec2Nsec() in emac.c.
+ */
+static u32_t ethernetif_subsec2nsec(u32_t subsec)
+{
+    return (u32_t)((1000000000ULL * (u64_t) subsec) >> 31);
+}
+
+/**
+ * Index of a Tx descriptor inside the descriptor ring.
+ */
+static u32_t ethernetif_tx_desc_index(EMAC_DESCRIPTOR_T *desc)
+{
+    return ((u32_t) desc - EMAC->TXDSA) / sizeof(EMAC_DESCRIPTOR_T);
+}
+
+/**
+ * Queue a sent pbuf for ethernetif_poll(). Runs in the Tx interrupt, or with
+ * it masked.
+ */
+static void ethernetif_tx_ts_latch(struct pbuf *p, u32_t sec, u32_t nsec,
+                                   u8_t valid)
+{
+    volatile struct tx_ts_entry *e;
+
+    LWIP_ASSERT("tx_ts_ring full",
+                tx_ts_head - tx_ts_tail < ETHERNETIF_TX_TS_RING);
+    e = &tx_ts_ring[tx_ts_head % ETHERNETIF_TX_TS_RING];
+    e->p = p;
+    e->sec = sec;
+    e->nsec = nsec;
+    e->valid = valid;
+    tx_ts_head++;
+}
+
+/**
+ * Find the pbuf of a chain which requests a Tx time stamp.
+ */
+static struct pbuf *ethernetif_tx_ts_request(struct pbuf *p)
+{
+    struct pbuf *q;
+
+    for (q = p; q != NULL; q = q->next) {
+        if (q->ts_flags & ETHERNETIF_TS_TX_REQ)
+            return q;
+    }
+    return NULL;
+}
+
 static void phy_layer_init(void)
 {
     EMAC_PhyInit();
@@ -170,6 +254,49 @@ static void low_level_init(struct netif *netif)
     phy_layer_init();
 }
 
+/**
+ * Restart the EMAC after a DMA bus error. The DMA engine halts on a bus
+ * error, so the MAC is reset and both descriptor rings are rebuilt. Frames
+ * still in the rings are lost.
+ *
+ * Link mode and the time stamp counter survive the restart.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ */
+static void low_level_restart(struct netif *netif)
+{
+    uint32_t sec = 0, nsec = 0;
+    u32_t ctl, tsctl, addend, i;
+
+    LWIP_UNUSED_ARG(netif);
+
+    ctl = EMAC->CTL & (EMAC_CTL_OPMODE_Msk | EMAC_CTL_FUDUP_Msk);
+    tsctl = EMAC->TSCTL;
+    addend = EMAC->TSADDEND;
+    if (tsctl & EMAC_TSCTL_TSEN_Msk)
+        EMAC_GetTime(&sec, &nsec);
+
+    EMAC_Close();
+
+    /* Frames lost with the ring go to ethernetif_poll() without a stamp */
+    for (i = 0; i < EMAC_TX_DESC_SIZE; i++) {
+        if (tx_ts_pbuf[i] != NULL) {
+            ethernetif_tx_ts_latch(tx_ts_pbuf[i], 0, 0, 0);
+            tx_ts_pbuf[i] = NULL;
+        }
+    }
+
+    mac_layer_init();
+    EMAC->CTL |= ctl;
+
+    if (tsctl & EMAC_TSCTL_TSEN_Msk) {
+        EMAC_EnableTS(sec, nsec);
+        EMAC->TSADDEND = addend;
+    }
+
+    LINK_STATS_INC(link.err);
+}
+
 /**
  * This function should do the actual transmission of the packet. The packet is
  * contained in the pbuf that is passed to the function. This pbuf
@@ -190,39 +317,56 @@ static void low_level_init(struct netif *netif)
 static err_t low_level_output(struct netif *netif, struct pbuf *p)
 {
     EMAC_DESCRIPTOR_T *desc;
+    struct pbuf *q;
     u32_t status;
 
+    PERF_START;
+
     /* Get Tx frame descriptor & data pointer */
     desc = (EMAC_DESCRIPTOR_T *) u32NextTxDesc;
 
     status = desc->u32Status1;
 
     /* Check descriptor ownership */
-    if ((status & EMAC_DESC_OWN_EMAC) == EMAC_DESC_OWN_EMAC)
+    if ((status & EMAC_DESC_OWN_EMAC) == EMAC_DESC_OWN_EMAC) {
+        PERF_STOP("low_level_output");
         return ERR_USE;
+    }
 
 #if ETH_PAD_SIZE
     pbuf_remove_header(p, ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
-    memcpy((u8_t *) desc->u32Data, p->payload, p->len);
+    /* Data and next pointer are overwritten by the Tx time stamp, the backup
+     * fields always hold the original values. Copy the whole pbuf chain. */
+    pbuf_copy_partial(p, (u8_t *) desc->u32Backup1, p->tot_len, 0);
 
     /* Set Tx descriptor transmit byte count */
-    desc->u32Status2 = p->len;
+    desc->u32Status2 = p->tot_len;
 
 #if ETH_PAD_SIZE
     pbuf_add_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
 #endif
 
+    /* Keep the pbuf until ethernetif_poll() reports its time stamp. With the
+     * ring taken up the frame goes out unstamped and without a callback. */
+    q = ethernetif_tx_ts_request(p);
+    if (q != NULL && tx_ts_held < ETHERNETIF_TX_TS_RING) {
+        pbuf_ref(q);
+        tx_ts_pbuf[ethernetif_tx_desc_index(desc)] = q;
+        tx_ts_held++;
+    }
+
     /* Change descriptor ownership to EMAC */
     desc->u32Status1 |= EMAC_DESC_OWN_EMAC;
 
     /* Get next Tx descriptor */
-    u32NextTxDesc = (u32_t)(desc->u32Next);
+    u32NextTxDesc = (u32_t)(desc->u32Backup2);
 
     /* Trigger EMAC to send the packet */
     EMAC_TRIGGER_TX();
 
+    PERF_STOP("low_level_output");
     return ERR_OK;
 }
 
@@ -230,32 +374,23 @@ static err_t low_level_output(struct netif *netif, struct pbuf *p)
  * Should allocate a pbuf and transfer the bytes of the incoming
  * packet from the interface into the pbuf.
  *
+ * The current Rx descriptor must be owned by the CPU. It is handed back to
+ * the EMAC before returning, also if the frame is dropped.
+ *
  * @param netif the lwip network interface structure for this ethernetif
  * @return a pbuf filled with the received packet (including MAC header)
- *         NULL on memory error
+ *         NULL on memory error or bad frame
  */
 static struct pbuf *low_level_input(struct netif *netif)
 {
-    struct pbuf *p;
-    volatile EMAC_DESCRIPTOR_T *cur_rx_desc =
-        (volatile EMAC_DESCRIPTOR_T *) u32CurrentRxDesc;
+    struct pbuf *p = NULL;
+    EMAC_DESCRIPTOR_T *desc = (EMAC_DESCRIPTOR_T *) u32CurrentRxDesc;
     u32_t status;
     u16_t len;
 
-    status = EMAC->INTSTS & 0xFFFF;
-    EMAC->INTSTS = status;
+    PERF_START;
 
-    if (status & EMAC_INTSTS_RXBEIF_Msk) {
-        // Shouldn't goes here, unless descriptor corrupted
-        printf("[Error]: EMAC_INTSTS_RXBEIF\n");
-        while (1)
-            ;
-    }
-
-    status = cur_rx_desc->u32Status1;
-
-    if (status & EMAC_DESC_OWN_EMAC)
-        return NULL;
+    status = desc->u32Status1;
 
     if (status & EMAC_RXFD_RXGD) {
         len = status & 0xFFFF;
@@ -273,20 +408,32 @@ static struct pbuf *low_level_input(struct netif *netif)
             pbuf_remove_header(p, ETH_PAD_SIZE); /* drop the padding word */
 #endif
 
-            /* Copy ethernet frame into pbuf */
-            memcpy((u8_t *) p->payload, (u8_t *) cur_rx_desc->u32Data, p->len);
+            /* Copy ethernet frame into pbuf, data pointer is in backup field
+             * since the time stamp overwrites it. */
+            pbuf_take(p, (u8_t *) desc->u32Backup1, p->tot_len);
 
 #if ETH_PAD_SIZE
             pbuf_add_header(p, ETH_PAD_SIZE); /* reclaim the padding word */
 #endif
 
+            /* Second in NEXT field, sub-second in DATA field */
+            if (status & EMAC_RXFD_RTSAS) {
+                p->ts_sec = desc->u32Next;
+                p->ts_nsec = ethernetif_subsec2nsec(desc->u32Data);
+                p->ts_flags |= ETHERNETIF_TS_RX;
+            }
+#if PKT_LATENCY
+            pkt_latency_ingress(p, rx_isr_cycles);
+#endif
         } else {
             printf("pbuf_alloc() failed.\n");
         }
     }
-    cur_rx_desc->u32Status1 = EMAC_DESC_OWN_EMAC;
-    cur_rx_desc = (volatile EMAC_DESCRIPTOR_T *) cur_rx_desc->u32Next;
 
+    /* Restore descriptor and give it back to EMAC */
+    EMAC_RecvPktDone();
+
+    PERF_STOP("low_level_input");
     return p;
 }
 
@@ -303,23 +450,150 @@ void ethernetif_input(struct netif *netif)
 {
     err_t err;
     struct pbuf *p;
+    u32_t status;
+
+#if PKT_LATENCY
+    rx_isr_cycles = PERF_CYCLES();
+#endif
+
+    status = EMAC->INTSTS & 0xFFFF;
+    EMAC->INTSTS = status;
 
-    /* move received packet into a new pbuf */
-    p = low_level_input(netif);
+    if (status & EMAC_INTSTS_RXBEIF_Msk) {
+        // Shouldn't goes here, unless descriptor corrupted
+        printf("[Error]: EMAC_INTSTS_RXBEIF\n");
+        /* The Tx interrupt is the only other writer of tx_ts_ring[] */
+        NVIC_DisableIRQ(EMAC_TX_IRQn);
+        low_level_restart(netif);
+        NVIC_EnableIRQ(EMAC_TX_IRQn);
+        return;
+    }
+
+    while (!(((EMAC_DESCRIPTOR_T *) u32CurrentRxDesc)->u32Status1 &
+             EMAC_DESC_OWN_EMAC)) {
+        /* move received packet into a new pbuf */
+        p = low_level_input(netif);
+        if (p == NULL)
+            continue;
 
-    while (p) {
         /* entry point to the LwIP stack */
         err = netif->input(p, netif);
 
         if (err != ERR_OK) {
             LWIP_DEBUGF(NETIF_DEBUG, ("ethernetif_input: IP input error\n"));
             pbuf_free(p);
-            p = NULL;
         }
-        p = low_level_input(netif);
     }
+}
 
-    EMAC_RecvPktDone();
+/**
+ * Clean up Tx descriptors after frames are sent. Must be called from the
+ * EMAC Tx interrupt instead of EMAC_SendPktDone().
+ *
+ * The Tx time stamps of pbufs marked with ETHERNETIF_TS_TX_REQ are latched
+ * for ethernetif_poll(), the pbufs themselves are left alone.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ */
+void ethernetif_tx_done(struct netif *netif)
+{
+    EMAC_DESCRIPTOR_T *desc;
+    struct pbuf *q;
+    u32_t status, idx, n;
+
+    status = EMAC->INTSTS;
+    /* Clear Tx interrupt flags */
+    EMAC->INTSTS = status & (0xFFFF0000UL & ~EMAC_INTSTS_TSALMIF_Msk);
+
+    if (status & EMAC_INTSTS_TXBEIF_Msk) {
+        // Shouldn't goes here, unless descriptor corrupted
+        printf("[Error]: EMAC_INTSTS_TXBEIF\n");
+        low_level_restart(netif);
+        return;
+    }
+
+    desc = (EMAC_DESCRIPTOR_T *) u32CurrentTxDesc;
+
+    /* EMAC writes the Tx status to the upper half of status word 2, which is
+     * cleared again once the descriptor is cleaned up. */
+    for (n = 0; n < EMAC_TX_DESC_SIZE; n++) {
+        /* Descriptor ownership is still EMAC, so this packet haven't been
+         * sent. */
+        if (desc->u32Status1 & EMAC_DESC_OWN_EMAC)
+            break;
+
+        status = desc->u32Status2;
+        if ((status & 0xFFFF0000UL) == 0)
+            break;
+
+        idx = ethernetif_tx_desc_index(desc);
+        q = tx_ts_pbuf[idx];
+        if (q != NULL) {
+            tx_ts_pbuf[idx] = NULL;
+            if ((status & EMAC_TXFD_TXCP) && (status & EMAC_TXFD_TTSAS))
+                ethernetif_tx_ts_latch(q, desc->u32Next,
+                                       ethernetif_subsec2nsec(desc->u32Data),
+                                       1);
+            else
+                ethernetif_tx_ts_latch(q, 0, 0, 0);
+        }
+
+        /* Restore descriptor link list and data pointer they will be
+         * overwrite if time stamp enabled */
+        desc->u32Data = desc->u32Backup1;
+        desc->u32Next = desc->u32Backup2;
+        desc->u32Status2 = 0;
+        desc = (EMAC_DESCRIPTOR_T *) desc->u32Next;
+    }
+
+    u32CurrentTxDesc = (u32_t) desc;
+}
+
+/**
+ * Pass the Tx time stamps latched by ethernetif_tx_done() on. Must be called
+ * from the main loop, the same context as sys_check_timeouts().
+ *
+ * pbufs marked with ETHERNETIF_TS_TX_REQ get the Tx time stamp stored and
+ * are passed to the callback set by ethernetif_set_tx_ts_callback(), then
+ * our reference is dropped.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ */
+void ethernetif_poll(struct netif *netif)
+{
+    struct ethernetif *ethernetif = netif->state;
+    volatile struct tx_ts_entry *e;
+    struct pbuf *q;
+
+    while (tx_ts_tail != tx_ts_head) {
+        e = &tx_ts_ring[tx_ts_tail % ETHERNETIF_TX_TS_RING];
+        q = e->p;
+        if (e->valid) {
+            q->ts_sec = e->sec;
+            q->ts_nsec = e->nsec;
+            q->ts_flags |= ETHERNETIF_TS_TX;
+        }
+        tx_ts_tail++;
+        tx_ts_held--;
+
+        if (ethernetif->tx_ts_fn != NULL)
+            ethernetif->tx_ts_fn(netif, q);
+        pbuf_free(q);
+    }
+}
+
+/**
+ * Set the function called by ethernetif_poll() once a pbuf marked with
+ * ETHERNETIF_TS_TX_REQ has been sent.
+ *
+ * @param netif the lwip network interface structure for this ethernetif
+ * @param fn    callback, NULL to disable
+ */
+void ethernetif_set_tx_ts_callback(struct netif *netif, ethernetif_tx_ts_fn fn)
+{
+    struct ethernetif *ethernetif = netif->state;
+
+    ethernetif->tx_ts_fn = fn;
 }
 
 /**
@@ -375,6 +649,7 @@ err_t ethernetif_init(struct netif *netif)
     netif->linkoutput = low_level_output;
 
     ethernetif->ethaddr = (struct eth_addr *) &(netif->hwaddr[0]);
+    ethernetif->tx_ts_fn = NULL;
 
     /* initialize the hardware */
     low_level_init(netif);
@@ -26,8 +26,21 @@
 
 #include "lwip/err.h"
 #include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+/* pbuf ts_flags, see LWIP_PBUF_CUSTOM_DATA in lwipopts.h */
+#define ETHERNETIF_TS_RX     0x01U /* ts_sec/ts_nsec hold the Rx time stamp */
+#define ETHERNETIF_TS_TX_REQ 0x02U /* capture the Tx time stamp of this pbuf */
+#define ETHERNETIF_TS_TX     0x04U /* ts_sec/ts_nsec hold the Tx time stamp */
+#define ETHERNETIF_TS_CYC    0x08U /* cyc_in holds the Rx ISR cycle count */
+
+/* Called from ethernetif_poll() with a pbuf marked ETHERNETIF_TS_TX_REQ */
+typedef void (*ethernetif_tx_ts_fn)(struct netif *netif, struct pbuf *p);
 
 err_t ethernetif_init(struct netif *netif);
 void ethernetif_input(struct netif *netif);
+void ethernetif_tx_done(struct netif *netif);
+void ethernetif_poll(struct netif *netif);
+void ethernetif_set_tx_ts_callback(struct netif *netif, ethernetif_tx_ts_fn fn);
 
 #endif
@@ -0,0 +1,24 @@
+/**
+ * @file lwip_hooks.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief lwIP hook declarations, included by the core through
+ *        LWIP_HOOK_FILENAME (see lwipopts.h).
+ */
+
+#ifndef LWIP_HOOKS_H
+#define LWIP_HOOKS_H
+
+#if PTP_TRANSPORT_L2
+#include "ptp.h"
+#endif
+
+#if SNTP_HIGH_PRECISION
+#include "sntp_clock.h"
+#endif
+
+#if PKT_LATENCY
+#include "pkt_latency.h"
+#endif
+
+#endif /* LWIP_HOOKS_H */
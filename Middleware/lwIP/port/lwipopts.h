@@ -70,6 +70,32 @@ a lot of data that needs to be copied, this should be set high. */
 /* PBUF_POOL_BUFSIZE: the size of each pbuf in the pbuf pool. */
 #define PBUF_POOL_BUFSIZE 500
 
+/* ---------- Latency trace options ---------- */
+/* PKT_LATENCY==1: Stamp received frames with the DWT cycle counter in the Rx
+ * ISR and at every stack layer, keep per-layer latency histograms
+ * (pkt_latency.h). */
+#define PKT_LATENCY 0
+
+/* LWIP_PBUF_CUSTOM_DATA: EMAC IEEE 1588 time stamp carried by each pbuf.
+ * ts_flags takes the ETHERNETIF_TS_* bits from ethernetif.h. With
+ * PKT_LATENCY, also the ingress cycle count and the last traced layer. */
+#if PKT_LATENCY
+#define LWIP_PBUF_CUSTOM_DATA \
+    u32_t ts_sec;             \
+    u32_t ts_nsec;            \
+    u8_t ts_flags;            \
+    u8_t trace_stage;         \
+    u32_t cyc_in;             \
+    u32_t cyc_last;
+#define LWIP_PBUF_TRACE(p, stage) pkt_latency_stamp(p, stage)
+#else
+#define LWIP_PBUF_CUSTOM_DATA \
+    u32_t ts_sec;             \
+    u32_t ts_nsec;            \
+    u8_t ts_flags;
+#endif
+#define LWIP_PBUF_CUSTOM_DATA_INIT(p) ((p)->ts_flags = 0)
+
 /* ---------- TCP options ---------- */
 #define LWIP_TCP 1
 #define TCP_TTL  255
@@ -101,12 +127,76 @@ interfaces. DHCP is not implemented in lwIP 0.5.1, however, so
 turning this on does currently not work. */
 #define LWIP_DHCP 1
 
+/* LWIP_DHCP_LEASE_STORE==1: The last lease is kept on the external flash
+ * (flash_lease.c) and requested again at start up (INIT-REBOOT), its address
+ * probed by ARP meanwhile, instead of discovering a server. */
+#define LWIP_DHCP_LEASE_STORE 1
+
+/* ---------- DNS options ---------- */
+/* LWIP_DNS==1: Resolve the servers of the clients (MQTT, SMTP, SNTP) by name,
+ * the DNS servers come from DHCP. Names looked up again are queried before
+ * their TTL expires (DNS_PREFETCH_PERCENT), non-existent ones are cached
+ * (DNS_MAX_NEG_TTL) and the fastest server is asked first (DNS_SERVER_RTT). */
+#define LWIP_DNS            1
+#define DNS_TABLE_SIZE      8
+#define DNS_MAX_NAME_LENGTH 128
+
+/* ---------- IP reassembly options ---------- */
+/* Fragments wait in the pbuf pool (PBUF_POOL_SIZE): one sender holds at most
+ * 2 full-size fragments, a datagram not complete within 3 s is dropped. The
+ * host test (test_ip4_reass) sizes the limit for its benchmark. */
+#define IP_REASS_MAXAGE 3
+#ifndef IP_REASS_MAX_PBUFS_PER_SRC
+#define IP_REASS_MAX_PBUFS_PER_SRC 8
+#endif
+
 /* ---------- UDP options ---------- */
 #define LWIP_UDP 1
 #define UDP_TTL  255
 
+/* ---------- PTP options ---------- */
+/* PTP_TRANSPORT_L2==1: Run PTP directly over Ethernet (ethertype 0x88F7)
+ * instead of UDP/IPv4 ports 319 and 320. */
+#define PTP_TRANSPORT_L2 0
+
+/* ---------- SNTP options ---------- */
+/* SNTP_HIGH_PRECISION==1: Poll every server, filter and combine their offsets
+ * and slew the EMAC time stamp clock through the PTP servo (sntp_clock.c),
+ * with the requests and responses time stamped by the EMAC, instead of
+ * setting the time in seconds. */
+#define SNTP_HIGH_PRECISION 1
+#ifndef SNTP_MAX_SERVERS
+#define SNTP_MAX_SERVERS    4
+#endif
+#define SNTP_GET_TIME_NS()                      sntp_clock_get_time()
+#define SNTP_PBUF_TIME_NS(p, t)                 sntp_clock_pbuf_time(p, &(t))
+#define SNTP_TX_TIMESTAMP_REQ(p)                sntp_clock_tx_request(p)
+#define SNTP_UPDATE_CLOCK(offset, delay, local) sntp_clock_update(offset, delay, local)
+
+/* ---------- Hook options ---------- */
+#define LWIP_HOOK_FILENAME "lwip_hooks.h"
+#if PTP_TRANSPORT_L2
+#define LWIP_HOOK_UNKNOWN_ETH_PROTOCOL(p, netif) ptp_l2_input(p, netif)
+#endif
+
+/* ---------- Profiling options ---------- */
+/* LWIP_PERF==1: Measure the hot path with PERF_START/PERF_STOP in DWT cycles
+ * (arch/perf.h). Call perf_init() at start up and perf_print_stats() to dump
+ * min/avg/max/percentiles per point. */
+#define LWIP_PERF 0
+
 /* ---------- Statistics options ---------- */
-#define LWIP_STATS         0
+/* LWIP_STATS==1: Only the heap and the pools, used and high watermark, for the
+ * benchmark (bench.c). */
+#define LWIP_STATS         1
+#define LINK_STATS         0
+#define ETHARP_STATS       0
+#define IP_STATS           0
+#define IPFRAG_STATS       0
+#define ICMP_STATS         0
+#define IGMP_STATS         0
+#define UDP_STATS          0
+#define TCP_STATS          0
 #define LWIP_PROVIDE_ERRNO 1
 
 /* ---------- link callback options ---------- */
@@ -138,6 +228,73 @@ turning this on does currently not work. */
 /*CHECKSUM_CHECK_ICMP==1: Check checksums by hardware for incoming ICMP
  * packets.*/
 #define CHECKSUM_GEN_ICMP 1
+/* LWIP_CHECKSUM_ON_COPY==1: Calculate the TCP checksum while copying data
+ * into segments, or take it from tcp_write_precalc(), instead of in a
+ * second pass over the segment at send time. */
+#define LWIP_CHECKSUM_ON_COPY 1
+
+/* ---------- HTTP server options ---------- */
+/* HTTPD_PRECALCULATED_CHECKSUM==1: Send the files of fsdata.c (makefsdata -c)
+ * as PBUF_ROM references with the checksums computed by makefsdata. The file
+ * data is then only read once, by the copy into the Tx DMA buffer. */
+#define HTTPD_PRECALCULATED_CHECKSUM 1
+
+/* LWIP_HTTPD_GZIP_VARIANTS==1: Send the "<name>.gz" variants of fsdata.c
+ * (makefsdata -gz) to clients that send "Accept-Encoding: gzip". */
+#define LWIP_HTTPD_GZIP_VARIANTS 1
+
+/* LWIP_HTTPD_SUPPORT_11_KEEPALIVE==1: Keep HTTP/1.1 connections open, the
+ * file headers say "Connection: keep-alive" (makefsdata -11).
+ * LWIP_HTTPD_SUPPORT_PIPELINING==1: Answer pipelined requests in order. */
+#define LWIP_HTTPD_SUPPORT_11_KEEPALIVE 1
+#define LWIP_HTTPD_SUPPORT_PIPELINING 1
+
+/* LWIP_HTTPD_INCREMENTAL_PARSER==1: Parse requests in place from the received
+ * pbufs, resuming at the end of the previous segment (httpd_parser.c). */
+#define LWIP_HTTPD_INCREMENTAL_PARSER 1
+
+/* LWIP_HTTPD_DYNAMIC_HANDLERS==1: Answer the URIs of http_set_dyn_handlers()
+ * with generated bodies (e.g. JSON telemetry), chunked for HTTP/1.1, written
+ * part by part into the room tcp_sndbuf() reports. */
+#define LWIP_HTTPD_DYNAMIC_HANDLERS 1
+
+/* LWIP_HTTPD_WEBSOCKET==1: Upgrade GETs of the URIs of http_set_ws_handlers()
+ * to WebSocket connections, pushed to with httpd_ws_send() from the main loop
+ * and pinged when idle (httpd_ws.c). */
+#define LWIP_HTTPD_WEBSOCKET 1
+
+/* LWIP_HTTPD_SUPPORT_POST==1: Stream POST bodies to the external flash
+ * (flash_upload.c).
+ * LWIP_HTTPD_POST_MANUAL_WND==1: The window is opened only for what has been
+ * programmed, so a client cannot send faster than the flash writes. */
+#define LWIP_HTTPD_SUPPORT_POST 1
+#define LWIP_HTTPD_POST_MANUAL_WND 1
+
+/* LWIP_HTTPD_CUSTOM_FILES==1: Look up the file system image on the external
+ * flash (flash_fs.c) before the files of fsdata.c.
+ * LWIP_HTTPD_DYNAMIC_FILE_READ==1: Those are read part by part into a send
+ * buffer, the files of fsdata.c are still sent in place. */
+#define LWIP_HTTPD_CUSTOM_FILES 1
+#define LWIP_HTTPD_DYNAMIC_FILE_READ 1
+
+/* LWIP_HTTPD_FS_ASYNC_READ==1: A part that is not cached is read from the
+ * flash by PDMA, the connection is resumed from flash_fs_poll() meanwhile
+ * the main loop keeps serving the others. */
+#define LWIP_HTTPD_FS_ASYNC_READ 1
+
+/* Idle keep-alive connections run at the lowest priority, tcp_alloc() then
+ * reclaims the least recently used one when MEMP_NUM_TCP_PCB is exhausted.
+ * LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED does the same when the
+ * http_state allocation fails. */
+#define HTTPD_TCP_PRIO TCP_PRIO_NORMAL
+#define HTTPD_TCP_PRIO_IDLE TCP_PRIO_MIN
+#define LWIP_HTTPD_KILL_OLD_ON_CONNECTIONS_EXCEEDED 1
+
+/* ---------- MQTT client options ---------- */
+/* MQTT_REQ_MAX_IN_FLIGHT: Bound of the in-flight window, QoS 1 and 2
+ * publishes waiting for their acknowledgement. The window starts at
+ * MQTT_REQ_WINDOW_INIT and grows with the acknowledgements. */
+#define MQTT_REQ_MAX_IN_FLIGHT 32
 
 /*
     ----------------------------------------------
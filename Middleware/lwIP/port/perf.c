@@ -0,0 +1,43 @@
+/**
+ * @file perf.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Cycle counter for the lwIP port, see arch/perf.h.
+ */
+
+#include <stdio.h>
+#include "NuMicro.h"
+#include "lwip/opt.h"
+#include "arch/perf.h"
+
+void perf_init(void)
+{
+    /* DWT is part of the trace block, enabled by TRCENA */
+    CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+    DWT->CYCCNT = 0;
+    DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+}
+
+void perf_stop(struct perf_point **pt, const char *name, uint32_t cycles)
+{
+    uint32_t mask = __get_PRIMASK();
+
+    __disable_irq();
+    if (*pt == NULL)
+        *pt = perf_point_get(name);
+    if (*pt != NULL)
+        perf_hist_add(&(*pt)->hist, cycles);
+    __set_PRIMASK(mask);
+}
+
+void perf_print_stats(void)
+{
+    uint32_t mask;
+
+    perf_stats_print(stdout, SystemCoreClock / 1000000);
+
+    mask = __get_PRIMASK();
+    __disable_irq();
+    perf_stats_reset();
+    __set_PRIMASK(mask);
+}
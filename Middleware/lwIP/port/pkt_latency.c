@@ -0,0 +1,97 @@
+/**
+ * @file pkt_latency.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Per-layer latency of received packets (PKT_LATENCY in lwipopts.h).
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "NuMicro.h"
+
+#include "lwip/opt.h"
+#include "arch/perf.h"
+#include "ethernetif.h"
+#include "pkt_latency.h"
+
+#if PKT_LATENCY
+
+static struct perf_hist hist[PKT_LATENCY_NUM];
+
+static const char *const hist_name[PKT_LATENCY_NUM] = {
+    "isr->netif", "netif->ip", "ip->transport", "transport->app", "total",
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void pkt_latency_init(void)
+{
+    perf_init();
+    pkt_latency_reset();
+}
+
+void pkt_latency_reset(void)
+{
+    uint32_t mask = __get_PRIMASK();
+
+    __disable_irq();
+    memset(hist, 0, sizeof(hist));
+    __set_PRIMASK(mask);
+}
+
+void pkt_latency_ingress(struct pbuf *p, u32_t cyc)
+{
+    p->cyc_in = cyc;
+    p->cyc_last = cyc;
+    p->trace_stage = 0;
+    p->ts_flags |= ETHERNETIF_TS_CYC;
+}
+
+void pkt_latency_stamp(struct pbuf *p, u8_t stage)
+{
+    u32_t now;
+
+    /* Only frames stamped by ethernetif, each stage once */
+    if (!(p->ts_flags & ETHERNETIF_TS_CYC) || stage <= p->trace_stage)
+        return;
+
+    now = PERF_CYCLES();
+    perf_hist_add(&hist[stage - 1], now - p->cyc_last);
+    if (stage == PBUF_TRACE_APP)
+        perf_hist_add(&hist[PKT_LATENCY_TOTAL], now - p->cyc_in);
+
+    p->cyc_last = now;
+    p->trace_stage = stage;
+}
+
+void pkt_latency_get(u8_t idx, struct perf_hist *h)
+{
+    uint32_t mask = __get_PRIMASK();
+
+    __disable_irq();
+    *h = hist[idx];
+    __set_PRIMASK(mask);
+}
+
+void pkt_latency_print(void)
+{
+    struct perf_hist h;
+    u32_t mhz = SystemCoreClock / 1000000;
+    u8_t i;
+
+    printf("%-15s %8s %8s %8s %8s %8s %8s %8s\n", "stage [us]", "count",
+           "min", "avg", "max", "p50", "p90", "p99");
+    for (i = 0; i < PKT_LATENCY_NUM; i++) {
+        pkt_latency_get(i, &h);
+        printf("%-15s %8lu %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+               hist_name[i], (unsigned long) h.count, (float) h.min / mhz,
+               h.count ? (float) h.sum / h.count / mhz : 0.0f,
+               (float) h.max / mhz,
+               (float) perf_hist_percentile(&h, 50) / mhz,
+               (float) perf_hist_percentile(&h, 90) / mhz,
+               (float) perf_hist_percentile(&h, 99) / mhz);
+    }
+}
+
+#endif /* PKT_LATENCY */
@@ -0,0 +1,71 @@
+/**
+ * @file pkt_latency.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Per-layer latency of received packets (PKT_LATENCY in lwipopts.h).
+ *
+ * ethernetif stamps every frame with the DWT cycle count of the Rx ISR,
+ * LWIP_PBUF_TRACE() stamps it again in ethernet_input(), ip4_input(),
+ * udp_input()/tcp_input() and before the application recv callback. The
+ * time between two stamps goes to a log2 histogram per stage.
+ *
+ * Applications can read p->cyc_in (ETHERNETIF_TS_CYC) and the EMAC time
+ * stamps (ETHERNETIF_TS_RX/TX) directly from the pbuf.
+ */
+
+#ifndef PKT_LATENCY_H
+#define PKT_LATENCY_H
+
+#include "lwip/opt.h"
+#include "lwip/pbuf.h"
+#include "perf_stats.h"
+
+#if PKT_LATENCY
+
+/** Histogram index */
+#define PKT_LATENCY_ISR_NETIF     0 /* Rx ISR -> ethernet_input() */
+#define PKT_LATENCY_NETIF_IP      1 /* ethernet_input() -> ip4_input() */
+#define PKT_LATENCY_IP_TRANSPORT  2 /* ip4_input() -> udp/tcp_input() */
+#define PKT_LATENCY_TRANSPORT_APP 3 /* udp/tcp_input() -> recv callback */
+#define PKT_LATENCY_TOTAL         4 /* Rx ISR -> recv callback */
+#define PKT_LATENCY_NUM           5
+
+/**
+ * @brief Start the cycle counter and clear all histograms.
+ */
+void pkt_latency_init(void);
+
+/**
+ * @brief Clear all histograms.
+ */
+void pkt_latency_reset(void);
+
+/**
+ * @brief Stamp a received frame, called by ethernetif.
+ * @param p     pbuf of the frame
+ * @param cyc   cycle count at Rx ISR entry
+ */
+void pkt_latency_ingress(struct pbuf *p, u32_t cyc);
+
+/**
+ * @brief LWIP_PBUF_TRACE() target.
+ * @param p     pbuf entering a layer
+ * @param stage PBUF_TRACE_* from pbuf.h
+ */
+void pkt_latency_stamp(struct pbuf *p, u8_t stage);
+
+/**
+ * @brief Copy one histogram, in cycles.
+ * @param idx   PKT_LATENCY_* histogram index
+ * @param hist  output
+ */
+void pkt_latency_get(u8_t idx, struct perf_hist *hist);
+
+/**
+ * @brief Print count, min/avg/max and p50/p90/p99 of every stage in us.
+ */
+void pkt_latency_print(void);
+
+#endif /* PKT_LATENCY */
+
+#endif /* PKT_LATENCY_H */
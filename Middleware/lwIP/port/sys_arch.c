@@ -6,6 +6,7 @@
 #include "lwip/tcpip.h"
 
 static uint32_t u32Jiffies = 0;
+static uint32_t u32RandState = 0;
 
 void TMR0_IRQHandler(void)
 {
@@ -18,6 +19,30 @@ u32_t sys_now(void)
     return u32Jiffies;
 }
 
+/* xorshift32 for LWIP_RAND(): DNS ids, DHCP xid, the first local ports. The
+   TRNG takes about 4 ms per word, so it only provides the seed. */
+void sys_rand_init(void)
+{
+    uint32_t seed = 0;
+
+    if (TRNG_Open() != 0 || TRNG_GenWord(&seed) != 0)
+        printf("[ERROR]: TRNG, LWIP_RAND() seeded from TIMER0\n");
+    u32RandState = seed ^ TIMER_GetCounter(TIMER0);
+    if (u32RandState == 0)
+        u32RandState = 0x9E3779B9UL;
+}
+
+u32_t sys_rand(void)
+{
+    uint32_t x = u32RandState;
+
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    u32RandState = x;
+    return x;
+}
+
 uint32_t sys_arch_protect(void)
 {
     uint32_t mask = __get_PRIMASK();
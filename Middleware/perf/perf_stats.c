@@ -0,0 +1,106 @@
+/**
+ * @file perf_stats.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Aggregated min/avg/max/percentiles of PERF_START/PERF_STOP points.
+ */
+
+#include <string.h>
+#include "perf_stats.h"
+
+static struct perf_point points[PERF_STATS_MAX_POINTS];
+static uint8_t num_points;
+
+static uint8_t perf_log2(uint32_t v)
+{
+    return v ? (uint8_t)(31 - __builtin_clz(v)) : 0;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void perf_hist_add(struct perf_hist *hist, uint32_t value)
+{
+    if (hist->count == 0 || value < hist->min)
+        hist->min = value;
+    if (value > hist->max)
+        hist->max = value;
+    hist->count++;
+    hist->sum += value;
+    hist->bucket[perf_log2(value)]++;
+}
+
+uint32_t perf_hist_percentile(const struct perf_hist *hist, uint8_t percent)
+{
+    uint32_t target, acc = 0;
+    uint64_t lo, hi, v;
+    uint8_t i;
+
+    if (hist->count == 0)
+        return 0;
+
+    target = (uint32_t)(((uint64_t) hist->count * percent + 99) / 100);
+    if (target == 0)
+        return hist->min;
+
+    for (i = 0; i < PERF_HIST_BUCKETS - 1; i++) {
+        if (acc + hist->bucket[i] >= target)
+            break;
+        acc += hist->bucket[i];
+    }
+
+    /* Linear inside the bucket */
+    lo = i ? (uint64_t) 1 << i : 0;
+    hi = ((uint64_t) 2 << i) - 1;
+    v = lo + (hi - lo) * (target - acc) / hist->bucket[i];
+
+    if (v < hist->min)
+        v = hist->min;
+    if (v > hist->max)
+        v = hist->max;
+    return (uint32_t) v;
+}
+
+struct perf_point *perf_point_get(const char *name)
+{
+    uint8_t i;
+
+    for (i = 0; i < num_points; i++) {
+        if (points[i].name == name || strcmp(points[i].name, name) == 0)
+            return &points[i];
+    }
+
+    if (num_points >= PERF_STATS_MAX_POINTS)
+        return NULL;
+
+    points[num_points].name = name;
+    memset(&points[num_points].hist, 0, sizeof(struct perf_hist));
+    return &points[num_points++];
+}
+
+void perf_stats_reset(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < num_points; i++)
+        memset(&points[i].hist, 0, sizeof(struct perf_hist));
+}
+
+void perf_stats_print(FILE *out, uint32_t ticks_per_us)
+{
+    struct perf_hist h;
+    float div = ticks_per_us ? (float) ticks_per_us : 1.0f;
+    uint8_t i;
+
+    fprintf(out, "%-18s %8s %8s %8s %8s %8s %8s %8s\n", "point [us]", "count",
+            "min", "avg", "max", "p50", "p90", "p99");
+    for (i = 0; i < num_points; i++) {
+        h = points[i].hist;
+        fprintf(out, "%-18s %8lu %8.2f %8.2f %8.2f %8.2f %8.2f %8.2f\n",
+                points[i].name, (unsigned long) h.count, h.min / div,
+                h.count ? (float) h.sum / h.count / div : 0.0f, h.max / div,
+                perf_hist_percentile(&h, 50) / div,
+                perf_hist_percentile(&h, 90) / div,
+                perf_hist_percentile(&h, 99) / div);
+    }
+}
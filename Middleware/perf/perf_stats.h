@@ -0,0 +1,73 @@
+/**
+ * @file perf_stats.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Aggregated min/avg/max/percentiles of PERF_START/PERF_STOP points.
+ *
+ * arch/perf.h of each port maps PERF_START/PERF_STOP (lwip/def.h, enabled
+ * with LWIP_PERF) onto these functions:
+ *  - M487 port  : Cortex-M4 DWT cycle counter, unit is CPU cycles
+ *  - unix port  : clock_gettime(CLOCK_MONOTONIC), unit is ns
+ *
+ * Each point keeps a log2 histogram, percentiles are interpolated inside a
+ * bucket and clamped to min/max.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+/** Maximum number of distinct PERF_STOP() names */
+#ifndef PERF_STATS_MAX_POINTS
+#define PERF_STATS_MAX_POINTS 16
+#endif
+
+/** Bucket n counts values of [2^n, 2^(n+1)), bucket 0 also 0 */
+#define PERF_HIST_BUCKETS 32
+
+struct perf_hist {
+    uint32_t count;
+    uint32_t min;
+    uint32_t max;
+    uint64_t sum;
+    uint32_t bucket[PERF_HIST_BUCKETS];
+};
+
+struct perf_point {
+    const char *name;
+    struct perf_hist hist;
+};
+
+/**
+ * @brief Add one value to a histogram.
+ */
+void perf_hist_add(struct perf_hist *hist, uint32_t value);
+
+/**
+ * @brief Estimate a percentile of a histogram.
+ * @param hist      histogram
+ * @param percent   0 .. 100
+ */
+uint32_t perf_hist_percentile(const struct perf_hist *hist, uint8_t percent);
+
+/**
+ * @brief Find a point by name, or create it.
+ * @return NULL if PERF_STATS_MAX_POINTS are in use
+ */
+struct perf_point *perf_point_get(const char *name);
+
+/**
+ * @brief Clear the histograms of all points.
+ */
+void perf_stats_reset(void);
+
+/**
+ * @brief Print count, min/avg/max and p50/p90/p99 of every point in us.
+ * @param out           output stream
+ * @param ticks_per_us  counter ticks per micro second
+ */
+void perf_stats_print(FILE *out, uint32_t ticks_per_us);
+
+#endif /* PERF_STATS_H */
@@ -0,0 +1,685 @@
+/**
+ * @file ptp.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief IEEE 1588-2008 (PTPv2) ordinary clock, slave only.
+ *
+ * End-to-end delay mechanism, one- and two-step masters. The master is chosen
+ * by a reduced BMCA on the Announce data set (priority1, clockClass,
+ * clockAccuracy, variance, priority2, identity).
+ *
+ *  t1  master sends Sync        (originTimestamp or Follow_Up)
+ *  t2  slave receives Sync      (EMAC Rx time stamp)
+ *  t3  slave sends Delay_Req    (EMAC Tx time stamp)
+ *  t4  master receives it       (Delay_Resp receiveTimestamp)
+ *
+ *  delay  = ((t2 - t1) + (t4 - t3)) / 2
+ *  offset = (t2 - t1) - delay
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lwip/def.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+#include "lwip/ip_addr.h"
+#include "netif/ethernet.h"
+
+#include "ethernetif.h"
+#include "ptp.h"
+
+/*******************************************************************************
+ * Protocol constants
+ ******************************************************************************/
+#define PTP_EVENT_PORT   319
+#define PTP_GENERAL_PORT 320
+#define PTP_ETHTYPE      0x88F7
+
+#define PTP_MSG_SYNC       0x0
+#define PTP_MSG_DELAY_REQ  0x1
+#define PTP_MSG_FOLLOW_UP  0x8
+#define PTP_MSG_DELAY_RESP 0x9
+#define PTP_MSG_ANNOUNCE   0xB
+
+#define PTP_HDR_LEN        34
+#define PTP_SYNC_LEN       44
+#define PTP_DELAY_REQ_LEN  44
+#define PTP_FOLLOW_UP_LEN  44
+#define PTP_DELAY_RESP_LEN 54
+#define PTP_ANNOUNCE_LEN   64
+
+#define PTP_FLAG_TWO_STEP 0x02 /* first octet of flagField */
+
+#define PTP_CLOCK_ID_LEN 8
+#define PTP_PORT_ID_LEN  10
+
+/* Header field offsets */
+#define PTP_OFS_TYPE       0
+#define PTP_OFS_VERSION    1
+#define PTP_OFS_LENGTH     2
+#define PTP_OFS_DOMAIN     4
+#define PTP_OFS_FLAGS      6
+#define PTP_OFS_CORRECTION 8
+#define PTP_OFS_SRC_PORT   20
+#define PTP_OFS_SEQ        30
+#define PTP_OFS_CONTROL    32
+#define PTP_OFS_LOG_INTVL  33
+#define PTP_OFS_BODY       34
+
+/* Announce body offsets */
+#define PTP_OFS_GM_PRIORITY1  47
+#define PTP_OFS_GM_CLASS      48
+#define PTP_OFS_GM_ACCURACY   49
+#define PTP_OFS_GM_VARIANCE   50
+#define PTP_OFS_GM_PRIORITY2  52
+#define PTP_OFS_GM_IDENTITY   53
+#define PTP_OFS_STEPS_REMOVED 61
+
+/* Delay_Resp body offset */
+#define PTP_OFS_REQ_PORT 44
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+/** Announce fields compared by the BMCA */
+struct ptp_master {
+    uint8_t port_id[PTP_PORT_ID_LEN]; /* sender of Announce/Sync */
+    uint8_t priority1;
+    uint8_t clock_class;
+    uint8_t accuracy;
+    uint16_t variance;
+    uint8_t priority2;
+    uint8_t gm_id[PTP_CLOCK_ID_LEN];
+    uint16_t steps_removed;
+};
+
+struct ptp_port {
+    struct netif *netif;
+    const struct ptp_clock *clock;
+#if !PTP_TRANSPORT_L2
+    struct udp_pcb *event_pcb;
+    struct udp_pcb *general_pcb;
+#endif
+    enum ptp_port_state state;
+    uint8_t port_id[PTP_PORT_ID_LEN];
+
+    /* selected master */
+    int have_master;
+    struct ptp_master master;
+    int32_t announce_timeout; /* ms until the master is dropped */
+
+    /* Sync / Follow_Up */
+    int sync_pending;         /* waiting for Follow_Up */
+    uint16_t sync_seq;
+    int64_t t2;
+    int64_t sync_corr;
+    int64_t ms_diff;          /* t2 - t1 of the last Sync */
+    int have_ms;
+
+    /* Delay_Req / Delay_Resp */
+    uint16_t delay_req_seq;
+    int8_t delay_req_log;
+    int32_t delay_req_timer;  /* ms until the next Delay_Req */
+    int delay_req_pending;    /* waiting for Delay_Resp */
+    struct pbuf *delay_req_p; /* waiting for its Tx time stamp */
+    int64_t t3;
+    int64_t path_delay;
+    int have_delay;
+
+    struct ptp_servo servo;
+    struct ptp_stats stats;
+};
+
+static struct ptp_port ptp;
+
+#if PTP_TRANSPORT_L2
+static const struct eth_addr ptp_l2_mcast = {{0x01, 0x1B, 0x19, 0x00, 0x00, 0x00}};
+#else
+static ip_addr_t ptp_mcast;
+#endif
+
+/*******************************************************************************
+ * Private Function
+ ******************************************************************************/
+static uint16_t ptp_get16(const uint8_t *b)
+{
+    return (uint16_t)((b[0] << 8) | b[1]);
+}
+
+static uint32_t ptp_get32(const uint8_t *b)
+{
+    return ((uint32_t) b[0] << 24) | ((uint32_t) b[1] << 16) |
+           ((uint32_t) b[2] << 8) | b[3];
+}
+
+static void ptp_put16(uint8_t *b, uint16_t v)
+{
+    b[0] = (uint8_t)(v >> 8);
+    b[1] = (uint8_t) v;
+}
+
+static void ptp_put32(uint8_t *b, uint32_t v)
+{
+    b[0] = (uint8_t)(v >> 24);
+    b[1] = (uint8_t)(v >> 16);
+    b[2] = (uint8_t)(v >> 8);
+    b[3] = (uint8_t) v;
+}
+
+/**
+ * @brief Timestamp: 48 bit seconds, 32 bit nano seconds.
+ */
+static int64_t ptp_get_timestamp(const uint8_t *b)
+{
+    int64_t sec = ((int64_t) ptp_get16(b) << 32) | ptp_get32(b + 2);
+
+    return sec * PTP_NSEC_PER_SEC + ptp_get32(b + 6);
+}
+
+static void ptp_put_timestamp(uint8_t *b, int64_t ns)
+{
+    int64_t sec = ns / PTP_NSEC_PER_SEC;
+
+    ptp_put16(b, (uint16_t)(sec >> 32));
+    ptp_put32(b + 2, (uint32_t) sec);
+    ptp_put32(b + 6, (uint32_t)(ns % PTP_NSEC_PER_SEC));
+}
+
+/**
+ * @brief correctionField is nano seconds * 2^16.
+ */
+static int64_t ptp_get_correction(const uint8_t *b)
+{
+    int64_t v = ((int64_t) ptp_get32(b) << 32) | ptp_get32(b + 4);
+
+    return v / 65536;
+}
+
+/**
+ * @brief Interval in ms from a log2 seconds field, 0x7F means unspecified.
+ */
+static int32_t ptp_log_interval_ms(int8_t log)
+{
+    if (log == 0x7F)
+        return 1000;
+    if (log < -7)
+        log = -7;
+    if (log > 7)
+        log = 7;
+    return log >= 0 ? 1000 << log : 1000 >> -log;
+}
+
+/**
+ * @brief Receive time of a frame, EMAC time stamp if available.
+ */
+static int64_t ptp_rx_time(struct pbuf *p)
+{
+    if (p->ts_flags & ETHERNETIF_TS_RX)
+        return (int64_t) p->ts_sec * PTP_NSEC_PER_SEC + p->ts_nsec;
+
+    ptp.stats.sw_timestamps++;
+    return ptp.clock->get_time(ptp.clock);
+}
+
+static void ptp_set_state(enum ptp_port_state state)
+{
+    if (ptp.state == state)
+        return;
+    LWIP_DEBUGF(PTP_DEBUG, ("ptp: state %d -> %d\n", ptp.state, state));
+    ptp.state = state;
+}
+
+/**
+ * @brief Drop the pending Delay_Req, e.g. after the clock was stepped.
+ */
+static void ptp_delay_req_cancel(void)
+{
+    ptp.delay_req_pending = 0;
+    if (ptp.delay_req_p != NULL) {
+        pbuf_free(ptp.delay_req_p);
+        ptp.delay_req_p = NULL;
+    }
+}
+
+static void ptp_reset_master(void)
+{
+    ptp.have_master = 0;
+    ptp.sync_pending = 0;
+    ptp.have_ms = 0;
+    ptp.have_delay = 0;
+    ptp.delay_req_log = PTP_DELAY_REQ_INTERVAL_LOG;
+    ptp_delay_req_cancel();
+    ptp_servo_init(&ptp.servo, ptp.clock, 1000);
+    ptp_set_state(PTP_STATE_LISTENING);
+}
+
+/**
+ * @brief Reduced BMCA, data set comparison of IEEE 1588-2008 9.3.4.
+ * @return < 0 if a is better than b
+ */
+static int ptp_master_compare(const struct ptp_master *a,
+                              const struct ptp_master *b)
+{
+    if (a->priority1 != b->priority1)
+        return a->priority1 - b->priority1;
+    if (a->clock_class != b->clock_class)
+        return a->clock_class - b->clock_class;
+    if (a->accuracy != b->accuracy)
+        return a->accuracy - b->accuracy;
+    if (a->variance != b->variance)
+        return a->variance - b->variance;
+    if (a->priority2 != b->priority2)
+        return a->priority2 - b->priority2;
+    return memcmp(a->gm_id, b->gm_id, PTP_CLOCK_ID_LEN);
+}
+
+static int ptp_from_master(const uint8_t *msg)
+{
+    return ptp.have_master &&
+           memcmp(msg + PTP_OFS_SRC_PORT, ptp.master.port_id,
+                  PTP_PORT_ID_LEN) == 0;
+}
+
+/**
+ * @brief Offset from master for the last Sync, fed to the servo.
+ */
+static void ptp_sync_complete(int64_t t1, int64_t corr)
+{
+    enum ptp_servo_state state;
+    int64_t offset;
+
+    ptp.ms_diff = ptp.t2 - t1 - corr;
+    ptp.have_ms = 1;
+
+    if (!ptp.have_delay)
+        return;
+
+    offset = ptp.ms_diff - ptp.path_delay;
+    state = ptp_servo_sample(&ptp.servo, offset, ptp.path_delay, ptp.t2);
+
+    switch (state) {
+    case PTP_SERVO_JUMP:
+        /* Time stamps taken before the step are useless now */
+        ptp.have_ms = 0;
+        ptp_delay_req_cancel();
+        ptp_set_state(PTP_STATE_UNCALIBRATED);
+        break;
+    case PTP_SERVO_LOCKED:
+        ptp_set_state(PTP_STATE_SLAVE);
+        break;
+    default:
+        break;
+    }
+}
+
+static void ptp_handle_announce(const uint8_t *msg, u16_t len)
+{
+    struct ptp_master cand;
+
+    if (len < PTP_ANNOUNCE_LEN)
+        goto drop;
+
+    memcpy(cand.port_id, msg + PTP_OFS_SRC_PORT, PTP_PORT_ID_LEN);
+    cand.priority1 = msg[PTP_OFS_GM_PRIORITY1];
+    cand.clock_class = msg[PTP_OFS_GM_CLASS];
+    cand.accuracy = msg[PTP_OFS_GM_ACCURACY];
+    cand.variance = ptp_get16(msg + PTP_OFS_GM_VARIANCE);
+    cand.priority2 = msg[PTP_OFS_GM_PRIORITY2];
+    memcpy(cand.gm_id, msg + PTP_OFS_GM_IDENTITY, PTP_CLOCK_ID_LEN);
+    cand.steps_removed = ptp_get16(msg + PTP_OFS_STEPS_REMOVED);
+
+    /* Own messages looped back, or a path too long */
+    if (memcmp(cand.port_id, ptp.port_id, PTP_CLOCK_ID_LEN) == 0 ||
+        cand.steps_removed >= 255)
+        goto drop;
+
+    ptp.stats.rx_announce++;
+
+    if (ptp_from_master(msg)) {
+        ptp.master = cand;
+    } else if (!ptp.have_master ||
+               ptp_master_compare(&cand, &ptp.master) < 0) {
+        if (ptp.have_master)
+            ptp_reset_master();
+        ptp.master = cand;
+        ptp.have_master = 1;
+        ptp.delay_req_timer = 0;
+        ptp_set_state(PTP_STATE_UNCALIBRATED);
+        LWIP_DEBUGF(PTP_DEBUG,
+                    ("ptp: master %02x%02x%02x.%02x%02x.%02x%02x%02x\n",
+                     cand.gm_id[0], cand.gm_id[1], cand.gm_id[2],
+                     cand.gm_id[3], cand.gm_id[4], cand.gm_id[5],
+                     cand.gm_id[6], cand.gm_id[7]));
+    } else {
+        return;
+    }
+
+    ptp.announce_timeout = PTP_ANNOUNCE_RECEIPT_TIMEOUT *
+                           ptp_log_interval_ms((int8_t) msg[PTP_OFS_LOG_INTVL]);
+    return;
+
+drop:
+    ptp.stats.rx_dropped++;
+}
+
+static void ptp_handle_sync(const uint8_t *msg, u16_t len, int64_t t2)
+{
+    if (len < PTP_SYNC_LEN || !ptp_from_master(msg)) {
+        ptp.stats.rx_dropped++;
+        return;
+    }
+    ptp.stats.rx_sync++;
+
+    ptp_servo_set_interval(
+        &ptp.servo, ptp_log_interval_ms((int8_t) msg[PTP_OFS_LOG_INTVL]));
+
+    ptp.t2 = t2;
+    ptp.sync_seq = ptp_get16(msg + PTP_OFS_SEQ);
+    ptp.sync_corr = ptp_get_correction(msg + PTP_OFS_CORRECTION);
+
+    if (msg[PTP_OFS_FLAGS] & PTP_FLAG_TWO_STEP) {
+        ptp.sync_pending = 1;
+        return;
+    }
+
+    ptp.sync_pending = 0;
+    ptp_sync_complete(ptp_get_timestamp(msg + PTP_OFS_BODY), ptp.sync_corr);
+}
+
+static void ptp_handle_follow_up(const uint8_t *msg, u16_t len)
+{
+    if (len < PTP_FOLLOW_UP_LEN || !ptp_from_master(msg) ||
+        !ptp.sync_pending || ptp_get16(msg + PTP_OFS_SEQ) != ptp.sync_seq) {
+        ptp.stats.rx_dropped++;
+        return;
+    }
+    ptp.stats.rx_follow_up++;
+
+    ptp.sync_pending = 0;
+    ptp_sync_complete(ptp_get_timestamp(msg + PTP_OFS_BODY),
+                      ptp.sync_corr +
+                          ptp_get_correction(msg + PTP_OFS_CORRECTION));
+}
+
+static void ptp_handle_delay_resp(const uint8_t *msg, u16_t len)
+{
+    int64_t t4, sm_diff, delay;
+
+    if (len < PTP_DELAY_RESP_LEN || !ptp_from_master(msg) ||
+        memcmp(msg + PTP_OFS_REQ_PORT, ptp.port_id, PTP_PORT_ID_LEN) != 0 ||
+        !ptp.delay_req_pending ||
+        ptp_get16(msg + PTP_OFS_SEQ) != ptp.delay_req_seq) {
+        ptp.stats.rx_dropped++;
+        return;
+    }
+    ptp.stats.rx_delay_resp++;
+    ptp.delay_req_pending = 0;
+    ptp.delay_req_log = (int8_t) msg[PTP_OFS_LOG_INTVL];
+
+    /* No Tx time stamp was reported, stay with the software one */
+    if (ptp.delay_req_p != NULL) {
+        ptp.stats.sw_timestamps++;
+        pbuf_free(ptp.delay_req_p);
+        ptp.delay_req_p = NULL;
+    }
+
+    if (!ptp.have_ms)
+        return;
+
+    t4 = ptp_get_timestamp(msg + PTP_OFS_BODY);
+    sm_diff = t4 - ptp.t3 - ptp_get_correction(msg + PTP_OFS_CORRECTION);
+    delay = (ptp.ms_diff + sm_diff) / 2;
+    if (delay < 0) {
+        ptp.stats.rx_dropped++;
+        return;
+    }
+
+    if (!ptp.have_delay) {
+        ptp.path_delay = delay;
+        ptp.have_delay = 1;
+    } else {
+        ptp.path_delay += (delay - ptp.path_delay) / (1 << PTP_DELAY_FILTER_SHIFT);
+    }
+}
+
+/**
+ * @brief Dispatch one PTP message, p->payload points to the PTP header.
+ */
+static void ptp_input(struct pbuf *p)
+{
+    uint8_t msg[PTP_ANNOUNCE_LEN];
+    int64_t rx_time;
+    u16_t len;
+
+    len = pbuf_copy_partial(p, msg, sizeof(msg), 0);
+    if (len < PTP_HDR_LEN || (msg[PTP_OFS_VERSION] & 0x0F) != 2 ||
+        msg[PTP_OFS_DOMAIN] != PTP_DOMAIN) {
+        ptp.stats.rx_dropped++;
+        return;
+    }
+    if (ptp_get16(msg + PTP_OFS_LENGTH) < len)
+        len = ptp_get16(msg + PTP_OFS_LENGTH);
+
+    switch (msg[PTP_OFS_TYPE] & 0x0F) {
+    case PTP_MSG_ANNOUNCE:
+        ptp_handle_announce(msg, len);
+        break;
+    case PTP_MSG_SYNC:
+        rx_time = ptp_rx_time(p);
+        ptp_handle_sync(msg, len, rx_time);
+        break;
+    case PTP_MSG_FOLLOW_UP:
+        ptp_handle_follow_up(msg, len);
+        break;
+    case PTP_MSG_DELAY_RESP:
+        ptp_handle_delay_resp(msg, len);
+        break;
+    default:
+        /* Delay_Req of other slaves, management, signaling, P2P */
+        break;
+    }
+}
+
+/**
+ * @brief ethernetif_poll() callback, takes t3 of the Delay_Req.
+ */
+static void ptp_tx_ts(struct netif *netif, struct pbuf *p)
+{
+    LWIP_UNUSED_ARG(netif);
+
+    if (p != ptp.delay_req_p)
+        return;
+
+    if (p->ts_flags & ETHERNETIF_TS_TX)
+        ptp.t3 = (int64_t) p->ts_sec * PTP_NSEC_PER_SEC + p->ts_nsec;
+    else
+        ptp.stats.sw_timestamps++;
+
+    pbuf_free(p);
+    ptp.delay_req_p = NULL;
+}
+
+static void ptp_send_delay_req(void)
+{
+    struct pbuf *p;
+    uint8_t *msg;
+    err_t err;
+
+    ptp_delay_req_cancel();
+
+#if PTP_TRANSPORT_L2
+    p = pbuf_alloc(PBUF_LINK, PTP_DELAY_REQ_LEN, PBUF_RAM);
+#else
+    p = pbuf_alloc(PBUF_TRANSPORT, PTP_DELAY_REQ_LEN, PBUF_RAM);
+#endif
+    if (p == NULL)
+        return;
+
+    msg = p->payload;
+    memset(msg, 0, PTP_DELAY_REQ_LEN);
+    msg[PTP_OFS_TYPE] = PTP_MSG_DELAY_REQ;
+    msg[PTP_OFS_VERSION] = 2;
+    ptp_put16(msg + PTP_OFS_LENGTH, PTP_DELAY_REQ_LEN);
+    msg[PTP_OFS_DOMAIN] = PTP_DOMAIN;
+    memcpy(msg + PTP_OFS_SRC_PORT, ptp.port_id, PTP_PORT_ID_LEN);
+    ptp_put16(msg + PTP_OFS_SEQ, ++ptp.delay_req_seq);
+    msg[PTP_OFS_CONTROL] = 1;
+    msg[PTP_OFS_LOG_INTVL] = 0x7F;
+
+    /* Software time stamp, replaced by the EMAC one in ptp_tx_ts() */
+    ptp.t3 = ptp.clock->get_time(ptp.clock);
+    ptp_put_timestamp(msg + PTP_OFS_BODY, ptp.t3);
+
+    /* Our reference is kept for ptp_tx_ts(), IP output wants p->ref == 1 so
+     * no extra one is taken. ethernetif_poll() calls back from the main loop,
+     * never within the send. */
+    p->ts_flags |= ETHERNETIF_TS_TX_REQ;
+    ptp.delay_req_p = p;
+
+#if PTP_TRANSPORT_L2
+    err = ethernet_output(ptp.netif, p,
+                          (const struct eth_addr *) ptp.netif->hwaddr,
+                          &ptp_l2_mcast, PTP_ETHTYPE);
+#else
+    err = udp_sendto(ptp.event_pcb, p, &ptp_mcast, PTP_EVENT_PORT);
+#endif
+
+    if (err != ERR_OK) {
+        /* Drops our reference */
+        ptp_delay_req_cancel();
+        return;
+    }
+    ptp.delay_req_pending = 1;
+    ptp.stats.tx_delay_req++;
+}
+
+static void ptp_tmr(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (ptp.have_master) {
+        ptp.announce_timeout -= PTP_TMR_INTERVAL;
+        if (ptp.announce_timeout <= 0) {
+            LWIP_DEBUGF(PTP_DEBUG, ("ptp: announce receipt timeout\n"));
+            ptp_reset_master();
+        }
+    }
+
+    if (ptp.have_master && ptp.have_ms) {
+        ptp.delay_req_timer -= PTP_TMR_INTERVAL;
+        if (ptp.delay_req_timer <= 0) {
+            ptp.delay_req_timer = ptp_log_interval_ms(ptp.delay_req_log);
+            ptp_send_delay_req();
+        }
+    }
+
+    sys_timeout(PTP_TMR_INTERVAL, ptp_tmr, NULL);
+}
+
+#if !PTP_TRANSPORT_L2
+static void ptp_udp_recv(void *arg,
+                         struct udp_pcb *upcb,
+                         struct pbuf *p,
+                         const ip_addr_t *addr,
+                         u16_t port)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(upcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    ptp_input(p);
+    pbuf_free(p);
+}
+
+static struct udp_pcb *ptp_udp_open(u16_t port)
+{
+    struct udp_pcb *pcb;
+
+    pcb = udp_new_ip_type(IPADDR_TYPE_V4);
+    if (pcb == NULL)
+        return NULL;
+
+    if (udp_bind(pcb, IP4_ADDR_ANY, port) != ERR_OK) {
+        udp_remove(pcb);
+        return NULL;
+    }
+    udp_recv(pcb, ptp_udp_recv, NULL);
+    return pcb;
+}
+#endif
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void ptp_init(struct netif *netif, const struct ptp_clock *clock)
+{
+    memset(&ptp, 0, sizeof(ptp));
+    ptp.netif = netif;
+    ptp.clock = clock;
+    ptp.state = PTP_STATE_INITIALIZING;
+
+    /* EUI-64 clock identity from the MAC address, port number 1 */
+    ptp.port_id[0] = netif->hwaddr[0];
+    ptp.port_id[1] = netif->hwaddr[1];
+    ptp.port_id[2] = netif->hwaddr[2];
+    ptp.port_id[3] = 0xFF;
+    ptp.port_id[4] = 0xFE;
+    ptp.port_id[5] = netif->hwaddr[3];
+    ptp.port_id[6] = netif->hwaddr[4];
+    ptp.port_id[7] = netif->hwaddr[5];
+    ptp_put16(ptp.port_id + PTP_CLOCK_ID_LEN, 1);
+
+#if !PTP_TRANSPORT_L2
+    IP_ADDR4(&ptp_mcast, 224, 0, 1, 129);
+    ptp.event_pcb = ptp_udp_open(PTP_EVENT_PORT);
+    ptp.general_pcb = ptp_udp_open(PTP_GENERAL_PORT);
+    if (ptp.event_pcb == NULL || ptp.general_pcb == NULL) {
+        printf("[ERROR]: ptp_init: udp pcb\n");
+        ptp_set_state(PTP_STATE_FAULTY);
+        return;
+    }
+#endif
+
+    ethernetif_set_tx_ts_callback(netif, ptp_tx_ts);
+    ptp_reset_master();
+    sys_timeout(PTP_TMR_INTERVAL, ptp_tmr, NULL);
+}
+
+void ptp_get_stats(struct ptp_stats *stats, int reset)
+{
+    *stats = ptp.stats;
+    stats->state = ptp.state;
+    memcpy(stats->master_id, ptp.master.gm_id, PTP_CLOCK_ID_LEN);
+    stats->path_delay = ptp.path_delay;
+    ptp_servo_get_stats(&ptp.servo, &stats->servo, reset);
+}
+
+void ptp_print_stats(void)
+{
+    struct ptp_stats s;
+
+    ptp_get_stats(&s, 1);
+    printf("[INFO]: ptp state %d offset %ld/%ld/%ld ns jitter %ld ns "
+           "delay %ld ns freq %ld ppb steps %lu\n",
+           (int) s.state, (long) s.servo.offset_min,
+           (long) s.servo.offset_mean, (long) s.servo.offset_max,
+           (long) s.servo.offset_jitter, (long) s.path_delay,
+           (long) s.servo.freq_ppb, (unsigned long) s.servo.steps);
+}
+
+#if PTP_TRANSPORT_L2
+err_t ptp_l2_input(struct pbuf *p, struct netif *netif)
+{
+    struct eth_hdr *ethhdr = (struct eth_hdr *) p->payload;
+
+    if (netif != ptp.netif || ethhdr->type != PP_HTONS(PTP_ETHTYPE))
+        return ERR_VAL;
+
+    if (pbuf_remove_header(p, SIZEOF_ETH_HDR) == 0)
+        ptp_input(p);
+    pbuf_free(p);
+    return ERR_OK;
+}
+#endif
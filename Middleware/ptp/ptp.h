@@ -0,0 +1,126 @@
+/**
+ * @file ptp.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief IEEE 1588-2008 (PTPv2) ordinary clock, slave only.
+ *
+ * Event messages are time stamped by the EMAC, Rx stamps arrive in the pbuf
+ * (ETHERNETIF_TS_RX) and Tx stamps through ethernetif_poll(). The offset
+ * from master feeds ptp_servo, which disciplines a struct ptp_clock.
+ *
+ * ethernetif_input(), ethernetif_poll() and sys_check_timeouts() must not
+ * preempt each other, run all three from the main loop.
+ *
+ * Transport is UDP/IPv4 (ports 319/320, 224.0.1.129) by default, or raw
+ * Ethernet with PTP_TRANSPORT_L2 (see lwipopts.h).
+ */
+
+#ifndef PTP_H
+#define PTP_H
+
+#include <stdint.h>
+#include "lwip/opt.h"
+#include "lwip/err.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+
+#include "ptp_clock.h"
+#include "ptp_servo.h"
+
+/*******************************************************************************
+ * Options
+ ******************************************************************************/
+#ifndef PTP_TRANSPORT_L2
+#define PTP_TRANSPORT_L2 0
+#endif
+
+/** PTP domain number */
+#ifndef PTP_DOMAIN
+#define PTP_DOMAIN 0
+#endif
+
+/** Period of the PTP timer (ms) */
+#ifndef PTP_TMR_INTERVAL
+#define PTP_TMR_INTERVAL 100
+#endif
+
+/** Delay_Req interval (log2 s), until the master tells otherwise */
+#ifndef PTP_DELAY_REQ_INTERVAL_LOG
+#define PTP_DELAY_REQ_INTERVAL_LOG 0
+#endif
+
+/** Announce intervals without Announce before the master is dropped */
+#ifndef PTP_ANNOUNCE_RECEIPT_TIMEOUT
+#define PTP_ANNOUNCE_RECEIPT_TIMEOUT 3
+#endif
+
+/** Weight of a new path delay in the moving average, 1 / 2^n */
+#ifndef PTP_DELAY_FILTER_SHIFT
+#define PTP_DELAY_FILTER_SHIFT 3
+#endif
+
+#ifndef PTP_DEBUG
+#define PTP_DEBUG LWIP_DBG_OFF
+#endif
+
+/*******************************************************************************
+ * Types
+ ******************************************************************************/
+/** Port states, IEEE 1588-2008 9.2.5 */
+enum ptp_port_state {
+    PTP_STATE_INITIALIZING = 1,
+    PTP_STATE_FAULTY,
+    PTP_STATE_DISABLED,
+    PTP_STATE_LISTENING,
+    PTP_STATE_PRE_MASTER,
+    PTP_STATE_MASTER,
+    PTP_STATE_PASSIVE,
+    PTP_STATE_UNCALIBRATED,
+    PTP_STATE_SLAVE,
+};
+
+struct ptp_stats {
+    enum ptp_port_state state;
+    uint8_t master_id[8];        /* clock identity of the selected master */
+    int64_t path_delay;          /* filtered mean path delay (ns) */
+    struct ptp_servo_stats servo;
+    uint32_t rx_announce;
+    uint32_t rx_sync;
+    uint32_t rx_follow_up;
+    uint32_t rx_delay_resp;
+    uint32_t tx_delay_req;
+    uint32_t rx_dropped;         /* malformed, foreign domain or not master */
+    uint32_t sw_timestamps;      /* event messages without EMAC time stamp */
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+/**
+ * @brief Start the PTP slave on a netif.
+ * @param netif netif created with ethernetif_init()
+ * @param clock clock to discipline, normally &ptp_clock_emac
+ */
+void ptp_init(struct netif *netif, const struct ptp_clock *clock);
+
+/**
+ * @brief Get port and servo statistics.
+ * @param stats output
+ * @param reset start a new offset statistics window
+ */
+void ptp_get_stats(struct ptp_stats *stats, int reset);
+
+/**
+ * @brief Print ptp_get_stats() on one line and start a new window.
+ */
+void ptp_print_stats(void);
+
+#if PTP_TRANSPORT_L2
+/**
+ * @brief LWIP_HOOK_UNKNOWN_ETH_PROTOCOL handler for ethertype 0x88F7.
+ * @return ERR_OK if the pbuf was consumed
+ */
+err_t ptp_l2_input(struct pbuf *p, struct netif *netif);
+#endif
+
+#endif /* PTP_H */
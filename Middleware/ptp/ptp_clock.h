@@ -0,0 +1,37 @@
+/**
+ * @file ptp_clock.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Clock interface disciplined by the PTP servo.
+ *
+ *  - ptp_clock_emac : EMAC IEEE 1588 time stamp counter (ptp_clock_emac.c)
+ *  - a simulated clock for host tests (UnitTest/host/ptp_clock_sim.c)
+ */
+
+#ifndef PTP_CLOCK_H
+#define PTP_CLOCK_H
+
+#include <stdint.h>
+
+#define PTP_NSEC_PER_SEC 1000000000LL
+
+struct ptp_clock {
+    /** Current time in nano seconds */
+    int64_t (*get_time)(const struct ptp_clock *clk);
+    /** Add delta_ns to the current time */
+    void (*adjust_time)(const struct ptp_clock *clk, int64_t delta_ns);
+    /** Set the frequency offset against the nominal rate, in ppb */
+    void (*adjust_freq)(const struct ptp_clock *clk, int32_t ppb);
+};
+
+/*******************************************************************************
+ * EMAC time stamp clock
+ ******************************************************************************/
+extern const struct ptp_clock ptp_clock_emac;
+
+/**
+ * @brief Enable the EMAC time stamp counter, starting from 0s:0ns.
+ */
+void ptp_clock_emac_init(void);
+
+#endif /* PTP_CLOCK_H */
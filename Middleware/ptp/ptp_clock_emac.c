@@ -0,0 +1,61 @@
+/**
+ * @file ptp_clock_emac.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief PTP clock backed by the EMAC IEEE 1588 time stamp counter.
+ *
+ * Phase is stepped through EMAC_UpdateTime(). Frequency is tuned by scaling
+ * EMAC->TSADDEND, which the counter uses directly in fine update mode.
+ */
+
+#include "NuMicro.h"
+#include "ptp_clock.h"
+
+/* TSADDEND value programmed by EMAC_EnableTS() */
+static uint32_t addend_nominal;
+
+static int64_t ptp_clock_emac_get_time(const struct ptp_clock *clk)
+{
+    uint32_t sec, nsec;
+
+    (void) clk;
+    EMAC_GetTime(&sec, &nsec);
+    return (int64_t) sec * PTP_NSEC_PER_SEC + nsec;
+}
+
+static void ptp_clock_emac_adjust_time(const struct ptp_clock *clk,
+                                       int64_t delta_ns)
+{
+    uint32_t neg = 0;
+
+    (void) clk;
+    if (delta_ns < 0) {
+        neg = 1;
+        delta_ns = -delta_ns;
+    }
+    EMAC_UpdateTime(neg, (uint32_t)(delta_ns / PTP_NSEC_PER_SEC),
+                    (uint32_t)(delta_ns % PTP_NSEC_PER_SEC));
+}
+
+static void ptp_clock_emac_adjust_freq(const struct ptp_clock *clk,
+                                       int32_t ppb)
+{
+    int64_t addend;
+
+    (void) clk;
+    addend = (int64_t) addend_nominal +
+             (int64_t) addend_nominal * ppb / PTP_NSEC_PER_SEC;
+    EMAC->TSADDEND = (uint32_t) addend;
+}
+
+const struct ptp_clock ptp_clock_emac = {
+    ptp_clock_emac_get_time,
+    ptp_clock_emac_adjust_time,
+    ptp_clock_emac_adjust_freq,
+};
+
+void ptp_clock_emac_init(void)
+{
+    EMAC_EnableTS(0, 0);
+    addend_nominal = EMAC->TSADDEND;
+}
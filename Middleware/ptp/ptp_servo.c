@@ -0,0 +1,185 @@
+/**
+ * @file ptp_servo.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief PI clock servo for the PTP slave.
+ */
+
+#include <string.h>
+#include "ptp_servo.h"
+
+static int64_t ptp_servo_abs(int64_t v)
+{
+    return v < 0 ? -v : v;
+}
+
+/**
+ * @brief Integer square root, for the jitter without libm.
+ */
+static uint64_t ptp_servo_isqrt(uint64_t v)
+{
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+
+    while (bit > v)
+        bit >>= 2;
+
+    while (bit != 0) {
+        if (v >= res + bit) {
+            v -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return res;
+}
+
+static void ptp_servo_set_freq(struct ptp_servo *servo, int64_t ppb)
+{
+    if (ppb > PTP_SERVO_MAX_PPB)
+        ppb = PTP_SERVO_MAX_PPB;
+    else if (ppb < -PTP_SERVO_MAX_PPB)
+        ppb = -PTP_SERVO_MAX_PPB;
+
+    servo->freq_ppb = (int32_t) ppb;
+    servo->clock->adjust_freq(servo->clock, servo->freq_ppb);
+}
+
+static void ptp_servo_step(struct ptp_servo *servo, int64_t offset)
+{
+    servo->clock->adjust_time(servo->clock, -offset);
+    servo->steps++;
+}
+
+static void ptp_servo_record(struct ptp_servo *servo,
+                             int64_t offset,
+                             int64_t delay)
+{
+    /* Keep the squares in range, such offsets are stepped anyway */
+    if (ptp_servo_abs(offset) > PTP_SERVO_STEP_THRESHOLD)
+        return;
+
+    if (servo->n == 0 || offset < servo->min)
+        servo->min = offset;
+    if (servo->n == 0 || offset > servo->max)
+        servo->max = offset;
+    servo->n++;
+    servo->sum += offset;
+    servo->sum_sq += offset * offset;
+    servo->delay_sum += delay;
+}
+
+void ptp_servo_init(struct ptp_servo *servo,
+                    const struct ptp_clock *clock,
+                    uint32_t interval_ms)
+{
+    memset(servo, 0, sizeof(*servo));
+    servo->clock = clock;
+    servo->state = PTP_SERVO_UNLOCKED;
+    servo->interval_ms = interval_ms ? interval_ms : 1000;
+    ptp_servo_set_freq(servo, 0);
+}
+
+void ptp_servo_set_interval(struct ptp_servo *servo, uint32_t interval_ms)
+{
+    if (interval_ms)
+        servo->interval_ms = interval_ms;
+}
+
+enum ptp_servo_state ptp_servo_sample(struct ptp_servo *servo,
+                                      int64_t offset,
+                                      int64_t delay,
+                                      int64_t local)
+{
+    int64_t dt, kp, ki;
+
+    switch (servo->state) {
+    case PTP_SERVO_UNLOCKED:
+        if (!servo->have_last) {
+            servo->last_offset = offset;
+            servo->last_local = local;
+            servo->have_last = 1;
+            break;
+        }
+
+        /* Frequency error from two samples, relative to the current
+         * adjustment. The clock runs fast when the offset grows. */
+        dt = local - servo->last_local;
+        servo->have_last = 0;
+        if (dt <= 0)
+            break;
+        servo->drift = (int64_t) servo->freq_ppb * 65536 -
+                       (offset - servo->last_offset) * PTP_NSEC_PER_SEC /
+                           dt * 65536;
+        ptp_servo_set_freq(servo, servo->drift / 65536);
+        servo->drift = (int64_t) servo->freq_ppb * 65536;
+
+        if (ptp_servo_abs(offset) > PTP_SERVO_STEP_THRESHOLD) {
+            ptp_servo_step(servo, offset);
+            servo->state = PTP_SERVO_JUMP;
+        } else {
+            servo->state = PTP_SERVO_TRACKING;
+        }
+        break;
+
+    case PTP_SERVO_JUMP:
+    case PTP_SERVO_TRACKING:
+    case PTP_SERVO_LOCKED:
+        if (ptp_servo_abs(offset) > PTP_SERVO_STEP_THRESHOLD) {
+            ptp_servo_step(servo, offset);
+            servo->state = PTP_SERVO_JUMP;
+            break;
+        }
+
+        /* Gains scale with the interval: the proportional term removes
+         * kp of the offset within one interval, the integral term follows
+         * the frequency error. Units are ppb * 2^16. */
+        kp = offset * PTP_SERVO_KP_Q16 * 1000 / servo->interval_ms;
+        ki = offset * PTP_SERVO_KI_Q16 * 1000 / servo->interval_ms;
+        servo->drift -= ki;
+        if (servo->drift > (int64_t) PTP_SERVO_MAX_PPB * 65536)
+            servo->drift = (int64_t) PTP_SERVO_MAX_PPB * 65536;
+        else if (servo->drift < -(int64_t) PTP_SERVO_MAX_PPB * 65536)
+            servo->drift = -(int64_t) PTP_SERVO_MAX_PPB * 65536;
+        ptp_servo_set_freq(servo, (servo->drift - kp) / 65536);
+
+        ptp_servo_record(servo, offset, delay);
+        servo->state = ptp_servo_abs(offset) < PTP_SERVO_LOCK_THRESHOLD
+                           ? PTP_SERVO_LOCKED
+                           : PTP_SERVO_TRACKING;
+        break;
+    }
+
+    return servo->state;
+}
+
+void ptp_servo_get_stats(struct ptp_servo *servo,
+                         struct ptp_servo_stats *stats,
+                         int reset)
+{
+    int64_t var;
+
+    memset(stats, 0, sizeof(*stats));
+    stats->samples = servo->n;
+    stats->freq_ppb = servo->freq_ppb;
+    stats->steps = servo->steps;
+
+    if (servo->n) {
+        stats->offset_mean = servo->sum / servo->n;
+        stats->offset_min = servo->min;
+        stats->offset_max = servo->max;
+        stats->delay_mean = servo->delay_sum / servo->n;
+        var = servo->sum_sq / servo->n -
+              stats->offset_mean * stats->offset_mean;
+        stats->offset_jitter = (int64_t) ptp_servo_isqrt(var > 0 ? var : 0);
+    }
+
+    if (reset) {
+        servo->n = 0;
+        servo->sum = 0;
+        servo->sum_sq = 0;
+        servo->delay_sum = 0;
+    }
+}
@@ -0,0 +1,115 @@
+/**
+ * @file ptp_servo.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief PI clock servo for the PTP slave.
+ *
+ * The first two samples estimate the frequency error and step the clock,
+ * after that the offset is removed by a PI controller on the frequency.
+ * Offsets larger than PTP_SERVO_STEP_THRESHOLD step the clock again.
+ */
+
+#ifndef PTP_SERVO_H
+#define PTP_SERVO_H
+
+#include <stdint.h>
+#include "ptp_clock.h"
+
+/** Offset (ns) above which the clock is stepped instead of slewed */
+#ifndef PTP_SERVO_STEP_THRESHOLD
+#define PTP_SERVO_STEP_THRESHOLD 1000000
+#endif
+
+/** Frequency adjustment limit (ppb) */
+#ifndef PTP_SERVO_MAX_PPB
+#define PTP_SERVO_MAX_PPB 500000
+#endif
+
+/** Proportional and integral gain for a 1 second interval, Q16 */
+#ifndef PTP_SERVO_KP_Q16
+#define PTP_SERVO_KP_Q16 45875 /* 0.7 */
+#endif
+#ifndef PTP_SERVO_KI_Q16
+#define PTP_SERVO_KI_Q16 19661 /* 0.3 */
+#endif
+
+/** Offset (ns) below which the servo reports PTP_SERVO_LOCKED */
+#ifndef PTP_SERVO_LOCK_THRESHOLD
+#define PTP_SERVO_LOCK_THRESHOLD 10000
+#endif
+
+enum ptp_servo_state {
+    PTP_SERVO_UNLOCKED = 0, /* collecting samples for the first estimate */
+    PTP_SERVO_JUMP,         /* clock was stepped with the last sample */
+    PTP_SERVO_TRACKING,     /* slewing, offset above lock threshold */
+    PTP_SERVO_LOCKED,       /* slewing, offset below lock threshold */
+};
+
+/** Offset statistics since the last reset, nano seconds */
+struct ptp_servo_stats {
+    uint32_t samples;
+    int64_t offset_mean;
+    int64_t offset_min;
+    int64_t offset_max;
+    int64_t offset_jitter; /* standard deviation of the offset */
+    int64_t delay_mean;
+    int32_t freq_ppb;      /* frequency adjustment applied to the clock */
+    uint32_t steps;        /* clock steps since ptp_servo_init() */
+};
+
+struct ptp_servo {
+    const struct ptp_clock *clock;
+    enum ptp_servo_state state;
+    uint32_t interval_ms;
+    int64_t last_offset;
+    int64_t last_local;
+    int have_last;
+    int64_t drift;         /* integral term, ppb * 2^16 */
+    int32_t freq_ppb;
+    uint32_t steps;
+
+    /* statistics window */
+    uint32_t n;
+    int64_t sum;
+    int64_t sum_sq;
+    int64_t min;
+    int64_t max;
+    int64_t delay_sum;
+};
+
+/**
+ * @brief Reset the servo, the clock frequency is set to nominal.
+ * @param servo         servo instance
+ * @param clock         clock to discipline
+ * @param interval_ms   expected time between two samples
+ */
+void ptp_servo_init(struct ptp_servo *servo,
+                    const struct ptp_clock *clock,
+                    uint32_t interval_ms);
+
+/**
+ * @brief Change the sample interval, e.g. from the Sync logMessageInterval.
+ */
+void ptp_servo_set_interval(struct ptp_servo *servo, uint32_t interval_ms);
+
+/**
+ * @brief Feed one offset sample and adjust the clock.
+ * @param servo     servo instance
+ * @param offset    slave time - master time (ns)
+ * @param delay     mean path delay used for the sample (ns)
+ * @param local     slave time at which the offset was measured (ns)
+ * @return servo state after the sample
+ */
+enum ptp_servo_state ptp_servo_sample(struct ptp_servo *servo,
+                                      int64_t offset,
+                                      int64_t delay,
+                                      int64_t local);
+
+/**
+ * @brief Get offset statistics and optionally start a new window.
+ */
+void ptp_servo_get_stats(struct ptp_servo *servo,
+                         struct ptp_servo_stats *stats,
+                         int reset);
+
+#endif /* PTP_SERVO_H */
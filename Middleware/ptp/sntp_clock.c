@@ -0,0 +1,101 @@
+/**
+ * @file sntp_clock.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Clock disciplined by the SNTP client, high precision mode.
+ *
+ * sntp.c passes an offset on only when its best server has a sample not
+ * used before, so the servo interval is the time since the last update. The
+ * least delay sample can be up to SNTP_FILTER_SIZE polls old, the servo gains
+ * are kept as for one update per SNTP_CLOCK_TIME_CONST_MS, or the offsets it
+ * corrects have long changed when the next update comes.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lwip/apps/sntp_opts.h"
+
+#include "ethernetif.h"
+#include "sntp_clock.h"
+
+/** Shortest servo interval (ms) */
+#ifndef SNTP_CLOCK_TIME_CONST_MS
+#define SNTP_CLOCK_TIME_CONST_MS (SNTP_FILTER_SIZE * SNTP_POLL_INTERVAL)
+#endif
+
+static struct {
+    const struct ptp_clock *clock;
+    struct ptp_servo servo;
+    int64_t last_local;
+    struct sntp_clock_stats stats;
+} sc;
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void sntp_clock_init(const struct ptp_clock *clock)
+{
+    memset(&sc, 0, sizeof(sc));
+    sc.clock = clock;
+    ptp_servo_init(&sc.servo, clock, SNTP_CLOCK_TIME_CONST_MS);
+}
+
+int64_t sntp_clock_get_time(void)
+{
+    return sc.clock->get_time(sc.clock);
+}
+
+int sntp_clock_pbuf_time(const struct pbuf *p, s64_t *t)
+{
+    if (!(p->ts_flags & (ETHERNETIF_TS_RX | ETHERNETIF_TS_TX))) {
+        sc.stats.sw_timestamps++;
+        return 0;
+    }
+    *t = (s64_t) p->ts_sec * PTP_NSEC_PER_SEC + p->ts_nsec;
+    return 1;
+}
+
+void sntp_clock_tx_request(struct pbuf *p)
+{
+    p->ts_flags |= ETHERNETIF_TS_TX_REQ;
+}
+
+int sntp_clock_update(int64_t offset, int64_t delay, int64_t local)
+{
+    int64_t interval_ms = (local - sc.last_local) / 1000000;
+
+    if (interval_ms < SNTP_CLOCK_TIME_CONST_MS)
+        interval_ms = SNTP_CLOCK_TIME_CONST_MS;
+    if (sc.last_local != 0)
+        ptp_servo_set_interval(&sc.servo, (uint32_t) interval_ms);
+    sc.stats.updates++;
+
+    if (ptp_servo_sample(&sc.servo, offset, delay, local) == PTP_SERVO_JUMP) {
+        /* the next interval starts on the new time scale */
+        sc.last_local = 0;
+        return 1;
+    }
+    sc.last_local = local;
+    return 0;
+}
+
+void sntp_clock_get_stats(struct sntp_clock_stats *stats, int reset)
+{
+    *stats = sc.stats;
+    ptp_servo_get_stats(&sc.servo, &stats->servo, reset);
+}
+
+void sntp_clock_print_stats(void)
+{
+    struct sntp_clock_stats s;
+
+    sntp_clock_get_stats(&s, 1);
+    printf("[INFO]: sntp state %d offset %ld/%ld/%ld ns jitter %ld ns "
+           "delay %ld ns freq %ld ppb steps %lu updates %lu sw stamps %lu\n",
+           (int) sc.servo.state, (long) s.servo.offset_min,
+           (long) s.servo.offset_mean, (long) s.servo.offset_max,
+           (long) s.servo.offset_jitter, (long) s.servo.delay_mean,
+           (long) s.servo.freq_ppb, (unsigned long) s.servo.steps,
+           (unsigned long) s.updates, (unsigned long) s.sw_timestamps);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file sntp_clock.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Clock disciplined by the SNTP client, high precision mode.
+ *
+ * Implements the SNTP_HIGH_PRECISION hooks of sntp.c (see lwipopts.h). The
+ * requests and responses are time stamped by the EMAC like the PTP event
+ * messages (ETHERNETIF_TS_TX_REQ / ETHERNETIF_TS_RX), the offset sntp.c
+ * combines from its servers feeds a ptp_servo, which slews the clock. Only
+ * the first update, and offsets beyond PTP_SERVO_STEP_THRESHOLD, step it.
+ *
+ * The clock counts nanoseconds since 1970. ptp_init() and sntp_clock_init()
+ * must not discipline the same clock.
+ *
+ * Transmit stamps are stored by ethernetif_poll(). Run it, ethernetif_input()
+ * and sys_check_timeouts() from the main loop, ethernetif_poll() first.
+ *
+ *   ptp_clock_emac_init();
+ *   sntp_clock_init(&ptp_clock_emac);
+ *   sntp_setserver(0, &server);
+ *   sntp_init();
+ */
+
+#ifndef SNTP_CLOCK_H
+#define SNTP_CLOCK_H
+
+#include <stdint.h>
+#include "lwip/pbuf.h"
+
+#include "ptp_clock.h"
+#include "ptp_servo.h"
+
+struct sntp_clock_stats {
+    struct ptp_servo_stats servo;
+    uint32_t updates;       /* offsets passed on by sntp.c */
+    uint32_t sw_timestamps; /* requests or responses without EMAC time stamp */
+};
+
+/**
+ * @brief Start disciplining a clock, the frequency is set to nominal.
+ * @param clock clock to discipline, normally &ptp_clock_emac
+ */
+void sntp_clock_init(const struct ptp_clock *clock);
+
+/**
+ * @brief SNTP_GET_TIME_NS(), the clock in nanoseconds.
+ */
+int64_t sntp_clock_get_time(void);
+
+/**
+ * @brief SNTP_PBUF_TIME_NS(), the EMAC time stamp of a pbuf.
+ * @param t set to the time stamp in nanoseconds, s64_t like the sntp.c
+ *          samples
+ * @return 1 if *t was set, 0 if the pbuf has none
+ */
+int sntp_clock_pbuf_time(const struct pbuf *p, s64_t *t);
+
+/**
+ * @brief SNTP_TX_TIMESTAMP_REQ(), have the EMAC time stamp a request.
+ */
+void sntp_clock_tx_request(struct pbuf *p);
+
+/**
+ * @brief SNTP_UPDATE_CLOCK(), feed the servo.
+ * @param offset clock minus the servers (ns)
+ * @param delay  round-trip delay of the sample (ns)
+ * @param local  clock when the sample was taken (ns)
+ * @return 1 if the clock was stepped
+ */
+int sntp_clock_update(int64_t offset, int64_t delay, int64_t local);
+
+/**
+ * @brief Get servo statistics and optionally start a new window.
+ */
+void sntp_clock_get_stats(struct sntp_clock_stats *stats, int reset);
+
+/**
+ * @brief Print sntp_clock_get_stats() on one line and start a new window.
+ */
+void sntp_clock_print_stats(void);
+
+#endif /* SNTP_CLOCK_H */
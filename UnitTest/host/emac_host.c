@@ -0,0 +1,183 @@
+/**
+ * @file emac_host.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Firmware network stack on the EMAC register model, attached to a
+ *        Linux TAP interface or replaying a pcap capture.
+ *
+ *   emac_host -i tap0 [-w out.pcap]      ping / UDP echo on 192.168.0.23
+ *   emac_host -r in.pcap [-w out.pcap]   replay frames at their time stamps
+ *
+ * Like Core/main.c the stack runs ethernetif.c and emac.c with the UDP echo
+ * server on port 7.
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "NuMicro.h"
+#include "emac_model.h"
+#include "emac_pcap.h"
+#include "emac_tap.h"
+#include "m487_sys.h"
+
+#include "ethernetif.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include "udpecho_raw.h"
+
+#define TAP_POLL_MS 10
+
+struct netif gnetif;
+
+static FILE *cap;
+static int tap_fd = -1;
+
+void EMAC_RX_IRQHandler(void)
+{
+    ethernetif_input(&gnetif);
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    // Clean up Tx resource occupied by previous sent.
+    ethernetif_tx_done(&gnetif);
+}
+
+static void host_tx(void *arg, const uint8_t *frame, uint32_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (tap_fd >= 0)
+        emac_tap_write(tap_fd, frame, len);
+    if (cap != NULL)
+        emac_pcap_write(cap, frame, len, m487_sys_time_ns());
+}
+
+static void host_rx(const uint8_t *frame, uint32_t len)
+{
+    if (cap != NULL)
+        emac_pcap_write(cap, frame, len, m487_sys_time_ns());
+    emac_model_rx(frame, len);
+}
+
+static uint64_t mono_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+static void lwip_layer_init(void)
+{
+    ip4_addr_t ipaddr, netmask, gw;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 23);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    lwip_init();
+    netif_add(&gnetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+    netif_set_default(&gnetif);
+    netif_set_up(&gnetif);
+}
+
+static int run_tap(void)
+{
+    uint8_t frame[EMAC_MAX_PKT_SIZE];
+    uint64_t last = mono_ns(), now;
+    int len;
+
+    for (;;) {
+        len = emac_tap_read(tap_fd, frame, sizeof(frame), TAP_POLL_MS);
+        if (len < 0)
+            return 1;
+        now = mono_ns();
+        while (now - last >= 1000000ULL) {
+            m487_sys_advance(1000000);
+            last += 1000000ULL;
+        }
+        if (len > 0)
+            host_rx(frame, (uint32_t) len);
+        sys_check_timeouts();
+    }
+    return 0;
+}
+
+static int run_replay(const char *path)
+{
+    uint8_t frame[EMAC_MAX_PKT_SIZE];
+    uint64_t ts, base = 0;
+    uint32_t len, n = 0;
+    FILE *in = emac_pcap_open(path);
+
+    if (in == NULL)
+        return 1;
+
+    while ((len = emac_pcap_read(in, frame, sizeof(frame), &ts)) > 0) {
+        if (n++ == 0)
+            base = ts;
+        /* Virtual time follows the capture in 1 ms steps */
+        while (m487_sys_time_ns() + 1000000ULL <= ts - base) {
+            m487_sys_advance(1000000);
+            sys_check_timeouts();
+        }
+        host_rx(frame, len);
+    }
+    fclose(in);
+    printf("[INFO]: replayed %u frames, sent %u\n", n,
+           emac_model_get_stats()->tx_frames);
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    const char *ifname = NULL, *rd = NULL, *wr = NULL;
+    int opt, ret;
+
+    while ((opt = getopt(argc, argv, "i:r:w:")) != -1) {
+        switch (opt) {
+        case 'i':
+            ifname = optarg;
+            break;
+        case 'r':
+            rd = optarg;
+            break;
+        case 'w':
+            wr = optarg;
+            break;
+        default:
+            break;
+        }
+    }
+    if ((ifname == NULL) == (rd == NULL)) {
+        printf("usage: %s -i tap0 | -r in.pcap [-w out.pcap]\n", argv[0]);
+        return 1;
+    }
+
+    if (wr != NULL && (cap = emac_pcap_create(wr)) == NULL)
+        return 1;
+    if (ifname != NULL) {
+        tap_fd = emac_tap_open(ifname);
+        if (tap_fd < 0)
+            return 1;
+        printf("[INFO]: attached to %s\n", ifname);
+    }
+
+    emac_model_reset();
+    emac_model_set_tx_fn(host_tx, NULL);
+    lwip_layer_init();
+    udpecho_raw_init();
+
+    ret = ifname ? run_tap() : run_replay(rd);
+
+    if (cap != NULL)
+        fclose(cap);
+    return ret;
+}
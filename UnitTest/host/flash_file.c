@@ -0,0 +1,193 @@
+/**
+ * @file flash_file.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief File-backed stand-in of the w25q128jv for host tests.
+ */
+
+#include <string.h>
+#include "flash_file.h"
+
+static struct flash_file *flash_file_of(const struct flash_dev *dev)
+{
+    return (struct flash_file *) dev;
+}
+
+static int flash_file_copy(struct flash_file *ff, uint32_t addr,
+                           uint8_t *buf, uint32_t len)
+{
+    if (addr + len > ff->dev.size || fseek(ff->f, addr, SEEK_SET) ||
+        fread(buf, 1, len, ff->f) != len)
+        return -1;
+    ff->reads++;
+    ff->read_ns += FLASH_FILE_READ_NS(len);
+    return 0;
+}
+
+/* The DMA of a started read, the buffer is filled when it ends */
+static void flash_file_complete(struct flash_file *ff)
+{
+    if (ff->pending.buf == NULL)
+        return;
+    flash_file_copy(ff, ff->pending.addr, ff->pending.buf, ff->pending.len);
+    ff->pending.buf = NULL;
+}
+
+static int flash_file_busy(const struct flash_dev *dev)
+{
+    struct flash_file *ff = flash_file_of(dev);
+
+    if (ff->now_ns() < ff->busy_until)
+        return 1;
+    flash_file_complete(ff);
+    return 0;
+}
+
+static int flash_file_fill(struct flash_file *ff, uint32_t addr,
+                           uint8_t value, uint32_t len)
+{
+    uint8_t buf[4096];
+    uint32_t n;
+
+    memset(buf, value, sizeof(buf));
+    if (fseek(ff->f, addr, SEEK_SET))
+        return -1;
+    for (; len > 0; len -= n) {
+        n = len < sizeof(buf) ? len : sizeof(buf);
+        if (fwrite(buf, 1, n, ff->f) != n)
+            return -1;
+    }
+    return 0;
+}
+
+static int flash_file_erase(const struct flash_dev *dev, uint32_t addr,
+                            uint32_t len)
+{
+    struct flash_file *ff = flash_file_of(dev);
+
+    if ((len != dev->sector_size && len != dev->block_size) ||
+        (addr & (len - 1)) || addr + len > dev->size || flash_file_busy(dev))
+        return -1;
+    if (flash_file_fill(ff, addr, 0xFF, len))
+        return -1;
+
+    if (len == dev->block_size) {
+        ff->block_erases++;
+        ff->busy_until = ff->now_ns() + FLASH_FILE_BLOCK_NS;
+    } else {
+        ff->sector_erases++;
+        ff->busy_until = ff->now_ns() + FLASH_FILE_SECTOR_NS;
+    }
+    return 0;
+}
+
+static int flash_file_program(const struct flash_dev *dev, uint32_t addr,
+                              const uint8_t *data, uint32_t len)
+{
+    struct flash_file *ff = flash_file_of(dev);
+    uint8_t old[256];
+    uint32_t i;
+
+    if (len == 0 || (addr & (dev->page_size - 1)) + len > dev->page_size ||
+        addr + len > dev->size || flash_file_busy(dev))
+        return -1;
+    if (fseek(ff->f, addr, SEEK_SET) || fread(old, 1, len, ff->f) != len)
+        return -1;
+    /* NOR programming only clears bits */
+    for (i = 0; i < len; i++) {
+        if (old[i] != 0xFF)
+            ff->not_erased++;
+        old[i] &= data[i];
+    }
+    if (fseek(ff->f, addr, SEEK_SET) || fwrite(old, 1, len, ff->f) != len)
+        return -1;
+
+    ff->programs++;
+    ff->busy_until = ff->now_ns() + FLASH_FILE_PROGRAM_NS;
+    return 0;
+}
+
+/* No time passes here, unlike flash_w25q it does not wait for busy */
+static int flash_file_read(const struct flash_dev *dev, uint32_t addr,
+                           uint8_t *buf, uint32_t len)
+{
+    struct flash_file *ff = flash_file_of(dev);
+
+    flash_file_complete(ff);
+    return flash_file_copy(ff, addr, buf, len);
+}
+
+static int flash_file_read_start(const struct flash_dev *dev, uint32_t addr,
+                                 uint8_t *buf, uint32_t len)
+{
+    struct flash_file *ff = flash_file_of(dev);
+
+    if (len == 0 || addr + len > dev->size || flash_file_busy(dev))
+        return -1;
+    ff->pending.buf = buf;
+    ff->pending.addr = addr;
+    ff->pending.len = len;
+    ff->reads_started++;
+    ff->busy_until = ff->now_ns() + (ff->read_latency_ns
+                                         ? ff->read_latency_ns
+                                         : FLASH_FILE_READ_NS(len));
+    return 0;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int flash_file_open(struct flash_file *ff, const char *path, uint32_t size,
+                    uint64_t (*now_ns)(void))
+{
+    memset(ff, 0, sizeof(*ff));
+    ff->dev.size = size;
+    ff->dev.page_size = 256;
+    ff->dev.sector_size = 4096;
+    ff->dev.block_size = 65536;
+    ff->dev.erase = flash_file_erase;
+    ff->dev.program = flash_file_program;
+    ff->dev.busy = flash_file_busy;
+    ff->dev.read = flash_file_read;
+    ff->dev.read_start = flash_file_read_start;
+    ff->now_ns = now_ns;
+
+    ff->f = path != NULL ? fopen(path, "w+b") : tmpfile();
+    if (ff->f == NULL)
+        return -1;
+    if (flash_file_fill(ff, 0, 0xFF, size)) {
+        fclose(ff->f);
+        ff->f = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+int flash_file_load(struct flash_file *ff, uint32_t addr, const char *path)
+{
+    uint8_t buf[4096];
+    uint32_t total = 0;
+    size_t n;
+    FILE *f = fopen(path, "rb");
+
+    if (f == NULL)
+        return -1;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0) {
+        if (addr + total + n > ff->dev.size ||
+            fseek(ff->f, addr + total, SEEK_SET) ||
+            fwrite(buf, 1, n, ff->f) != n) {
+            fclose(f);
+            return -1;
+        }
+        total += n;
+    }
+    fclose(f);
+    return (int) total;
+}
+
+void flash_file_close(struct flash_file *ff)
+{
+    if (ff->f != NULL)
+        fclose(ff->f);
+    ff->f = NULL;
+}
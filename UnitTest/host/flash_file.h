@@ -0,0 +1,67 @@
+/**
+ * @file flash_file.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief File-backed stand-in of the w25q128jv for host tests.
+ *
+ * Same geometry as flash_w25q, erase and program take the typical times of
+ * the datasheet on the clock passed in. Programming a byte that is not
+ * erased is counted, it would not read back on NOR flash. Reads take no
+ * time on the clock, their time at the 48 MHz SPI clock of flash_w25q is
+ * summed up in read_ns. A read_start() does take time, read_latency_ns or
+ * the one at 48 MHz if 0, the data lands in the buffer when busy() turns 0
+ * as it does by DMA.
+ */
+
+#ifndef FLASH_FILE_H
+#define FLASH_FILE_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "flash_dev.h"
+
+#define FLASH_FILE_PROGRAM_NS  400000ULL    /* page program */
+#define FLASH_FILE_SECTOR_NS   45000000ULL  /* 4 KiB erase */
+#define FLASH_FILE_BLOCK_NS    150000000ULL /* 64 KiB erase */
+
+/* Fast read, command, address and dummy byte then the data, 8 bits each */
+#define FLASH_FILE_READ_NS(len) (((len) + 5) * 8 * 1000ULL / 48)
+
+struct flash_file {
+    struct flash_dev dev;  /* must be first */
+    FILE *f;
+    uint64_t (*now_ns)(void);
+    uint64_t busy_until;   /* ns, end of the running erase or program */
+    uint32_t programs;
+    uint32_t sector_erases;
+    uint32_t block_erases;
+    uint32_t not_erased;   /* bytes programmed without an erase */
+    uint32_t reads;
+    uint64_t read_ns;      /* sum of FLASH_FILE_READ_NS() */
+    uint64_t read_latency_ns; /* of read_start(), 0 for FLASH_FILE_READ_NS() */
+    uint32_t reads_started;
+    struct {
+        uint8_t *buf;      /* NULL if no read started */
+        uint32_t addr;
+        uint32_t len;
+    } pending;
+};
+
+/**
+ * @brief Create an erased flash of size bytes in the file at path, or in an
+ *        anonymous temporary file if path is NULL.
+ * @return 0, -1 if the file cannot be written
+ */
+int flash_file_open(struct flash_file *ff, const char *path, uint32_t size,
+                    uint64_t (*now_ns)(void));
+
+/**
+ * @brief Write the contents of the file at path to addr, as if it was
+ *        programmed before.
+ * @return bytes written, -1 if the file cannot be read or does not fit
+ */
+int flash_file_load(struct flash_file *ff, uint32_t addr, const char *path);
+
+void flash_file_close(struct flash_file *ff);
+
+#endif /* FLASH_FILE_H */
@@ -0,0 +1,63 @@
+/**
+ * @file NuMicro.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host replacement of the M480 device header.
+ *
+ * Only the parts used by emac.c and ethernetif.c are provided. The EMAC
+ * register block is a plain structure which is kept coherent by the model
+ * in emac_model.c, the macros which kick the DMA engine are routed to the
+ * model as well.
+ */
+
+#ifndef __NUMICRO_H__
+#define __NUMICRO_H__
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Core
+ ******************************************************************************/
+#define __I  volatile const
+#define __O  volatile
+#define __IO volatile
+
+#define BIT31 0x80000000UL
+
+typedef enum {
+    EMAC_TX_IRQn = 66,
+    EMAC_RX_IRQn = 67,
+} IRQn_Type;
+
+extern uint32_t SystemCoreClock;
+
+uint32_t CLK_GetHCLKFreq(void);
+void NVIC_EnableIRQ(IRQn_Type IRQn);
+void NVIC_DisableIRQ(IRQn_Type IRQn);
+
+/*******************************************************************************
+ * EMAC
+ ******************************************************************************/
+#include "emac_reg.h"
+
+extern EMAC_T emac_model_regs;
+#define EMAC (&emac_model_regs)
+
+#include "emac.h"
+#include "emac_model.h"
+
+#undef EMAC_ENABLE_TX
+#undef EMAC_ENABLE_RX
+#undef EMAC_DISABLE_TX
+#undef EMAC_DISABLE_RX
+#undef EMAC_TRIGGER_RX
+#undef EMAC_TRIGGER_TX
+
+#define EMAC_ENABLE_TX()  emac_model_enable_tx()
+#define EMAC_ENABLE_RX()  emac_model_enable_rx()
+#define EMAC_DISABLE_TX() emac_model_disable_tx()
+#define EMAC_DISABLE_RX() emac_model_disable_rx()
+#define EMAC_TRIGGER_RX() emac_model_trigger_rx()
+#define EMAC_TRIGGER_TX() emac_model_trigger_tx()
+
+#endif /* __NUMICRO_H__ */
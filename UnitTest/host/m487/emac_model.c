@@ -0,0 +1,505 @@
+/**
+ * @file emac_model.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host model of the M487 EMAC register block and DMA engine.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "emac_model.h"
+
+/* Descriptor layout shared by emac.c and ethernetif.c */
+struct emac_desc {
+    uint32_t status1;
+    uint32_t data;
+    uint32_t status2;
+    uint32_t next;
+    uint32_t backup1;
+    uint32_t backup2;
+};
+
+#define DESC_OWN_EMAC 0x80000000UL
+
+/* Rx status word 1 */
+#define RXFD_RTSAS  0x00800000UL
+#define RXFD_RXGD   0x00100000UL
+#define RXFD_PTLE   0x00080000UL
+#define RXFD_RXINTR 0x00010000UL
+
+/* Tx status word 1 control and status word 2 */
+#define TXFD_TTSEN  0x08UL
+#define TXFD_INTEN  0x04UL
+#define TXFD_PADEN  0x01UL
+#define TXFD_TXINTR 0x00010000UL
+#define TXFD_TXCP   0x00080000UL
+#define TXFD_TTSAS  0x08000000UL
+
+/* Reserved INTSTS bits used to detect write one to clear accesses */
+#define INTSTS_MARK_RX 0x00002000UL
+#define INTSTS_MARK_TX 0x80000000UL
+#define INTSTS_MARK    (INTSTS_MARK_RX | INTSTS_MARK_TX)
+
+#define INTSTS_RX_LINE 0x0000FFFFUL
+#define INTSTS_TX_LINE 0xFFFF0000UL
+
+/* Reasons for a halted DMA engine */
+#define HALT_RDU 1
+#define HALT_BUS 2
+
+/* Handler calls in a row before the request is considered stuck */
+#define IRQ_STORM_LIMIT 64
+
+#define MIN_FRAME_SIZE 60
+
+/* Access to read only fields of the register block */
+#define REG(r) (*(volatile uint32_t *) &EMAC->r)
+
+EMAC_T emac_model_regs;
+
+static struct {
+    uint32_t intsts;       /* pending interrupt status */
+    uint32_t intsts_shown; /* value last written to EMAC->INTSTS */
+    uint32_t intsts_hist;  /* every bit raised since reset */
+    uint8_t nvic[2];
+    uint8_t irq_active;
+    uint8_t irq_masked;
+    uint8_t rx_halt;
+    uint8_t tx_halt;
+    uint8_t tx_hold;
+    uint64_t ts_ns; /* time stamp counter */
+    double ts_frac;
+    emac_model_tx_fn tx_fn;
+    void *tx_arg;
+    struct emac_model_stats stats;
+} model;
+
+/*******************************************************************************
+ * Private Function
+ ******************************************************************************/
+
+static struct emac_desc *desc_at(uint32_t addr)
+{
+    return (struct emac_desc *) (uintptr_t) addr;
+}
+
+static uint32_t nsec2subsec(uint32_t nsec)
+{
+    return (uint32_t)(((uint64_t) nsec << 31) / 1000000000ULL);
+}
+
+static uint32_t subsec2nsec(uint32_t subsec)
+{
+    return (uint32_t)((1000000000ULL * subsec) >> 31);
+}
+
+static void ts_write_regs(void)
+{
+    REG(TSSEC) = (uint32_t)(model.ts_ns / 1000000000ULL);
+    REG(TSSUBSEC) = nsec2subsec((uint32_t)(model.ts_ns % 1000000000ULL));
+}
+
+/**
+ * Apply the TSCTL commands the driver has written since the last call.
+ */
+static void ts_sync(void)
+{
+    uint64_t upd;
+
+    if (!(EMAC->TSCTL & EMAC_TSCTL_TSEN_Msk))
+        return;
+
+    upd = (uint64_t) EMAC->UPDSEC * 1000000000ULL +
+          subsec2nsec(EMAC->UPDSUBSEC & ~BIT31);
+
+    if (EMAC->TSCTL & EMAC_TSCTL_TSIEN_Msk) {
+        /* Initialize, EMAC_EnableTS() and EMAC_SetTime() */
+        model.ts_ns = upd;
+        EMAC->TSCTL &= ~(EMAC_TSCTL_TSIEN_Msk | EMAC_TSCTL_TSUPDATE_Msk);
+    } else if (EMAC->TSCTL & EMAC_TSCTL_TSUPDATE_Msk) {
+        /* Add or subtract, EMAC_UpdateTime() */
+        if (EMAC->UPDSUBSEC & BIT31)
+            model.ts_ns -= upd;
+        else
+            model.ts_ns += upd;
+        EMAC->TSCTL &= ~EMAC_TSCTL_TSUPDATE_Msk;
+    }
+    ts_write_regs();
+}
+
+/**
+ * Fold driver writes of INTSTS into the pending status and show the
+ * pending status with the marker bits again.
+ */
+static void intsts_sync(void)
+{
+    uint32_t reg = EMAC->INTSTS;
+
+    if (reg != model.intsts_shown)
+        model.intsts &= ~(reg & ~INTSTS_MARK);
+
+    model.intsts_shown = model.intsts | INTSTS_MARK;
+    EMAC->INTSTS = model.intsts_shown;
+}
+
+static void sync(void)
+{
+    intsts_sync();
+    ts_sync();
+}
+
+static void raise(uint32_t flags)
+{
+    model.intsts |= flags;
+    model.intsts_hist |= flags;
+    model.intsts_shown = model.intsts | INTSTS_MARK;
+    EMAC->INTSTS = model.intsts_shown;
+}
+
+/**
+ * Call the interrupt handlers while an enabled request is pending.
+ */
+static void dispatch(void)
+{
+    uint32_t pending, n;
+
+    if (model.irq_active)
+        return;
+
+    for (n = 0; n < IRQ_STORM_LIMIT; n++) {
+        sync();
+        if (model.irq_masked)
+            return;
+
+        pending = model.intsts & EMAC->INTEN;
+
+        model.irq_active = 1;
+        if ((pending & INTSTS_RX_LINE) && model.nvic[0]) {
+            model.stats.irq_rx++;
+            EMAC_RX_IRQHandler();
+        } else if ((pending & INTSTS_TX_LINE) && model.nvic[1]) {
+            model.stats.irq_tx++;
+            EMAC_TX_IRQHandler();
+        } else {
+            model.irq_active = 0;
+            return;
+        }
+        model.irq_active = 0;
+    }
+    printf("[ERROR]: EMAC interrupt 0x%08x not cleared by handler\n",
+           (unsigned) (model.intsts & EMAC->INTEN));
+}
+
+/**
+ * CAM filter of the destination address.
+ */
+static int rx_accept(const uint8_t *frame)
+{
+    volatile uint32_t *cam = &EMAC->CAM0M;
+    uint32_t msw, lsw, i;
+
+    if (memcmp(frame, "\xff\xff\xff\xff\xff\xff", 6) == 0)
+        return EMAC->CAMCTL & EMAC_CAMCTL_ABP_Msk;
+    if (frame[0] & 0x01)
+        return EMAC->CAMCTL & EMAC_CAMCTL_AMP_Msk;
+    if (EMAC->CAMCTL & EMAC_CAMCTL_AUP_Msk)
+        return 1;
+    if (!(EMAC->CAMCTL & EMAC_CAMCTL_CMPEN_Msk))
+        return 0;
+
+    msw = ((uint32_t) frame[0] << 24) | ((uint32_t) frame[1] << 16) |
+          ((uint32_t) frame[2] << 8) | frame[3];
+    lsw = ((uint32_t) frame[4] << 24) | ((uint32_t) frame[5] << 16);
+    for (i = 0; i < EMAC_CAMENTRY_NB; i++) {
+        if ((EMAC->CAMEN & (1UL << i)) && cam[2 * i] == msw &&
+            cam[2 * i + 1] == lsw)
+            return 1;
+    }
+    return 0;
+}
+
+/**
+ * Walk the Tx descriptors owned by the EMAC.
+ */
+static void tx_process(void)
+{
+    struct emac_desc *desc;
+    uint8_t frame[EMAC_MAX_PKT_SIZE];
+    uint32_t len, next, status;
+
+    if (!(EMAC->CTL & EMAC_CTL_TXON_Msk) || model.tx_halt || model.tx_hold)
+        return;
+
+    for (;;) {
+        desc = desc_at(EMAC->CTXDSA);
+        if (!(desc->status1 & DESC_OWN_EMAC)) {
+            raise(EMAC_INTSTS_TDUIF_Msk);
+            break;
+        }
+
+        len = desc->status2 & 0xFFFF;
+        if (len > sizeof(frame))
+            len = sizeof(frame);
+        memcpy(frame, desc_at(desc->data), len);
+        if ((desc->status1 & TXFD_PADEN) && len < MIN_FRAME_SIZE) {
+            memset(frame + len, 0, MIN_FRAME_SIZE - len);
+            len = MIN_FRAME_SIZE;
+        }
+        REG(CTXBSA) = desc->data;
+
+        if (model.tx_fn != NULL)
+            model.tx_fn(model.tx_arg, frame, len);
+        model.stats.tx_frames++;
+
+        /* Next pointer is fetched before the time stamp overwrites it */
+        next = desc->next;
+        status = TXFD_TXCP | (desc->status2 & 0xFFFF);
+        if (desc->status1 & TXFD_INTEN)
+            status |= TXFD_TXINTR;
+        if ((desc->status1 & TXFD_TTSEN) &&
+            (EMAC->TSCTL & EMAC_TSCTL_TSEN_Msk)) {
+            desc->data = EMAC->TSSUBSEC;
+            desc->next = EMAC->TSSEC;
+            status |= TXFD_TTSAS;
+        }
+        desc->status2 = status;
+        desc->status1 &= ~DESC_OWN_EMAC;
+
+        if (next <= EMAC->CTXDSA)
+            model.stats.tx_wraps++;
+        REG(CTXDSA) = next;
+
+        raise(EMAC_INTSTS_TXCPIF_Msk |
+              ((status & TXFD_TXINTR) ? EMAC_INTSTS_TXIF_Msk : 0));
+    }
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void emac_model_reset(void)
+{
+    memset((void *) &emac_model_regs, 0, sizeof(emac_model_regs));
+    memset(&model, 0, sizeof(model));
+    sync();
+}
+
+void emac_model_set_tx_fn(emac_model_tx_fn fn, void *arg)
+{
+    model.tx_fn = fn;
+    model.tx_arg = arg;
+}
+
+int emac_model_rx(const uint8_t *frame, uint32_t len)
+{
+    struct emac_desc *desc;
+    uint32_t next, status;
+
+    sync();
+
+    if (!(EMAC->CTL & EMAC_CTL_RXON_Msk) || len < 14)
+        return -1;
+
+    if (!rx_accept(frame)) {
+        model.stats.rx_filter++;
+        return -1;
+    }
+
+    if (model.rx_halt) {
+        model.stats.rx_missed++;
+        REG(MPCNT)++;
+        return -1;
+    }
+
+    desc = desc_at(EMAC->CRXDSA);
+    if (!(desc->status1 & DESC_OWN_EMAC)) {
+        /* Rx descriptor unavailable, DMA halts until EMAC_TRIGGER_RX() */
+        model.rx_halt = HALT_RDU;
+        model.stats.rdu++;
+        model.stats.rx_missed++;
+        REG(MPCNT)++;
+        raise(EMAC_INTSTS_RDUIF_Msk | EMAC_INTSTS_RXIF_Msk);
+        dispatch();
+        return -1;
+    }
+
+    if (len > EMAC->MRFL) {
+        len = EMAC->MRFL;
+        status = RXFD_PTLE;
+    } else {
+        status = RXFD_RXGD;
+    }
+    memcpy(desc_at(desc->data), frame, len);
+    REG(CRXBSA) = desc->data;
+
+    next = desc->next;
+    status |= RXFD_RXINTR | len;
+    if (EMAC->TSCTL & EMAC_TSCTL_TSEN_Msk) {
+        desc->data = EMAC->TSSUBSEC;
+        desc->next = EMAC->TSSEC;
+        status |= RXFD_RTSAS;
+    }
+    desc->status1 = status;
+
+    if (next <= EMAC->CRXDSA)
+        model.stats.rx_wraps++;
+    REG(CRXDSA) = next;
+    REG(RPCNT)++;
+    model.stats.rx_frames++;
+
+    raise(EMAC_INTSTS_RXIF_Msk |
+          ((status & RXFD_RXGD) ? EMAC_INTSTS_RXGDIF_Msk : 0));
+    dispatch();
+    return 0;
+}
+
+void emac_model_tx_hold(int hold)
+{
+    model.tx_hold = hold;
+    if (!hold) {
+        sync();
+        tx_process();
+        dispatch();
+    }
+}
+
+void emac_model_bus_error(int tx)
+{
+    sync();
+    model.stats.bus_errors++;
+    if (tx) {
+        model.tx_halt = HALT_BUS;
+        raise(EMAC_INTSTS_TXBEIF_Msk | EMAC_INTSTS_TXIF_Msk);
+    } else {
+        model.rx_halt = HALT_BUS;
+        raise(EMAC_INTSTS_RXBEIF_Msk | EMAC_INTSTS_RXIF_Msk);
+    }
+    dispatch();
+}
+
+void emac_model_irq_mask(int mask)
+{
+    model.irq_masked = mask;
+    dispatch();
+}
+
+void emac_model_advance(uint32_t ns)
+{
+    double addend, nominal;
+
+    sync();
+    if (EMAC->TSCTL & EMAC_TSCTL_TSEN_Msk) {
+        /* Counter runs at TSADDEND relative to the value of EMAC_EnableTS() */
+        addend = EMAC->TSADDEND;
+        nominal = EMAC->TSINC ? 9223372036854775808.0 /
+                                    ((double) CLK_GetHCLKFreq() * EMAC->TSINC)
+                              : 0.0;
+        if (nominal > 0.0)
+            model.ts_frac += (double) ns * addend / nominal;
+        else
+            model.ts_frac += ns;
+        model.ts_ns += (uint64_t) model.ts_frac;
+        model.ts_frac -= (double) (uint64_t) model.ts_frac;
+        ts_write_regs();
+    }
+    dispatch();
+}
+
+uint32_t emac_model_intsts_history(void)
+{
+    return model.intsts_hist;
+}
+
+const struct emac_model_stats *emac_model_get_stats(void)
+{
+    return &model.stats;
+}
+
+void emac_model_enable_tx(void)
+{
+    sync();
+    if (!(EMAC->CTL & EMAC_CTL_TXON_Msk)) {
+        REG(CTXDSA) = EMAC->TXDSA;
+        model.tx_halt = 0;
+    }
+    EMAC->CTL |= EMAC_CTL_TXON_Msk;
+}
+
+void emac_model_enable_rx(void)
+{
+    sync();
+    if (!(EMAC->CTL & EMAC_CTL_RXON_Msk)) {
+        REG(CRXDSA) = EMAC->RXDSA;
+        model.rx_halt = 0;
+    }
+    EMAC->CTL |= EMAC_CTL_RXON_Msk;
+    EMAC->RXST = 0;
+}
+
+void emac_model_disable_tx(void)
+{
+    EMAC->CTL &= ~EMAC_CTL_TXON_Msk;
+}
+
+void emac_model_disable_rx(void)
+{
+    EMAC->CTL &= ~EMAC_CTL_RXON_Msk;
+}
+
+void emac_model_trigger_tx(void)
+{
+    EMAC->TXST = 0;
+    sync();
+    tx_process();
+    dispatch();
+}
+
+void emac_model_trigger_rx(void)
+{
+    EMAC->RXST = 0;
+    sync();
+    if (model.rx_halt == HALT_RDU)
+        model.rx_halt = 0;
+    dispatch();
+}
+
+/*******************************************************************************
+ * Device
+ ******************************************************************************/
+uint32_t SystemCoreClock = 192000000UL;
+
+uint32_t CLK_GetHCLKFreq(void)
+{
+    return SystemCoreClock;
+}
+
+void NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == EMAC_RX_IRQn)
+        model.nvic[0] = 1;
+    else if (IRQn == EMAC_TX_IRQn)
+        model.nvic[1] = 1;
+    dispatch();
+}
+
+void NVIC_DisableIRQ(IRQn_Type IRQn)
+{
+    if (IRQn == EMAC_RX_IRQn)
+        model.nvic[0] = 0;
+    else if (IRQn == EMAC_TX_IRQn)
+        model.nvic[1] = 0;
+}
+
+/**
+ * The MDIO engine is not modeled, the real EMAC_PhyInit() is built as
+ * EMAC_PhyInit_mdio. The PHY reports a 100 Mbps full duplex link, the
+ * data register answers EMAC_CheckLinkStatus() accordingly.
+ */
+int32_t EMAC_PhyInit(void)
+{
+    EMAC->MIIMDAT = (1UL << 2) | (1UL << 5) | (1UL << 8); /* link, AN, 100F */
+    EMAC->CTL |= EMAC_CTL_OPMODE_Msk | EMAC_CTL_FUDUP_Msk;
+    return 0;
+}
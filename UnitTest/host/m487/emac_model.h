@@ -0,0 +1,112 @@
+/**
+ * @file emac_model.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host model of the M487 EMAC register block and DMA engine.
+ *
+ * The model runs the unmodified emac.c and ethernetif.c on a PC. Frames
+ * are moved between the descriptor rings and a backend (memory, TAP, pcap)
+ * with the same ownership handoff as the hardware:
+ *
+ * - Rx: emac_model_rx() copies a frame into the current Rx descriptor
+ *   owned by the EMAC, hands it to the CPU and raises the Rx interrupt.
+ *   A descriptor owned by the CPU raises RDUIF and halts Rx DMA until
+ *   EMAC_TRIGGER_RX().
+ * - Tx: EMAC_TRIGGER_TX() walks the Tx descriptors owned by the EMAC,
+ *   passes the frames to the backend and raises the Tx interrupt.
+ *
+ * INTSTS is write one to clear. Writes of the driver are detected through
+ * two reserved marker bits, so every write must keep one half of the
+ * register masked out as ethernetif.c does.
+ *
+ * Interrupts are delivered synchronously by calling EMAC_RX_IRQHandler() and
+ * EMAC_TX_IRQHandler(), which the application provides like on the target.
+ * They never nest, a request raised inside a handler is delivered after the
+ * handler returns.
+ */
+
+#ifndef __EMAC_MODEL_H__
+#define __EMAC_MODEL_H__
+
+#include <stdint.h>
+
+/** Backend receiving the frames sent by the Tx DMA */
+typedef void (*emac_model_tx_fn)(void *arg, const uint8_t *frame, uint32_t len);
+
+struct emac_model_stats {
+    uint32_t rx_frames;  /* frames handed to the CPU */
+    uint32_t rx_missed;  /* frames dropped by RDU or halted Rx DMA */
+    uint32_t rx_filter;  /* frames dropped by the CAM filter */
+    uint32_t rx_wraps;   /* Rx ring wrap arounds */
+    uint32_t rdu;        /* Rx descriptor unavailable events */
+    uint32_t tx_frames;  /* frames passed to the backend */
+    uint32_t tx_wraps;   /* Tx ring wrap arounds */
+    uint32_t bus_errors; /* injected bus errors */
+    uint32_t irq_rx;     /* EMAC_RX_IRQHandler() calls */
+    uint32_t irq_tx;     /* EMAC_TX_IRQHandler() calls */
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Reset the register block, the DMA state and the statistics.
+ */
+void emac_model_reset(void);
+
+/**
+ * @brief Set the backend for transmitted frames.
+ */
+void emac_model_set_tx_fn(emac_model_tx_fn fn, void *arg);
+
+/**
+ * @brief Receive a frame from the wire.
+ *
+ * @return 0 if the frame is handed to the CPU, -1 if it is dropped.
+ */
+int emac_model_rx(const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Hold Tx DMA, as if the wire were busy. Descriptors stay owned by
+ *        the EMAC until released.
+ */
+void emac_model_tx_hold(int hold);
+
+/**
+ * @brief Raise a DMA bus error, Rx if tx is 0, else Tx. The DMA engine halts
+ *        until it is enabled again.
+ */
+void emac_model_bus_error(int tx);
+
+/**
+ * @brief Mask both EMAC interrupts like __disable_irq(). Requests stay
+ *        pending and are delivered once unmasked.
+ */
+void emac_model_irq_mask(int mask);
+
+/**
+ * @brief Advance the time stamp counter.
+ */
+void emac_model_advance(uint32_t ns);
+
+/**
+ * @brief Interrupt status including bits already cleared by the driver.
+ */
+uint32_t emac_model_intsts_history(void);
+
+const struct emac_model_stats *emac_model_get_stats(void);
+
+/* Hooks for the macros of emac.h, see NuMicro.h */
+void emac_model_enable_tx(void);
+void emac_model_enable_rx(void);
+void emac_model_disable_tx(void);
+void emac_model_disable_rx(void);
+void emac_model_trigger_tx(void);
+void emac_model_trigger_rx(void);
+
+/* Provided by the application */
+void EMAC_RX_IRQHandler(void);
+void EMAC_TX_IRQHandler(void);
+
+#endif /* __EMAC_MODEL_H__ */
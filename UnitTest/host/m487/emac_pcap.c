@@ -0,0 +1,101 @@
+/**
+ * @file emac_pcap.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief pcap file endpoint of the host EMAC model.
+ */
+
+#include <string.h>
+
+#include "emac_pcap.h"
+
+#define PCAP_MAGIC       0xA1B2C3D4UL
+#define PCAP_SNAPLEN     65535UL
+#define PCAP_LINK_ETHER  1UL
+
+struct pcap_file_hdr {
+    uint32_t magic;
+    uint16_t version_major;
+    uint16_t version_minor;
+    int32_t thiszone;
+    uint32_t sigfigs;
+    uint32_t snaplen;
+    uint32_t linktype;
+};
+
+struct pcap_rec_hdr {
+    uint32_t ts_sec;
+    uint32_t ts_usec;
+    uint32_t incl_len;
+    uint32_t orig_len;
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+FILE *emac_pcap_create(const char *path)
+{
+    struct pcap_file_hdr hdr = {PCAP_MAGIC, 2, 4, 0, 0, PCAP_SNAPLEN,
+                                PCAP_LINK_ETHER};
+    FILE *fp = fopen(path, "wb");
+
+    if (fp == NULL) {
+        printf("[ERROR]: cannot create %s\n", path);
+        return NULL;
+    }
+    fwrite(&hdr, sizeof(hdr), 1, fp);
+    return fp;
+}
+
+FILE *emac_pcap_open(const char *path)
+{
+    struct pcap_file_hdr hdr;
+    FILE *fp = fopen(path, "rb");
+
+    if (fp == NULL) {
+        printf("[ERROR]: cannot open %s\n", path);
+        return NULL;
+    }
+    if (fread(&hdr, sizeof(hdr), 1, fp) != 1 || hdr.magic != PCAP_MAGIC ||
+        hdr.linktype != PCAP_LINK_ETHER) {
+        printf("[ERROR]: %s is not an Ethernet pcap file\n", path);
+        fclose(fp);
+        return NULL;
+    }
+    return fp;
+}
+
+void emac_pcap_write(FILE *fp, const uint8_t *frame, uint32_t len,
+                     uint64_t ts_ns)
+{
+    struct pcap_rec_hdr rec;
+
+    rec.ts_sec = (uint32_t)(ts_ns / 1000000000ULL);
+    rec.ts_usec = (uint32_t)(ts_ns % 1000000000ULL / 1000);
+    rec.incl_len = len;
+    rec.orig_len = len;
+    fwrite(&rec, sizeof(rec), 1, fp);
+    fwrite(frame, 1, len, fp);
+    fflush(fp);
+}
+
+uint32_t emac_pcap_read(FILE *fp, uint8_t *frame, uint32_t size,
+                        uint64_t *ts_ns)
+{
+    struct pcap_rec_hdr rec;
+    uint32_t len;
+
+    if (fread(&rec, sizeof(rec), 1, fp) != 1)
+        return 0;
+
+    len = rec.incl_len < size ? rec.incl_len : size;
+    if (fread(frame, 1, len, fp) != len)
+        return 0;
+    if (rec.incl_len > len)
+        fseek(fp, rec.incl_len - len, SEEK_CUR);
+
+    if (ts_ns != NULL)
+        *ts_ns = (uint64_t) rec.ts_sec * 1000000000ULL +
+                 (uint64_t) rec.ts_usec * 1000ULL;
+    return len;
+}
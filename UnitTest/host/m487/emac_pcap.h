@@ -0,0 +1,50 @@
+/**
+ * @file emac_pcap.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief pcap file endpoint of the host EMAC model.
+ *
+ * A capture is either replayed into the Rx DMA or written from both
+ * directions, so a session can be inspected with wireshark or fed back as a
+ * regression input.
+ */
+
+#ifndef __EMAC_PCAP_H__
+#define __EMAC_PCAP_H__
+
+#include <stdint.h>
+#include <stdio.h>
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Create a capture file with an Ethernet link type header.
+ *
+ * @return file handle, NULL on error
+ */
+FILE *emac_pcap_create(const char *path);
+
+/**
+ * @brief Open a capture file for replay.
+ *
+ * @return file handle, NULL if missing or not a little endian Ethernet pcap
+ */
+FILE *emac_pcap_open(const char *path);
+
+/**
+ * @brief Append a frame with a time stamp in nano seconds.
+ */
+void emac_pcap_write(FILE *fp, const uint8_t *frame, uint32_t len,
+                     uint64_t ts_ns);
+
+/**
+ * @brief Read the next frame of a capture.
+ *
+ * @return captured length, 0 at end of file
+ */
+uint32_t emac_pcap_read(FILE *fp, uint8_t *frame, uint32_t size,
+                        uint64_t *ts_ns);
+
+#endif /* __EMAC_PCAP_H__ */
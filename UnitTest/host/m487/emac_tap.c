@@ -0,0 +1,59 @@
+/**
+ * @file emac_tap.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Linux TAP endpoint of the host EMAC model.
+ */
+
+#include <fcntl.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <poll.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+
+#include "emac_tap.h"
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+int emac_tap_open(const char *ifname)
+{
+    struct ifreq ifr;
+    int fd;
+
+    fd = open("/dev/net/tun", O_RDWR);
+    if (fd < 0) {
+        printf("[ERROR]: cannot open /dev/net/tun\n");
+        return -1;
+    }
+
+    memset(&ifr, 0, sizeof(ifr));
+    ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+    strncpy(ifr.ifr_name, ifname, IFNAMSIZ - 1);
+    if (ioctl(fd, TUNSETIFF, &ifr) < 0) {
+        printf("[ERROR]: cannot attach to %s\n", ifname);
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+int emac_tap_read(int fd, uint8_t *frame, uint32_t size, int timeout_ms)
+{
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int ret;
+
+    ret = poll(&pfd, 1, timeout_ms);
+    if (ret <= 0)
+        return ret;
+    return (int) read(fd, frame, size);
+}
+
+void emac_tap_write(int fd, const uint8_t *frame, uint32_t len)
+{
+    if (write(fd, frame, len) != (ssize_t) len)
+        printf("[ERROR]: TAP write failed\n");
+}
@@ -0,0 +1,41 @@
+/**
+ * @file emac_tap.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Linux TAP endpoint of the host EMAC model.
+ *
+ * The TAP interface has to exist and be up, e.g.
+ *   ip tuntap add dev tap0 mode tap user $USER
+ *   ip addr add 192.168.0.1/24 dev tap0 && ip link set tap0 up
+ */
+
+#ifndef __EMAC_TAP_H__
+#define __EMAC_TAP_H__
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Attach to a TAP interface.
+ *
+ * @return file descriptor, -1 on error
+ */
+int emac_tap_open(const char *ifname);
+
+/**
+ * @brief Read one frame from the TAP interface.
+ *
+ * @param timeout_ms time to wait for a frame
+ * @return frame length, 0 on timeout, -1 on error
+ */
+int emac_tap_read(int fd, uint8_t *frame, uint32_t size, int timeout_ms);
+
+/**
+ * @brief Write one frame to the TAP interface.
+ */
+void emac_tap_write(int fd, const uint8_t *frame, uint32_t len);
+
+#endif /* __EMAC_TAP_H__ */
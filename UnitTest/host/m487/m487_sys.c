@@ -0,0 +1,32 @@
+/**
+ * @file m487_sys.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Virtual clock of the host M487 model.
+ */
+
+#include "lwip/sys.h"
+
+#include "emac_model.h"
+#include "m487_sys.h"
+
+static uint64_t time_ns;
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void m487_sys_advance(uint32_t ns)
+{
+    time_ns += ns;
+    emac_model_advance(ns);
+}
+
+uint64_t m487_sys_time_ns(void)
+{
+    return time_ns;
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t)(time_ns / 1000000ULL);
+}
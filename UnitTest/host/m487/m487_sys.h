@@ -0,0 +1,30 @@
+/**
+ * @file m487_sys.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Virtual clock of the host M487 model.
+ *
+ * Replaces the TIMER0 tick of sys_arch.c. Time only moves when the host
+ * program advances it, which keeps runs reproducible.
+ */
+
+#ifndef __M487_SYS_H__
+#define __M487_SYS_H__
+
+#include <stdint.h>
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Advance the virtual clock and the EMAC time stamp counter.
+ */
+void m487_sys_advance(uint32_t ns);
+
+/**
+ * @brief Virtual time in nano seconds.
+ */
+uint64_t m487_sys_time_ns(void);
+
+#endif /* __M487_SYS_H__ */
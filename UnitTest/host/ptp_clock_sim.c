@@ -0,0 +1,47 @@
+/**
+ * @file ptp_clock_sim.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Simulated free running clock for host tests of the PTP servo.
+ */
+
+#include <string.h>
+#include "ptp_clock_sim.h"
+
+static int64_t ptp_clock_sim_get_time(const struct ptp_clock *clk)
+{
+    return ((const struct ptp_clock_sim *) clk)->now;
+}
+
+static void ptp_clock_sim_adjust_time(const struct ptp_clock *clk,
+                                      int64_t delta_ns)
+{
+    ((struct ptp_clock_sim *) clk)->now += delta_ns;
+}
+
+static void ptp_clock_sim_adjust_freq(const struct ptp_clock *clk,
+                                      int32_t ppb)
+{
+    ((struct ptp_clock_sim *) clk)->adj_ppb = ppb;
+}
+
+void ptp_clock_sim_init(struct ptp_clock_sim *sim,
+                        int64_t start_ns,
+                        int32_t drift_ppb)
+{
+    memset(sim, 0, sizeof(*sim));
+    sim->clock.get_time = ptp_clock_sim_get_time;
+    sim->clock.adjust_time = ptp_clock_sim_adjust_time;
+    sim->clock.adjust_freq = ptp_clock_sim_adjust_freq;
+    sim->now = start_ns;
+    sim->drift_ppb = drift_ppb;
+}
+
+void ptp_clock_sim_advance(struct ptp_clock_sim *sim, int64_t dt_ns)
+{
+    int64_t rate = PTP_NSEC_PER_SEC + sim->drift_ppb + sim->adj_ppb;
+
+    sim->frac += dt_ns * rate;
+    sim->now += sim->frac / PTP_NSEC_PER_SEC;
+    sim->frac %= PTP_NSEC_PER_SEC;
+}
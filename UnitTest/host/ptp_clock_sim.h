@@ -0,0 +1,34 @@
+/**
+ * @file ptp_clock_sim.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Simulated free running clock for host tests of the PTP servo.
+ */
+
+#ifndef PTP_CLOCK_SIM_H
+#define PTP_CLOCK_SIM_H
+
+#include <stdint.h>
+#include "ptp_clock.h"
+
+struct ptp_clock_sim {
+    struct ptp_clock clock;  /* must be first */
+    int64_t now;             /* clock reading, ns */
+    int64_t frac;            /* sub-ns remainder, ns * 1e9 */
+    int32_t drift_ppb;       /* oscillator error */
+    int32_t adj_ppb;         /* set through adjust_freq */
+};
+
+/**
+ * @brief Create a clock starting at start_ns with a fixed oscillator error.
+ */
+void ptp_clock_sim_init(struct ptp_clock_sim *sim,
+                        int64_t start_ns,
+                        int32_t drift_ppb);
+
+/**
+ * @brief Let dt_ns of reference time pass.
+ */
+void ptp_clock_sim_advance(struct ptp_clock_sim *sim, int64_t dt_ns);
+
+#endif /* PTP_CLOCK_SIM_H */
@@ -0,0 +1,2076 @@
+/**
+ * @file netsim.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Deterministic network simulation of the firmware stack.
+ *
+ * The device runs ethernetif.c and emac.c on the EMAC register model with
+ * the applications of the firmware, the peer is a second lwIP stack
+ * (sim_peer.c). Both are connected by the in-memory link of sim_link.c and
+ * share one virtual clock, so a run depends only on its options:
+ *
+ *   netsim [-b bandwidth_bps] [-d delay_us] [-l loss_ppm] [-q queue_bytes]
+ *          [-f flash_read_us] [-s seed] [-S scenario] [-o report.csv]
+ *          [-t tag]
+ *
+ * Scenarios:
+ *  - udp_echo   : peer -> udpecho_raw, round trip time
+ *  - tcp_echo   : peer -> tcpecho_raw, ping-pong round trip time
+ *  - tcp_bulk   : peer -> tcpecho_raw, 256 KiB echoed back
+ *  - http       : peer GET / from httpd, request time and rate
+ *  - http_gz    : as http with "Accept-Encoding: gzip", gzip variant of /
+ *  - http_ka    : HTTP/1.1 GET / one after the other on one connection
+ *  - http_pipe  : HTTP/1.1 GET / pipelined, all sent at once on one connection
+ *  - http_lru   : more idle keep-alive connections than the device has pcbs,
+ *                 the least recently used are reclaimed
+ *  - http_dyn   : HTTP/1.1 GET of a JSON dynamic response (chunked) one after
+ *                 the other on one connection, then once with HTTP/1.0
+ *  - ws         : WebSocket upgrade, echo, ping, server push every 100 ms,
+ *                 a burst beyond the send queue, 30 s idle with keepalive
+ *                 pings and the close handshake; the pushed updates are then
+ *                 polled with GET /last.json every 25 ms for comparison
+ *  - upload     : POST of 250000 bytes to the file-backed flash, read back
+ *  - http_flash : as http, / from the flash_fs image of the same files, read
+ *                 asynchronously, each flash read taking -f us (the time at
+ *                 48 MHz if 0)
+ *  - iperf      : peer lwiperf client -> device lwiperf server, 10 s
+ *  - tcp_client : tcpclient_raw -> peer tcpecho_raw, 10 messages
+ *  - udp_client : udpclient_raw -> peer udpecho_raw, round trip time
+ *  - bench      : the default cases of bench.c against the peer, its CSV rows
+ *                 on stdout
+ *  - mqtt       : MQTT client -> peer broker, QoS 0 publishes of 2 KiB from a
+ *                 caller-owned buffer, then 4 KiB pbuf chains echoed back on a
+ *                 subscription and checked
+ *  - mqtt_rtt   : MQTT client -> peer broker, QoS 1 publishes of 64 bytes for
+ *                 2 s per round trip time of 0.1 to 20 ms, 4 in flight as
+ *                 before the window, then the window of the client; publish
+ *                 rates and publishes per frame on stdout
+ *  - dns        : name lookups every second against the DNS server of the
+ *                 peer: a name with a TTL of 10 s, answered from the table
+ *                 and refreshed before it expires, a non-existent name, kept
+ *                 for its negative TTL, then the faster of the two servers
+ *                 stops answering
+ *  - tftp       : peer TFTP client writes 250000 bytes to upload/fw in the
+ *                 file-backed flash and reads them back, block by block,
+ *                 with 1468 byte blocks and with windows of 4 such blocks,
+ *                 at a round trip time of 0.2 and 10 ms; transfer times on
+ *                 stdout
+ *  - dhcp       : the device restarts without an address and gets one from
+ *                 the DHCP server of the peer: with no lease stored
+ *                 (DISCOVER), with the lease flash_lease.c stored then
+ *                 (INIT-REBOOT), and with a stored address the peer has, the
+ *                 ARP probe finds it taken; time to network on stdout
+ *
+ * Throughput, latencies, frame and interrupt counts follow from the virtual
+ * clock and are reproducible. The device processes frames in zero virtual
+ * time, its CPU cost is the host time spent in the device stack, reported
+ * separately and not reproducible. With -o the rows are appended to a CSV
+ * file tagged with -t (e.g. the commit), to track a metric over commits.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "NuMicro.h"
+#include "bench.h"
+#include "emac_model.h"
+#include "flash_file.h"
+#include "flash_fs.h"
+#include "flash_lease.h"
+#include "flash_upload.h"
+#include "m487_sys.h"
+#include "perf_stats.h"
+#include "sim_link.h"
+#include "sim_peer.h"
+#include "test_util.h"
+
+#include "ethernetif.h"
+#include "lwip/apps/fs.h"
+#include "lwip/apps/httpd.h"
+#include "lwip/apps/lwiperf.h"
+#include "lwip/apps/mqtt.h"
+#include "lwip/apps/mqtt_priv.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/dhcp.h"
+#include "lwip/dns.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/priv/tcp_priv.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include "tcpclient_raw.h"
+#include "tcpecho_raw.h"
+#include "udpclient_raw.h"
+#include "udpecho_raw.h"
+
+#define MS (1000000ULL)
+
+#define UDP_ECHO_COUNT   1000
+#define UDP_ECHO_SIZE    64
+#define TCP_ECHO_COUNT   500
+#define TCP_ECHO_SIZE    64
+#define TCP_BULK_BYTES   (256 * 1024)
+#define HTTP_COUNT       50
+#define HTTP_LRU_CONNS   12
+#define HTTP_DYN_RECORDS 400
+#define WS_PUSH_COUNT    100
+#define WS_PUSH_MS       100
+#define WS_POLL_MS       25
+#define WS_BURST         200
+#define UDP_CLIENT_COUNT 100
+#define UPLOAD_BYTES     250000
+#define MQTT_PUB_COUNT   400
+#define MQTT_PUB_SIZE    2048
+#define MQTT_ECHO_COUNT  50
+#define MQTT_ECHO_SIZE   4096
+#define MQTT_ECHO_WINDOW 4
+#define MQTT_RTT_SIZE    64
+#define MQTT_RTT_MS      2000
+#define MQTT_RTT_FIXED   4    /* in flight before the window */
+#define DNS_LOOKUPS      60
+#define DNS_NEG_LOOKUPS  40
+#define DNS_SLOW_MS      20   /* answer delay of 192.168.0.220 */
+#define DNS_FAST_MS      2    /* answer delay of 192.168.0.221 */
+#define TFTP_BYTES       250000
+#define FLASH_SIZE       (2 * 1024 * 1024)
+#define WWW_ADDR         0x180000
+
+struct sim_result {
+    const char *name;
+    int ok;
+    uint64_t duration_ns;
+    uint64_t bytes;
+    uint32_t ops;         /* completed requests, echoes or transfers */
+    struct perf_hist lat; /* ns */
+    uint32_t lost;        /* frames lost or dropped on the link */
+    uint32_t frames;      /* frames on the link, both directions */
+    uint32_t irqs;        /* EMAC interrupts of the device */
+    uint64_t dev_cpu_ns;  /* host time in the device stack */
+};
+
+struct netif gnetif;
+
+static uint64_t next_tick;
+static uint64_t dev_cpu_ns;
+
+/* State of the running scenario, updated by the callbacks */
+static struct {
+    uint64_t t0;       /* start of the pending request */
+    uint32_t expect;   /* bytes of the pending reply */
+    uint32_t got;      /* bytes received */
+    uint32_t sent;     /* bytes accepted by the peer stack */
+    int connected;
+    int closed;
+    int done;
+    uint32_t udp_seq;
+    uint32_t udp_client_rx;
+    uint32_t iperf_bytes, iperf_ms;
+    char reply[256];   /* first bytes of the reply, null-terminated */
+    struct perf_hist *lat;
+} st;
+
+static uint8_t tx_buf[TCP_BULK_BYTES];
+static uint8_t rx_buf[TCP_BULK_BYTES]; /* reply bytes 0 .. st.got */
+
+static struct flash_file flash;
+static const struct flash_upload_region upload_regions[] = {
+    {"/upload/fw", 0, 1024 * 1024},
+    {"/upload/config", 1024 * 1024, 64 * 1024},
+};
+
+/*******************************************************************************
+ * Device
+ ******************************************************************************/
+void EMAC_RX_IRQHandler(void)
+{
+    ethernetif_input(&gnetif);
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    // Clean up Tx resource occupied by previous sent.
+    ethernetif_tx_done(&gnetif);
+}
+
+static void dev_tx(void *arg, const uint8_t *frame, uint32_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    sim_link_send(SIM_TO_PEER, frame, len);
+}
+
+/* Frame of the peer echo server (192.168.0.220 port 7) to udpclient_raw */
+static int is_udp_client_echo(const uint8_t *frame, uint32_t len)
+{
+    return len >= 42 && frame[12] == 0x08 && frame[13] == 0x00 &&
+           frame[23] == 17 && frame[29] == 220 && frame[34] == 0 &&
+           frame[35] == 7;
+}
+
+static void link_deliver(int dir, const uint8_t *frame, uint32_t len)
+{
+    uint64_t t;
+
+    if (dir == SIM_TO_PEER) {
+        sim_peer_input(frame, len);
+        return;
+    }
+
+    if (st.lat != NULL && is_udp_client_echo(frame, len)) {
+        st.udp_client_rx++;
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - st.t0));
+    }
+    t = host_ns();
+    emac_model_rx(frame, len);
+    dev_cpu_ns += host_ns() - t;
+}
+
+static void dev_timeouts(void)
+{
+    uint64_t t = host_ns();
+
+    sys_check_timeouts();
+    dev_cpu_ns += host_ns() - t;
+}
+
+/* Rest of the main loop, run after every event */
+static void dev_poll(void)
+{
+    uint64_t t = host_ns();
+
+    ethernetif_poll(&gnetif);
+    flash_fs_poll();
+    flash_upload_poll();
+    flash_lease_poll();
+    bench_poll();
+    dev_cpu_ns += host_ns() - t;
+}
+
+static void lwip_layer_init(void)
+{
+    ip4_addr_t ipaddr, netmask, gw;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 23);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    lwip_init();
+    netif_add(&gnetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+    netif_set_default(&gnetif);
+    netif_set_up(&gnetif);
+}
+
+/*******************************************************************************
+ * Peer callbacks
+ ******************************************************************************/
+void sim_on_udp_recv(const uint8_t *data, uint16_t len)
+{
+    uint32_t seq;
+
+    if (len < sizeof(seq))
+        return;
+    memcpy(&seq, data, sizeof(seq));
+    if (st.lat == NULL || seq != st.udp_seq || st.done)
+        return;
+    perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - st.t0));
+    st.got += len;
+    st.done = 1;
+}
+
+void sim_on_tcp_connected(int err)
+{
+    st.connected = (err == 0);
+}
+
+void sim_on_tcp_recv(const uint8_t *data, uint16_t len)
+{
+    if (data == NULL) {
+        st.closed = 1;
+        return;
+    }
+    if (st.got < sizeof(st.reply) - 1)
+        memcpy(&st.reply[st.got], data,
+               LWIP_MIN(len, sizeof(st.reply) - 1 - st.got));
+    if (st.got < sizeof(rx_buf))
+        memcpy(&rx_buf[st.got], data, LWIP_MIN(len, sizeof(rx_buf) - st.got));
+    st.got += len;
+}
+
+void sim_on_tcp_sent(uint16_t len)
+{
+    LWIP_UNUSED_ARG(len);
+}
+
+void sim_on_iperf_report(int ok, uint32_t bytes, uint32_t ms, uint32_t kbps)
+{
+    LWIP_UNUSED_ARG(kbps);
+
+    st.done = ok ? 1 : -1;
+    st.iperf_bytes = bytes;
+    st.iperf_ms = ms;
+}
+
+void sim_on_tftp_done(int ok, uint32_t bytes)
+{
+    st.done = ok ? 1 : -1;
+    st.got = bytes;
+}
+
+/*******************************************************************************
+ * Event loop
+ ******************************************************************************/
+static void sim_step_to(uint64_t t)
+{
+    uint64_t now = m487_sys_time_ns(), d;
+
+    while (now < t) {
+        d = t - now;
+        if (d > 1000 * MS)
+            d = 1000 * MS;
+        m487_sys_advance((uint32_t) d);
+        now += d;
+    }
+}
+
+/**
+ * Run both stacks for at most dur_ns, or until done() is true. Frames are
+ * delivered at their arrival time, the lwIP timeouts run every 1 ms and the
+ * main loop also when the flash gets ready.
+ */
+static void sim_run(uint64_t dur_ns, int (*done)(void))
+{
+    uint64_t end = m487_sys_time_ns() + dur_ns, next;
+
+    while (done == NULL || !done()) {
+        next = sim_link_next();
+        if (next_tick < next)
+            next = next_tick;
+        if (flash.busy_until > m487_sys_time_ns() && flash.busy_until < next)
+            next = flash.busy_until;
+        if (next > end) {
+            sim_step_to(end);
+            break;
+        }
+        sim_step_to(next);
+        sim_link_deliver(next);
+        if (next == next_tick) {
+            dev_timeouts();
+            sim_peer_poll();
+            next_tick += MS;
+        }
+        dev_poll();
+    }
+}
+
+static int is_done(void)
+{
+    return st.done != 0;
+}
+
+static int is_connected(void)
+{
+    return st.connected || st.closed;
+}
+
+static int is_closed(void)
+{
+    return st.closed;
+}
+
+static int got_expected(void)
+{
+    return st.got >= st.expect || st.closed;
+}
+
+static int tcp_client_done(void)
+{
+    return tcp_active_pcbs == NULL;
+}
+
+static int udp_client_done(void)
+{
+    return st.udp_client_rx == st.expect;
+}
+
+/*******************************************************************************
+ * Scenarios
+ ******************************************************************************/
+static void scenario_udp_echo(struct sim_result *r)
+{
+    uint8_t buf[UDP_ECHO_SIZE];
+    uint32_t i, answered = 0;
+
+    memset(buf, 0xa5, sizeof(buf));
+    for (i = 0; i < UDP_ECHO_COUNT; i++) {
+        st.udp_seq = i;
+        st.done = 0;
+        st.t0 = m487_sys_time_ns();
+        memcpy(buf, &i, sizeof(i));
+        sim_peer_udp_send(7, buf, sizeof(buf));
+        sim_run(100 * MS, is_done);
+        answered += st.done;
+    }
+    r->ops = answered;
+    r->bytes = st.got * 2ULL;
+    r->ok = answered > 0 && (answered == UDP_ECHO_COUNT ||
+                             sim_link_get_stats(SIM_TO_DEV)->lost +
+                                 sim_link_get_stats(SIM_TO_PEER)->lost >=
+                                 UDP_ECHO_COUNT - answered);
+}
+
+static void scenario_tcp_echo(struct sim_result *r)
+{
+    uint8_t buf[TCP_ECHO_SIZE];
+    uint32_t i, n = 0;
+    uint64_t t;
+
+    memset(buf, 0x5a, sizeof(buf));
+    if (sim_peer_tcp_connect(7) != 0)
+        return;
+    sim_run(5000 * MS, is_connected);
+    if (!st.connected)
+        return;
+
+    for (i = 0; i < TCP_ECHO_COUNT && !st.closed; i++) {
+        st.expect = st.got + sizeof(buf);
+        t = m487_sys_time_ns();
+        if (sim_peer_tcp_write(buf, sizeof(buf)) != sizeof(buf))
+            break;
+        sim_run(5000 * MS, got_expected);
+        if (st.got < st.expect)
+            break;
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - t));
+        n++;
+    }
+    sim_peer_tcp_close();
+    r->ops = n;
+    r->bytes = st.got * 2ULL;
+    r->ok = n == TCP_ECHO_COUNT;
+}
+
+static int tcp_bulk_done(void)
+{
+    /* Keep the send buffer of the peer full */
+    if (st.sent < TCP_BULK_BYTES && !st.closed)
+        st.sent += sim_peer_tcp_write(&tx_buf[st.sent],
+                                      TCP_BULK_BYTES - st.sent);
+    return st.got >= TCP_BULK_BYTES || st.closed;
+}
+
+static void scenario_tcp_bulk(struct sim_result *r)
+{
+    uint32_t i;
+
+    for (i = 0; i < TCP_BULK_BYTES; i++)
+        tx_buf[i] = (uint8_t) i;
+    if (sim_peer_tcp_connect(7) != 0)
+        return;
+    sim_run(5000 * MS, is_connected);
+    if (!st.connected)
+        return;
+    sim_run(60000 * MS, tcp_bulk_done);
+    sim_peer_tcp_close();
+    r->bytes = st.got * 2ULL;
+    r->ok = st.got == TCP_BULK_BYTES;
+    r->ops = r->ok;
+}
+
+/* HTTP_COUNT requests, each on its own connection, replies must contain hdr */
+static void http_get(struct sim_result *r, const char *req, const char *hdr)
+{
+    uint32_t i, n = 0, req_len = strlen(req);
+    uint64_t t, bytes = 0;
+
+    for (i = 0; i < HTTP_COUNT; i++) {
+        st.connected = st.closed = 0;
+        st.got = 0;
+        memset(st.reply, 0, sizeof(st.reply));
+        t = m487_sys_time_ns();
+        if (sim_peer_tcp_connect(80) != 0)
+            break;
+        sim_run(5000 * MS, is_connected);
+        if (!st.connected || sim_peer_tcp_write(req, req_len) != req_len) {
+            sim_peer_tcp_close();
+            break;
+        }
+        sim_run(5000 * MS, is_closed);
+        if (!st.closed) {
+            sim_peer_tcp_close();
+            break;
+        }
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - t));
+        bytes += st.got;
+        if (memcmp(st.reply, "HTTP/1.", 7) == 0 && strstr(st.reply, hdr))
+            n++;
+    }
+    r->ops = n;
+    r->bytes = bytes;
+    r->ok = n == HTTP_COUNT;
+}
+
+static void scenario_http(struct sim_result *r)
+{
+    http_get(r, "GET / HTTP/1.0\r\n\r\n", "Content-Type: text/html");
+}
+
+static void scenario_http_gz(struct sim_result *r)
+{
+    http_get(r,
+             "GET / HTTP/1.0\r\n"
+             "Accept-Encoding: gzip, deflate\r\n\r\n",
+             "Content-Encoding: gzip");
+}
+
+/* Length of the response to GET / (header and body from fsdata.c) */
+static uint32_t http_index_len(void)
+{
+    struct fs_file file;
+    uint32_t len;
+
+    if (fs_open(&file, "/index.html") != ERR_OK)
+        return 0;
+    len = (uint32_t) file.len;
+    fs_close(&file);
+    return len;
+}
+
+static int http_connect(void)
+{
+    st.connected = st.closed = 0;
+    if (sim_peer_tcp_connect(80) != 0)
+        return -1;
+    sim_run(5000 * MS, is_connected);
+    return st.connected ? 0 : -1;
+}
+
+static void scenario_http_ka(struct sim_result *r)
+{
+    static const char req[] = "GET / HTTP/1.1\r\nHost: 192.168.0.23\r\n\r\n";
+    uint32_t i, n = 0, len = http_index_len();
+    uint64_t t;
+
+    if (len == 0 || http_connect() != 0)
+        return;
+    for (i = 0; i < HTTP_COUNT && !st.closed; i++) {
+        st.expect = st.got + len;
+        t = m487_sys_time_ns();
+        if (sim_peer_tcp_write(req, sizeof(req) - 1) != sizeof(req) - 1)
+            break;
+        sim_run(5000 * MS, got_expected);
+        if (st.got != st.expect)
+            break;
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - t));
+        n++;
+    }
+    /* One connection, the server must not have closed it */
+    r->ok = n == HTTP_COUNT && !st.closed &&
+            memcmp(st.reply, "HTTP/1.1 200", 12) == 0 &&
+            strstr(st.reply, "Connection: keep-alive") != NULL;
+    sim_peer_tcp_close();
+    r->ops = n;
+    r->bytes = st.got;
+}
+
+static int http_pipe_done(void)
+{
+    uint64_t now = m487_sys_time_ns();
+
+    /* Time between the completions of the responses */
+    while (st.got >= st.sent + st.expect) {
+        st.sent += st.expect;
+        perf_hist_add(st.lat, (uint32_t)(now - st.t0));
+        st.t0 = now;
+    }
+    return st.got >= HTTP_COUNT * st.expect || st.closed;
+}
+
+static void scenario_http_pipe(struct sim_result *r)
+{
+    static const char req[] = "GET / HTTP/1.1\r\nHost: 192.168.0.23\r\n\r\n";
+    uint32_t i, len = sizeof(req) - 1;
+
+    st.expect = http_index_len();
+    if (st.expect == 0 || http_connect() != 0)
+        return;
+    for (i = 0; i < HTTP_COUNT; i++)
+        memcpy((char *) &tx_buf[i * len], req, len);
+    st.t0 = m487_sys_time_ns();
+    if (sim_peer_tcp_write(tx_buf, HTTP_COUNT * len) != HTTP_COUNT * len) {
+        sim_peer_tcp_close();
+        return;
+    }
+    sim_run(20000 * MS, http_pipe_done);
+    r->ops = st.got / st.expect;
+    r->ok = st.got == HTTP_COUNT * st.expect && !st.closed;
+    sim_peer_tcp_close();
+    r->bytes = st.got;
+}
+
+static void scenario_http_lru(struct sim_result *r)
+{
+    static const char req[] = "GET / HTTP/1.1\r\nHost: 192.168.0.23\r\n\r\n";
+    uint32_t i, n = 0, open = 0, len = http_index_len();
+    uint64_t t;
+    int lru = 1;
+
+    for (i = 0; i < HTTP_LRU_CONNS && len > 0; i++) {
+        st.got = 0;
+        memset(st.reply, 0, sizeof(st.reply));
+        t = m487_sys_time_ns();
+        if (http_connect() != 0)
+            break;
+        st.expect = len;
+        if (sim_peer_tcp_write(req, sizeof(req) - 1) != sizeof(req) - 1)
+            break;
+        sim_run(5000 * MS, got_expected);
+        if (st.got != len || memcmp(st.reply, "HTTP/1.1 200", 12) != 0)
+            break;
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - t));
+        n++;
+        if (sim_peer_tcp_hold() != 0)
+            break;
+    }
+    sim_peer_tcp_close();
+    sim_run(100 * MS, NULL);
+    /* The open connections are the most recently used ones */
+    for (i = 0; i < n; i++) {
+        if (sim_peer_tcp_held_open(i))
+            open++;
+        else if (open > 0)
+            lru = 0;
+    }
+    printf("[INFO]: http_lru: %u of %u idle connections kept\n", open, n);
+    sim_peer_tcp_release();
+    r->ops = n;
+    r->bytes = (uint64_t) n * len;
+    r->ok = n == HTTP_LRU_CONNS && open > 0 && open < n && lru;
+}
+
+/* JSON telemetry records, as many whole ones as fit each time */
+static err_t http_dyn_json(int index, char *buf, u16_t *len, u32_t *state)
+{
+    u16_t off = 0;
+    char rec[64];
+    int n;
+
+    LWIP_UNUSED_ARG(index);
+    while (*state <= HTTP_DYN_RECORDS) {
+        if (*state == HTTP_DYN_RECORDS)
+            n = snprintf(rec, sizeof(rec), "]\n");
+        else
+            n = snprintf(rec, sizeof(rec),
+                         "%c{\"seq\":%u,\"rx\":%u,\"tx\":%u}",
+                         *state ? ',' : '[', *state, *state * 1514,
+                         *state * 60);
+        if (off + n > *len)
+            break;
+        memcpy(&buf[off], rec, n);
+        off += n;
+        (*state)++;
+    }
+    *len = off;
+    return *state > HTTP_DYN_RECORDS ? ERR_OK : ERR_INPROGRESS;
+}
+
+/* Latest value of the ws push source, also served as GET /last.json */
+static uint32_t ws_value;
+
+static err_t http_dyn_last(int index, char *buf, u16_t *len, u32_t *state)
+{
+    LWIP_UNUSED_ARG(index);
+    LWIP_UNUSED_ARG(state);
+    *len = (u16_t) snprintf(buf, *len, "{\"seq\":%u}", ws_value);
+    return ERR_OK;
+}
+
+static const tDyn http_dyns[] = {
+    {"/telemetry.json", "application/json", http_dyn_json},
+    {"/last.json", "application/json", http_dyn_last},
+    {FLASH_UPLOAD_RESULT_URI, "application/json", flash_upload_json},
+};
+
+/* The body http_dyn_json() writes in one piece */
+static uint32_t http_dyn_body(char *buf, uint32_t size)
+{
+    u32_t state = 0;
+    u16_t len = (u16_t) LWIP_MIN(size, 0xffff);
+
+    return http_dyn_json(0, buf, &len, &state) == ERR_OK ? len : 0;
+}
+
+/* A whole chunked response, or the connection closed */
+static int http_dyn_done(void)
+{
+    return st.closed ||
+           (st.got >= 5 && memcmp(&rx_buf[st.got - 5], "0\r\n\r\n", 5) == 0);
+}
+
+/* Decode the chunked body of the response in rx_buf to out, 0 if malformed */
+static uint32_t http_dyn_dechunk(char *out, uint32_t size)
+{
+    const char *p = (const char *) rx_buf, *end = p + st.got;
+    const char *hdr = strstr(st.reply, "\r\n\r\n");
+    uint32_t n = 0;
+    char *e;
+
+    if (hdr == NULL)
+        return 0;
+    p += hdr + 4 - st.reply;
+    for (;;) {
+        unsigned long len = strtoul(p, &e, 16);
+
+        if (e == p || e + 2 > end || memcmp(e, "\r\n", 2) != 0)
+            return 0;
+        p = e + 2;
+        if (len == 0)
+            return p + 2 == end && memcmp(p, "\r\n", 2) == 0 ? n : 0;
+        if (p + len + 2 > end || n + len > size || memcmp(p + len, "\r\n", 2))
+            return 0;
+        memcpy(&out[n], p, len);
+        n += len;
+        p += len + 2;
+    }
+}
+
+static void scenario_http_dyn(struct sim_result *r)
+{
+    static const char req[] =
+        "GET /telemetry.json HTTP/1.1\r\nHost: 192.168.0.23\r\n\r\n";
+    static const char req10[] = "GET /telemetry.json HTTP/1.0\r\n\r\n";
+    static char body[32 * 1024], got[32 * 1024];
+    uint32_t i, n = 0, len = http_dyn_body(body, sizeof(body));
+    uint64_t t, bytes = 0;
+    const char *hdr;
+    int ok10 = 0;
+
+    if (len == 0 || http_connect() != 0)
+        return;
+    for (i = 0; i < HTTP_COUNT && !st.closed; i++) {
+        st.got = 0;
+        memset(st.reply, 0, sizeof(st.reply));
+        t = m487_sys_time_ns();
+        if (sim_peer_tcp_write(req, sizeof(req) - 1) != sizeof(req) - 1)
+            break;
+        sim_run(5000 * MS, http_dyn_done);
+        if (st.closed || memcmp(st.reply, "HTTP/1.1 200", 12) != 0 ||
+            !strstr(st.reply, "Transfer-Encoding: chunked") ||
+            http_dyn_dechunk(got, sizeof(got)) != len ||
+            memcmp(got, body, len) != 0)
+            break;
+        perf_hist_add(st.lat, (uint32_t)(m487_sys_time_ns() - t));
+        bytes += st.got;
+        n++;
+    }
+    sim_peer_tcp_close();
+
+    /* HTTP/1.0: not chunked, the body ends with the connection */
+    st.got = 0;
+    memset(st.reply, 0, sizeof(st.reply));
+    if (http_connect() == 0 &&
+        sim_peer_tcp_write(req10, sizeof(req10) - 1) == sizeof(req10) - 1) {
+        sim_run(5000 * MS, is_closed);
+        hdr = strstr(st.reply, "\r\n\r\n");
+        ok10 = st.closed && hdr != NULL &&
+               memcmp(st.reply, "HTTP/1.0 200", 12) == 0 &&
+               st.got == (uint32_t)(hdr + 4 - st.reply) + len &&
+               memcmp(&rx_buf[hdr + 4 - st.reply], body, len) == 0;
+    }
+    sim_peer_tcp_close();
+    r->ops = n;
+    r->bytes = bytes;
+    r->ok = n == HTTP_COUNT && ok10;
+}
+
+/* Client side of scenario_ws, frames parsed from rx_buf */
+static struct {
+    uint32_t pos;       /* next frame in rx_buf */
+    uint32_t msgs;      /* data frames */
+    uint32_t pings, pongs;
+    int close_code;     /* -1 until a close frame */
+    int timing;         /* data frames add their latency from st.t0 */
+    uint32_t seq, bad;  /* burst: next sequence number, frames out of order */
+    char last[64];      /* payload of the last data or pong frame */
+    uint32_t last_len;
+    void *conn;         /* device side, set by the open handler */
+    int opened, closed_dev;
+} ws;
+
+static void ws_open(void *connection, int index)
+{
+    LWIP_UNUSED_ARG(index);
+    ws.conn = connection;
+    ws.opened = 1;
+}
+
+/* Echo what the client sends */
+static void ws_recv(void *connection, int index, u8_t flags, struct pbuf *p,
+                    u16_t len)
+{
+    char buf[128];
+
+    LWIP_UNUSED_ARG(index);
+    if (len <= sizeof(buf) && pbuf_copy_partial(p, buf, len, 0) == len)
+        httpd_ws_send(connection, flags & 0x0f, buf, len);
+}
+
+static void ws_close(void *connection, int index)
+{
+    LWIP_UNUSED_ARG(connection);
+    LWIP_UNUSED_ARG(index);
+    ws.conn = NULL;
+    ws.closed_dev = 1;
+}
+
+static const tWs ws_handlers[] = {
+    {"/ws", ws_open, ws_recv, ws_close},
+};
+
+/* A masked client frame, written in parts segments */
+static int ws_client_send(uint8_t opcode, const void *data, uint16_t len,
+                          int parts)
+{
+    static const uint8_t mask[4] = {0x37, 0xfa, 0x21, 0x3d};
+    uint8_t f[8 + 128];
+    uint32_t n = 0, i, k, cut;
+
+    if (len > 128)
+        return -1;
+    f[n++] = HTTPD_WS_FIN | opcode;
+    if (len < 126) {
+        f[n++] = 0x80 | len;
+    } else {
+        f[n++] = 0x80 | 126;
+        f[n++] = len >> 8;
+        f[n++] = len;
+    }
+    memcpy(&f[n], mask, 4);
+    n += 4;
+    for (i = 0; i < len; i++)
+        f[n + i] = ((const uint8_t *) data)[i] ^ mask[i & 3];
+    n += len;
+    for (k = 0, i = 0; k < (uint32_t) parts; k++, i = cut) {
+        cut = k == (uint32_t) parts - 1 ? n : n * (k + 1) / parts;
+        if (sim_peer_tcp_write(&f[i], cut - i) != cut - i)
+            return -1;
+        if (k < (uint32_t) parts - 1)
+            sim_run(MS, NULL);
+    }
+    return 0;
+}
+
+/* Parse the frames received since the last call, answer pings */
+static void ws_client_poll(void)
+{
+    uint32_t hlen, len, left, seq;
+    const uint8_t *f;
+    uint8_t op;
+
+    while (st.got > ws.pos && st.got <= sizeof(rx_buf)) {
+        f = &rx_buf[ws.pos];
+        left = st.got - ws.pos;
+        if (left < 2)
+            break;
+        len = f[1] & 0x7f;
+        hlen = 2;
+        if (len == 126) {
+            if (left < 4)
+                break;
+            len = (f[2] << 8) | f[3];
+            hlen = 4;
+        }
+        if (left < hlen + len)
+            break;
+        op = f[0] & 0x0f;
+        if (op == HTTPD_WS_PING) {
+            ws.pings++;
+            ws_client_send(HTTPD_WS_PONG, &f[hlen], len, 1);
+        } else if (op == HTTPD_WS_CLOSE) {
+            ws.close_code = len >= 2 ? (f[hlen] << 8) | f[hlen + 1] : 0;
+        } else {
+            ws.last_len = LWIP_MIN(len, sizeof(ws.last));
+            memcpy(ws.last, &f[hlen], ws.last_len);
+            if (op == HTTPD_WS_PONG) {
+                ws.pongs++;
+            } else {
+                ws.msgs++;
+                if (ws.timing == 1 && st.lat != NULL)
+                    perf_hist_add(st.lat,
+                                  (uint32_t)(m487_sys_time_ns() - st.t0));
+                if (ws.timing > 1 &&
+                    (sscanf(ws.last, "%8u", &seq) != 1 || seq != ws.seq++))
+                    ws.bad++;
+            }
+        }
+        ws.pos += hlen + len;
+    }
+}
+
+static int ws_got_msgs(void)
+{
+    ws_client_poll();
+    return ws.msgs >= st.expect || st.closed;
+}
+
+static int ws_got_pong(void)
+{
+    ws_client_poll();
+    return ws.pongs > 0 || st.closed;
+}
+
+static int ws_got_close(void)
+{
+    ws_client_poll();
+    return (ws.close_code >= 0 && st.closed && ws.closed_dev) || ws.bad;
+}
+
+static int ws_handshake_done(void)
+{
+    return strstr(st.reply, "\r\n\r\n") != NULL || st.closed;
+}
+
+/* Run until t, if not already past */
+static void sim_run_until(uint64_t t)
+{
+    uint64_t now = m487_sys_time_ns();
+
+    if (t > now)
+        sim_run(t - now, NULL);
+}
+
+static int ws_idle(void)
+{
+    ws_client_poll();
+    return st.closed;
+}
+
+/* The same updates polled with keep-alive GETs, bytes per update */
+static uint64_t ws_polling(struct perf_hist *lat)
+{
+    static const char req[] =
+        "GET /last.json HTTP/1.1\r\nHost: 192.168.0.23\r\n\r\n";
+    uint64_t start, t, t_update = 0, bytes;
+    uint32_t k, seq, seen = 0;
+    char body[64];
+
+    if (http_connect() != 0)
+        return 0;
+    bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+            sim_link_get_stats(SIM_TO_PEER)->bytes;
+    start = m487_sys_time_ns() + WS_POLL_MS * MS;
+    for (k = 0; k < WS_PUSH_COUNT * WS_PUSH_MS / WS_POLL_MS; k++) {
+        /* an update half a polling interval before a poll, the mean; the
+           phase is kept when behind after a retransmission */
+        if (k % (WS_PUSH_MS / WS_POLL_MS) == 0) {
+            t = start + k * WS_POLL_MS * MS - WS_POLL_MS * MS / 2;
+            if (m487_sys_time_ns() > t) {
+                start += m487_sys_time_ns() - t;
+                t = m487_sys_time_ns();
+            }
+            sim_run_until(t);
+            ws_value++;
+            t_update = m487_sys_time_ns();
+        }
+        sim_run_until(start + k * WS_POLL_MS * MS);
+        st.got = 0;
+        memset(st.reply, 0, sizeof(st.reply));
+        if (sim_peer_tcp_write(req, sizeof(req) - 1) != sizeof(req) - 1)
+            break;
+        sim_run(5000 * MS, http_dyn_done);
+        memset(body, 0, sizeof(body));
+        if (st.closed || http_dyn_dechunk(body, sizeof(body) - 1) == 0 ||
+            sscanf(body, "{\"seq\":%u}", &seq) != 1)
+            break;
+        if (seq != seen) {
+            seen = seq;
+            perf_hist_add(lat, (uint32_t)(m487_sys_time_ns() - t_update));
+        }
+    }
+    sim_peer_tcp_close();
+    bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+            sim_link_get_stats(SIM_TO_PEER)->bytes - bytes;
+    return seen == ws_value ? bytes / seen : 0;
+}
+
+static void scenario_ws(struct sim_result *r)
+{
+    static const char req[] = "GET /ws HTTP/1.1\r\n"
+                              "Host: 192.168.0.23\r\n"
+                              "Upgrade: websocket\r\n"
+                              "Connection: Upgrade\r\n"
+                              "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n"
+                              "Sec-WebSocket-Version: 13\r\n\r\n";
+    static const char msg[] = "hello over a WebSocket";
+    struct perf_hist poll_lat;
+    uint64_t bytes, ws_bytes, poll_bytes;
+    uint32_t i, sent;
+    const char *hdr;
+    char push[64];
+    int ok = 1;
+
+    memset(&ws, 0, sizeof(ws));
+    ws.close_code = -1;
+    if (http_connect() != 0 ||
+        sim_peer_tcp_write(req, sizeof(req) - 1) != sizeof(req) - 1)
+        return;
+    sim_run(5000 * MS, ws_handshake_done);
+    hdr = strstr(st.reply, "\r\n\r\n");
+    if (hdr == NULL || memcmp(st.reply, "HTTP/1.1 101", 12) != 0 ||
+        !strstr(st.reply,
+                "Sec-WebSocket-Accept: s3pPLMBiTxaQ9kYGzzhZRbK+xOo=") ||
+        !ws.opened) {
+        printf("[ERROR]: ws: handshake\n");
+        sim_peer_tcp_close();
+        return;
+    }
+    ws.pos = hdr + 4 - st.reply;
+
+    /* echo of a frame received in pieces, ping */
+    st.expect = 1;
+    ws_client_send(HTTPD_WS_TEXT, msg, sizeof(msg) - 1, 3);
+    sim_run(5000 * MS, ws_got_msgs);
+    ok &= ws.msgs == 1 && ws.last_len == sizeof(msg) - 1 &&
+          memcmp(ws.last, msg, ws.last_len) == 0;
+    ws_client_send(HTTPD_WS_PING, "p1", 2, 1);
+    sim_run(5000 * MS, ws_got_pong);
+    ok &= ws.pongs == 1 && ws.last_len == 2 && memcmp(ws.last, "p1", 2) == 0;
+    if (!ok)
+        printf("[ERROR]: ws: echo or ping\n");
+
+    /* server push from the main loop */
+    bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+            sim_link_get_stats(SIM_TO_PEER)->bytes;
+    ws.timing = 1;
+    sent = ws.msgs;
+    for (i = 0; i < WS_PUSH_COUNT && !st.closed; i++) {
+        ws_value++;
+        st.t0 = m487_sys_time_ns();
+        st.expect = ws.msgs + 1;
+        if (httpd_ws_broadcast(0, HTTPD_WS_TEXT, push,
+                               snprintf(push, sizeof(push), "{\"seq\":%u}",
+                                        ws_value)) != 1)
+            break;
+        sim_run(WS_PUSH_MS * MS, ws_got_msgs);
+        sim_run_until(st.t0 + WS_PUSH_MS * MS);
+    }
+    /* late ones, e.g. retransmitted */
+    st.expect = sent + WS_PUSH_COUNT;
+    sim_run(5000 * MS, ws_got_msgs);
+    r->ops = ws.msgs - sent;
+    ws_bytes = (sim_link_get_stats(SIM_TO_DEV)->bytes +
+                sim_link_get_stats(SIM_TO_PEER)->bytes - bytes) / WS_PUSH_COUNT;
+    ok &= r->ops == WS_PUSH_COUNT;
+
+    /* a burst beyond the send queue: what is accepted arrives in order */
+    ws.timing = 2;
+    for (sent = 0; sent < WS_BURST; sent++) {
+        memset(push, 'x', sizeof(push));
+        snprintf(push, sizeof(push), "%08u", sent);
+        push[8] = ' ';
+        if (httpd_ws_send(ws.conn, HTTPD_WS_TEXT, push, sizeof(push)) != ERR_OK)
+            break;
+    }
+    st.expect = ws.msgs + sent;
+    sim_run(5000 * MS, ws_got_msgs);
+    printf("[INFO]: ws: %u of %u burst frames queued\n", sent, WS_BURST);
+    ok &= ws.seq == sent && !ws.bad && sent > 0 && sent < WS_BURST;
+    ws.timing = 0;
+
+    /* idle: pinged, answered, kept open */
+    sim_run(30000 * MS, ws_idle);
+    ok &= ws.pings >= 2 && !st.closed && !ws.closed_dev;
+    if (!ok)
+        printf("[ERROR]: ws: push, burst or idle (%u pings)\n", ws.pings);
+
+    /* close handshake from the client */
+    ws_client_send(HTTPD_WS_CLOSE, "\x03\xe8", 2, 1);
+    sim_run(5000 * MS, ws_got_close);
+    ok &= ws.close_code == HTTPD_WS_CLOSE_NORMAL && st.closed && ws.closed_dev;
+    r->bytes = st.got;
+
+    /* the same updates polled */
+    memset(&poll_lat, 0, sizeof(poll_lat));
+    poll_bytes = ws_polling(&poll_lat);
+    printf("[INFO]: ws: push %llu B/update p50 %u us, polling every %u ms "
+           "%llu B/update p50 %u us\n",
+           (unsigned long long) ws_bytes,
+           perf_hist_percentile(st.lat, 50) / 1000,
+           WS_POLL_MS, (unsigned long long) poll_bytes,
+           perf_hist_percentile(&poll_lat, 50) / 1000);
+    r->ok = ok && poll_bytes > ws_bytes;
+}
+
+static int upload_done(void)
+{
+    /* Keep the send buffer of the peer full */
+    if (st.sent < st.expect && !st.closed)
+        st.sent += sim_peer_tcp_write(&tx_buf[st.sent], st.expect - st.sent);
+    return st.closed;
+}
+
+static void scenario_upload(struct sim_result *r)
+{
+    static uint8_t body[UPLOAD_BYTES];
+    uint32_t i, hdr, bad = 0;
+
+    hdr = (uint32_t) snprintf((char *) tx_buf, sizeof(tx_buf),
+                              "POST /upload/fw HTTP/1.0\r\n"
+                              "Content-Type: application/octet-stream\r\n"
+                              "Content-Length: %u\r\n\r\n",
+                              UPLOAD_BYTES);
+    for (i = 0; i < UPLOAD_BYTES; i++)
+        tx_buf[hdr + i] = (uint8_t) (i * 7 + (i >> 8));
+    st.expect = hdr + UPLOAD_BYTES;
+    if (http_connect() != 0)
+        return;
+    sim_run(60000 * MS, upload_done);
+    if (!st.closed)
+        sim_peer_tcp_close();
+
+    if (flash.dev.read(&flash.dev, 0, body, UPLOAD_BYTES) != 0)
+        return;
+    for (i = 0; i < UPLOAD_BYTES; i++)
+        bad += body[i] != tx_buf[hdr + i];
+    r->bytes = st.sent;
+    r->ops = bad == 0;
+    r->ok = bad == 0 && flash.not_erased == 0 &&
+            memcmp(st.reply, "HTTP/1.0 200", 12) == 0 &&
+            strstr(st.reply, "\"result\":\"ok\"") != NULL;
+    if (!r->ok)
+        printf("[ERROR]: upload: %u bytes differ, reply %.40s\n", bad,
+               st.reply);
+}
+
+static void scenario_http_flash(struct sim_result *r)
+{
+    const struct flash_fs_stats *s = flash_fs_get_stats();
+    uint32_t blocks = s->hits + s->misses, delayed = s->delayed;
+
+    if (flash_file_load(&flash, WWW_ADDR, WWW_IMAGE) < 0 ||
+        flash_fs_mount(&flash.dev, WWW_ADDR) != 0) {
+        printf("[ERROR]: http_flash: cannot mount %s\n", WWW_IMAGE);
+        return;
+    }
+    http_get(r, "GET / HTTP/1.0\r\n\r\n", "Content-Type: text/html");
+    r->ok = r->ok && s->hits + s->misses > blocks && s->delayed > delayed;
+    flash_fs_unmount();
+}
+
+static void scenario_iperf(struct sim_result *r)
+{
+    if (sim_peer_iperf_start(LWIPERF_TCP_PORT_DEFAULT) != 0)
+        return;
+    sim_run(20000 * MS, is_done);
+    r->bytes = st.iperf_bytes;
+    r->ok = st.done > 0 && st.iperf_bytes > 0;
+    r->ops = r->ok;
+}
+
+static void scenario_tcp_client(struct sim_result *r)
+{
+    tcp_echoclient_connect();
+    sim_run(20000 * MS, tcp_client_done);
+    r->bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+               sim_link_get_stats(SIM_TO_PEER)->bytes;
+    r->ok = tcp_client_done();
+    r->ops = r->ok;
+}
+
+/* MQTT client of the device, published to and checked by the callbacks */
+static struct {
+    mqtt_client_t *client;
+    const char *topic;
+    struct pbuf *payload;
+    uint32_t count;         /* publishes to make */
+    uint32_t published;
+    uint32_t base;          /* publishes of the broker before */
+    uint32_t rx_msgs;       /* echoes received in full and intact */
+    uint32_t rx_off;        /* in the echo being received */
+    uint64_t rx_bytes;
+    int bad;
+} mq;
+
+static void mqtt_connection(mqtt_client_t *client, void *arg,
+                            mqtt_connection_status_t status)
+{
+    LWIP_UNUSED_ARG(client);
+    LWIP_UNUSED_ARG(arg);
+
+    st.connected = status == MQTT_CONNECT_ACCEPTED;
+    st.closed = !st.connected;
+}
+
+static void mqtt_subscribed(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    st.done = err == ERR_OK ? 1 : -1;
+}
+
+static void mqtt_incoming_publish(void *arg, const char *topic, u32_t tot_len)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    mq.rx_off = 0;
+    if (strcmp(topic, "echo/dev") != 0 || tot_len != MQTT_ECHO_SIZE)
+        mq.bad = 1;
+}
+
+static void mqtt_incoming_data(void *arg, const u8_t *data, u16_t len,
+                               u8_t flags)
+{
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(arg);
+
+    for (i = 0; i < len; i++)
+        if (data[i] != (uint8_t) (mq.rx_off + i))
+            mq.bad = 1;
+    mq.rx_off += len;
+    mq.rx_bytes += len;
+    if ((flags & MQTT_DATA_FLAG_LAST) && mq.rx_off == MQTT_ECHO_SIZE)
+        mq.rx_msgs++;
+}
+
+/* Publish as long as the client takes it, until the broker or the echoes
+   show all of them. At most MQTT_ECHO_WINDOW echoes are outstanding, the
+   broker drops those not fitting its send buffer. */
+static int mqtt_pump(void)
+{
+    int echo = strcmp(mq.topic, "echo/dev") == 0;
+
+    while (mq.published < mq.count &&
+           (!echo || mq.published - mq.rx_msgs < MQTT_ECHO_WINDOW) &&
+           mqtt_publish_pbuf(mq.client, mq.topic, mq.payload, 0, 0, NULL,
+                             NULL) == ERR_OK)
+        mq.published++;
+    if (st.closed || mq.bad)
+        return 1;
+    if (echo)
+        return mq.rx_msgs == mq.count;
+    return sim_peer_mqtt_get_stats()->publishes - mq.base == mq.count;
+}
+
+static void scenario_mqtt(struct sim_result *r)
+{
+    static const struct mqtt_connect_client_info_t info = {"netsim", NULL,
+                                                           NULL, 60};
+    struct pbuf *ref, *chain;
+    ip_addr_t broker;
+    uint64_t base_bytes;
+    uint32_t i;
+
+    memset(&mq, 0, sizeof(mq));
+    for (i = 0; i < MQTT_ECHO_SIZE; i++)
+        tx_buf[i] = (uint8_t) i;
+    /* caller-owned memory, and a chain of 3 pbufs */
+    ref = pbuf_alloc(PBUF_RAW, MQTT_PUB_SIZE, PBUF_REF);
+    chain = pbuf_alloc(PBUF_RAW, 1500, PBUF_RAM);
+    mq.client = mqtt_client_new();
+    if (ref == NULL || chain == NULL || mq.client == NULL)
+        goto out;
+    pbuf_cat(chain, pbuf_alloc(PBUF_RAW, 1500, PBUF_RAM));
+    pbuf_cat(chain, pbuf_alloc(PBUF_RAW, MQTT_ECHO_SIZE - 3000, PBUF_RAM));
+    ref->payload = tx_buf;
+    pbuf_take(chain, tx_buf, MQTT_ECHO_SIZE);
+
+    IP_ADDR4(&broker, 192, 168, 0, 220);
+    if (mqtt_client_connect(mq.client, &broker, MQTT_PORT, mqtt_connection,
+                            NULL, &info) != ERR_OK)
+        goto out;
+    mqtt_set_inpub_callback(mq.client, mqtt_incoming_publish,
+                            mqtt_incoming_data, NULL);
+    sim_run(5000 * MS, is_connected);
+    if (!st.connected)
+        goto out;
+
+    mq.topic = "telemetry/raw";
+    mq.payload = ref;
+    mq.count = MQTT_PUB_COUNT;
+    mq.base = sim_peer_mqtt_get_stats()->publishes;
+    base_bytes = sim_peer_mqtt_get_stats()->bytes;
+    sim_run(60000 * MS, mqtt_pump);
+
+    if (mqtt_subscribe(mq.client, "echo/#", 0, mqtt_subscribed, NULL) !=
+        ERR_OK)
+        goto out;
+    sim_run(5000 * MS, is_done);
+    mq.topic = "echo/dev";
+    mq.payload = chain;
+    mq.count = MQTT_ECHO_COUNT;
+    mq.published = 0;
+    sim_run(60000 * MS, mqtt_pump);
+
+    r->ops = sim_peer_mqtt_get_stats()->publishes - mq.base + mq.rx_msgs;
+    r->bytes = sim_peer_mqtt_get_stats()->bytes - base_bytes + mq.rx_bytes;
+    mqtt_disconnect(mq.client);
+    /* the client holds no reference to the payloads anymore */
+    r->ok = st.done > 0 && !mq.bad && mq.rx_msgs == MQTT_ECHO_COUNT &&
+            r->bytes == (uint64_t) MQTT_PUB_SIZE * MQTT_PUB_COUNT +
+                            2ULL * MQTT_ECHO_SIZE * MQTT_ECHO_COUNT &&
+            ref->ref == 1 && chain->ref == 1;
+    if (!r->ok)
+        printf("[ERROR]: mqtt: %u echoes (%u dropped) %lu bytes, bad %d, refs %u %u\n", mq.rx_msgs, sim_peer_mqtt_get_stats()->dropped, (unsigned long) mq.rx_bytes,
+               mq.bad, ref->ref, chain->ref);
+out:
+    if (mq.client != NULL)
+        mqtt_client_free(mq.client);
+    if (ref != NULL)
+        pbuf_free(ref);
+    if (chain != NULL)
+        pbuf_free(chain);
+}
+
+/* QoS 1 publishes, acknowledged ones make room for the next */
+static struct {
+    uint32_t cap; /* in flight, 0 for the window of the client */
+    int publishing;
+    uint32_t published;
+    uint32_t acked;
+    uint32_t failed;
+    uint64_t t0[256]; /* of the publishes in flight */
+} mr;
+
+static void mqtt_rtt_acked(void *arg, err_t err);
+
+static void mqtt_rtt_fill(void)
+{
+    while (mr.publishing &&
+           (mr.cap == 0 || mr.published - mr.acked < mr.cap)) {
+        mr.t0[mr.published % LWIP_ARRAYSIZE(mr.t0)] = m487_sys_time_ns();
+        if (mqtt_publish(mq.client, "telemetry/qos1", tx_buf, MQTT_RTT_SIZE,
+                         1, 0, mqtt_rtt_acked,
+                         (void *) (uintptr_t) mr.published) != ERR_OK)
+            break;
+        mr.published++;
+    }
+}
+
+static void mqtt_rtt_acked(void *arg, err_t err)
+{
+    uint32_t i = (uint32_t) (uintptr_t) arg % LWIP_ARRAYSIZE(mr.t0);
+
+    if (err == ERR_OK)
+        perf_hist_add(st.lat, (uint32_t) (m487_sys_time_ns() - mr.t0[i]));
+    else
+        mr.failed++;
+    mr.acked++;
+    mqtt_rtt_fill();
+}
+
+static int mqtt_rtt_pump(void)
+{
+    mqtt_rtt_fill();
+    return st.closed;
+}
+
+static int mqtt_rtt_idle(void)
+{
+    return st.closed ||
+           (mr.acked == mr.published && sim_link_next() == UINT64_MAX);
+}
+
+/* Publishes acknowledged per second, at most cap in flight */
+static uint32_t mqtt_rtt_phase(uint32_t cap, uint32_t *frames)
+{
+    uint32_t acked = mr.acked, published = mr.published;
+    uint32_t sent = sim_link_get_stats(SIM_TO_PEER)->frames;
+
+    mr.cap = cap;
+    mr.publishing = 1;
+    sim_run(MQTT_RTT_MS * MS, mqtt_rtt_pump);
+    acked = mr.acked - acked;
+    mr.publishing = 0;
+    sim_run(5000 * MS, mqtt_rtt_idle);
+    if (frames != NULL && mr.published > published)
+        *frames = sim_link_get_stats(SIM_TO_PEER)->frames - sent;
+    return acked * 1000 / MQTT_RTT_MS;
+}
+
+static void scenario_mqtt_rtt(struct sim_result *r)
+{
+    static const struct mqtt_connect_client_info_t info = {"netsim", NULL,
+                                                           NULL, 60};
+    static const uint32_t delays_us[] = {50, 500, 2500, 10000};
+    uint32_t i, delay = 0, fixed, windowed, frames = 0, published;
+    ip_addr_t broker;
+    int ok = 1;
+
+    memset(&mq, 0, sizeof(mq));
+    memset(&mr, 0, sizeof(mr));
+    mq.client = mqtt_client_new();
+    IP_ADDR4(&broker, 192, 168, 0, 220);
+    if (mq.client == NULL ||
+        mqtt_client_connect(mq.client, &broker, MQTT_PORT, mqtt_connection,
+                            NULL, &info) != ERR_OK)
+        goto out;
+    sim_run(5000 * MS, is_connected);
+    if (!st.connected)
+        goto out;
+
+    for (i = 0; i < LWIP_ARRAYSIZE(delays_us); i++) {
+        sim_run(5000 * MS, mqtt_rtt_idle);
+        if (i == 0)
+            delay = sim_link_set_delay(delays_us[i]);
+        else
+            sim_link_set_delay(delays_us[i]);
+        fixed = mqtt_rtt_phase(MQTT_RTT_FIXED, NULL);
+        published = mr.published;
+        windowed = mqtt_rtt_phase(0, &frames);
+        printf("[INFO]: mqtt_rtt: rtt %5u us: %6u/s with %u in flight, "
+               "%6u/s with the window (%u), %.1f publishes/frame\n",
+               2 * delays_us[i], fixed, MQTT_RTT_FIXED, windowed,
+               mq.client->req_window,
+               frames ? (double) (mr.published - published) / frames : 0.0);
+        ok &= windowed >= fixed;
+        if (i == LWIP_ARRAYSIZE(delays_us) - 1)
+            ok &= windowed > 2 * fixed;
+    }
+    sim_link_set_delay(delay);
+
+    r->ops = mr.acked;
+    r->bytes = (uint64_t) mr.acked * MQTT_RTT_SIZE;
+    mqtt_disconnect(mq.client);
+    r->ok = ok && !st.closed && mr.failed == 0 && mr.acked == mr.published;
+    if (!r->ok)
+        printf("[ERROR]: mqtt_rtt: %u of %u acknowledged, %u failed\n",
+               mr.acked, mr.published, mr.failed);
+out:
+    if (mq.client != NULL)
+        mqtt_client_free(mq.client);
+}
+
+/* Lookups of a client connecting to its server by name */
+static struct {
+    int found; /* 1 resolved, -1 not */
+    uint32_t cached;
+    uint32_t waited;
+    uint32_t failed; /* at once */
+} dl;
+
+static void dns_found(const char *name, const ip_addr_t *ipaddr, void *arg)
+{
+    LWIP_UNUSED_ARG(name);
+    LWIP_UNUSED_ARG(arg);
+
+    dl.found = ipaddr != NULL ? 1 : -1;
+}
+
+static int dns_is_found(void)
+{
+    return dl.found != 0;
+}
+
+/* ERR_OK once resolved, waiting for the server if it is not in the table */
+static err_t dns_resolve(const char *name)
+{
+    uint64_t t0 = m487_sys_time_ns();
+    ip_addr_t addr;
+    err_t err;
+
+    dl.found = 0;
+    err = dns_gethostbyname(name, &addr, dns_found, NULL);
+    if (err == ERR_OK) {
+        dl.cached++;
+        return ERR_OK;
+    }
+    if (err != ERR_INPROGRESS) {
+        dl.failed++;
+        return err;
+    }
+    dl.waited++;
+    sim_run(30000 * MS, dns_is_found);
+    perf_hist_add(st.lat, (uint32_t) LWIP_MIN(m487_sys_time_ns() - t0,
+                                              UINT32_MAX));
+    return dl.found == 1 ? ERR_OK : ERR_VAL;
+}
+
+static void scenario_dns(struct sim_result *r)
+{
+    const struct sim_peer_dns_stats *ds = sim_peer_dns_get_stats();
+    uint32_t i, q0, q1, nx, resolved = 0, failover_ms, retry_ms;
+    ip_addr_t server;
+    uint64_t t0;
+    int ok = 1;
+
+    memset(&dl, 0, sizeof(dl));
+    IP_ADDR4(&server, 192, 168, 0, 220);
+    dns_setserver(0, &server);
+    IP_ADDR4(&server, 192, 168, 0, 221);
+    dns_setserver(1, &server);
+    sim_peer_dns_set(0, DNS_SLOW_MS, 0);
+    sim_peer_dns_set(1, DNS_FAST_MS, 0);
+
+    /* TTL of 10 s, only the first lookup waits */
+    q0 = ds->queries[0];
+    q1 = ds->queries[1];
+    for (i = 0; i < DNS_LOOKUPS; i++) {
+        resolved += dns_resolve("broker.sim") == ERR_OK;
+        sim_run(1000 * MS, NULL);
+    }
+    q0 = ds->queries[0] - q0;
+    q1 = ds->queries[1] - q1;
+    printf("[INFO]: dns: %u lookups of a name with a TTL of 10 s: %u waited "
+           "for the server, %u queries, %u to the faster server\n",
+           DNS_LOOKUPS, dl.waited, q0 + q1, q1);
+    ok &= resolved == DNS_LOOKUPS && dl.waited == 1 && q0 + q1 >= 5 &&
+          q0 == 1;
+
+    /* NXDOMAIN with a negative TTL of 30 s */
+    nx = ds->nxdomain;
+    dl.failed = 0;
+    for (i = 0; i < DNS_NEG_LOOKUPS; i++) {
+        ok &= dns_resolve("nothere.sim") != ERR_OK;
+        sim_run(1000 * MS, NULL);
+    }
+    nx = ds->nxdomain - nx;
+    printf("[INFO]: dns: %u lookups of a name that does not exist: %u "
+           "failed at once, %u queries\n", DNS_NEG_LOOKUPS, dl.failed, nx);
+    ok &= nx == 2 && dl.failed == DNS_NEG_LOOKUPS - 2;
+
+    /* The faster server stops answering, then is ranked last */
+    sim_peer_dns_set(1, DNS_FAST_MS, 1);
+    t0 = m487_sys_time_ns();
+    ok &= dns_resolve("time.sim") == ERR_OK;
+    failover_ms = (uint32_t) ((m487_sys_time_ns() - t0) / MS);
+    q1 = ds->queries[1];
+    t0 = m487_sys_time_ns();
+    ok &= dns_resolve("broker.sim") == ERR_OK;
+    retry_ms = (uint32_t) ((m487_sys_time_ns() - t0) / MS);
+    printf("[INFO]: dns: failover to the slower server in %u ms, the next "
+           "name resolved by it in %u ms\n", failover_ms, retry_ms);
+    ok &= ds->queries[1] == q1 && retry_ms < 2 * DNS_SLOW_MS;
+    sim_peer_dns_set(1, DNS_FAST_MS, 0);
+
+    r->ops = dl.cached + dl.waited + dl.failed;
+    r->bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+               sim_link_get_stats(SIM_TO_PEER)->bytes;
+    r->ok = ok;
+}
+
+/*
+ * TFTP files of the device: written to the upload regions by
+ * flash_upload_tftp, upload/fw read back as far as it was last written
+ */
+static struct {
+    int open;
+    uint32_t off;
+    uint32_t len;
+} tftp_fw;
+
+static void *dev_tftp_open(const char *fname, const char *mode, u8_t write)
+{
+    if (write)
+        return flash_upload_tftp.open(fname, mode, write);
+    if (tftp_fw.open || strcmp(fname, "upload/fw") != 0)
+        return NULL;
+    tftp_fw.open = 1;
+    tftp_fw.off = 0;
+    tftp_fw.len = flash_upload_get_stats()->bytes;
+    return &tftp_fw;
+}
+
+static void dev_tftp_close(void *handle)
+{
+    if (handle == &tftp_fw)
+        tftp_fw.open = 0;
+    else
+        flash_upload_tftp.close(handle);
+}
+
+static int dev_tftp_read(void *handle, void *buf, int bytes)
+{
+    uint32_t n = LWIP_MIN((uint32_t) bytes, tftp_fw.len - tftp_fw.off);
+
+    LWIP_UNUSED_ARG(handle);
+
+    if (flash.dev.read(&flash.dev, upload_regions[0].addr + tftp_fw.off, buf,
+                       n) != 0)
+        return -1;
+    tftp_fw.off += n;
+    return (int) n;
+}
+
+static int dev_tftp_write(void *handle, struct pbuf *p)
+{
+    return flash_upload_tftp.write(handle, p);
+}
+
+static const struct tftp_context dev_tftp = {
+    dev_tftp_open,
+    dev_tftp_close,
+    dev_tftp_read,
+    dev_tftp_write,
+};
+
+static int tftp_done(void)
+{
+    return st.done != 0;
+}
+
+/* One transfer of tx_buf, its time in ms or 0 if it failed */
+static uint32_t tftp_transfer(int put, uint16_t blksize, uint16_t windowsize)
+{
+    static uint8_t back[TFTP_BYTES];
+    uint64_t t0 = m487_sys_time_ns();
+    uint32_t ms;
+    int err;
+
+    st.done = 0;
+    st.got = 0;
+    if (put)
+        err = sim_peer_tftp_put("upload/fw", tx_buf, TFTP_BYTES, blksize,
+                                windowsize);
+    else
+        err = sim_peer_tftp_get("upload/fw", back, sizeof(back), blksize,
+                                windowsize);
+    if (err != 0)
+        return 0;
+    sim_run(120000 * MS, tftp_done);
+    ms = (uint32_t) ((m487_sys_time_ns() - t0) / MS);
+    if (put && flash.dev.read(&flash.dev, upload_regions[0].addr, back,
+                              TFTP_BYTES) != 0)
+        return 0;
+    if (st.done != 1 || st.got != TFTP_BYTES ||
+        memcmp(back, tx_buf, TFTP_BYTES) != 0) {
+        printf("[ERROR]: tftp: %s of %u x %u failed at %u bytes\n",
+               put ? "put" : "get", blksize, windowsize, st.got);
+        return 0;
+    }
+    return LWIP_MAX(ms, 1);
+}
+
+static void scenario_tftp(struct sim_result *r)
+{
+    static const struct {
+        uint16_t blksize, windowsize; /* 0: option not asked for */
+    } opts[] = {{0, 0}, {1468, 0}, {1468, 4}};
+    static const uint32_t delays_us[] = {100, 5000};
+    const struct sim_peer_tftp_stats *ts = sim_peer_tftp_get_stats();
+    uint32_t i, j, delay = 0, put_ms[3], get_ms[3];
+    int ok = 1;
+
+    for (i = 0; i < TFTP_BYTES; i++)
+        tx_buf[i] = (uint8_t) (i * 13 + (i >> 9));
+
+    for (i = 0; i < LWIP_ARRAYSIZE(delays_us); i++) {
+        if (i == 0)
+            delay = sim_link_set_delay(delays_us[i]);
+        else
+            sim_link_set_delay(delays_us[i]);
+        for (j = 0; j < LWIP_ARRAYSIZE(opts); j++) {
+            put_ms[j] = tftp_transfer(1, opts[j].blksize, opts[j].windowsize);
+            get_ms[j] = tftp_transfer(0, opts[j].blksize, opts[j].windowsize);
+            ok &= put_ms[j] != 0 && get_ms[j] != 0 &&
+                  ts->blksize == LWIP_MAX(opts[j].blksize, 512) &&
+                  ts->windowsize == LWIP_MAX(opts[j].windowsize, 1);
+            r->ops += 2;
+            r->bytes += 2 * TFTP_BYTES;
+            printf("[INFO]: tftp: rtt %5u us: %4u x %u: put %5u ms "
+                   "%4u KiB/s, get %5u ms %4u KiB/s\n",
+                   2 * delays_us[i], ts->blksize, ts->windowsize, put_ms[j],
+                   TFTP_BYTES * 1000 / 1024 / LWIP_MAX(put_ms[j], 1),
+                   get_ms[j],
+                   TFTP_BYTES * 1000 / 1024 / LWIP_MAX(get_ms[j], 1));
+        }
+    }
+    sim_link_set_delay(delay);
+
+    /* at 10 ms the windows beat the round trips, writes down to the flash */
+    r->ok = ok && put_ms[2] * 3 < put_ms[0] && get_ms[2] * 8 < get_ms[0];
+}
+
+static int dhcp_is_bound(void)
+{
+    return dhcp_supplied_address(&gnetif);
+}
+
+/*
+ * Restart of the device: no address, the lease read back from the flash,
+ * then DHCP until bound.
+ * @return time to network in us, UINT32_MAX if not bound within 30 s
+ */
+static uint32_t dhcp_boot(void)
+{
+    uint64_t t0, ns;
+
+    /* the last lease programmed */
+    sim_run(10 * MS, NULL);
+    netif_set_addr(&gnetif, IP4_ADDR_ANY4, IP4_ADDR_ANY4, IP4_ADDR_ANY4);
+    if (flash_lease_init(&flash.dev, FLASH_LEASE_ADDR) != 0)
+        return UINT32_MAX;
+    t0 = m487_sys_time_ns();
+    if (dhcp_start(&gnetif) != ERR_OK)
+        return UINT32_MAX;
+    sim_run(30000 * MS, dhcp_is_bound);
+    if (!dhcp_is_bound())
+        return UINT32_MAX;
+    ns = m487_sys_time_ns() - t0;
+    perf_hist_add(st.lat, (uint32_t) ns);
+    return (uint32_t) (ns / 1000);
+}
+
+static int dhcp_bound_to(uint8_t host)
+{
+    ip4_addr_t addr;
+
+    IP4_ADDR(&addr, 192, 168, 0, host);
+    return dhcp_is_bound() && ip4_addr_cmp(netif_ip4_addr(&gnetif), &addr);
+}
+
+static void scenario_dhcp(struct sim_result *r)
+{
+    const struct sim_peer_dhcp_stats *ds = sim_peer_dhcp_get_stats();
+    const struct flash_lease_stats *ls = flash_lease_get_stats();
+    struct sim_peer_dhcp_stats d0;
+    struct dhcp_lease lease;
+    uint32_t cold_us, warm_us, taken_us, writes;
+    int ok = 1;
+
+    /* Nothing stored: DISCOVER, OFFER, REQUEST, ACK and the ARP check */
+    d0 = *ds;
+    writes = ls->writes;
+    cold_us = dhcp_boot();
+    ok &= dhcp_bound_to(23) && ds->discovers == d0.discovers + 1 &&
+          ds->requests == d0.requests + 1 && ls->writes == writes + 1;
+
+    /* The lease stored then, requested again while its address is probed */
+    d0 = *ds;
+    writes = ls->writes;
+    warm_us = dhcp_boot();
+    ok &= dhcp_bound_to(23) && ds->discovers == d0.discovers &&
+          ds->requests == d0.requests + 1 && ls->writes == writes;
+
+    /* A stored address the peer has, its ARP reply comes before the ACK */
+    IP4_ADDR(&lease.addr, 192, 168, 0, 221);
+    IP4_ADDR(&lease.netmask, 255, 255, 255, 0);
+    IP4_ADDR(&lease.gw, 192, 168, 0, 1);
+    IP4_ADDR(&lease.server, 192, 168, 0, 220);
+    lease.lease_time = 3600;
+    dhcp_lease_store(&gnetif, &lease);
+    d0 = *ds;
+    taken_us = dhcp_boot();
+    ok &= dhcp_bound_to(23) && ds->discovers == d0.discovers + 1 &&
+          ds->declines == d0.declines;
+    sim_run(10 * MS, NULL);
+    ok &= dhcp_lease_load(&gnetif, &lease) &&
+          ip4_addr_cmp(&lease.addr, netif_ip4_addr(&gnetif));
+
+    printf("[INFO]: dhcp: time to network %u.%03u ms from DISCOVER, "
+           "%u.%03u ms with the stored lease, %u.%03u ms when its address "
+           "is taken\n", cold_us / 1000, cold_us % 1000, warm_us / 1000,
+           warm_us % 1000, taken_us / 1000, taken_us % 1000);
+    ok &= warm_us < cold_us / 100;
+
+    r->ops = 3;
+    r->bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+               sim_link_get_stats(SIM_TO_PEER)->bytes;
+    r->ok = ok;
+}
+
+static void scenario_udp_client(struct sim_result *r)
+{
+    uint32_t i;
+
+    for (i = 0; i < UDP_CLIENT_COUNT; i++) {
+        st.expect = i + 1;
+        st.t0 = m487_sys_time_ns();
+        udp_echoclient_send();
+        sim_run(100 * MS, udp_client_done);
+    }
+    r->ops = st.udp_client_rx;
+    r->bytes = sim_link_get_stats(SIM_TO_DEV)->bytes +
+               sim_link_get_stats(SIM_TO_PEER)->bytes;
+    r->ok = st.udp_client_rx > 0 &&
+            (st.udp_client_rx == UDP_CLIENT_COUNT ||
+             sim_link_get_stats(SIM_TO_DEV)->lost +
+                     sim_link_get_stats(SIM_TO_PEER)->lost >=
+                 UDP_CLIENT_COUNT - st.udp_client_rx);
+}
+
+static int bench_in_iperf_server(void)
+{
+    const struct bench_case *c = bench_current();
+
+    return bench_done() || (c != NULL && c->kind == BENCH_IPERF_SERVER);
+}
+
+/* The iperf port of the device is taken by lwiperf_start_tcp_server_default */
+static void scenario_bench(struct sim_result *r)
+{
+    static struct bench_cfg cfg;
+    const struct bench_result *b;
+    uint32_t i;
+
+    BENCH_PEER(&cfg.peer);
+    cfg.iperf_port = LWIPERF_TCP_PORT_DEFAULT + 1;
+    cfg.echo_port = 7;
+    cfg.http_port = 80;
+    cfg.cases = bench_default_cases;
+    cfg.num_cases = bench_num_default_cases;
+    if (sim_peer_iperf_listen(cfg.iperf_port) != 0 ||
+        bench_start(&gnetif, &cfg) != 0)
+        return;
+    sim_run(60000 * MS, bench_in_iperf_server);
+    if (!bench_done())
+        sim_peer_iperf_start(cfg.iperf_port);
+    sim_run(120000 * MS, bench_done);
+
+    r->ok = bench_done();
+    for (i = 0; (b = bench_get_result(i)) != NULL; i++) {
+        r->bytes += b->rx_bytes + b->tx_bytes;
+        r->ops += b->ops;
+        if (b->ops == 0) {
+            printf("[ERROR]: bench: no operation in %s\n",
+                   bench_default_cases[i].name);
+            r->ok = 0;
+        }
+    }
+}
+
+static const struct {
+    const char *name;
+    void (*run)(struct sim_result *r);
+} scenarios[] = {
+    {"udp_echo", scenario_udp_echo},     {"tcp_echo", scenario_tcp_echo},
+    {"tcp_bulk", scenario_tcp_bulk},     {"http", scenario_http},
+    {"http_gz", scenario_http_gz},       {"http_ka", scenario_http_ka},
+    {"http_pipe", scenario_http_pipe},   {"http_lru", scenario_http_lru},
+    {"http_dyn", scenario_http_dyn},     {"ws", scenario_ws},
+    {"upload", scenario_upload},         {"http_flash", scenario_http_flash},
+    {"iperf", scenario_iperf},           {"tcp_client", scenario_tcp_client},
+    {"udp_client", scenario_udp_client}, {"bench", scenario_bench},
+    {"mqtt", scenario_mqtt},             {"mqtt_rtt", scenario_mqtt_rtt},
+    {"dns", scenario_dns},               {"tftp", scenario_tftp},
+    {"dhcp", scenario_dhcp},
+};
+
+static void scenario_run(int i, struct sim_result *r)
+{
+    const struct emac_model_stats *es = emac_model_get_stats();
+    const struct sim_link_stats *up, *down;
+    uint32_t irqs = es->irq_rx + es->irq_tx;
+    uint64_t t0 = m487_sys_time_ns();
+
+    memset(r, 0, sizeof(*r));
+    memset(&st, 0, sizeof(st));
+    st.lat = &r->lat;
+    r->name = scenarios[i].name;
+    sim_link_reset_stats();
+    dev_cpu_ns = 0;
+
+    scenarios[i].run(r);
+
+    r->duration_ns = m487_sys_time_ns() - t0;
+    r->dev_cpu_ns = dev_cpu_ns;
+    r->irqs = es->irq_rx + es->irq_tx - irqs;
+    up = sim_link_get_stats(SIM_TO_PEER);
+    down = sim_link_get_stats(SIM_TO_DEV);
+    r->frames = up->frames + down->frames;
+    r->lost = up->lost + up->queue_drops + down->lost + down->queue_drops;
+
+    /* Let the connections of the scenario finish */
+    st.lat = NULL;
+    sim_run(2000 * MS, NULL);
+}
+
+/*******************************************************************************
+ * Report
+ ******************************************************************************/
+static uint64_t result_kbps(const struct sim_result *r)
+{
+    if (r->duration_ns == 0)
+        return 0;
+    return r->bytes * 8ULL * 1000000ULL / r->duration_ns;
+}
+
+static uint64_t result_ops_per_s(const struct sim_result *r)
+{
+    if (r->duration_ns == 0)
+        return 0;
+    return r->ops * 1000000000ULL / r->duration_ns;
+}
+
+static uint64_t result_cpu_ns_per_op(const struct sim_result *r)
+{
+    if (r->ops == 0)
+        return 0;
+    return r->dev_cpu_ns / r->ops;
+}
+
+static uint64_t result_cpu_ns_per_kb(const struct sim_result *r)
+{
+    if (r->bytes == 0)
+        return 0;
+    return r->dev_cpu_ns * 1024ULL / r->bytes;
+}
+
+static void report_print(const struct sim_result *r, int n)
+{
+    int i;
+
+    printf("%-10s %2s %9s %10s %9s %6s %7s %8s %8s %8s %6s %7s %6s %10s "
+           "%9s %9s\n",
+           "scenario", "ok", "time_ms", "bytes", "kbps", "ops", "ops/s",
+           "p50_us", "p99_us", "max_us", "lost", "frames", "irqs",
+           "host_cpu_us", "ns/op", "ns/KiB");
+    for (i = 0; i < n; i++, r++) {
+        printf("%-10s %2d %9llu %10llu %9llu %6u %7llu %8u %8u %8u %6u %7u "
+               "%6u %10llu %9llu %9llu\n",
+               r->name, r->ok, (unsigned long long) (r->duration_ns / MS),
+               (unsigned long long) r->bytes,
+               (unsigned long long) result_kbps(r), r->ops,
+               (unsigned long long) result_ops_per_s(r),
+               perf_hist_percentile(&r->lat, 50) / 1000,
+               perf_hist_percentile(&r->lat, 99) / 1000, r->lat.max / 1000,
+               r->lost, r->frames, r->irqs,
+               (unsigned long long) (r->dev_cpu_ns / 1000),
+               (unsigned long long) result_cpu_ns_per_op(r),
+               (unsigned long long) result_cpu_ns_per_kb(r));
+    }
+}
+
+static int report_csv(const char *path, const char *tag,
+                      const struct sim_link_cfg *cfg,
+                      const struct sim_result *r, int n)
+{
+    FILE *fp = fopen(path, "a");
+    int i;
+
+    if (fp == NULL) {
+        printf("[ERROR]: cannot open %s\n", path);
+        return -1;
+    }
+    if (ftell(fp) == 0)
+        fprintf(fp, "tag,bandwidth_bps,delay_us,loss_ppm,seed,scenario,ok,"
+                    "duration_ms,bytes,throughput_kbps,ops,ops_per_s,"
+                    "lat_p50_us,lat_p99_us,lat_max_us,lost,frames,irqs,"
+                    "host_cpu_us,host_cpu_ns_per_op,host_cpu_ns_per_kib\n");
+    for (i = 0; i < n; i++, r++) {
+        fprintf(fp, "%s,%u,%u,%u,%u,%s,%d,%llu,%llu,%llu,%u,%llu,%u,%u,%u,%u,"
+                    "%u,%u,%llu,%llu,%llu\n",
+                tag, cfg->bandwidth_bps, cfg->delay_us, cfg->loss_ppm,
+                cfg->seed, r->name, r->ok,
+                (unsigned long long) (r->duration_ns / MS),
+                (unsigned long long) r->bytes,
+                (unsigned long long) result_kbps(r), r->ops,
+                (unsigned long long) result_ops_per_s(r),
+                perf_hist_percentile(&r->lat, 50) / 1000,
+                perf_hist_percentile(&r->lat, 99) / 1000, r->lat.max / 1000,
+                r->lost, r->frames, r->irqs,
+                (unsigned long long) (r->dev_cpu_ns / 1000),
+                (unsigned long long) result_cpu_ns_per_op(r),
+                (unsigned long long) result_cpu_ns_per_kb(r));
+    }
+    fclose(fp);
+    return 0;
+}
+
+/*******************************************************************************
+ * Main
+ ******************************************************************************/
+int main(int argc, char **argv)
+{
+    struct sim_link_cfg cfg = {
+        .bandwidth_bps = 100000000,
+        .delay_us = 100,
+        .loss_ppm = 0,
+        .queue_bytes = 64 * 1024,
+        .seed = 1,
+    };
+    struct sim_result res[sizeof(scenarios) / sizeof(scenarios[0])];
+    const char *csv = NULL, *tag = "-", *only = NULL;
+    uint64_t flash_read_ns = 0;
+    int i, n = 0, opt;
+
+    while ((opt = getopt(argc, argv, "b:d:l:q:f:s:S:o:t:")) != -1) {
+        switch (opt) {
+        case 'b':
+            cfg.bandwidth_bps = strtoul(optarg, NULL, 0);
+            break;
+        case 'd':
+            cfg.delay_us = strtoul(optarg, NULL, 0);
+            break;
+        case 'l':
+            cfg.loss_ppm = strtoul(optarg, NULL, 0);
+            break;
+        case 'q':
+            cfg.queue_bytes = strtoul(optarg, NULL, 0);
+            break;
+        case 'f':
+            flash_read_ns = strtoull(optarg, NULL, 0) * 1000;
+            break;
+        case 's':
+            cfg.seed = strtoul(optarg, NULL, 0);
+            break;
+        case 'S':
+            only = optarg;
+            break;
+        case 'o':
+            csv = optarg;
+            break;
+        case 't':
+            tag = optarg;
+            break;
+        default:
+            printf("usage: %s [-b bps] [-d delay_us] [-l loss_ppm] "
+                   "[-q queue_bytes] [-f flash_read_us] [-s seed] "
+                   "[-S scenario] [-o report.csv] [-t tag]\n",
+                   argv[0]);
+            return 1;
+        }
+    }
+
+    printf("[test]: Network simulation, %u bit/s, %u us, %u ppm loss\n\n",
+           cfg.bandwidth_bps, cfg.delay_us, cfg.loss_ppm);
+
+    /* LWIP_RAND() of both stacks, e.g. initial sequence numbers */
+    srand(cfg.seed);
+    sim_link_init(&cfg, link_deliver);
+    emac_model_reset();
+    emac_model_set_tx_fn(dev_tx, NULL);
+    lwip_layer_init();
+    udpecho_raw_init();
+    tcpecho_raw_init();
+    if (flash_file_open(&flash, NULL, FLASH_SIZE, m487_sys_time_ns) != 0 ||
+        flash_upload_init(&flash.dev, upload_regions,
+                          LWIP_ARRAYSIZE(upload_regions)) != 0 ||
+        flash_lease_init(&flash.dev, FLASH_LEASE_ADDR) != 0) {
+        printf("[ERROR]: flash stand-in\n");
+        return 1;
+    }
+    flash.read_latency_ns = flash_read_ns;
+    httpd_init();
+    http_set_dyn_handlers(http_dyns, LWIP_ARRAYSIZE(http_dyns));
+    http_set_ws_handlers(ws_handlers, LWIP_ARRAYSIZE(ws_handlers));
+    lwiperf_start_tcp_server_default(NULL, NULL);
+    tftp_init(&dev_tftp);
+    udp_echoclient_connect();
+    sim_peer_init();
+    next_tick = m487_sys_time_ns() + MS;
+
+    /* Settle the gratuitous ARPs */
+    sim_run(100 * MS, NULL);
+
+    for (i = 0; i < (int) (sizeof(scenarios) / sizeof(scenarios[0])); i++) {
+        if (only != NULL && strcmp(only, scenarios[i].name) != 0)
+            continue;
+        scenario_run(i, &res[n]);
+        fail += !res[n++].ok;
+    }
+    if (n == 0) {
+        printf("[ERROR]: unknown scenario %s\n", only);
+        return 1;
+    }
+
+    printf("\n");
+    report_print(res, n);
+    if (csv != NULL && report_csv(csv, tag, &cfg, res, n) != 0)
+        fail++;
+
+    flash_file_close(&flash);
+    printf("\n%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
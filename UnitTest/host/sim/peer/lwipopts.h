@@ -0,0 +1,60 @@
+#ifndef __LWIPOPTS_H__
+#define __LWIPOPTS_H__
+
+/*
+ * lwIP options of the simulated peer, the PC on the other end of the link.
+ * Sized like a desktop stack so that the device side is the bottleneck.
+ */
+
+#define LWIP_IPV4 1
+#define LWIP_IPV6 0
+
+#define SYS_LIGHTWEIGHT_PROT 0
+#define NO_SYS               1
+#define NO_SYS_NO_TIMERS     0
+
+/* ---------- Memory options ---------- */
+#define MEM_ALIGNMENT           8
+#define MEM_SIZE                (512 * 1024)
+#define MEMP_NUM_PBUF           256
+#define MEMP_NUM_UDP_PCB        8
+#define MEMP_NUM_TCP_PCB        16
+#define MEMP_NUM_TCP_PCB_LISTEN 8
+#define MEMP_NUM_TCP_SEG        512
+#define MEMP_NUM_SYS_TIMEOUT    16
+
+/* ---------- Pbuf options ---------- */
+#define PBUF_POOL_SIZE    512
+#define PBUF_POOL_BUFSIZE 1536
+
+/* ---------- TCP options ---------- */
+#define LWIP_TCP         1
+#define TCP_TTL          255
+#define TCP_QUEUE_OOSEQ  1
+#define TCP_MSS          1460
+#define TCP_SND_BUF      (32 * TCP_MSS)
+#define TCP_SND_QUEUELEN (4 * TCP_SND_BUF / TCP_MSS)
+#define TCP_WND          (32 * TCP_MSS)
+#define LWIP_WND_SCALE   1
+#define TCP_RCV_SCALE    2
+
+/* ---------- ICMP / DHCP / UDP options ---------- */
+#define LWIP_ICMP 1
+#define LWIP_DHCP 0
+#define LWIP_UDP  1
+#define UDP_TTL   255
+/* the DHCP server of sim_peer.c receives from 0.0.0.0 */
+#define LWIP_IP_ACCEPT_UDP_PORT(port) ((port) == PP_NTOHS(67))
+
+/* ---------- Statistics options ---------- */
+#define LWIP_STATS         0
+#define LWIP_PROVIDE_ERRNO 1
+
+/* ---------- API options ---------- */
+#define LWIP_NETCONN 0
+#define LWIP_SOCKET  0
+
+/* ---------- Debug options ---------- */
+#define LWIP_DEBUG 0
+
+#endif /* __LWIPOPTS_H__ */
@@ -0,0 +1,164 @@
+/**
+ * @file sim_link.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief In-memory Ethernet link of the network simulation.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "m487_sys.h"
+#include "sim_link.h"
+
+#define LINK_SLOTS      1024
+#define LINK_FRAME_SIZE 1536
+
+/* Preamble, SFD, FCS and inter frame gap on the wire */
+#define LINK_OVERHEAD 24
+
+/*
+ * With a constant delay frames of one direction arrive in order, a ring per
+ * direction is the whole event queue.
+ */
+struct link_dir {
+    uint8_t frame[LINK_SLOTS][LINK_FRAME_SIZE];
+    uint32_t len[LINK_SLOTS];
+    uint64_t arrive[LINK_SLOTS];
+    uint32_t head, tail;
+    uint64_t busy_until; /* end of serialization of the last frame */
+    struct sim_link_stats stats;
+};
+
+static struct link_dir dirs[2];
+static struct sim_link_cfg link_cfg;
+static sim_link_deliver_fn deliver_fn;
+static uint32_t rng;
+
+/*******************************************************************************
+ * Private Function
+ ******************************************************************************/
+
+/* xorshift32 */
+static uint32_t link_rand(void)
+{
+    rng ^= rng << 13;
+    rng ^= rng >> 17;
+    rng ^= rng << 5;
+    return rng;
+}
+
+/**
+ * Bytes still waiting for serialization in front of a new frame.
+ */
+static uint64_t link_backlog(const struct link_dir *d, uint64_t now)
+{
+    if (link_cfg.bandwidth_bps == 0 || d->busy_until <= now)
+        return 0;
+    return (d->busy_until - now) * link_cfg.bandwidth_bps / 8000000000ULL;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void sim_link_init(const struct sim_link_cfg *cfg, sim_link_deliver_fn fn)
+{
+    memset(dirs, 0, sizeof(dirs));
+    link_cfg = *cfg;
+    deliver_fn = fn;
+    rng = cfg->seed ? cfg->seed : 1;
+}
+
+uint32_t sim_link_set_delay(uint32_t delay_us)
+{
+    uint32_t prev = link_cfg.delay_us;
+
+    link_cfg.delay_us = delay_us;
+    return prev;
+}
+
+void sim_link_send(int dir, const uint8_t *frame, uint32_t len)
+{
+    struct link_dir *d = &dirs[dir];
+    uint64_t now = m487_sys_time_ns(), start;
+    uint32_t slot;
+
+    if (len > LINK_FRAME_SIZE)
+        len = LINK_FRAME_SIZE;
+
+    if (d->head - d->tail == LINK_SLOTS ||
+        (link_cfg.queue_bytes &&
+         link_backlog(d, now) + len > link_cfg.queue_bytes)) {
+        d->stats.queue_drops++;
+        return;
+    }
+
+    start = d->busy_until > now ? d->busy_until : now;
+    if (link_cfg.bandwidth_bps)
+        d->busy_until = start + (uint64_t)(len + LINK_OVERHEAD) * 8 *
+                                    1000000000ULL / link_cfg.bandwidth_bps;
+    else
+        d->busy_until = start;
+
+    d->stats.frames++;
+    d->stats.bytes += len;
+
+    /* A lost frame still occupies the wire */
+    if (link_cfg.loss_ppm && link_rand() % 1000000U < link_cfg.loss_ppm) {
+        d->stats.lost++;
+        return;
+    }
+
+    slot = d->head % LINK_SLOTS;
+    memcpy(d->frame[slot], frame, len);
+    d->len[slot] = len;
+    d->arrive[slot] = d->busy_until + (uint64_t) link_cfg.delay_us * 1000ULL;
+    d->head++;
+}
+
+uint64_t sim_link_next(void)
+{
+    uint64_t next = UINT64_MAX;
+    int i;
+
+    for (i = 0; i < 2; i++) {
+        if (dirs[i].tail != dirs[i].head &&
+            dirs[i].arrive[dirs[i].tail % LINK_SLOTS] < next)
+            next = dirs[i].arrive[dirs[i].tail % LINK_SLOTS];
+    }
+    return next;
+}
+
+void sim_link_deliver(uint64_t now_ns)
+{
+    struct link_dir *d;
+    uint32_t slot;
+    int i, more = 1;
+
+    /* Device bound frames first on a tie, keeps the order reproducible */
+    while (more) {
+        more = 0;
+        for (i = SIM_TO_DEV; i >= SIM_TO_PEER; i--) {
+            d = &dirs[i];
+            if (d->tail == d->head)
+                continue;
+            slot = d->tail % LINK_SLOTS;
+            if (d->arrive[slot] > now_ns)
+                continue;
+            d->tail++;
+            deliver_fn(i, d->frame[slot], d->len[slot]);
+            more = 1;
+        }
+    }
+}
+
+const struct sim_link_stats *sim_link_get_stats(int dir)
+{
+    return &dirs[dir].stats;
+}
+
+void sim_link_reset_stats(void)
+{
+    memset(&dirs[0].stats, 0, sizeof(dirs[0].stats));
+    memset(&dirs[1].stats, 0, sizeof(dirs[1].stats));
+}
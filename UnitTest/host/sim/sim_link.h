@@ -0,0 +1,75 @@
+/**
+ * @file sim_link.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief In-memory Ethernet link of the network simulation.
+ *
+ * Full duplex point to point link between the device (EMAC model) and the
+ * peer stack. Each direction serializes frames at the configured bandwidth,
+ * delays them and drops them with a seeded pseudo random loss, so a run
+ * depends only on its configuration.
+ */
+
+#ifndef __SIM_LINK_H__
+#define __SIM_LINK_H__
+
+#include <stdint.h>
+
+#define SIM_TO_PEER 0 /* sent by the device */
+#define SIM_TO_DEV  1 /* sent by the peer */
+
+struct sim_link_cfg {
+    uint32_t bandwidth_bps; /* 0 = unlimited */
+    uint32_t delay_us;      /* one way propagation delay */
+    uint32_t loss_ppm;      /* frame loss in parts per million */
+    uint32_t queue_bytes;   /* transmit queue, tail drop when full */
+    uint32_t seed;
+};
+
+struct sim_link_stats {
+    uint32_t frames;
+    uint64_t bytes;
+    uint32_t lost;
+    uint32_t queue_drops;
+};
+
+/** Called when a frame arrives at the end of direction dir */
+typedef void (*sim_link_deliver_fn)(int dir, const uint8_t *frame,
+                                    uint32_t len);
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Reset the link, drop the frames in flight.
+ */
+void sim_link_init(const struct sim_link_cfg *cfg, sim_link_deliver_fn fn);
+
+/**
+ * @brief Change the propagation delay of the frames sent from now on. Frames
+ *        of a direction must arrive in order, change it when the link is idle.
+ * @return The previous delay
+ */
+uint32_t sim_link_set_delay(uint32_t delay_us);
+
+/**
+ * @brief Put a frame on the wire at the current virtual time.
+ */
+void sim_link_send(int dir, const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Arrival time of the next frame, UINT64_MAX if the link is idle.
+ */
+uint64_t sim_link_next(void);
+
+/**
+ * @brief Deliver all frames arrived until now.
+ */
+void sim_link_deliver(uint64_t now_ns);
+
+const struct sim_link_stats *sim_link_get_stats(int dir);
+
+void sim_link_reset_stats(void);
+
+#endif /* __SIM_LINK_H__ */
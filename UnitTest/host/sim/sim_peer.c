@@ -0,0 +1,1177 @@
+/**
+ * @file sim_peer.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Simulated PC on the other end of the link, a second lwIP stack.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/apps/lwiperf.h"
+#include "lwip/etharp.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/tcp.h"
+#include "lwip/timeouts.h"
+#include "lwip/udp.h"
+#include "netif/ethernet.h"
+#include "tcpecho_raw.h"
+#include "udpecho_raw.h"
+
+#include "sim_link.h"
+#include "sim_peer.h"
+
+#define PEER_UDP_PORT 5000
+#define PEER_HELD_MAX 14
+#define PEER_HTTP_PORT 80
+#define PEER_MQTT_PORT 1883
+#define PEER_DNS_PORT 53
+#define PEER_DNS_DELAYED 16
+#define PEER_DNS_NEG_TTL 30 /* MINIMUM of the SOA record */
+#define PEER_TFTP_PORT 69
+#define PEER_TFTP_TIMEOUT_MS 500
+#define PEER_TFTP_RETRIES 10
+#define PEER_DHCP_SERVER_PORT 67
+#define PEER_DHCP_CLIENT_PORT 68
+#define PEER_DHCP_LEASE 3600
+
+static struct netif peer_netif;
+static struct udp_pcb *peer_udp;
+static struct tcp_pcb *peer_tcp;
+static ip_addr_t dev_addr;
+static struct tcp_pcb *held[PEER_HELD_MAX];
+static uint32_t held_count;
+
+/* MQTT broker stand-in, one client */
+static struct {
+    struct tcp_pcb *pcb;
+    uint8_t buf[16384];
+    uint32_t len;
+    int subscribed;
+    struct sim_peer_mqtt_stats stats;
+} broker;
+
+/* DNS server stand-in, on the two addresses of the peer */
+static const struct {
+    const char *name;
+    uint8_t addr[4];
+    uint32_t ttl;
+} dns_records[] = {
+    {"broker.sim", {192, 168, 0, 220}, 10},
+    {"time.sim", {192, 168, 0, 220}, 3600},
+};
+
+static struct netif peer_dns_netif;
+static struct {
+    struct udp_pcb *pcb;
+    uint32_t delay_ms[SIM_PEER_DNS_SERVERS];
+    int mute[SIM_PEER_DNS_SERVERS];
+    struct {
+        struct pbuf *p;
+        int server;
+        ip_addr_t addr;
+        u16_t port;
+    } delayed[PEER_DNS_DELAYED];
+    struct sim_peer_dns_stats stats;
+} dns;
+
+/* TFTP client, one transfer at a time. Blocks are counted from 1 without
+ * the 16 bit wrap, block b holds bytes [(b - 1) * blksize, b * blksize). */
+static struct {
+    struct udp_pcb *pcb;
+    int active;
+    int put;
+    u16_t port;         /* of the server, TFTP_PORT until it answers */
+    uint8_t *buf;
+    uint32_t len;       /* put: of the file, get: room in buf */
+    uint32_t got;       /* get: bytes received */
+    uint8_t req[64];    /* RRQ or WRQ, sent again until answered */
+    u16_t req_len;
+    int answered;
+    u16_t blksize;
+    u16_t windowsize;
+    uint32_t base;      /* put: first block not acknowledged, get: next one */
+    uint32_t sent;      /* put: last block sent */
+    uint32_t received;  /* get: blocks since the last ACK */
+    int ooo;            /* get: blocks out of order since ooo_blknum */
+    u16_t ooo_blknum;
+    int progress;       /* since the last timer tick */
+    uint32_t retries;
+    struct sim_peer_tftp_stats stats;
+} tftp;
+
+/* DHCP server stand-in, offers the address of the device */
+static struct {
+    struct udp_pcb *pcb;
+    struct sim_peer_dhcp_stats stats;
+} dhcp;
+
+/*******************************************************************************
+ * Private Function
+ ******************************************************************************/
+static err_t peer_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    static uint8_t frame[1536];
+    u16_t len;
+
+    LWIP_UNUSED_ARG(netif);
+
+    len = pbuf_copy_partial(p, frame, sizeof(frame), 0);
+    sim_link_send(SIM_TO_DEV, frame, len);
+    return ERR_OK;
+}
+
+static err_t peer_netif_init(struct netif *netif)
+{
+    static const uint8_t mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0xdc};
+    static const uint8_t dns_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0xdd};
+
+    netif->name[0] = 'p';
+    netif->name[1] = netif == &peer_dns_netif ? 'd' : 'c';
+    netif->output = etharp_output;
+    netif->linkoutput = peer_linkoutput;
+    netif->mtu = 1500;
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    memcpy(netif->hwaddr, netif == &peer_dns_netif ? dns_mac : mac,
+           ETH_HWADDR_LEN);
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP |
+                   NETIF_FLAG_ETHERNET | NETIF_FLAG_LINK_UP;
+    return ERR_OK;
+}
+
+static void peer_udp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                          const ip_addr_t *addr, u16_t port)
+{
+    static uint8_t buf[1536];
+    u16_t len;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    len = pbuf_copy_partial(p, buf, sizeof(buf), 0);
+    pbuf_free(p);
+    sim_on_udp_recv(buf, len);
+}
+
+static err_t peer_tcp_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                           err_t err)
+{
+    struct pbuf *q;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL) {
+        tcp_arg(pcb, NULL);
+        tcp_recv(pcb, NULL);
+        tcp_sent(pcb, NULL);
+        tcp_err(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK)
+            tcp_abort(pcb);
+        peer_tcp = NULL;
+        sim_on_tcp_recv(NULL, 0);
+        return ERR_OK;
+    }
+
+    tcp_recved(pcb, p->tot_len);
+    for (q = p; q != NULL; q = q->next)
+        sim_on_tcp_recv((const uint8_t *) q->payload, q->len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static err_t peer_tcp_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+
+    sim_on_tcp_sent(len);
+    return ERR_OK;
+}
+
+static void peer_tcp_err(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    peer_tcp = NULL;
+    sim_on_tcp_recv(NULL, 0);
+}
+
+static err_t peer_tcp_connected(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+
+    sim_on_tcp_connected(err);
+    return ERR_OK;
+}
+
+static void peer_held_close(struct tcp_pcb *pcb)
+{
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, NULL);
+    tcp_err(pcb, NULL);
+    if (tcp_close(pcb) != ERR_OK)
+        tcp_abort(pcb);
+}
+
+static err_t peer_held_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                            err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL) {
+        held[(uintptr_t) arg] = NULL;
+        peer_held_close(pcb);
+        return ERR_OK;
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_free(p);
+    return ERR_OK;
+}
+
+static void peer_held_err(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(err);
+
+    held[(uintptr_t) arg] = NULL;
+}
+
+static void peer_iperf_report(void *arg, enum lwiperf_report_type report_type,
+                              const ip_addr_t *local_addr, u16_t local_port,
+                              const ip_addr_t *remote_addr, u16_t remote_port,
+                              u32_t bytes_transferred, u32_t ms_duration,
+                              u32_t bandwidth_kbitpsec)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(local_addr);
+    LWIP_UNUSED_ARG(local_port);
+    LWIP_UNUSED_ARG(remote_addr);
+    LWIP_UNUSED_ARG(remote_port);
+
+    sim_on_iperf_report(report_type == LWIPERF_TCP_DONE_CLIENT,
+                        bytes_transferred, ms_duration, bandwidth_kbitpsec);
+}
+
+/* The body of GET /<n> is n bytes, remaining ones in the arg of the pcb */
+static void peer_http_send(struct tcp_pcb *pcb)
+{
+    static const uint8_t body[1024];
+    uintptr_t left = (uintptr_t) pcb->callback_arg;
+    u16_t n;
+
+    while (left > 0) {
+        n = (u16_t) LWIP_MIN(LWIP_MIN(left, sizeof(body)), tcp_sndbuf(pcb));
+        if (n == 0 || tcp_write(pcb, body, n, 0) != ERR_OK)
+            break;
+        left -= n;
+    }
+    tcp_arg(pcb, (void *) left);
+    tcp_output(pcb);
+    if (left == 0) {
+        tcp_recv(pcb, NULL);
+        tcp_sent(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK)
+            tcp_abort(pcb);
+    }
+}
+
+static err_t peer_http_sent(void *arg, struct tcp_pcb *pcb, u16_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(len);
+
+    peer_http_send(pcb);
+    return ERR_OK;
+}
+
+static err_t peer_http_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                            err_t err)
+{
+    char req[64], hdr[96];
+    unsigned long n;
+    int len;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL) {
+        tcp_recv(pcb, NULL);
+        tcp_sent(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK)
+            tcp_abort(pcb);
+        return ERR_OK;
+    }
+    tcp_recved(pcb, p->tot_len);
+    req[pbuf_copy_partial(p, req, sizeof(req) - 1, 0)] = '\0';
+    pbuf_free(p);
+    /* the request fits in one segment, the rest of it is ignored */
+    if (pcb->sent != NULL || strncmp(req, "GET /", 5) != 0)
+        return ERR_OK;
+    n = strtoul(&req[5], NULL, 10);
+    len = snprintf(hdr, sizeof(hdr),
+                   "HTTP/1.0 200 OK\r\nContent-Length: %lu\r\n\r\n", n);
+    tcp_write(pcb, hdr, (u16_t) len, TCP_WRITE_FLAG_COPY);
+    tcp_arg(pcb, (void *) (uintptr_t) n);
+    tcp_sent(pcb, peer_http_sent);
+    peer_http_send(pcb);
+    return ERR_OK;
+}
+
+static err_t peer_http_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (err != ERR_OK || pcb == NULL)
+        return ERR_VAL;
+    tcp_arg(pcb, NULL);
+    tcp_recv(pcb, peer_http_recv);
+    return ERR_OK;
+}
+
+static void peer_mqtt_write(const void *data, uint32_t len)
+{
+    if (tcp_sndbuf(broker.pcb) < len ||
+        tcp_write(broker.pcb, data, (u16_t) len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        broker.stats.dropped++;
+}
+
+static void peer_mqtt_ack(uint8_t type, const uint8_t *id)
+{
+    const uint8_t ack[4] = {type, 2, id[0], id[1]};
+
+    peer_mqtt_write(ack, sizeof(ack));
+}
+
+/* PUBLISH to echo/... sent back with QoS 0 once the client subscribed */
+static void peer_mqtt_echo(const uint8_t *topic, uint16_t topic_len,
+                           const uint8_t *payload, uint32_t len)
+{
+    uint8_t hdr[8];
+    uint32_t rem = 2 + topic_len + len, n = 1;
+
+    if (!broker.subscribed || topic_len < 5 || memcmp(topic, "echo/", 5))
+        return;
+    if (tcp_sndbuf(broker.pcb) < 7 + rem) {
+        broker.stats.dropped++;
+        return;
+    }
+    hdr[0] = 0x30;
+    do {
+        hdr[n++] = (uint8_t) ((rem & 0x7f) | (rem >= 128 ? 0x80 : 0));
+        rem >>= 7;
+    } while (rem > 0);
+    hdr[n++] = (uint8_t) (topic_len >> 8);
+    hdr[n++] = (uint8_t) topic_len;
+    peer_mqtt_write(hdr, n);
+    peer_mqtt_write(topic, topic_len);
+    peer_mqtt_write(payload, len);
+    broker.stats.echoed++;
+}
+
+/* One complete packet, type and flags in pkt[0], var is its variable part */
+static void peer_mqtt_packet(const uint8_t *pkt, const uint8_t *var,
+                             uint32_t rem)
+{
+    static const uint8_t connack[4] = {0x20, 2, 0, 0};
+    static const uint8_t pingresp[2] = {0xd0, 0};
+    uint8_t qos = (pkt[0] >> 1) & 3, suback[5];
+    uint16_t topic_len;
+    uint32_t off;
+
+    switch (pkt[0] >> 4) {
+    case 1: /* CONNECT */
+        peer_mqtt_write(connack, sizeof(connack));
+        break;
+    case 3: /* PUBLISH */
+        topic_len = (uint16_t) ((var[0] << 8) | var[1]);
+        off = 2 + topic_len + (qos ? 2 : 0);
+        if (off > rem)
+            break;
+        broker.stats.publishes++;
+        broker.stats.bytes += rem - off;
+        if (qos == 1)
+            peer_mqtt_ack(0x40, &var[off - 2]);
+        else if (qos == 2)
+            peer_mqtt_ack(0x50, &var[off - 2]);
+        peer_mqtt_echo(&var[2], topic_len, &var[off], rem - off);
+        break;
+    case 6: /* PUBREL */
+        peer_mqtt_ack(0x70, var);
+        break;
+    case 8: /* SUBSCRIBE, one topic, granted its QoS */
+        suback[0] = 0x90;
+        suback[1] = 3;
+        suback[2] = var[0];
+        suback[3] = var[1];
+        suback[4] = var[rem - 1];
+        peer_mqtt_write(suback, sizeof(suback));
+        broker.subscribed = 1;
+        break;
+    case 10: /* UNSUBSCRIBE */
+        peer_mqtt_ack(0xb0, var);
+        broker.subscribed = 0;
+        break;
+    case 12: /* PINGREQ */
+        peer_mqtt_write(pingresp, sizeof(pingresp));
+        break;
+    }
+}
+
+static err_t peer_mqtt_recv(void *arg, struct tcp_pcb *pcb, struct pbuf *p,
+                            err_t err)
+{
+    uint32_t used = 0, hdr, rem, shift;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    if (p == NULL || broker.len + p->tot_len > sizeof(broker.buf)) {
+        if (p != NULL)
+            pbuf_free(p);
+        tcp_recv(pcb, NULL);
+        if (tcp_close(pcb) != ERR_OK)
+            tcp_abort(pcb);
+        broker.pcb = NULL;
+        return p == NULL ? ERR_OK : ERR_ABRT;
+    }
+    tcp_recved(pcb, p->tot_len);
+    pbuf_copy_partial(p, &broker.buf[broker.len], p->tot_len, 0);
+    broker.len += p->tot_len;
+    pbuf_free(p);
+
+    /* complete packets: type, remaining length of 1 to 4 bytes, rest */
+    while (broker.len - used >= 2) {
+        for (hdr = 1, rem = 0, shift = 0; hdr < 5; shift += 7) {
+            if (used + hdr >= broker.len)
+                break;
+            rem |= (uint32_t) (broker.buf[used + hdr] & 0x7f) << shift;
+            if (!(broker.buf[used + hdr++] & 0x80))
+                break;
+        }
+        if (used + hdr + rem > broker.len || (broker.buf[used + hdr - 1] & 0x80))
+            break;
+        peer_mqtt_packet(&broker.buf[used], &broker.buf[used + hdr], rem);
+        used += hdr + rem;
+    }
+    memmove(broker.buf, &broker.buf[used], broker.len - used);
+    broker.len -= used;
+    tcp_output(pcb);
+    return ERR_OK;
+}
+
+static void peer_mqtt_err(void *arg, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(err);
+
+    broker.pcb = NULL;
+}
+
+static err_t peer_mqtt_accept(void *arg, struct tcp_pcb *pcb, err_t err)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (err != ERR_OK || pcb == NULL || broker.pcb != NULL)
+        return ERR_VAL;
+    broker.pcb = pcb;
+    broker.len = 0;
+    broker.subscribed = 0;
+    tcp_nagle_disable(pcb);
+    tcp_recv(pcb, peer_mqtt_recv);
+    tcp_err(pcb, peer_mqtt_err);
+    return ERR_OK;
+}
+
+/* Answer from the address of server, peer_netif routes to the device */
+static void peer_dns_send(struct pbuf *p, int server, const ip_addr_t *addr,
+                          u16_t port)
+{
+    ip_addr_t src;
+
+    IP_ADDR4(&src, 192, 168, 0, 220 + server);
+    udp_sendto_if_src(dns.pcb, p, addr, port, &peer_netif, &src);
+    pbuf_free(p);
+}
+
+static void peer_dns_send_delayed(void *arg)
+{
+    uint32_t i = (uint32_t) (uintptr_t) arg;
+
+    peer_dns_send(dns.delayed[i].p, dns.delayed[i].server,
+                  &dns.delayed[i].addr, dns.delayed[i].port);
+    dns.delayed[i].p = NULL;
+}
+
+static void put16(uint8_t *b, uint16_t v)
+{
+    b[0] = (uint8_t) (v >> 8);
+    b[1] = (uint8_t) v;
+}
+
+static void put32(uint8_t *b, uint32_t v)
+{
+    put16(b, (uint16_t) (v >> 16));
+    put16(b + 2, (uint16_t) v);
+}
+
+/*
+ * A query for one name of dns_records gets its address, any other name
+ * NXDOMAIN and another type than A an empty answer, both with a SOA record
+ * for the negative TTL.
+ */
+static void peer_dns_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                          const ip_addr_t *addr, u16_t port)
+{
+    uint8_t q[512], r[600];
+    char name[256];
+    uint32_t qlen, n = 0, i, len, found = LWIP_ARRAYSIZE(dns_records);
+    int server = ip4_addr4(ip_2_ip4(ip_current_dest_addr())) - 220;
+    struct pbuf *out;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+
+    qlen = pbuf_copy_partial(p, q, sizeof(q), 0);
+    pbuf_free(p);
+    if (server < 0 || server >= SIM_PEER_DNS_SERVERS || qlen < 17 ||
+        (q[2] & 0x80) || q[4] != 0 || q[5] != 1)
+        return;
+    dns.stats.queries[server]++;
+    if (dns.mute[server])
+        return;
+
+    /* question name, as dotted string */
+    for (i = 12; i < qlen && q[i] != 0; i += len + 1) {
+        len = q[i];
+        if (len > 63 || i + 1 + len >= qlen || n + len + 1 >= sizeof(name))
+            return;
+        if (n > 0)
+            name[n++] = '.';
+        memcpy(&name[n], &q[i + 1], len);
+        n += len;
+    }
+    name[n] = '\0';
+    if (i + 5 > qlen)
+        return;
+    qlen = i + 5; /* the question */
+    for (i = 0; i < LWIP_ARRAYSIZE(dns_records); i++)
+        if (strcmp(name, dns_records[i].name) == 0)
+            found = i;
+
+    memcpy(r, q, qlen);
+    r[2] = 0x80 | (q[2] & 0x01); /* response, RD copied */
+    r[3] = 0x80;                 /* RA */
+    memset(&r[6], 0, 6);
+    len = qlen;
+    if (found < LWIP_ARRAYSIZE(dns_records) && q[qlen - 3] == 1) {
+        put16(&r[6], 1);
+        put16(&r[len], 0xc00c); /* name of the question */
+        put16(&r[len + 2], 1);  /* A */
+        put16(&r[len + 4], 1);  /* IN */
+        put32(&r[len + 6], dns_records[found].ttl);
+        put16(&r[len + 10], 4);
+        memcpy(&r[len + 12], dns_records[found].addr, 4);
+        len += 16;
+    } else {
+        if (found == LWIP_ARRAYSIZE(dns_records)) {
+            r[3] |= 3; /* NXDOMAIN */
+            dns.stats.nxdomain++;
+        }
+        put16(&r[8], 1);
+        put16(&r[len], 0xc00c);
+        put16(&r[len + 2], 6); /* SOA */
+        put16(&r[len + 4], 1);
+        put32(&r[len + 6], 2 * PEER_DNS_NEG_TTL);
+        put16(&r[len + 10], 22);
+        memset(&r[len + 12], 0, 2); /* MNAME and RNAME, the root */
+        put32(&r[len + 14], 1);     /* SERIAL */
+        put32(&r[len + 18], 3600);  /* REFRESH */
+        put32(&r[len + 22], 600);   /* RETRY */
+        put32(&r[len + 26], 86400); /* EXPIRE */
+        put32(&r[len + 30], PEER_DNS_NEG_TTL);
+        len += 34;
+    }
+
+    out = pbuf_alloc(PBUF_TRANSPORT, (u16_t) len, PBUF_RAM);
+    if (out == NULL)
+        return;
+    pbuf_take(out, r, (u16_t) len);
+    if (dns.delay_ms[server] == 0) {
+        peer_dns_send(out, server, addr, port);
+        return;
+    }
+    for (i = 0; i < PEER_DNS_DELAYED && dns.delayed[i].p != NULL; i++)
+        ;
+    if (i == PEER_DNS_DELAYED) {
+        pbuf_free(out);
+        return;
+    }
+    dns.delayed[i].p = out;
+    dns.delayed[i].server = server;
+    ip_addr_copy(dns.delayed[i].addr, *addr);
+    dns.delayed[i].port = port;
+    sys_timeout(dns.delay_ms[server], peer_dns_send_delayed,
+                (void *) (uintptr_t) i);
+}
+
+/*
+ * DISCOVER gets an OFFER of 192.168.0.23, REQUEST an ACK of the address
+ * asked for if it is on 192.168.0.0/24, else a NAK. Answers are broadcast.
+ */
+static void peer_dhcp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                           const ip_addr_t *addr, u16_t port)
+{
+    static const uint8_t pool[4] = {192, 168, 0, 23};
+    uint8_t q[576], r[300];
+    uint8_t type = 0, reply;
+    const uint8_t *req = NULL, *server = NULL;
+    uint32_t qlen, i, len;
+    struct pbuf *out;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+    LWIP_UNUSED_ARG(port);
+
+    qlen = pbuf_copy_partial(p, q, sizeof(q), 0);
+    pbuf_free(p);
+    if (qlen < 244 || q[0] != 1 || q[236] != 99 || q[237] != 130 ||
+        q[238] != 83 || q[239] != 99)
+        return;
+    i = 240;
+    while (i < qlen && q[i] != 255) {
+        if (q[i] == 0) { /* pad */
+            i++;
+            continue;
+        }
+        if (i + 2 > qlen || i + 2 + q[i + 1] > qlen)
+            return;
+        len = q[i + 1];
+        if (q[i] == 53 && len == 1)
+            type = q[i + 2];
+        else if (q[i] == 50 && len == 4)
+            req = &q[i + 2];
+        else if (q[i] == 54 && len == 4)
+            server = &q[i + 2];
+        i += 2 + len;
+    }
+
+    switch (type) {
+    case 1: /* DISCOVER */
+        dhcp.stats.discovers++;
+        break;
+    case 3: /* REQUEST */
+        if (server != NULL && server[3] != 220)
+            return; /* for another server */
+        dhcp.stats.requests++;
+        break;
+    case 4: /* DECLINE */
+        dhcp.stats.declines++;
+        return;
+    default:
+        return;
+    }
+
+    memset(r, 0, sizeof(r));
+    memcpy(r, q, 240); /* xid, flags, giaddr, chaddr and the cookie */
+    r[0] = 2;
+    memset(&r[12], 0, 4);
+    memset(&r[44], 0, 192); /* sname and file */
+    len = 240;
+    if (type == 1) {
+        memcpy(&r[16], pool, 4);
+        reply = 2; /* OFFER */
+    } else {
+        if (req == NULL)
+            req = &q[12]; /* ciaddr, renewing */
+        if (req[0] == 192 && req[1] == 168 && req[2] == 0 && req[3] != 0 &&
+            req[3] != 255) {
+            memcpy(&r[16], req, 4);
+            dhcp.stats.acks++;
+            reply = 5; /* ACK */
+        } else {
+            dhcp.stats.naks++;
+            reply = 6; /* NAK */
+        }
+    }
+    r[len++] = 53;
+    r[len++] = 1;
+    r[len++] = reply;
+    r[len++] = 54;
+    r[len++] = 4;
+    memcpy(&r[len], (const uint8_t[]){192, 168, 0, 220}, 4);
+    len += 4;
+    if (reply != 6) {
+        r[len++] = 51;
+        r[len++] = 4;
+        put32(&r[len], PEER_DHCP_LEASE);
+        len += 4;
+        r[len++] = 1;
+        r[len++] = 4;
+        memcpy(&r[len], (const uint8_t[]){255, 255, 255, 0}, 4);
+        len += 4;
+        r[len++] = 3;
+        r[len++] = 4;
+        memcpy(&r[len], (const uint8_t[]){192, 168, 0, 1}, 4);
+        len += 4;
+    }
+    r[len++] = 255;
+
+    out = pbuf_alloc(PBUF_TRANSPORT, (u16_t) len, PBUF_RAM);
+    if (out == NULL)
+        return;
+    pbuf_take(out, r, (u16_t) len);
+    udp_sendto_if(dhcp.pcb, out, IP_ADDR_BROADCAST, PEER_DHCP_CLIENT_PORT,
+                  &peer_netif);
+    pbuf_free(out);
+}
+
+static void peer_tftp_tmr(void *arg);
+
+static void peer_tftp_send(const void *data, u16_t len)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+
+    if (p == NULL)
+        return;
+    pbuf_take(p, data, len);
+    udp_sendto(tftp.pcb, p, &dev_addr, tftp.port);
+    pbuf_free(p);
+}
+
+static void peer_tftp_ack(u16_t blknum)
+{
+    uint8_t ack[4];
+
+    put16(ack, 4);
+    put16(&ack[2], blknum);
+    peer_tftp_send(ack, sizeof(ack));
+}
+
+static uint32_t peer_tftp_last_block(void)
+{
+    return tftp.len / tftp.blksize + 1;
+}
+
+/* Blocks from tftp.base to the end of the window */
+static void peer_tftp_send_window(void)
+{
+    static uint8_t block[4 + 65464];
+    uint32_t b, off, n;
+
+    for (b = tftp.base;
+         b < tftp.base + tftp.windowsize && b <= peer_tftp_last_block(); b++) {
+        off = (b - 1) * tftp.blksize;
+        n = LWIP_MIN(tftp.blksize, tftp.len - off);
+        put16(block, 3);
+        put16(&block[2], (uint16_t) b);
+        memcpy(&block[4], &tftp.buf[off], n);
+        peer_tftp_send(block, (u16_t) (4 + n));
+        tftp.sent = b;
+    }
+}
+
+static void peer_tftp_done(int ok)
+{
+    tftp.active = 0;
+    sys_untimeout(peer_tftp_tmr, NULL);
+    sim_on_tftp_done(ok, tftp.put ? tftp.len : tftp.got);
+}
+
+static void peer_tftp_tmr(void *arg)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (!tftp.active)
+        return;
+    sys_timeout(PEER_TFTP_TIMEOUT_MS, peer_tftp_tmr, NULL);
+    if (tftp.progress) {
+        tftp.progress = 0;
+        tftp.retries = 0;
+        return;
+    }
+    if (++tftp.retries > PEER_TFTP_RETRIES) {
+        peer_tftp_done(0);
+        return;
+    }
+    tftp.stats.timeouts++;
+    if (!tftp.answered)
+        peer_tftp_send(tftp.req, tftp.req_len);
+    else if (tftp.put)
+        peer_tftp_send_window();
+    else
+        peer_tftp_ack((u16_t) (tftp.base - 1));
+}
+
+/* Values of the options granted by an OACK */
+static void peer_tftp_oack(const uint8_t *pkt, uint32_t len)
+{
+    const char *name, *value;
+    uint32_t i = 2;
+
+    while (i < len) {
+        name = (const char *) &pkt[i];
+        i += strnlen(name, len - i) + 1;
+        if (i >= len)
+            break;
+        value = (const char *) &pkt[i];
+        i += strnlen(value, len - i) + 1;
+        if (strcmp(name, "blksize") == 0)
+            tftp.blksize = (u16_t) atoi(value);
+        else if (strcmp(name, "windowsize") == 0)
+            tftp.windowsize = (u16_t) atoi(value);
+    }
+    tftp.stats.blksize = tftp.blksize;
+    tftp.stats.windowsize = tftp.windowsize;
+}
+
+static void peer_tftp_recv(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                           const ip_addr_t *addr, u16_t port)
+{
+    static uint8_t pkt[4 + 65464];
+    uint32_t len, n, acked;
+    uint16_t op, blknum;
+
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(pcb);
+    LWIP_UNUSED_ARG(addr);
+
+    len = pbuf_copy_partial(p, pkt, sizeof(pkt) - 1, 0);
+    pbuf_free(p);
+    if (!tftp.active || len < 2)
+        return;
+    pkt[len] = 0;
+    op = (uint16_t) (pkt[0] << 8 | pkt[1]);
+    blknum = len >= 4 ? (uint16_t) (pkt[2] << 8 | pkt[3]) : 0;
+    tftp.port = port;
+
+    if (op == 6 && !tftp.answered) {
+        /* OACK */
+        tftp.answered = 1;
+        tftp.progress = 1;
+        peer_tftp_oack(pkt, len);
+        if (tftp.put)
+            peer_tftp_send_window();
+        else
+            peer_tftp_ack(0);
+    } else if (op == 5) {
+        printf("[ERROR]: tftp: error %u from the device: %s\n", blknum,
+               len > 4 ? (const char *) &pkt[4] : "");
+        peer_tftp_done(0);
+    } else if (op == 4 && tftp.put) {
+        if (!tftp.answered) {
+            /* ACK 0 without OACK, the options were not granted */
+            if (blknum != 0)
+                return;
+            tftp.answered = 1;
+            tftp.progress = 1;
+            peer_tftp_send_window();
+            return;
+        }
+        acked = (uint16_t) (blknum + 1 - tftp.base);
+        if (acked > tftp.sent + 1 - tftp.base)
+            return;
+        tftp.progress = 1;
+        tftp.base += acked;
+        if (tftp.base > peer_tftp_last_block())
+            peer_tftp_done(1);
+        else if (acked > 0)
+            peer_tftp_send_window();
+    } else if (op == 3 && !tftp.put && len >= 4) {
+        /* DATA 1 without OACK, the options were not granted */
+        tftp.answered = 1;
+        if (blknum != (uint16_t) tftp.base) {
+            /* ACK the last block in order, once per run */
+            if (!tftp.ooo || (uint16_t) (tftp.ooo_blknum - blknum) < 0x8000) {
+                tftp.received = 0;
+                peer_tftp_ack((u16_t) (tftp.base - 1));
+            }
+            tftp.ooo = 1;
+            tftp.ooo_blknum = blknum;
+            return;
+        }
+        n = len - 4;
+        if (tftp.got + n > tftp.len) {
+            peer_tftp_done(0);
+            return;
+        }
+        memcpy(&tftp.buf[tftp.got], &pkt[4], n);
+        tftp.got += n;
+        tftp.ooo = 0;
+        tftp.progress = 1;
+        tftp.base++;
+        if (n < tftp.blksize) {
+            peer_tftp_ack(blknum);
+            peer_tftp_done(1);
+        } else if (++tftp.received >= tftp.windowsize) {
+            tftp.received = 0;
+            peer_tftp_ack(blknum);
+        }
+    }
+}
+
+static int peer_tftp_start(int put, const char *name, uint8_t *buf,
+                           uint32_t len, uint16_t blksize, uint16_t windowsize)
+{
+    struct udp_pcb *pcb = tftp.pcb;
+    uint32_t n;
+
+    if (tftp.active || strlen(name) + 40 > sizeof(tftp.req))
+        return -1;
+    if (pcb == NULL && (pcb = udp_new()) == NULL)
+        return -1;
+    memset(&tftp, 0, sizeof(tftp));
+    tftp.pcb = pcb;
+    udp_recv(tftp.pcb, peer_tftp_recv, NULL);
+    tftp.active = 1;
+    tftp.put = put;
+    tftp.port = PEER_TFTP_PORT;
+    tftp.buf = buf;
+    tftp.len = len;
+    tftp.base = 1;
+    tftp.blksize = 512;
+    tftp.windowsize = 1;
+    tftp.stats.blksize = 512;
+    tftp.stats.windowsize = 1;
+
+    put16(tftp.req, put ? 2 : 1);
+    n = 2 + sprintf((char *) &tftp.req[2], "%s", name) + 1;
+    n += sprintf((char *) &tftp.req[n], "octet") + 1;
+    if (blksize)
+        n += sprintf((char *) &tftp.req[n], "blksize%c%u", 0, blksize) + 1;
+    if (windowsize)
+        n += sprintf((char *) &tftp.req[n], "windowsize%c%u", 0,
+                     windowsize) + 1;
+    tftp.req_len = (u16_t) n;
+    peer_tftp_send(tftp.req, tftp.req_len);
+    sys_timeout(PEER_TFTP_TIMEOUT_MS, peer_tftp_tmr, NULL);
+    return 0;
+}
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+void sim_peer_init(void)
+{
+    ip4_addr_t ipaddr, netmask, gw;
+    struct tcp_pcb *http, *mqtt;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 221);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP_ADDR4(&dev_addr, 192, 168, 0, 23);
+
+    lwip_init();
+    /* the second DNS server, added first so that peer_netif heads the list
+       and routes the traffic of the peer */
+    netif_add(&peer_dns_netif, &ipaddr, &netmask, &gw, NULL, peer_netif_init,
+              ethernet_input);
+    netif_set_up(&peer_dns_netif);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 220);
+    netif_add(&peer_netif, &ipaddr, &netmask, &gw, NULL, peer_netif_init,
+              ethernet_input);
+    netif_set_default(&peer_netif);
+    netif_set_up(&peer_netif);
+
+    udpecho_raw_init();
+    tcpecho_raw_init();
+
+    peer_udp = udp_new();
+    udp_bind(peer_udp, IP_ADDR_ANY, PEER_UDP_PORT);
+    udp_recv(peer_udp, peer_udp_recv, NULL);
+
+    http = tcp_new();
+    tcp_bind(http, IP_ADDR_ANY, PEER_HTTP_PORT);
+    http = tcp_listen(http);
+    tcp_accept(http, peer_http_accept);
+
+    mqtt = tcp_new();
+    tcp_bind(mqtt, IP_ADDR_ANY, PEER_MQTT_PORT);
+    mqtt = tcp_listen(mqtt);
+    tcp_accept(mqtt, peer_mqtt_accept);
+
+    dns.pcb = udp_new();
+    udp_bind(dns.pcb, IP_ADDR_ANY, PEER_DNS_PORT);
+    udp_recv(dns.pcb, peer_dns_recv, NULL);
+
+    dhcp.pcb = udp_new();
+    udp_bind(dhcp.pcb, IP_ADDR_ANY, PEER_DHCP_SERVER_PORT);
+    udp_recv(dhcp.pcb, peer_dhcp_recv, NULL);
+}
+
+/* IP to either address is taken by peer_netif, ARP goes to both */
+void sim_peer_input(const uint8_t *frame, uint32_t len)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t) len, PBUF_POOL);
+
+    if (p == NULL)
+        return;
+    pbuf_take(p, frame, (u16_t) len);
+    if (len >= 14 && frame[12] == 0x08 && frame[13] == 0x06) {
+        struct pbuf *q = pbuf_clone(PBUF_RAW, PBUF_POOL, p);
+
+        if (q != NULL && peer_dns_netif.input(q, &peer_dns_netif) != ERR_OK)
+            pbuf_free(q);
+    }
+    if (peer_netif.input(p, &peer_netif) != ERR_OK)
+        pbuf_free(p);
+}
+
+void sim_peer_poll(void)
+{
+    sys_check_timeouts();
+}
+
+int sim_peer_udp_send(uint16_t port, const void *data, uint16_t len)
+{
+    struct pbuf *p = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
+    err_t err;
+
+    if (p == NULL)
+        return -1;
+    pbuf_take(p, data, len);
+    err = udp_sendto(peer_udp, p, &dev_addr, port);
+    pbuf_free(p);
+    return err == ERR_OK ? 0 : -1;
+}
+
+int sim_peer_tcp_connect(uint16_t port)
+{
+    if (peer_tcp != NULL)
+        return -1;
+    peer_tcp = tcp_new();
+    if (peer_tcp == NULL)
+        return -1;
+    tcp_nagle_disable(peer_tcp);
+    tcp_recv(peer_tcp, peer_tcp_recv);
+    tcp_sent(peer_tcp, peer_tcp_sent);
+    tcp_err(peer_tcp, peer_tcp_err);
+    if (tcp_connect(peer_tcp, &dev_addr, port, peer_tcp_connected) != ERR_OK) {
+        tcp_abort(peer_tcp);
+        peer_tcp = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+uint32_t sim_peer_tcp_write(const void *data, uint32_t len)
+{
+    if (peer_tcp == NULL)
+        return 0;
+    if (len > tcp_sndbuf(peer_tcp))
+        len = tcp_sndbuf(peer_tcp);
+    if (len > 0xffff)
+        len = 0xffff;
+    if (len == 0 ||
+        tcp_write(peer_tcp, data, (u16_t) len, TCP_WRITE_FLAG_COPY) != ERR_OK)
+        return 0;
+    tcp_output(peer_tcp);
+    return len;
+}
+
+void sim_peer_tcp_close(void)
+{
+    if (peer_tcp == NULL)
+        return;
+    tcp_arg(peer_tcp, NULL);
+    tcp_recv(peer_tcp, NULL);
+    tcp_sent(peer_tcp, NULL);
+    tcp_err(peer_tcp, NULL);
+    if (tcp_close(peer_tcp) != ERR_OK)
+        tcp_abort(peer_tcp);
+    peer_tcp = NULL;
+}
+
+int sim_peer_tcp_hold(void)
+{
+    if (peer_tcp == NULL || held_count >= PEER_HELD_MAX)
+        return -1;
+    tcp_arg(peer_tcp, (void *) (uintptr_t) held_count);
+    tcp_recv(peer_tcp, peer_held_recv);
+    tcp_sent(peer_tcp, NULL);
+    tcp_err(peer_tcp, peer_held_err);
+    held[held_count++] = peer_tcp;
+    peer_tcp = NULL;
+    return 0;
+}
+
+int sim_peer_tcp_held_open(uint32_t i)
+{
+    return i < held_count && held[i] != NULL;
+}
+
+void sim_peer_tcp_release(void)
+{
+    uint32_t i;
+
+    for (i = 0; i < held_count; i++) {
+        if (held[i] != NULL)
+            peer_held_close(held[i]);
+        held[i] = NULL;
+    }
+    held_count = 0;
+}
+
+int sim_peer_iperf_start(uint16_t port)
+{
+    void *session = lwiperf_start_tcp_client(&dev_addr, port,
+                                             LWIPERF_CLIENT, peer_iperf_report,
+                                             NULL);
+
+    return session != NULL ? 0 : -1;
+}
+
+int sim_peer_iperf_listen(uint16_t port)
+{
+    void *session = lwiperf_start_tcp_server(IP_ADDR_ANY, port, NULL, NULL);
+
+    return session != NULL ? 0 : -1;
+}
+
+const struct sim_peer_mqtt_stats *sim_peer_mqtt_get_stats(void)
+{
+    return &broker.stats;
+}
+
+void sim_peer_dns_set(uint32_t server, uint32_t delay_ms, int mute)
+{
+    if (server >= SIM_PEER_DNS_SERVERS)
+        return;
+    dns.delay_ms[server] = delay_ms;
+    dns.mute[server] = mute;
+}
+
+const struct sim_peer_dns_stats *sim_peer_dns_get_stats(void)
+{
+    return &dns.stats;
+}
+
+const struct sim_peer_dhcp_stats *sim_peer_dhcp_get_stats(void)
+{
+    return &dhcp.stats;
+}
+
+int sim_peer_tftp_put(const char *name, const void *data, uint32_t len,
+                      uint16_t blksize, uint16_t windowsize)
+{
+    return peer_tftp_start(1, name, (uint8_t *) data, len, blksize,
+                           windowsize);
+}
+
+int sim_peer_tftp_get(const char *name, void *buf, uint32_t size,
+                      uint16_t blksize, uint16_t windowsize)
+{
+    return peer_tftp_start(0, name, buf, size, blksize, windowsize);
+}
+
+const struct sim_peer_tftp_stats *sim_peer_tftp_get_stats(void)
+{
+    return &tftp.stats;
+}
@@ -0,0 +1,200 @@
+/**
+ * @file sim_peer.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Simulated PC on the other end of the link, a second lwIP stack.
+ *
+ * The peer is 192.168.0.220, the address the firmware clients connect to.
+ * It runs the UDP and TCP echo servers on port 7, a HTTP server on port 80
+ * answering GET /<n> with n bytes, a MQTT broker stand-in on port 1883, a
+ * DNS server stand-in on port 53 of 192.168.0.220 and 192.168.0.221, a
+ * DHCP server stand-in, and drives the device with UDP datagrams, one TCP
+ * connection and an iperf client.
+ *
+ * The broker takes one client. It acknowledges CONNECT, SUBSCRIBE and the
+ * QoS 1 and 2 PUBLISH flows, counts the messages and, once the client has
+ * subscribed, sends every PUBLISH to echo/... back to it with QoS 0.
+ *
+ * The DNS server resolves broker.sim (TTL 10 s) and time.sim (TTL 1 h) to
+ * 192.168.0.220, other names are NXDOMAIN with a negative TTL of 30 s. Each
+ * of its two addresses answers after its own delay, or not at all.
+ *
+ * The DHCP server offers 192.168.0.23/24 with the router 192.168.0.1 for
+ * an hour and acknowledges a request for any address of 192.168.0.0/24, as
+ * if it had handed it out before, so 192.168.0.221 can be taken from the
+ * peer. Its answers are broadcast.
+ *
+ * The TFTP client writes and reads files on the device, with the blksize
+ * and windowsize options if asked to. It sends the window again, or the
+ * ACK of the last block in order, after 500 ms without progress.
+ *
+ * The peer stack is built with its own lwipopts.h (peer/) and linked as one
+ * object whose global symbols are renamed to peer_*, so only the sim_peer_*
+ * functions below are visible. This header must not include lwIP headers,
+ * the harness sees the lwIP of the device.
+ */
+
+#ifndef __SIM_PEER_H__
+#define __SIM_PEER_H__
+
+#include <stdint.h>
+
+#define SIM_PEER_DNS_SERVERS 2
+
+struct sim_peer_dns_stats {
+    uint32_t queries[SIM_PEER_DNS_SERVERS]; /* to .220 and .221 */
+    uint32_t nxdomain;                      /* answered */
+};
+
+struct sim_peer_dhcp_stats {
+    uint32_t discovers;
+    uint32_t requests; /* to the peer, or to no server (INIT-REBOOT) */
+    uint32_t acks;
+    uint32_t naks;
+    uint32_t declines;
+};
+
+struct sim_peer_tftp_stats {
+    uint16_t blksize;    /* of the last transfer, granted by the device */
+    uint16_t windowsize;
+    uint32_t timeouts;   /* of the last transfer */
+};
+
+struct sim_peer_mqtt_stats {
+    uint32_t publishes; /* received */
+    uint64_t bytes;     /* of their payload */
+    uint32_t echoed;
+    uint32_t dropped;   /* writes not fitting the send buffer */
+};
+
+/*******************************************************************************
+ * Public Function
+ ******************************************************************************/
+
+/**
+ * @brief Bring up the peer stack and its echo servers.
+ */
+void sim_peer_init(void);
+
+/**
+ * @brief Frame from the wire.
+ */
+void sim_peer_input(const uint8_t *frame, uint32_t len);
+
+/**
+ * @brief Run the timeouts of the peer stack.
+ */
+void sim_peer_poll(void);
+
+/**
+ * @brief Send a UDP datagram from port 5000 to the device.
+ * @return 0 on success
+ */
+int sim_peer_udp_send(uint16_t port, const void *data, uint16_t len);
+
+/**
+ * @brief Open the TCP connection to the device, sim_on_tcp_connected() is
+ *        called once established.
+ * @return 0 on success
+ */
+int sim_peer_tcp_connect(uint16_t port);
+
+/**
+ * @brief Queue data on the TCP connection and push it.
+ * @return bytes accepted, limited by the send buffer
+ */
+uint32_t sim_peer_tcp_write(const void *data, uint32_t len);
+
+/**
+ * @brief Close the TCP connection.
+ */
+void sim_peer_tcp_close(void);
+
+/**
+ * @brief Keep the TCP connection open in the background, its data is
+ *        discarded, and free the slot for sim_peer_tcp_connect().
+ * @return 0 on success
+ */
+int sim_peer_tcp_hold(void);
+
+/**
+ * @brief Whether the i-th held connection (in sim_peer_tcp_hold() order) is
+ *        still open, i.e. not closed or reset by the device.
+ */
+int sim_peer_tcp_held_open(uint32_t i);
+
+/**
+ * @brief Close all held connections.
+ */
+void sim_peer_tcp_release(void);
+
+/**
+ * @brief Start the iperf client against the device, 10 s of TCP data.
+ * @return 0 on success
+ */
+int sim_peer_iperf_start(uint16_t port);
+
+/**
+ * @brief Start an iperf server for the clients of the device.
+ * @return 0 on success
+ */
+int sim_peer_iperf_listen(uint16_t port);
+
+/**
+ * @brief Counters of the MQTT broker, since start up.
+ */
+const struct sim_peer_mqtt_stats *sim_peer_mqtt_get_stats(void);
+
+/**
+ * @brief Answer the DNS queries to server (0: 192.168.0.220, 1: .221) after
+ *        delay_ms, or not at all if mute.
+ */
+void sim_peer_dns_set(uint32_t server, uint32_t delay_ms, int mute);
+
+/**
+ * @brief Counters of the DNS server, since start up.
+ */
+const struct sim_peer_dns_stats *sim_peer_dns_get_stats(void);
+
+/**
+ * @brief Counters of the DHCP server, since start up.
+ */
+const struct sim_peer_dhcp_stats *sim_peer_dhcp_get_stats(void);
+
+/**
+ * @brief Write len bytes of data to name on the device, asking for blksize
+ *        and windowsize unless 0. sim_on_tftp_done() is called at the end.
+ * @return 0 on success
+ */
+int sim_peer_tftp_put(const char *name, const void *data, uint32_t len,
+                      uint16_t blksize, uint16_t windowsize);
+
+/**
+ * @brief Read name from the device into buf of size bytes, as
+ *        sim_peer_tftp_put().
+ * @return 0 on success
+ */
+int sim_peer_tftp_get(const char *name, void *buf, uint32_t size,
+                      uint16_t blksize, uint16_t windowsize);
+
+/**
+ * @brief Options and timeouts of the last TFTP transfer.
+ */
+const struct sim_peer_tftp_stats *sim_peer_tftp_get_stats(void);
+
+/*******************************************************************************
+ * Callbacks, provided by the harness
+ ******************************************************************************/
+void sim_on_udp_recv(const uint8_t *data, uint16_t len);
+void sim_on_tcp_connected(int err);
+/* data is NULL when the device closed the connection or it was reset */
+void sim_on_tcp_recv(const uint8_t *data, uint16_t len);
+void sim_on_tcp_sent(uint16_t len);
+void sim_on_iperf_report(int ok, uint32_t bytes, uint32_t ms, uint32_t kbps);
+/* bytes written or read */
+void sim_on_tftp_done(int ok, uint32_t bytes);
+
+/* Provided by sim_link.c, kept unresolved in the peer object */
+void sim_link_send(int dir, const uint8_t *frame, uint32_t len);
+
+#endif /* __SIM_PEER_H__ */
@@ -0,0 +1,339 @@
+/**
+ * @file test_emac_model.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - ethernetif.c and emac.c on the EMAC register model
+ *
+ * The firmware UDP echo server runs on the unmodified port. A peer on the
+ * other end of the wire answers ARP and counts the echoes while the model
+ * drives the descriptor rings into wrap around, Rx descriptor unavailable
+ * and bus errors.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "emac_model.h"
+#include "m487_sys.h"
+
+#include "ethernetif.h"
+#include "lwip/etharp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include "udpecho_raw.h"
+#include "test_util.h"
+
+#define ECHO_PORT     7
+#define PEER_PORT     5000
+#define BENCH_FRAMES  20000
+#define PEER_QUEUE    16
+
+static const uint8_t peer_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+extern unsigned char mac_addr[6];
+
+struct netif gnetif;
+static ip4_addr_t dev_ip, peer_ip;
+
+/* Frames sent by the device, processed outside of the Tx DMA */
+static struct {
+    uint8_t frame[PEER_QUEUE][EMAC_MAX_PKT_SIZE];
+    uint32_t len[PEER_QUEUE];
+    uint32_t head, tail;
+} peer_q;
+
+static uint32_t echoes, last_seq;
+static int echo_order_ok = 1;
+
+void EMAC_RX_IRQHandler(void)
+{
+    ethernetif_input(&gnetif);
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    // Clean up Tx resource occupied by previous sent.
+    ethernetif_tx_done(&gnetif);
+}
+
+/*******************************************************************************
+ * Peer
+ ******************************************************************************/
+static void peer_tx(void *arg, const uint8_t *frame, uint32_t len)
+{
+    LWIP_UNUSED_ARG(arg);
+
+    if (peer_q.head - peer_q.tail == PEER_QUEUE) {
+        printf("[ERROR]: peer queue overflow\n");
+        fail = 1;
+        return;
+    }
+    memcpy(peer_q.frame[peer_q.head % PEER_QUEUE], frame, len);
+    peer_q.len[peer_q.head % PEER_QUEUE] = len;
+    peer_q.head++;
+}
+
+static void eth_fill(uint8_t *frame, const uint8_t *dst, u16_t type)
+{
+    struct eth_hdr *eth = (struct eth_hdr *) frame;
+
+    memcpy(eth->dest.addr, dst, 6);
+    memcpy(eth->src.addr, peer_mac, 6);
+    eth->type = lwip_htons(type);
+}
+
+static void peer_arp_reply(const struct etharp_hdr *req)
+{
+    uint8_t frame[SIZEOF_ETH_HDR + SIZEOF_ETHARP_HDR];
+    struct etharp_hdr *arp = (struct etharp_hdr *) (frame + SIZEOF_ETH_HDR);
+
+    eth_fill(frame, req->shwaddr.addr, ETHTYPE_ARP);
+    *arp = *req;
+    arp->opcode = lwip_htons(ARP_REPLY);
+    memcpy(arp->shwaddr.addr, peer_mac, 6);
+    arp->sipaddr = req->dipaddr;
+    arp->dhwaddr = req->shwaddr;
+    arp->dipaddr = req->sipaddr;
+    emac_model_rx(frame, sizeof(frame));
+}
+
+static int peer_udp_send(uint32_t seq)
+{
+    uint8_t frame[SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + 32];
+    struct ip_hdr *ip = (struct ip_hdr *) (frame + SIZEOF_ETH_HDR);
+    struct udp_hdr *udp = (struct udp_hdr *) ((uint8_t *) ip + IP_HLEN);
+    uint8_t *data = (uint8_t *) udp + UDP_HLEN;
+    u16_t len = sizeof(frame) - SIZEOF_ETH_HDR;
+
+    memset(frame, 0, sizeof(frame));
+    eth_fill(frame, mac_addr, ETHTYPE_IP);
+    IPH_VHL_SET(ip, 4, IP_HLEN / 4);
+    IPH_LEN_SET(ip, lwip_htons(len));
+    IPH_ID_SET(ip, lwip_htons((u16_t) seq));
+    IPH_TTL_SET(ip, 64);
+    IPH_PROTO_SET(ip, IP_PROTO_UDP);
+    ip4_addr_copy(ip->src, peer_ip);
+    ip4_addr_copy(ip->dest, dev_ip);
+    IPH_CHKSUM_SET(ip, inet_chksum(ip, IP_HLEN));
+    udp->src = lwip_htons(PEER_PORT);
+    udp->dest = lwip_htons(ECHO_PORT);
+    udp->len = lwip_htons(len - IP_HLEN);
+    memcpy(data, &seq, sizeof(seq));
+
+    return emac_model_rx(frame, sizeof(frame));
+}
+
+/**
+ * Answer ARP and count the echoes sent by the device.
+ */
+static void peer_poll(void)
+{
+    const uint8_t *frame;
+    const struct eth_hdr *eth;
+    const struct ip_hdr *ip;
+    const struct etharp_hdr *arp;
+    uint32_t seq;
+
+    while (peer_q.tail != peer_q.head) {
+        frame = peer_q.frame[peer_q.tail % PEER_QUEUE];
+        peer_q.tail++;
+        eth = (const struct eth_hdr *) frame;
+
+        if (eth->type == PP_HTONS(ETHTYPE_ARP)) {
+            arp = (const struct etharp_hdr *) (frame + SIZEOF_ETH_HDR);
+            if (arp->opcode == PP_HTONS(ARP_REQUEST))
+                peer_arp_reply(arp);
+        } else if (eth->type == PP_HTONS(ETHTYPE_IP)) {
+            ip = (const struct ip_hdr *) (frame + SIZEOF_ETH_HDR);
+            if (IPH_PROTO(ip) != IP_PROTO_UDP)
+                continue;
+            memcpy(&seq, (const uint8_t *) ip + IP_HLEN + UDP_HLEN,
+                   sizeof(seq));
+            if (echoes && seq <= last_seq)
+                echo_order_ok = 0;
+            last_seq = seq;
+            echoes++;
+        }
+    }
+}
+
+/**
+ * One round on the wire: a frame from the peer, timers and replies.
+ */
+static void round_trip(uint32_t seq)
+{
+    peer_udp_send(seq);
+    peer_poll();
+    m487_sys_advance(100000);
+    sys_check_timeouts();
+}
+
+/*******************************************************************************
+ * Test
+ ******************************************************************************/
+static void test_ring_wrap(uint32_t *seq)
+{
+    const struct emac_model_stats *st = emac_model_get_stats();
+    uint32_t n = echoes, i;
+
+    printf("[INFO]: ring wrap\n");
+    for (i = 0; i < 4 * EMAC_RX_DESC_SIZE; i++)
+        round_trip((*seq)++);
+
+    check("echoes", echoes - n, 4 * EMAC_RX_DESC_SIZE, 4 * EMAC_RX_DESC_SIZE);
+    check("rx wraps", st->rx_wraps, 4, 5);
+    check("tx wraps", st->tx_wraps, 4, 5);
+    check("echo order", echo_order_ok, 1, 1);
+}
+
+static void test_rdu(uint32_t *seq)
+{
+    const struct emac_model_stats *st = emac_model_get_stats();
+    uint32_t n = echoes, missed = st->rx_missed, ok = 0, i;
+
+    printf("[INFO]: Rx descriptor unavailable\n");
+    /* Interrupts held off, the ring fills up and Rx DMA halts */
+    emac_model_irq_mask(1);
+    for (i = 0; i < EMAC_RX_DESC_SIZE + 2; i++)
+        ok += peer_udp_send((*seq)++) == 0;
+    check("accepted", ok, EMAC_RX_DESC_SIZE, EMAC_RX_DESC_SIZE);
+    check("missed", st->rx_missed - missed, 2, 2);
+    check("rdu", st->rdu, 1, 1);
+
+    /* The handler drains the ring and restarts Rx DMA */
+    emac_model_irq_mask(0);
+    peer_poll();
+    check("echoes", echoes - n, EMAC_RX_DESC_SIZE, EMAC_RX_DESC_SIZE);
+
+    round_trip((*seq)++);
+    check("echoes after rdu", echoes - n, EMAC_RX_DESC_SIZE + 1,
+          EMAC_RX_DESC_SIZE + 1);
+    check("RDUIF", emac_model_intsts_history() & EMAC_INTSTS_RDUIF_Msk,
+          EMAC_INTSTS_RDUIF_Msk, EMAC_INTSTS_RDUIF_Msk);
+}
+
+static void test_tx_ring_full(uint32_t *seq)
+{
+    uint32_t n = echoes, i;
+
+    printf("[INFO]: Tx ring full\n");
+    /* Wire busy, low_level_output() runs out of descriptors */
+    emac_model_tx_hold(1);
+    for (i = 0; i < EMAC_TX_DESC_SIZE + 2; i++)
+        round_trip((*seq)++);
+    check("echoes while held", echoes - n, 0, 0);
+
+    emac_model_tx_hold(0);
+    peer_poll();
+    check("echoes", echoes - n, EMAC_TX_DESC_SIZE, EMAC_TX_DESC_SIZE);
+
+    round_trip((*seq)++);
+    check("echoes after release", echoes - n, EMAC_TX_DESC_SIZE + 1,
+          EMAC_TX_DESC_SIZE + 1);
+}
+
+static void test_bus_error(uint32_t *seq)
+{
+    const struct emac_model_stats *st = emac_model_get_stats();
+    uint32_t n = echoes;
+
+    printf("[INFO]: bus error\n");
+    /* Rx bus error, the driver restarts the EMAC */
+    emac_model_bus_error(0);
+    round_trip((*seq)++);
+    check("echoes after Rx bus error", echoes - n, 1, 1);
+
+    /* Tx bus error with a frame in flight, which is lost */
+    emac_model_tx_hold(1);
+    round_trip((*seq)++);
+    emac_model_bus_error(1);
+    emac_model_tx_hold(0);
+    peer_poll();
+    check("echoes lost", echoes - n, 1, 1);
+
+    round_trip((*seq)++);
+    check("echoes after Tx bus error", echoes - n, 2, 2);
+    check("bus errors", st->bus_errors, 2, 2);
+    check("BEIF", emac_model_intsts_history() &
+                      (EMAC_INTSTS_RXBEIF_Msk | EMAC_INTSTS_TXBEIF_Msk),
+          EMAC_INTSTS_RXBEIF_Msk | EMAC_INTSTS_TXBEIF_Msk,
+          EMAC_INTSTS_RXBEIF_Msk | EMAC_INTSTS_TXBEIF_Msk);
+}
+
+static void test_time_stamp(void)
+{
+    uint32_t sec, nsec;
+
+    printf("[INFO]: time stamp counter\n");
+    EMAC_EnableTS(100, 0);
+    m487_sys_advance(1000000);
+    EMAC_GetTime(&sec, &nsec);
+    check("sec", sec, 100, 100);
+    check("nsec", nsec, 999990, 1000010);
+
+    EMAC_UpdateTime(1, 0, 500000);
+    m487_sys_advance(0);
+    EMAC_GetTime(&sec, &nsec);
+    check("nsec after update", nsec, 499990, 500010);
+    EMAC_DisableTS();
+}
+
+static void bench(uint32_t *seq)
+{
+    uint32_t n = echoes, i;
+    uint64_t t0;
+    double ns;
+
+    t0 = host_ns();
+    for (i = 0; i < BENCH_FRAMES; i++)
+        round_trip((*seq)++);
+    ns = (double) (host_ns() - t0);
+    check("bench echoes", echoes - n, BENCH_FRAMES, BENCH_FRAMES);
+    printf("[INFO]: %u UDP echoes, %.0f ns per round trip, %.0f frames/s\n",
+           BENCH_FRAMES, ns / BENCH_FRAMES, 2e9 * BENCH_FRAMES / ns);
+}
+
+int main(void)
+{
+    ip4_addr_t netmask, gw;
+    uint32_t seq = 1;
+
+    printf("[test]: EMAC register model.\n\n");
+
+    emac_model_reset();
+    emac_model_set_tx_fn(peer_tx, NULL);
+
+    IP4_ADDR(&dev_ip, 192, 168, 0, 23);
+    IP4_ADDR(&peer_ip, 192, 168, 0, 1);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+
+    lwip_init();
+    netif_add(&gnetif, &dev_ip, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+    netif_set_default(&gnetif);
+    netif_set_up(&gnetif);
+    udpecho_raw_init();
+
+    /* First echo resolves the peer by ARP */
+    round_trip(seq++);
+    peer_poll();
+    check("first echo", echoes, 1, 1);
+
+    test_ring_wrap(&seq);
+    test_rdu(&seq);
+    test_tx_ring_full(&seq);
+    test_bus_error(&seq);
+    test_time_stamp();
+    bench(&seq);
+
+    printf(fail ? "FAIL\n" : "PASS\n");
+    return fail;
+}
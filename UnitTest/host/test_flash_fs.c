@@ -0,0 +1,555 @@
+/**
+ * @file test_flash_fs.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - read-only file system on the file-backed flash: the
+ *        httpd files of an image built by mkflashfs read back through
+ *        fs_open() and tftp, lookups among many names, images that must not
+ *        mount, LRU eviction, large files read past the cache, reads that
+ *        wait for the flash while the clock runs on, and the flash time
+ *        per request with and without the cache.
+ *
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_file.h"
+#include "flash_fs.h"
+#include "lwip/apps/fs.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/def.h"
+#include "test_util.h"
+
+#define FLASH_SIZE   (2 * 1024 * 1024)
+#define FS_ADDR      0x100000
+#define SMALL_FILES  300
+#define BIG_LEN      (64 * 1024 + 123)
+#define REQUESTS     1000
+#define CHUNK        1460   /* read per call, a segment as httpd does */
+#define LATENCY_NS   200000 /* of a started flash read, slow storage */
+
+static uint64_t now;
+
+static uint64_t flash_now_ns(void)
+{
+    return now;
+}
+
+static struct flash_file ff;
+
+static const char *const www[] = {"/index.html", "/404.html",
+                                  "/img/sics.gif"};
+
+static const char *const missing[] = {"",           "/",          "/index.htm",
+                                      "/index.html/", "/img",     "/img/",
+                                      "/INDEX.HTML", "/s300.txt", "/s0.txt"};
+
+static uint8_t *read_all(const char *path, uint32_t *len)
+{
+    static uint8_t buf[BIG_LEN];
+    FILE *f = fopen(path, "rb");
+
+    *len = f != NULL ? (uint32_t) fread(buf, 1, sizeof(buf), f) : 0;
+    if (f == NULL) {
+        printf("[ERROR]: cannot read %s\n", path);
+        fail = 1;
+    } else {
+        fclose(f);
+    }
+    return buf;
+}
+
+/* Image of dir written to the flash, mounted */
+static int image(const char *dir, const char *path, int gz)
+{
+    char cmd[512];
+
+    snprintf(cmd, sizeof(cmd), MKFLASHFS " %s%s %s > /dev/null",
+             gz ? "-gz " : "", dir, path);
+    if (system(cmd) != 0 || flash_file_load(&ff, FS_ADDR, path) < 0 ||
+        flash_fs_mount(&ff.dev, FS_ADDR) != 0) {
+        printf("[ERROR]: cannot mount the image of %s\n", dir);
+        fail = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/* The file of name after its header equals data, read in random pieces */
+static void check_file(const char *name, const uint8_t *data, uint32_t len)
+{
+    static uint8_t buf[BIG_LEN];
+    struct flash_fs_file f;
+    uint32_t off = 0;
+    int n;
+
+    if (flash_fs_open(name, &f) != 0) {
+        printf("[ERROR]: %s not found\n", name);
+        fail = 1;
+        return;
+    }
+    check("file len", f.len - f.hdr_len, len, len);
+    do {
+        n = flash_fs_read(&f, f.hdr_len + off, &buf[off], 1 + rnd() % 3000);
+        off += n > 0 ? n : 0;
+    } while (n > 0 && off < sizeof(buf));
+    check("read to the end", off, len, len);
+    if (n < 0 || memcmp(buf, data, len) != 0) {
+        printf("[ERROR]: %s differs\n", name);
+        fail = 1;
+    }
+}
+
+static void wake(void *arg)
+{
+    (*(uint32_t *) arg)++;
+}
+
+/* The main loop: the clock run on to the end of the flash read, polled */
+static int run_to_wake(const uint32_t *calls)
+{
+    uint32_t i;
+
+    for (i = 0; i < 4 && *calls == 0; i++) {
+        now = LWIP_MAX(now, ff.busy_until);
+        flash_fs_poll();
+    }
+    if (*calls == 0) {
+        printf("[ERROR]: no callback\n");
+        fail = 1;
+        return -1;
+    }
+    return 0;
+}
+
+/* fs_read_async() as httpd calls it, again after each callback */
+static int fs_read_wait(struct fs_file *file, char *buf, int count)
+{
+    uint32_t calls;
+    int n;
+
+    for (;;) {
+        calls = 0;
+        n = fs_read_async(file, buf, count, wake, &calls);
+        if (n != FS_READ_DELAYED)
+            return n;
+        if (run_to_wake(&calls))
+            return FS_READ_EOF;
+    }
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+/* The httpd files through fs_open() and tftp, as served */
+static void test_www(void)
+{
+    static char buf[BIG_LEN];
+    char path[256];
+    const uint8_t *data;
+    struct fs_file file;
+    struct flash_fs_file f;
+    void *h, *h2;
+    uint32_t i, len, off;
+    int n;
+
+    if (image(HTTP_FS_DIR, "build/test_flash_fs_www.bin", 1))
+        return;
+    for (i = 0; i < LWIP_ARRAYSIZE(www); i++) {
+        snprintf(path, sizeof(path), "%s%s", HTTP_FS_DIR, www[i]);
+        data = read_all(path, &len);
+        check_file(www[i], data, len);
+
+        /* fs_open() finds the flash file before the one of fsdata.c */
+        if (fs_open(&file, www[i]) != ERR_OK) {
+            printf("[ERROR]: fs_open(%s)\n", www[i]);
+            fail = 1;
+            continue;
+        }
+        check("is_custom_file", file.is_custom_file, 1, 1);
+        check("header included", file.flags & FS_FILE_FLAGS_HEADER_INCLUDED,
+              FS_FILE_FLAGS_HEADER_INCLUDED, FS_FILE_FLAGS_HEADER_INCLUDED);
+        for (off = 0; (n = fs_read_wait(&file, &buf[off], CHUNK)) > 0;
+             off += n)
+            ;
+        check("fs_read to the end", off, file.len, file.len);
+        buf[off] = '\0';
+        snprintf(path, sizeof(path), "Content-Length: %u\r\n", len);
+        check("status line",
+              strncmp(buf, i == 1 ? "HTTP/1.1 404" : "HTTP/1.1 200", 12), 0,
+              0);
+        check("Content-Length", strstr(buf, path) != NULL, 1, 1);
+        check("body", memcmp(&buf[off - len], data, len), 0, 0);
+        fs_close(&file);
+    }
+
+    /* gzip variants, not of the gif */
+    check("index.html.gz", flash_fs_open("/index.html.gz", &f), 0, 0);
+    check("sics.gif.gz", flash_fs_open("/img/sics.gif.gz", &f), (uint32_t) -1,
+          (uint32_t) -1);
+    check("index.html has gzip",
+          flash_fs_open("/index.html", &f) == 0 &&
+              (f.flags & FS_FILE_FLAGS_HAS_GZIP),
+          1, 1);
+
+    /* tftp gets the file without the header, read only */
+    snprintf(path, sizeof(path), "%s/index.html", HTTP_FS_DIR);
+    data = read_all(path, &len);
+    h = flash_fs_tftp.open("index.html", "octet", 0);
+    h2 = flash_fs_tftp.open("404.html", "octet", 0);
+    check("tftp open", h != NULL, 1, 1);
+    check("tftp one at a time", h2 == NULL, 1, 1);
+    for (off = 0; h && (n = flash_fs_tftp.read(h, &buf[off], 512)) > 0;
+         off += n)
+        ;
+    check("tftp read", off, len, len);
+    check("tftp data", memcmp(buf, data, len), 0, 0);
+    if (h != NULL)
+        flash_fs_tftp.close(h);
+    check("tftp write refused",
+          flash_fs_tftp.open("/index.html", "octet", 1) == NULL, 1, 1);
+
+    /* not mounted: fsdata.c again */
+    flash_fs_unmount();
+    check("fsdata.c", fs_open(&file, "/index.html"), ERR_OK, ERR_OK);
+    check("not custom", file.is_custom_file, 0, 0);
+    fs_close(&file);
+}
+
+/* Many names, a large file */
+static void write_files(const char *dir)
+{
+    static uint8_t buf[BIG_LEN];
+    char path[256];
+    uint32_t i, j;
+    FILE *f;
+
+    snprintf(path, sizeof(path), "mkdir -p %s/sub/dir", dir);
+    if (system(path) != 0)
+        fail = 1;
+    for (i = 0; i <= SMALL_FILES; i++) {
+        if (i < SMALL_FILES)
+            snprintf(path, sizeof(path), "%s/s%02u.txt", dir, i);
+        else
+            snprintf(path, sizeof(path), "%s/sub/dir/big.bin", dir);
+        for (j = 0; j < BIG_LEN; j++)
+            buf[j] = (uint8_t) (j * 7 + i);
+        f = fopen(path, "wb");
+        if (f == NULL) {
+            fail = 1;
+            continue;
+        }
+        fwrite(buf, 1, i < SMALL_FILES ? i % 40 : BIG_LEN, f);
+        fclose(f);
+    }
+}
+
+static void test_lookup(void)
+{
+    static uint8_t data[BIG_LEN];
+    char name[64];
+    struct flash_fs_file f;
+    uint32_t i, j, len;
+
+    write_files("build/flash_fs_files");
+    if (image("build/flash_fs_files", "build/test_flash_fs.bin", 0))
+        return;
+    for (i = 0; i <= SMALL_FILES; i++) {
+        len = i < SMALL_FILES ? i % 40 : BIG_LEN;
+        for (j = 0; j < len; j++)
+            data[j] = (uint8_t) (j * 7 + i);
+        if (i < SMALL_FILES)
+            snprintf(name, sizeof(name), "/s%02u.txt", i);
+        else
+            snprintf(name, sizeof(name), "/sub/dir/big.bin");
+        check_file(name, data, len);
+    }
+    for (i = 0; i < LWIP_ARRAYSIZE(missing); i++)
+        check(missing[i], flash_fs_open(missing[i], &f), (uint32_t) -1,
+              (uint32_t) -1);
+}
+
+/* Reads of files within one block each, the least recently used is evicted */
+static void test_lru(void)
+{
+    struct flash_fs_file f[FLASH_FS_CACHE_BLOCKS + 1];
+    const struct flash_fs_stats *s = flash_fs_get_stats();
+    char name[64];
+    uint8_t buf[FLASH_FS_BLOCK_SIZE];
+    uint32_t i, j, n = 0, misses;
+
+    for (i = 0; i < SMALL_FILES && n < LWIP_ARRAYSIZE(f); i++) {
+        snprintf(name, sizeof(name), "/s%02u.txt", i);
+        if (flash_fs_open(name, &f[n]) != 0)
+            continue;
+        if (f[n].addr / FLASH_FS_BLOCK_SIZE !=
+            (f[n].addr + f[n].len - 1) / FLASH_FS_BLOCK_SIZE)
+            continue;
+        for (j = 0; j < n; j++)
+            if (f[j].addr / FLASH_FS_BLOCK_SIZE ==
+                f[n].addr / FLASH_FS_BLOCK_SIZE)
+                break;
+        n += j == n;
+    }
+    check("files in distinct blocks", n, LWIP_ARRAYSIZE(f),
+          LWIP_ARRAYSIZE(f));
+    if (n < LWIP_ARRAYSIZE(f))
+        return;
+
+#define READ(k) flash_fs_read(&f[k], 0, buf, sizeof(buf))
+    /* the cache holds the blocks of f[0 .. 7] */
+    for (i = 0; i < FLASH_FS_CACHE_BLOCKS; i++)
+        READ(i);
+    misses = s->misses;
+    READ(0);
+    check("hit", s->misses - misses, 0, 0);
+    READ(FLASH_FS_CACHE_BLOCKS);
+    check("miss", s->misses - misses, 1, 1);
+    for (i = 0; i < FLASH_FS_CACHE_BLOCKS; i++) {
+        if (i != 1)
+            READ(i);
+    }
+    check("recently used kept", s->misses - misses, 1, 1);
+    READ(1);
+    check("least recently used evicted", s->misses - misses, 2, 2);
+#undef READ
+}
+
+/* Streaming the large file leaves the small ones cached */
+static void test_bypass(void)
+{
+    const struct flash_fs_stats *s = flash_fs_get_stats();
+    static uint8_t buf[CHUNK];
+    struct flash_fs_file big, small;
+    uint32_t off, misses, bypassed = s->bypassed;
+
+    if (flash_fs_open("/sub/dir/big.bin", &big) ||
+        flash_fs_open("/s39.txt", &small)) {
+        printf("[ERROR]: files not found\n");
+        fail = 1;
+        return;
+    }
+    flash_fs_read(&small, 0, buf, sizeof(buf));
+    misses = s->misses;
+    for (off = 0; off < big.len; off += CHUNK)
+        flash_fs_read(&big, off, buf, sizeof(buf));
+    check("big reads past the cache", s->bypassed - bypassed,
+          big.len / CHUNK, big.len / CHUNK + 1);
+    flash_fs_read(&small, 0, buf, sizeof(buf));
+    check("small still cached", s->misses - misses, 0, 0);
+}
+
+static void test_mount(void)
+{
+    struct flash_fs_file f;
+    uint32_t zero = 0;
+    int len;
+
+    check("erased", flash_fs_mount(&ff.dev, 0), (uint32_t) -1,
+          (uint32_t) -1);
+    check("outside", flash_fs_mount(&ff.dev, FLASH_SIZE - 8), (uint32_t) -1,
+          (uint32_t) -1);
+    /* an upload that stopped before the last sector */
+    len = flash_file_load(&ff, FS_ADDR, "build/test_flash_fs.bin");
+    check("complete", flash_fs_mount(&ff.dev, FS_ADDR), 0, 0);
+    if (len < 0 || ff.dev.erase(&ff.dev, (FS_ADDR + len - 1) & ~4095u, 4096))
+        fail = 1;
+    ff.busy_until = 0;
+    check("truncated", flash_fs_mount(&ff.dev, FS_ADDR), (uint32_t) -1,
+          (uint32_t) -1);
+    /* the first entry with a header longer than its blob */
+    if (flash_file_load(&ff, FS_ADDR, "build/test_flash_fs.bin") < 0 ||
+        ff.dev.program(&ff.dev, FS_ADDR + sizeof(struct flash_fs_header) + 12,
+                       (const uint8_t *) &zero, sizeof(zero)) != 0)
+        fail = 1;
+    ff.busy_until = 0;
+    check("bad entry", flash_fs_mount(&ff.dev, FS_ADDR), (uint32_t) -1,
+          (uint32_t) -1);
+    check("open unmounted", flash_fs_open("/s01.txt", &f), (uint32_t) -1,
+          (uint32_t) -1);
+}
+
+/*
+ * Requests for the httpd files as fs_open() and fs_read() make them, some
+ * more often than others. Without the cache each one reads the entries of
+ * the binary search, a name and the file from the flash.
+ */
+static void bench_requests(void)
+{
+    const struct flash_fs_stats *s = flash_fs_get_stats();
+    static const uint8_t weight[] = {6, 1, 3};
+    static char buf[CHUNK];
+    uint32_t i, k, hits, misses, steps = 0, n;
+    uint64_t ns, direct_ns = 0;
+    struct fs_file file;
+    int r;
+
+    if (flash_file_load(&ff, FS_ADDR, "build/test_flash_fs_www.bin") < 0 ||
+        flash_fs_mount(&ff.dev, FS_ADDR) != 0) {
+        fail = 1;
+        return;
+    }
+    /* the binary search over the 5 entries, the entry found */
+    for (n = 5; n > 1; n = (n + 1) / 2)
+        steps++;
+    hits = s->hits;
+    misses = s->misses;
+    ns = ff.read_ns;
+    for (i = 0; i < REQUESTS; i++) {
+        k = rnd() % 10;
+        k = k < weight[0] ? 0 : k < weight[0] + weight[1] ? 1 : 2;
+        if (fs_open(&file, www[k]) != ERR_OK) {
+            fail = 1;
+            break;
+        }
+        direct_ns += (steps + 1) * FLASH_FILE_READ_NS(
+                         sizeof(struct flash_fs_entry)) +
+                     FLASH_FILE_READ_NS(FLASH_FS_NAME_MAX);
+        while ((r = fs_read_wait(&file, buf, sizeof(buf))) > 0)
+            direct_ns += FLASH_FILE_READ_NS(r);
+        fs_close(&file);
+    }
+    check("hit rate %", (uint32_t) ((uint64_t) (s->hits - hits) * 100 /
+                                    (s->hits - hits + s->misses - misses)),
+          90, 100);
+    printf("[INFO]: %u requests, %u block hits %u misses, flash %u us per "
+           "request, %u us without the cache\n",
+           REQUESTS, s->hits - hits, s->misses - misses,
+           (uint32_t) ((ff.read_ns - ns) / REQUESTS / 1000),
+           (uint32_t) (direct_ns / REQUESTS / 1000));
+}
+
+/*
+ * Reads that find the flash busy: the connections wait for the callback of
+ * flash_fs_poll() and carry on while the clock runs, the one that started
+ * the read first. A closed file is not called back.
+ */
+static void test_async(void)
+{
+    const struct flash_fs_stats *s = flash_fs_get_stats();
+    /* the large file with its header */
+    static uint8_t buf[BIG_LEN + 512], ref[BIG_LEN + 512];
+    struct fs_file a, b, c;
+    struct flash_fs_file big;
+    uint32_t calls_a = 0, calls_b = 0, calls_c = 0, off, started;
+    uint64_t t;
+    int n;
+
+    ff.read_latency_ns = LATENCY_NS;
+    if (flash_file_load(&ff, FS_ADDR, "build/test_flash_fs_www.bin") < 0 ||
+        flash_fs_mount(&ff.dev, FS_ADDR) != 0 ||
+        fs_open(&a, "/index.html") != ERR_OK ||
+        fs_open(&b, "/img/sics.gif") != ERR_OK) {
+        fail = 1;
+        return;
+    }
+    started = ff.reads_started;
+    t = now;
+    check("a delayed", fs_read_async(&a, (char *) buf, CHUNK, wake, &calls_a),
+          (uint32_t) FS_READ_DELAYED, (uint32_t) FS_READ_DELAYED);
+    check("b delayed", fs_read_async(&b, (char *) buf, CHUNK, wake, &calls_b),
+          (uint32_t) FS_READ_DELAYED, (uint32_t) FS_READ_DELAYED);
+    check("one read at a time", ff.reads_started - started, 1, 1);
+    check("a not ready", fs_is_file_ready(&a, wake, &calls_a), 0, 0);
+
+    now = t + LATENCY_NS / 2;
+    flash_fs_poll();
+    check("no callback before the flash", calls_a + calls_b, 0, 0);
+    now = t + LATENCY_NS;
+    flash_fs_poll();
+    check("a called back", calls_a, 1, 1);
+    check("b called back", calls_b, 1, 1);
+    check("a ready", fs_is_file_ready(&a, wake, &calls_a), 1, 1);
+    for (off = 0; (n = fs_read_wait(&a, (char *) &buf[off], CHUNK)) > 0;
+         off += n)
+        check("a in whole parts", n, LWIP_MIN(CHUNK, a.len - off), CHUNK);
+    check("a to the end", off, a.len, a.len);
+    for (off = 0; (n = fs_read_wait(&b, (char *) &buf[off], CHUNK)) > 0;
+         off += n)
+        ;
+    check("b to the end", off, b.len, b.len);
+    fs_close(&a);
+    fs_close(&b);
+
+    /* closed while its read is running */
+    flash_fs_mount(&ff.dev, FS_ADDR);
+    if (fs_open(&c, "/404.html") != ERR_OK) {
+        fail = 1;
+        return;
+    }
+    check("c delayed", fs_read_async(&c, (char *) buf, CHUNK, wake, &calls_c),
+          (uint32_t) FS_READ_DELAYED, (uint32_t) FS_READ_DELAYED);
+    fs_close(&c);
+    now = ff.busy_until;
+    flash_fs_poll();
+    check("closed not called back", calls_c, 0, 0);
+
+    /* the large file streamed, FLASH_FS_STREAM_SIZE per read */
+    if (flash_file_load(&ff, FS_ADDR, "build/test_flash_fs.bin") < 0 ||
+        flash_fs_mount(&ff.dev, FS_ADDR) != 0 ||
+        flash_fs_open("/sub/dir/big.bin", &big) != 0) {
+        fail = 1;
+        return;
+    }
+    for (off = 0; off < big.len; off += n) {
+        n = flash_fs_read(&big, off, &ref[off], big.len - off);
+        if (n <= 0)
+            break;
+    }
+    started = ff.reads_started;
+    t = now;
+    for (off = 0; off < big.len; off += n) {
+        calls_a = 0;
+        n = flash_fs_read_async(&big, off, &buf[off], CHUNK, wake, &calls_a);
+        if (n == FLASH_FS_DELAYED) {
+            n = 0;
+            if (run_to_wake(&calls_a))
+                break;
+        } else if (n <= 0) {
+            break;
+        }
+    }
+    flash_fs_close(&big);
+    check("big streamed", off, big.len, big.len);
+    check("big data", memcmp(buf, ref, big.len), 0, 0);
+    /* a part left short by the end of the buffer is read again */
+    check("big reads", ff.reads_started - started,
+          (big.len + FLASH_FS_STREAM_SIZE - 1) / FLASH_FS_STREAM_SIZE,
+          big.len / (FLASH_FS_STREAM_SIZE / 2) + 1);
+    printf("[INFO]: %u bytes streamed in %u flash reads of %u us, %u us, "
+           "%u reads delayed\n",
+           big.len, ff.reads_started - started, LATENCY_NS / 1000,
+           (uint32_t) ((now - t) / 1000), s->delayed);
+
+    /* a flash without read_start() blocks */
+    ff.dev.read_start = NULL;
+    check("blocking read", flash_fs_read_async(&big, 0, buf, CHUNK, wake,
+                                               &calls_a),
+          CHUNK, CHUNK);
+    ff.read_latency_ns = 0;
+}
+
+int main(void)
+{
+    printf("[test]: read-only file system on the flash.\n\n");
+
+    if (flash_file_open(&ff, NULL, FLASH_SIZE, flash_now_ns)) {
+        printf("[ERROR]: cannot create the flash file\n");
+        return 1;
+    }
+
+    test_www();
+    test_lookup();
+    test_lru();
+    test_bypass();
+    test_mount();
+    bench_requests();
+    test_async();
+
+    flash_file_close(&ff);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
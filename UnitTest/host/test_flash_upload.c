@@ -0,0 +1,410 @@
+/**
+ * @file test_flash_upload.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - httpd POST upload to flash: bodies in random pbufs sent
+ *        as the window allows, read back from the file-backed flash, never
+ *        programmed without an erase, the window fully reopened, block
+ *        erases used, and an aborted upload followed by a new one. TFTP
+ *        writes of whole windows: the ACK held back while the ring cannot
+ *        take the next window and the last one until the last page is
+ *        programmed, files larger than the region, aborted transfers.
+ *
+ * httpd and tftp_server.c are replaced by the sender loops here, time is
+ * virtual. Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "flash_file.h"
+#include "flash_upload.h"
+#include "lwip/apps/tftp_server.h"
+#include "lwip/def.h"
+#include "lwip/pbuf.h"
+#include "test_util.h"
+
+#define FLASH_SIZE   (2 * 1024 * 1024)
+#define FW_ADDR      0
+#define FW_SIZE      (1024 * 1024)
+#define CFG_ADDR     0x100000
+#define CFG_SIZE     (128 * 1024)
+#define STEP_NS      50000ULL   /* sender and main loop period */
+#define TIMEOUT_NS   60000000000ULL
+
+static const struct flash_upload_region regions[] = {
+    {"/upload/fw", FW_ADDR, FW_SIZE},
+    {"/upload/config", CFG_ADDR, CFG_SIZE},
+};
+
+static uint64_t now;
+
+static uint64_t flash_now_ns(void)
+{
+    return now;
+}
+
+u32_t sys_now(void)
+{
+    return (u32_t) (now / 1000000);
+}
+
+/*******************************************************************************
+ * httpd side
+ ******************************************************************************/
+static struct flash_file ff;
+static int conn_a, conn_b;   /* connection handles */
+static void *finished_conn;  /* httpd_post_finished() called */
+static uint32_t credited;
+
+void httpd_post_data_recved(void *connection, u16_t recved_len)
+{
+    if (connection == finished_conn) {
+        printf("[ERROR]: window update after httpd_post_finished\n");
+        fail = 1;
+    }
+    credited += recved_len;
+}
+
+static void finish(void *conn)
+{
+    char uri[64] = "";
+
+    httpd_post_finished(conn, uri, sizeof(uri));
+    finished_conn = conn;
+    if (strcmp(uri, FLASH_UPLOAD_RESULT_URI) != 0) {
+        printf("[ERROR]: response %s\n", uri);
+        fail = 1;
+    }
+}
+
+static uint8_t pattern(uint32_t off, uint32_t seed)
+{
+    return (uint8_t) ((off * 7 + (off >> 8) + seed) ^ 0x5a);
+}
+
+/* Next piece of the body, one or two pbufs like a TCP segment chain */
+static struct pbuf *segment(uint32_t off, uint16_t len, uint32_t seed)
+{
+    uint16_t first = (len > 1 && (rnd() & 1)) ? 1 + rnd() % (len - 1) : len;
+    struct pbuf *p = pbuf_alloc(PBUF_RAW, first, PBUF_RAM), *q;
+    uint16_t i;
+
+    if (p == NULL)
+        return NULL;
+    if (first < len) {
+        q = pbuf_alloc(PBUF_RAW, len - first, PBUF_RAM);
+        if (q == NULL) {
+            pbuf_free(p);
+            return NULL;
+        }
+        pbuf_cat(p, q);
+    }
+    for (i = 0; i < len; i++)
+        pbuf_put_at(p, i, pattern(off + i, seed));
+    return p;
+}
+
+/**
+ * Send len bytes to uri as the window allows, stop after abort_at bytes
+ * (the connection closes), run the main loop until the upload ends.
+ * @return bytes sent
+ */
+static uint32_t upload(void *conn, const char *uri, uint32_t len,
+                       uint32_t seed, uint32_t abort_at)
+{
+    u8_t auto_wnd = 1;
+    uint32_t sent = 0, room;
+    uint64_t t0 = now;
+    uint16_t n;
+    struct pbuf *p;
+    char resp[64];
+
+    credited = 0;
+    finished_conn = NULL;
+    if (httpd_post_begin(conn, uri, "", 0, (int) len, resp, sizeof(resp),
+                         &auto_wnd) != ERR_OK) {
+        printf("[ERROR]: %s refused\n", uri);
+        fail = 1;
+        return 0;
+    }
+    check("post_auto_wnd", auto_wnd, 0, 0);
+
+    for (;;) {
+        /* httpd finishes once the body is received and all passed on */
+        if ((sent == len && credited == len) || sent == abort_at) {
+            finish(conn);
+            break;
+        }
+        if (now - t0 > TIMEOUT_NS) {
+            printf("[ERROR]: %s timed out at %u bytes\n", uri, sent);
+            fail = 1;
+            break;
+        }
+        /* at most TCP_WND beyond what the device took */
+        room = credited + TCP_WND - sent;
+        if (sent < len && room > 0) {
+            n = (uint16_t) (1 + rnd() % TCP_MSS);
+            n = LWIP_MIN(n, LWIP_MIN(room, LWIP_MIN(len, abort_at) - sent));
+            p = segment(sent, n, seed);
+            if (p == NULL) {
+                printf("[ERROR]: out of pbufs\n");
+                fail = 1;
+                break;
+            }
+            sent += n;
+            if (httpd_post_receive_data(conn, p) != ERR_OK) {
+                printf("[ERROR]: data refused at %u\n", sent);
+                fail = 1;
+                break;
+            }
+        }
+        now += STEP_NS;
+        flash_upload_poll();
+    }
+    return sent;
+}
+
+/*******************************************************************************
+ * tftp_server.c side
+ ******************************************************************************/
+static int tftp_held;     /* the last write() returned TFTP_WRITE_WAIT */
+static int tftp_resumed;
+static int tftp_result;   /* of tftp_write_resume() */
+
+void tftp_write_resume(int result)
+{
+    if (!tftp_held) {
+        printf("[ERROR]: tftp_write_resume() without a held ACK\n");
+        fail = 1;
+    }
+    tftp_held = 0;
+    tftp_resumed++;
+    tftp_result = result;
+}
+
+/* Run the main loop until the held ACK is sent */
+static int tftp_wait(uint64_t t0)
+{
+    while (tftp_held) {
+        if (now - t0 > TIMEOUT_NS)
+            return -1;
+        now += STEP_NS;
+        flash_upload_poll();
+    }
+    return tftp_result;
+}
+
+/**
+ * Write len bytes to name in windows of blocks as the server does, each
+ * window only once the previous one is acknowledged. Stop after abort_at
+ * bytes (the server times out and closes).
+ * @return bytes written, -1 if a write or the last ACK failed
+ */
+static int32_t tftp_upload(const char *name, uint32_t len, uint32_t seed,
+                           uint16_t blksize, uint8_t window,
+                           uint32_t abort_at)
+{
+    const struct tftp_context *ctx = &flash_upload_tftp;
+    uint32_t sent = 0, n;
+    uint64_t t0 = now;
+    void *h = ctx->open(name, "octet", 1);
+    struct pbuf *p;
+    uint8_t i;
+    int ret = 0, last = 0;
+
+    if (h == NULL) {
+        printf("[ERROR]: tftp %s refused\n", name);
+        fail = 1;
+        return -1;
+    }
+    tftp_held = 0;
+    tftp_resumed = 0;
+    while (!last && ret >= 0) {
+        for (i = 0; i < window && !last && ret >= 0; i++) {
+            if (sent >= abort_at) {
+                ctx->close(h);
+                return (int32_t) sent;
+            }
+            n = LWIP_MIN(blksize, len - sent);
+            p = segment(sent, (uint16_t) n, seed);
+            if (p == NULL) {
+                fail = 1;
+                break;
+            }
+            ret = ctx->write(h, p);
+            pbuf_free(p);
+            sent += n;
+            if (ret >= 0 && n < blksize) {
+                last = 1;
+                ret = ctx->write(h, NULL);
+            }
+            tftp_held = ret == TFTP_WRITE_WAIT;
+            /* the client keeps sending the blocks of the window */
+            now += STEP_NS / 8;
+            flash_upload_poll();
+        }
+        if (ret >= 0 && tftp_wait(t0) < 0)
+            ret = -1;
+    }
+    ctx->close(h);
+    return ret < 0 ? -1 : (int32_t) sent;
+}
+
+static void readback(uint32_t addr, uint32_t len, uint32_t seed)
+{
+    static uint8_t buf[FW_SIZE];
+    uint32_t i, bad = 0;
+
+    if (ff.dev.read(&ff.dev, addr, buf, len)) {
+        fail = 1;
+        return;
+    }
+    for (i = 0; i < len; i++)
+        bad += buf[i] != pattern(i, seed);
+    check("bytes not read back", bad, 0, 0);
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+static void test_upload(const char *uri, uint32_t addr, uint32_t len,
+                        uint32_t seed)
+{
+    const struct flash_upload_stats *s = flash_upload_get_stats();
+    uint32_t blocks = ff.block_erases;
+    uint64_t t0 = now;
+
+    upload(&conn_a, uri, len, seed, UINT32_MAX);
+    check("result ok", s->result, FLASH_UPLOAD_OK, FLASH_UPLOAD_OK);
+    check("bytes programmed", s->bytes, len, len);
+    check("window reopened", credited, len, len);
+    readback(addr, len, seed);
+    check("programmed without erase", ff.not_erased, 0, 0);
+    printf("[INFO]: %-14s %7u bytes %5u ms %4u KiB/s, %u block erases\n",
+           uri, len, s->ms,
+           (uint32_t) ((uint64_t) len * 1000000000 / 1024 /
+                       (now - t0 ? now - t0 : 1)),
+           ff.block_erases - blocks);
+    if (len >= 2 * ff.dev.block_size)
+        check("block erases", ff.block_erases - blocks, 1, 16);
+}
+
+static void test_abort(void)
+{
+    const struct flash_upload_stats *s = flash_upload_get_stats();
+    uint32_t sent;
+
+    /* closed halfway, while a page may still be programmed */
+    sent = upload(&conn_b, "/upload/fw", 200000, 3, 100000);
+    check("aborted at", sent, 100000, 100000);
+    check("result aborted", s->result, FLASH_UPLOAD_ABORTED,
+          FLASH_UPLOAD_ABORTED);
+    /* the next one starts right away */
+    test_upload("/upload/fw", FW_ADDR, 150000, 4);
+}
+
+static void test_refused(void)
+{
+    u8_t auto_wnd;
+    char resp[64];
+
+    check("unknown uri",
+          httpd_post_begin(&conn_a, "/upload/x", "", 0, 10, resp,
+                           sizeof(resp), &auto_wnd) != ERR_OK, 1, 1);
+    check("larger than region",
+          httpd_post_begin(&conn_a, "/upload/config", "", 0, CFG_SIZE + 1,
+                           resp, sizeof(resp), &auto_wnd) != ERR_OK, 1, 1);
+    check("first accepted",
+          httpd_post_begin(&conn_a, "/upload/config", "", 0, 100, resp,
+                           sizeof(resp), &auto_wnd), ERR_OK, ERR_OK);
+    check("second refused",
+          httpd_post_begin(&conn_b, "/upload/fw", "", 0, 100, resp,
+                           sizeof(resp), &auto_wnd) != ERR_OK, 1, 1);
+    finish(&conn_a);
+    check("closed before the body", flash_upload_get_stats()->result,
+          FLASH_UPLOAD_ABORTED, FLASH_UPLOAD_ABORTED);
+}
+
+static void test_tftp(uint32_t len, uint16_t blksize, uint8_t window,
+                      uint32_t seed)
+{
+    const struct flash_upload_stats *s = flash_upload_get_stats();
+    uint64_t t0 = now;
+
+    check("tftp written", (uint32_t) tftp_upload("upload/fw", len, seed,
+                                                 blksize, window, UINT32_MAX),
+          len, len);
+    check("tftp result ok", s->result, FLASH_UPLOAD_OK, FLASH_UPLOAD_OK);
+    check("tftp bytes programmed", s->bytes, len, len);
+    readback(FW_ADDR, len, seed);
+    check("programmed without erase", ff.not_erased, 0, 0);
+    /* the flash is slower than the sender */
+    check("tftp acks held", (uint32_t) tftp_resumed, len > 65536, len / 512);
+    printf("[INFO]: tftp %4u x %u    %7u bytes %5u ms %4u KiB/s, %u ACKs "
+           "held\n", blksize, window, len, s->ms,
+           (uint32_t) ((uint64_t) len * 1000000000 / 1024 /
+                       (now - t0 ? now - t0 : 1)), tftp_resumed);
+}
+
+static void test_tftp_refused(void)
+{
+    const struct tftp_context *ctx = &flash_upload_tftp;
+    const struct flash_upload_stats *s = flash_upload_get_stats();
+    u8_t auto_wnd;
+    char resp[64];
+    void *h;
+
+    check("tftp read", ctx->open("upload/fw", "octet", 0) == NULL, 1, 1);
+    check("tftp unknown name", ctx->open("upload/x", "octet", 1) == NULL, 1,
+          1);
+    check("tftp during POST",
+          httpd_post_begin(&conn_a, "/upload/fw", "", 0, 100, resp,
+                           sizeof(resp), &auto_wnd) == ERR_OK &&
+              ctx->open("upload/fw", "octet", 1) == NULL, 1, 1);
+    finish(&conn_a);
+
+    /* one block more than the region */
+    check("tftp larger than region",
+          (uint32_t) tftp_upload("/upload/config", CFG_SIZE + 1, 6, 1468, 4,
+                                 UINT32_MAX), (uint32_t) -1, (uint32_t) -1);
+    check("tftp result aborted", s->result, FLASH_UPLOAD_ABORTED,
+          FLASH_UPLOAD_ABORTED);
+
+    /* the server gives up halfway */
+    check("tftp aborted at",
+          (uint32_t) tftp_upload("upload/fw", 200000, 7, 1468, 4, 100000),
+          100000, 102000);
+    check("tftp result aborted", s->result, FLASH_UPLOAD_ABORTED,
+          FLASH_UPLOAD_ABORTED);
+    h = ctx->open("upload/fw", "octet", 1);
+    check("tftp after abort", h != NULL, 1, 1);
+    ctx->close(h);
+}
+
+int main(void)
+{
+    printf("[test]: httpd POST and TFTP upload to flash.\n\n");
+
+    if (flash_file_open(&ff, NULL, FLASH_SIZE, flash_now_ns) ||
+        flash_upload_init(&ff.dev, regions, LWIP_ARRAYSIZE(regions))) {
+        printf("[ERROR]: cannot create the flash file\n");
+        return 1;
+    }
+
+    test_upload("/upload/fw", FW_ADDR, 256 * 1024, 1);
+    test_upload("/upload/config", CFG_ADDR, 70123, 2);
+    test_upload("/upload/config", CFG_ADDR, 0, 5);
+    test_abort();
+    test_refused();
+    test_tftp(256 * 1024, 512, 1, 8);
+    test_tftp(256 * 1024, 1468, 4, 9);
+    test_tftp(3 * 1468, 1468, 4, 10);
+    test_tftp(0, 1468, 4, 11);
+    test_tftp_refused();
+
+    flash_file_close(&ff);
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,132 @@
+/**
+ * @file test_fs.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - httpd file system: hashed fs_open(), the checksums
+ *        precalculated by makefsdata -c and the gzip variants of -gz
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <zlib.h>
+
+#include "lwip/apps/fs.h"
+#include "lwip/inet_chksum.h"
+#include "test_util.h"
+
+#define LOOKUPS 1000000
+
+static const char *const files[] = {"/index.html", "/404.html",
+                                    "/img/sics.gif", "/index.html.gz",
+                                    "/404.html.gz"};
+
+static const char *const missing[] = {"",          "/",          "/index.htm",
+                                      "/index.html/", "/img",    "/img/",
+                                      "/INDEX.HTML", "/index.html?"};
+
+/* The chunks are contiguous, cover the file and hold its checksums */
+static void check_chunks(const char *name, const struct fs_file *file)
+{
+    uint32_t off = 0;
+    u16_t i;
+
+    check(name, file->chksum_count > 0, 1, 1);
+    for (i = 0; i < file->chksum_count; i++) {
+        const struct fsdata_chksum *c = &file->chksum[i];
+
+        check("chunk offset", c->offset, off, off);
+        check("chunk len", c->len, 1, TCP_MSS);
+        check("chunk chksum",
+              (u16_t) ~inet_chksum(file->data + c->offset, c->len), c->chksum,
+              c->chksum);
+        off += c->len;
+    }
+    check("chunks cover file", off, file->len, file->len);
+}
+
+/* Length of the HTTP header included in front of the file data */
+static uint32_t header_len(const struct fs_file *file)
+{
+    const char *end = strstr(file->data, "\r\n\r\n");
+
+    return end != NULL ? (uint32_t) (end + 4 - file->data) : 0;
+}
+
+static int in_header(const struct fs_file *file, uint32_t hdr, const char *line)
+{
+    const char *p = strstr(file->data, line);
+
+    return p != NULL && p < file->data + hdr;
+}
+
+/* The gzip variant inflates to the body of the original and says so */
+static void check_gzip(const char *name)
+{
+    struct fs_file file, gz;
+    char gz_name[64];
+    uint8_t out[4096];
+    uint32_t hdr, gz_hdr;
+    z_stream strm;
+
+    snprintf(gz_name, sizeof(gz_name), "%s.gz", name);
+    check(name, fs_open(&file, name), ERR_OK, ERR_OK);
+    check("has gzip flag", file.flags & FS_FILE_FLAGS_HAS_GZIP,
+          FS_FILE_FLAGS_HAS_GZIP, FS_FILE_FLAGS_HAS_GZIP);
+    check(gz_name, fs_open(&gz, gz_name), ERR_OK, ERR_OK);
+    check("variant flag", gz.flags & FS_FILE_FLAGS_HAS_GZIP, 0, 0);
+    hdr = header_len(&file);
+    gz_hdr = header_len(&gz);
+    check("header", hdr > 0 && gz_hdr > 0, 1, 1);
+    check("Content-Encoding", in_header(&gz, gz_hdr, "Content-Encoding: gzip\r\n"),
+          1, 1);
+    check("Vary", in_header(&file, hdr, "Vary: Accept-Encoding\r\n"), 1, 1);
+    check("Vary gz", in_header(&gz, gz_hdr, "Vary: Accept-Encoding\r\n"), 1, 1);
+    check("smaller", gz.len - gz_hdr, 1, file.len - hdr - 1);
+
+    memset(&strm, 0, sizeof(strm));
+    inflateInit2(&strm, 15 + 16);
+    strm.next_in = (Bytef *) gz.data + gz_hdr;
+    strm.avail_in = gz.len - gz_hdr;
+    strm.next_out = out;
+    strm.avail_out = sizeof(out);
+    check("inflate", inflate(&strm, Z_FINISH), Z_STREAM_END, Z_STREAM_END);
+    check("inflated len", strm.total_out, file.len - hdr, file.len - hdr);
+    check("inflated data",
+          memcmp(out, file.data + hdr, file.len - hdr) == 0, 1, 1);
+    inflateEnd(&strm);
+    fs_close(&gz);
+    fs_close(&file);
+}
+
+int main(void)
+{
+    struct fs_file file;
+    uint64_t t;
+    uint32_t i;
+
+    printf("[test]: httpd file system.\n\n");
+
+    for (i = 0; i < sizeof(files) / sizeof(files[0]); i++) {
+        check(files[i], fs_open(&file, files[i]), ERR_OK, ERR_OK);
+        check_chunks(files[i], &file);
+        fs_close(&file);
+    }
+    check_gzip("/index.html");
+    check_gzip("/404.html");
+    check("/img/sics.gif.gz", (uint32_t) -fs_open(&file, "/img/sics.gif.gz"),
+          -ERR_VAL, -ERR_VAL);
+    for (i = 0; i < sizeof(missing) / sizeof(missing[0]); i++)
+        check(missing[i], (uint32_t) -fs_open(&file, missing[i]), -ERR_VAL,
+              -ERR_VAL);
+
+    t = host_ns();
+    for (i = 0; i < LOOKUPS; i++) {
+        fs_open(&file, files[i % 3]);
+        fs_close(&file);
+    }
+    printf("[INFO]: fs_open %.1f ns\n", (double) (host_ns() - t) / LOOKUPS);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,414 @@
+/**
+ * @file test_httpd_parser.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - incremental httpd request parser: known requests, a
+ *        mutation fuzzer and the parse time against the segment count.
+ *
+ *   test_httpd_parser [-n fuzz_iterations] [-s seed]
+ *
+ * Every request is parsed in one pbuf and again fed segment by segment the
+ * way httpd receives it; the results must not depend on the segmentation.
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "httpd_parser.h"
+#include "lwip/def.h"
+#include "test_util.h"
+
+#define MAX_REQ       1024
+#define MAX_SEGS      64
+#define BENCH_ROUNDS  20000
+
+/*******************************************************************************
+ * pbuf chains over a request buffer
+ ******************************************************************************/
+static struct pbuf segs[MAX_SEGS];
+
+/* Chain of n segments, cut at the offsets cuts[0 .. n-2] */
+static struct pbuf *chain(const char *data, uint16_t len, const uint16_t *cuts,
+                          int n)
+{
+    uint16_t start = 0, end;
+    int i;
+
+    for (i = 0; i < n; i++) {
+        end = i < n - 1 ? cuts[i] : len;
+        memset(&segs[i], 0, sizeof(segs[i]));
+        segs[i].payload = (void *) (data + start);
+        segs[i].len = end - start;
+        segs[i].next = i < n - 1 ? &segs[i + 1] : NULL;
+        start = end;
+    }
+    for (i = n - 1; i >= 0; i--)
+        segs[i].tot_len = segs[i].len + (i < n - 1 ? segs[i + 1].tot_len : 0);
+    return &segs[0];
+}
+
+/* Append the segments one by one, as httpd does, and parse after each */
+static err_t parse_segmented(struct http_req_parser *rp, const char *data,
+                             uint16_t len, const uint16_t *cuts, int n)
+{
+    struct pbuf *p = chain(data, len, cuts, n);
+    uint16_t tot;
+    err_t err = ERR_INPROGRESS;
+    int i, j;
+
+    http_req_parser_init(rp);
+    for (i = 0; i < n && err == ERR_INPROGRESS; i++) {
+        /* the chain as received so far */
+        segs[i].next = NULL;
+        for (j = i, tot = 0; j >= 0; j--) {
+            tot += segs[j].len;
+            segs[j].tot_len = tot;
+        }
+        err = http_req_parse(rp, p, MAX_REQ);
+        if (i < n - 1)
+            segs[i].next = &segs[i + 1];
+    }
+    return err;
+}
+
+static err_t parse_whole(struct http_req_parser *rp, const char *data,
+                         uint16_t len)
+{
+    http_req_parser_init(rp);
+    return http_req_parse(rp, chain(data, len, NULL, 1), MAX_REQ);
+}
+
+/* The results that matter to httpd */
+static int same(const struct http_req_parser *a, const struct http_req_parser *b)
+{
+    return a->method == b->method && a->version == b->version &&
+           a->flags == b->flags && a->uri_off == b->uri_off &&
+           a->uri_len == b->uri_len && a->hdr_len == b->hdr_len &&
+           a->content_len == b->content_len &&
+           memcmp(a->val_off, b->val_off, sizeof(a->val_off)) == 0 &&
+           memcmp(a->val_len, b->val_len, sizeof(a->val_len)) == 0;
+}
+
+/*******************************************************************************
+ * Known requests
+ ******************************************************************************/
+static const struct {
+    const char *req;
+    err_t err;
+    uint8_t method, version, flags;
+    const char *uri;
+    uint32_t content_len;
+} cases[] = {
+    {"GET / HTTP/1.0\r\n\r\n", ERR_OK, HTTP_METHOD_GET, HTTP_VERSION_10, 0,
+     "/", 0},
+    {"GET /index.html HTTP/1.1\r\nHost: a\r\n\r\n", ERR_OK, HTTP_METHOD_GET,
+     HTTP_VERSION_11, 0, "/index.html", 0},
+    {"GET /\r\n", ERR_OK, HTTP_METHOD_GET, HTTP_VERSION_09, 0, "/", 0},
+    {"GET / HTTP/1.1\nconnection:close\n\n", ERR_OK, HTTP_METHOD_GET,
+     HTTP_VERSION_11, HTTP_REQ_FLAG_CLOSE, "/", 0},
+    {"GET / HTTP/1.0\r\nConnection: Keep-Alive\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_10, HTTP_REQ_FLAG_KEEPALIVE, "/", 0},
+    {"GET / HTTP/1.1\r\nConnection: Upgrade, keep-alive \r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11,
+     HTTP_REQ_FLAG_KEEPALIVE | HTTP_REQ_FLAG_UPGRADE, "/", 0},
+    {"GET /ws HTTP/1.1\r\nUpgrade: WebSocket\r\nConnection: Upgrade\r\n"
+     "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ== \r\n"
+     "Sec-WebSocket-Version: 13\r\n\r\n", ERR_OK, HTTP_METHOD_GET,
+     HTTP_VERSION_11, HTTP_REQ_FLAG_UPGRADE | HTTP_REQ_FLAG_WEBSOCKET, "/ws",
+     0},
+    {"GET / HTTP/1.1\r\nUpgrade: h2c, websocketX\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"GET / HTTP/1.1\r\nConnection: keep-aliveX\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"GET / HTTP/1.1\r\nAccept-Encoding: gzip, deflate, br\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, HTTP_REQ_FLAG_GZIP, "/", 0},
+    {"GET / HTTP/1.1\r\nAccept-Encoding: deflate;q=0.5, GZIP;q=0.8\r\n\r\n",
+     ERR_OK, HTTP_METHOD_GET, HTTP_VERSION_11, HTTP_REQ_FLAG_GZIP, "/", 0},
+    {"GET / HTTP/1.1\r\nAccept-Encoding: gzip;q=0, br\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"GET / HTTP/1.1\r\nAccept-Encoding: gzip ; q=0.000\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"GET / HTTP/1.1\r\naccept-encoding: Gzip\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, HTTP_REQ_FLAG_GZIP, "/", 0},
+    {"GET / HTTP/1.1\r\nAccept-Encoding: x-gzip\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"GET / HTTP/1.1\r\nX-Accept-Encoding: gzip\r\n\r\n", ERR_OK,
+     HTTP_METHOD_GET, HTTP_VERSION_11, 0, "/", 0},
+    {"POST /upload.cgi HTTP/1.1\r\nContent-Length: 1234\r\n\r\nbody", ERR_OK,
+     HTTP_METHOD_POST, HTTP_VERSION_11, HTTP_REQ_FLAG_CONTENT_LENGTH,
+     "/upload.cgi", 1234},
+    {"POST / HTTP/1.1\r\nContent-Length: 12 3\r\n\r\n", ERR_ARG, 0, 0, 0,
+     NULL, 0},
+    {"POST / HTTP/1.1\r\nContent-Length: 99999999999\r\n\r\n", ERR_ARG, 0, 0,
+     0, NULL, 0},
+    {"POST / HTTP/1.1\r\nContent-Length: 1\r\nContent-Length: 2\r\n\r\n",
+     ERR_ARG, 0, 0, 0, NULL, 0},
+    {"POST / HTTP/1.1\r\nContent-Length:\r\n\r\n", ERR_ARG, 0, 0, 0, NULL, 0},
+    {"PUT /x HTTP/1.1\r\n\r\n", ERR_OK, HTTP_METHOD_UNKNOWN, HTTP_VERSION_11,
+     0, "/x", 0},
+    {"GETS / HTTP/1.1\r\n\r\n", ERR_OK, HTTP_METHOD_UNKNOWN, HTTP_VERSION_11,
+     0, "/", 0},
+    {"GET / HTTP/1.1\r\nNoColon\r\n\r\n", ERR_ARG, 0, 0, 0, NULL, 0},
+    {"\r\nGET / HTTP/1.1\r\n\r\n", ERR_ARG, 0, 0, 0, NULL, 0},
+    {"GET / HTTP/1.1\r\nHost: a\r\n", ERR_INPROGRESS, 0, 0, 0, NULL, 0},
+};
+
+static void check_case(int i)
+{
+    struct http_req_parser ref, rp;
+    const char *req = cases[i].req;
+    uint16_t len = strlen(req), cut, cuts[MAX_SEGS];
+    char what[64];
+    err_t err;
+    int n;
+
+    snprintf(what, sizeof(what), "case %d err", i);
+    err = parse_whole(&ref, req, len);
+    check(what, (uint32_t) -err, -cases[i].err, -cases[i].err);
+    if (err == ERR_OK) {
+        snprintf(what, sizeof(what), "case %d method", i);
+        check(what, ref.method, cases[i].method, cases[i].method);
+        snprintf(what, sizeof(what), "case %d version", i);
+        check(what, ref.version, cases[i].version, cases[i].version);
+        snprintf(what, sizeof(what), "case %d flags", i);
+        check(what, ref.flags, cases[i].flags, cases[i].flags);
+        snprintf(what, sizeof(what), "case %d uri", i);
+        check(what,
+              ref.uri_len == strlen(cases[i].uri) &&
+                  memcmp(req + ref.uri_off, cases[i].uri, ref.uri_len) == 0,
+              1, 1);
+        snprintf(what, sizeof(what), "case %d content_len", i);
+        check(what, ref.content_len, cases[i].content_len,
+              cases[i].content_len);
+    }
+
+    /* every two-segment split and one byte per segment (as far as fits) */
+    for (cut = 1; cut < len; cut++) {
+        snprintf(what, sizeof(what), "case %d split %u", i, cut);
+        err = parse_segmented(&rp, req, len, &cut, 2);
+        check(what, (uint32_t) -err, -cases[i].err, -cases[i].err);
+        if (err == ERR_OK)
+            check(what, same(&ref, &rp), 1, 1);
+    }
+    if (len <= MAX_SEGS) {
+        for (n = 0; n < len - 1; n++)
+            cuts[n] = n + 1;
+        snprintf(what, sizeof(what), "case %d bytewise", i);
+        err = parse_segmented(&rp, req, len, cuts, len);
+        check(what, (uint32_t) -err, -cases[i].err, -cases[i].err);
+        if (err == ERR_OK)
+            check(what, same(&ref, &rp), 1, 1);
+    }
+}
+
+/*******************************************************************************
+ * Fuzzer
+ ******************************************************************************/
+static uint32_t rnd_below(uint32_t n)
+{
+    return rnd() % n;
+}
+
+static const char *const corpus[] = {
+    "GET /index.html HTTP/1.1\r\nHost: 192.168.0.23\r\nConnection: "
+    "keep-alive\r\nAccept-Encoding: gzip, deflate\r\n\r\n",
+    "POST /cfg.cgi HTTP/1.1\r\nContent-Length: 42\r\nConnection: close\r\n\r\n",
+    "GET /img/sics.gif HTTP/1.0\r\nAccept-Encoding: br;q=1, gzip;q=0\r\n\r\n",
+    "GET /ws HTTP/1.1\r\nUpgrade: websocket\r\nConnection: Upgrade\r\n"
+    "Sec-WebSocket-Key: dGhlIHNhbXBsZSBub25jZQ==\r\n\r\n",
+};
+
+static const char fuzz_chars[] = "\r\n :;,=qQ0123456789GETPOSHgzipkeep-alive";
+
+static uint16_t mutate(char *buf, const char *seed)
+{
+    uint16_t len = strlen(seed);
+    uint32_t k, ops = 1 + rnd_below(8);
+
+    memcpy(buf, seed, len);
+    for (k = 0; k < ops && len > 0; k++) {
+        uint32_t at = rnd_below(len);
+
+        switch (rnd_below(5)) {
+        case 0: /* replace */
+            buf[at] = rnd_below(4)
+                          ? fuzz_chars[rnd_below(sizeof(fuzz_chars) - 1)]
+                          : (char) rnd_below(256);
+            break;
+        case 1: /* insert */
+            if (len < MAX_REQ - 1) {
+                memmove(&buf[at + 1], &buf[at], len - at);
+                buf[at] = fuzz_chars[rnd_below(sizeof(fuzz_chars) - 1)];
+                len++;
+            }
+            break;
+        case 2: /* delete */
+            memmove(&buf[at], &buf[at + 1], len - at - 1);
+            len--;
+            break;
+        case 3: /* truncate */
+            len = at;
+            break;
+        default: /* repeat a piece */
+            if (len + 16 < MAX_REQ) {
+                uint32_t n = 1 + rnd_below(16);
+
+                if (at + n > len)
+                    n = len - at;
+                memmove(&buf[at + n], &buf[at], len - at);
+                len += n;
+            }
+            break;
+        }
+    }
+    return len;
+}
+
+static void fuzz(uint32_t iterations)
+{
+    static char buf[MAX_REQ];
+    struct http_req_parser ref, rp;
+    uint16_t len, cuts[MAX_SEGS], last;
+    uint32_t i, ok = 0;
+    err_t err, err2;
+    int n, k;
+
+    for (i = 0; i < iterations; i++) {
+        len = mutate(buf, corpus[rnd_below(LWIP_ARRAYSIZE(corpus))]);
+        if (len == 0)
+            continue;
+        err = parse_whole(&ref, buf, len);
+        if (err == ERR_OK) {
+            ok++;
+            check("hdr_len", ref.hdr_len, 1, len);
+            check("uri", ref.uri_off + ref.uri_len, 0, ref.hdr_len);
+            for (k = 0; k < HTTP_REQ_HDR_COUNT; k++)
+                check("value", ref.val_off[k] + ref.val_len[k], 0,
+                      ref.hdr_len);
+        }
+
+        /* random segmentation, sorted distinct cuts */
+        n = 1 + rnd_below(len < 8 ? len : 8);
+        for (k = 0, last = 0; k < n - 1; k++) {
+            if (last + 1 >= len)
+                break;
+            cuts[k] = last + 1 + rnd_below(len - last - 1);
+            last = cuts[k];
+        }
+        n = k + 1;
+        err2 = parse_segmented(&rp, buf, len, cuts, n);
+        check("segmented err", (uint32_t) -err2, -err, -err);
+        if (err == ERR_OK && err2 == ERR_OK && !same(&ref, &rp)) {
+            printf("[ERROR]: segmentation changes the result: %.*s\n", len,
+                   buf);
+            fail = 1;
+        }
+        if (fail)
+            break;
+    }
+    printf("[INFO]: fuzz %u requests, %u parsed\n", iterations, ok);
+}
+
+/*******************************************************************************
+ * Parse time against the number of segments
+ ******************************************************************************/
+/* Before: copy the chain to a buffer and search it for every segment */
+static int copy_and_search(struct pbuf *p)
+{
+    static char buf[MAX_REQ];
+    u16_t len = LWIP_MIN(p->tot_len, MAX_REQ - 1);
+    char *data = p->payload;
+
+    if (p->next != NULL) {
+        pbuf_copy_partial(p, buf, len, 0);
+        data = buf;
+    }
+    return lwip_strnstr(data, "\r\n\r\n", len) != NULL;
+}
+
+static void bench(void)
+{
+    static const char req[] =
+        "GET /index.html HTTP/1.1\r\n"
+        "Host: 192.168.0.23\r\n"
+        "User-Agent: Mozilla/5.0 (X11; Linux x86_64; rv:109.0) "
+        "Gecko/20100101 Firefox/115.0\r\n"
+        "Accept: text/html,application/xhtml+xml,application/xml;q=0.9,"
+        "image/avif,image/webp,*/*;q=0.8\r\n"
+        "Accept-Language: en-US,en;q=0.5\r\n"
+        "Accept-Encoding: gzip, deflate\r\n"
+        "Connection: keep-alive\r\n"
+        "Upgrade-Insecure-Requests: 1\r\n\r\n";
+    static const int nsegs[] = {1, 4, 16, 64};
+    uint16_t len = sizeof(req) - 1, cuts[MAX_SEGS], tot;
+    struct http_req_parser rp;
+    struct pbuf *p;
+    uint64_t t, t_new, t_old;
+    uint32_t r;
+    int i, k, n, done = 0;
+
+    printf("[INFO]: %u byte request, ns per request\n", len);
+    printf("%8s %12s %12s\n", "segments", "incremental", "copy+search");
+    for (i = 0; i < (int) LWIP_ARRAYSIZE(nsegs); i++) {
+        n = nsegs[i];
+        for (k = 0; k < n - 1; k++)
+            cuts[k] = (uint16_t) ((uint32_t) len * (k + 1) / n);
+
+        t = host_ns();
+        for (r = 0; r < BENCH_ROUNDS; r++)
+            done += parse_segmented(&rp, req, len, cuts, n) == ERR_OK;
+        t_new = host_ns() - t;
+
+        t = host_ns();
+        for (r = 0; r < BENCH_ROUNDS; r++) {
+            p = chain(req, len, cuts, n);
+            for (k = 0, tot = 0; k < n; k++) {
+                segs[k].next = NULL;
+                tot += segs[k].len;
+                p->tot_len = tot;
+                done += copy_and_search(p) && k == n - 1;
+                if (k < n - 1)
+                    segs[k].next = &segs[k + 1];
+            }
+        }
+        t_old = host_ns() - t;
+        printf("%8d %12llu %12llu\n", n,
+               (unsigned long long) (t_new / BENCH_ROUNDS),
+               (unsigned long long) (t_old / BENCH_ROUNDS));
+    }
+    check("bench parsed", done, 2 * BENCH_ROUNDS * LWIP_ARRAYSIZE(nsegs),
+          2 * BENCH_ROUNDS * LWIP_ARRAYSIZE(nsegs));
+}
+
+int main(int argc, char **argv)
+{
+    uint32_t iterations = 200000;
+    int i, opt;
+
+    while ((opt = getopt(argc, argv, "n:s:")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = strtoul(optarg, NULL, 0);
+            break;
+        case 's':
+            rnd_state = strtoul(optarg, NULL, 0);
+            break;
+        default:
+            printf("usage: %s [-n fuzz_iterations] [-s seed]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    printf("[test]: httpd request parser.\n\n");
+
+    for (i = 0; i < (int) LWIP_ARRAYSIZE(cases); i++)
+        check_case(i);
+    fuzz(iterations);
+    bench();
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,487 @@
+/**
+ * @file test_ip4_reass.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - IPv4 reassembly (ip4_frag.c): datagrams from fragments
+ *        in any order, split over pbuf chains and repeated, overlapping and
+ *        inconsistent fragments, the time exceeded timeout, a legitimate
+ *        sender under a fragment flood within the per-source and total pbuf
+ *        limits, random fragments, and the time per fragment with many
+ *        datagrams in progress.
+ *
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/icmp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/ip4_frag.h"
+#include "lwip/memp.h"
+#include "lwip/prot/ip4.h"
+#include "test_util.h"
+
+#define MTU_DATA      1480 /* fragment payload of a 1500 byte MTU */
+#define MAX_DATAGRAM  8000
+#define ORDER_ROUNDS  300
+#define FLOOD_FRAGS   20000
+#define RANDOM_FRAGS  200000
+#define BENCH_SRCS    16
+#define BENCH_DGRAMS  48   /* in progress at once, 3 per source */
+#define BENCH_FRAGS   8    /* fragments per datagram, 11840 bytes */
+#define BENCH_ROUNDS  400
+
+#define SRC_LEGIT     10
+#define SRC_FLOOD     66
+
+/*******************************************************************************
+ * Fragments, custom pbufs counted until ip4_frag.c frees them
+ ******************************************************************************/
+struct frag_buf {
+    struct pbuf_custom pc;
+    uint8_t data[];
+};
+
+static uint32_t live; /* fragment pbufs not freed */
+static uint32_t max_live;
+
+static void frag_free(struct pbuf *p)
+{
+    live--;
+    free(p);
+}
+
+static struct pbuf *frag_pbuf(uint16_t len)
+{
+    struct frag_buf *b = malloc(sizeof(*b) + len);
+
+    b->pc.custom_free_function = frag_free;
+    live++;
+    return pbuf_alloced_custom(PBUF_RAW, len, PBUF_RAM, &b->pc, b->data, len);
+}
+
+/* Byte 'off' of datagram 'id' from 192.168.0.'src' */
+static uint8_t data_at(uint32_t src, uint32_t id, uint32_t off)
+{
+    return (uint8_t) ((src * 7 + id * 31 + off * 13) ^ (off >> 8));
+}
+
+/* One fragment, its IP header and the first 8 data bytes in a pbuf of their
+ * own if 'split' */
+static struct pbuf *fragment(uint32_t src, uint16_t id, uint8_t proto,
+                             uint16_t off, uint16_t len, int mf, int split)
+{
+    static uint8_t buf[IP_HLEN + 0x10000];
+    struct ip_hdr *iph = (struct ip_hdr *) buf;
+    uint16_t head = (split && len > 8) ? 8 : len;
+    struct pbuf *p;
+    uint32_t i;
+
+    memset(iph, 0, IP_HLEN);
+    IPH_VHL_SET(iph, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iph, lwip_htons(IP_HLEN + len));
+    IPH_ID_SET(iph, lwip_htons(id));
+    IPH_OFFSET_SET(iph, lwip_htons((off / 8) | (mf ? IP_MF : 0)));
+    IPH_TTL_SET(iph, 64);
+    IPH_PROTO_SET(iph, proto);
+    ip4_addr_set_u32(&iph->src, lwip_htonl(0xc0a80000u + src));
+    ip4_addr_set_u32(&iph->dest, lwip_htonl(0xc0a80017u));
+    IPH_CHKSUM_SET(iph, inet_chksum(iph, IP_HLEN));
+    for (i = 0; i < len; i++)
+        buf[IP_HLEN + i] = data_at(src, id, off + i);
+
+    p = frag_pbuf(IP_HLEN + head);
+    if (head < len)
+        pbuf_cat(p, frag_pbuf(len - head));
+    pbuf_take(p, buf, IP_HLEN + len);
+    return p;
+}
+
+/* A reassembled datagram against data_at(), then freed */
+static int verify(struct pbuf *p, uint32_t src, uint16_t len)
+{
+    static uint8_t buf[IP_HLEN + 0x10000];
+    struct ip_hdr *iph = (struct ip_hdr *) p->payload;
+    uint16_t id = lwip_ntohs(IPH_ID(iph));
+    struct pbuf *q;
+    int ok;
+    uint32_t i;
+
+    ok = p->tot_len == IP_HLEN + len &&
+         lwip_ntohs(IPH_LEN(iph)) == p->tot_len && IPH_OFFSET(iph) == 0 &&
+         inet_chksum(iph, IP_HLEN) == 0 &&
+         ip4_addr_get_u32(&iph->src) == lwip_htonl(0xc0a80000u + src);
+    for (q = p; q != NULL; q = q->next)
+        ok &= q->tot_len == q->len + (q->next ? q->next->tot_len : 0);
+    if (ok) {
+        pbuf_copy_partial(p, buf, p->tot_len, 0);
+        for (i = 0; i < len; i++)
+            ok &= buf[IP_HLEN + i] == data_at(src, id, i);
+    }
+    pbuf_free(p);
+    return ok;
+}
+
+static struct pbuf *input(struct pbuf *p)
+{
+    p = ip4_reass(p);
+    if (live > max_live)
+        max_live = live;
+    return p;
+}
+
+/*******************************************************************************
+ * ICMP time exceeded, sent for timed out datagrams with the first fragment
+ ******************************************************************************/
+static uint32_t icmp_sent, icmp_bad;
+
+void icmp_time_exceeded(struct pbuf *p, enum icmp_te_type t)
+{
+    struct ip_hdr *iph = (struct ip_hdr *) p->payload;
+
+    icmp_sent++;
+    if (t != ICMP_TE_FRAG || p->len < IP_HLEN + 8 ||
+        (lwip_ntohs(IPH_OFFSET(iph)) & IP_OFFMASK) != 0 ||
+        inet_chksum(iph, IP_HLEN) != 0)
+        icmp_bad++;
+}
+
+static void expire(void)
+{
+    uint32_t i;
+
+    for (i = 0; i <= IP_REASS_MAXAGE; i++)
+        ip_reass_tmr();
+}
+
+/*******************************************************************************
+ * Fragment orders
+ ******************************************************************************/
+struct frag {
+    uint16_t off;
+    uint16_t len;
+    int mf;
+};
+
+static uint32_t make_frags(struct frag *f, uint16_t len, uint16_t size)
+{
+    uint32_t n = 0;
+    uint16_t off;
+
+    for (off = 0; off < len; off += size) {
+        f[n].off = off;
+        f[n].len = LWIP_MIN(size, len - off);
+        f[n].mf = off + size < len;
+        n++;
+    }
+    return n;
+}
+
+static void test_orders(void)
+{
+    static struct frag f[MAX_DATAGRAM / 8], order[2 * MAX_DATAGRAM / 8];
+    uint32_t round, i, j, n, total, got = 0, bad = 0, early = 0;
+    struct frag last;
+    struct pbuf *p;
+
+    for (round = 0; round < ORDER_ROUNDS; round++) {
+        uint16_t len = 1 + rnd() % MAX_DATAGRAM;
+        uint16_t size = 8 * (1 + rnd() % (MTU_DATA / 8));
+
+        /* up to 40 fragments, within IP_REASS_MAX_PBUFS_PER_SRC */
+        size = LWIP_MAX(size, 8 * ((len + 319) / 320));
+
+        n = make_frags(f, len, size);
+        for (i = 0; i < n; i++)
+            order[i] = f[i];
+        /* in order, reversed or shuffled */
+        if (round % 3 == 1) {
+            for (i = 0; i < n; i++)
+                order[i] = f[n - 1 - i];
+        } else if (round % 3 == 2) {
+            for (i = n - 1; i > 0; i--) {
+                struct frag t = order[i];
+                j = rnd() % (i + 1);
+                order[i] = order[j];
+                order[j] = t;
+            }
+        }
+        /* repeat some, but not the fragment completing the datagram */
+        last = order[n - 1];
+        total = n - 1;
+        for (i = 0; i + 1 < n && i < n / 2; i++) {
+            j = rnd() % (total + 1);
+            memmove(&order[j + 1], &order[j], (total - j) * sizeof(order[0]));
+            order[j] = order[(j + 1 + rnd() % total) % (total + 1)];
+            total++;
+        }
+        order[total++] = last;
+        for (i = 0; i < total; i++) {
+            p = input(fragment(SRC_LEGIT, (uint16_t) round, IP_PROTO_UDP,
+                               order[i].off, order[i].len, order[i].mf,
+                               rnd() & 1));
+            if (p == NULL)
+                continue;
+            if (i != total - 1)
+                early++;
+            got++;
+            bad += !verify(p, SRC_LEGIT, len);
+        }
+    }
+    check("orders: datagrams", got, ORDER_ROUNDS, ORDER_ROUNDS);
+    check("orders: completed early", early, 0, 0);
+    check("orders: corrupt", bad, 0, 0);
+    check("orders: pbufs left", live, 0, 0);
+}
+
+/*******************************************************************************
+ * Overlapping and inconsistent fragments
+ ******************************************************************************/
+static void test_overlap(void)
+{
+    struct pbuf *p;
+
+    /* part overlap: the datagram is discarded */
+    input(fragment(SRC_LEGIT, 1, IP_PROTO_UDP, 0, 1480, 1, 0));
+    input(fragment(SRC_LEGIT, 1, IP_PROTO_UDP, 1000, 1000, 1, 0));
+    check("overlap: discarded", live, 0, 0);
+
+    /* within the data received: the fragment is dropped, not the datagram */
+    input(fragment(SRC_LEGIT, 2, IP_PROTO_UDP, 0, 1480, 1, 0));
+    input(fragment(SRC_LEGIT, 2, IP_PROTO_UDP, 8, 16, 1, 0));
+    check("overlap: duplicate dropped", live, 1, 1);
+    input(fragment(SRC_LEGIT, 2, IP_PROTO_UDP, 2960, 1040, 0, 1));
+    p = input(fragment(SRC_LEGIT, 2, IP_PROTO_UDP, 1480, 1480, 1, 1));
+    check("overlap: completed after duplicate", p && verify(p, SRC_LEGIT, 4000),
+          1, 1);
+
+    /* last fragments disagreeing on the length */
+    input(fragment(SRC_LEGIT, 3, IP_PROTO_UDP, 1480, 1040, 0, 0));
+    input(fragment(SRC_LEGIT, 3, IP_PROTO_UDP, 1480, 1048, 0, 0));
+    check("overlap: two lengths", live, 0, 0);
+
+    /* data beyond the end, after and before the last fragment */
+    input(fragment(SRC_LEGIT, 4, IP_PROTO_UDP, 1480, 1040, 0, 0));
+    input(fragment(SRC_LEGIT, 4, IP_PROTO_UDP, 2520, 8, 1, 0));
+    check("overlap: beyond the end", live, 0, 0);
+    input(fragment(SRC_LEGIT, 5, IP_PROTO_UDP, 2960, 1480, 1, 0));
+    input(fragment(SRC_LEGIT, 5, IP_PROTO_UDP, 1480, 1040, 0, 0));
+    check("overlap: end before data", live, 0, 0);
+
+    /* the same ID with another protocol is another datagram */
+    input(fragment(SRC_LEGIT, 6, IP_PROTO_UDP, 0, 1480, 1, 0));
+    input(fragment(SRC_LEGIT, 6, IP_PROTO_TCP, 0, 1480, 1, 0));
+    p = input(fragment(SRC_LEGIT, 6, IP_PROTO_UDP, 1480, 100, 0, 0));
+    check("overlap: udp completed", p && verify(p, SRC_LEGIT, 1580), 1, 1);
+    p = input(fragment(SRC_LEGIT, 6, IP_PROTO_TCP, 1480, 200, 0, 0));
+    check("overlap: tcp completed", p && verify(p, SRC_LEGIT, 1680), 1, 1);
+
+    /* empty fragments are not kept */
+    input(fragment(SRC_LEGIT, 7, IP_PROTO_UDP, 0, 0, 1, 0));
+    check("overlap: empty fragment", live, 0, 0);
+}
+
+/*******************************************************************************
+ * Timeout
+ ******************************************************************************/
+static void test_timeout(void)
+{
+    uint32_t i;
+
+    icmp_sent = 0;
+    /* with the first fragment, chained behind the second, and without */
+    input(fragment(SRC_LEGIT, 10, IP_PROTO_UDP, 0, 1480, 1, 1));
+    input(fragment(SRC_LEGIT, 10, IP_PROTO_UDP, 1480, 1480, 1, 0));
+    input(fragment(SRC_LEGIT, 11, IP_PROTO_UDP, 1480, 1480, 1, 0));
+    for (i = 0; i < IP_REASS_MAXAGE; i++)
+        ip_reass_tmr();
+    check("timeout: kept until the age", live, 4, 4);
+    ip_reass_tmr();
+    check("timeout: freed", live, 0, 0);
+    check("timeout: time exceeded", icmp_sent, 1, 1);
+    check("timeout: time exceeded header", icmp_bad, 0, 0);
+}
+
+/*******************************************************************************
+ * Flood
+ ******************************************************************************/
+/* FLOOD_FRAGS fragments of datagrams never completed from 'srcs' sources, a
+ * fragment of a datagram of SRC_LEGIT each 50 in between */
+static void flood(uint32_t srcs, uint16_t frags_per_dgram, const char *what)
+{
+    static struct frag f[MAX_DATAGRAM / 8];
+    uint32_t i, n, k = 0, legit = 0, sent = 0, bad = 0;
+    uint16_t id = 100;
+    char name[64];
+    struct pbuf *p;
+
+    n = make_frags(f, MAX_DATAGRAM, MTU_DATA);
+    icmp_sent = 0;
+    max_live = 0;
+    for (i = 0; i < FLOOD_FRAGS; i++) {
+        uint32_t src = SRC_FLOOD + i % srcs;
+        uint32_t seq = i / srcs;
+
+        /* offset 0 on, the last fragment never sent */
+        input(fragment(src, (uint16_t) (seq / frags_per_dgram), IP_PROTO_UDP,
+                       (uint16_t) ((seq % frags_per_dgram) * MTU_DATA),
+                       MTU_DATA, 1, 0));
+        if (i % 50 != 0)
+            continue;
+        p = input(fragment(SRC_LEGIT, id, IP_PROTO_UDP, f[k].off, f[k].len,
+                           f[k].mf, 0));
+        if (++k == n) {
+            sent++;
+            legit += p != NULL;
+            bad += p && !verify(p, SRC_LEGIT, MAX_DATAGRAM);
+            id++;
+            k = 0;
+        }
+    }
+    snprintf(name, sizeof(name), "flood %s: legit datagrams", what);
+    check(name, legit, sent, sent);
+    snprintf(name, sizeof(name), "flood %s: corrupt", what);
+    check(name, bad, 0, 0);
+    snprintf(name, sizeof(name), "flood %s: pbufs queued", what);
+    check(name, max_live, 1, IP_REASS_MAX_PBUFS);
+    snprintf(name, sizeof(name), "flood %s: time exceeded", what);
+    check(name, icmp_sent, 0, 0);
+    printf("[INFO]: flood %s: %u legit datagrams of %u completed, "
+           "%u pbufs queued at most\n",
+           what, legit, sent, max_live);
+    expire();
+    snprintf(name, sizeof(name), "flood %s: pbufs left", what);
+    check(name, live, 0, 0);
+}
+
+static void test_flood(void)
+{
+    /* one source starting datagrams: short of struct ip_reassdata */
+    flood(1, 1, "of first fragments");
+    /* one source, datagrams of 40 fragments: its own pbuf limit */
+    flood(1, 40, "of long datagrams");
+    /* 8 sources, 40 fragments: the total pbuf limit */
+    flood(8, 40, "from 8 sources");
+}
+
+/*******************************************************************************
+ * Random fragments
+ ******************************************************************************/
+static void test_random(void)
+{
+    uint32_t i, got = 0, bad = 0;
+    struct pbuf *p;
+
+    max_live = 0;
+    for (i = 0; i < RANDOM_FRAGS; i++) {
+        uint32_t src = 1 + rnd() % 4;
+        uint16_t id = rnd() % 16;
+        uint16_t off, len;
+        int mf = rnd() % 4 != 0;
+
+        if (rnd() & 1) {
+            /* on the MTU grid of a datagram of 1 to 5 fragments */
+            uint16_t dlen = 1 + (src * 1009 + id * 733) % (5 * MTU_DATA);
+            off = MTU_DATA * (rnd() % (1 + (dlen - 1) / MTU_DATA));
+            len = LWIP_MIN(MTU_DATA, dlen - off);
+            mf = off + len < dlen;
+        } else {
+            off = 8 * (rnd() % 1000);
+            len = mf ? 8 * (rnd() % 200) : rnd() % 1600;
+        }
+        p = input(fragment(src, id, (rnd() % 8) ? IP_PROTO_UDP : IP_PROTO_TCP,
+                           off, len, mf, rnd() % 3 == 0));
+        if (p != NULL) {
+            got++;
+            bad += !verify(p, src,
+                           lwip_ntohs(IPH_LEN((struct ip_hdr *) p->payload)) -
+                               IP_HLEN);
+        }
+        if (i % 1000 == 999)
+            ip_reass_tmr();
+    }
+    printf("[INFO]: random: %u fragments, %u datagrams, %u pbufs queued at "
+           "most\n",
+           RANDOM_FRAGS, got, max_live);
+    check("random: datagrams", got, 1, RANDOM_FRAGS);
+    check("random: corrupt", bad, 0, 0);
+    check("random: pbufs queued", max_live, 1, IP_REASS_MAX_PBUFS);
+    expire();
+    check("random: pbufs left", live, 0, 0);
+}
+
+/*******************************************************************************
+ * Benchmark
+ ******************************************************************************/
+static struct pbuf *bench_frags[BENCH_DGRAMS * BENCH_FRAGS];
+
+/* BENCH_ROUNDS times BENCH_DGRAMS datagrams in progress at once, fragments
+ * interleaved in turn or shuffled, the time in ip4_reass() per fragment */
+static uint64_t bench(int shuffle)
+{
+    uint32_t round, i, j, n = BENCH_DGRAMS * BENCH_FRAGS, got = 0, bad = 0;
+    uint64_t ns = 0, t0;
+    struct pbuf *out[BENCH_DGRAMS];
+    uint32_t outs;
+
+    for (round = 0; round < BENCH_ROUNDS; round++) {
+        for (i = 0; i < n; i++) {
+            uint32_t d = i % BENCH_DGRAMS, k = i / BENCH_DGRAMS;
+            bench_frags[i] = fragment(1 + d % BENCH_SRCS,
+                                      (uint16_t) (round * 8 + d / BENCH_SRCS),
+                                      IP_PROTO_UDP, (uint16_t) (k * MTU_DATA),
+                                      MTU_DATA, k + 1 < BENCH_FRAGS, 0);
+        }
+        for (i = n - 1; shuffle && i > 0; i--) {
+            struct pbuf *t = bench_frags[i];
+            j = rnd() % (i + 1);
+            bench_frags[i] = bench_frags[j];
+            bench_frags[j] = t;
+        }
+        outs = 0;
+        t0 = host_ns();
+        for (i = 0; i < n; i++) {
+            struct pbuf *p = ip4_reass(bench_frags[i]);
+            if (p != NULL && outs < BENCH_DGRAMS)
+                out[outs++] = p;
+        }
+        ns += host_ns() - t0;
+        for (i = 0; i < outs; i++) {
+            struct ip_hdr *iph = (struct ip_hdr *) out[i]->payload;
+            uint32_t src = lwip_ntohl(ip4_addr_get_u32(&iph->src)) & 0xff;
+            bad += !verify(out[i], src, BENCH_FRAGS * MTU_DATA);
+        }
+        got += outs;
+    }
+    check("bench: datagrams", got, BENCH_ROUNDS * BENCH_DGRAMS,
+          BENCH_ROUNDS * BENCH_DGRAMS);
+    check("bench: corrupt", bad, 0, 0);
+    check("bench: pbufs left", live, 0, 0);
+    return ns / (BENCH_ROUNDS * n);
+}
+
+int main(void)
+{
+    uint64_t in_turn, shuffled;
+
+    printf("[test]: IPv4 reassembly\n");
+    memp_init();
+
+    test_orders();
+    test_overlap();
+    test_timeout();
+    test_flood();
+    test_random();
+
+    in_turn = bench(0);
+    shuffled = bench(1);
+    printf("[INFO]: %u datagrams of %u fragments at once, %u hash buckets: "
+           "%llu ns per fragment in turn, %llu ns shuffled\n",
+           BENCH_DGRAMS, BENCH_FRAGS, IP_REASS_HASH_SIZE,
+           (unsigned long long) in_turn, (unsigned long long) shuffled);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
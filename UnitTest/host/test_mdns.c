@@ -0,0 +1,686 @@
+/**
+ * @file test_mdns.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - mDNS responder: kept replies against the built ones and
+ *        dropped when the address, the TXT data or a service name changes,
+ *        known answers clearing answers and additional records, truncated
+ *        queries waiting for the rest of their known answers, the one second
+ *        multicast rate limit per record, and the time per query of a storm
+ *        answered from kept replies against replies built for each query.
+ *
+ * Built with AddressSanitizer and UBSan. The netif is the test's, its
+ * output() decodes what the responder sends.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/apps/mdns.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/init.h"
+#include "lwip/ip.h"
+#include "lwip/ip4.h"
+#include "lwip/netif.h"
+#include "lwip/prot/dns.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "lwip/timeouts.h"
+#include "test_util.h"
+
+#define MDNS_PORT     5353
+#define HOST_TTL      120
+#define MAX_RR        16
+#define MAX_SENT      8
+#define BENCH_QUERIES 20000
+#define STORM_SECONDS (BENCH_QUERIES / 1000)
+
+/* the record sets the storm asks for, more than the replies kept */
+#define BENCH_KINDS   6
+
+#if MDNS_REPLY_CACHE_SIZE + 1 > BENCH_KINDS
+#error "BENCH_KINDS must exceed MDNS_REPLY_CACHE_SIZE"
+#endif
+
+/*******************************************************************************
+ * Time, sys_now() of the stack
+ ******************************************************************************/
+static u32_t now_ms = 1;
+
+u32_t sys_now(void)
+{
+    return now_ms;
+}
+
+static void advance(u32_t ms)
+{
+    while (ms--) {
+        now_ms++;
+        sys_check_timeouts();
+    }
+}
+
+/*******************************************************************************
+ * Replies, decoded from the netif output
+ ******************************************************************************/
+struct rr {
+    char name[256];
+    uint16_t type;
+    uint32_t ttl;
+    uint8_t rdata[256];
+    uint16_t rdlen;
+};
+
+struct msg {
+    uint8_t raw[1500];
+    uint16_t len;
+    ip4_addr_t dst;
+    uint16_t dport;
+    uint16_t id;
+    uint16_t an, ar; /* answers, additional records */
+    uint32_t n;
+    struct rr rr[MAX_RR];
+};
+
+static struct msg sent[MAX_SENT];
+static uint32_t nsent;
+static int decode = 1; /* 0 during the benchmark, only counted */
+
+/* name at *off with the compression jumps followed, dotted */
+static int read_name(const uint8_t *m, uint16_t len, uint16_t *off, char *out)
+{
+    uint16_t pos = *off, jumps = 0, o = 0;
+    int jumped = 0;
+
+    for (;;) {
+        uint8_t l;
+
+        if (pos >= len)
+            return -1;
+        l = m[pos];
+        if ((l & 0xc0) == 0xc0) {
+            if (pos + 1 >= len || ++jumps > 8)
+                return -1;
+            if (!jumped)
+                *off = pos + 2;
+            jumped = 1;
+            pos = ((l & 0x3f) << 8) | m[pos + 1];
+            continue;
+        }
+        pos++;
+        if (l == 0)
+            break;
+        if (pos + l > len || o + l + 1 >= 255)
+            return -1;
+        if (o)
+            out[o++] = '.';
+        memcpy(&out[o], &m[pos], l);
+        o += l;
+        pos += l;
+    }
+    out[o] = '\0';
+    if (!jumped)
+        *off = pos;
+    return 0;
+}
+
+static int parse(struct msg *r)
+{
+    const uint8_t *m = r->raw;
+    uint16_t off = SIZEOF_DNS_HDR, qd, ns, i;
+    char name[256];
+
+    if (r->len < SIZEOF_DNS_HDR)
+        return -1;
+    r->id = (m[0] << 8) | m[1];
+    qd = (m[4] << 8) | m[5];
+    r->an = (m[6] << 8) | m[7];
+    ns = (m[8] << 8) | m[9];
+    r->ar = (m[10] << 8) | m[11];
+    for (i = 0; i < qd; i++) {
+        if (read_name(m, r->len, &off, name) != 0)
+            return -1;
+        off += 4;
+    }
+    r->n = 0;
+    for (i = 0; i < r->an + ns + r->ar && i < MAX_RR; i++) {
+        struct rr *rr = &r->rr[r->n++];
+
+        if (read_name(m, r->len, &off, rr->name) != 0 || off + 10 > r->len)
+            return -1;
+        rr->type = (m[off] << 8) | m[off + 1];
+        rr->ttl = ((uint32_t) m[off + 4] << 24) | (m[off + 5] << 16) |
+                  (m[off + 6] << 8) | m[off + 7];
+        rr->rdlen = (m[off + 8] << 8) | m[off + 9];
+        off += 10;
+        if (off + rr->rdlen > r->len || rr->rdlen > sizeof(rr->rdata))
+            return -1;
+        memcpy(rr->rdata, &m[off], rr->rdlen);
+        off += rr->rdlen;
+    }
+    return 0;
+}
+
+/* count of the records of type in the answers (add 0) or additional (add 1) */
+static uint32_t count_rr(const struct msg *r, int add, uint16_t type)
+{
+    uint32_t i, n = 0;
+    uint32_t from = add ? r->n - r->ar : 0, to = add ? r->n : r->an;
+
+    for (i = from; i < to; i++)
+        n += r->rr[i].type == type;
+    return n;
+}
+
+static const struct rr *find_rr(const struct msg *r, uint16_t type)
+{
+    uint32_t i;
+
+    for (i = 0; i < r->n; i++) {
+        if (r->rr[i].type == type)
+            return &r->rr[i];
+    }
+    return NULL;
+}
+
+static err_t nif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *dst)
+{
+    struct ip_hdr iph;
+    struct udp_hdr udph;
+    struct msg *r;
+    uint16_t hlen;
+
+    LWIP_UNUSED_ARG(netif);
+    pbuf_copy_partial(p, &iph, sizeof(iph), 0);
+    hlen = IPH_HL_BYTES(&iph);
+    if (IPH_PROTO(&iph) != IP_PROTO_UDP)
+        return ERR_OK; /* IGMP reports */
+    pbuf_copy_partial(p, &udph, sizeof(udph), hlen);
+    if (lwip_ntohs(udph.src) != MDNS_PORT)
+        return ERR_OK;
+    if (nsent >= MAX_SENT) {
+        nsent++;
+        return ERR_OK;
+    }
+    r = &sent[nsent++];
+    if (!decode)
+        return ERR_OK;
+    r->len = pbuf_copy_partial(p, r->raw, sizeof(r->raw), hlen + UDP_HLEN);
+    ip4_addr_copy(r->dst, *dst);
+    r->dport = lwip_ntohs(udph.dest);
+    if (parse(r) != 0) {
+        printf("[ERROR]: undecodable reply\n");
+        fail = 1;
+    }
+    return ERR_OK;
+}
+
+/*******************************************************************************
+ * Queries, delivered through ip4_input()
+ ******************************************************************************/
+struct query {
+    uint8_t buf[512];
+    uint16_t len;
+    uint16_t qd, an, ns;
+};
+
+static void put16(struct query *q, uint16_t v)
+{
+    q->buf[q->len++] = v >> 8;
+    q->buf[q->len++] = v & 0xff;
+}
+
+static void put32(struct query *q, uint32_t v)
+{
+    put16(q, v >> 16);
+    put16(q, v & 0xffff);
+}
+
+static void put_name(struct query *q, const char *name)
+{
+    while (*name) {
+        const char *dot = strchr(name, '.');
+        size_t l = dot ? (size_t) (dot - name) : strlen(name);
+
+        q->buf[q->len++] = (uint8_t) l;
+        memcpy(&q->buf[q->len], name, l);
+        q->len += l;
+        name += l + (dot != NULL);
+    }
+    q->buf[q->len++] = 0;
+}
+
+static void q_begin(struct query *q, uint16_t id, uint8_t flags1)
+{
+    memset(q, 0, sizeof(*q));
+    put16(q, id);
+    q->buf[q->len++] = flags1;
+    q->buf[q->len++] = 0;
+    q->len += 8; /* counts, set by deliver() */
+}
+
+static void q_question(struct query *q, const char *name, uint16_t type, int qu)
+{
+    put_name(q, name);
+    put16(q, type);
+    put16(q, DNS_RRCLASS_IN | (qu ? 0x8000 : 0));
+    q->qd++;
+}
+
+/* a known answer, or a proposed record of a probe */
+static void q_rr(struct query *q, const char *name, uint16_t type, uint32_t ttl,
+                 const uint8_t *rdata, uint16_t rdlen)
+{
+    put_name(q, name);
+    put16(q, type);
+    put16(q, DNS_RRCLASS_IN);
+    put32(q, ttl);
+    put16(q, rdlen);
+    memcpy(&q->buf[q->len], rdata, rdlen);
+    q->len += rdlen;
+}
+
+static void q_ptr(struct query *q, const char *name, const char *target, uint32_t ttl)
+{
+    struct query t;
+
+    t.len = 0;
+    put_name(&t, target);
+    q_rr(q, name, DNS_RRTYPE_PTR, ttl, t.buf, t.len);
+    q->an++;
+}
+
+static struct netif nif;
+
+static void deliver(const char *src, uint16_t sport, const char *dst, struct query *q)
+{
+    struct pbuf *p;
+    struct ip_hdr *iph;
+    struct udp_hdr *udph;
+    ip4_addr_t a;
+    uint16_t len = IP_HLEN + UDP_HLEN + q->len;
+
+    q->buf[4] = q->qd >> 8;
+    q->buf[5] = q->qd & 0xff;
+    q->buf[6] = q->an >> 8;
+    q->buf[7] = q->an & 0xff;
+    q->buf[8] = q->ns >> 8;
+    q->buf[9] = q->ns & 0xff;
+
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    iph = (struct ip_hdr *) p->payload;
+    memset(iph, 0, IP_HLEN);
+    IPH_VHL_SET(iph, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iph, lwip_htons(len));
+    IPH_TTL_SET(iph, 255);
+    IPH_PROTO_SET(iph, IP_PROTO_UDP);
+    ip4addr_aton(src, &a);
+    ip4_addr_copy(iph->src, a);
+    ip4addr_aton(dst, &a);
+    ip4_addr_copy(iph->dest, a);
+    IPH_CHKSUM_SET(iph, inet_chksum(iph, IP_HLEN));
+    udph = (struct udp_hdr *) ((uint8_t *) iph + IP_HLEN);
+    udph->src = lwip_htons(sport);
+    udph->dest = lwip_htons(MDNS_PORT);
+    udph->len = lwip_htons(UDP_HLEN + q->len);
+    udph->chksum = 0; /* none */
+    memcpy((uint8_t *) udph + UDP_HLEN, q->buf, q->len);
+    ip4_input(p, &nif);
+}
+
+/* one question from a querier at .50, multicast or QU */
+static void ask(const char *name, uint16_t type, int qu)
+{
+    struct query q;
+
+    q_begin(&q, 0, 0);
+    q_question(&q, name, type, qu);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+}
+
+/*******************************************************************************
+ * Responder, a host with one service
+ ******************************************************************************/
+#define HOST     "m487"
+#define INSTANCE "M487 web._http._tcp.local"
+#define SERVICE  "_http._tcp.local"
+#define SERVICES "_services._dns-sd._udp.local"
+
+static uint32_t txt_calls;
+static char txt_version[8] = "v=1";
+
+static void srv_txt(struct mdns_service *service, void *txt_userdata)
+{
+    LWIP_UNUSED_ARG(txt_userdata);
+    txt_calls++;
+    mdns_resp_add_service_txtitem(service, "path=/", 6);
+    mdns_resp_add_service_txtitem(service, txt_version, (u8_t) strlen(txt_version));
+}
+
+static err_t nif_init(struct netif *netif)
+{
+    netif->name[0] = 't';
+    netif->name[1] = 'e';
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_IGMP;
+    netif->output = nif_output;
+    return ERR_OK;
+}
+
+static void probe_done(void)
+{
+    /* three probes 250 ms apart, then the announcement */
+    advance(1500);
+    nsent = 0;
+}
+
+static void setup(void)
+{
+    ip4_addr_t addr, mask, gw;
+
+    lwip_init();
+    IP4_ADDR(&addr, 192, 168, 0, 23);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    netif_add(&nif, &addr, &mask, &gw, NULL, nif_init, ip4_input);
+    netif_set_up(&nif);
+    netif_set_link_up(&nif);
+
+    mdns_resp_init();
+    check("add netif", mdns_resp_add_netif(&nif, HOST, HOST_TTL) == ERR_OK, 1, 1);
+    check("add service", mdns_resp_add_service(&nif, "M487 web", "_http", DNSSD_PROTO_TCP,
+                                               80, HOST_TTL, srv_txt, NULL) == 0, 1, 1);
+    probe_done();
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+static void test_kept_replies(void)
+{
+    static struct msg built;
+    uint32_t calls;
+
+    advance(1000);
+    ask(SERVICE, DNS_RRTYPE_PTR, 1);
+    check("ptr: replies", nsent, 1, 1);
+    built = sent[0];
+    check("ptr: unicast", ip4_addr_ismulticast(&built.dst), 0, 0);
+    check("ptr: answers", count_rr(&built, 0, DNS_RRTYPE_PTR), 1, 1);
+    check("ptr: additional srv", count_rr(&built, 1, DNS_RRTYPE_SRV), 1, 1);
+    check("ptr: additional txt", count_rr(&built, 1, DNS_RRTYPE_TXT), 1, 1);
+    check("ptr: additional a", count_rr(&built, 1, DNS_RRTYPE_A), 1, 1);
+
+    nsent = 0;
+    calls = txt_calls;
+    ask(SERVICE, DNS_RRTYPE_PTR, 1);
+    check("kept: replies", nsent, 1, 1);
+    check("kept: same bytes", sent[0].len == built.len &&
+          memcmp(sent[0].raw, built.raw, built.len) == 0, 1, 1);
+    check("kept: not built", txt_calls - calls, 0, 0);
+
+    /* legacy unicast, the question and id are echoed, built each time */
+    {
+        struct query q;
+
+        nsent = 0;
+        q_begin(&q, 0x1234, 0);
+        q_question(&q, HOST ".local", DNS_RRTYPE_A, 0);
+        deliver("192.168.0.50", 40000, "224.0.0.251", &q);
+        check("legacy: replies", nsent, 1, 1);
+        check("legacy: id", sent[0].id, 0x1234, 0x1234);
+        check("legacy: port", sent[0].dport, 40000, 40000);
+    }
+}
+
+static void test_changes(void)
+{
+    const struct rr *rr;
+    ip4_addr_t addr;
+
+    /* the address is part of what a reply is kept for */
+    nsent = 0;
+    ask(HOST ".local", DNS_RRTYPE_A, 1);
+    IP4_ADDR(&addr, 192, 168, 0, 24);
+    netif_set_ipaddr(&nif, &addr);
+    ask(HOST ".local", DNS_RRTYPE_A, 1);
+    check("address: replies", nsent, 2, 2);
+    rr = find_rr(&sent[1], DNS_RRTYPE_A);
+    check("address: new", rr != NULL && rr->rdlen == 4 && rr->rdata[3] == 24, 1, 1);
+
+    /* new TXT data with mdns_resp_announce() */
+    strcpy(txt_version, "v=2");
+    mdns_resp_announce(&nif);
+    advance(1000);
+    nsent = 0;
+    ask(INSTANCE, DNS_RRTYPE_TXT, 1);
+    check("txt: replies", nsent, 1, 1);
+    rr = find_rr(&sent[0], DNS_RRTYPE_TXT);
+    check("txt: new", rr != NULL && rr->rdlen == 11 && memcmp(&rr->rdata[8], "v=2", 3) == 0, 1, 1);
+
+    /* renaming probes the new name, the old one is not answered any more */
+    mdns_resp_rename_service(&nif, 0, "M487 lab");
+    probe_done();
+    advance(1000);
+    ask(SERVICE, DNS_RRTYPE_PTR, 1);
+    check("rename: replies", nsent, 1, 1);
+    rr = find_rr(&sent[0], DNS_RRTYPE_PTR);
+    check("rename: new instance", rr != NULL && rr->rdlen > 9 &&
+          memcmp(&rr->rdata[1], "M487 lab", 8) == 0, 1, 1);
+    nsent = 0;
+    ask("M487 web._http._tcp.local", DNS_RRTYPE_SRV, 1);
+    check("rename: old not answered", nsent, 0, 0);
+    mdns_resp_rename_service(&nif, 0, "M487 web");
+    probe_done();
+}
+
+static void test_known_answers(void)
+{
+    struct query q;
+
+    advance(1000);
+
+    /* the answer is known with more than half of its TTL left */
+    nsent = 0;
+    q_begin(&q, 0, 0);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    q_ptr(&q, SERVICE, INSTANCE, HOST_TTL);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    check("known: no reply", nsent, 0, 0);
+
+    /* less than half left, answered again */
+    q_begin(&q, 0, 0);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    q_ptr(&q, SERVICE, INSTANCE, HOST_TTL / 2 - 1);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    check("known expiring: replies", nsent, 1, 1);
+
+    /* known SRV and A are not sent as additional records */
+    nsent = 0;
+    q_begin(&q, 0, 0);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    {
+        struct query t;
+        uint8_t a[4] = {192, 168, 0, 24};
+
+        t.len = 0;
+        put16(&t, 0);
+        put16(&t, 0);
+        put16(&t, 80);
+        put_name(&t, HOST ".local");
+        q_rr(&q, INSTANCE, DNS_RRTYPE_SRV, HOST_TTL, t.buf, t.len);
+        q_rr(&q, HOST ".local", DNS_RRTYPE_A, HOST_TTL, a, 4);
+        q.an += 2;
+    }
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    check("known additional: replies", nsent, 1, 1);
+    check("known additional: ptr", count_rr(&sent[0], 0, DNS_RRTYPE_PTR), 1, 1);
+    check("known additional: srv", count_rr(&sent[0], 1, DNS_RRTYPE_SRV), 0, 0);
+    check("known additional: a", count_rr(&sent[0], 1, DNS_RRTYPE_A), 0, 0);
+    check("known additional: txt", count_rr(&sent[0], 1, DNS_RRTYPE_TXT), 1, 1);
+}
+
+static void test_truncated(void)
+{
+    struct query q;
+
+    advance(1000);
+
+    /* the known answer comes in the second packet */
+    nsent = 0;
+    q_begin(&q, 0, DNS_FLAG1_TRUNC);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    check("truncated: waits", nsent, 0, 0);
+    advance(100);
+    q_begin(&q, 0, 0);
+    q_ptr(&q, SERVICE, INSTANCE, HOST_TTL);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    advance(600);
+    check("truncated: known in the next packet", nsent, 0, 0);
+
+    /* no more known answers, answered after 400 .. 500 ms */
+    q_begin(&q, 0, DNS_FLAG1_TRUNC);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    advance(399);
+    check("truncated: not before 400 ms", nsent, 0, 0);
+    advance(101);
+    check("truncated: answered", nsent, 1, 1);
+
+    /* another querier's known answers do not count */
+    nsent = 0;
+    q_begin(&q, 0, DNS_FLAG1_TRUNC);
+    q_question(&q, SERVICE, DNS_RRTYPE_PTR, 1);
+    deliver("192.168.0.50", MDNS_PORT, "224.0.0.251", &q);
+    q_begin(&q, 0, 0);
+    q_ptr(&q, SERVICE, INSTANCE, HOST_TTL);
+    deliver("192.168.0.51", MDNS_PORT, "224.0.0.251", &q);
+    advance(500);
+    check("truncated: other querier", nsent, 1, 1);
+}
+
+static void test_rate_limit(void)
+{
+    struct query q;
+
+    advance(1000);
+
+    nsent = 0;
+    ask(SERVICE, DNS_RRTYPE_PTR, 0);
+    check("multicast: replies", nsent, 1, 1);
+    check("multicast: to the group", ip4_addr_ismulticast(&sent[0].dst), 1, 1);
+    advance(200);
+    ask(SERVICE, DNS_RRTYPE_PTR, 0);
+    check("multicast: limited", nsent, 1, 1);
+
+    /* other records and unicast replies are not limited */
+    ask(HOST ".local", DNS_RRTYPE_A, 0);
+    check("multicast: other record", nsent, 2, 2);
+    ask(SERVICE, DNS_RRTYPE_PTR, 1);
+    check("multicast: unicast reply", nsent, 3, 3);
+
+    /* nor answers to probes */
+    q_begin(&q, 0, 0);
+    q_question(&q, HOST ".local", DNS_RRTYPE_ANY, 1);
+    {
+        uint8_t a[4] = {192, 168, 0, 77};
+
+        q_rr(&q, HOST ".local", DNS_RRTYPE_A, HOST_TTL, a, 4);
+        q.ns++;
+    }
+    deliver("192.168.0.77", MDNS_PORT, "224.0.0.251", &q);
+    check("multicast: probe answered", nsent, 4, 4);
+
+    advance(800);
+    nsent = 0;
+    ask(SERVICE, DNS_RRTYPE_PTR, 0);
+    check("multicast: after a second", nsent, 1, 1);
+}
+
+/*******************************************************************************
+ * Query storm
+ ******************************************************************************/
+static void storm_ask(uint32_t kind, int qu)
+{
+    static const struct {
+        const char *name;
+        uint16_t type;
+    } kinds[BENCH_KINDS] = {
+        {SERVICE, DNS_RRTYPE_PTR},
+        {INSTANCE, DNS_RRTYPE_SRV},
+        {INSTANCE, DNS_RRTYPE_TXT},
+        {HOST ".local", DNS_RRTYPE_A},
+        {SERVICES, DNS_RRTYPE_PTR},
+        {INSTANCE, DNS_RRTYPE_ANY},
+    };
+
+    ask(kinds[kind].name, kinds[kind].type, qu);
+}
+
+static void bench(void)
+{
+    uint64_t t0, kept_ns, built_ns, storm_ns;
+    uint32_t i, calls;
+
+    decode = 0;
+    advance(1000);
+
+    /* QU queries for as many record sets as replies are kept */
+    nsent = 0;
+    calls = txt_calls;
+    t0 = host_ns();
+    for (i = 0; i < BENCH_QUERIES; i++)
+        storm_ask(i % MDNS_REPLY_CACHE_SIZE, 1);
+    kept_ns = host_ns() - t0;
+    check("bench kept: replies", nsent, BENCH_QUERIES, BENCH_QUERIES);
+    check("bench kept: built", txt_calls - calls, 0, MDNS_REPLY_CACHE_SIZE);
+
+    /* one set more, each reply is built again as before */
+    nsent = 0;
+    calls = txt_calls;
+    t0 = host_ns();
+    for (i = 0; i < BENCH_QUERIES; i++)
+        storm_ask(i % (MDNS_REPLY_CACHE_SIZE + 1), 1);
+    built_ns = host_ns() - t0;
+    check("bench built: replies", nsent, BENCH_QUERIES, BENCH_QUERIES);
+    /* two of the five sets carry the TXT record */
+    check("bench built: txt", txt_calls - calls, BENCH_QUERIES / 3, BENCH_QUERIES / 2);
+
+    /* multicast queries for the PTR 1 ms apart, answered once a second */
+    nsent = 0;
+    t0 = host_ns();
+    for (i = 0; i < BENCH_QUERIES; i++) {
+        storm_ask(0, 0);
+        now_ms++;
+    }
+    storm_ns = host_ns() - t0;
+    check("bench multicast: replies", nsent, STORM_SECONDS, STORM_SECONDS + 1);
+
+    printf("[INFO]: mdns: %llu ns/query from kept replies, %llu ns/query built, "
+           "%llu ns/query multicast at most once a second (%u replies in %u s)\n",
+           (unsigned long long) (kept_ns / BENCH_QUERIES),
+           (unsigned long long) (built_ns / BENCH_QUERIES),
+           (unsigned long long) (storm_ns / BENCH_QUERIES), nsent, STORM_SECONDS);
+    /* loose, the question is still parsed and matched for a kept reply, and
+     * the sanitizers and the host load skew both */
+    check("kept faster", kept_ns * 4 < built_ns * 3, 1, 1);
+    decode = 1;
+}
+
+int main(void)
+{
+    printf("[test]: mDNS responder\n");
+    setup();
+
+    test_kept_replies();
+    test_changes();
+    test_known_answers();
+    test_truncated();
+    test_rate_limit();
+    bench();
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,319 @@
+/**
+ * @file test_mqtt_dispatch.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - MQTT subscription registry: the topic filter examples
+ *        of MQTT 3.1.1 section 4.7, malformed filters, removal, dispatch of
+ *        the payload fragments, random topics against a reference matcher,
+ *        and the match time with thousands of subscriptions against a
+ *        strcmp-style loop over all filters.
+ *
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/apps/mqtt_dispatch.h"
+#include "test_util.h"
+
+#define BENCH_DEVS    2000
+#define BENCH_SUBS    (BENCH_DEVS * 2 + 4)
+#define BENCH_TOPICS  20000
+#define RANDOM_ROUNDS 20000
+
+/*******************************************************************************
+ * Reference matcher, one filter at a time as the applications did
+ ******************************************************************************/
+static int ref_match(const char *filter, const char *topic)
+{
+    if (topic[0] == '$' && (filter[0] == '+' || filter[0] == '#'))
+        return 0;
+    for (;;) {
+        if (filter[0] == '#')
+            return 1;
+        if (filter[0] == '+') {
+            filter++;
+            while (*topic != '\0' && *topic != '/')
+                topic++;
+        } else {
+            while (*filter != '\0' && *filter != '/' && *filter == *topic) {
+                filter++;
+                topic++;
+            }
+            if ((*filter != '\0' && *filter != '/') ||
+                (*topic != '\0' && *topic != '/'))
+                return 0;
+        }
+        if (*filter == '\0' || *topic == '\0')
+            break;
+        filter++;
+        topic++;
+    }
+    /* "a/#" matches "a" */
+    if (*filter == '/' && strcmp(filter, "/#") == 0)
+        return 1;
+    return *filter == '\0' && *topic == '\0';
+}
+
+/*******************************************************************************
+ * Handlers
+ ******************************************************************************/
+static uint32_t hits, id_sum, bytes, lasts;
+
+static void on_publish(void *arg, const char *topic, u32_t tot_len)
+{
+    LWIP_UNUSED_ARG(topic);
+    LWIP_UNUSED_ARG(tot_len);
+
+    hits++;
+    id_sum += (uint32_t) (uintptr_t) arg;
+}
+
+static void on_data(void *arg, const u8_t *data, u16_t len, u8_t flags)
+{
+    LWIP_UNUSED_ARG(arg);
+    LWIP_UNUSED_ARG(data);
+
+    bytes += len;
+    if (flags & MQTT_DATA_FLAG_LAST)
+        lasts++;
+}
+
+static uint32_t dispatch(struct mqtt_dispatch *reg, const char *topic)
+{
+    hits = 0;
+    id_sum = 0;
+    mqtt_dispatch_incoming_publish(reg, topic, 0);
+    mqtt_dispatch_incoming_data(reg, NULL, 0, MQTT_DATA_FLAG_LAST);
+    return hits;
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+static void test_spec(void)
+{
+    static const struct {
+        const char *filter, *topic;
+        int match;
+    } cases[] = {
+        {"sport/tennis/player1/#", "sport/tennis/player1", 1},
+        {"sport/tennis/player1/#", "sport/tennis/player1/ranking", 1},
+        {"sport/tennis/player1/#", "sport/tennis/player1/score/wimbledon", 1},
+        {"sport/#", "sport", 1},
+        {"#", "sport/tennis", 1},
+        {"sport/tennis/+", "sport/tennis/player1", 1},
+        {"sport/tennis/+", "sport/tennis/player1/ranking", 0},
+        {"sport/+", "sport", 0},
+        {"sport/+", "sport/", 1},
+        {"+/+", "/finance", 1},
+        {"/+", "/finance", 1},
+        {"+", "/finance", 0},
+        {"+/tennis/#", "sport/tennis/player1", 1},
+        {"#", "$SYS/broker", 0},
+        {"+/monitor/Clients", "$SYS/monitor/Clients", 0},
+        {"$SYS/#", "$SYS/monitor/Clients", 1},
+        {"$SYS/monitor/+", "$SYS/monitor/Clients", 1},
+        {"a//b", "a//b", 1},
+        {"a/b", "a/bc", 0},
+        {"a/bc", "a/b", 0},
+    };
+    struct mqtt_dispatch reg;
+    struct mqtt_dispatch_sub *sub;
+    uint32_t i;
+    char what[96];
+
+    for (i = 0; i < LWIP_ARRAYSIZE(cases); i++) {
+        mqtt_dispatch_init(&reg);
+        check("add", mqtt_dispatch_add(&reg, cases[i].filter, on_publish,
+                                       on_data, (void *) 1, &sub),
+              ERR_OK, ERR_OK);
+        snprintf(what, sizeof(what), "\"%s\" matches \"%s\"", cases[i].filter,
+                 cases[i].topic);
+        check(what, dispatch(&reg, cases[i].topic), cases[i].match,
+              cases[i].match);
+        check("reference", ref_match(cases[i].filter, cases[i].topic),
+              cases[i].match, cases[i].match);
+        mqtt_dispatch_remove(&reg, sub);
+        check("nodes left", reg.nodes, 0, 0);
+    }
+}
+
+static void test_malformed(void)
+{
+    static const char *const filters[] = {"", "a/#/b", "a#", "a/b+", "+a/b",
+                                          "#/"};
+    struct mqtt_dispatch reg;
+    uint32_t i;
+
+    mqtt_dispatch_init(&reg);
+    for (i = 0; i < LWIP_ARRAYSIZE(filters); i++) {
+        check("malformed", mqtt_dispatch_add(&reg, filters[i], on_publish,
+                                             NULL, NULL, NULL) == ERR_ARG,
+              1, 1);
+        check("no nodes left", reg.nodes, 0, 0);
+    }
+    /* after the LWIP_ERROR messages */
+    printf("\n");
+}
+
+/* Overlapping filters, each handler once, the payload fragments to all */
+static void test_overlap(void)
+{
+    static const char *const filters[] = {"a/b/c", "a/+/c", "a/#", "#",
+                                          "+/b/+", "a/b/c", "x/y"};
+    struct mqtt_dispatch_sub *subs[LWIP_ARRAYSIZE(filters)];
+    struct mqtt_dispatch reg;
+    uint32_t i;
+
+    mqtt_dispatch_init(&reg);
+    for (i = 0; i < LWIP_ARRAYSIZE(filters); i++)
+        mqtt_dispatch_add(&reg, filters[i], on_publish, on_data,
+                          (void *) (uintptr_t) (1 << i), &subs[i]);
+
+    hits = id_sum = bytes = lasts = 0;
+    mqtt_dispatch_incoming_publish(&reg, "a/b/c", 300);
+    mqtt_dispatch_incoming_data(&reg, (const u8_t *) "x", 100, 0);
+    mqtt_dispatch_incoming_data(&reg, (const u8_t *) "x", 200,
+                                MQTT_DATA_FLAG_LAST);
+    check("overlap handlers", hits, 6, 6);
+    check("overlap ids", id_sum, 0x3f, 0x3f);
+    check("overlap bytes", bytes, 6 * 300, 6 * 300);
+    check("overlap lasts", lasts, 6, 6);
+
+    /* no match: no fragment goes anywhere */
+    bytes = 0;
+    mqtt_dispatch_remove(&reg, subs[3]);
+    mqtt_dispatch_incoming_publish(&reg, "q", 10);
+    mqtt_dispatch_incoming_data(&reg, (const u8_t *) "x", 10,
+                                MQTT_DATA_FLAG_LAST);
+    check("unmatched bytes", bytes, 0, 0);
+    check("a/b/c after removal", dispatch(&reg, "a/b/c"), 5, 5);
+
+    for (i = 0; i < LWIP_ARRAYSIZE(filters); i++)
+        if (i != 3)
+            mqtt_dispatch_remove(&reg, subs[i]);
+    check("nodes after removal", reg.nodes, 0, 0);
+}
+
+/*******************************************************************************
+ * Random topics and the benchmark, against the reference
+ ******************************************************************************/
+static char filters[BENCH_SUBS][32];
+static struct mqtt_dispatch_sub *subs[BENCH_SUBS];
+static char topics[BENCH_TOPICS][32];
+
+static void bench_filters(struct mqtt_dispatch *reg)
+{
+    uint32_t i, n = 0;
+
+    for (i = 0; i < BENCH_DEVS; i++) {
+        snprintf(filters[n++], sizeof(filters[0]), "dev/%u/cmd", i);
+        snprintf(filters[n++], sizeof(filters[0]),
+                 i % 2 ? "dev/%u/cfg/+" : "site/%u/#", i);
+    }
+    snprintf(filters[n++], sizeof(filters[0]), "dev/+/cmd");
+    snprintf(filters[n++], sizeof(filters[0]), "+/+/status");
+    snprintf(filters[n++], sizeof(filters[0]), "site/+/alarm/#");
+    snprintf(filters[n++], sizeof(filters[0]), "$SYS/#");
+    for (i = 0; i < n; i++)
+        check("bench add", mqtt_dispatch_add(reg, filters[i], on_publish, NULL,
+                                             (void *) (uintptr_t) i, &subs[i]),
+              ERR_OK, ERR_OK);
+}
+
+static void random_topic(char *topic, size_t size)
+{
+    static const char *const roots[] = {"dev", "site", "x", "$SYS"};
+    static const char *const leaves[] = {"cmd", "cfg/a", "status", "alarm/1",
+                                         "cmd/x", ""};
+
+    snprintf(topic, size, "%s/%u/%s", roots[rnd() % 4],
+             rnd() % (BENCH_DEVS + 10), leaves[rnd() % 6]);
+}
+
+static void ref_dispatch(const char *topic, uint32_t *n, uint32_t *sum)
+{
+    uint32_t i;
+
+    *n = *sum = 0;
+    for (i = 0; i < BENCH_SUBS; i++) {
+        if (ref_match(filters[i], topic)) {
+            (*n)++;
+            *sum += i;
+        }
+    }
+}
+
+static void test_random(struct mqtt_dispatch *reg)
+{
+    uint32_t i, n, sum, bad = 0;
+    char topic[32];
+
+    for (i = 0; i < RANDOM_ROUNDS; i++) {
+        random_topic(topic, sizeof(topic));
+        ref_dispatch(topic, &n, &sum);
+        dispatch(reg, topic);
+        if (hits != n || id_sum != sum) {
+            if (bad++ < 5)
+                printf("[ERROR]: \"%s\": %u handlers, reference %u\n", topic,
+                       hits, n);
+            fail = 1;
+        }
+    }
+}
+
+static void bench(struct mqtt_dispatch *reg)
+{
+    uint32_t i, n, sum, total = 0, ref_total = 0;
+    uint64_t t0, trie_ns, ref_ns;
+
+    for (i = 0; i < BENCH_TOPICS; i++)
+        random_topic(topics[i], sizeof(topics[0]));
+
+    t0 = host_ns();
+    for (i = 0; i < BENCH_TOPICS; i++)
+        total += dispatch(reg, topics[i]);
+    trie_ns = host_ns() - t0;
+
+    t0 = host_ns();
+    for (i = 0; i < BENCH_TOPICS; i++) {
+        ref_dispatch(topics[i], &n, &sum);
+        ref_total += n;
+    }
+    ref_ns = host_ns() - t0;
+
+    printf("[INFO]: %u subscriptions, %u nodes, %u hash buckets: "
+           "%llu ns/publish, the filters one by one %llu ns/publish\n",
+           BENCH_SUBS, reg->nodes, MQTT_DISPATCH_HASH_SIZE,
+           (unsigned long long) (trie_ns / BENCH_TOPICS),
+           (unsigned long long) (ref_ns / BENCH_TOPICS));
+    check("bench handlers", total, ref_total, ref_total);
+    /* loose, the sanitizers and the host load skew both */
+    check("trie faster", trie_ns * 10 < ref_ns, 1, 1);
+}
+
+int main(void)
+{
+    static struct mqtt_dispatch reg;
+    uint32_t i;
+
+    printf("[test]: MQTT subscription registry\n");
+
+    test_spec();
+    test_malformed();
+    test_overlap();
+
+    mqtt_dispatch_init(&reg);
+    bench_filters(&reg);
+    test_random(&reg);
+    bench(&reg);
+    for (i = 0; i < BENCH_SUBS; i++)
+        mqtt_dispatch_remove(&reg, subs[i]);
+    check("bench nodes after removal", reg.nodes, 0, 0);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
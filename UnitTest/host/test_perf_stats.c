@@ -0,0 +1,63 @@
+/**
+ * @file test_perf_stats.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - PERF_START/PERF_STOP aggregation of the unix port
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "arch/perf.h"
+#include "test_util.h"
+
+/* Some work between PERF_START and PERF_STOP, two exits like udp_input() */
+static volatile uint32_t sink;
+static int work(uint32_t n)
+{
+    uint32_t i;
+
+    PERF_START;
+    if (n == 0) {
+        PERF_STOP("work");
+        return 0;
+    }
+    for (i = 0; i < n; i++)
+        sink += i * i;
+    PERF_STOP("work");
+    return 1;
+}
+
+int main(void)
+{
+    struct perf_hist h = {0};
+    struct perf_point *pt;
+    uint32_t i;
+
+    printf("[test]: perf_stats.\n\n");
+
+    /* Percentiles of a uniform 1 .. 1000 distribution, log2 buckets */
+    for (i = 1; i <= 1000; i++)
+        perf_hist_add(&h, i);
+    check("count", h.count, 1000, 1000);
+    check("min", h.min, 1, 1);
+    check("max", h.max, 1000, 1000);
+    check("avg", (uint32_t)(h.sum / h.count), 500, 501);
+    check("p50", perf_hist_percentile(&h, 50), 480, 520);
+    check("p90", perf_hist_percentile(&h, 90), 860, 940);
+    check("p99", perf_hist_percentile(&h, 99), 960, 1000);
+    check("p100", perf_hist_percentile(&h, 100), 1000, 1000);
+
+    /* Call sites of one name share the point */
+    perf_init(NULL);
+    for (i = 0; i < 100; i++)
+        work(i % 10 == 0 ? 0 : 10000);
+    pt = perf_point_get("work");
+    check("work count", pt ? pt->hist.count : 0, 100, 100);
+    check("points", perf_point_get("other") - pt, 1, 1);
+
+    perf_print_stats();
+    check("reset", pt ? pt->hist.count : 1, 0, 0);
+
+    printf(fail ? "FAIL\n" : "PASS\n");
+    return fail;
+}
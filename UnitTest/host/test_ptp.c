@@ -0,0 +1,327 @@
+/**
+ * @file test_ptp.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - PTP slave Delay_Req on the EMAC register model
+ *
+ * A master on the other end of the wire sends Announce and a one-step Sync,
+ * the slave answers with a Delay_Req. Its Tx time stamp is latched by
+ * ethernetif_tx_done() and passed to the ptp_tx_ts() callback by
+ * ethernetif_poll(), which must release the pbuf, whether the Tx interrupt
+ * comes later or within the send, and also when the Delay_Resp is taken
+ * first. A failing send must release it too.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "NuMicro.h"
+#include "emac_model.h"
+#include "m487_sys.h"
+
+#include "ethernetif.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/init.h"
+#include "lwip/netif.h"
+#include "lwip/prot/ethernet.h"
+#include "lwip/prot/ip.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "lwip/mem.h"
+#include "lwip/timeouts.h"
+#include "netif/ethernet.h"
+#include "ptp.h"
+#include "test_util.h"
+
+#define PTP_EVENT_PORT   319
+#define PTP_GENERAL_PORT 320
+#define WIRE_NS          5000  /* each way */
+#define PEER_QUEUE       16
+
+/* Message layout, IEEE 1588-2008 13 */
+#define MSG_SYNC        0x0
+#define MSG_DELAY_REQ   0x1
+#define MSG_DELAY_RESP  0x9
+#define MSG_ANNOUNCE    0xB
+#define OFS_LENGTH      2
+#define OFS_DOMAIN      4
+#define OFS_SRC_PORT    20
+#define OFS_SEQ         30
+#define OFS_BODY        34
+#define OFS_REQ_PORT    44
+#define OFS_GM_PRIORITY1 47
+#define OFS_GM_IDENTITY 53
+#define SYNC_LEN        44
+#define DELAY_RESP_LEN  54
+#define ANNOUNCE_LEN    64
+#define PORT_ID_LEN     10
+
+static const uint8_t peer_mac[6] = {0x02, 0x00, 0x00, 0x00, 0x00, 0x01};
+static const uint8_t master_port[PORT_ID_LEN] = {0x02, 0x00, 0x00, 0xFF, 0xFE,
+                                                 0x00, 0x00, 0x01, 0x00, 0x01};
+extern unsigned char mac_addr[6];
+
+struct netif gnetif;
+static ip4_addr_t dev_ip, peer_ip;
+
+/* Heap blocks in use, mem_malloc() and mem_free() are wrapped (Makefile) */
+static int heap_blocks;
+void *__real_mem_malloc(mem_size_t size);
+void __real_mem_free(void *mem);
+
+/* Delay_Req seen by the master */
+static struct {
+    uint32_t count;
+    int64_t t3;  /* EMAC time when the frame left */
+    uint16_t seq;
+    uint8_t port[PORT_ID_LEN];
+} delay_req;
+
+void *__wrap_mem_malloc(mem_size_t size)
+{
+    void *mem = __real_mem_malloc(size);
+
+    if (mem != NULL)
+        heap_blocks++;
+    return mem;
+}
+
+void __wrap_mem_free(void *mem)
+{
+    if (mem != NULL)
+        heap_blocks--;
+    __real_mem_free(mem);
+}
+
+void EMAC_RX_IRQHandler(void)
+{
+    ethernetif_input(&gnetif);
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    ethernetif_tx_done(&gnetif);
+}
+
+static int64_t emac_time(void)
+{
+    uint32_t sec, nsec;
+
+    EMAC_GetTime(&sec, &nsec);
+    return (int64_t) sec * PTP_NSEC_PER_SEC + nsec;
+}
+
+static void put_timestamp(uint8_t *b, int64_t ns)
+{
+    uint64_t sec = (uint64_t) (ns / PTP_NSEC_PER_SEC);
+    uint32_t nsec = (uint32_t) (ns % PTP_NSEC_PER_SEC);
+
+    b[0] = (uint8_t) (sec >> 40);
+    b[1] = (uint8_t) (sec >> 32);
+    b[2] = (uint8_t) (sec >> 24);
+    b[3] = (uint8_t) (sec >> 16);
+    b[4] = (uint8_t) (sec >> 8);
+    b[5] = (uint8_t) sec;
+    b[6] = (uint8_t) (nsec >> 24);
+    b[7] = (uint8_t) (nsec >> 16);
+    b[8] = (uint8_t) (nsec >> 8);
+    b[9] = (uint8_t) nsec;
+}
+
+/*******************************************************************************
+ * Master
+ ******************************************************************************/
+/**
+ * Record the Delay_Req of the slave, the Tx DMA runs this.
+ */
+static void peer_tx(void *arg, const uint8_t *frame, uint32_t len)
+{
+    const struct eth_hdr *eth = (const struct eth_hdr *) frame;
+    const struct ip_hdr *ip = (const struct ip_hdr *) (frame + SIZEOF_ETH_HDR);
+    const struct udp_hdr *udp = (const struct udp_hdr *) ((const uint8_t *) ip + IP_HLEN);
+    const uint8_t *msg = (const uint8_t *) udp + UDP_HLEN;
+
+    LWIP_UNUSED_ARG(arg);
+
+    if (len < SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + OFS_BODY ||
+        eth->type != PP_HTONS(ETHTYPE_IP) || IPH_PROTO(ip) != IP_PROTO_UDP ||
+        udp->dest != PP_HTONS(PTP_EVENT_PORT) ||
+        (msg[0] & 0x0F) != MSG_DELAY_REQ)
+        return;
+
+    delay_req.count++;
+    delay_req.t3 = emac_time();
+    delay_req.seq = (uint16_t) ((msg[OFS_SEQ] << 8) | msg[OFS_SEQ + 1]);
+    memcpy(delay_req.port, msg + OFS_SRC_PORT, PORT_ID_LEN);
+}
+
+static void master_send(u16_t port, const uint8_t *msg, u16_t msg_len)
+{
+    uint8_t frame[SIZEOF_ETH_HDR + IP_HLEN + UDP_HLEN + ANNOUNCE_LEN];
+    struct eth_hdr *eth = (struct eth_hdr *) frame;
+    struct ip_hdr *ip = (struct ip_hdr *) (frame + SIZEOF_ETH_HDR);
+    struct udp_hdr *udp = (struct udp_hdr *) ((uint8_t *) ip + IP_HLEN);
+    u16_t len = IP_HLEN + UDP_HLEN + msg_len;
+
+    memset(frame, 0, sizeof(frame));
+    memcpy(eth->dest.addr, mac_addr, 6);
+    memcpy(eth->src.addr, peer_mac, 6);
+    eth->type = PP_HTONS(ETHTYPE_IP);
+    IPH_VHL_SET(ip, 4, IP_HLEN / 4);
+    IPH_LEN_SET(ip, lwip_htons(len));
+    IPH_TTL_SET(ip, 64);
+    IPH_PROTO_SET(ip, IP_PROTO_UDP);
+    ip4_addr_copy(ip->src, peer_ip);
+    ip4_addr_copy(ip->dest, dev_ip);
+    IPH_CHKSUM_SET(ip, inet_chksum(ip, IP_HLEN));
+    udp->src = lwip_htons(port);
+    udp->dest = lwip_htons(port);
+    udp->len = lwip_htons(UDP_HLEN + msg_len);
+    memcpy((uint8_t *) udp + UDP_HLEN, msg, msg_len);
+
+    emac_model_rx(frame, SIZEOF_ETH_HDR + len);
+}
+
+static void master_header(uint8_t *msg, uint8_t type, u16_t len, u16_t seq)
+{
+    memset(msg, 0, len);
+    msg[0] = type;
+    msg[1] = 2;
+    msg[OFS_LENGTH] = (uint8_t) (len >> 8);
+    msg[OFS_LENGTH + 1] = (uint8_t) len;
+    msg[OFS_DOMAIN] = PTP_DOMAIN;
+    memcpy(msg + OFS_SRC_PORT, master_port, PORT_ID_LEN);
+    msg[OFS_SEQ] = (uint8_t) (seq >> 8);
+    msg[OFS_SEQ + 1] = (uint8_t) seq;
+}
+
+static void master_announce(void)
+{
+    uint8_t msg[ANNOUNCE_LEN];
+
+    master_header(msg, MSG_ANNOUNCE, ANNOUNCE_LEN, 1);
+    msg[OFS_GM_PRIORITY1] = 128;
+    memcpy(msg + OFS_GM_IDENTITY, master_port, 8);
+    master_send(PTP_GENERAL_PORT, msg, ANNOUNCE_LEN);
+}
+
+/* One-step Sync, sent WIRE_NS ago on the slave's time scale */
+static void master_sync(void)
+{
+    uint8_t msg[SYNC_LEN];
+
+    master_header(msg, MSG_SYNC, SYNC_LEN, 1);
+    put_timestamp(msg + OFS_BODY, emac_time() - WIRE_NS);
+    master_send(PTP_EVENT_PORT, msg, SYNC_LEN);
+}
+
+static void master_delay_resp(void)
+{
+    uint8_t msg[DELAY_RESP_LEN];
+
+    master_header(msg, MSG_DELAY_RESP, DELAY_RESP_LEN, delay_req.seq);
+    put_timestamp(msg + OFS_BODY, delay_req.t3 + WIRE_NS);
+    memcpy(msg + OFS_REQ_PORT, delay_req.port, PORT_ID_LEN);
+    master_send(PTP_GENERAL_PORT, msg, DELAY_RESP_LEN);
+}
+
+static void run_ms(uint32_t ms)
+{
+    while (ms--) {
+        m487_sys_advance(1000000);
+        ethernetif_poll(&gnetif);
+        sys_check_timeouts();
+    }
+}
+
+/*******************************************************************************
+ * Test
+ ******************************************************************************/
+int main(void)
+{
+    struct ptp_stats st;
+    ip4_addr_t netmask, gw;
+    int heap;
+
+    printf("[test]: PTP Delay_Req on the EMAC register model.\n\n");
+
+    emac_model_reset();
+    emac_model_set_tx_fn(peer_tx, NULL);
+
+    IP4_ADDR(&dev_ip, 192, 168, 0, 23);
+    IP4_ADDR(&peer_ip, 192, 168, 0, 1);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+
+    lwip_init();
+    netif_add(&gnetif, &dev_ip, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+    netif_set_default(&gnetif);
+    netif_set_up(&gnetif);
+
+    ptp_clock_emac_init();
+    ptp_init(&gnetif, &ptp_clock_emac);
+    run_ms(1);
+    heap = heap_blocks;
+
+    master_announce();
+    master_sync();
+
+    /* Tx interrupt after the send returned, like the hardware */
+    printf("[INFO]: Delay_Req, Tx time stamp later\n");
+    emac_model_tx_hold(1);
+    run_ms(PTP_TMR_INTERVAL);
+    ptp_get_stats(&st, 0);
+    check("tx_delay_req", st.tx_delay_req, 1, 1);
+    check("held heap > idle", heap_blocks > heap, 1, 1);
+    emac_model_tx_hold(0);
+    check("delay_req on the wire", delay_req.count, 1, 1);
+    check("held until ethernetif_poll()", heap_blocks > heap, 1, 1);
+    ethernetif_poll(&gnetif);
+    check("heap after Tx time stamp", (uint32_t) heap_blocks, heap, heap);
+
+    master_delay_resp();
+    ptp_get_stats(&st, 0);
+    check("rx_delay_resp", st.rx_delay_resp, 1, 1);
+    check("sw_timestamps", st.sw_timestamps, 0, 0);
+    check("path_delay", (uint32_t) st.path_delay, WIRE_NS - 100, WIRE_NS + 100);
+
+    /* Tx interrupt within udp_sendto(), passed on by the next poll */
+    printf("[INFO]: Delay_Req, Tx time stamp within the send\n");
+    run_ms(1000);
+    ptp_get_stats(&st, 0);
+    check("tx_delay_req", st.tx_delay_req, 2, 2);
+    check("delay_req on the wire", delay_req.count, 2, 2);
+    check("heap after Tx time stamp", (uint32_t) heap_blocks, heap, heap);
+    master_delay_resp();
+    ptp_get_stats(&st, 0);
+    check("rx_delay_resp", st.rx_delay_resp, 2, 2);
+    check("sw_timestamps", st.sw_timestamps, 0, 0);
+
+    /* Delay_Resp taken before ethernetif_poll() passed the stamp on */
+    printf("[INFO]: Delay_Req, Delay_Resp before the Tx time stamp\n");
+    emac_model_tx_hold(1);
+    run_ms(1000);
+    emac_model_tx_hold(0);
+    master_delay_resp();
+    ptp_get_stats(&st, 0);
+    check("tx_delay_req", st.tx_delay_req, 3, 3);
+    check("rx_delay_resp", st.rx_delay_resp, 3, 3);
+    check("sw_timestamps", st.sw_timestamps, 1, 1);
+    ethernetif_poll(&gnetif);
+    check("heap after Tx time stamp", (uint32_t) heap_blocks, heap, heap);
+
+    /* No route with the netif down, the send fails */
+    printf("[INFO]: Delay_Req, send fails\n");
+    netif_set_down(&gnetif);
+    run_ms(1000);
+    ptp_get_stats(&st, 0);
+    check("tx_delay_req", st.tx_delay_req, 3, 3);
+    check("delay_req on the wire", delay_req.count, 3, 3);
+    check("heap after failed send", (uint32_t) heap_blocks, heap, heap);
+
+    printf("[INFO]: path delay %ld ns, %d heap blocks idle\n",
+           (long) st.path_delay, heap);
+    printf(fail ? "FAIL\n" : "PASS\n");
+    return fail;
+}
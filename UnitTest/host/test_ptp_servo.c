@@ -0,0 +1,117 @@
+/**
+ * @file test_ptp_servo.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - PTP servo against a simulated drifting clock
+ *
+ * The master is the reference time. The slave clock runs 50 ppm fast and
+ * starts 1.2 s ahead, the path delay is 5 us and every time stamp carries
+ * up to +-100 ns of noise. Sync/Delay_Req exchanges are computed the same way
+ * as in ptp.c and fed to ptp_servo.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include "ptp_servo.h"
+#include "ptp_clock_sim.h"
+#include "test_util.h"
+
+#define SIM_DRIFT_PPB    50000
+#define SIM_START_OFFSET 1200000000LL
+#define SIM_PATH_DELAY   5000
+#define SIM_NOISE_NS     100
+#define SIM_SYNC_MS      1000
+#define SIM_SYNCS        120
+
+/* Accepted after SIM_SYNCS exchanges */
+#define PASS_OFFSET_NS   500
+#define PASS_JITTER_NS   200
+#define PASS_FREQ_ERR    200 /* kp reacts to the time stamp noise */
+
+static int64_t noise(void)
+{
+    return (int64_t)(rnd() % (2 * SIM_NOISE_NS + 1)) - SIM_NOISE_NS;
+}
+
+int main(void)
+{
+    struct ptp_clock_sim slave;
+    struct ptp_servo servo;
+    struct ptp_servo_stats stats;
+    enum ptp_servo_state state = PTP_SERVO_UNLOCKED;
+    int64_t master = 0;
+    int64_t t1, t2, t3, t4, delay, offset, true_offset = 0;
+    int i;
+
+    printf("[test]: PTP servo, slave %+d ppb, start offset %lld ns.\n\n",
+           SIM_DRIFT_PPB, (long long) SIM_START_OFFSET);
+
+    ptp_clock_sim_init(&slave, SIM_START_OFFSET, SIM_DRIFT_PPB);
+    ptp_servo_init(&servo, &slave.clock, SIM_SYNC_MS);
+
+    for (i = 0; i < SIM_SYNCS; i++) {
+        /* Sync: t1 on master, t2 on slave after the path delay */
+        t1 = master + noise();
+        master += SIM_PATH_DELAY;
+        ptp_clock_sim_advance(&slave, SIM_PATH_DELAY);
+        t2 = slave.now + noise();
+
+        /* Delay_Req 1 ms later: t3 on slave, t4 on master */
+        master += 1000000;
+        ptp_clock_sim_advance(&slave, 1000000);
+        t3 = slave.now + noise();
+        master += SIM_PATH_DELAY;
+        ptp_clock_sim_advance(&slave, SIM_PATH_DELAY);
+        t4 = master + noise();
+
+        delay = ((t2 - t1) + (t4 - t3)) / 2;
+        offset = (t2 - t1) - delay;
+        state = ptp_servo_sample(&servo, offset, delay, t2);
+
+        /* Rest of the sync interval */
+        master += SIM_SYNC_MS * 1000000LL - 1000000 - 2 * SIM_PATH_DELAY;
+        ptp_clock_sim_advance(
+            &slave, SIM_SYNC_MS * 1000000LL - 1000000 - 2 * SIM_PATH_DELAY);
+        true_offset = slave.now - master;
+
+        if (i % 10 == 9) {
+            ptp_servo_get_stats(&servo, &stats, 1);
+            printf("[INFO]: %3ds state %d offset %lld/%lld/%lld ns "
+                   "jitter %lld ns delay %lld ns freq %d ppb\n",
+                   i + 1, state, (long long) stats.offset_min,
+                   (long long) stats.offset_mean,
+                   (long long) stats.offset_max,
+                   (long long) stats.offset_jitter,
+                   (long long) stats.delay_mean, (int) stats.freq_ppb);
+        }
+    }
+
+    ptp_servo_get_stats(&servo, &stats, 0);
+    printf("\ntrue offset %lld ns, freq %d ppb, steps %u\n",
+           (long long) true_offset, (int) stats.freq_ppb,
+           (unsigned) stats.steps);
+
+    if (state != PTP_SERVO_LOCKED) {
+        printf("[ERROR]: servo not locked\n");
+        fail = 1;
+    }
+    if (llabs(true_offset) > PASS_OFFSET_NS) {
+        printf("[ERROR]: offset %lld ns\n", (long long) true_offset);
+        fail = 1;
+    }
+    if (stats.offset_jitter > PASS_JITTER_NS) {
+        printf("[ERROR]: jitter %lld ns\n", (long long) stats.offset_jitter);
+        fail = 1;
+    }
+    if (abs(stats.freq_ppb + SIM_DRIFT_PPB) > PASS_FREQ_ERR) {
+        printf("[ERROR]: frequency %d ppb\n", (int) stats.freq_ppb);
+        fail = 1;
+    }
+    if (stats.steps != 1) {
+        printf("[ERROR]: %u clock steps\n", (unsigned) stats.steps);
+        fail = 1;
+    }
+
+    printf(fail ? "FAIL\n" : "PASS\n");
+    return fail;
+}
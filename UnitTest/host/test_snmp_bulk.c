@@ -0,0 +1,604 @@
+/**
+ * @file test_snmp_bulk.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - SNMP agent GetBulk walks: the sorted row index against
+ *        the next-OID check over all rows and its reuse by the next request
+ *        while the rows are unchanged, walks of a large table with four
+ *        columns through snmp_receive() decoded and compared to the sorted
+ *        rows, GET of single cells, and the walk time per varbind of an
+ *        indexed table against the same table scanned row by row.
+ *
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/apps/snmp.h"
+#include "lwip/apps/snmp_core.h"
+#include "lwip/apps/snmp_table.h"
+#include "lwip/pbuf.h"
+#include "snmp_msg.h"
+#include "snmp_asn1.h"
+#include "test_util.h"
+
+#define TABLE_ROWS    1024
+#define ROW_OID_LEN   10
+#define COLUMNS       4
+#define MAX_REPS      8
+#define RANDOM_ROUNDS 20000
+
+#define BASE_OID_LEN  7
+#define TABLE_INDEXED 1
+#define TABLE_SCANNED 2
+
+static int oid_cmp(const u32_t *a, u8_t a_len, const u32_t *b, u8_t b_len)
+{
+    return snmp_oid_compare(a, a_len, b, b_len);
+}
+
+/*******************************************************************************
+ * Table, rows like tcpConnTable: local address and port, remote address and
+ * port. Columns 1..3 Gauge32, column 4 Integer32.
+ ******************************************************************************/
+struct row {
+    u32_t oid[ROW_OID_LEN];
+    u32_t val[COLUMNS];
+};
+
+static struct row rows[TABLE_ROWS];
+static struct row *sorted[TABLE_ROWS];
+static uint32_t scans;
+
+static struct snmp_row_index_entry table_index_rows[TABLE_ROWS];
+static struct snmp_row_index table_index = SNMP_ROW_INDEX_CREATE(table_index_rows);
+
+static void rows_init(void)
+{
+    uint32_t i, j;
+
+    for (i = 0; i < TABLE_ROWS; i++) {
+        /* 192.168.1.x:port, 10.0.y.z:port, unique by the local port */
+        rows[i].oid[0] = 192;
+        rows[i].oid[1] = 168;
+        rows[i].oid[2] = 1;
+        rows[i].oid[3] = 10 + rnd() % 4;
+        rows[i].oid[4] = 1024 + i * 7 % TABLE_ROWS * 3 + rnd() % 3;
+        rows[i].oid[5] = 10;
+        rows[i].oid[6] = 0;
+        rows[i].oid[7] = rnd() % 256;
+        rows[i].oid[8] = rnd() % 256;
+        rows[i].oid[9] = rnd() % 65536;
+        for (j = 0; j < COLUMNS; j++)
+            rows[i].val[j] = rnd() << (j * 4);
+        sorted[i] = &rows[i];
+    }
+}
+
+static int row_sort_cmp(const void *a, const void *b)
+{
+    const struct row *ra = *(const struct row *const *) a;
+    const struct row *rb = *(const struct row *const *) b;
+
+    return oid_cmp(ra->oid, ROW_OID_LEN, rb->oid, ROW_OID_LEN);
+}
+
+static void cell_value(const struct row *r, u32_t column, union snmp_variant_value *value)
+{
+    if (column == COLUMNS)
+        value->s32 = (s32_t) r->val[column - 1];
+    else
+        value->u32 = r->val[column - 1];
+}
+
+static snmp_err_t table_get_cell_value(const u32_t *column, const u32_t *row_oid, u8_t row_oid_len,
+                                       union snmp_variant_value *value, u32_t *value_len)
+{
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(value_len);
+    for (i = 0; i < TABLE_ROWS; i++) {
+        if (oid_cmp(rows[i].oid, ROW_OID_LEN, row_oid, row_oid_len) == 0) {
+            cell_value(&rows[i], *column, value);
+            return SNMP_ERR_NOERROR;
+        }
+    }
+    return SNMP_ERR_NOSUCHINSTANCE;
+}
+
+/* as the lwIP MIB2 tables: the index is built once per request */
+static snmp_err_t table_indexed_get_next(const u32_t *column, struct snmp_obj_id *row_oid,
+                                         union snmp_variant_value *value, u32_t *value_len)
+{
+    const struct snmp_row_index_entry *row;
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(value_len);
+    if (!snmp_row_index_current(&table_index)) {
+        snmp_row_index_begin(&table_index);
+        for (i = 0; i < TABLE_ROWS; i++)
+            snmp_row_index_add(&table_index, rows[i].oid, ROW_OID_LEN, &rows[i]);
+        snmp_row_index_end(&table_index);
+    }
+    row = snmp_row_index_next(&table_index, row_oid->id, row_oid->len);
+    if (row == NULL)
+        return SNMP_ERR_NOSUCHINSTANCE;
+    snmp_oid_assign(row_oid, row->oid, row->oid_len);
+    cell_value((const struct row *) row->reference, *column, value);
+    return SNMP_ERR_NOERROR;
+}
+
+/* as before the index: every get-next checks all rows */
+static snmp_err_t table_scanned_get_next(const u32_t *column, struct snmp_obj_id *row_oid,
+                                         union snmp_variant_value *value, u32_t *value_len)
+{
+    struct snmp_next_oid_state state;
+    u32_t result_temp[ROW_OID_LEN];
+    uint32_t i;
+
+    LWIP_UNUSED_ARG(value_len);
+    snmp_next_oid_init(&state, row_oid->id, row_oid->len, result_temp, ROW_OID_LEN);
+    for (i = 0; i < TABLE_ROWS; i++)
+        snmp_next_oid_check(&state, rows[i].oid, ROW_OID_LEN, &rows[i]);
+    scans++;
+    if (state.status != SNMP_NEXT_OID_STATUS_SUCCESS)
+        return SNMP_ERR_NOSUCHINSTANCE;
+    snmp_oid_assign(row_oid, state.next_oid, state.next_oid_len);
+    cell_value((const struct row *) state.reference, *column, value);
+    return SNMP_ERR_NOERROR;
+}
+
+static const struct snmp_table_simple_col_def table_columns[] = {
+    { 1, SNMP_ASN1_TYPE_GAUGE, SNMP_VARIANT_VALUE_TYPE_U32 },
+    { 2, SNMP_ASN1_TYPE_GAUGE, SNMP_VARIANT_VALUE_TYPE_U32 },
+    { 3, SNMP_ASN1_TYPE_GAUGE, SNMP_VARIANT_VALUE_TYPE_U32 },
+    { 4, SNMP_ASN1_TYPE_INTEGER, SNMP_VARIANT_VALUE_TYPE_S32 },
+};
+
+static const struct snmp_table_simple_node table_indexed = SNMP_TABLE_CREATE_SIMPLE(
+    TABLE_INDEXED, table_columns, table_get_cell_value, table_indexed_get_next);
+static const struct snmp_table_simple_node table_scanned = SNMP_TABLE_CREATE_SIMPLE(
+    TABLE_SCANNED, table_columns, table_get_cell_value, table_scanned_get_next);
+
+static const struct snmp_node *const test_nodes[] = {
+    &table_indexed.node.node,
+    &table_scanned.node.node,
+};
+static const struct snmp_tree_node test_root = SNMP_CREATE_TREE_NODE(0, test_nodes);
+
+static const u32_t test_base_oid[BASE_OID_LEN] = { 1, 3, 6, 1, 4, 1, 26381 };
+static const struct snmp_mib test_mib = SNMP_MIB_CREATE(test_base_oid, &test_root.node);
+
+/*******************************************************************************
+ * Agent transport: requests in, the response captured
+ ******************************************************************************/
+static u8_t resp[1500];
+static u16_t resp_len;
+
+err_t snmp_sendto(void *handle, struct pbuf *p, const ip_addr_t *dst, u16_t port)
+{
+    LWIP_UNUSED_ARG(handle);
+    LWIP_UNUSED_ARG(dst);
+    LWIP_UNUSED_ARG(port);
+    resp_len = pbuf_copy_partial(p, resp, sizeof(resp), 0);
+    return ERR_OK;
+}
+
+u8_t snmp_get_local_ip_for_dst(void *handle, const ip_addr_t *dst, ip_addr_t *result)
+{
+    LWIP_UNUSED_ARG(handle);
+    LWIP_UNUSED_ARG(dst);
+    ip_addr_set_zero(result);
+    return 1;
+}
+
+/* BER, lengths always in the long two byte form which the agent accepts */
+struct ber {
+    u8_t buf[1500];
+    u16_t len;
+};
+
+static u16_t ber_open(struct ber *b, u8_t type)
+{
+    b->buf[b->len++] = type;
+    b->buf[b->len++] = 0x82;
+    b->len += 2;
+    return b->len;
+}
+
+static void ber_close(struct ber *b, u16_t start)
+{
+    u16_t n = b->len - start;
+
+    b->buf[start - 2] = (u8_t) (n >> 8);
+    b->buf[start - 1] = (u8_t) n;
+}
+
+static void ber_int(struct ber *b, u32_t v)
+{
+    b->buf[b->len++] = SNMP_ASN1_TYPE_INTEGER;
+    b->buf[b->len++] = 4;
+    b->buf[b->len++] = (u8_t) (v >> 24);
+    b->buf[b->len++] = (u8_t) (v >> 16);
+    b->buf[b->len++] = (u8_t) (v >> 8);
+    b->buf[b->len++] = (u8_t) v;
+}
+
+static void ber_oid(struct ber *b, const u32_t *oid, u8_t oid_len)
+{
+    u16_t start = ber_open(b, SNMP_ASN1_TYPE_OBJECT_ID);
+    u8_t i;
+    int shift;
+
+    b->buf[b->len++] = (u8_t) (oid[0] * 40 + oid[1]);
+    for (i = 2; i < oid_len; i++) {
+        for (shift = 28; shift > 0; shift -= 7)
+            if (oid[i] >> shift)
+                b->buf[b->len++] = (u8_t) (0x80 | (oid[i] >> shift));
+        b->buf[b->len++] = (u8_t) (oid[i] & 0x7f);
+    }
+    ber_close(b, start);
+}
+
+static u32_t request_id;
+
+/* v2c request with NULL values; GetBulk when max_reps != 0 */
+static void agent_request(u8_t pdu, u32_t max_reps, struct snmp_obj_id *oids, u8_t num)
+{
+    struct ber b;
+    struct pbuf *p;
+    u16_t msg, pdu_seq, vbl, vb;
+    u8_t i;
+
+    b.len = 0;
+    msg = ber_open(&b, SNMP_ASN1_TYPE_SEQUENCE);
+    ber_int(&b, SNMP_VERSION_2c);
+    b.buf[b.len++] = SNMP_ASN1_TYPE_OCTET_STRING;
+    b.buf[b.len++] = 6;
+    memcpy(&b.buf[b.len], "public", 6);
+    b.len += 6;
+    pdu_seq = ber_open(&b, SNMP_ASN1_CLASS_CONTEXT | SNMP_ASN1_CONTENTTYPE_CONSTRUCTED | pdu);
+    ber_int(&b, ++request_id);
+    ber_int(&b, 0);
+    ber_int(&b, max_reps);
+    vbl = ber_open(&b, SNMP_ASN1_TYPE_SEQUENCE);
+    for (i = 0; i < num; i++) {
+        vb = ber_open(&b, SNMP_ASN1_TYPE_SEQUENCE);
+        ber_oid(&b, oids[i].id, oids[i].len);
+        b.buf[b.len++] = SNMP_ASN1_TYPE_NULL;
+        b.buf[b.len++] = 0;
+        ber_close(&b, vb);
+    }
+    ber_close(&b, vbl);
+    ber_close(&b, pdu_seq);
+    ber_close(&b, msg);
+
+    p = pbuf_alloc(PBUF_TRANSPORT, b.len, PBUF_RAM);
+    pbuf_take(p, b.buf, b.len);
+    resp_len = 0;
+    snmp_receive(NULL, p, IP_ADDR_ANY, 161);
+    pbuf_free(p);
+}
+
+/* response decoder, returns the content of the next TLV */
+static const u8_t *ber_next(const u8_t **pos, const u8_t *end, u8_t *type, u16_t *len)
+{
+    const u8_t *p = *pos;
+    u16_t n;
+
+    if (end - p < 2)
+        return NULL;
+    *type = *p++;
+    n = *p++;
+    if (n & 0x80) {
+        u8_t k = n & 0x7f;
+
+        if (k > 2 || end - p < k)
+            return NULL;
+        for (n = 0; k > 0; k--)
+            n = (u16_t) (n << 8 | *p++);
+    }
+    if (end - p < n)
+        return NULL;
+    *len = n;
+    *pos = p + n;
+    return p;
+}
+
+static u32_t ber_uint(const u8_t *p, u16_t len, int is_signed)
+{
+    u32_t v = (is_signed && len > 0 && (p[0] & 0x80)) ? 0xffffffffu : 0;
+
+    while (len-- > 0)
+        v = v << 8 | *p++;
+    return v;
+}
+
+struct varbind {
+    struct snmp_obj_id oid;
+    u8_t type;
+    u32_t value;
+};
+
+/* varbinds of the captured response, -1 if malformed or an error status */
+static int agent_response(struct varbind *vbs, int max)
+{
+    const u8_t *pos = resp, *end = resp + resp_len, *c, *pdu_end, *vbl_end;
+    u8_t type;
+    u16_t len;
+    int n = 0;
+
+    if ((c = ber_next(&pos, end, &type, &len)) == NULL || type != SNMP_ASN1_TYPE_SEQUENCE)
+        return -1;
+    pos = c;
+    end = c + len;
+    if (ber_next(&pos, end, &type, &len) == NULL || type != SNMP_ASN1_TYPE_INTEGER)
+        return -1;
+    if (ber_next(&pos, end, &type, &len) == NULL || type != SNMP_ASN1_TYPE_OCTET_STRING)
+        return -1;
+    if ((c = ber_next(&pos, end, &type, &len)) == NULL)
+        return -1;
+    pos = c;
+    pdu_end = c + len;
+    if ((c = ber_next(&pos, pdu_end, &type, &len)) == NULL || ber_uint(c, len, 0) != request_id)
+        return -1;
+    if ((c = ber_next(&pos, pdu_end, &type, &len)) == NULL || ber_uint(c, len, 0) != 0)
+        return -1;
+    if (ber_next(&pos, pdu_end, &type, &len) == NULL)
+        return -1;
+    if ((c = ber_next(&pos, pdu_end, &type, &len)) == NULL || type != SNMP_ASN1_TYPE_SEQUENCE)
+        return -1;
+    pos = c;
+    vbl_end = c + len;
+    while (pos < vbl_end) {
+        const u8_t *vb_pos, *vb_end, *o;
+        u16_t i;
+
+        if (n == max || (c = ber_next(&pos, vbl_end, &type, &len)) == NULL)
+            return -1;
+        vb_pos = c;
+        vb_end = c + len;
+        if ((o = ber_next(&vb_pos, vb_end, &type, &len)) == NULL || type != SNMP_ASN1_TYPE_OBJECT_ID ||
+            len == 0)
+            return -1;
+        vbs[n].oid.id[0] = o[0] / 40;
+        vbs[n].oid.id[1] = o[0] % 40;
+        vbs[n].oid.len = 2;
+        for (i = 1; i < len; i++) {
+            u32_t sub = 0;
+
+            while (i < len && (o[i] & 0x80))
+                sub = sub << 7 | (o[i++] & 0x7f);
+            if (i == len || vbs[n].oid.len == SNMP_MAX_OBJ_ID_LEN)
+                return -1;
+            vbs[n].oid.id[vbs[n].oid.len++] = sub << 7 | o[i];
+        }
+        if ((c = ber_next(&vb_pos, vb_end, &vbs[n].type, &len)) == NULL || len > 5)
+            return -1;
+        vbs[n].value = ber_uint(c, len, vbs[n].type == SNMP_ASN1_TYPE_INTEGER);
+        n++;
+    }
+    return n;
+}
+
+/*******************************************************************************
+ * Tests
+ ******************************************************************************/
+static void test_index(void)
+{
+    static struct snmp_row_index_entry small_rows[4];
+    struct snmp_row_index small = SNMP_ROW_INDEX_CREATE(small_rows);
+    static const u32_t a[] = { 5 }, b[] = { 5, 1 }, c[] = { 5, 2 }, d[] = { 7 };
+    static const u32_t q0[] = { 0 }, q5[] = { 5 }, q51[] = { 5, 1 }, q6[] = { 6 };
+    u32_t long_oid[SNMP_ROW_INDEX_OID_LEN + 1] = { 0 };
+
+    snmp_row_index_begin(&small);
+    check("empty index next", snmp_row_index_next(&small, q0, 1) == NULL, 1, 1);
+    check("current after begin", snmp_row_index_current(&small), 1, 1);
+
+    /* any order in, shorter OIDs first */
+    snmp_row_index_add(&small, d, 1, (void *) d);
+    snmp_row_index_add(&small, b, 2, (void *) b);
+    snmp_row_index_add(&small, c, 2, (void *) c);
+    snmp_row_index_add(&small, a, 1, (void *) a);
+    snmp_row_index_end(&small);
+    check("no overflow", small.overflow, 0, 0);
+    check("next of 0", snmp_row_index_next(&small, q0, 1)->reference == a, 1, 1);
+    check("next of 5", snmp_row_index_next(&small, q5, 1)->reference == b, 1, 1);
+    check("next of 5.1", snmp_row_index_next(&small, q51, 2)->reference == c, 1, 1);
+    check("next of 6", snmp_row_index_next(&small, q6, 1)->reference == d, 1, 1);
+    check("next of the last", snmp_row_index_next(&small, d, 1) == NULL, 1, 1);
+
+    /* the next request: the same rows keep the order, a changed one sorts again */
+    snmp_row_index_begin(&small);
+    snmp_row_index_add(&small, d, 1, (void *) d);
+    snmp_row_index_add(&small, b, 2, (void *) b);
+    snmp_row_index_add(&small, c, 2, (void *) c);
+    snmp_row_index_add(&small, a, 1, (void *) a);
+    snmp_row_index_end(&small);
+    check("unchanged rows", small.changed, 0, 0);
+    check("unchanged next of 5", snmp_row_index_next(&small, q5, 1)->reference == b, 1, 1);
+    snmp_row_index_begin(&small);
+    snmp_row_index_add(&small, d, 1, (void *) d);
+    snmp_row_index_add(&small, q0, 1, (void *) q0);
+    snmp_row_index_add(&small, c, 2, (void *) c);
+    snmp_row_index_end(&small);
+    check("changed rows", small.changed, 1, 1);
+    check("changed first row", snmp_row_index_next(&small, q0, 0)->reference == q0, 1, 1);
+    check("changed next of 0", snmp_row_index_next(&small, q0, 1)->reference == c, 1, 1);
+    check("changed next of 5.2", snmp_row_index_next(&small, c, 2)->reference == d, 1, 1);
+
+    /* a fifth row and a too long OID overflow, the table is scanned then */
+    snmp_row_index_begin(&small);
+    snmp_row_index_add(&small, a, 1, NULL);
+    snmp_row_index_add(&small, b, 2, NULL);
+    snmp_row_index_add(&small, c, 2, NULL);
+    snmp_row_index_add(&small, d, 1, NULL);
+    snmp_row_index_add(&small, a, 1, NULL);
+    check("overflow on rows", small.overflow, 1, 1);
+    snmp_row_index_begin(&small);
+    snmp_row_index_add(&small, long_oid, SNMP_ROW_INDEX_OID_LEN + 1, NULL);
+    check("overflow on OID length", small.overflow, 1, 1);
+
+    snmp_row_index_expire();
+    check("stale after expire", snmp_row_index_current(&small), 0, 0);
+}
+
+/* the index answers as the next-OID check over all rows, including start
+   OIDs shorter, longer and in between the rows */
+static void test_random(void)
+{
+    uint32_t i, mismatches = 0;
+
+    snmp_row_index_begin(&table_index);
+    for (i = 0; i < TABLE_ROWS; i++)
+        snmp_row_index_add(&table_index, rows[i].oid, ROW_OID_LEN, &rows[i]);
+    snmp_row_index_end(&table_index);
+    check("table index overflow", table_index.overflow, 0, 0);
+
+    for (i = 0; i < RANDOM_ROUNDS; i++) {
+        const struct snmp_row_index_entry *row;
+        struct snmp_next_oid_state state;
+        u32_t result_temp[ROW_OID_LEN];
+        u32_t start[ROW_OID_LEN];
+        u8_t start_len = (u8_t) (rnd() % (ROW_OID_LEN + 1));
+        uint32_t j;
+
+        memcpy(start, rows[rnd() % TABLE_ROWS].oid, sizeof(start));
+        if (start_len > 0 && (rnd() & 1))
+            start[start_len - 1] += rnd() % 3 - 1;
+
+        snmp_next_oid_init(&state, start, start_len, result_temp, ROW_OID_LEN);
+        for (j = 0; j < TABLE_ROWS; j++)
+            snmp_next_oid_check(&state, rows[j].oid, ROW_OID_LEN, &rows[j]);
+        row = snmp_row_index_next(&table_index, start, start_len);
+        if (state.status == SNMP_NEXT_OID_STATUS_SUCCESS ? row == NULL || row->reference != state.reference
+                                                         : row != NULL)
+            mismatches++;
+    }
+    check("index against next-OID check mismatches", mismatches, 0, 0);
+}
+
+static void test_get(void)
+{
+    struct snmp_obj_id oids[COLUMNS];
+    struct varbind vbs[COLUMNS];
+    const struct row *r = &rows[rnd() % TABLE_ROWS];
+    uint32_t col;
+
+    for (col = 1; col <= COLUMNS; col++) {
+        const u32_t prefix[] = { TABLE_INDEXED, 1, col };
+
+        snmp_oid_combine(&oids[col - 1], test_base_oid, BASE_OID_LEN, prefix, 3);
+        snmp_oid_append(&oids[col - 1], r->oid, ROW_OID_LEN);
+    }
+    agent_request(SNMP_ASN1_CONTEXT_PDU_GET_REQ, 0, oids, COLUMNS);
+    check("get varbinds", agent_response(vbs, COLUMNS), COLUMNS, COLUMNS);
+    for (col = 1; col <= COLUMNS; col++) {
+        check("get oid", oid_cmp(vbs[col - 1].oid.id, vbs[col - 1].oid.len, oids[col - 1].id,
+                                 oids[col - 1].len) == 0, 1, 1);
+        check("get value", vbs[col - 1].value, r->val[col - 1], r->val[col - 1]);
+    }
+}
+
+/* GetBulk walk of the four columns as an NMS polls them; every row is checked
+   against the sorted rows, returns the varbinds of the table */
+static uint32_t walk(u32_t table, uint32_t *requests)
+{
+    static struct varbind vbs[COLUMNS * MAX_REPS];
+    struct snmp_obj_id oids[COLUMNS];
+    uint32_t next_row[COLUMNS] = { 0 };
+    uint32_t done = 0, varbinds = 0, col;
+
+    for (col = 1; col <= COLUMNS; col++) {
+        const u32_t prefix[] = { table, 1, col };
+
+        snmp_oid_combine(&oids[col - 1], test_base_oid, BASE_OID_LEN, prefix, 3);
+    }
+    *requests = 0;
+    while (done != (1u << COLUMNS) - 1) {
+        int n, i;
+
+        agent_request(SNMP_ASN1_CONTEXT_PDU_GET_BULK_REQ, MAX_REPS, oids, COLUMNS);
+        (*requests)++;
+        n = agent_response(vbs, COLUMNS * MAX_REPS);
+        if (n < COLUMNS || n % COLUMNS != 0) {
+            check("bulk response varbinds", (uint32_t) n, COLUMNS, COLUMNS * MAX_REPS);
+            return varbinds;
+        }
+        for (i = 0; i < n; i++) {
+            const struct varbind *vb = &vbs[i];
+            const struct row *r;
+
+            col = (uint32_t) i % COLUMNS + 1;
+            if (done & (1u << (col - 1)))
+                continue;
+            if (vb->type == (SNMP_ASN1_CLASS_CONTEXT | SNMP_ASN1_CONTEXT_VARBIND_END_OF_MIB_VIEW) ||
+                vb->oid.len != BASE_OID_LEN + 3 + ROW_OID_LEN || vb->oid.id[BASE_OID_LEN] != table ||
+                vb->oid.id[BASE_OID_LEN + 2] != col) {
+                /* left the column, or the last table at the end of the MIB view */
+                check("rows walked", next_row[col - 1], TABLE_ROWS, TABLE_ROWS);
+                done |= 1u << (col - 1);
+                continue;
+            }
+            if (next_row[col - 1] >= TABLE_ROWS) {
+                check("walk past the rows", next_row[col - 1], 0, TABLE_ROWS - 1);
+                return varbinds;
+            }
+            r = sorted[next_row[col - 1]++];
+            if (oid_cmp(&vb->oid.id[BASE_OID_LEN + 3], ROW_OID_LEN, r->oid, ROW_OID_LEN) != 0 ||
+                vb->value != r->val[col - 1] ||
+                vb->type != (col == COLUMNS ? SNMP_ASN1_TYPE_INTEGER : SNMP_ASN1_TYPE_GAUGE)) {
+                check("walk row", next_row[col - 1] - 1, TABLE_ROWS, 0);
+                return varbinds;
+            }
+            varbinds++;
+            oids[col - 1] = vb->oid;
+        }
+    }
+    return varbinds;
+}
+
+static void bench(void)
+{
+    uint32_t requests, varbinds;
+    uint64_t t0, t_indexed, t_scanned;
+
+    t0 = host_ns();
+    varbinds = walk(TABLE_INDEXED, &requests);
+    t_indexed = host_ns() - t0;
+    check("indexed walk varbinds", varbinds, TABLE_ROWS * COLUMNS, TABLE_ROWS * COLUMNS);
+
+    scans = 0;
+    t0 = host_ns();
+    varbinds = walk(TABLE_SCANNED, &requests);
+    t_scanned = host_ns() - t0;
+    check("scanned walk varbinds", varbinds, TABLE_ROWS * COLUMNS, TABLE_ROWS * COLUMNS);
+    check("scans, one per get-next", scans, TABLE_ROWS * COLUMNS, UINT32_MAX);
+
+    printf("[INFO]: %u rows x %u columns in %u GetBulk requests: "
+           "%.0f ns/varbind indexed, %.0f ns/varbind scanned\n",
+           TABLE_ROWS, COLUMNS, requests,
+           (double) t_indexed / varbinds, (double) t_scanned / varbinds);
+}
+
+int main(void)
+{
+    const struct snmp_mib *mibs[] = { &test_mib };
+
+    printf("[test]: SNMP GetBulk walks\n");
+
+    snmp_set_mibs(mibs, LWIP_ARRAYSIZE(mibs));
+    rows_init();
+    qsort(sorted, TABLE_ROWS, sizeof(sorted[0]), row_sort_cmp);
+
+    test_index();
+    test_random();
+    test_get();
+    bench();
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,464 @@
+/**
+ * @file test_sntp.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test - SNTP client, high precision mode, disciplining a
+ *        simulated clock through sntp_clock.c against simulated servers.
+ *
+ * The clock starts at 0 s and runs 30 ppm fast. Three servers are within a
+ * few us of the reference time, a fourth is 25 ms off and must not be
+ * selected. Each way takes 150 us plus up to 20 us, a quarter of the packets
+ * wait up to 3 ms more in a queue. With EMAC time stamps the request and
+ * response carry the clock at the wire, without them the clock is read up to
+ * 50 us before the request leaves and up to 100 us after the response
+ * arrived. Polls are 1 s apart (SNTP_POLL_INTERVAL in the Makefile).
+ * The transmit stamp reaches the request on the next pass of the main loop
+ * with a reference of its own, as ethernetif_poll() does.
+ *
+ * Built with AddressSanitizer and UBSan.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "lwip/apps/sntp.h"
+#include "lwip/inet_chksum.h"
+#include "lwip/init.h"
+#include "lwip/ip.h"
+#include "lwip/ip4.h"
+#include "lwip/netif.h"
+#include "lwip/prot/ip4.h"
+#include "lwip/prot/udp.h"
+#include "lwip/timeouts.h"
+
+#include "ethernetif.h"
+#include "ptp_clock_sim.h"
+#include "sntp_clock.h"
+#include "test_util.h"
+
+#define NTP_PORT       123
+#define NTP_MSG_LEN    48
+#define NTP_UNIX_DIFF  2208988800UL /* seconds from 1900 to 1970 */
+
+#define SIM_START      1792368000LL /* 2026-10-19 00:00:00 UTC */
+#define SIM_DRIFT_PPB  30000
+#define SIM_SERVERS    4
+#define SIM_PATH_NS    150000
+#define SIM_PATH_JITTER 20000
+#define SIM_QUEUE_NS   3000000      /* one in SIM_QUEUE_ONE_IN packets */
+#define SIM_QUEUE_ONE_IN 4
+#define SIM_SERVER_NS  20000        /* from receive to transmit time stamp */
+#define SIM_TX_SW_NS   50000        /* clock read before the request leaves */
+#define SIM_RX_SW_NS   100000       /* clock read after the response arrived */
+#define SIM_STAMP_NS   8            /* EMAC time stamp resolution */
+#define SIM_SECONDS    600
+#define SIM_SETTLED    300          /* errors counted from here on */
+#define SIM_SILENT_AT  400          /* the system peer stops answering */
+
+/* Accepted after SIM_SETTLED s */
+#define PASS_HW_NS     20000
+#define PASS_SW_NS     200000
+
+#define MAX_EVENTS     32
+
+/*******************************************************************************
+ * Reference time, the clock and sys_now()
+ ******************************************************************************/
+static int64_t true_ns;  /* reference time, ns since 1970 */
+static int64_t start_ns; /* reference time of the run start */
+static struct ptp_clock_sim clk;
+static u32_t now_ms;
+
+u32_t sys_now(void)
+{
+    return now_ms;
+}
+
+/* the clock at reference time t, at or after true_ns */
+static int64_t clock_at(int64_t t)
+{
+    int64_t dt = t - true_ns;
+
+    return clk.now + dt + dt * (clk.drift_ppb + clk.adj_ppb) / 1000000000LL;
+}
+
+/*******************************************************************************
+ * Servers
+ ******************************************************************************/
+struct server {
+    ip4_addr_t addr;
+    int64_t error_ns; /* its clock minus the reference time */
+    int silent;
+    uint32_t requests;
+};
+
+static struct server servers[SIM_SERVERS];
+
+struct event {
+    int64_t at;        /* reference time of the response reaching the stack */
+    uint8_t msg[NTP_MSG_LEN];
+    int server;
+    uint16_t dport;
+    int64_t rx_stamp;  /* clock when the response reached the MAC */
+};
+
+static struct event events[MAX_EVENTS];
+static int nevents;
+static int hw_stamps;
+
+/* transmit stamps latched for tx_poll(), as by ethernetif_tx_done() */
+struct tx_stamp {
+    struct pbuf *p;
+    int64_t t;
+};
+
+static struct tx_stamp tx_stamps[MAX_EVENTS];
+static int ntx_stamps;
+
+/* raw offset error of every sample, as one response alone would set it */
+static int64_t raw_sq_sum;
+static uint32_t raw_n;
+
+static int64_t one_way(void)
+{
+    int64_t d = SIM_PATH_NS + rnd() % SIM_PATH_JITTER;
+
+    if (rnd() % SIM_QUEUE_ONE_IN == 0)
+        d += rnd() % SIM_QUEUE_NS;
+    return d;
+}
+
+static void put_time(uint8_t *b, int64_t unix_ns)
+{
+    uint32_t sec = (uint32_t) (unix_ns / 1000000000LL + NTP_UNIX_DIFF);
+    uint32_t frac = (uint32_t) (((uint64_t) (unix_ns % 1000000000LL) << 32) / 1000000000ULL);
+
+    b[0] = sec >> 24;
+    b[1] = sec >> 16;
+    b[2] = sec >> 8;
+    b[3] = sec;
+    b[4] = frac >> 24;
+    b[5] = frac >> 16;
+    b[6] = frac >> 8;
+    b[7] = frac;
+}
+
+static int64_t get_time(const uint8_t *b)
+{
+    uint32_t sec = ((uint32_t) b[0] << 24) | (b[1] << 16) | (b[2] << 8) | b[3];
+    uint32_t frac = ((uint32_t) b[4] << 24) | (b[5] << 16) | (b[6] << 8) | b[7];
+
+    return (int64_t) (sec - NTP_UNIX_DIFF) * 1000000000LL +
+           (int64_t) (((uint64_t) frac * 1000000000ULL) >> 32);
+}
+
+static err_t nif_output(struct netif *netif, struct pbuf *p, const ip4_addr_t *dst)
+{
+    struct ip_hdr iph;
+    struct udp_hdr udph;
+    uint8_t req[NTP_MSG_LEN];
+    struct event *ev;
+    int64_t depart, arrive, t1_sw;
+    int s;
+
+    LWIP_UNUSED_ARG(netif);
+    pbuf_copy_partial(p, &iph, sizeof(iph), 0);
+    if (IPH_PROTO(&iph) != IP_PROTO_UDP)
+        return ERR_OK;
+    pbuf_copy_partial(p, &udph, sizeof(udph), IP_HLEN);
+    if (lwip_ntohs(udph.dest) != NTP_PORT ||
+        pbuf_copy_partial(p, req, NTP_MSG_LEN, IP_HLEN + UDP_HLEN) != NTP_MSG_LEN)
+        return ERR_OK;
+    for (s = 0; s < SIM_SERVERS; s++) {
+        if (ip4_addr_cmp(dst, &servers[s].addr))
+            break;
+    }
+    if (s == SIM_SERVERS)
+        return ERR_OK;
+    servers[s].requests++;
+
+    /* the request leaves, time stamped by the MAC and kept for tx_poll() */
+    depart = true_ns + (hw_stamps ? 0 : rnd() % SIM_TX_SW_NS);
+    if (hw_stamps && (p->ts_flags & ETHERNETIF_TS_TX_REQ) &&
+        ntx_stamps < MAX_EVENTS) {
+        pbuf_ref(p);
+        tx_stamps[ntx_stamps].p = p;
+        tx_stamps[ntx_stamps].t = clock_at(depart) + rnd() % SIM_STAMP_NS;
+        ntx_stamps++;
+    }
+    if (servers[s].silent || nevents == MAX_EVENTS)
+        return ERR_OK;
+
+    arrive = depart + one_way();
+    ev = &events[nevents++];
+    memset(ev->msg, 0, NTP_MSG_LEN);
+    ev->msg[0] = (4 << 3) | 4; /* version 4, server */
+    ev->msg[1] = 2;            /* stratum */
+    ev->msg[7] = 0x10;         /* root delay 244 us */
+    ev->msg[11] = 0x08;        /* root dispersion 122 us */
+    memcpy(&ev->msg[24], &req[40], 8);
+    put_time(&ev->msg[32], arrive + servers[s].error_ns);
+    put_time(&ev->msg[40], arrive + SIM_SERVER_NS + servers[s].error_ns);
+    arrive += SIM_SERVER_NS + one_way();
+    ev->rx_stamp = clock_at(arrive) + rnd() % SIM_STAMP_NS;
+    ev->at = arrive + (hw_stamps ? 0 : rnd() % SIM_RX_SW_NS);
+    ev->server = s;
+    ev->dport = lwip_ntohs(udph.src);
+
+    /* what one sample alone would set the clock to, RFC 4330 */
+    t1_sw = get_time(&req[40]);
+    {
+        int64_t t1 = hw_stamps ? clock_at(depart) : t1_sw;
+        int64_t t4 = hw_stamps ? ev->rx_stamp : clock_at(ev->at);
+        int64_t t2 = get_time(&ev->msg[32]), t3 = get_time(&ev->msg[40]);
+        int64_t offset = ((t1 - t2) + (t4 - t3)) / 2;
+        int64_t err = offset - (clock_at(ev->at) - ev->at);
+
+        if (true_ns - start_ns >= SIM_SETTLED * 1000000000LL && !servers[s].error_ns) {
+            raw_sq_sum += err / 1000 * (err / 1000);
+            raw_n++;
+        }
+    }
+    return ERR_OK;
+}
+
+static struct netif nif;
+
+/* as ethernetif_poll(), the stamps go into the requests from the main loop */
+static void tx_poll(void)
+{
+    int i;
+
+    for (i = 0; i < ntx_stamps; i++) {
+        struct pbuf *p = tx_stamps[i].p;
+
+        p->ts_sec = (u32_t) (tx_stamps[i].t / 1000000000LL);
+        p->ts_nsec = (u32_t) (tx_stamps[i].t % 1000000000LL);
+        p->ts_flags |= ETHERNETIF_TS_TX;
+        pbuf_free(p);
+    }
+    ntx_stamps = 0;
+}
+
+static void deliver(const struct event *ev)
+{
+    struct pbuf *p;
+    struct ip_hdr *iph;
+    struct udp_hdr *udph;
+    uint16_t len = IP_HLEN + UDP_HLEN + NTP_MSG_LEN;
+
+    p = pbuf_alloc(PBUF_RAW, len, PBUF_RAM);
+    iph = (struct ip_hdr *) p->payload;
+    memset(iph, 0, IP_HLEN);
+    IPH_VHL_SET(iph, 4, IP_HLEN / 4);
+    IPH_LEN_SET(iph, lwip_htons(len));
+    IPH_TTL_SET(iph, 64);
+    IPH_PROTO_SET(iph, IP_PROTO_UDP);
+    ip4_addr_copy(iph->src, servers[ev->server].addr);
+    ip4_addr_copy(iph->dest, *netif_ip4_addr(&nif));
+    IPH_CHKSUM_SET(iph, inet_chksum(iph, IP_HLEN));
+    udph = (struct udp_hdr *) ((uint8_t *) iph + IP_HLEN);
+    udph->src = lwip_htons(NTP_PORT);
+    udph->dest = lwip_htons(ev->dport);
+    udph->len = lwip_htons(UDP_HLEN + NTP_MSG_LEN);
+    udph->chksum = 0; /* none */
+    memcpy((uint8_t *) udph + UDP_HLEN, ev->msg, NTP_MSG_LEN);
+    if (hw_stamps) {
+        /* as low_level_input() */
+        p->ts_sec = (u32_t) (ev->rx_stamp / 1000000000LL);
+        p->ts_nsec = (u32_t) (ev->rx_stamp % 1000000000LL);
+        p->ts_flags |= ETHERNETIF_TS_RX;
+    }
+    ip4_input(p, &nif);
+}
+
+/* let the reference time run to t, the stack sees 1 ms ticks */
+static void run_to(int64_t t)
+{
+    while (true_ns < t) {
+        int64_t next = (true_ns / 1000000 + 1) * 1000000;
+        int i, first = -1;
+
+        for (i = 0; i < nevents; i++) {
+            if (events[i].at < next && (first < 0 || events[i].at < events[first].at))
+                first = i;
+        }
+        if (first >= 0)
+            next = events[first].at;
+        if (next > t)
+            next = t;
+        ptp_clock_sim_advance(&clk, next - true_ns);
+        true_ns = next;
+        tx_poll();
+
+        if (first >= 0 && events[first].at == true_ns) {
+            struct event ev = events[first];
+
+            events[first] = events[--nevents];
+            deliver(&ev);
+        } else if (true_ns % 1000000 == 0) {
+            now_ms++;
+            sys_check_timeouts();
+        }
+    }
+}
+
+/*******************************************************************************
+ * Setup
+ ******************************************************************************/
+static err_t nif_init(struct netif *netif)
+{
+    netif->name[0] = 't';
+    netif->name[1] = 'e';
+    netif->mtu = 1500;
+    netif->flags = NETIF_FLAG_BROADCAST;
+    netif->output = nif_output;
+    return ERR_OK;
+}
+
+static void setup(void)
+{
+    ip4_addr_t addr, mask, gw;
+
+    lwip_init();
+    IP4_ADDR(&addr, 192, 168, 0, 23);
+    IP4_ADDR(&mask, 255, 255, 255, 0);
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    netif_add(&nif, &addr, &mask, &gw, NULL, nif_init, ip4_input);
+    netif_set_default(&nif);
+    netif_set_up(&nif);
+    netif_set_link_up(&nif);
+}
+
+/*******************************************************************************
+ * Runs
+ ******************************************************************************/
+struct result {
+    int64_t max_err;    /* of the clock from SIM_SETTLED s on */
+    int64_t rms_err;
+    int64_t raw_rms;    /* of single samples of server 0 */
+    uint32_t steps;
+    int32_t freq_ppb;
+    int64_t max_after_silence;
+};
+
+static int64_t isqrt(int64_t v)
+{
+    int64_t r = 0;
+
+    while ((r + 1) * (r + 1) <= v)
+        r++;
+    return r;
+}
+
+static void run(int hw, struct result *res)
+{
+    static const int64_t errors[SIM_SERVERS] = {0, 2000, -3000, 25000000};
+    struct sntp_clock_stats stats;
+    struct sntp_peer_stats peer;
+    int64_t sq_sum = 0, err;
+    uint32_t n = 0, i;
+    int s, sys = -1;
+
+    memset(res, 0, sizeof(*res));
+    memset(servers, 0, sizeof(servers));
+    nevents = 0;
+    raw_sq_sum = 0;
+    raw_n = 0;
+    hw_stamps = hw;
+    start_ns = true_ns;
+    ptp_clock_sim_init(&clk, 0, SIM_DRIFT_PPB);
+    sntp_clock_init(&clk.clock);
+
+    for (s = 0; s < SIM_SERVERS; s++) {
+        ip_addr_t a;
+
+        IP4_ADDR(&servers[s].addr, 10, 0, 0, 1 + s);
+        servers[s].error_ns = errors[s];
+        ip_addr_copy_from_ip4(a, servers[s].addr);
+        sntp_setserver((u8_t) s, &a);
+    }
+    sntp_setoperatingmode(SNTP_OPMODE_POLL);
+    sntp_init();
+
+    for (i = 1; i <= SIM_SECONDS; i++) {
+        run_to(start_ns + (int64_t) i * 1000000000LL);
+        err = clk.now - true_ns;
+        if (i == SIM_SILENT_AT) {
+            /* the system peer stops answering */
+            for (s = 0; s < SIM_SERVERS; s++) {
+                if (sntp_getpeerstats((u8_t) s, &peer) && peer.sys_peer)
+                    sys = s;
+            }
+            check("system peer", sys >= 0 && sys < 3, 1, 1);
+            if (sys >= 0)
+                servers[sys].silent = 1;
+        }
+        if (i >= SIM_SETTLED) {
+            if (llabs(err) > res->max_err)
+                res->max_err = llabs(err);
+            sq_sum += err / 1000 * (err / 1000);
+            n++;
+        }
+        if (i > SIM_SILENT_AT && llabs(err) > res->max_after_silence)
+            res->max_after_silence = llabs(err);
+    }
+
+    /* all polled, the falseticker left out, the silent server forgotten */
+    for (s = 0; s < SIM_SERVERS; s++)
+        check("requests", servers[s].requests, SIM_SECONDS - 10, SIM_SECONDS);
+    for (s = 0; s < SIM_SERVERS; s++) {
+        int has = sntp_getpeerstats((u8_t) s, &peer);
+
+        if (s == sys)
+            check("silent server dropped", has, 0, 0);
+        else if (s == 3)
+            check("falseticker selected", has && peer.selected, 0, 0);
+        else
+            check("server selected", has && peer.selected, 1, 1);
+    }
+
+    sntp_clock_get_stats(&stats, 0);
+    res->rms_err = isqrt(sq_sum / n) * 1000;
+    res->raw_rms = raw_n ? isqrt(raw_sq_sum / raw_n) * 1000 : 0;
+    res->steps = stats.servo.steps;
+    res->freq_ppb = stats.servo.freq_ppb;
+    check("sw stamps", stats.sw_timestamps, hw ? 0 : 1, hw ? 0 : UINT32_MAX);
+    sntp_stop();
+    tx_poll();
+}
+
+int main(void)
+{
+    struct result hw, sw;
+
+    printf("[test]: SNTP high precision, clock %+d ppb, %d servers, one off by 25 ms\n",
+           SIM_DRIFT_PPB, SIM_SERVERS);
+    setup();
+    true_ns = SIM_START * 1000000000LL;
+
+    run(1, &hw);
+    run(0, &sw);
+
+    printf("[INFO]: sntp EMAC stamps: clock error max %lld ns rms %lld ns, "
+           "single samples rms %lld ns, freq %d ppb, steps %u\n",
+           (long long) hw.max_err, (long long) hw.rms_err,
+           (long long) hw.raw_rms, (int) hw.freq_ppb, (unsigned) hw.steps);
+    printf("[INFO]: sntp software stamps: clock error max %lld ns rms %lld ns, "
+           "single samples rms %lld ns, freq %d ppb, steps %u\n",
+           (long long) sw.max_err, (long long) sw.rms_err,
+           (long long) sw.raw_rms, (int) sw.freq_ppb, (unsigned) sw.steps);
+
+    check("hw error us", (uint32_t) (hw.max_err / 1000), 0, PASS_HW_NS / 1000);
+    check("sw error us", (uint32_t) (sw.max_err / 1000), 0, PASS_SW_NS / 1000);
+    check("hw after silence us", (uint32_t) (hw.max_after_silence / 1000), 0, PASS_HW_NS / 1000);
+    check("hw steps", hw.steps, 1, 1);
+    check("sw steps", sw.steps, 1, 1);
+    check("hw freq error ppb", (uint32_t) llabs(hw.freq_ppb + SIM_DRIFT_PPB), 0, 500);
+    check("hw better than sw", hw.rms_err < sw.rms_err, 1, 1);
+    check("filter better than single samples", hw.rms_err < hw.raw_rms, 1, 1);
+
+    printf("%s\n", fail ? "FAIL" : "PASS");
+    return fail;
+}
@@ -0,0 +1,46 @@
+/**
+ * @file test_util.h
+ * @author cy023
+ * @date 2026.10.19
+ * @brief Host test helpers, included once by each test.
+ *
+ * check() records a value out of range in fail, main() returns it.
+ * rnd() is the same LCG in every test, so a seed gives the same run on any
+ * host. host_ns() is the host clock, for timings printed next to the results.
+ */
+
+#ifndef TEST_UTIL_H
+#define TEST_UTIL_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <time.h>
+
+static int fail;
+
+static inline void check(const char *what, uint32_t got, uint32_t lo,
+                         uint32_t hi)
+{
+    if (got < lo || got > hi) {
+        printf("[ERROR]: %s = %u, expected %u .. %u\n", what, got, lo, hi);
+        fail = 1;
+    }
+}
+
+static uint32_t rnd_state = 1;
+
+static inline uint32_t rnd(void)
+{
+    rnd_state = rnd_state * 1103515245u + 12345u;
+    return rnd_state >> 8;
+}
+
+static inline uint64_t host_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t) ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+#endif /* TEST_UTIL_H */
@@ -0,0 +1,151 @@
+/**
+ * @file test_08_ptp_slave.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief lwIP - IEEE 1588 PTPv2 slave on EMAC time stamps
+ *
+ * Run a PTP master on the same LAN, e.g. `ptp4l -i eth0 -E -4 -m` (UDP/IPv4,
+ * end-to-end delay). Offset statistics are printed every second.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "system.h"
+#include "NuMicro.h"
+
+#include "ethernetif.h"
+#include "ethernet_phy.h"
+#include "netif/ethernet.h"
+
+#include "lwip/etharp.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "lwip/init.h"
+
+#include "ptp.h"
+
+struct netif gnetif;
+/* Frames wait in the Rx ring, the Rx interrupt is masked until taken */
+static volatile bool rx_pending = false;
+
+void lwip_layer_init(void);
+
+void printIPaddr(void)
+{
+    static char tmp_buff[16];
+    printf("IP_ADDR    : %s\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.ip_addr), tmp_buff, 16));
+    printf("NET_MASK   : %s\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.netmask), tmp_buff, 16));
+    printf("GATEWAY_IP : %s\r\n\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.gw), tmp_buff, 16));
+}
+
+void check_connection(void)
+{
+    bool link_up = false;
+    ethernet_phy_get_link_status(&link_up);
+    /* Print IP address info */
+    if (link_up && gnetif.ip_addr.addr) {
+        printf("Hello Connection!\n");
+        printIPaddr();
+    }
+}
+
+void timer0_init(void)
+{
+    // Set timer frequency to 100HZ
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 100);
+
+    // Enable timer interrupt
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+
+    // Start Timer 0
+    TIMER_Start(TIMER0);
+}
+
+int main(void)
+{
+    u32_t last_print = 0;
+
+    system_init();
+    timer0_init();
+    printf("[test]: PTP slave.\n\n");
+
+    lwip_layer_init();
+    check_connection();
+
+    // Time stamp counter must run before frames are received
+    ptp_clock_emac_init();
+    ptp_init(&gnetif, &ptp_clock_emac);
+
+    NVIC_EnableIRQ(EMAC_TX_IRQn);
+    NVIC_EnableIRQ(EMAC_RX_IRQn);
+    EMAC_ENABLE_TX();
+    EMAC_ENABLE_RX();
+
+    while (1) {
+        /* Tx time stamps, before the Delay_Resp they belong to */
+        ethernetif_poll(&gnetif);
+
+        if (rx_pending) {
+            rx_pending = false;
+            ethernetif_input(&gnetif);
+            NVIC_EnableIRQ(EMAC_RX_IRQn);
+        }
+
+        /* LWIP timers - ARP, PTP, etc. */
+        sys_check_timeouts();
+
+        if (sys_now() - last_print >= 1000) {
+            last_print = sys_now();
+            ptp_print_stats();
+        }
+    }
+}
+
+void lwip_layer_init(void)
+{
+    ip_addr_t ipaddr, netmask, gw;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 23);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    /* Initilialize the LwIP stack without RTOS */
+    lwip_init();
+
+    /* add the network interface (IPv4/IPv6) without RTOS */
+    netif_add(&gnetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+
+    /* Registers the default network interface */
+    netif_set_default(&gnetif);
+
+    if (netif_is_link_up(&gnetif)) {
+        /* When the netif is fully configured this function must be called */
+        netif_set_up(&gnetif);
+        printf("netif_set_up\n\n");
+    } else {
+        /* When the netif link is down this function must be called */
+        netif_set_down(&gnetif);
+        printf("netif_set_down\n\n");
+    }
+}
+
+void EMAC_RX_IRQHandler(void)
+{
+    PH5 ^= 1;
+    // PTP runs in the main loop only, hand the frames over to it.
+    NVIC_DisableIRQ(EMAC_RX_IRQn);
+    rx_pending = true;
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    PH4 ^= 1;
+    // Clean up Tx resource, latches Tx time stamps for ethernetif_poll().
+    ethernetif_tx_done(&gnetif);
+}
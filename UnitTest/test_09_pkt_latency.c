@@ -0,0 +1,159 @@
+/**
+ * @file test_09_pkt_latency.c
+ * @author cy023
+ * @date 2026.10.19
+ * @brief lwIP - per-layer Rx latency and hot path profile of the UDP and TCP
+ *        echo servers
+ *
+ * Set PKT_LATENCY and/or LWIP_PERF to 1 in lwipopts.h. Drive the echo
+ * servers with UnitTest/py/echo_UDP_client.py or echo_TCP_client.py, the
+ * statistics are printed and cleared every 5 seconds.
+ */
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <string.h>
+#include "system.h"
+#include "NuMicro.h"
+
+#include "ethernetif.h"
+#include "ethernet_phy.h"
+#include "netif/ethernet.h"
+
+#include "lwip/etharp.h"
+#include "lwip/netif.h"
+#include "lwip/timeouts.h"
+#include "lwip/init.h"
+
+#include "udpecho_raw.h"
+#include "tcpecho_raw.h"
+#include "pkt_latency.h"
+#include "arch/perf.h"
+
+struct netif gnetif;
+
+void lwip_layer_init(void);
+
+void printIPaddr(void)
+{
+    static char tmp_buff[16];
+    printf("IP_ADDR    : %s\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.ip_addr), tmp_buff, 16));
+    printf("NET_MASK   : %s\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.netmask), tmp_buff, 16));
+    printf("GATEWAY_IP : %s\r\n\r\n",
+           ipaddr_ntoa_r((const ip_addr_t *) &(gnetif.gw), tmp_buff, 16));
+}
+
+void check_connection(void)
+{
+    bool link_up = false;
+    ethernet_phy_get_link_status(&link_up);
+    /* Print IP address info */
+    if (link_up && gnetif.ip_addr.addr) {
+        printf("Hello Connection!\n");
+        printIPaddr();
+    }
+}
+
+void timer0_init(void)
+{
+    // Set timer frequency to 100HZ
+    TIMER_Open(TIMER0, TIMER_PERIODIC_MODE, 100);
+
+    // Enable timer interrupt
+    TIMER_EnableInt(TIMER0);
+    NVIC_EnableIRQ(TMR0_IRQn);
+
+    // Start Timer 0
+    TIMER_Start(TIMER0);
+}
+
+int main(void)
+{
+    u32_t last_print = 0;
+
+    system_init();
+    timer0_init();
+    printf("[test]: Rx latency per stack layer.\n\n");
+
+#if PKT_LATENCY
+    pkt_latency_init();
+#endif
+#if LWIP_PERF
+    perf_init();
+#endif
+#if !PKT_LATENCY && !LWIP_PERF
+    printf("[ERROR]: PKT_LATENCY and LWIP_PERF are disabled in lwipopts.h\n");
+#endif
+
+    lwip_layer_init();
+    check_connection();
+
+    /* UDP and TCP echo server, port 7 */
+    udpecho_raw_init();
+    tcpecho_raw_init();
+
+    NVIC_EnableIRQ(EMAC_TX_IRQn);
+    NVIC_EnableIRQ(EMAC_RX_IRQn);
+    EMAC_ENABLE_TX();
+    EMAC_ENABLE_RX();
+
+    while (1) {
+        /* LWIP timers - ARP, TCP, etc. */
+        sys_check_timeouts();
+
+        if (sys_now() - last_print >= 5000) {
+            last_print = sys_now();
+#if PKT_LATENCY
+            pkt_latency_print();
+            pkt_latency_reset();
+#endif
+#if LWIP_PERF
+            perf_print_stats();
+#endif
+        }
+    }
+}
+
+void lwip_layer_init(void)
+{
+    ip_addr_t ipaddr, netmask, gw;
+
+    IP4_ADDR(&gw, 192, 168, 0, 1);
+    IP4_ADDR(&ipaddr, 192, 168, 0, 23);
+    IP4_ADDR(&netmask, 255, 255, 255, 0);
+
+    /* Initilialize the LwIP stack without RTOS */
+    lwip_init();
+
+    /* add the network interface (IPv4/IPv6) without RTOS */
+    netif_add(&gnetif, &ipaddr, &netmask, &gw, NULL, &ethernetif_init,
+              &netif_input);
+
+    /* Registers the default network interface */
+    netif_set_default(&gnetif);
+
+    if (netif_is_link_up(&gnetif)) {
+        /* When the netif is fully configured this function must be called */
+        netif_set_up(&gnetif);
+        printf("netif_set_up\n\n");
+    } else {
+        /* When the netif link is down this function must be called */
+        netif_set_down(&gnetif);
+        printf("netif_set_down\n\n");
+    }
+}
+
+void EMAC_RX_IRQHandler(void)
+{
+    PH5 ^= 1;
+    ethernetif_input(&gnetif);
+}
+
+void EMAC_TX_IRQHandler(void)
+{
+    PH4 ^= 1;
+    // Clean up Tx resource occupied by previous sent.
+    ethernetif_tx_done(&gnetif);
+}